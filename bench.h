@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef vic_bench_h
+#define vic_bench_h
+
+/*
+ * What the *bench tools have in common: the clocks they time with,
+ * the timing loop, the usage exit, the wxh argument, PSNR, and the
+ * Gilbert loss model of the rtp benches.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+/* wall clock seconds, monotonic where there is one */
+static inline double bench_now(void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + 1e-9 * ts.tv_nsec);
+#else
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return (tv.tv_sec + 1e-6 * tv.tv_usec);
+#endif
+}
+
+/* user and system seconds of all the threads */
+static inline double bench_cputime(void)
+{
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	return (ru.ru_utime.tv_sec + 1e-6 * ru.ru_utime.tv_usec +
+		ru.ru_stime.tv_sec + 1e-6 * ru.ru_stime.tv_usec);
+}
+
+/* t = the seconds it takes to do stmt n times */
+#define BENCH_TIME(t, n, stmt) \
+{ \
+	int k__; \
+	double t0__ = bench_now(); \
+	for (k__ = 0; k__ < (n); ++k__) { \
+		stmt; \
+	} \
+	(t) = bench_now() - t0__; \
+}
+
+/* print the synopsis (without "usage: ") and exit */
+static inline void bench_usage(const char* synopsis)
+{
+	fprintf(stderr, "usage: %s", synopsis);
+	exit(1);
+}
+
+/* parse "wxh"; 0 if it isn't */
+static inline int bench_size(const char* s, int* w, int* h)
+{
+	return (sscanf(s, "%dx%d", w, h) == 2 && *w > 0 && *h > 0);
+}
+
+static inline double bench_psnr(const unsigned char* a,
+				const unsigned char* b, int n)
+{
+	double sse = 0.;
+	int i;
+	for (i = 0; i < n; ++i) {
+		int d = a[i] - b[i];
+		sse += d * d;
+	}
+	if (sse == 0.)
+		return (99.);
+	return (10. * log10(255. * 255. * n / sse));
+}
+
+/*
+ * Gilbert loss: a packet is lost in the bad state and gets through
+ * in the good one.  loss (percent) is the mean, burst the mean
+ * length of a run of losses.
+ */
+struct bench_loss {
+	double p_bad;		/* good -> bad */
+	double p_good;		/* bad -> good */
+};
+
+static inline void bench_loss_init(struct bench_loss* l, double loss,
+				   double burst)
+{
+	l->p_good = 1. / burst;
+	l->p_bad = loss / 100. * l->p_good / (1. - loss / 100.);
+}
+
+/* the next packet on a path in state *bad: 1 if it is lost */
+static inline int bench_lose(const struct bench_loss* l, int* bad)
+{
+	double u = drand48();
+	*bad = *bad ? (u >= l->p_good) : (u < l->p_bad);
+	return (*bad);
+}
+
+#endif
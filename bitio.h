@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef vic_bitio_h
+#define vic_bitio_h
+
+/*
+ * The bit buffer the entropy coders share: h.261 (encoder-h261,
+ * codec/p64), jpeg (encoder-jpeg, codec/jpeg) and pvh (huffman.h).
+ *
+ * Bits go MSB first through a 64-bit buffer `bb'.  A writer keeps
+ * the `nbb' bits put so far at the top of bb and stores all 8 bytes
+ * of it at once when it fills (BITS_PUT); `bs' is where they go.  A
+ * reader keeps the `nbb' bits it hasn't taken at the bottom of bb
+ * and tops it up 32 bits at a time with one load (BITS_FILL), so it
+ * can look ahead as far as a code needs without a branch per byte.
+ * It reads up to BITS_PAD bytes past the end of what it decodes,
+ * which the buffer has to have (a pktbuf has plenty).
+ *
+ * The jpeg versions (_FF) stuff a 0 after each ff put, and skip it
+ * on reading; a reader stops at a marker, feeding 0 bits after it.
+ * Neither takes a branch per byte unless there is an ff about.
+ */
+
+#include <string.h>
+#include "config.h"
+#include "bsd-endian.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+typedef unsigned __int64 bitbuf;
+#define BITS_ONES 0x0101010101010101ui64
+#define BITS_HIGH 0x8080808080808080ui64
+#else
+typedef u_int64_t bitbuf;
+#define BITS_ONES 0x0101010101010101ULL
+#define BITS_HIGH 0x8080808080808080ULL
+#endif
+
+#if defined(_MSC_VER) && !defined(__cplusplus)
+#define inline __inline
+#endif
+
+#define BITS_NBIT 64
+#define BITS_PAD 8
+#define BITS_MASK(n) ((1 << (n)) - 1)
+
+/* true if a byte of the word is ff */
+#define BITS_FF32(w) ((~(w) - 0x01010101U) & (w) & 0x80808080U)
+#define BITS_FF64(w) ((~(w) - BITS_ONES) & (w) & BITS_HIGH)
+
+#if BYTE_ORDER == LITTLE_ENDIAN
+#ifdef __GNUC__
+#define BITS_SWAP32(v) __builtin_bswap32(v)
+#define BITS_SWAP64(v) __builtin_bswap64(v)
+#else
+#define BITS_SWAP32(v) \
+	((v) >> 24 | ((v) >> 8 & 0xff00) | ((v) & 0xff00) << 8 | (v) << 24)
+#define BITS_SWAP64(v) \
+	((bitbuf)BITS_SWAP32((u_int32_t)(v)) << 32 | \
+	 BITS_SWAP32((u_int32_t)((v) >> 32)))
+#endif
+#else
+#define BITS_SWAP32(v) (v)
+#define BITS_SWAP64(v) (v)
+#endif
+
+/* big-endian words at any alignment */
+static inline u_int32_t bits_load32(const u_char* p)
+{
+	u_int32_t v;
+	memcpy(&v, p, 4);
+	return (BITS_SWAP32(v));
+}
+
+static inline bitbuf bits_load64(const u_char* p)
+{
+	bitbuf v;
+	memcpy(&v, p, 8);
+	return (BITS_SWAP64(v));
+}
+
+static inline void bits_store64(u_char* p, bitbuf v)
+{
+	v = BITS_SWAP64(v);
+	memcpy(p, &v, 8);
+}
+
+/* store bb with a 0 after each ff; returns where the next byte goes */
+static inline u_char* bits_store64_ff(u_char* bs, bitbuf bb)
+{
+	int s;
+	if (BITS_FF64(bb) == 0) {
+		bits_store64(bs, bb);
+		return (bs + 8);
+	}
+	for (s = 56; s >= 0; s -= 8) {
+		u_char t = (u_char)(bb >> s);
+		*bs++ = t;
+		if (t == 0xff)
+			*bs++ = 0;
+	}
+	return (bs);
+}
+
+/* the next 32 bits of a jpeg segment into bb; returns the new bs */
+static inline const u_char* bits_fill_ff(const u_char* bs, bitbuf* bb)
+{
+	int n;
+	u_int32_t w = bits_load32(bs);
+	if (BITS_FF32(w) == 0) {
+		*bb = *bb << 32 | w;
+		return (bs + 4);
+	}
+	for (n = 4; --n >= 0; ) {
+		int v = *bs;
+		if (v != 0xff)
+			++bs;
+		else if (bs[1] == 0)
+			bs += 2;
+		else
+			/* a marker: stay on it */
+			v = 0;
+		*bb = *bb << 8 | v;
+	}
+	return (bs);
+}
+
+#define BITS_PUT(bits, n, nbb, bb, bs) \
+{ \
+	nbb += (n); \
+	if (nbb > BITS_NBIT) { \
+		int extra__ = (nbb) - BITS_NBIT; \
+		bb |= (bitbuf)(bits) >> extra__; \
+		bits_store64(bs, bb); \
+		bs += BITS_NBIT / 8; \
+		bb = (bitbuf)(bits) << (BITS_NBIT - extra__); \
+		nbb = extra__; \
+	} else \
+		bb |= (bitbuf)(bits) << (BITS_NBIT - (nbb)); \
+}
+
+#define BITS_PUT_FF(bits, n, nbb, bb, bs) \
+{ \
+	nbb += (n); \
+	if (nbb > BITS_NBIT) { \
+		int extra__ = (nbb) - BITS_NBIT; \
+		bb |= (bitbuf)(bits) >> extra__; \
+		bs = bits_store64_ff(bs, bb); \
+		bb = (bitbuf)(bits) << (BITS_NBIT - extra__); \
+		nbb = extra__; \
+	} else \
+		bb |= (bitbuf)(bits) << (BITS_NBIT - (nbb)); \
+}
+
+/* 32 more bits into the reader's bb */
+#define BITS_FILL(bs, nbb, bb) \
+{ \
+	bb = bb << 32 | bits_load32(bs); \
+	bs += 4; \
+	nbb += 32; \
+}
+
+#define BITS_FILL_FF(bs, nbb, bb) \
+{ \
+	bs = bits_fill_ff(bs, &(bb)); \
+	nbb += 32; \
+}
+
+/* the next n (up to 32) bits, as they were put */
+#define BITS_GET(bs, n, nbb, bb, result) \
+{ \
+	nbb -= (n); \
+	if (nbb < 0) \
+		BITS_FILL(bs, nbb, bb); \
+	(result) = (int)((bb) >> (nbb)) & BITS_MASK(n); \
+}
+
+#define BITS_GET_FF(bs, n, nbb, bb, result) \
+{ \
+	nbb -= (n); \
+	if (nbb < 0) \
+		BITS_FILL_FF(bs, nbb, bb); \
+	(result) = (int)((bb) >> (nbb)) & BITS_MASK(n); \
+}
+
+/*
+ * Look up the code at the front of the stream in a table indexed
+ * by its next `maxlen' bits, whose entries are the symbol << 5 and
+ * the code's length, as mkhuff (p64-huff.h) and pvh-huff.c make.
+ * It takes one symbol a lookup; there are no tables of several.
+ */
+#define BITS_HUFF(bs, ht, maxlen, nbb, bb, result) \
+{ \
+	int s__, v__; \
+ \
+	if (nbb < (maxlen)) \
+		BITS_FILL(bs, nbb, bb); \
+	v__ = (int)((bb) >> (nbb - (maxlen))) & BITS_MASK(maxlen); \
+	s__ = (ht)[v__]; \
+	nbb -= (s__ & 0x1f); \
+	result = s__ >> 5; \
+}
+
+#endif
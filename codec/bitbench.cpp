@@ -0,0 +1,562 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * bitbench - time the entropy coders' bit i/o (bitio.h) against
+ * the 32-bit writer and 16-bit reader they used before.
+ *
+ * usage: bitbench [-n passes] [-s symbols]
+ *
+ * A stream of `symbols' (1000000) random pvh coefficient codes
+ * (hte_pvh_tc, mostly the short ones), each followed by a few raw
+ * bits as the coders put signs and levels, is put and got back
+ * `passes' (10) times with each, and the rates are reported in
+ * nanoseconds per symbol.  The same is done for h.261 blocks (a DC
+ * level, run/level codes from hte_tc or escaped, and an EOB), with
+ * the old reader as codec/p64 had it, and for a stream of random
+ * 1 to 16 bit fields with jpeg's ff stuffing.  The two writers have
+ * to make the same bytes and both readers get back what was put;
+ * if not, bitbench says so and exits with 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../config.h"
+#include "../bench.h"
+#include "../bitio.h"
+#include "../huffman.h"
+extern "C" {
+#include "pvh-huff.h"
+}
+
+/*
+ * The h.261 coefficient tables, from mkhuff (huffcode.c).  They are
+ * declared here as p64/p64-huff.h would, but for its own huffent,
+ * which is huffman.h's again.
+ */
+extern "C" {
+extern struct huffent hte_tc[];
+extern const short htd_tcoeff[];
+}
+#define SYM_ESCAPE	0
+#define SYM_EOB		-1
+#define H261_MAXLEN	14
+
+/*
+ * The old bit i/o, as huffman.h, encoder-jpeg.cpp and jpeg.cpp had
+ * it: 32 bits put at a time, 16 (or a byte) got at a time.
+ */
+#define OLD_NBIT 32
+
+#define OLD_STORE(bs, bb) \
+{ \
+	(bs)[0] = (bb) >> 24; \
+	(bs)[1] = (bb) >> 16; \
+	(bs)[2] = (bb) >> 8; \
+	(bs)[3] = (bb); \
+	bs += 4; \
+}
+
+#define OLD_STORE_FF(bs, bb) \
+{ \
+	u_char t = (bb) >> 24; \
+	*bs++ = t; \
+	if (t == 0xff) *bs++ = 0; \
+	t = (bb) >> 16; \
+	*bs++ = t; \
+	if (t == 0xff) *bs++ = 0; \
+	t = (bb) >> 8; \
+	*bs++ = t; \
+	if (t == 0xff) *bs++ = 0; \
+	t = (bb); \
+	*bs++ = t; \
+	if (t == 0xff) *bs++ = 0; \
+}
+
+#define OLD_PUT(store, bits, n, nbb, bb, bs) \
+{ \
+	nbb += (n); \
+	if (nbb > OLD_NBIT) { \
+		int extra = (nbb) - OLD_NBIT; \
+		bb |= (u_int)(bits) >> extra; \
+		store(bs, bb) \
+		bb = (u_int)(bits) << (OLD_NBIT - extra); \
+		nbb = extra; \
+	} else \
+		bb |= (u_int)(bits) << (OLD_NBIT - (nbb)); \
+}
+
+#define OLD_READ(bb, bs) \
+{ \
+	bb = bb << 16 | (bs)[0] << 8 | (bs)[1]; \
+	bs += 2; \
+}
+
+#define OLD_READ_FF(bb, bs) \
+{ \
+	int v = *bs++; \
+	if (v == 0xff) ++bs; \
+	bb = bb << 8 | v; \
+	v = *bs++; \
+	if (v == 0xff) ++bs; \
+	bb = bb << 8 | v; \
+}
+
+#define OLD_GET(read, n, nbb, bb, bs, result) \
+{ \
+	nbb -= (n); \
+	if (nbb < 0) { \
+		read(bb, bs); \
+		nbb += 16; \
+	} \
+	(result) = ((bb) >> (nbb)) & BITS_MASK(n); \
+}
+
+#define OLD_HUFF(ht, maxlen, nbb, bb, bs, result) \
+{ \
+	int s__, v__; \
+	while (nbb < (maxlen)) { \
+		bb = bb << 8 | *(bs)++; \
+		nbb += 8; \
+	} \
+	v__ = ((bb) >> (nbb - (maxlen))) & BITS_MASK(maxlen); \
+	s__ = (ht)[v__]; \
+	nbb -= (s__ & 0x1f); \
+	result = s__ >> 5; \
+}
+
+/* and as codec/p64 had it, 16 bits got when fewer were left */
+#define OLD_HUFF16(ht, maxlen, nbb, bb, bs, result) \
+{ \
+	int s__, v__; \
+	if (nbb < 16) { \
+		OLD_READ(bb, bs); \
+		nbb += 16; \
+	} \
+	v__ = ((bb) >> (nbb - (maxlen))) & BITS_MASK(maxlen); \
+	s__ = (ht)[v__]; \
+	nbb -= (s__ & 0x1f); \
+	result = s__ >> 5; \
+}
+
+#define TC_MAXLEN 14
+
+static int nsym = 1000000;
+static int* sym;	/* the code's index, or the field for jpeg */
+static int* len;	/* the raw bits after it, or the field's size */
+static int* raw;
+
+/* pvh codes, with a short code more likely than a long one */
+static void mksyms()
+{
+	int codes[2048];
+	int ncode = 0;
+	for (int s = 0; s < 2048; ++s) {
+		const huffent& he = hte_pvh_tc[s];
+		if (he.nb == 0)
+			continue;
+		/* only the ones the table gives back (as s << 1) */
+		int v = he.val << (TC_MAXLEN - he.nb);
+		if ((htd_pvh_tc[v] & 0x1f) == he.nb &&
+		    htd_pvh_tc[v] >> 5 == s << 1)
+			codes[ncode++] = s;
+	}
+	for (int i = 0; i < nsym; ) {
+		int s = codes[random() % ncode];
+		if (random() % (1 << hte_pvh_tc[s].nb / 2) != 0)
+			continue;
+		sym[i] = s;
+		len[i] = random() % 9;
+		raw[i] = random() & BITS_MASK(len[i]);
+		++i;
+	}
+}
+
+/*
+ * h.261 intra blocks as encoder-h261 codes them: for each, the DC
+ * level (len -1), then runs and levels, mostly short (len the run),
+ * and the EOB (len -2).
+ */
+#define H261_DC		-1
+#define H261_EOB	-2
+
+static void mkblocks()
+{
+	int i = 0;
+	while (i < nsym) {
+		sym[i] = 1 + random() % 254;
+		len[i++] = H261_DC;
+		int k = 1;
+		int n = random() % 10;
+		while (n-- > 0 && i < nsym - 1) {
+			int run = random() % (random() % 4 == 0 ? 16 : 3);
+			if (k + run > 63)
+				break;
+			int level = 1 + random() % (random() % 8 == 0 ? 127 : 3);
+			if (random() & 1)
+				level = -level;
+			sym[i] = level;
+			len[i++] = run;
+			k += run + 1;
+		}
+		if (i < nsym)
+			len[i++] = H261_EOB;
+	}
+}
+
+/* the code for an event, as encode_blk() makes it */
+static inline int h261code(int i, int* nb)
+{
+	if (len[i] == H261_DC) {
+		*nb = 8;
+		return (sym[i]);
+	}
+	if (len[i] == H261_EOB) {
+		*nb = 2;
+		return (2);
+	}
+	int level = sym[i];
+	int run = len[i];
+	const huffent* he;
+	if (u_int(level + 15) <= 30 &&
+	    (*nb = (he = &hte_tc[((level & 0x1f) << 6) | run])->nb) != 0)
+		return (he->val);
+	*nb = 20;
+	return ((1 << 14) | (run << 8) | (level & 0xff));
+}
+
+/* does what was got for event i, as parse_block() takes it, match? */
+static inline int h261bad(int i, int r, int v)
+{
+	if (len[i] == H261_DC)
+		return (v != sym[i]);
+	if (len[i] == H261_EOB)
+		return (r != SYM_EOB);
+	return (r != len[i] || v != (sym[i] & 0xff));
+}
+
+static void mkfields()
+{
+	for (int i = 0; i < nsym; ++i) {
+		len[i] = 1 + random() % 16;
+		sym[i] = random() & BITS_MASK(len[i]);
+	}
+}
+
+/* each writer ends with 64 0 bits, so all of the stream is stored */
+
+static int put_old(u_char* bp)
+{
+	u_char* bs = bp;
+	u_int bb = 0;
+	int nbb = 0;
+	for (int i = 0; i < nsym; ++i) {
+		const huffent& he = hte_pvh_tc[sym[i]];
+		OLD_PUT(OLD_STORE, he.val, he.nb, nbb, bb, bs);
+		if (len[i] != 0)
+			OLD_PUT(OLD_STORE, raw[i], len[i], nbb, bb, bs);
+	}
+	OLD_PUT(OLD_STORE, 0, 32, nbb, bb, bs);
+	OLD_PUT(OLD_STORE, 0, 32, nbb, bb, bs);
+	return (bs - bp);
+}
+
+static int put_new(u_char* bp)
+{
+	u_char* bs = bp;
+	bitbuf bb = 0;
+	int nbb = 0;
+	for (int i = 0; i < nsym; ++i) {
+		const huffent& he = hte_pvh_tc[sym[i]];
+		BITS_PUT(he.val, he.nb, nbb, bb, bs);
+		if (len[i] != 0)
+			BITS_PUT(raw[i], len[i], nbb, bb, bs);
+	}
+	BITS_PUT(0, 32, nbb, bb, bs);
+	BITS_PUT(0, 32, nbb, bb, bs);
+	return (bs - bp);
+}
+
+static int get_old(const u_char* bs)
+{
+	u_int bb = 0;
+	int nbb = 0;
+	int bad = 0;
+	for (int i = 0; i < nsym; ++i) {
+		int s, v;
+		OLD_HUFF(htd_pvh_tc, TC_MAXLEN, nbb, bb, bs, s);
+		OLD_GET(OLD_READ, len[i], nbb, bb, bs, v);
+		bad += s != sym[i] << 1 || v != raw[i];
+	}
+	return (bad);
+}
+
+static int get_new(const u_char* bs)
+{
+	bitbuf bb = 0;
+	int nbb = 0;
+	int bad = 0;
+	for (int i = 0; i < nsym; ++i) {
+		int s, v;
+		BITS_HUFF(bs, htd_pvh_tc, TC_MAXLEN, nbb, bb, s);
+		BITS_GET(bs, len[i], nbb, bb, v);
+		bad += s != sym[i] << 1 || v != raw[i];
+	}
+	return (bad);
+}
+
+static int put_old_h261(u_char* bp)
+{
+	u_char* bs = bp;
+	u_int bb = 0;
+	int nbb = 0;
+	for (int i = 0; i < nsym; ++i) {
+		int nb;
+		int val = h261code(i, &nb);
+		OLD_PUT(OLD_STORE, val, nb, nbb, bb, bs);
+	}
+	OLD_PUT(OLD_STORE, 0, 32, nbb, bb, bs);
+	OLD_PUT(OLD_STORE, 0, 32, nbb, bb, bs);
+	return (bs - bp);
+}
+
+static int put_new_h261(u_char* bp)
+{
+	u_char* bs = bp;
+	bitbuf bb = 0;
+	int nbb = 0;
+	for (int i = 0; i < nsym; ++i) {
+		int nb;
+		int val = h261code(i, &nb);
+		BITS_PUT(val, nb, nbb, bb, bs);
+	}
+	BITS_PUT(0, 32, nbb, bb, bs);
+	BITS_PUT(0, 32, nbb, bb, bs);
+	return (bs - bp);
+}
+
+static int get_old_h261(const u_char* bs)
+{
+	u_int bb = 0;
+	int nbb = 0;
+	int bad = 0;
+	for (int i = 0; i < nsym; ++i) {
+		int r = 0, v = 0;
+		if (len[i] == H261_DC)
+			OLD_GET(OLD_READ, 8, nbb, bb, bs, v)
+		else {
+			OLD_HUFF16(htd_tcoeff, H261_MAXLEN, nbb, bb, bs, r);
+			if (r == SYM_ESCAPE) {
+				OLD_GET(OLD_READ, 14, nbb, bb, bs, r);
+				v = r & 0xff;
+				r >>= 8;
+			} else if (r > 0) {
+				v = ((r << 22) >> 27) & 0xff;
+				r &= 0x1f;
+			}
+		}
+		bad += h261bad(i, r, v);
+	}
+	return (bad);
+}
+
+static int get_new_h261(const u_char* bs)
+{
+	bitbuf bb = 0;
+	int nbb = 0;
+	int bad = 0;
+	for (int i = 0; i < nsym; ++i) {
+		int r = 0, v = 0;
+		if (len[i] == H261_DC)
+			BITS_GET(bs, 8, nbb, bb, v)
+		else {
+			BITS_HUFF(bs, htd_tcoeff, H261_MAXLEN, nbb, bb, r);
+			if (r == SYM_ESCAPE) {
+				BITS_GET(bs, 14, nbb, bb, r);
+				v = r & 0xff;
+				r >>= 8;
+			} else if (r > 0) {
+				v = ((r << 22) >> 27) & 0xff;
+				r &= 0x1f;
+			}
+		}
+		bad += h261bad(i, r, v);
+	}
+	return (bad);
+}
+
+static int put_old_ff(u_char* bp)
+{
+	u_char* bs = bp;
+	u_int bb = 0;
+	int nbb = 0;
+	for (int i = 0; i < nsym; ++i)
+		OLD_PUT(OLD_STORE_FF, sym[i], len[i], nbb, bb, bs);
+	OLD_PUT(OLD_STORE_FF, 0, 32, nbb, bb, bs);
+	OLD_PUT(OLD_STORE_FF, 0, 32, nbb, bb, bs);
+	return (bs - bp);
+}
+
+static int put_new_ff(u_char* bp)
+{
+	u_char* bs = bp;
+	bitbuf bb = 0;
+	int nbb = 0;
+	for (int i = 0; i < nsym; ++i)
+		BITS_PUT_FF(sym[i], len[i], nbb, bb, bs);
+	BITS_PUT_FF(0, 32, nbb, bb, bs);
+	BITS_PUT_FF(0, 32, nbb, bb, bs);
+	return (bs - bp);
+}
+
+static int get_old_ff(const u_char* bs)
+{
+	u_int bb = 0;
+	int nbb = 0;
+	int bad = 0;
+	for (int i = 0; i < nsym; ++i) {
+		int v;
+		OLD_GET(OLD_READ_FF, len[i], nbb, bb, bs, v);
+		bad += v != sym[i];
+	}
+	return (bad);
+}
+
+static int get_new_ff(const u_char* bs)
+{
+	bitbuf bb = 0;
+	int nbb = 0;
+	int bad = 0;
+	for (int i = 0; i < nsym; ++i) {
+		int v;
+		BITS_GET_FF(bs, len[i], nbb, bb, v);
+		bad += v != sym[i];
+	}
+	return (bad);
+}
+
+static int npass = 10;
+static int failed;
+
+/*
+ * Time each writer and reader over the stream, check they agree,
+ * and print the rates.
+ */
+static void run(const char* name, int (*pold)(u_char*),
+		int (*pnew)(u_char*), int (*gold)(const u_char*),
+		int (*gnew)(const u_char*), int size)
+{
+	u_char* ob = new u_char[size + BITS_PAD];
+	u_char* nb = new u_char[size + BITS_PAD];
+	memset(ob, 0, size + BITS_PAD);
+	memset(nb, 0, size + BITS_PAD);
+	double t[4];
+	int occ = 0, ncc = 0, obad = 0, nbad = 0;
+
+	double t0 = bench_now();
+	for (int k = 0; k < npass; ++k)
+		occ = pold(ob);
+	t[0] = bench_now() - t0;
+	t0 = bench_now();
+	for (int k = 0; k < npass; ++k)
+		ncc = pnew(nb);
+	t[1] = bench_now() - t0;
+	t0 = bench_now();
+	for (int k = 0; k < npass; ++k)
+		obad = gold(ob);
+	t[2] = bench_now() - t0;
+	t0 = bench_now();
+	for (int k = 0; k < npass; ++k)
+		nbad = gnew(nb);
+	t[3] = bench_now() - t0;
+
+	/* the writers store different amounts of the padding at the end */
+	int cc = occ < ncc ? occ : ncc;
+	if (memcmp(ob, nb, cc) != 0) {
+		printf("%s: the writers differ\n", name);
+		failed = 1;
+	}
+	if (obad != 0 || nbad != 0) {
+		printf("%s: %d symbols got back wrong (old %d, new %d)\n",
+		       name, obad + nbad, obad, nbad);
+		failed = 1;
+	}
+	double ns = 1e9 / ((double)npass * nsym);
+	printf("%-8s %8d %8.2f %8.2f %8.2f %8.2f\n", name, cc,
+	       t[0] * ns, t[1] * ns, t[2] * ns, t[3] * ns);
+	delete[] ob;
+	delete[] nb;
+}
+
+static const char synopsis[] =
+	"bitbench [-n passes] [-s symbols]\n";
+
+int main(int argc, char** argv)
+{
+	int op;
+	while ((op = getopt(argc, argv, "n:s:")) != -1) {
+		switch (op) {
+		case 'n':
+			npass = atoi(optarg);
+			break;
+		case 's':
+			nsym = atoi(optarg);
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind != argc || npass < 1 || nsym < 1)
+		bench_usage(synopsis);
+
+	sym = new int[nsym];
+	len = new int[nsym];
+	raw = new int[nsym];
+	srandom(1);
+
+	printf("%-8s %8s %17s %17s\n", "", "", "put ns/symbol",
+	       "get ns/symbol");
+	printf("%-8s %8s %8s %8s %8s %8s\n", "stream", "bytes", "old", "new",
+	       "old", "new");
+	/* at most 22 bits a symbol, and the 64 at the end */
+	mksyms();
+	run("pvh", put_old, put_new, get_old, get_new, nsym * 3 + 16);
+	/* at most 20 bits an event */
+	mkblocks();
+	run("h261", put_old_h261, put_new_h261, get_old_h261, get_new_h261,
+	    nsym * 3 + 16);
+	/* 16 bits a field, and a stuffed 0 for each ff */
+	mkfields();
+	run("jpeg", put_old_ff, put_new_ff, get_old_ff, get_new_ff,
+	    nsym * 4 + 32);
+	return (failed);
+}
@@ -0,0 +1,816 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* $Header$ */
+
+#include <string.h>
+#include "bvc-block.h"
+
+/*
+ * SSE2 versions of the transforms.  On gcc these are compiled for
+ * SSE2 even when the rest of the file isn't, and are only called
+ * if the cpu turns out to have it (see bvc_simd()).
+ */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define BVC_SSE2 __attribute__((target("sse2")))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define BVC_SSE2
+#endif
+
+#ifdef BVC_SSE2
+#include <emmintrin.h>
+#ifdef RUNTIME_CPUDETECT
+extern "C" {
+#include "cpu/cpudetect.h"
+}
+#endif
+#endif
+
+static int simd_ = -1;
+
+void bvc_simd(int on)
+{
+	simd_ = 0;
+#ifdef BVC_SSE2
+	if (on) {
+#ifdef RUNTIME_CPUDETECT
+		simd_ = (cpu_check() & FF_CPU_SSE2) != 0;
+#elif defined(__SSE2__) || defined(_M_X64)
+		simd_ = 1;
+#endif
+	}
+#else
+	UNUSED(on);
+#endif
+}
+
+int bvc_simd()
+{
+	if (simd_ < 0)
+		bvc_simd(1);
+	return (simd_);
+}
+
+static void haar_fwd_c(const u_int8_t* in, u_int8_t* out, int stride)
+{
+	int32_t scratch[64];
+	u_int8_t* l = (u_int8_t*)in;
+	int32_t* o = scratch;
+	/* XXX would be more efficient here to do rows first */
+	int k;
+	for (k = 8; --k >= 0; ) {
+		/* use fixed point arithmetic with 2 bits of fraction */
+		int t0 = l[0];
+		int t1 = l[stride];
+		int t2 = t0 + t1;
+		o[4*8] = (t1 - t0) << 2;
+
+		t0 = l[2*stride];
+		t1 = l[3*stride];
+		int t3 = t0 + t1;
+		o[5*8] = (t1 - t0) << 2;
+
+		t0 = l[4*stride];
+		t1 = l[5*stride];
+		int t4 = t0 + t1;
+		o[6*8] = (t1 - t0) << 2;
+
+		t0 = l[6*stride];
+		t1 = l[7*stride];
+		int t5 = t0 + t1;
+		o[7*8] = (t1 - t0) << 2;
+
+		t0 = t2 + t3;
+		t1 = t4 + t5;
+		o[0*8]  = t0 + t1;
+		o[1*8]  = t1 - t0;
+		o[2*8] = (t3 - t2) << 1;
+		o[3*8] = (t5 - t4) << 1;
+
+		++o;
+		++l;
+	}
+	/* rows */
+	o = scratch;
+	l = (u_int8_t*)out;
+	for (k = 8; --k >= 0; ) {
+		int t0 = o[0];
+		int t1 = o[1];
+		int t2 = t0 + t1;
+		l[4] = (t1 - t0 + 7) >> 4;
+
+		t0 = o[2];
+		t1 = o[3];
+		int t3 = t0 + t1;
+		l[5] = (t1 - t0 + 7) >> 4;
+
+		t0 = o[4];
+		t1 = o[5];
+		int t4 = t0 + t1;
+		l[6] = (t1 - t0 + 7) >> 4;
+
+		t0 = o[6];
+		t1 = o[7];
+		int t5 = t0 + t1;
+		l[7] = (t1 - t0 + 7) >> 4;
+
+		t0 = t2 + t3;
+		t1 = t4 + t5;
+		l[0] = (t0 + t1 + 31) >> 6;
+		l[1] = (t1 - t0 + 31) >> 6;
+		l[2] = (t3 - t2 + 15) >> 5;
+		l[3] = (t5 - t4 + 15) >> 5;
+
+		l += 8;
+		o += 8;
+	}
+}
+
+#define CMAX(a,b) ((a) > (b) ? (a) : (b))
+static void decompose_c(const u_char* in, int stride, int8_t* out)
+{
+	int32_t scratch[CMAX(2*8*18/4, 64)];
+	u_int8_t* l = (u_int8_t*)scratch;
+	int8_t* h = (int8_t*)&l[8*18];
+	in -= 1;
+	for (int w = 18; --w >= 0; ) {
+		int8_t* cl = (int8_t*)(l++);
+		int8_t* ch = h++;
+		const u_char* p = in++;
+		int in0 = p[-stride];
+		int in1 = *p;
+		p += stride;
+		for (int th = 8; --th >= 0; ) {
+			int in2 = *p;
+			p += stride;
+			int in3 = *p;
+			p += stride;
+
+			/* multiply by 3 */
+			int m1 = in1 + (in1 << 1);
+			int m2 = in2 + (in2 << 1);
+
+			/* -1 3 3 -1 */
+			int v = m1 + m2 - in0 - in3;
+			v >>= 2;
+			if (v & ~0xff)
+				v = (v < 0) ? 0 : 255;
+			*cl = v;
+			cl += 18;
+
+			/* 1 -3 3 -1 */
+			v = in0 - m1 + m2 - in3;
+			v >>= 2;
+			if ((v + 127) & ~0xff)
+				v = (v < -128) ? -128 : 127;
+			*ch = v;
+			ch += 18;
+
+			in0 = in2;
+			in1 = in3;
+		}
+	}
+	/* rows */
+	const u_int8_t* p = (u_int8_t*)scratch;
+	l = (u_int8_t*)out;
+	h = out + 2*64;
+	int th;
+	for (th = 8; --th >= 0; ) {
+		int in0 = *p++;
+		int in1 = *p++;
+		for (int w = 8; --w >= 0; ) {
+			int in2 = *p++;
+			int in3 = *p++;
+
+			/* multiply by 3 */
+			int m1 = in1 + (in1 << 1);
+			int m2 = in2 + (in2 << 1);
+
+			/* -1 3 3 -1 */
+			int v = m1 + m2 - in0 - in3;
+			v >>= 2;
+			if (v & ~0xff)
+				v = (v < 0) ? 0 : 255;
+			*l++ = v;
+			/* 1 -3 3 -1 */
+			v = in0 - m1 + m2 - in3;
+			v >>= 2;
+			if ((v + 127) & ~0xff)
+				v = (v < -128) ? -128 : 127;
+			*h++ = v;
+
+			in0 = in2;
+			in1 = in3;
+		}
+	}
+	for (th = 8; --th >= 0; ) {
+		int in0 = *(int8_t*)(p++);
+		int in1 = *(int8_t*)(p++);
+		for (int w = 8; --w >= 0; ) {
+			int in2 = *(int8_t*)(p++);
+			int in3 = *(int8_t*)(p++);
+
+			/* multiply by 3 */
+			int m1 = in1 + (in1 << 1);
+			int m2 = in2 + (in2 << 1);
+
+			/* -1 3 3 -1 */
+			int v = m1 + m2 - in0 - in3;
+			*l++ = v >> 2;
+#ifdef HAVE_HH
+			/* 1 -3 3 -1 */
+			v = in0 - m1 + m2 - in3;
+			*h++ = v >> 2;
+#endif
+
+			in0 = in2;
+			in1 = in3;
+		}
+	}
+
+	/* now apply fully separable Haar tranform remaining 8x8 subimage */
+	haar_fwd_c((u_int8_t*)out, (u_int8_t*)out, 8);
+}
+
+static void haar_rev_c(const int8_t* in, int8_t* out, int stride)
+{
+	int blk[64];
+	int* o = blk;
+
+	int m = 0xff;/*XXX make sure DC is unsigned*/
+
+	/* inverse Haar transform 8x8 base image */
+	int k;
+	for (k = 8; --k >= 0; ) {
+		int t4 = in[0];
+		t4 &= m;
+		m = ~0;
+		int t5 = in[1];
+		int t0 = t4 - t5;
+		int t1 = t4 + t5;
+
+		t4 = in[2];
+		t5 = in[3];
+		int t2 = t0 - t4;
+		int t3 = t0 + t4;
+		t4 = t1 - t5;
+		t5 = t1 + t5;
+
+		t0 = in[4];
+		t1 = in[5];
+		o[0] = t2 - t0;
+		o[1] = t2 + t0;
+		o[2] = t3 - t1;
+		o[3] = t3 + t1;
+
+		t0 = in[6];
+		t1 = in[7];
+		o[4] = t4 - t0;
+		o[5] = t4 + t0;
+		o[6] = t5 - t1;
+		o[7] = t5 + t1;
+
+		o += 8;
+		in += 8;
+	}
+	/* columns */
+	o = blk;
+	for (k = 8; --k >= 0; ) {
+		int t4 = o[0*8];
+		int t5 = o[1*8];
+		int t0 = t4 - t5;
+		int t1 = t4 + t5;
+
+		t4 = o[2*8];
+		t5 = o[3*8];
+		int t2 = t0 - t4;
+		int t3 = t0 + t4;
+		t4 = t1 - t5;
+		t5 = t1 + t5;
+
+		t0 = o[4*8];
+		t1 = o[5*8];
+
+		/*
+		 * Saturate the reconstructed values, since quantization
+		 * of the transform coefficients can result in values
+		 * outside [0,255].
+		 */
+#define UCLIMIT(x) ((t = (x)), (t &= ~(t>>31)), (t | ~((t-256) >> 31)))
+		int t;
+		*out = UCLIMIT(t2 - t0);
+		out += stride;
+		*out = UCLIMIT(t2 + t0);
+		out += stride;
+		*out = UCLIMIT(t3 - t1);
+		out += stride;
+		*out = UCLIMIT(t3 + t1);
+		out += stride;
+
+		t0 = o[6*8];
+		t1 = o[7*8];
+		*out = UCLIMIT(t4 - t0);
+		out += stride;
+		*out = UCLIMIT(t4 + t0);
+		out += stride;
+		*out = UCLIMIT(t5 - t1);
+		out += stride;
+		*out = UCLIMIT(t5 + t1);
+		out += stride;
+
+		out -= stride << 3;
+		++out;
+		++o;
+	}
+}
+
+/*16x16*/
+static void reconstruct_c(const int8_t* ll, const int8_t* lh,
+			  const int8_t* hl, int stride, u_char* out, int width)
+{
+	int16_t blk[2*10*16];
+
+	int16_t* o = blk;
+	const u_int8_t* lu = (const u_int8_t*)ll - stride;
+	const int8_t* h = lh - stride;
+	int th;
+	for (th = 10; --th >= 0; ) {
+		int l0 = lu[-1];
+		int h0 = h[-1];
+		int l1 = *lu++;
+		int h1 = *h++;
+		for (int w = 8; --w >= 0; ) {
+			int l3 = l1 + (l1 << 1);
+			int h3 = h1 + (h1 << 1);
+			int v = l0 + l3 + h0 - h3;
+			*o++ = v >> 2;
+
+			l0 = l1;
+			h0 = h1;
+			l1 = *lu++;
+			h1 = *h++;
+
+			v = l3 + l1 + h3 - h1;
+			*o++ = v >> 2;
+		}
+		lu += stride - 9;
+		h += stride - 9;
+	}
+	/* HH isn't coded, so this is the same filter with h = 0 */
+	const int8_t* l = hl - stride;
+	for (th = 10; --th >= 0; ) {
+		int l0 = l[-1];
+		int l1 = *l++;
+		for (int w = 8; --w >= 0; ) {
+			int l3 = l1 + (l1 << 1);
+			int v = l0 + l3;
+			*o++ = v >> 2;
+
+			l0 = l1;
+			l1 = *l++;
+
+			v = l3 + l1;
+			*o++ = v >> 2;
+		}
+		l += stride - 9;
+	}
+
+	o = blk;
+	for (int w = 16; --w >= 0; ) {
+		const int16_t* cl = o++;
+		const int16_t* ch = cl + 10*16;
+		u_int8_t* p = out++;
+
+		int l0 = *cl;
+		cl += 16;
+		int h0 = *ch;
+		ch += 16;
+		int l1 = *cl;
+		cl += 16;
+		int h1 = *ch;
+		ch += 16;
+
+		for (int th = 8; --th >= 0; ) {
+			int l3 = l1 + (l1 << 1);
+			int h3 = h1 + (h1 << 1);
+			int v = l3 + l0 + h0 - h3;
+			v >>= 2;
+			/*XXX*/
+			if (v & ~0xff)
+				v = (v < 0) ? 0 : 255;
+			*p = v;
+			p += width;
+
+			l0 = l1;
+			h0 = h1;
+			l1 = *cl;
+			cl += 16;
+			h1 = *ch;
+			ch += 16;
+
+			v = l1 + l3 + h3 - h1;
+			v >>= 2;
+			/*XXX*/
+			if (v & ~0xff)
+				v = (v < 0) ? 0 : 255;
+			*p = v;
+			p += width;
+		}
+	}
+}
+
+#ifdef BVC_SSE2
+/*
+ * The SSE2 transforms work in 16-bit lanes, eight pels or
+ * coefficients per register.  The Haar transforms keep an 8x8
+ * block in eight registers, one row per register, and transpose
+ * between the passes.  The 1-3-3-1 filters run down the columns
+ * with the taps of each output in separate registers, so no
+ * shuffling is needed at all: loading a row from one pel left of
+ * the block and one pel right of it and splitting the bytes by
+ * parity gives the pels at 2k-1, 2k, 2k+1 and 2k+2 in lane k.
+ */
+BVC_SSE2
+static inline void transpose8(__m128i* r)
+{
+	__m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+	__m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+	__m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+	__m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+	__m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+	__m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+	__m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+	__m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+	__m128i b0 = _mm_unpacklo_epi32(a0, a2);
+	__m128i b1 = _mm_unpackhi_epi32(a0, a2);
+	__m128i b2 = _mm_unpacklo_epi32(a1, a3);
+	__m128i b3 = _mm_unpackhi_epi32(a1, a3);
+	__m128i b4 = _mm_unpacklo_epi32(a4, a6);
+	__m128i b5 = _mm_unpackhi_epi32(a4, a6);
+	__m128i b6 = _mm_unpacklo_epi32(a5, a7);
+	__m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+	r[0] = _mm_unpacklo_epi64(b0, b4);
+	r[1] = _mm_unpackhi_epi64(b0, b4);
+	r[2] = _mm_unpacklo_epi64(b1, b5);
+	r[3] = _mm_unpackhi_epi64(b1, b5);
+	r[4] = _mm_unpacklo_epi64(b2, b6);
+	r[5] = _mm_unpackhi_epi64(b2, b6);
+	r[6] = _mm_unpacklo_epi64(b3, b7);
+	r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+/* (x + r) >> s */
+#define BVC_RSHIFT(x, r, s) \
+	_mm_srai_epi16(_mm_add_epi16((x), _mm_set1_epi16(r)), s)
+
+/* 3 * (b + c) - a - d, the low-pass taps */
+BVC_SSE2
+static inline __m128i lowpass(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+	__m128i m = _mm_add_epi16(b, c);
+	m = _mm_add_epi16(m, _mm_add_epi16(m, m));
+	return (_mm_sub_epi16(m, _mm_add_epi16(a, d)));
+}
+
+/* a - 3 * (b - c) - d, the high-pass taps */
+BVC_SSE2
+static inline __m128i highpass(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+	__m128i m = _mm_sub_epi16(b, c);
+	m = _mm_add_epi16(m, _mm_add_epi16(m, m));
+	return (_mm_sub_epi16(_mm_sub_epi16(a, m), d));
+}
+
+/* x clamped to [0,255] */
+BVC_SSE2
+static inline __m128i uclamp(__m128i x)
+{
+	return (_mm_min_epi16(_mm_max_epi16(x, _mm_setzero_si128()),
+			      _mm_set1_epi16(255)));
+}
+
+/*
+ * x clamped to a signed char as the C analysis does it, which
+ * turns -128 into 127 and 128 into -128: both come out of the
+ * clamp as the wrong end of the range, bit for bit the inverse.
+ */
+BVC_SSE2
+static inline __m128i sclamp(__m128i x)
+{
+	__m128i c = _mm_min_epi16(_mm_max_epi16(x, _mm_set1_epi16(-128)),
+				  _mm_set1_epi16(127));
+	__m128i m = _mm_or_si128(_mm_cmpeq_epi16(x, _mm_set1_epi16(-128)),
+				 _mm_cmpeq_epi16(x, _mm_set1_epi16(128)));
+	return (_mm_xor_si128(c, m));
+}
+
+/* the Haar transform of the 8 rows in r, into 64 bytes at out */
+BVC_SSE2
+static void haar_fwd_rows(__m128i* r, u_char* out)
+{
+	__m128i d[8], t0, t1, t2, t3, t4, t5;
+
+	/* columns */
+	t2 = _mm_add_epi16(r[0], r[1]);
+	d[4] = _mm_slli_epi16(_mm_sub_epi16(r[1], r[0]), 2);
+	t3 = _mm_add_epi16(r[2], r[3]);
+	d[5] = _mm_slli_epi16(_mm_sub_epi16(r[3], r[2]), 2);
+	t4 = _mm_add_epi16(r[4], r[5]);
+	d[6] = _mm_slli_epi16(_mm_sub_epi16(r[5], r[4]), 2);
+	t5 = _mm_add_epi16(r[6], r[7]);
+	d[7] = _mm_slli_epi16(_mm_sub_epi16(r[7], r[6]), 2);
+
+	t0 = _mm_add_epi16(t2, t3);
+	t1 = _mm_add_epi16(t4, t5);
+	d[0] = _mm_add_epi16(t0, t1);
+	d[1] = _mm_sub_epi16(t1, t0);
+	d[2] = _mm_slli_epi16(_mm_sub_epi16(t3, t2), 1);
+	d[3] = _mm_slli_epi16(_mm_sub_epi16(t5, t4), 1);
+	transpose8(d);
+
+	/* rows */
+	t2 = _mm_add_epi16(d[0], d[1]);
+	r[4] = BVC_RSHIFT(_mm_sub_epi16(d[1], d[0]), 7, 4);
+	t3 = _mm_add_epi16(d[2], d[3]);
+	r[5] = BVC_RSHIFT(_mm_sub_epi16(d[3], d[2]), 7, 4);
+	t4 = _mm_add_epi16(d[4], d[5]);
+	r[6] = BVC_RSHIFT(_mm_sub_epi16(d[5], d[4]), 7, 4);
+	t5 = _mm_add_epi16(d[6], d[7]);
+	r[7] = BVC_RSHIFT(_mm_sub_epi16(d[7], d[6]), 7, 4);
+
+	t0 = _mm_add_epi16(t2, t3);
+	t1 = _mm_add_epi16(t4, t5);
+	r[0] = BVC_RSHIFT(_mm_add_epi16(t0, t1), 31, 6);
+	r[1] = BVC_RSHIFT(_mm_sub_epi16(t1, t0), 31, 6);
+	r[2] = BVC_RSHIFT(_mm_sub_epi16(t3, t2), 15, 5);
+	r[3] = BVC_RSHIFT(_mm_sub_epi16(t5, t4), 15, 5);
+	transpose8(r);
+
+	/* the low bytes, as the C code's stores to u_int8_t */
+	const __m128i mask = _mm_set1_epi16(0xff);
+	for (int k = 0; k < 8; k += 2)
+		_mm_storeu_si128((__m128i*)(out + 8 * k),
+			_mm_packus_epi16(_mm_and_si128(r[k], mask),
+					 _mm_and_si128(r[k + 1], mask)));
+}
+
+BVC_SSE2
+static void haar_fwd_sse2(const u_char* in, u_char* out, int stride)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i r[8];
+	for (int k = 0; k < 8; ++k) {
+		r[k] = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)in),
+					 zero);
+		in += stride;
+	}
+	haar_fwd_rows(r, out);
+}
+
+BVC_SSE2
+static void decompose_sse2(const u_char* in, int stride, int8_t* out)
+{
+	const __m128i mask = _mm_set1_epi16(0xff);
+	/* rows -1 to 16, each as the pels at 2k-1, 2k, 2k+1, 2k+2 */
+	__m128i x[18][4];
+	__m128i l[8], t[4], h[4], lh[8], hl[8];
+	int k, s;
+
+	in -= stride;
+	for (k = 0; k < 18; ++k) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(in - 1));
+		__m128i b = _mm_loadu_si128((const __m128i*)(in + 1));
+		x[k][0] = _mm_and_si128(a, mask);
+		x[k][1] = _mm_srli_epi16(a, 8);
+		x[k][2] = _mm_and_si128(b, mask);
+		x[k][3] = _mm_srli_epi16(b, 8);
+		in += stride;
+	}
+	for (k = 0; k < 8; ++k) {
+		/* columns */
+		const __m128i* r = x[2 * k];
+		for (s = 0; s < 4; ++s) {
+			t[s] = uclamp(_mm_srai_epi16(lowpass(r[s], r[s + 4],
+					r[s + 8], r[s + 12]), 2));
+			h[s] = sclamp(_mm_srai_epi16(highpass(r[s], r[s + 4],
+					r[s + 8], r[s + 12]), 2));
+		}
+		/* rows */
+		l[k] = uclamp(_mm_srai_epi16(lowpass(t[0], t[1], t[2], t[3]),
+					     2));
+		lh[k] = sclamp(_mm_srai_epi16(highpass(t[0], t[1], t[2], t[3]),
+					      2));
+		hl[k] = _mm_and_si128(_mm_srai_epi16(lowpass(h[0], h[1], h[2],
+							      h[3]), 2), mask);
+	}
+	for (k = 0; k < 8; k += 2) {
+		_mm_storeu_si128((__m128i*)(out + 64 + 8 * k),
+				 _mm_packus_epi16(hl[k], hl[k + 1]));
+		_mm_storeu_si128((__m128i*)(out + 128 + 8 * k),
+				 _mm_packs_epi16(lh[k], lh[k + 1]));
+	}
+	haar_fwd_rows(l, (u_char*)out);
+}
+
+/*
+ * One pass of the inverse Haar transform, which is the same across
+ * the rows as down the columns.
+ */
+BVC_SSE2
+static inline void haar_rev_pass(const __m128i* x, __m128i* d)
+{
+	__m128i t0, t1, t2, t3, t4, t5;
+
+	t0 = _mm_sub_epi16(x[0], x[1]);
+	t1 = _mm_add_epi16(x[0], x[1]);
+	t2 = _mm_sub_epi16(t0, x[2]);
+	t3 = _mm_add_epi16(t0, x[2]);
+	t4 = _mm_sub_epi16(t1, x[3]);
+	t5 = _mm_add_epi16(t1, x[3]);
+
+	d[0] = _mm_sub_epi16(t2, x[4]);
+	d[1] = _mm_add_epi16(t2, x[4]);
+	d[2] = _mm_sub_epi16(t3, x[5]);
+	d[3] = _mm_add_epi16(t3, x[5]);
+	d[4] = _mm_sub_epi16(t4, x[6]);
+	d[5] = _mm_add_epi16(t4, x[6]);
+	d[6] = _mm_sub_epi16(t5, x[7]);
+	d[7] = _mm_add_epi16(t5, x[7]);
+}
+
+BVC_SSE2
+static void haar_rev_sse2(const int8_t* in, int8_t* out, int stride)
+{
+	__m128i x[8], d[8];
+	int k;
+
+	for (k = 0; k < 8; k += 2) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(in + 8 * k));
+		x[k] = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+		x[k + 1] = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+	}
+	/* the DC is unsigned */
+	x[0] = _mm_and_si128(x[0], _mm_set_epi16(-1, -1, -1, -1, -1, -1, -1,
+						  0xff));
+	transpose8(x);
+	haar_rev_pass(x, d);
+	transpose8(d);
+	haar_rev_pass(d, x);
+	for (k = 0; k < 8; ++k) {
+		_mm_storel_epi64((__m128i*)out, _mm_packus_epi16(x[k], x[k]));
+		out += stride;
+	}
+}
+
+/* pels 0-7 at p, zero or sign extended */
+BVC_SSE2
+static inline __m128i load_u8(const int8_t* p)
+{
+	return (_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)p),
+				  _mm_setzero_si128()));
+}
+
+BVC_SSE2
+static inline __m128i load_s8(const int8_t* p)
+{
+	__m128i v = _mm_loadl_epi64((const __m128i*)p);
+	return (_mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8));
+}
+
+/* l0 + 3 * l1 + h0 - 3 * h1, the even taps of the synthesis */
+BVC_SSE2
+static inline __m128i synth(__m128i l0, __m128i l1, __m128i h0, __m128i h1)
+{
+	__m128i m = _mm_sub_epi16(l1, h1);
+	m = _mm_add_epi16(m, _mm_add_epi16(m, m));
+	return (_mm_add_epi16(_mm_add_epi16(l0, h0), m));
+}
+
+BVC_SSE2
+static void reconstruct_sse2(const int8_t* ll, const int8_t* lh,
+			     const int8_t* hl, int stride, u_char* out,
+			     int width)
+{
+	/* rows -1 to 8 after the horizontal pass, for L and H */
+	__m128i lo[10][2], hi[10][2];
+	const __m128i zero = _mm_setzero_si128();
+	int k;
+
+	ll -= stride;
+	lh -= stride;
+	hl -= stride;
+	for (k = 0; k < 10; ++k) {
+		__m128i l0 = load_u8(ll - 1);
+		__m128i l1 = load_u8(ll);
+		__m128i l2 = load_u8(ll + 1);
+		__m128i h0 = load_s8(lh - 1);
+		__m128i h1 = load_s8(lh);
+		__m128i h2 = load_s8(lh + 1);
+		/* the odd taps are the even ones mirrored, with h negated */
+		__m128i e = _mm_srai_epi16(synth(l0, l1, h0, h1), 2);
+		__m128i o = _mm_srai_epi16(synth(l2, l1,
+				_mm_sub_epi16(zero, h2), _mm_sub_epi16(zero, h1)), 2);
+		lo[k][0] = _mm_unpacklo_epi16(e, o);
+		lo[k][1] = _mm_unpackhi_epi16(e, o);
+
+		l0 = load_s8(hl - 1);
+		l1 = load_s8(hl);
+		l2 = load_s8(hl + 1);
+		e = _mm_srai_epi16(synth(l0, l1, zero, zero), 2);
+		o = _mm_srai_epi16(synth(l2, l1, zero, zero), 2);
+		hi[k][0] = _mm_unpacklo_epi16(e, o);
+		hi[k][1] = _mm_unpackhi_epi16(e, o);
+
+		ll += stride;
+		lh += stride;
+		hl += stride;
+	}
+	for (k = 0; k < 8; ++k) {
+		__m128i e[2], o[2];
+		for (int j = 0; j < 2; ++j) {
+			e[j] = _mm_srai_epi16(synth(lo[k][j], lo[k + 1][j],
+						    hi[k][j], hi[k + 1][j]), 2);
+			o[j] = _mm_srai_epi16(synth(lo[k + 2][j], lo[k + 1][j],
+				_mm_sub_epi16(zero, hi[k + 2][j]),
+				_mm_sub_epi16(zero, hi[k + 1][j])), 2);
+		}
+		_mm_storeu_si128((__m128i*)out, _mm_packus_epi16(e[0], e[1]));
+		out += width;
+		_mm_storeu_si128((__m128i*)out, _mm_packus_epi16(o[0], o[1]));
+		out += width;
+	}
+}
+#endif
+
+void bvc_decompose(const u_char* in, int stride, int8_t* out)
+{
+#ifdef BVC_SSE2
+	if (bvc_simd()) {
+		decompose_sse2(in, stride, out);
+		return;
+	}
+#endif
+	decompose_c(in, stride, out);
+}
+
+void bvc_reconstruct(const int8_t* ll, const int8_t* lh, const int8_t* hl,
+		     int stride, u_char* out, int width)
+{
+#ifdef BVC_SSE2
+	if (bvc_simd()) {
+		reconstruct_sse2(ll, lh, hl, stride, out, width);
+		return;
+	}
+#endif
+	reconstruct_c(ll, lh, hl, stride, out, width);
+}
+
+void bvc_haar_fwd(const u_char* in, u_char* out, int stride)
+{
+#ifdef BVC_SSE2
+	if (bvc_simd()) {
+		haar_fwd_sse2(in, out, stride);
+		return;
+	}
+#endif
+	haar_fwd_c(in, out, stride);
+}
+
+void bvc_haar_rev(const int8_t* in, int8_t* out, int stride)
+{
+#ifdef BVC_SSE2
+	if (bvc_simd()) {
+		haar_rev_sse2(in, out, stride);
+		return;
+	}
+#endif
+	haar_rev_c(in, out, stride);
+}
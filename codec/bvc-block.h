@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef vic_bvc_block_h
+#define vic_bvc_block_h
+
+#include "config.h"
+
+/*
+ * Subband transforms for the bvc format, shared by the bvc encoder
+ * and decoder.  A 16x16 luma block is split with the 1-3-3-1 filter
+ * pair into four 8x8 subbands, of which HH is dropped and LL is
+ * Haar transformed again; the 8x8 chroma blocks only get the Haar
+ * transform.
+ *
+ * The transforms have SSE2 versions, used when the cpu has SSE2
+ * (see bvc_simd()); they give the same results as the C versions.
+ */
+
+/*
+ * Split the luma block at in into out: 64 bytes of Haar coefficients
+ * of LL, then 64 of HL and 64 of LH.  The filters read the row and
+ * column around the block as well.
+ */
+void bvc_decompose(const u_char* in, int stride, int8_t* out);
+/* the inverse, from the decoded subband planes into 16 rows at out */
+void bvc_reconstruct(const int8_t* ll, const int8_t* lh, const int8_t* hl,
+		     int stride, u_char* out, int width);
+
+/* Haar transform the 8x8 block at in into 64 bytes at out (may be in) */
+void bvc_haar_fwd(const u_char* in, u_char* out, int stride);
+/* and back, saturating to [0,255] */
+void bvc_haar_rev(const int8_t* in, int8_t* out, int stride);
+
+/* use the SSE2 transforms if on and the cpu has them */
+void bvc_simd(int on);
+int bvc_simd();
+
+#endif
@@ -0,0 +1,401 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * bvcbench - time the bvc subband transforms, C and SSE2.
+ *
+ * usage: bvcbench [-n passes] [-s wxh] [-c] [file]
+ *
+ * The input is one 4:2:0 planar frame of the given size (CIF by
+ * default) read from `file', or a synthetic frame if there's no
+ * file.  Every 16x16 block of the frame, with its chroma, is
+ * transformed as BvcEncoder does it and transformed back as
+ * BvcDecoder does it (without the quantization and coding in
+ * between), `passes' times, and the rates are reported in blocks
+ * per second.
+ *
+ * -c	instead, check that the SSE2 transforms give the same
+ *	coefficients and the same decoded frame as the C ones, and
+ *	the same results on random blocks.  Exits with 1 if anything
+ *	differs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "../config.h"
+#include "../bench.h"
+#include "bvc-block.h"
+
+static int width = 352;
+static int height = 288;
+
+/*
+ * The luma plane with a pel of border all round, which the encoder
+ * fills in by extending the edges.
+ */
+static u_char* luma;
+static int lstride;
+
+static void extend(const u_char* f)
+{
+	lstride = width + 32;
+	if (luma == 0)
+		luma = new u_char[lstride * (height + 2)];
+	for (int y = -1; y <= height; ++y) {
+		int sy = y < 0 ? 0 : y >= height ? height - 1 : y;
+		u_char* p = luma + (y + 1) * lstride + 1;
+		memcpy(p, f + sy * width, width);
+		p[-1] = p[0];
+		p[width] = p[width - 1];
+	}
+}
+
+/* the subband planes, laid out as BvcDecoder has them */
+static int8_t* plane[3];
+static int sstride;
+
+static void alloc_planes()
+{
+	sstride = (width + 8) >> 1;
+	int s = (width / 2 + 8) * (height / 2 + 2);
+	for (int i = 0; i < 3; ++i) {
+		if (plane[i] == 0)
+			plane[i] = new int8_t[s];
+		memset(plane[i], 0, s);
+	}
+}
+
+static int8_t* ll_(int i) { return (plane[0] + sstride + i); }
+static int8_t* lh_(int i) { return (plane[1] + sstride + i); }
+static int8_t* hl_(int i) { return (plane[2] + sstride + i); }
+
+/*
+ * Transform every block of f into cf, 3*192 bytes per block.
+ */
+static void encode(const u_char* f, int8_t* cf)
+{
+	extend(f);
+	int fs = width * height;
+	for (int y = 0; y < height; y += 16) {
+		for (int x = 0; x < width; x += 16) {
+			bvc_decompose(luma + (y + 1) * lstride + x + 1, lstride,
+				      cf);
+			const u_char* up = f + fs + (y >> 1) * (width >> 1) +
+				(x >> 1);
+			bvc_haar_fwd(up, (u_char*)cf + 192, width >> 1);
+			bvc_haar_fwd(up + (fs >> 2), (u_char*)cf + 384,
+				     width >> 1);
+			cf += 3 * 192;
+		}
+	}
+}
+
+/*
+ * Put the subbands of the block at (x, y) back in the planes and
+ * extend them at the edges of the image, as BvcDecoder::decode_block
+ * does, and invert its chroma.
+ */
+static void decode_block(const int8_t* cf, int x, int y, u_char* f)
+{
+	int stride = sstride;
+	int off = (y >> 1) * stride + (x >> 1);
+	int8_t* ll = ll_(off);
+	int8_t* lh = lh_(off);
+	int8_t* hl = hl_(off);
+	bvc_haar_rev(cf, ll, stride);
+	for (int k = 0; k < 8; ++k) {
+		memcpy(hl + k * stride, cf + 64 + 8 * k, 8);
+		memcpy(lh + k * stride, cf + 128 + 8 * k, 8);
+	}
+	int fs = width * height;
+	int8_t* chm = (int8_t*)f + fs + (y >> 1) * (width >> 1) + (x >> 1);
+	bvc_haar_rev(cf + 192, chm, width >> 1);
+	bvc_haar_rev(cf + 384, chm + (fs >> 2), width >> 1);
+
+	if (y == 0) {
+		memcpy(ll - stride, ll, 8);
+		memcpy(hl - stride, hl, 8);
+		for (int k = 0; k < 8; ++k)
+			lh[-stride + k] = -lh[k];
+	} else if (y == height - 16) {
+		ll += stride << 3;
+		lh += stride << 3;
+		hl += stride << 3;
+		memcpy(ll, ll - stride, 8);
+		memcpy(hl, hl - stride, 8);
+		for (int k = 0; k < 8; ++k)
+			lh[k] = -lh[-stride + k];
+		ll -= stride << 3;
+		lh -= stride << 3;
+		hl -= stride << 3;
+	}
+	if (x == 0) {
+		for (int k = 0; k < 8; ++k) {
+			ll[-1] = ll[0];
+			ll += stride;
+			hl[-1] = hl[0];
+			hl += stride;
+			lh[-1] = -lh[0];
+			lh += stride;
+		}
+	} else if (x == width - 16) {
+		ll += 8;
+		lh += 8;
+		hl += 8;
+		for (int k = 0; k < 8; ++k) {
+			ll[0] = ll[-1];
+			ll += stride;
+			hl[0] = hl[-1];
+			hl += stride;
+			lh[0] = -lh[-1];
+			lh += stride;
+		}
+	}
+}
+
+/*
+ * Invert what encode() left in cf into the frame f.
+ */
+static void decode(const int8_t* cf, u_char* f)
+{
+	const int8_t* p = cf;
+	for (int y = 0; y < height; y += 16) {
+		for (int x = 0; x < width; x += 16) {
+			decode_block(p, x, y, f);
+			p += 3 * 192;
+		}
+	}
+	for (int y = 0; y < height; y += 16) {
+		for (int x = 0; x < width; x += 16) {
+			int off = (y >> 1) * sstride + (x >> 1);
+			bvc_reconstruct(ll_(off), lh_(off), hl_(off), sstride,
+					f + y * width + x, width);
+		}
+	}
+}
+
+/*
+ * Transform the frame and back, C and SSE2, and compare.
+ */
+static int check_frame(const u_char* f)
+{
+	int fs = width * height * 3 / 2;
+	int ncf = (width >> 4) * (height >> 4) * 3 * 192;
+	int bad = 0;
+	int8_t* cf[2];
+	u_char* df[2];
+	for (int s = 0; s < 2; ++s) {
+		bvc_simd(s);
+		cf[s] = new int8_t[ncf];
+		encode(f, cf[s]);
+		df[s] = new u_char[fs];
+		memset(df[s], 0x80, fs);
+		alloc_planes();
+		decode(cf[s], df[s]);
+	}
+	if (memcmp(cf[0], cf[1], ncf) != 0) {
+		printf("coefficients differ\n");
+		bad = 1;
+	}
+	if (memcmp(df[0], df[1], fs) != 0) {
+		printf("decoded frames differ\n");
+		bad = 1;
+	}
+	printf("frame: luma psnr %.2f\n", bench_psnr(f, df[0], width * height));
+	for (int s = 0; s < 2; ++s) {
+		delete[] cf[s];
+		delete[] df[s];
+	}
+	return (bad);
+}
+
+/*
+ * Run random blocks through the transforms: pels through the
+ * forward ones and any bytes at all through the inverse ones.
+ */
+static int check_random(int n)
+{
+	const int stride = 32;
+	u_char in[18 * stride];
+	int8_t sb[3][10 * stride];
+	u_char out[2][16 * stride];
+	int8_t cf[2][192];
+	int bad[4];
+	memset(bad, 0, sizeof(bad));
+	srandom(1);
+	for (int k = 0; k < n; ++k) {
+		/* mostly smooth, sometimes wild, to hit the clamps */
+		int amp = (k & 3) == 0 ? 256 : 32;
+		int base = random() & 255;
+		for (int i = 0; i < 18 * stride; ++i) {
+			int v = base + (int)(random() % amp) - amp / 2;
+			in[i] = v < 0 ? 0 : v > 255 ? 255 : v;
+		}
+		for (int s = 0; s < 2; ++s) {
+			bvc_simd(s);
+			bvc_decompose(in + stride + 1, stride, cf[s]);
+		}
+		if (memcmp(cf[0], cf[1], 192) != 0)
+			++bad[0];
+		for (int s = 0; s < 2; ++s) {
+			bvc_simd(s);
+			bvc_haar_fwd(in + 3, (u_char*)cf[s], stride);
+		}
+		if (memcmp(cf[0], cf[1], 64) != 0)
+			++bad[1];
+
+		for (int p = 0; p < 3; ++p)
+			for (int i = 0; i < 10 * stride; ++i)
+				sb[p][i] = random();
+		for (int s = 0; s < 2; ++s) {
+			bvc_simd(s);
+			memset(out[s], 0, sizeof(out[s]));
+			bvc_haar_rev(sb[0], (int8_t*)out[s], stride);
+		}
+		if (memcmp(out[0], out[1], sizeof(out[0])) != 0)
+			++bad[2];
+		for (int s = 0; s < 2; ++s) {
+			bvc_simd(s);
+			bvc_reconstruct(sb[0] + stride + 1, sb[1] + stride + 1,
+					sb[2] + stride + 1, stride, out[s],
+					stride);
+		}
+		if (memcmp(out[0], out[1], sizeof(out[0])) != 0)
+			++bad[3];
+	}
+	static const char* what[] = {
+		"decompose", "forward haar", "inverse haar", "reconstruct"
+	};
+	int r = 0;
+	for (int i = 0; i < 4; ++i) {
+		printf("%s: %d of %d random blocks differ\n", what[i], bad[i],
+		       n);
+		r |= bad[i] != 0;
+	}
+	return (r);
+}
+
+static const char synopsis[] =
+	"bvcbench [-n passes] [-s wxh] [-c] [file]\n";
+
+int main(int argc, char** argv)
+{
+	int npass = 50;
+	int check = 0;
+	int op;
+	while ((op = getopt(argc, argv, "n:s:c")) != -1) {
+		switch (op) {
+		case 'n':
+			npass = atoi(optarg);
+			break;
+		case 's':
+			if (!bench_size(optarg, &width, &height))
+				bench_usage(synopsis);
+			break;
+		case 'c':
+			check = 1;
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind < argc - 1 || npass <= 0 ||
+	    width <= 0 || (width & 15) != 0 || height <= 0 || (height & 15) != 0)
+		bench_usage(synopsis);
+
+	int fs = width * height * 3 / 2;
+	u_char* f = new u_char[fs];
+	if (optind < argc) {
+		FILE* fp = fopen(argv[optind], "rb");
+		if (fp == 0) {
+			perror(argv[optind]);
+			exit(1);
+		}
+		if (fread(f, 1, fs, fp) != (size_t)fs) {
+			fprintf(stderr, "bvcbench: %s: short frame\n",
+				argv[optind]);
+			exit(1);
+		}
+		fclose(fp);
+	} else {
+		/* smooth luma with some texture, slow chroma */
+		for (int y = 0; y < height; ++y)
+			for (int x = 0; x < width; ++x)
+				f[y * width + x] = int(128 +
+					64 * sin(x * 0.05) * cos(y * 0.07) +
+					32 * sin((x + 3 * y) * 0.6));
+		int cw = width >> 1;
+		int ch = height >> 1;
+		for (int y = 0; y < ch; ++y) {
+			for (int x = 0; x < cw; ++x) {
+				f[width * height + y * cw + x] =
+					128 + ((x + y) & 63) - 32;
+				f[width * height * 5 / 4 + y * cw + x] =
+					128 + ((x - y) & 31) - 16;
+			}
+		}
+	}
+
+	if (check) {
+		int bad = check_frame(f);
+		bad |= check_random(200000);
+		return (bad);
+	}
+
+	int nblk = (width >> 4) * (height >> 4);
+	int8_t* cf = new int8_t[nblk * 3 * 192];
+	u_char* df = new u_char[fs];
+	alloc_planes();
+	int simd = bvc_simd();
+	printf("%dx%d, %d passes; blocks/sec\n", width, height, npass);
+	printf("%10s %10s %10s %10s\n", "enc c", "enc sse2", "dec c",
+	       "dec sse2");
+	double rate[2][2];
+	for (int s = 0; s < 2; ++s) {
+		bvc_simd(s);
+		double t0 = bench_now();
+		for (int i = 0; i < npass; ++i)
+			encode(f, cf);
+		double t1 = bench_now();
+		for (int i = 0; i < npass; ++i)
+			decode(cf, df);
+		double t2 = bench_now();
+		rate[s][0] = npass * nblk / (t1 - t0);
+		rate[s][1] = npass * nblk / (t2 - t1);
+	}
+	printf("%10.0f %10.0f %10.0f %10.0f\n", rate[0][0], rate[1][0],
+	       rate[0][1], rate[1][1]);
+	if (!simd)
+		printf("(no sse2: both columns are C)\n");
+	return (0);
+}
@@ -1238,3 +1238,107 @@ dct_decimate(const short* in0, const short* in1, short* o)
 		in1 += 8;
 	}
 }
+
+/*
+ * Constants for rdct_down(), to 12 bits: the 4 point inverse
+ * transform with the 8 point coefficients scaled to suit.
+ */
+#define RD_W0	1448	/* 1/(2 sqrt(2)) */
+#define RD_C1	1892	/* cos(pi/8)/2 */
+#define RD_C3	784	/* cos(3pi/8)/2 */
+
+/*
+ * An inverse dct for decoding at a reduced size: the block comes out
+ * 8 >> scale pixels on a side (scale is 1 or 2), from just its low
+ * order 4x4 (or 2x2) coefficients.  As for rdct(), they are in
+ * column order (COLZAG), and m0 is the low word of the mask of those
+ * present, which covers all of them.  If qt isn't null, they are
+ * multiplied by it (in natural order) first.  bias is added to every
+ * pixel (128 for jpeg) and, as with rdct(), the block at in (if not
+ * null) is added in.
+ */
+void rdct_down(int scale, const short* bp, u_int m0, const int* qt, int bias,
+	       u_char* p, int stride, const u_char* in)
+{
+	int n = 8 >> scale;
+	int c[16];
+	int i, j;
+	if ((m0 & ~1) == 0) {
+		/* just the DC (as often as not): the mean, as dcfill() */
+		int dc = (m0 & 1) ? bp[0] : 0;
+		if (qt != 0)
+			dc *= qt[0];
+		dc = ((dc + 4) >> 3) + bias;
+		for (i = 0; i < n; ++i) {
+			for (j = 0; j < n; ++j) {
+				int t;
+				int v = dc;
+				if (in != 0)
+					v += in[j];
+				p[j] = LIMIT(v, t);
+			}
+			p += stride;
+			if (in != 0)
+				in += stride;
+		}
+		return;
+	}
+	for (i = 0; i < n; ++i) {
+		for (j = 0; j < n; ++j) {
+			int k = i << 3 | j;
+			int nat = j << 3 | i;
+			int v = 0;
+			if (M(k)) {
+				v = bp[k];
+				if (qt != 0)
+					v *= qt[nat];
+			}
+			c[(nat >> 3) * n + (nat & 7)] = v;
+		}
+	}
+	int pix[16];
+	if (n == 2) {
+		pix[0] = (c[0] + c[1] + c[2] + c[3] + 4) >> 3;
+		pix[1] = (c[0] - c[1] + c[2] - c[3] + 4) >> 3;
+		pix[2] = (c[0] + c[1] - c[2] - c[3] + 4) >> 3;
+		pix[3] = (c[0] - c[1] - c[2] + c[3] + 4) >> 3;
+	} else {
+		/* rows, keeping 6 bits of fraction */
+		int t[16];
+		for (i = 0; i < 16; i += 4) {
+			int e0 = RD_W0 * (c[i] + c[i + 2]);
+			int e1 = RD_W0 * (c[i] - c[i + 2]);
+			int o0 = RD_C1 * c[i + 1] + RD_C3 * c[i + 3];
+			int o1 = RD_C3 * c[i + 1] - RD_C1 * c[i + 3];
+			t[i] = (e0 + o0 + (1 << 5)) >> 6;
+			t[i + 1] = (e1 + o1 + (1 << 5)) >> 6;
+			t[i + 2] = (e1 - o1 + (1 << 5)) >> 6;
+			t[i + 3] = (e0 - o0 + (1 << 5)) >> 6;
+		}
+		/* then columns */
+		for (i = 0; i < 4; ++i) {
+			int e0 = RD_W0 * (t[i] + t[i + 8]);
+			int e1 = RD_W0 * (t[i] - t[i + 8]);
+			int o0 = RD_C1 * t[i + 4] + RD_C3 * t[i + 12];
+			int o1 = RD_C3 * t[i + 4] - RD_C1 * t[i + 12];
+			pix[i] = (e0 + o0 + (1 << 17)) >> 18;
+			pix[i + 4] = (e1 + o1 + (1 << 17)) >> 18;
+			pix[i + 8] = (e1 - o1 + (1 << 17)) >> 18;
+			pix[i + 12] = (e0 - o0 + (1 << 17)) >> 18;
+		}
+	}
+	const int* pp = pix;
+	for (i = 0; i < n; ++i) {
+		for (j = 0; j < n; ++j) {
+			int t;
+			int v = pp[j] + bias;
+			if (in != 0)
+				v += in[j];
+			p[j] = LIMIT(v, t);
+		}
+		pp += n;
+		p += stride;
+		if (in != 0)
+			in += stride;
+	}
+}
@@ -67,6 +67,8 @@ void dcfill(int dc, u_char* out, int stride);
 void dcsum(int dc, u_char* in, u_char* out, int stride);
 void dcsum2(int dc, u_char* in, u_char* out, int stride);
 void dct_decimate(const short* in0, const short* in1, short* out);
+void rdct_down(int scale, const short* coef, u_int m0, const int* qt,
+	       int bias, u_char* out, int stride, const u_char* in);
 
 /*XXX*/
 void rdct_fold_q(const int* in, int* qt);
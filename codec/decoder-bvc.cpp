@@ -8,6 +8,7 @@
 #include "inet.h"
 #include "rtp.h"
 #include "renderer.h"
+#include "bvc-block.h"
 
 class BvcDecoder : public Decoder {
  public:
@@ -256,210 +257,8 @@ void BvcDecoder::reconstruct_block(int x, int y)
 {
 	int stride = (inw_ + LINEPAD) >> 1;
 	int off = (y >> 1) * stride + (x >> 1);
-	int16_t blk[2*10*16];
-
-	int16_t* o = blk;
-	u_int8_t* lu = (u_int8_t*)ll_ + off - stride;
-	int8_t* h = lh_ + off - stride;
-	o = blk;
-	int th;
-	for (th = 10; --th >= 0; ) {
-		int l0 = lu[-1];
-		int h0 = h[-1];
-		int l1 = *lu++;
-		int h1 = *h++;
-		for (int w = 8; --w >= 0; ) {
-			int l3 = l1 + (l1 << 1);
-			int h3 = h1 + (h1 << 1);
-			int v = l0 + l3 + h0 - h3;
-			*o++ = v >> 2;
-
-			l0 = l1;
-			h0 = h1;
-			l1 = *lu++;
-			h1 = *h++;
-
-			v = l3 + l1 + h3 - h1;
-			*o++ = v >> 2;
-		}
-		lu += stride - 9;
-		h += stride - 9;
-	}
-	int8_t* l = hl_ + off - stride;
-#ifdef HAVE_HH
-	h = hh_ + off - stride;
-#endif
-	for (th = 10; --th >= 0; ) {
-		int l0 = l[-1];
-		int h0 = h[-1];
-		int l1 = *l++;
-#ifdef HAVE_HH
-		int h1 = *h++;
-#else
-		int h1 = 0;
-#endif
-		for (int w = 8; --w >= 0; ) {
-			int l3 = l1 + (l1 << 1);
-			int h3 = h1 + (h1 << 1);
-			int v = l0 + l3 + h0 - h3;
-			*o++ = v >> 2;
-
-			l0 = l1;
-			h0 = h1;
-			l1 = *l++;
-#ifdef HAVE_HH
-			h1 = *h++;
-#endif
-			v = l3 + l1 + h3 - h1;
-			*o++ = v >> 2;
-		}
-		l += stride - 9;
-#ifdef HAVE_HH
-		h += stride - 9;
-#endif
-	}
-
-	o = blk;
-	off = y * inw_ + x;
-	u_int8_t* out = frm_ + off;
-	for (int w = 16; --w >= 0; ) {
-		const int16_t* cl = o++;
-		const int16_t* ch = cl + 10*16;
-		u_int8_t* p = out++;
-
-		int l0 = *cl;
-		cl += 16;
-		int h0 = *ch;
-		ch += 16;
-		int l1 = *cl;
-		cl += 16;
-		int h1 = *ch;
-		ch += 16;
-		
-		for (int th = 8; --th >= 0; ) {
-			int l3 = l1 + (l1 << 1);
-			int h3 = h1 + (h1 << 1);
-			int v = l3 + l0 + h0 - h3;
-			v >>= 2;
-			/*XXX*/
-			if (v & ~0xff)
-				v = (v < 0) ? 0 : 255;
-			*p = v;
-			p += inw_;
-
-			l0 = l1;
-			h0 = h1;
-			l1 = *cl;
-			cl += 16;
-			h1 = *ch;
-			ch += 16;
-
-			v = l1 + l3 + h3 - h1;
-			v >>= 2;
-			/*XXX*/
-			if (v & ~0xff)
-				v = (v < 0) ? 0 : 255;
-			*p = v;
-			p += inw_;
-		}
-	}
-}
-
-void haar_rev(const int8_t* in, int8_t* out, int stride)
-{
-	int blk[64];
-	int* o = blk;
-
-#ifdef notdef
-	if (nohaar)
-		return;
-#endif
-
-	int m = 0xff;/*XXX make sure DC is unsigned*/
-
-	/* inverse Haar transform 8x8 base image */
-	int k;
-	for (k = 8; --k >= 0; ) {
-		int t4 = in[0];
-		t4 &= m;
-		m = ~0;
-		int t5 = in[1];
-		int t0 = t4 - t5;
-		int t1 = t4 + t5;
-			
-		t4 = in[2];
-		t5 = in[3];
-		int t2 = t0 - t4;
-		int t3 = t0 + t4;
-		t4 = t1 - t5;
-		t5 = t1 + t5;
-
-		t0 = in[4];
-		t1 = in[5];
-		o[0] = t2 - t0;
-		o[1] = t2 + t0;
-		o[2] = t3 - t1;
-		o[3] = t3 + t1;
-
-		t0 = in[6];
-		t1 = in[7];
-		o[4] = t4 - t0;
-		o[5] = t4 + t0;
-		o[6] = t5 - t1;
-		o[7] = t5 + t1;
-
-		o += 8;
-		in += 8;
-	}
-	/* columns */
-	o = blk;
-	for (k = 8; --k >= 0; ) {
-		int t4 = o[0*8];
-		int t5 = o[1*8];
-		int t0 = t4 - t5;
-		int t1 = t4 + t5;
-
-		t4 = o[2*8];
-		t5 = o[3*8];
-		int t2 = t0 - t4;
-		int t3 = t0 + t4;
-		t4 = t1 - t5;
-		t5 = t1 + t5;
-
-		t0 = o[4*8];
-		t1 = o[5*8];
-
-		/*
-		 * Saturate the reconstructed values, since quantization
-		 * of the transform coefficients can result in values
-		 * outside [0,255].
-		 */
-#define UCLIMIT(x) ((t = (x)), (t &= ~(t>>31)), (t | ~((t-256) >> 31)))
-		int t;
-		*out = UCLIMIT(t2 - t0);
-		out += stride;
-		*out = UCLIMIT(t2 + t0);
-		out += stride;
-		*out = UCLIMIT(t3 - t1);
-		out += stride;
-		*out = UCLIMIT(t3 + t1);
-		out += stride;
-
-		t0 = o[6*8];
-		t1 = o[7*8];
-		*out = UCLIMIT(t4 - t0);
-		out += stride;
-		*out = UCLIMIT(t4 + t0);
-		out += stride;
-		*out = UCLIMIT(t5 - t1);
-		out += stride;
-		*out = UCLIMIT(t5 + t1);
-		out += stride;
-
-		out -= stride << 3;
-		++out;
-		++o;
-	}
+	bvc_reconstruct(ll_ + off, lh_ + off, hl_ + off, stride,
+			frm_ + y * inw_ + x, inw_);
 }
 
 #define DECODE(v, qs) \
@@ -676,7 +475,7 @@ void BvcDecoder::decode_block(int x, int y)
 	int8_t LL[64];
 	memset(LL, 0, sizeof(LL));
 	decode_sbc(LL, hl, lh, stride);
-	haar_rev(LL, ll, stride);
+	bvc_haar_rev(LL, ll, stride);
 
 	int8_t junk[64];
 	memset(LL, 0, sizeof(LL));
@@ -684,10 +483,10 @@ void BvcDecoder::decode_block(int x, int y)
 	int s = inw_ * inh_;
 	int8_t* chm = (int8_t*)frm_ + s;
 	chm += (y >> 1) * (inw_ >> 1) + (x >> 1);
-	haar_rev(LL, chm, inw_ >> 1);
+	bvc_haar_rev(LL, chm, inw_ >> 1);
 	memset(LL, 0, sizeof(LL));
 	decode_sbc(LL, junk, junk, 8);
-	haar_rev(LL, chm + (s >> 2), inw_ >> 1);
+	bvc_haar_rev(LL, chm + (s >> 2), inw_ >> 1);
 
 	/*
 	 * XXX this needs a comment; esp. subtlety about sign change
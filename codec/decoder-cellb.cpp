@@ -183,6 +183,12 @@ void CellbDecoder::decode(const u_char* p, int cc, int cellx, int celly,
 
 void CellbDecoder::recv(pktbuf* pb)
 {
+	if (dormant()) {
+		/* the blocks sent after wake() fill the picture in again */
+		++nskip_;
+		pb->release();
+		return;
+	}
 	rtphdr* rh = (rtphdr*)pb->dp;
 	cellbhdr* ph = (cellbhdr*)(rh + 1);
 	int w = ntohs(ph->width) & 0x7fff;
@@ -196,6 +202,7 @@ void CellbDecoder::recv(pktbuf* pb)
 		}
 		resize(w, h);
 	}
+	frame();
 	int cc = pb->len - (sizeof(*rh) + sizeof(*ph));
 	decode((u_char*)(ph + 1), cc, ntohs(ph->x), ntohs(ph->y), w, h);
 	if (ntohs(rh->rh_flags) & RTP_M) {
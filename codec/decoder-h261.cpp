@@ -38,6 +38,83 @@ static const char rcsid[] =
 #include "decoder.h"
 #include "renderer.h"
 #include "p64/p64.h"
+#include "framepool.h"
+#include "worker.h"
+#include "trace.h"
+
+/*
+ * Most packets a frame is split across for parallel decoding.
+ * There are only 12 GOBs in a CIF frame, so more slices than that
+ * just adds overhead.
+ */
+#define H261_MAXSLICE 12
+
+/*
+ * The packets a dormant decoder keeps to decode when it wakes: the
+ * latest H261_FFWD bytes of them, which is about a second of a 1 Mb/s
+ * stream (and 16 s at 64 kb/s).  Over RTP (RFC 2032) each H.261
+ * packet starts on a GOB or macroblock, so decoding can start at any
+ * of them, and conditional replenishment codes every block it sends
+ * intra; decoding what came in lately brings back the picture but
+ * for the blocks last sent before then, in the GOBs whose packets
+ * were dropped to make room.  Those are asked for in a key frame.
+ */
+#define H261_FFWD	(128 << 10)
+
+/*
+ * One RTP packet, with its H.261 payload header already parsed.
+ */
+struct H261Packet {
+	pktbuf* pb;
+	const u_char* bp;
+	int cc;
+	int sbit;
+	int ebit;
+	int mba;
+	int gob;
+	int quant;
+	int mvdh;
+	int mvdv;
+};
+
+/*
+ * The packets of one frame, held for parallel decoding.
+ */
+struct H261Batch {
+	H261Batch() : next_(0), ssrc_(0), ts_(0), start_(0.), npkt_(0),
+		      maxpkt_(0), pkt_(0) {}
+	~H261Batch() { delete[] pkt_; }
+	H261Batch* next_;
+	u_int32_t ssrc_;	/* net order, for tracing */
+	u_int32_t ts_;
+	double start_;		/* arrival time of the first packet */
+	int npkt_;
+	int maxpkt_;
+	H261Packet* pkt_;
+};
+
+class H261Decoder;
+
+/*
+ * Decodes a range of the packets of a frame on a worker thread.
+ */
+class H261Task : public WorkerTask {
+    public:
+	H261Task() : decoder_(0), slice_(0), first_(0), last_(0) {}
+	virtual void run();
+	H261Decoder* decoder_;
+	SliceP64Decoder* slice_;
+	int first_;
+	int last_;
+};
+
+class H261Reply : public WorkerReply {
+    public:
+	H261Reply(H261Decoder* d) : decoder_(d) {}
+    protected:
+	virtual void ready();
+	H261Decoder* decoder_;
+};
 
 class H261Decoder : public Decoder {
     public:
@@ -47,11 +124,76 @@ class H261Decoder : public Decoder {
 	virtual void recv(pktbuf*);
 	int colorhist(u_int* hist) const;
 	virtual void stats(char* wrk);
+	virtual int command(int argc, const char*const* argv);
+	void work(SliceP64Decoder*, int first, int last);
+	void frame_done();
     protected:
 	void decode(const u_char* vh, const u_char* bp, int cc);
 	virtual void redraw();
+	virtual void idle();
+	virtual int framemem() const;
+	virtual void wake();
+	virtual void rescale();
+	void skim(pktbuf* pb);
+	void ffdrop();
+	int gobof(const u_char* vh) const;
+	void pullstats();
+	void delay(double start);
+	inline int busy() const {
+		return (cur_ != 0 || head_ != 0 || busy_ != 0);
+	}
+	void queue(pktbuf* pb, const u_char* bp, int cc, int sbit, int ebit,
+		   int mba, int gob, int quant, int mvdh, int mvdv,
+		   u_int32_t ts, int mbit);
+	void close_frame();
+	void start_frame();
+	void finish_frame();
+	void release_frame(H261Batch*);
 	P64Decoder* codec_;
 	int h261_rtp_bug_;
+
+	double fstart_;		/* arrival of first packet of frame */
+	double delay_;		/* smoothed frame latency (usec) */
+
+	/*
+	 * State for parallel decoding (see the "parallel" command).
+	 * Packets are collected a frame at a time.  Once a frame is
+	 * complete, its packets are split into contiguous ranges that
+	 * are decoded at once by the worker pool, each into the shared
+	 * frame buffer through its own SliceP64Decoder.  The last task
+	 * to finish merges the slices, and the frame is handed back to
+	 * the main thread to be rendered.  Only one frame is decoded
+	 * at a time since each depends on the one before.
+	 */
+	int parallel_;
+	H261Reply* reply_;
+	H261Batch* cur_;	/* frame being collected */
+	H261Batch* head_;	/* complete frames waiting to be decoded */
+	H261Batch* tail_;
+	H261Batch* busy_;	/* frame being decoded */
+	H261Batch* free_;
+	volatile int ntask_;	/* tasks not yet done with busy_ */
+	volatile int done_;	/* busy_ is decoded and synced */
+	int nstart_;		/* frames given to the pool */
+	volatile int npost_;	/* frames the pool is all done with */
+	int redraw_pending_;
+	int nslice_;
+	SliceP64Decoder* slice_[H261_MAXSLICE];
+	H261Task task_[H261_MAXSLICE];
+
+	/*
+	 * The packets kept while dormant, length (2 bytes) first, in a
+	 * ring from the FramePool.  A packet doesn't wrap round the end;
+	 * a zero length (or the end too near for one) says the next is
+	 * at the front.
+	 */
+	u_char* ffwd_;
+	int ffhead_;		/* the oldest */
+	int fftail_;		/* where the next goes */
+	int ffn_;
+	int intra_;		/* the stream is intra coded (the I bit) */
+	u_int16_t fflost_;	/* GOBs with packets dropped, one bit each */
+	BufferPool pool_;	/* for decoding them */
 };
 
 static class H261DecoderMatcher : public Matcher {
@@ -71,9 +213,16 @@ static class H261DecoderMatcher : public Matcher {
 #define STAT_BAD_FMT	3
 #define STAT_FMT_CHANGE 4	/* # times fmt changed */
 #define STAT_BAD_HEADER 5
+#define STAT_LATENCY_US	6	/* smoothed time from first packet to render */
+#define STAT_QUEUED	7	/* # frames that waited for a previous one */
 
 
-H261Decoder::H261Decoder() : Decoder(4), codec_(0), h261_rtp_bug_(0)
+H261Decoder::H261Decoder()
+	: Decoder(4), codec_(0), h261_rtp_bug_(0), fstart_(0.), delay_(0.),
+	  parallel_(0), reply_(0), cur_(0), head_(0), tail_(0), busy_(0),
+	  free_(0), ntask_(0), done_(0), nstart_(0), npost_(0),
+	  redraw_pending_(0), nslice_(0),
+	  ffwd_(0), ffhead_(0), fftail_(0), ffn_(0), intra_(0), fflost_(0)
 {
 	stat_[STAT_BAD_PSC].name = "H261-Bad-PSC";
 	stat_[STAT_BAD_GOB].name = "H261-Bad-GOB";
@@ -81,9 +230,12 @@ H261Decoder::H261Decoder() : Decoder(4), codec_(0), h261_rtp_bug_(0)
 	stat_[STAT_BAD_FMT].name = "H261-Bad-fmt";
 	stat_[STAT_FMT_CHANGE].name = "H261-Fmt-change";
 	stat_[STAT_BAD_HEADER].name = "H261-Bad-Header";
-	nstat_ = 6;
+	stat_[STAT_LATENCY_US].name = "H261-Frame-latency-usec";
+	stat_[STAT_QUEUED].name = "H261-Frames-queued";
+	nstat_ = 8;
 
 	decimation_ = 420;
+	maxscale_ = 2;
 	/*
 	 * Assume CIF.  Picture header will trigger a resize if
 	 * we encounter QCIF instead.
@@ -97,7 +249,50 @@ H261Decoder::H261Decoder() : Decoder(4), codec_(0), h261_rtp_bug_(0)
 
 H261Decoder::~H261Decoder()
 {
+	/*
+	 * The worker pool may still be using our frame buffer,
+	 * or posting the reply for it, so wait for it to finish.
+	 */
+#ifndef WIN32
+	while (npost_ != nstart_)
+		usleep(1000);
+#endif
+	if (busy_ != 0)
+		release_frame(busy_);
+	if (cur_ != 0)
+		release_frame(cur_);
+	while (head_ != 0) {
+		H261Batch* f = head_;
+		head_ = f->next_;
+		release_frame(f);
+	}
+	while (free_ != 0) {
+		H261Batch* f = free_;
+		free_ = f->next_;
+		delete f;
+	}
+	for (int i = 0; i < nslice_; ++i)
+		delete slice_[i];
+	delete reply_;
 	delete codec_;
+	framefree(ffwd_);
+}
+
+int H261Decoder::command(int argc, const char*const* argv)
+{
+	if (argc == 3 && strcmp(argv[1], "parallel") == 0) {
+		/*
+		 * Frames already queued are still decoded in parallel
+		 * when this is turned off; recv() goes back to decoding
+		 * in line once they drain.
+		 */
+		parallel_ = atoi(argv[2]) != 0 &&
+			WorkerPool::instance().nthread() > 0;
+		if (parallel_ && reply_ == 0)
+			reply_ = new H261Reply(this);
+		return (TCL_OK);
+	}
+	return (Decoder::command(argc, argv));
 }
 
 void H261Decoder::info(char* wrk) const
@@ -108,21 +303,52 @@ void H261Decoder::info(char* wrk) const
 		sprintf(wrk, "[q=%d]", codec_->gobquant());
 }
 
-void H261Decoder::stats(char* wrk)
+void H261Decoder::pullstats()
 {
 	/* pull stats out of vic indepdendent P64Decoder */
+	if (codec_ == 0)
+		return;
 	setstat(STAT_BAD_PSC, codec_->bad_psc());
 	setstat(STAT_BAD_GOB, codec_->bad_GOBno());
 	setstat(STAT_BAD_SYNTAX, codec_->bad_bits());
 	setstat(STAT_BAD_FMT, codec_->bad_fmt());
+	setstat(STAT_LATENCY_US, (u_int)delay_);
+}
+
+void H261Decoder::stats(char* wrk)
+{
+	/*
+	 * While a frame is being decoded, the P64Decoder counters
+	 * belong to the worker pool, so report what we had when
+	 * the last frame finished.
+	 */
+	if (busy_ == 0)
+		pullstats();
 	Decoder::stats(wrk);
 }
 
+/*
+ * Fold the time since the first packet of a frame arrived
+ * into the smoothed frame latency.
+ */
+void H261Decoder::delay(double start)
+{
+	if (start == 0.)
+		return;
+	double d = gettimeofday_usecs() - start;
+	if (delay_ == 0.)
+		delay_ = d;
+	else
+		delay_ += (d - delay_) / 16.;
+}
+
 int H261Decoder::colorhist(u_int* hist) const
 {
+	if (codec_ == 0)
+		return (0);
 	const u_char* frm = codec_->frame();
-	int w = inw_;
-	int h = inh_;
+	int w = inw_ >> scale_;
+	int h = inh_ >> scale_;
 	int s = w * h;
 	colorhist_420_556(hist, frm, frm + s, frm + s + (s >> 2), w, h);
 	return (1);
@@ -159,6 +385,10 @@ void dumpShadow(u_int32_t ts, u_char* p, int nblk)
 
 void H261Decoder::recv(pktbuf* pb)
 {	
+	if (dormant()) {
+		skim(pb);
+		return;
+	}
 	rtphdr* rh = (rtphdr*)pb->dp;
 	u_int8_t* vh = (u_int8_t*)(rh + 1);
 	if (codec_ == 0) {
@@ -166,7 +396,10 @@ void H261Decoder::recv(pktbuf* pb)
 			codec_ = new IntraP64Decoder();
 		else
 			codec_ = new FullP64Decoder();
+		codec_->scale(scale_);
 		codec_->marks(rvts_);
+		/* its frames are from the pool: see idle() */
+		ssched(FRAMEPOOL_IDLE);
 	}
 #ifdef CR_STATS
 	memcpy(shadow, rvts_, nblk_);
@@ -209,6 +442,13 @@ void H261Decoder::recv(pktbuf* pb)
 		return;
 	}
 	int cc = pb->len - (sizeof(*rh) + 4);
+	if (parallel_ || busy()) {
+		queue(pb, vh + 4, cc, sbit, ebit, mba, gob, quant, mvdh, mvdv,
+		      ntohl(rh->rh_ts), ntohs(rh->rh_flags) & RTP_M);
+		return;
+	}
+	if (fstart_ == 0.)
+		fstart_ = gettimeofday_usecs();
 	codec_->mark(now_);
 	(void)codec_->decode(vh + 4, cc, sbit, ebit,
 			     mba, gob, quant, mvdh, mvdv);
@@ -230,12 +470,383 @@ void H261Decoder::recv(pktbuf* pb)
 		ndblk_ = codec_->ndblk();
 		render_frame(codec_->frame());
 		codec_->resetndblk();
+		delay(fstart_);
+		fstart_ = 0.;
+		/* the windows changed: the next frame at the size they want */
+		if (reduction(inw_, inh_) != scale_) {
+			resize(inw_, inh_);
+			codec_->marks(rvts_);
+		}
 	}
 	pb->release();
 }
 
 void H261Decoder::redraw()
 {
+	if (busy_ != 0) {
+		/* can't touch the frame until the pool is done with it */
+		redraw_pending_ = 1;
+		return;
+	}
 	if (codec_ != 0)
 		Decoder::redraw(codec_->frame());
 }
+
+/*
+ * Nothing decoded for a while: give back the frames, with the
+ * P64Decoder they belong to; recv() makes another.
+ */
+void H261Decoder::idle()
+{
+	/* the worker pool may have them */
+	if (busy())
+		return;
+	delete codec_;
+	codec_ = 0;
+}
+
+/* called by resize(), with the worker pool done with the frame */
+void H261Decoder::rescale()
+{
+	if (codec_ != 0)
+		codec_->scale(scale_);
+}
+
+int H261Decoder::framemem() const
+{
+	return (framemem_ + (codec_ != 0 ? codec_->framemem() : 0));
+}
+
+/*
+ * Dormant: keep the packet to decode on waking, dropping the oldest
+ * to make room.
+ */
+void H261Decoder::skim(pktbuf* pb)
+{
+	++nskip_;
+	int len = pb->len;
+	int need = len + 2;
+	if (len < int(sizeof(rtphdr) + 4) || need > H261_FFWD) {
+		pb->release();
+		return;
+	}
+	intra_ = (pb->dp[sizeof(rtphdr)] & 2) != 0;
+	if (ffwd_ == 0) {
+		ffwd_ = framealloc(H261_FFWD);
+		ffhead_ = fftail_ = ffn_ = 0;
+		fflost_ = 0;
+	}
+	for (;;) {
+		if (ffn_ == 0) {
+			ffhead_ = fftail_ = 0;
+			break;
+		}
+		if (ffhead_ < fftail_) {
+			/* room up to the end? */
+			if (fftail_ + need <= H261_FFWD)
+				break;
+			if (fftail_ + 2 <= H261_FFWD)
+				ffwd_[fftail_] = ffwd_[fftail_ + 1] = 0;
+			fftail_ = 0;
+		} else if (fftail_ + need <= ffhead_)
+			/* room up to the oldest */
+			break;
+		else
+			ffdrop();
+	}
+	ffwd_[fftail_] = len >> 8;
+	ffwd_[fftail_ + 1] = len;
+	memcpy(ffwd_ + fftail_ + 2, pb->dp, len);
+	fftail_ += need;
+	++ffn_;
+	pb->release();
+}
+
+/*
+ * The GOB a packet (its H.261 header) starts in, 0 for the picture
+ * header, taking the fields as recv() last did.
+ */
+int H261Decoder::gobof(const u_char* vh) const
+{
+	u_int v = ntohl(*(u_int32_t*)vh);
+	int gob = h261_rtp_bug_ ? (v >> 15) & 0xf : (v >> 20) & 0xf;
+	if (gob > 12)
+		gob = h261_rtp_bug_ ? (v >> 20) & 0xf : (v >> 15) & 0xf;
+	return (gob <= 12 ? gob : 0);
+}
+
+/*
+ * Drop the oldest packet kept, noting the GOBs it ran over: from
+ * the one it starts in to the one the next starts in, if that is
+ * of the same frame, else to the last.
+ */
+void H261Decoder::ffdrop()
+{
+	const u_char* p = ffwd_ + ffhead_ + 2;
+	u_int32_t ts = ((rtphdr*)p)->rh_ts;
+	int first = gobof(p + sizeof(rtphdr));
+	int last = 12;
+	ffhead_ += (ffwd_[ffhead_] << 8 | ffwd_[ffhead_ + 1]) + 2;
+	if (--ffn_ > 0 && (ffhead_ + 2 > H261_FFWD ||
+			   (ffwd_[ffhead_] | ffwd_[ffhead_ + 1]) == 0))
+		ffhead_ = 0;
+	if (ffn_ > 0) {
+		const u_char* n = ffwd_ + ffhead_ + 2;
+		int gob = gobof(n + sizeof(rtphdr));
+		if (((rtphdr*)n)->rh_ts == ts && gob >= first)
+			last = gob;
+	}
+	if (first == 0)
+		first = 1;
+	fflost_ |= (2 << last) - (1 << first);
+}
+
+/*
+ * Attached again: decode the packets kept, with nothing attached to
+ * render them, so that the renderer's first redraw has the picture
+ * as it is now.  A key frame is asked for if packets were dropped
+ * from the ring, or if the sender codes frames from the one before
+ * (not vic's).
+ */
+void H261Decoder::wake()
+{
+	if (ffwd_ == 0)
+		return;
+	/* not behind frames the worker pool still has */
+	if (!busy()) {
+		int dormancy = dormancy_;
+		int parallel = parallel_;
+		dormancy_ = 0;
+		parallel_ = 0;
+		int pos = ffhead_;
+		for (int i = 0; i < ffn_; ++i) {
+			if (pos + 2 > H261_FFWD ||
+			    (ffwd_[pos] | ffwd_[pos + 1]) == 0)
+				pos = 0;
+			int len = ffwd_[pos] << 8 | ffwd_[pos + 1];
+			pktbuf* pb = pool_.alloc();
+			memcpy(pb->dp, ffwd_ + pos + 2, len);
+			pb->len = len;
+			recv(pb);
+			pos += len + 2;
+		}
+		dormancy_ = dormancy;
+		parallel_ = parallel;
+	}
+	if (!intra_ || fflost_ != 0)
+		keyreq(1);
+	framefree(ffwd_);
+	ffn_ = 0;
+	fflost_ = 0;
+}
+
+void H261Decoder::queue(pktbuf* pb, const u_char* bp, int cc, int sbit,
+			int ebit, int mba, int gob, int quant, int mvdh,
+			int mvdv, u_int32_t ts, int mbit)
+{
+	/*
+	 * A new timestamp means we lost the packet with the
+	 * marker bit; decode what we have of the old frame.
+	 */
+	if (cur_ != 0 && cur_->ts_ != ts)
+		close_frame();
+	if (cur_ == 0) {
+		cur_ = free_;
+		if (cur_ != 0)
+			free_ = cur_->next_;
+		else
+			cur_ = new H261Batch;
+		cur_->next_ = 0;
+		cur_->ssrc_ = ((rtphdr*)pb->data)->rh_ssrc;
+		cur_->ts_ = ts;
+		cur_->start_ = (fstart_ != 0.) ? fstart_ : gettimeofday_usecs();
+		fstart_ = 0.;
+	}
+	H261Batch* f = cur_;
+	if (f->npkt_ >= f->maxpkt_) {
+		int n = (f->maxpkt_ == 0) ? 16 : 2 * f->maxpkt_;
+		H261Packet* p = new H261Packet[n];
+		if (f->npkt_ > 0)
+			memcpy(p, f->pkt_, f->npkt_ * sizeof(*p));
+		delete[] f->pkt_;
+		f->pkt_ = p;
+		f->maxpkt_ = n;
+	}
+	H261Packet* p = &f->pkt_[f->npkt_++];
+	p->pb = pb;
+	p->bp = bp;
+	p->cc = cc;
+	p->sbit = sbit;
+	p->ebit = ebit;
+	p->mba = mba;
+	p->gob = gob;
+	p->quant = quant;
+	p->mvdh = mvdh;
+	p->mvdv = mvdv;
+	if (mbit)
+		close_frame();
+}
+
+void H261Decoder::close_frame()
+{
+	H261Batch* f = cur_;
+	cur_ = 0;
+	if (head_ == 0)
+		head_ = f;
+	else
+		tail_->next_ = f;
+	tail_ = f;
+	if (busy_ == 0)
+		start_frame();
+	else
+		count(STAT_QUEUED);
+}
+
+/*
+ * Hand the next complete frame to the worker pool.
+ * Called on the main thread with nothing in progress.
+ */
+void H261Decoder::start_frame()
+{
+	H261Batch* f = head_;
+	if (f == 0)
+		return;
+	head_ = f->next_;
+	if (head_ == 0)
+		tail_ = 0;
+	f->next_ = 0;
+
+	/*
+	 * A format change reallocates the frame buffer, so it has
+	 * to happen here rather than in the middle of the slices.
+	 * Only packets that start with a picture header can have one.
+	 */
+	for (int i = 0; i < f->npkt_; ++i) {
+		H261Packet* p = &f->pkt_[i];
+		if (p->gob == 0)
+			(void)codec_->prepare(p->bp, p->cc, p->sbit);
+	}
+	if (codec_->width() != inw_) {
+		resize(codec_->width(), codec_->height());
+		count(STAT_FMT_CHANGE);
+	} else if (reduction(inw_, inh_) != scale_)
+		resize(inw_, inh_);
+	codec_->marks(rvts_);
+	codec_->mark(now_);
+
+	int n = WorkerPool::instance().nthread();
+	if (n > H261_MAXSLICE)
+		n = H261_MAXSLICE;
+	if (n > f->npkt_)
+		n = f->npkt_;
+	if (n < 1)
+		n = 1;
+	while (nslice_ < n)
+		slice_[nslice_++] = new SliceP64Decoder;
+	/* reset the ones we don't use too, since all are merged */
+	for (int i = 0; i < nslice_; ++i)
+		slice_[i]->share(*codec_);
+
+	busy_ = f;
+	done_ = 0;
+	++nstart_;
+	ntask_ = n;
+	for (int i = 0; i < n; ++i) {
+		H261Task* t = &task_[i];
+		t->decoder_ = this;
+		t->slice_ = slice_[i];
+		t->first_ = i * f->npkt_ / n;
+		t->last_ = (i + 1) * f->npkt_ / n;
+	}
+	/*
+	 * Don't submit until all the tasks are set up, since a
+	 * fast worker could otherwise finish the frame early.
+	 */
+	for (int i = 0; i < n; ++i)
+		WorkerPool::instance().submit(&task_[i]);
+}
+
+void H261Task::run()
+{
+	decoder_->work(slice_, first_, last_);
+}
+
+/*
+ * Decode packets [first, last) of the current frame.
+ * Runs on a worker thread.
+ */
+void H261Decoder::work(SliceP64Decoder* slice, int first, int last)
+{
+	H261Batch* f = busy_;
+	TRACE_SCOPE_KEY(TRACE_SLICE, f->ssrc_, f->ts_);
+	for (int i = first; i < last; ++i) {
+		H261Packet* p = &f->pkt_[i];
+		(void)slice->decode(p->bp, p->cc, p->sbit, p->ebit, p->mba,
+				    p->gob, p->quant, p->mvdh, p->mvdv);
+	}
+	if (worker_add(&ntask_, -1) == 0)
+		finish_frame();
+}
+
+/*
+ * Runs on the worker thread that decoded the last slice.
+ */
+void H261Decoder::finish_frame()
+{
+	for (int i = 0; i < nslice_; ++i)
+		codec_->merge(*slice_[i]);
+	codec_->sync();
+	/*
+	 * done_ has to be seen before the reply, or the main thread
+	 * can take the reply, find the frame not done, and never be
+	 * told again.  (worker_add is a full barrier.)  Once npost_
+	 * is bumped the main thread may delete us, so it is the last
+	 * thing we touch.
+	 */
+	worker_add(&done_, 1);
+	reply_->post();
+	worker_add(&npost_, 1);
+}
+
+void H261Reply::ready()
+{
+	decoder_->frame_done();
+}
+
+/*
+ * Render a frame decoded by the worker pool and start on
+ * the next one.  Runs on the main thread.
+ */
+void H261Decoder::frame_done()
+{
+	H261Batch* f = busy_;
+	if (f == 0 || !done_)
+		return;
+	busy_ = 0;
+	pullstats();
+	/* the last packet demuxed is likely from a later frame */
+	Tracer::key(Tracer::ssrc(), f->ts_);
+	ndblk_ = codec_->ndblk();
+	render_frame(codec_->frame());
+	codec_->resetndblk();
+	delay(f->start_);
+	release_frame(f);
+	if (redraw_pending_) {
+		redraw_pending_ = 0;
+		redraw();
+	}
+	start_frame();
+}
+
+/*
+ * Give back the packets of a frame and put it on the free list.
+ * Packet buffers must be released on the main thread.
+ */
+void H261Decoder::release_frame(H261Batch* f)
+{
+	for (int i = 0; i < f->npkt_; ++i)
+		f->pkt_[i].pb->release();
+	f->npkt_ = 0;
+	f->next_ = free_;
+	free_ = f;
+}
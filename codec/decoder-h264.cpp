@@ -19,6 +19,7 @@
 #include "databuffer.h"
 #include "ffmpeg_codec.h"
 #include "rtp_h264_depayloader.h"
+#include "keyframe.h"
 
 
 #define SDP_LINE_LEN 10000
@@ -28,6 +29,10 @@
 //extern "C" UCHAR * video_frame;
 
 
+#define STAT_HELD 0
+#define STAT_KEYREQ 1
+#define STAT_RECOVERY 2
+
 class H264Decoder:public Decoder
 {
   public:
@@ -40,12 +45,12 @@ class H264Decoder:public Decoder
   protected:
     void decode(const u_char * vh, const u_char * bp, int cc);
     virtual void redraw();
+    virtual void idle();
+    virtual void wake();
 
     /* packet statistics */
     uint16_t last_seq;		/* sequence number */
 
-    UCHAR bitstream[MAX_CODED_SIZE];	/* bitstream data */
-
     /* collecting data for a frame */
     uint16_t idx;
     int last_mbit;
@@ -54,8 +59,12 @@ class H264Decoder:public Decoder
 
     int aggregate_pkt; // Count of mbits for decoding IOCOM H.264
 
-    /* image */
-    UCHAR xxx_frame[MAX_FRAME_SIZE];
+    /* loss recovery */
+    KeyWait kw_;
+    int key_;			/* frame so far has a key NAL */
+
+    /* image, from the FramePool once there is one */
+    u_char *frame_;
     FFMpegCodec h264;
     PacketBuffer *stream; //SV: probably this is going to be substituted by the AVPacket->data when we call decode()...
     H264Depayloader *h264depayloader;
@@ -83,7 +92,7 @@ static class H264DecoderMatcher:public Matcher
 dm_h264;
 
 
-H264Decoder::H264Decoder():Decoder(0 /* 0 byte extra header */)
+H264Decoder::H264Decoder():Decoder(0 /* 0 byte extra header */), frame_(0)
 {				/* , codec_(0), */
 
 
@@ -107,6 +116,7 @@ H264Decoder::H264Decoder():Decoder(0 /* 0 byte extra header */)
     last_mbit = 0;
     last_iframe = 0;
     last_seq = 0;
+    key_ = 0;
     //===================================================
 
 
@@ -125,6 +135,11 @@ H264Decoder::H264Decoder():Decoder(0 /* 0 byte extra header */)
     //cout << "new PacketBuffer..\n";
     stream = new PacketBuffer(1024, 1600); //SV: 1024 = ???
     startPkt = false;
+
+    stat_[STAT_HELD].name = "H264-Frames-held";
+    stat_[STAT_KEYREQ].name = "H264-Key-requests";
+    stat_[STAT_RECOVERY].name = "H264-Recovery-ms";
+    nstat_ = 3;
 }
 
 void
@@ -177,6 +192,7 @@ H264Decoder::~H264Decoder()
 {
     delete stream;
     delete h264depayloader;
+    framefree(frame_);
 }
 
 int H264Decoder::colorhist(u_int * hist)  const
@@ -186,8 +202,51 @@ int H264Decoder::colorhist(u_int * hist)  const
     return (1);
 }
 
+/*
+ * True if the NAL unit is an IDR slice, or the recovery point SEI
+ * (payload type 6) that x264 puts at the start of each intra
+ * refresh.
+ */
+static int key_nal(const u_char * p, int n)
+{
+    int type = p[0] & 0x1f;
+    return (type == 5 || (type == 6 && n > 1 && p[1] == 6));
+}
+
+/*
+ * True if an RFC 3984 payload carries a key NAL, whole, at the head
+ * of an FU-A or in a STAP-A.
+ */
+static int key_payload(const u_char * bp, int cc)
+{
+    if (cc < 2)
+	return (0);
+    int type = bp[0] & 0x1f;
+    if (type == 28)
+	return ((bp[1] & 0x80) != 0 && (bp[1] & 0x1f) == 5);
+    if (type == 24) {
+	for (++bp, --cc; cc > 2; ) {
+	    int n = bp[0] << 8 | bp[1];
+	    if (n < 1 || n + 2 > cc)
+		break;
+	    if (key_nal(bp + 2, n))
+		return (1);
+	    bp += n + 2;
+	    cc -= n + 2;
+	}
+	return (0);
+    }
+    return (key_nal(bp, cc));
+}
+
 void H264Decoder::recv(pktbuf * pb)
 {
+    if (dormant()) {
+	/* nothing decoded; after wake(), not until a key frame */
+	++nskip_;
+	pb->release();
+	return;
+    }
     rtphdr *rh = (rtphdr *) pb->dp;
     int hdrsize = sizeof(rtphdr) + hdrlen();
     u_char *buf = pb->dp + hdrsize;
@@ -200,6 +259,7 @@ void H264Decoder::recv(pktbuf * pb)
     uint16_t seq = ntohs(rh->rh_seqno);
     int packetStatus;
     //int ts = ntohl(rh->rh_ts);
+    double now = gettimeofday_usecs() / 1e6;
 
 
     //Barz: =============================================
@@ -208,6 +268,8 @@ void H264Decoder::recv(pktbuf * pb)
        startPkt = true;
        idx = seq;
        last_seq = seq - 1;
+       /* nothing to predict from yet */
+       kw_.damaged(now);
     }
 
     int pktIdx = seq - idx;
@@ -220,6 +282,8 @@ void H264Decoder::recv(pktbuf * pb)
 	    idx = seq;
 	    pktIdx = 0;
 	    stream->clear();
+	    key_ = 0;
+	    kw_.damaged(now);
     }else if (last_seq + 1 != seq) {
 	    // oops - missing packet
 	    debug_msg("H264_RTP: missing packet\n");
@@ -248,6 +312,7 @@ void H264Decoder::recv(pktbuf * pb)
        }
     } else {
        packetStatus = h264depayloader->h264_handle_packet(h264depayloader->h264_extradata, pktIdx, stream, buf, len);
+       key_ |= key_payload(buf, len);
     }
 
 
@@ -257,25 +322,44 @@ void H264Decoder::recv(pktbuf * pb)
     if (mbit) {
 	    stream->setTotalPkts(pktIdx + 1);
 
+	    /*
+	     * A frame with a piece missing, and those predicted from it,
+	     * would only show garbage: hold the last good one up until a
+	     * key frame comes in.  (IOCOM's format isn't looked into, so
+	     * its frames all count as key frames.)
+	     */
 	    DataBuffer *f;
-	    if (stream->isComplete()) {
+	    if (!stream->isComplete())
+		    kw_.damaged(now);
+	    else if (kw_.frame(key_ || fmt == 107, now)) {
 		    f = stream->getStream();
-		    decodeLen =  h264.decode((UCHAR *) f->getData(), f->getDataSize(), xxx_frame);
-	    }
-
-	    if (decodeLen < 0) {
-		  debug_msg("H264_RTP: frame error\n");
-	    }
-
-	    if (inw_ != h264.width || inh_ != h264.height) {
-			inw_ = h264.width;
-			inh_ = h264.height;
-			resize(inw_, inh_);
-	    } else {
-			Decoder::redraw(xxx_frame);
-                //render_frame(xxx_frame);
+		    decodeLen =  h264.decode((UCHAR *) f->getData(), f->getDataSize());
+
+		    if (decodeLen < 0) {
+			  debug_msg("H264_RTP: frame error\n");
+			  /* hold the frames predicted from it */
+			  kw_.damaged(now);
+		    } else {
+			  framefit(frame_, h264.width * h264.height * 3 / 2);
+			  h264.copy(frame_);
+		    }
+
+		    if (inw_ != h264.width || inh_ != h264.height) {
+				inw_ = h264.width;
+				inh_ = h264.height;
+				resize(inw_, inh_);
+		    } else {
+				Decoder::redraw(frame_);
+			//render_frame(frame_);
+		    }
 	    }
+	    if (kw_.request(now))
+		    keyreq(1);
+	    setstat(STAT_HELD, kw_.nheld());
+	    setstat(STAT_KEYREQ, kw_.nrequest());
+	    setstat(STAT_RECOVERY, kw_.recovery());
 	    stream->clear();
+	    key_ = 0;
 	    idx = seq+1;
     }
 
@@ -286,5 +370,19 @@ void H264Decoder::recv(pktbuf * pb)
 
 void H264Decoder::redraw()
 {
-    Decoder::redraw(xxx_frame);
+    Decoder::redraw(frame_);
+}
+
+void H264Decoder::idle()
+{
+    framefree(frame_);
+}
+
+/*
+ * Start again as on the first packet: frames are held, and a key
+ * frame asked for, until one comes in.
+ */
+void H264Decoder::wake()
+{
+    startPkt = false;
 }
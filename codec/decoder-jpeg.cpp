@@ -103,7 +103,8 @@ JpegReassembler::JpegReassembler()
 	: decimate_(0), ndec_(0), hugefrm_(0), badoff_(0)
 {
 	rbsize_ = JPEG_BUFSIZE;
-	rb0_.bp = new u_char[2 * JPEG_BUFSIZE];
+	/* the bit buffer reads a little past the end */
+	rb0_.bp = new u_char[2 * JPEG_BUFSIZE + BITS_PAD];
 	rb0_.ts = ~0;
 	rb0_.drop = 0;
 	rb1_.bp = &rb0_.bp[JPEG_BUFSIZE];
@@ -146,7 +147,7 @@ u_char* JpegReassembler::reassemble(const rtphdr* rh, const u_char* bp, int& len
 		do {
 			nsize <<= 1;
 		} while (off + cc > nsize);
-		u_char* p = new u_char[2 * nsize];
+		u_char* p = new u_char[2 * nsize + BITS_PAD];
 		memcpy(p, rb0_.bp, rbsize_);
 		memcpy(p + nsize, rb1_.bp, rbsize_);
 		delete[] rb0_.bp;
@@ -238,9 +239,11 @@ public:
 protected:
 	virtual void recv(pktbuf*);
 	virtual void redraw();
+	virtual void rescale();
 
 	int inq_;		/* input quantization */
 	int type_;		/* JPEG/RTP parameters type code */
+	int dri_;		/* restart interval, from the restart header */
 
 	void configure();
 	JpegPixelDecoder* codec_;
@@ -270,7 +273,9 @@ MotionJpegDecoder::MotionJpegDecoder()
 	inq_ = 0;
 	/* guess type 0 */
 	type_ = 0;
+	dri_ = 0;
 	decimation_ = 422;
+	maxscale_ = 2;
 
 	stat_[STAT_BADOFF].name = "Bad-Offset";
 	stat_[STAT_HUGEFRM].name = "Huge-Frame";
@@ -294,7 +299,7 @@ void MotionJpegDecoder::configure()
 {
 	config_.comp[0].hsf = 2;
 	int old_decimation = decimation_;
-	if (type_ == 1) {
+	if ((type_ & ~JPEG_TYPE_RESTART) == 1) {
 		decimation_ = 420;
 		config_.comp[0].vsf = 2;
 	} else {
@@ -311,12 +316,14 @@ void MotionJpegDecoder::configure()
 
 	delete codec_;
 	codec_ = JpegPixelDecoder::create(config_, inw_, inh_);
+	codec_->scale(scale_);
 	Tcl& tcl = Tcl::instance();
 	int q = atoi(tcl.attr("softJPEGthresh"));
 	if (q < 0)
 		q = JpegDecoder::q_to_thresh(inq_);
 	codec_->thresh(q);
 	codec_->cthresh(atoi(tcl.attr("softJPEGcthresh")));
+	codec_->restart_interval(dri_);
 
 	if (old_decimation != decimation_)
 		tcl.evalf("decoder_changed %s", name());
@@ -325,13 +332,15 @@ void MotionJpegDecoder::configure()
 int MotionJpegDecoder::colorhist(u_int* hist) const
 {
 	const u_char* frm = codec_->frame();
-	int off = inw_ * inh_;
+	int w = inw_ >> scale_;
+	int h = inh_ >> scale_;
+	int off = w * h;
 	if (decimation_ == 420)
 		colorhist_420_556(hist, frm, frm + off, frm + off + (off >> 2),
-				  inw_, inh_);
+				  w, h);
 	else
 		colorhist_422_556(hist, frm, frm + off, frm + off + (off >> 1),
-				  inw_, inh_);
+				  w, h);
 	return (1);
 }
 
@@ -351,11 +360,22 @@ void MotionJpegDecoder::recv(pktbuf* pb)
 		resize(inw, inh);
 		needConfig = 1;
 	}
+	u_int8_t* bp = (u_int8_t*)(p + 1);
+	int cc = pb->len - (sizeof(*rh) + sizeof(*p));
+	int dri = 0;
+	if (p->type & JPEG_TYPE_RESTART) {
+		const jpegrsthdr* rst = (const jpegrsthdr*)bp;
+		dri = ntohs(rst->dri);
+		bp += sizeof(*rst);
+		cc -= sizeof(*rst);
+	}
+	if (dri != dri_) {
+		dri_ = dri;
+		needConfig = 1;
+	}
 	if (needConfig)
 		configure();
 
-	u_int8_t* bp = (u_int8_t*)(p + 1);
-	int cc = pb->len - (sizeof(*rh) + sizeof(*p));
 	bp = reasm_.reassemble(rh, bp, cc);
 	if (bp != 0) {
 		/*
@@ -375,6 +395,9 @@ void MotionJpegDecoder::recv(pktbuf* pb)
 			}
 		}
 		if (doSoftwareDecode) {
+			/* the windows changed: decode at the size they want */
+			if (reduction(inw_, inh_) != scale_)
+				resize(inw_, inh_);
 			codec_->decode(bp, cc, rvts_, now_);
 			ndblk_ = codec_->ndblk();
 			render_frame(codec_->frame());
@@ -389,3 +412,10 @@ void MotionJpegDecoder::redraw()
 	if (codec_ != 0)
 		Decoder::redraw(codec_->frame());
 }
+
+/* (configure() gives a new codec the scale) */
+void MotionJpegDecoder::rescale()
+{
+	if (codec_ != 0)
+		codec_->scale(scale_);
+}
@@ -10,12 +10,17 @@
 #include "databuffer.h"
 #include "packetbuffer.h"
 #include "ffmpeg_codec.h"
+#include "keyframe.h"
 
 
 //#define DIRECT_DISPLAY 1
 
 extern "C" UCHAR * video_frame;
 
+#define STAT_HELD 0
+#define STAT_KEYREQ 1
+#define STAT_RECOVERY 2
+
 class MPEG4Decoder:public Decoder
 {
   public:
@@ -27,18 +32,23 @@ class MPEG4Decoder:public Decoder
   protected:
     void decode(const u_char * vh, const u_char * bp, int cc);
     virtual void redraw();
+    virtual void idle();
+    virtual void wake();
 
     /* packet statistics */
     u_int16_t last_seq;		/* sequence number */
-    bool startPkt, startFrame;
+    bool startPkt;
     PacketBuffer *stream;
 
     /* collecting data for a frame */
     int last_iframe;
     int idx;
 
-    /* image */
-    UCHAR xxx_frame[MAX_FRAME_SIZE];
+    /* loss recovery */
+    KeyWait kw_;
+
+    /* image, from the FramePool once there is one */
+    u_char *frame_;
     FFMpegCodec mpeg4;
   
     
@@ -61,7 +71,7 @@ static class MPEG4DecoderMatcher:public Matcher
 dm_mpeg4;
 
 
-MPEG4Decoder::MPEG4Decoder():Decoder(2)
+MPEG4Decoder::MPEG4Decoder():Decoder(2), frame_(0)
 {				/* , codec_(0), */
 
     decimation_ = 420;
@@ -78,9 +88,13 @@ MPEG4Decoder::MPEG4Decoder():Decoder(2)
     mpeg4.init(false, CODEC_ID_MPEG4, PIX_FMT_YUV420P);
     mpeg4.init_decoder();
     startPkt = false;
-    startFrame = false;
     stream = new PacketBuffer(1024, 1600);
 
+    stat_[STAT_HELD].name = "MPEG4-Frames-held";
+    stat_[STAT_KEYREQ].name = "MPEG4-Key-requests";
+    stat_[STAT_RECOVERY].name = "MPEG4-Recovery-ms";
+    nstat_ = 3;
+
     last_iframe = 0;
     last_seq = 0;
     debug_msg("mp4dec: initialized\n");
@@ -90,6 +104,7 @@ MPEG4Decoder::~MPEG4Decoder()
 {
     debug_msg("mp4dec: released\n");
     delete stream;
+    framefree(frame_);
 }
 
 int MPEG4Decoder::colorhist(u_int * hist) const
@@ -97,8 +112,27 @@ int MPEG4Decoder::colorhist(u_int * hist) const
     return (1);
 }
 
+/*
+ * True if the frame has an I-VOP, i.e. a VOP start code followed
+ * by a vop_coding_type of 0.
+ */
+static int key_frame(const UCHAR * p, int n)
+{
+    for (int i = 0; i + 4 < n; ++i) {
+	if (p[i] == 0 && p[i + 1] == 0 && p[i + 2] == 1 && p[i + 3] == 0xb6)
+	    return ((p[i + 4] >> 6) == 0);
+    }
+    return (0);
+}
+
 void MPEG4Decoder::recv(pktbuf * pb)
 {
+    if (dormant()) {
+	/* nothing decoded; after wake(), not until a key frame */
+	++nskip_;
+	pb->release();
+	return;
+    }
     rtphdr *rh = (rtphdr *) pb->dp;
     int hdrsize = sizeof(rtphdr);	// sizeof(rtphdr) is 12 bytes
     u_char *bp = pb->dp + hdrsize;
@@ -107,6 +141,7 @@ void MPEG4Decoder::recv(pktbuf * pb)
     int mbit = ntohs(rh->rh_flags) >> 7 & 1;
     int seq = ntohs(rh->rh_seqno);
     int ts = ntohl(rh->rh_ts);
+    double now = gettimeofday_usecs() / 1e6;
 
 	// debug_msg("seq=%d, idx=%d, size=%d\n", seq, idx, cc);
 
@@ -115,6 +150,8 @@ void MPEG4Decoder::recv(pktbuf * pb)
 	    startPkt = true;
 	    idx = seq;
 		last_seq = seq - 1;
+		/* nothing to predict from yet */
+		kw_.damaged(now);
     }
 
     int pktIdx = seq - idx;
@@ -127,6 +164,7 @@ void MPEG4Decoder::recv(pktbuf * pb)
 	    idx = seq;
 	    pktIdx = 0;
 	    stream->clear();
+	    kw_.damaged(now);
     }else if (last_seq + 1 != seq) {
 	    /* oops - missing packet */
 	    debug_msg("mp4dec: missing packet\n");
@@ -143,24 +181,39 @@ void MPEG4Decoder::recv(pktbuf * pb)
 
 	    stream->setTotalPkts(pktIdx + 1);
 
-	    if (stream->isComplete()) {
+	    /*
+	     * A frame with a piece missing, and those predicted from it,
+	     * would only show garbage: hold the last good one up until a
+	     * key frame comes in.
+	     */
+	    int held = 1;
+	    if (!stream->isComplete())
+		    kw_.damaged(now);
+	    else {
 	        f = stream->getStream();
 	        encData = (UCHAR *) f->getData();
-
-	        if (encData[0] == 0x00 && encData[1] == 0x00 && encData[2] == 0x01
-		       && encData[3] == 0xb0) {
-		       startFrame = true;
-	        }
-
-	        if (!startFrame) {
-				debug_msg("mp4dec: waiting for the first key frame...\n");
-			    pb->release();
-			    stream->clear();
-			    idx = seq + 1;
-			    return;
+	        if (kw_.frame(key_frame(encData, f->getDataSize()), now)) {
+		        len = mpeg4.decode(encData, f->getDataSize());
+		        if (len >= 0) {
+			        framefit(frame_, mpeg4.width * mpeg4.height * 3 / 2);
+			        mpeg4.copy(frame_);
+		        } else {
+			        /* hold the frames predicted from it */
+			        kw_.damaged(now);
+		        }
+		        held = 0;
 	        }
-
-	        len = mpeg4.decode(encData, f->getDataSize(), xxx_frame);
+	    }
+	    if (kw_.request(now))
+		    keyreq(1);
+	    setstat(STAT_HELD, kw_.nheld());
+	    setstat(STAT_KEYREQ, kw_.nrequest());
+	    setstat(STAT_RECOVERY, kw_.recovery());
+	    if (held) {
+		    pb->release();
+		    stream->clear();
+		    idx = seq + 1;
+		    return;
 	    }
 
 		if (len < 0) {
@@ -177,7 +230,7 @@ void MPEG4Decoder::recv(pktbuf * pb)
 			resize(inw_, inh_);
 		}
   		else {
-			Decoder::redraw(xxx_frame);
+			Decoder::redraw(frame_);
 		}
 		stream->clear();
 		idx = seq + 1;
@@ -187,5 +240,19 @@ void MPEG4Decoder::recv(pktbuf * pb)
 
 void MPEG4Decoder::redraw()
 {
-    Decoder::redraw(xxx_frame);
+    Decoder::redraw(frame_);
+}
+
+void MPEG4Decoder::idle()
+{
+    framefree(frame_);
+}
+
+/*
+ * Start again as on the first packet: frames are held, and a key
+ * frame asked for, until one comes in.
+ */
+void MPEG4Decoder::wake()
+{
+    startPkt = false;
 }
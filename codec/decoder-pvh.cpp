@@ -91,7 +91,7 @@ struct rbent {
 
 	/* dynamic bit decoding state */
 	int nbb;
-	u_int bb;
+	bitbuf bb;
 	const u_char* bs;
 	const u_char* es;
 	int ebit;
@@ -453,7 +453,7 @@ void PvhDecoder::parse_block(rbent* lp, short* blk, u_int* mask)
 	 * Cache bit buffer in registers.
 	 */
 	register int nbb = lp->nbb;
-	register u_int bb = lp->bb;
+	bitbuf bb = lp->bb;
 
 	int k, v;
 	GET_BITS(8, nbb, bb, lp->bs, v);
@@ -707,7 +707,7 @@ void PvhDecoder::reconstruct_block(int x, int y)
 
 void PvhDecoder::decode_sbc_base(rbent* lp, int8_t* p, u_int m)
 {
-	u_int bb = lp->bb;
+	bitbuf bb = lp->bb;
 	int nbb = lp->nbb;
 	for (int k = 0; m != 0; ++k, m >>= 1) {
 		if ((m & 1) != 0) {
@@ -784,7 +784,7 @@ u_int PvhDecoder::decode_tree(rbent* lp)
 void PvhDecoder::decode_sbc_refinement(rbent* lp, int8_t* p,
 				       u_int m, int bit)
 {
-	u_int bb = lp->bb;
+	bitbuf bb = lp->bb;
 	int nbb = lp->nbb;
 	int mask = 0x80 - (1 << bit);
 	for (int k = 0; m != 0; ++k, m >>= 1) {
@@ -1046,7 +1046,6 @@ int PvhDecoder::decode_resumption_ptrs(rbent* lp, pvh_resump* pr)
 		if (v == 0)
 			return (n);
 		int chan;
-		/*XXX this macro can't hack more than 16 bits at a time */
 		PVH_GET_BITS(4, lp, chan);
 		PVH_GET_BITS(16, lp, v);
 		pr->channel = chan;
@@ -1249,9 +1248,8 @@ void PvhDecoder::setup_layers(frment* fe, rbent* base)
 		channels_[chan] = p;
 		init_bbs(p);
 		p->bs += off >> 3;
-		off &= 7;
-		HUFF_READ(p->bb, p->bs);
-		p->nbb += (16 - off);
+		p->nbb = -(off & 7);
+		BITS_FILL(p->bs, p->nbb, p->bb);
 	}
 	/*
 	 * Now read the bit allocation code words from the front
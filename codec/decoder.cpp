@@ -41,6 +41,8 @@ static const char rcsid[] =
 #include "decoder.h"
 #include "renderer.h"
 #include "color-hist.h"
+#include "framepool.h"
+#include "trace.h"
 
 extern "C" {
 #ifdef USE_SHM
@@ -57,8 +59,10 @@ int shmctl(int, int, struct shmid_ds*);
 
 //SV-XXX: rearranged intialistaion order to shut upp gcc4
 Decoder::Decoder(int hdrlen) : PacketHandler(hdrlen),
-	nstat_(0), color_(1), decimation_(422), inw_(0), inh_(0), 
-	engines_(0), rvts_(0), nblk_(0), ndblk_(0)
+	nstat_(0), color_(1), decimation_(422), inw_(0), inh_(0),
+	scale_(0), maxscale_(0), reduce_(1),
+	engines_(0), plan_(new RenderPlan), rvts_(0), nblk_(0), ndblk_(0),
+	framemem_(0), nframe_(0), dormancy_(1), nskip_(0)
 {
 	/*XXX*/
 	now_ = 1;
@@ -72,6 +76,7 @@ Decoder::~Decoder()
 {
 	if (rvts_)
 		delete[] rvts_; //SV-XXX: Debian
+	delete plan_;
 }
 
 int Decoder::command(int argc, const char*const* argv)
@@ -106,6 +111,14 @@ int Decoder::command(int argc, const char*const* argv)
 			redraw();
 			return (TCL_OK);
 		}
+		if (strcmp(argv[1], "dormant") == 0) {
+			tcl.resultf("%d", dormant());
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "reduce") == 0) {
+			tcl.resultf("%d", scale_);
+			return (TCL_OK);
+		}
 		if (strcmp(argv[1], "playout") == 0) {
 			/*XXX*/
 			tcl.result("0");
@@ -116,6 +129,18 @@ int Decoder::command(int argc, const char*const* argv)
 			setcolor(atoi(argv[2]));
 			return (TCL_OK);
 		}
+		if (strcmp(argv[1], "dormant") == 0) {
+			int was = dormant();
+			dormancy_ = atoi(argv[2]);
+			if (was && !dormant())
+				wake();
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "reduce") == 0) {
+			/* from the next frame */
+			reduce_ = atoi(argv[2]);
+			return (TCL_OK);
+		}
 		if (strcmp(argv[1], "attach") == 0) {
 			Renderer* r = (Renderer*)TclObject::lookup(argv[2]);
 			if (r == 0) {
@@ -155,15 +180,71 @@ void Decoder::info(char* wrk) const
 
 void Decoder::stats(char* bp)
 {
-	if (nstat_ == 0) {
-		*bp = 0;
-		return;
-	}
+	char* p = bp;
+	*p = 0;
 	for (int i = 0; i < nstat_; ++i) {
-		sprintf(bp, "%s %d ", stat_[i].name, stat_[i].cnt);
-		bp += strlen(bp);
+		sprintf(p, "%s %d ", stat_[i].name, stat_[i].cnt);
+		p += strlen(p);
+	}
+	if (nskip_ != 0) {
+		sprintf(p, "Dormant-pkts %u ", nskip_);
+		p += strlen(p);
+	}
+	if (scale_ != 0) {
+		sprintf(p, "Reduce %d ", 1 << scale_);
+		p += strlen(p);
+	}
+	/* (only decoders with frames from the FramePool have any) */
+	int mem = framemem();
+	if (mem > 0)
+		sprintf(p, "Frame-KB %d", (mem + 1023) >> 10);
+	else if (p > bp)
+		p[-1] = 0;
+}
+
+u_char* Decoder::framealloc(int size)
+{
+	u_char* p = FramePool::alloc(size);
+	framemem_ += FramePool::size(p);
+	ssched(FRAMEPOOL_IDLE);
+	return (p);
+}
+
+void Decoder::framefree(u_char*& p)
+{
+	if (p != 0) {
+		framemem_ -= FramePool::size(p);
+		FramePool::release(p);
+		p = 0;
 	}
-	bp[-1] = 0;
+}
+
+void Decoder::framefit(u_char*& p, int size)
+{
+	if (p != 0 && FramePool::size(p) >= size)
+		return;
+	framefree(p);
+	p = framealloc(size);
+}
+
+int Decoder::framemem() const
+{
+	return (framemem_);
+}
+
+void Decoder::idle()
+{
+}
+
+void Decoder::timeout()
+{
+	if (nframe_ == 0 && framemem() > 0)
+		idle();
+	nframe_ = 0;
+	/* keep looking while there are frames, here or left in the pool */
+	FramePool::trim();
+	if (framemem() > 0 || FramePool::nfree() > 0)
+		ssched(FRAMEPOOL_IDLE);
 }
 
 void Decoder::allocshm(dmabuf& d, int size, int flag)
@@ -201,8 +282,15 @@ double Decoder::gettimeofday_usecs()
 	return (1e6 * double(tv.tv_sec) + double(tv.tv_usec));
 }
 
+void Decoder::wake()
+{
+}
+
 void Decoder::attach(Renderer* r)
 {
+	/* catch up first, with nothing to render to yet */
+	if (dormant())
+		wake();
 	r->next_ = engines_;
 	engines_ = r;
 	r->setcolor(color_);
@@ -212,11 +300,16 @@ void Decoder::attach(Renderer* r)
 
 void Decoder::redraw(const u_char* frm)
 {
+	/* nothing decoded yet, or given back in idle() */
+	if (frm == 0)
+		return;
 	/* make sure all the renderer's are synced */
 	now_ = 1;
 	memset(rvts_, 1, nblk_);
-	for (Renderer* p = engines_; p != 0; p = p->next_)
+	for (Renderer* p = engines_; p != 0; p = p->next_) {
 		p->now(0);
+		p->invalidate();
+	}
 	render_frame(frm);
 }
 
@@ -268,6 +361,8 @@ void Decoder::colorhist_420_556(u_int* hist, const u_char* yp,
 
 void Decoder::render_frame(const u_char* frm)
 {
+	TRACE_SCOPE(TRACE_RENDER);
+	++nframe_;
 	/*
 	 * Go through all the timestamps and smash the time that
 	 * is about to wrap from the past into the future to the present,
@@ -285,8 +380,23 @@ void Decoder::render_frame(const u_char* frm)
 			*ts = now_;
 	}
 
-	YuvFrame f(now_, (u_int8_t*)frm, rvts_, inw_, inh_);
-	for (Renderer* p = engines_; p != 0; p = p->next_)
+	YuvFrame f(now_, (u_int8_t*)frm, rvts_, inw_ >> scale_,
+		   inh_ >> scale_);
+	/*
+	 * Work out which blocks changed since the last frame once
+	 * here, rather than in each window.  A renderer that didn't
+	 * see the last frame (e.g., because of its update interval)
+	 * won't match the plan and scans rvts_ itself.
+	 */
+	u_int base = (now_ - 1) & 0xff;
+	Renderer* p;
+	for (p = engines_; p != 0; p = p->next_)
+		if ((p->ft() & FT_HW) == 0 && p->now() == base) {
+			plan_->build(rvts_, base);
+			f.plan_ = plan_;
+			break;
+		}
+	for (p = engines_; p != 0; p = p->next_)
 		if ((p->ft() & FT_HW) == 0)
 			p->consume(&f);
 
@@ -302,14 +412,50 @@ void Decoder::setcolor(int color)
 	}
 }
 
+/*
+ * The scale a w by h frame is decoded at: as small as the largest
+ * window showing it allows, keeping whole 8x8 blocks.  With no
+ * window (dormant, or between windows) it stays as it is.
+ */
+int Decoder::reduction(int w, int h) const
+{
+	if (!reduce_ || maxscale_ == 0)
+		return (0);
+	int s = -1;
+	for (Renderer* p = engines_; p != 0; p = p->next_) {
+		if (p->ft() & FT_HW)
+			continue;
+		int r = p->reduction(w, h);
+		if (s < 0 || r < s)
+			s = r;
+	}
+	if (s < 0)
+		s = scale_;
+	if (s > maxscale_)
+		s = maxscale_;
+	while (s > 0 && (((w >> s) | (h >> s)) & 7) != 0)
+		--s;
+	return (s);
+}
+
+void Decoder::rescale()
+{
+}
+
 void Decoder::resize(int width, int height)
 {
 	inw_ = width;
 	inh_ = height;
+	scale_ = reduction(width, height);
+	/* the decoder goes over to the new size before anything is drawn */
+	rescale();
+	width >>= scale_;
+	height >>= scale_;
 	nblk_ = (width * height) / 64;
 	delete[] rvts_; //SV-XXX: Debian
 	rvts_ = new u_char[nblk_];
 	memset(rvts_, 0, nblk_);
+	plan_->resize(width, height);
 	redraw();
 }
 
@@ -340,13 +486,43 @@ public:
 	}
 } dm_null;
 
+/*
+ * framepool resident|inuse|free: the bytes the FramePool holds.
+ */
+static class FramePoolCommand : public TclObject {
+public:
+	FramePoolCommand(const char* name) : TclObject(name) { }
+protected:
+	int command(int argc, const char*const* argv);
+} framepool_cmd("framepool");
+
+int FramePoolCommand::command(int argc, const char*const* argv)
+{
+	Tcl& tcl = Tcl::instance();
+	if (argc == 2) {
+		if (strcmp(argv[1], "resident") == 0) {
+			tcl.resultf("%u", FramePool::resident());
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "inuse") == 0) {
+			tcl.resultf("%u", FramePool::inuse());
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "free") == 0) {
+			tcl.resultf("%u", FramePool::nfree());
+			return (TCL_OK);
+		}
+	}
+	return (TclObject::command(argc, argv));
+}
+
 PlaneDecoder::PlaneDecoder(int hdrlen) : Decoder(hdrlen), frm_(0)
 {
 }
 
 PlaneDecoder::~PlaneDecoder()
 {
-	delete[] frm_; //SV-XXX: Debian
+	framefree(frm_);
 }
 
 void PlaneDecoder::redraw()
@@ -356,18 +532,30 @@ void PlaneDecoder::redraw()
 
 void PlaneDecoder::resize(int width, int height)
 {
-	delete[] frm_; //SV-XXX: Debian
-	int size = width * height;
-	frm_ = new u_char[2 * size];
+	/* allocated again (by frame()) when there's a frame to decode */
+	framefree(frm_);
+	Decoder::resize(width, height);
+}
+
+void PlaneDecoder::allocate()
+{
+	int size = 2 * inw_ * inh_;
+	frm_ = framealloc(size);
 	/* 
 	 * Initialize image to gray.
 	 */
-	memset(frm_, 0x80, 2 * size);
-	Decoder::resize(width, height);
+	memset(frm_, 0x80, size);
+}
+
+void PlaneDecoder::idle()
+{
+	framefree(frm_);
 }
 
 int PlaneDecoder::colorhist(u_int* histogram) const
 {
+	if (frm_ == 0)
+		return (0);
 	int w = inw_;
 	int h = inh_;
 	int s = w * h;
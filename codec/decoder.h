@@ -44,6 +44,7 @@ extern "C" {
 #include "vic_tcl.h"
 #include "source.h"
 #include "ntp-time.h"
+#include "timer.h"
 
 /*
  * Rendering vector.  We keep a vector of timestamps of when each individual
@@ -55,6 +56,7 @@ extern "C" {
 #define RV_PAST(now, ts) ((((now) - (ts)) & 0x80) == 0)
 
 class Renderer;
+class RenderPlan;
 class Assistor;
 class VideoWindow;
 
@@ -63,7 +65,7 @@ struct dmabuf {
 	u_char* bp;
 };
 
-class Decoder : public PacketHandler {
+class Decoder : public PacketHandler, public Timer {
  protected:
 	Decoder(int hdrlen);
  public:
@@ -89,6 +91,19 @@ class Decoder : public PacketHandler {
 	inline int ndblk() const { return (ndblk_); }
 	inline void resetndblk() { ndblk_ = 0; }
 	void setcolor(int color);
+
+	/*
+	 * Decode on demand.  A decoder no renderer is attached to (its
+	 * window closed or the thumbnail hidden) is dormant and
+	 * reconstructs nothing; attach() wakes it.  H.261 keeps its
+	 * latest packets, and the GOBs it had to drop, to decode them
+	 * at once on waking and ask for a key frame for the rest.
+	 * H.264 and MPEG-4 just start over, holding frames until the
+	 * key frame they ask for; nv and cellb wait for the sender's
+	 * refresh.  "dormant 0" turns this off, for a decoder whose
+	 * frames something else reads.
+	 */
+	inline int dormant() const { return (engines_ == 0 && dormancy_); }
  protected:
 /*XXX*/
 #define MAXSTAT 16
@@ -106,6 +121,23 @@ class Decoder : public PacketHandler {
 	int inw_;		/* native image width */
 	int inh_;		/* native image height */
 
+	/*
+	 * Decoding smaller.  A decoder that can (maxscale_ > 0)
+	 * decodes its frames at 1 / (1 << scale_) of the native size,
+	 * when every window it shows in is that small (as thumbnails
+	 * are): resize() picks scale_ with reduction(), and calls
+	 * rescale() for the decoder to follow it.  Decoders check
+	 * reduction() between frames, as the windows come and go, and
+	 * resize() when it changes.  inw_ and inh_ stay native; the
+	 * frames rendered are inw_ >> scale_ by inh_ >> scale_.
+	 * "reduce 0" turns this off.
+	 */
+	int reduction(int w, int h) const;
+	virtual void rescale();
+	int scale_;
+	int maxscale_;
+	int reduce_;
+
  public:
 	/*
 	 * Add or remove a window to the set of windows
@@ -117,6 +149,7 @@ class Decoder : public PacketHandler {
 	void redraw(const u_char* frm);
 	virtual void redraw() = 0;
 	Renderer* engines_;
+	RenderPlan* plan_;	/* blocks to render, shared by engines_ */
 
 	void render_frame(const u_char* frm);
 	int now_;
@@ -124,6 +157,29 @@ class Decoder : public PacketHandler {
 	int nblk_;		/* number of 8x8 blocks */
 	int ndblk_;	/* number of blocks decoded in most recent frame */
 
+	/*
+	 * The frame buffers, from the FramePool.  A decoder allocates
+	 * them with the first frame it decodes, not when created, and
+	 * gives them back in idle() when it has decoded nothing for
+	 * FRAMEPOOL_IDLE seconds (the source paused or gone quiet),
+	 * to allocate them again with the next frame.  framemem() is
+	 * the bytes held, for the stats.
+	 */
+	u_char* framealloc(int size);
+	void framefree(u_char*& p);
+	/* make p hold at least size bytes (its contents are lost) */
+	void framefit(u_char*& p, int size);
+	virtual void idle();
+	virtual int framemem() const;
+	virtual void timeout();
+	int framemem_;
+	int nframe_;		/* frames since timeout() last looked */
+
+	/* called by attach() on a dormant decoder, before it links r */
+	virtual void wake();
+	int dormancy_;		/* 0 to decode regardless */
+	u_int32_t nskip_;	/* packets not decoded, dormant */
+
 	void colorhist_420_556(u_int* hist, const u_char* y, const u_char* u,
 			       const u_char* v, int width, int height) const;
 	void colorhist_422_556(u_int* hist, const u_char* y, const u_char* u,
@@ -139,6 +195,13 @@ class PlaneDecoder : public Decoder {
  protected:
 	void resize(int width, int height);
 	virtual void redraw();
+	virtual void idle();
+	/* the frame, gray, if there isn't one; before decoding into it */
+	inline void frame() {
+		if (frm_ == 0)
+			allocate();
+	}
+	void allocate();
 
 	u_char* frm_;		/* storage for YUV representation */
 };
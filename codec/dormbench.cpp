@@ -0,0 +1,328 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * dormbench - the cpu time a session of many h.261 sources takes
+ * with every one decoded, and with only the watched ones decoded
+ * and the rest dormant (Decoder::dormant()).
+ *
+ * usage: dormbench [-n sources] [-w watched] [-f frames]
+ *
+ * A synthetic CIF sequence of `frames' (300) frames is coded once
+ * with the h261 module, sending the blocks that changed as the
+ * grabbers do, and its packets replayed to each of `sources' (50)
+ * decoders, as if that many people sent it.  In the first run every
+ * decoder has a renderer attached; in the second only `watched' (5)
+ * of them do.  The cpu time per frame of both is printed, and what
+ * each dormant source saved.  Last, a renderer is attached to one
+ * of the dormant decoders: the time the fast-forward took, and how
+ * many of the picture's blocks then differ from one that was
+ * decoded all along, are printed, and whether it asked for a key
+ * frame for them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "bench.h"
+#include "vic_tcl.h"
+#include "module.h"
+#include "renderer.h"
+#include "decoder.h"
+#include "transmitter.h"
+#include "crdef.h"
+#include "source.h"
+#include "net.h"
+
+/* vw.cpp and the X11 grabber look at these; they live in main.cpp */
+int use_shm = 0;
+int use_ddraw = 0;
+
+#define WIDTH 352
+#define HEIGHT 288
+#define FRAMESIZE (WIDTH * HEIGHT * 3 / 2)
+
+/* the coded sequence: each packet, with its rtp header */
+static u_char** pkt;
+static int* pktlen;
+static int npkt;
+static int maxpkt;
+
+/* keeps a copy of each packet the encoder sends */
+class KeepTransmitter : public Transmitter {
+    public:
+	KeepTransmitter() { loop_layer(0); }
+    protected:
+	void transmit(pktbuf* pb) {
+		if (npkt == maxpkt) {
+			maxpkt = maxpkt != 0 ? 2 * maxpkt : 1024;
+			u_char** p = new u_char*[maxpkt];
+			int* l = new int[maxpkt];
+			memcpy(p, pkt, npkt * sizeof(*p));
+			memcpy(l, pktlen, npkt * sizeof(*l));
+			delete[] pkt;
+			delete[] pktlen;
+			pkt = p;
+			pktlen = l;
+		}
+		pkt[npkt] = new u_char[pb->len];
+		memcpy(pkt[npkt], pb->dp, pb->len);
+		pktlen[npkt++] = pb->len;
+	}
+};
+
+/* a renderer that keeps a copy of the last frame */
+class Copier : public Renderer {
+    public:
+	Copier() : Renderer(FT_YUV_420), nframe_(0) {
+		memset(frame_, 0, sizeof(frame_));
+	}
+	int consume(const VideoFrame* vf) {
+		const YuvFrame* yf = (const YuvFrame*)vf;
+		if (yf->width_ == WIDTH && yf->height_ == HEIGHT)
+			memcpy(frame_, yf->bp_, FRAMESIZE);
+		now_ = vf->ts_;
+		++nframe_;
+		return (0);
+	}
+	u_char frame_[FRAMESIZE];
+	int nframe_;
+};
+
+/* a textured pattern panning right and down, with a still border */
+static void synthesize(u_char* f, int k)
+{
+	int fs = WIDTH * HEIGHT;
+	int cw = WIDTH >> 1;
+	for (int y = 0; y < HEIGHT; ++y) {
+		int edge = y < 32 || y >= HEIGHT - 32;
+		for (int x = 0; x < WIDTH; ++x) {
+			int sx = edge ? x : x - 3 * k;
+			int sy = edge ? y : y - k;
+			f[y * WIDTH + x] = int(128 +
+				64 * sin(sx * 0.05) * cos(sy * 0.07) +
+				32 * sin((sx + 3 * sy) * 0.6));
+		}
+	}
+	for (int y = 0; y < HEIGHT >> 1; ++y) {
+		for (int x = 0; x < cw; ++x) {
+			f[fs + y * cw + x] = 128 + ((x + y - k) & 63) - 32;
+			f[fs + (fs >> 2) + y * cw + x] =
+				128 + ((x - y + k) & 31) - 16;
+		}
+	}
+}
+
+/*
+ * The blocks to send: those that changed since the last frame, and
+ * a couple of the rest as background fill, as the grabbers do.
+ */
+static void replenish(u_char* crv, const u_char* cur, const u_char* ref,
+		      int& rover)
+{
+	int bw = WIDTH >> 4;
+	int nblk = bw * (HEIGHT >> 4);
+	for (int i = 0; i < nblk; ++i) {
+		int off = (i / bw << 4) * WIDTH + (i % bw << 4);
+		int d = 0;
+		for (int r = 0; r < 16; r += 4)
+			for (int x = 0; x < 16; ++x)
+				d += abs(cur[off + r * WIDTH + x] -
+					 ref[off + r * WIDTH + x]);
+		crv[i] = d >= 48 ? CR_SEND|CR_MOTION : CR_IDLE;
+	}
+	for (int n = 2; n > 0; --n) {
+		crv[rover] = CR_SEND|CR_BG;
+		if (++rover >= nblk)
+			rover = 0;
+	}
+}
+
+static void encode(int nframe)
+{
+	Tcl& tcl = Tcl::instance();
+	Module* m = (Module*)Matcher::lookup("module", "h261");
+	if (m == 0) {
+		fprintf(stderr, "dormbench: h261 not built in\n");
+		exit(1);
+	}
+	KeepTransmitter* tx = new KeepTransmitter;
+	tcl.evalf("%s transmitter %s", m->name(), tx->name());
+	int nblk = (WIDTH >> 4) * (HEIGHT >> 4);
+	u_char* f[2];
+	f[0] = new u_char[FRAMESIZE];
+	f[1] = new u_char[FRAMESIZE];
+	u_char* crv = new u_char[nblk];
+	int rover = 0;
+	for (int k = 0; k < nframe; ++k) {
+		u_char* cur = f[k & 1];
+		synthesize(cur, k);
+		if (k == 0)
+			memset(crv, CR_SEND|CR_MOTION, nblk);
+		else
+			replenish(crv, cur, f[~k & 1], rover);
+		YuvFrame yf(k * 3000, cur, crv, WIDTH, HEIGHT);
+		m->consume(&yf);
+		tx->flush();
+	}
+	delete m;
+	delete[] f[0];
+	delete[] f[1];
+	delete[] crv;
+}
+
+/* replay the sequence to every decoder; the cpu ms per frame */
+static double replay(Decoder** d, int n, int nframe)
+{
+	BufferPool* pool = new BufferPool;
+	double c0 = bench_cputime();
+	for (int i = 0; i < npkt; ++i) {
+		for (int k = 0; k < n; ++k) {
+			pktbuf* pb = pool->alloc();
+			memcpy(pb->dp, pkt[i], pktlen[i]);
+			pb->len = pktlen[i];
+			d[k]->recv(pb);
+		}
+	}
+	double c = bench_cputime() - c0;
+	delete pool;
+	return (1e3 * c / nframe);
+}
+
+static Decoder** decoders(int n)
+{
+	Decoder** d = new Decoder*[n];
+	for (int i = 0; i < n; ++i) {
+		d[i] = (Decoder*)Matcher::lookup("decoder", "h261");
+		if (d[i] == 0) {
+			fprintf(stderr, "dormbench: no h261 decoder\n");
+			exit(1);
+		}
+	}
+	return (d);
+}
+
+static const char synopsis[] =
+	"dormbench [-n sources] [-w watched] "
+	"[-f frames]\n";
+
+int main(int argc, char** argv)
+{
+	int n = 50;
+	int watched = 5;
+	int nframe = 300;
+	int op;
+	while ((op = getopt(argc, argv, "n:w:f:")) != -1) {
+		switch (op) {
+		case 'n':
+			n = atoi(optarg);
+			break;
+		case 'w':
+			watched = atoi(optarg);
+			break;
+		case 'f':
+			nframe = atoi(optarg);
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind != argc || n < 2 || watched < 1 || watched >= n ||
+	    nframe < 1)
+		bench_usage(synopsis);
+
+	/* no Tk and none of the ui scripts, as in encbench */
+	Tcl::init("dormbench");
+	TclObject::define();
+	Tcl& tcl = Tcl::instance();
+	tcl.evalc("proc bgerror msg { puts stderr $msg }");
+	tcl.evalc("proc grabber args {}");
+	tcl.evalc("proc register src { $src layer 0 [new SourceLayer] }");
+	Address* local = Address::alloc("127.0.0.1");
+	SourceManager::instance().init(1, *local);
+
+	encode(nframe);
+	int nbyte = 0;
+	for (int i = 0; i < npkt; ++i)
+		nbyte += pktlen[i];
+	printf("%d sources, %d watched; %d frames, %d packets, %d bytes\n",
+	       n, watched, nframe, npkt, nbyte);
+
+	/* every source decoded */
+	Decoder** d = decoders(n);
+	Copier* c = new Copier[n];
+	int i;
+	for (i = 0; i < n; ++i)
+		d[i]->attach(&c[i]);
+	double all = replay(d, n, nframe);
+	for (i = 0; i < n; ++i) {
+		d[i]->detach(&c[i]);
+		delete d[i];
+	}
+
+	/* only the watched ones */
+	d = decoders(n);
+	for (i = 0; i < watched; ++i)
+		d[i]->attach(&c[i]);
+	double some = replay(d, n, nframe);
+
+	printf("%-24s %10s\n", "", "cpu ms/frame");
+	printf("%-24s %10.3f\n", "all decoded", all);
+	printf("%-24s %10.3f\n", "watched decoded", some);
+	printf("%-24s %10.3f\n", "saved per dormant source",
+	       (all - some) / (n - watched));
+
+	/* wake one and compare it with one decoded all along */
+	Decoder* w = d[watched];
+	Copier* wc = &c[watched];
+	wc->nframe_ = 0;
+	double c0 = bench_cputime();
+	w->attach(wc);
+	double t = 1e3 * (bench_cputime() - c0);
+	int nblk = (WIDTH >> 4) * (HEIGHT >> 4);
+	int stale = 0;
+	for (i = 0; i < nblk; ++i) {
+		int off = (i / (WIDTH >> 4) << 4) * WIDTH +
+			(i % (WIDTH >> 4) << 4);
+		for (int y = 0; y < 16; ++y)
+			if (memcmp(wc->frame_ + off + y * WIDTH,
+				   c[0].frame_ + off + y * WIDTH, 16) != 0) {
+				++stale;
+				break;
+			}
+	}
+	printf("wake: %.3f ms, %d of %d blocks differ, %s%s\n", t, stale,
+	       nblk, w->keyreq() ? "key frame asked" : "no key frame asked",
+	       wc->nframe_ == 0 ? " (nothing drawn)" : "");
+	return (0);
+}
@@ -0,0 +1,805 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * encbench - run a YUV sequence through the vic encoders.
+ *
+ * usage: encbench [-e encoders] [-n frames] [-s wxh] [-f 420|422]
+ *		   [-m cr|all] [-q q] [-r fps] [-b kbps] [-p] [-l] [-t]
+ *		   [-j file] [-c encoder/wxh,...] [file]
+ *
+ * The input is a raw planar sequence, frames of the given size
+ * (CIF by default) back to back, as FileGrabber loads it; 4:2:0
+ * unless -f says 422.  Without a file a synthetic moving sequence
+ * is used.  The frames are turned into YuvFrames in the layout
+ * each encoder asks for with "frame-format" and fed to it, one
+ * consume() per frame, with its packets going to a transmitter
+ * that only counts them.  For each encoder the frame rate, the
+ * mean and worst time in consume() (the encode latency), bits and
+ * packets per frame, and C++ heap allocations per frame are
+ * reported; -j also writes them as JSON to the file it names, so
+ * runs can be compared (not to stdout, where some encoders print).
+ *
+ * -e	the encoders to run, as a comma separated list of the names
+ *	given to "new module" (nvdct is nv with use-dct); by default
+ *	every one in the list below that is built in.
+ * -m	cr computes the conditional replenishment vector the way
+ *	the grabbers do (the default); all sends every block.
+ * -q	the quality passed to the encoders' q command.
+ * -r,-b	the frame rate and bit rate given to the encoders that
+ *	use them.
+ * -p	turn on "parallel" in the encoders that have it (bvc, jpeg),
+ *	to code each frame on the worker threads.
+ * -l	turn on the h264 encoder's low latency profile (sliced
+ *	threads, and slices that fit a packet).
+ * -t	run each encoder again with the tracer on, and report the
+ *	frame rate with it off and on, to see what tracing costs.
+ * -c	instead, run the sequence through a simulcast module feeding
+ *	the encoders listed, each at the size given, and then through
+ *	one simulcast module per encoder, as separate vics would.
+ *	The time per frame for each encoder, for scaling, and in all,
+ *	and the cpu time in all are reported for both.  Each
+ *	encoder has to send from an ssrc of its own and have its
+ *	packets looped back to the source for it, or encbench exits
+ *	with 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <new>
+#include <unistd.h>
+
+#include "config.h"
+#include "bench.h"
+#include "vic_tcl.h"
+#include "module.h"
+#include "transmitter.h"
+#include "crdef.h"
+#include "worker.h"
+#include "source.h"
+#include "net.h"
+
+/* vw.cpp and the X11 grabber look at these; they live in main.cpp */
+int use_shm = 0;
+int use_ddraw = 0;
+
+/*
+ * Count the C++ heap allocations.  The buffer pools and the
+ * encoders' own tables come from here; the ffmpeg and x264
+ * encoders allocate with malloc and aren't counted.  The library
+ * operator delete frees with free(), so it is left alone.
+ */
+static unsigned long nalloc;
+
+/* kept out of line, so gcc doesn't pair the malloc with a delete */
+#ifdef __GNUC__
+#define ENCBENCH_NOINLINE __attribute__((noinline))
+#else
+#define ENCBENCH_NOINLINE
+#endif
+
+ENCBENCH_NOINLINE void* operator new(size_t n)
+{
+	++nalloc;
+	void* p = malloc(n != 0 ? n : 1);
+	if (p == 0)
+		throw std::bad_alloc();
+	return (p);
+}
+
+ENCBENCH_NOINLINE void* operator new[](size_t n)
+{
+	return (operator new(n));
+}
+
+/*
+ * A transmitter that counts what it is given, and the ssrcs it
+ * came from.  Loop back is turned off for every layer, so
+ * Transmitter::output releases each packet after transmit(),
+ * except in the simulcast runs, which loop back layer 0 as vic
+ * does with one layer.
+ */
+class NullTransmitter : public Transmitter {
+    public:
+	NullTransmitter() : npkt_(0), nbyte_(0), nframe_(0), nssrc_(0) {
+		loop_layer(0);
+	}
+	void clear() { npkt_ = nbyte_ = nframe_ = nssrc_ = 0; }
+	double npkt_;
+	double nbyte_;
+	int nframe_;		/* packets with the marker bit */
+	int nssrc_;
+	u_int32_t ssrc_[64];
+    protected:
+	void transmit(pktbuf* pb) {
+		++npkt_;
+		nbyte_ += pb->len;
+		rtphdr* rh = (rtphdr*)pb->data;
+		if (ntohs(rh->rh_flags) & RTP_M)
+			++nframe_;
+		int i;
+		for (i = 0; i < nssrc_; ++i)
+			if (ssrc_[i] == rh->rh_ssrc)
+				break;
+		if (i == nssrc_ && nssrc_ < 64)
+			ssrc_[nssrc_++] = rh->rh_ssrc;
+	}
+};
+
+/* what the looped back packets are handed to, in place of a decoder */
+class NullHandler : public PacketHandler {
+    public:
+	NullHandler() : PacketHandler(0) {}
+	void recv(pktbuf* pb) { pb->release(); }
+};
+
+static const char* all_encoders[] = {
+	"h261", "h261as", "h263", "h263+", "jpeg", "nv", "nvdct", "cellb",
+	"bvc", "pvh", "h264", "mpeg4", 0
+};
+
+/* the pvh bit allocation ui-ctrlmenu.tcl sets up */
+static const char* pvh_setup =
+	"foreach {i v} { 0 0 1 1 2 2 3 1 } { %s shmap $i $v }\n"
+	"foreach t {\n"
+	"	{ lum-dct 0 5-1--11- } { lum-dct 1 ---5111- }\n"
+	"	{ lum-dct 2 --51-11- } { lum-sbc 0 ----4--2 }\n"
+	"	{ lum-sbc 1 ----4--2 } { lum-sbc 2 ----4--2 }\n"
+	"	{ chm 0 -5---1-- } { chm 1 ---5-1-- } { chm 2 --5--1-- }\n"
+	"} { eval %s comp $t }";
+
+static int width = 352;
+static int height = 288;
+static int nframe;		/* frames in the sequence */
+static u_char** seq;		/* the sequence, 4:2:0 */
+static u_char** crv;		/* and a crvec for each frame */
+
+/*
+ * Read up to max frames of 4:2:0 (or 4:2:2, which is cut down to
+ * 4:2:0 by dropping every other chroma row) from fp.
+ */
+static void load(FILE* fp, int in422, int max)
+{
+	int fs = width * height;
+	int cs = in422 ? fs >> 1 : fs >> 2;
+	u_char* buf = new u_char[fs + 2 * cs];
+	seq = new u_char*[max];
+	for (nframe = 0; nframe < max; ++nframe) {
+		if (fread(buf, 1, fs + 2 * cs, fp) != size_t(fs + 2 * cs))
+			break;
+		u_char* f = new u_char[fs + (fs >> 1)];
+		memcpy(f, buf, fs);
+		if (!in422)
+			memcpy(f + fs, buf + fs, fs >> 1);
+		else {
+			int cw = width >> 1;
+			u_char* dp = f + fs;
+			for (int p = 0; p < 2; ++p) {
+				const u_char* sp = buf + fs + p * cs;
+				for (int y = 0; y < height; y += 2) {
+					memcpy(dp, sp, cw);
+					dp += cw;
+					sp += 2 * cw;
+				}
+			}
+		}
+		seq[nframe] = f;
+	}
+	delete[] buf;
+}
+
+/* a textured pattern panning right and down, with a still border */
+static void synthesize(int n)
+{
+	int fs = width * height;
+	int cw = width >> 1;
+	seq = new u_char*[n];
+	for (int k = 0; k < n; ++k) {
+		u_char* f = new u_char[fs + (fs >> 1)];
+		for (int y = 0; y < height; ++y) {
+			int edge = y < 32 || y >= height - 32;
+			for (int x = 0; x < width; ++x) {
+				int sx = edge ? x : x - 3 * k;
+				int sy = edge ? y : y - k;
+				f[y * width + x] = int(128 +
+					64 * sin(sx * 0.05) * cos(sy * 0.07) +
+					32 * sin((sx + 3 * sy) * 0.6));
+			}
+		}
+		for (int y = 0; y < height >> 1; ++y) {
+			for (int x = 0; x < cw; ++x) {
+				f[fs + y * cw + x] = 128 + ((x + y - k) & 63) - 32;
+				f[fs + (fs >> 2) + y * cw + x] =
+					128 + ((x - y + k) & 31) - 16;
+			}
+		}
+		seq[k] = f;
+	}
+	nframe = n;
+}
+
+/*
+ * Build the crvec of each frame.  With cr set, this is what
+ * Grabber does: age every block, send a couple of idle ones as
+ * background fill, and mark the blocks (and their neighbors)
+ * whose edges moved by the grabber's threshold since the last
+ * frame.  Otherwise every block is sent every frame.
+ */
+static void replenish(int cr)
+{
+	int bw = width >> 4;
+	int bh = height >> 4;
+	int nblk = bw * bh;
+	crv = new u_char*[nframe];
+	u_char* state = new u_char[nblk];
+	memset(state, CR_SEND|CR_MOTION, nblk);
+	int rover = 0;
+	for (int k = 0; k < nframe; ++k) {
+		crv[k] = new u_char[nblk];
+		if (!cr || k == 0) {
+			memset(crv[k], CR_SEND|CR_MOTION, nblk);
+			continue;
+		}
+		for (int i = 0; i < nblk; ++i) {
+			int s = CR_STATE(state[i]);
+			if (s <= CR_AGETHRESH) {
+				if (s == CR_AGETHRESH)
+					s = CR_IDLE;
+				else if (++s == CR_AGETHRESH)
+					s |= CR_SEND;
+				state[i] = s;
+			} else if (s == CR_BG)
+				state[i] = CR_IDLE;
+		}
+		for (int n = 2, i = 0; n > 0 && i < nblk; ++i) {
+			if (CR_STATE(state[rover]) == CR_IDLE) {
+				state[rover] = CR_SEND|CR_BG;
+				--n;
+			}
+			if (++rover >= nblk)
+				rover = 0;
+		}
+		const u_char* cur = seq[k];
+		const u_char* ref = seq[k - 1];
+		for (int by = 0; by < bh; ++by) {
+			for (int bx = 0; bx < bw; ++bx) {
+				int off = (by << 4) * width + (bx << 4);
+				int left = 0, right = 0, top = 0, bottom = 0;
+				for (int r = 0; r < 16; r += 8) {
+					const u_char* a = cur + off + r * width;
+					const u_char* b = ref + off + r * width;
+					int d = 0;
+					for (int x = 0; x < 16; ++x)
+						d += abs(a[x] - b[x]);
+					left += abs(a[0] - b[0]) +
+						abs(a[1] - b[1]) +
+						abs(a[2] - b[2]) +
+						abs(a[3] - b[3]);
+					right += abs(a[12] - b[12]) +
+						abs(a[13] - b[13]) +
+						abs(a[14] - b[14]) +
+						abs(a[15] - b[15]);
+					if (r == 0)
+						top = d;
+					else
+						bottom = d;
+				}
+				u_char* c = state + by * bw + bx;
+				int center = 0;
+				if (left >= 48 && bx > 0) {
+					c[-1] = CR_MOTION|CR_SEND;
+					center = 1;
+				}
+				if (right >= 48 && bx < bw - 1) {
+					c[1] = CR_MOTION|CR_SEND;
+					center = 1;
+				}
+				if (bottom >= 48 && by < bh - 1) {
+					c[bw] = CR_MOTION|CR_SEND;
+					center = 1;
+				}
+				if (top >= 48 && by > 0) {
+					c[-bw] = CR_MOTION|CR_SEND;
+					center = 1;
+				}
+				if (center)
+					c[0] = CR_MOTION|CR_SEND;
+			}
+		}
+		memcpy(crv[k], state, nblk);
+	}
+	delete[] state;
+}
+
+/* the sequence in the layout fmt asks for, or 0 if there's none */
+static u_char** convert(const char* fmt)
+{
+	int fs = width * height;
+	if (strcmp(fmt, "420") == 0)
+		return (seq);
+	if (strcmp(fmt, "cif") == 0) {
+		if ((width == 352 && height == 288) ||
+		    (width == 176 && height == 144))
+			return (seq);
+		return (0);
+	}
+	if (strcmp(fmt, "422") != 0)
+		return (0);
+	int cw = width >> 1;
+	u_char** out = new u_char*[nframe];
+	for (int k = 0; k < nframe; ++k) {
+		u_char* f = new u_char[2 * fs];
+		memcpy(f, seq[k], fs);
+		for (int p = 0; p < 2; ++p) {
+			const u_char* sp = seq[k] + fs + p * (fs >> 2);
+			u_char* dp = f + fs + p * (fs >> 1);
+			for (int y = 0; y < height; ++y)
+				memcpy(dp + y * cw, sp + (y >> 1) * cw, cw);
+		}
+		out[k] = f;
+	}
+	return (out);
+}
+
+struct Result {
+	const char* name;
+	const char* fmt;
+	const char* why;	/* not run, because */
+	double fps;
+	double lat;		/* mean and worst ms in consume() */
+	double maxlat;
+	double bits;
+	double pkts;
+	double allocs;
+	int frames;		/* marker bits seen */
+	double tfps;		/* fps with the tracer on (-t) */
+};
+
+static int quality = -1;
+static int fps = 30;
+static int kbps = 1000;
+static int parallel;
+static int lowlatency;
+
+static void run(const char* name, NullTransmitter* tx, Result* r)
+{
+	Tcl& tcl = Tcl::instance();
+	memset(r, 0, sizeof(*r));
+	r->name = name;
+	int dct = strcmp(name, "nvdct") == 0;
+	TclObject* o = Matcher::lookup("module", dct ? "nv" : name);
+	if (o == 0) {
+		r->why = "not built in";
+		return;
+	}
+	Module* m = (Module*)o;
+	tcl.evalf("%s frame-format", m->name());
+	r->fmt = strdup(tcl.result());
+	u_char** frames = convert(r->fmt);
+	if (frames == 0) {
+		r->why = "frame size or format not supported";
+		delete m;
+		return;
+	}
+	tcl.evalf("%s transmitter %s", m->name(), tx->name());
+	if (dct)
+		tcl.evalf("%s use-dct 1", m->name());
+	if (strcmp(name, "pvh") == 0)
+		tcl.evalf(pvh_setup, m->name(), m->name());
+	if (quality >= 0)
+		tcl.evalf("catch { %s q %d }", m->name(), quality);
+	tcl.evalf("catch { %s fps %d }", m->name(), fps);
+	tcl.evalf("catch { %s kbps %d }", m->name(), kbps);
+	if (parallel)
+		tcl.evalf("catch { %s parallel 1 }", m->name());
+	if (lowlatency)
+		tcl.evalf("catch { %s lowLatency 1 }", m->name());
+
+	tx->clear();
+	unsigned long a0 = nalloc;
+	double t0 = bench_now();
+	for (int k = 0; k < nframe; ++k) {
+		YuvFrame yf(k * 90000 / fps, frames[k], crv[k], width, height);
+		double t1 = bench_now();
+		m->consume(&yf);
+		t1 = bench_now() - t1;
+		r->lat += t1;
+		if (t1 > r->maxlat)
+			r->maxlat = t1;
+		tx->flush();
+	}
+	double t = bench_now() - t0;
+	r->lat *= 1e3 / nframe;
+	r->maxlat *= 1e3;
+	r->allocs = double(nalloc - a0) / nframe;
+	r->fps = t > 0. ? nframe / t : 0.;
+	r->bits = 8. * tx->nbyte_ / nframe;
+	r->pkts = tx->npkt_ / nframe;
+	r->frames = tx->nframe_;
+
+	delete m;
+	if (frames != seq) {
+		for (int k = 0; k < nframe; ++k)
+			delete[] frames[k];
+		delete[] frames;
+	}
+}
+
+/*
+ * The results as JSON, on fp rather than stdout, where the
+ * h.263 encoders print as they go.
+ */
+static void report_json(FILE* fp, const Result* r, int n, int cr)
+{
+	fprintf(fp, "{\n  \"width\": %d, \"height\": %d, \"frames\": %d,"
+		" \"crvec\": \"%s\",\n  \"encoders\": [", width, height,
+		nframe, cr ? "cr" : "all");
+	for (int i = 0; i < n; ++i, ++r) {
+		fprintf(fp, "%s\n    { \"name\": \"%s\"", i ? "," : "",
+			r->name);
+		if (r->why != 0) {
+			fprintf(fp, ", \"skipped\": \"%s\" }", r->why);
+			continue;
+		}
+		fprintf(fp, ", \"format\": \"%s\", \"fps\": %.1f,"
+			" \"latency_ms\": %.2f, \"max_latency_ms\": %.2f,"
+			" \"bits_per_frame\": %.0f,"
+			" \"packets_per_frame\": %.2f,"
+			" \"allocs_per_frame\": %.2f,"
+			" \"marked_frames\": %d", r->fmt, r->fps, r->lat,
+			r->maxlat, r->bits, r->pkts, r->allocs, r->frames);
+		if (r->tfps > 0.)
+			fprintf(fp, ", \"traced_fps\": %.1f", r->tfps);
+		fprintf(fp, " }");
+	}
+	fprintf(fp, "\n  ]\n}\n");
+}
+
+static void report(const Result* r, int n, int cr)
+{
+	printf("%dx%d, %d frames, crvec %s\n", width, height, nframe,
+	       cr ? "cr" : "all");
+	printf("%-8s %-5s %9s %8s %8s %11s %9s %9s\n", "encoder", "fmt",
+	       "fps", "lat ms", "max ms", "bits/frame", "pkts/frm",
+	       "allocs/f");
+	for (int i = 0; i < n; ++i, ++r) {
+		if (r->why != 0)
+			printf("%-8s (%s)\n", r->name, r->why);
+		else
+			printf("%-8s %-5s %9.1f %8.2f %8.2f %11.0f %9.2f "
+			       "%9.2f\n", r->name, r->fmt, r->fps, r->lat,
+			       r->maxlat, r->bits, r->pkts, r->allocs);
+	}
+	r -= n;
+	int hdr = 0;
+	for (int i = 0; i < n; ++i, ++r) {
+		if (r->tfps <= 0.)
+			continue;
+		if (!hdr++)
+			printf("\n%-8s %9s %9s %9s\n", "tracer", "fps off",
+			       "fps on", "cost");
+		printf("%-8s %9.1f %9.1f %8.1f%%\n", r->name, r->fps,
+		       r->tfps, 100. * (r->fps - r->tfps) / r->fps);
+	}
+}
+
+/*
+ * Run the sequence through one simulcast module feeding chains
+ * first to first + n - 1 of name and size.  The module's stats
+ * go in st, then the wall and cpu time per frame.  The chains
+ * are all on layer 0, as vic puts them with one layer, and what
+ * they send is looped back; returns the number that didn't
+ * reach the network, or didn't come back to a local source of
+ * their own.
+ */
+static int simulcast(char** name, char** size, int first, int n,
+		     NullTransmitter* tx, double* st)
+{
+	Tcl& tcl = Tcl::instance();
+	Module* s = (Module*)Matcher::lookup("module", "simulcast");
+	Module* m[64];
+	tcl.evalf("%s transmitter %s", s->name(), tx->name());
+	tx->loop_layer(1);
+	for (int i = 0; i < n; ++i) {
+		const char* e = name[first + i];
+		m[i] = (Module*)Matcher::lookup("module", e);
+		if (strcmp(e, "pvh") == 0)
+			tcl.evalf(pvh_setup, m[i]->name(), m[i]->name());
+		if (quality >= 0)
+			tcl.evalf("catch { %s q %d }", m[i]->name(), quality);
+		tcl.evalf("catch { %s fps %d }", m[i]->name(), fps);
+		tcl.evalf("catch { %s kbps %d }", m[i]->name(), kbps);
+		if (parallel)
+			tcl.evalf("catch { %s parallel 1 }", m[i]->name());
+		if (lowlatency)
+			tcl.evalf("catch { %s lowLatency 1 }", m[i]->name());
+		/* h.263 calls into tcl, so it stays on this thread */
+		tcl.evalf("%s add %s %s 0 %d", s->name(), m[i]->name(),
+			  size[first + i], strncmp(e, "h263", 4) != 0);
+	}
+	SourceManager& sm = SourceManager::instance();
+	u_int32_t np[64];
+	for (int i = 0; i < n; ++i) {
+		Source* src = i == 0 ? sm.localsrc() : sm.extra(i - 1);
+		np[i] = src->layer(0).np();
+	}
+	tx->clear();
+	double t0 = bench_now();
+	double c0 = bench_cputime();
+	for (int k = 0; k < nframe; ++k) {
+		YuvFrame yf(k * 90000 / fps, seq[k], crv[k], width, height);
+		s->consume(&yf);
+		tx->flush();
+	}
+	double wall = bench_now() - t0;
+	double cpu = bench_cputime() - c0;
+
+	/* Simulcast-ms x Scale-ms x name-ms x ... */
+	tcl.evalf("%s stats", s->name());
+	const char* r = tcl.result();
+	for (int i = 0; i < n + 2; ++i) {
+		r = strchr(r, ' ');
+		st[i] = atof(r + 1);
+		r = strchr(r + 1, ' ');
+		if (r == 0)
+			break;
+		++r;
+	}
+	st[n + 2] = 1e3 * wall / nframe;
+	st[n + 3] = 1e3 * cpu / nframe;
+
+	int bad = 0;
+	for (int i = 0; i < n; ++i) {
+		Source* src = i == 0 ? sm.localsrc() : sm.extra(i - 1);
+		if (src->layer(0).np() == np[i]) {
+			fprintf(stderr, "encbench: %s: nothing looped back\n",
+				name[first + i]);
+			++bad;
+		}
+	}
+	if (tx->nssrc_ != n) {
+		fprintf(stderr, "encbench: %d encoders sent from %d ssrcs\n",
+			n, tx->nssrc_);
+		++bad;
+	}
+	tx->loop_layer(0);
+	delete s;
+	for (int i = 0; i < n; ++i)
+		delete m[i];
+	return (bad);
+}
+
+static int simulcast(const char* list, NullTransmitter* tx)
+{
+	char* name[64];
+	char* size[64];
+	int n = 0;
+	char* l = strdup(list);
+	for (char* p = strtok(l, ","); p != 0 && n < 64; p = strtok(0, ",")) {
+		char* q = strrchr(p, '/');
+		if (q == 0) {
+			fprintf(stderr, "encbench: %s: no size\n", p);
+			exit(1);
+		}
+		*q = 0;
+		name[n] = p;
+		size[n] = q + 1;
+		TclObject* o = Matcher::lookup("module", p);
+		if (o == 0) {
+			fprintf(stderr, "encbench: %s: not built in\n", p);
+			exit(1);
+		}
+		Tcl& tcl = Tcl::instance();
+		tcl.evalf("%s frame-format", o->name());
+		if (strcmp(tcl.result(), "420") != 0 &&
+		    strcmp(tcl.result(), "cif") != 0) {
+			fprintf(stderr, "encbench: %s: takes %s frames\n", p,
+				tcl.result());
+			exit(1);
+		}
+		delete o;
+		++n;
+	}
+
+	double all[68];
+	int bad = simulcast(name, size, 0, n, tx, all);
+	double sep[64][5];
+	double wall = 0., cpu = 0., scale = 0.;
+	for (int i = 0; i < n; ++i) {
+		bad += simulcast(name, size, i, 1, tx, sep[i]);
+		scale += sep[i][1];
+		wall += sep[i][3];
+		cpu += sep[i][4];
+	}
+
+	printf("%dx%d, %d frames, %d encoders on %d threads\n", width,
+	       height, nframe, n, WorkerPool::instance().nthread());
+	printf("%-20s %12s %12s\n", "ms per frame", "separate", "simulcast");
+	for (int i = 0; i < n; ++i) {
+		char s[64];
+		sprintf(s, "%s/%s", name[i], size[i]);
+		printf("%-20s %12.2f %12.2f\n", s, sep[i][2], all[2 + i]);
+	}
+	printf("%-20s %12.2f %12.2f\n", "scaling", scale, all[1]);
+	printf("%-20s %12.2f %12.2f\n", "wall", wall, all[n + 2]);
+	printf("%-20s %12.2f %12.2f\n", "cpu", cpu, all[n + 3]);
+	printf("%-20s %12s\n", "own ssrc, loop back",
+	       bad == 0 ? "ok" : "FAILED");
+	return (bad);
+}
+
+static const char synopsis[] =
+	"encbench [-e encoders] [-n frames] [-s wxh] "
+	"[-f 420|422] [-m cr|all]\n\t\t[-q q] [-r fps] [-b kbps] "
+	"[-p] [-l] [-t] [-j file]\n\t\t[-c encoder/wxh,...] [file]\n";
+
+int main(int argc, char** argv)
+{
+	const char* list = 0;
+	const char* chains = 0;
+	int maxframe = 100;
+	int in422 = 0;
+	int cr = 1;
+	FILE* json = 0;
+	int trace = 0;
+	int op;
+	while ((op = getopt(argc, argv, "e:n:s:f:m:q:r:b:pltj:c:")) != -1) {
+		switch (op) {
+		case 'e':
+			list = optarg;
+			break;
+		case 'n':
+			maxframe = atoi(optarg);
+			break;
+		case 's':
+			if (!bench_size(optarg, &width, &height))
+				bench_usage(synopsis);
+			break;
+		case 'f':
+			if (strcmp(optarg, "422") == 0)
+				in422 = 1;
+			else if (strcmp(optarg, "420") != 0)
+				bench_usage(synopsis);
+			break;
+		case 'm':
+			if (strcmp(optarg, "all") == 0)
+				cr = 0;
+			else if (strcmp(optarg, "cr") != 0)
+				bench_usage(synopsis);
+			break;
+		case 'q':
+			quality = atoi(optarg);
+			break;
+		case 'r':
+			fps = atoi(optarg);
+			break;
+		case 'b':
+			kbps = atoi(optarg);
+			break;
+		case 'p':
+			parallel = 1;
+			break;
+		case 'l':
+			lowlatency = 1;
+			break;
+		case 't':
+			trace = 1;
+			break;
+		case 'j':
+			json = fopen(optarg, "w");
+			if (json == 0) {
+				perror(optarg);
+				exit(1);
+			}
+			break;
+		case 'c':
+			chains = optarg;
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind < argc - 1 || maxframe <= 0 || fps <= 0 || kbps <= 0 ||
+	    width <= 0 || (width & 15) != 0 || height <= 0 || (height & 15) != 0)
+		bench_usage(synopsis);
+
+	if (optind < argc) {
+		FILE* fp = fopen(argv[optind], "rb");
+		if (fp == 0) {
+			perror(argv[optind]);
+			exit(1);
+		}
+		load(fp, in422, maxframe);
+		fclose(fp);
+		if (nframe == 0) {
+			fprintf(stderr, "encbench: %s: no whole frame\n",
+				argv[optind]);
+			exit(1);
+		}
+	} else
+		synthesize(maxframe);
+	replenish(cr);
+
+	/*
+	 * No Tk and none of the ui scripts; just the commands the
+	 * encoders use, and the h.263 encoder's rate sliders.
+	 */
+	Tcl::init("encbench");
+	TclObject::define();
+	Tcl& tcl = Tcl::instance();
+	tcl.evalc("proc bgerror msg { puts stderr $msg }");
+	tcl.evalc("proc grabber args {}");
+	tcl.evalf("proc encbench_fps args { return %d }", fps);
+	tcl.evalf("proc encbench_bps args { return %d }", kbps);
+	tcl.evalc("set fps_slider encbench_fps; set bps_slider encbench_bps");
+	/* the packets carry the local source's ssrc */
+	tcl.evalc("proc register src { $src layer 0 [new SourceLayer] }");
+	NullHandler* nh = new NullHandler;
+	tcl.evalf("proc activate src { $src handler %s }", nh->name());
+	tcl.evalc("foreach p { set_busy deactivate unregister } "
+		  "{ proc $p args {} }");
+	Address* local = Address::alloc("127.0.0.1");
+	SourceManager::instance().init(1, *local);
+
+	NullTransmitter* tx = new NullTransmitter;
+	if (chains != 0)
+		return (simulcast(chains, tx) != 0);
+
+	const char* names[64];
+	int n = 0;
+	if (list == 0) {
+		for (; all_encoders[n] != 0; ++n)
+			names[n] = all_encoders[n];
+	} else {
+		char* s = strdup(list);
+		for (char* p = strtok(s, ","); p != 0 && n < 64;
+		     p = strtok(0, ","))
+			names[n++] = p;
+	}
+
+	Result* r = new Result[n];
+	for (int i = 0; i < n; ++i) {
+		run(names[i], tx, &r[i]);
+		if (trace && r[i].why == 0) {
+			Result t;
+			tcl.evalc("tracer enable 1");
+			run(names[i], tx, &t);
+			tcl.evalc("tracer enable 0; tracer clear");
+			r[i].tfps = t.fps;
+		}
+	}
+	report(r, n, cr);
+	if (json != 0) {
+		report_json(json, r, n, cr);
+		fclose(json);
+	}
+	return (0);
+}
@@ -13,28 +13,59 @@
 #include "pktbuf-rtp.h"
 #include "module.h"
 #include "transmitter.h"
+#include "trace.h"
+#include "worker.h"
+#include "bvc-block.h"
 
 #define HDRSIZE (sizeof(rtphdr) + sizeof(bvchdr))
+/* the most a block can take */
+#define MAXMBSIZE (16*16+2*8*8+4)
 
-class BvcEncoder : public TransmitterModule {
+/*
+ * The payload of one packet, coded ahead into a band's buffer.
+ */
+struct BvcChunk {
+	int off;	/* offset in the buffer */
+	int cc;		/* length in bytes */
+	int blkno;	/* the last block before it, for the header */
+};
+
+class BvcEncoder;
+
+/*
+ * The coder for a band of block rows.  Blocks only depend on the
+ * frame, not on each other, so a band is coded on its own into a
+ * buffer, cut into packet payloads as it goes, and the encoder
+ * sends them once all the bands are done.  Serially there's one
+ * band covering the frame; with "parallel" on, there's one per
+ * worker thread and they're coded at the same time.
+ */
+class BvcBand : public WorkerTask {
  public:
-	BvcEncoder();
-	~BvcEncoder();
-	virtual int consume(const VideoFrame*);
-	virtual int command(int argc, const char*const* argv);
+	BvcBand();
+	~BvcBand();
+	virtual void run();
+	void code();
+
+	BvcEncoder* encoder_;
+	WorkerLatch* latch_;
+	int y0_;		/* first block row */
+	int y1_;		/* and one past the last */
+
+	u_char* buf_;
+	BvcChunk* chunk_;
+	int nchunk_;
  protected:
-	void size(int w, int h);
-	pktbuf* getpkt(u_int32_t ts, int layer);
-	int flush(pktbuf* pb, int sync);
-	void quantizer(int n, int q);
+	void reserve(int nblk);
+	void newchunk();
+	void endchunk();
 	void encode_sbc(const u_char* blk);
-	void encode_block(const u_char* blk);
-	void encode_color(const u_char* blk);
-	void decompose_block(const u_char* in, int8_t* out);
+	void encode_block(const u_char* blk, int stride);
+	void encode_color(const u_char* blk, int stride);
 	int prune_layers(int active, int cm);
 	void encode_coef(int v, int active);
 
-	u_int32_t quant_;
+	int size_;		/* number of blocks there's room for */
 
 	/* bit buffer */
 	u_int bb_;
@@ -44,8 +75,36 @@ class BvcEncoder : public TransmitterModule {
 
 	u_char* bs_;
 	u_char* es_;
+};
+
+#define BVC_MAXBAND 16
+
+class BvcEncoder : public TransmitterModule {
+ public:
+	BvcEncoder();
+	~BvcEncoder();
+	virtual int consume(const VideoFrame*);
+	virtual int command(int argc, const char*const* argv);
+ protected:
+	friend class BvcBand;
+	void size(int w, int h);
+	pktbuf* getpkt(u_int32_t ts, int layer, int blkno);
+	int flush(pktbuf* pb, int cc, int sync);
+	void quantizer(int n, int q);
 
+	u_int32_t quant_;
 	u_char qs_[64];
+
+	/* the frame being coded, for the bands */
+	const u_char* frm_;
+	const u_int8_t* crvec_;
+	u_int32_t ts_;
+	int len_;		/* payload size */
+
+	int parallel_;
+	int nband_;
+	BvcBand band_[BVC_MAXBAND];
+	WorkerLatch latch_;
 };
 
 static class BvcEncoderMatcher : public Matcher {
@@ -85,9 +144,9 @@ public:
 		bb |= (bits) << (NBIT - (nbb)); \
 }
 
-BvcEncoder::BvcEncoder() : TransmitterModule(FT_YUV_420)
+BvcEncoder::BvcEncoder() : TransmitterModule(FT_YUV_420),
+	frm_(0), crvec_(0), ts_(0), len_(0), parallel_(0), nband_(1)
 {
-	bs_ = es_ = 0;
 	quant_ = 0;
 
 	quantizer(0, 0);
@@ -100,6 +159,11 @@ BvcEncoder::BvcEncoder() : TransmitterModule(FT_YUV_420)
 	quantizer(7, 3);
 	quantizer(8, 4);
 	quantizer(9, 4);
+
+	for (int i = 0; i < BVC_MAXBAND; ++i) {
+		band_[i].encoder_ = this;
+		band_[i].latch_ = &latch_;
+	}
 }
 
 BvcEncoder::~BvcEncoder()
@@ -107,19 +171,8 @@ BvcEncoder::~BvcEncoder()
 }
 
 /*XXX share with h261*/
-int BvcEncoder::flush(pktbuf* pb, int sync)
+int BvcEncoder::flush(pktbuf* pb, int cc, int sync)
 {
-	/* flush bit buffer */
-	STORE_BITS(bs_, bb_);
-
-	//int cc = bs_ - (u_char*)pb->iov[1].iov_base;
-	int cc = bs_ - (u_char*)&pb->data[HDRSIZE];
-	cc += nbb_ >> 3;
-	int nbit = nbb_ & 7;
-	if (nbit != 0)
-		cc += 1;
-	//SV-XXX:unused: int ebit = (8 - nbit) & 7;
-
 	/*XXX*/
 	if (cc == 0 && sync == 0)
 		abort();
@@ -144,9 +197,20 @@ extern void setquant(u_char*, int n, int q);
 
 /*
  * encoder q $n $q
+ * encoder parallel $on
  */
 int BvcEncoder::command(int argc, const char*const* argv)
 {
+	if (argc == 3 && strcmp(argv[1], "parallel") == 0) {
+		/*
+		 * Code the frame in bands on the worker threads.
+		 * The packets come out the same apart from where
+		 * they're cut, since a band always starts a new one.
+		 */
+		parallel_ = atoi(argv[2]) != 0 &&
+			WorkerPool::instance().nthread() > 0;
+		return (TCL_OK);
+	}
 	if (argc == 4) {
 		if (strcmp(argv[1], "q") == 0) {
 			int n = atoi(argv[2]);
@@ -165,258 +229,7 @@ void BvcEncoder::quantizer(int n, int q)
 	setquant(qs_, n, q);
 }
 
-#define CMAX(a,b) ((a) > (b) ? (a) : (b))
-void BvcEncoder::decompose_block(const u_char* in, int8_t* out)
-{
-	int32_t scratch[CMAX(2*8*18/4, 64)];
-	u_int8_t* l = (u_int8_t*)scratch;
-	int8_t* h = (int8_t*)&l[8*18];
-	int stride = width_;
-	in -= 1;
-	for (int w = 18; --w >= 0; ) {
-		int8_t* cl = (int8_t*)(l++);
-		int8_t* ch = h++;
-		const u_char* p = in++;
-		int in0 = p[-stride];
-		int in1 = *p;
-		p += stride;
-		for (int th = 8; --th >= 0; ) {
-			int in2 = *p;
-			p += stride;
-			int in3 = *p;
-			p += stride;
-
-			/* multiply by 3 */
-			int m1 = in1 + (in1 << 1);
-			int m2 = in2 + (in2 << 1);
-
-			/* -1 3 3 -1 */
-			int v = m1 + m2 - in0 - in3;
-			v >>= 2;
-			if (v & ~0xff)
-				v = (v < 0) ? 0 : 255;
-			*cl = v;
-			cl += 18;
-
-			/* 1 -3 3 -1 */
-			v = in0 - m1 + m2 - in3;
-			v >>= 2;
-			if ((v + 127) & ~0xff)
-				v = (v < -128) ? -128 : 127;
-			*ch = v;
-			ch += 18;
-
-			in0 = in2;
-			in1 = in3;
-		}
-	}
-	/* rows */
-	const u_int8_t* p = (u_int8_t*)scratch;
-	l = (u_int8_t*)out;
-	h = out + 2*64;
-	int th;
-	for (th = 8; --th >= 0; ) {
-		int in0 = *p++;
-		int in1 = *p++;
-		for (int w = 8; --w >= 0; ) {
-			int in2 = *p++;
-			int in3 = *p++;
-
-			/* multiply by 3 */
-			int m1 = in1 + (in1 << 1);
-			int m2 = in2 + (in2 << 1);
-
-			/* -1 3 3 -1 */
-			int v = m1 + m2 - in0 - in3;
-			v >>= 2;
-			if (v & ~0xff)
-				v = (v < 0) ? 0 : 255;
-			*l++ = v;
-			/* 1 -3 3 -1 */
-			v = in0 - m1 + m2 - in3;
-			v >>= 2;
-			if ((v + 127) & ~0xff)
-				v = (v < -128) ? -128 : 127;
-			*h++ = v;
-
-			in0 = in2;
-			in1 = in3;
-		}
-	}
-	for (th = 8; --th >= 0; ) {
-		int in0 = *(int8_t*)(p++);
-		int in1 = *(int8_t*)(p++);
-		for (int w = 8; --w >= 0; ) {
-			int in2 = *(int8_t*)(p++);
-			int in3 = *(int8_t*)(p++);
-
-			/* multiply by 3 */
-			int m1 = in1 + (in1 << 1);
-			int m2 = in2 + (in2 << 1);
-
-			/* -1 3 3 -1 */
-			int v = m1 + m2 - in0 - in3;
-			*l++ = v >> 2;
-#ifdef HAVE_HH
-			/* 1 -3 3 -1 */
-			v = in0 - m1 + m2 - in3;
-			*h++ = v >> 2;
-#endif
-
-			in0 = in2;
-			in1 = in3;
-		}
-	}
-
-	/* now apply fully separable Haar tranform remaining 8x8 subimage */
-
-	/* columns */
-	l = (u_int8_t*)out;
-	int32_t* o = scratch;
-	int k;
-	for (k = 8; --k >= 0; ) {
-		/* use fixed point arithmetic with 2 bits of fraction */
-		int t0 = l[0*8];
-		int t1 = l[1*8];
-		int t2 = t0 + t1;
-		o[4*8] = (t1 - t0) << 2;
-
-		t0 = l[2*8];
-		t1 = l[3*8];
-		int t3 = t0 + t1;
-		o[5*8] = (t1 - t0) << 2;
-
-		t0 = l[4*8];
-		t1 = l[5*8];
-		int t4 = t0 + t1;
-		o[6*8] = (t1 - t0) << 2;
-
-		t0 = l[6*8];
-		t1 = l[7*8];
-		int t5 = t0 + t1;
-		o[7*8] = (t1 - t0) << 2;
-
-		t0 = t2 + t3;
-		t1 = t4 + t5;
-		o[0*8]  = t0 + t1;
-		o[1*8]  = t1 - t0;
-		o[2*8] = (t3 - t2) << 1;
-		o[3*8] = (t5 - t4) << 1;
-
-		++o;
-		++l;
-	}
-	/* rows */
-	o = scratch;
-	l = (u_int8_t*)out;
-	for (k = 8; --k >= 0; ) {
-		int t0 = o[0];
-		int t1 = o[1];
-		int t2 = t0 + t1;
-		l[4] = (t1 - t0 + 7) >> 4;
-
-		t0 = o[2];
-		t1 = o[3];
-		int t3 = t0 + t1;
-		l[5] = (t1 - t0 + 7) >> 4;
-
-		t0 = o[4];
-		t1 = o[5];
-		int t4 = t0 + t1;
-		l[6] = (t1 - t0 + 7) >> 4;
-
-		t0 = o[6];
-		t1 = o[7];
-		int t5 = t0 + t1;
-		l[7] = (t1 - t0 + 7) >> 4;
-
-		t0 = t2 + t3;
-		t1 = t4 + t5;
-		l[0] = (t0 + t1 + 31) >> 6;
-		l[1] = (t1 - t0 + 31) >> 6;
-		l[2] = (t3 - t2 + 15) >> 5;
-		l[3] = (t5 - t4 + 15) >> 5;
-
-		l += 8;
-		o += 8;
-	}
-}
-
-void haar_fwd(const u_int8_t* in, u_int8_t* out, int stride)
-{
-	int32_t scratch[64];
-	u_int8_t* l = (u_int8_t*)in;
-	int32_t* o = scratch;
-	/* XXX would be more efficient here to do rows first */
-	int k;
-	for (k = 8; --k >= 0; ) {
-		/* use fixed point arithmetic with 2 bits of fraction */
-		int t0 = l[0];
-		int t1 = l[stride];
-		int t2 = t0 + t1;
-		o[4*8] = (t1 - t0) << 2;
-
-		t0 = l[2*stride];
-		t1 = l[3*stride];
-		int t3 = t0 + t1;
-		o[5*8] = (t1 - t0) << 2;
-
-		t0 = l[4*stride];
-		t1 = l[5*stride];
-		int t4 = t0 + t1;
-		o[6*8] = (t1 - t0) << 2;
-
-		t0 = l[6*stride];
-		t1 = l[7*stride];
-		int t5 = t0 + t1;
-		o[7*8] = (t1 - t0) << 2;
-
-		t0 = t2 + t3;
-		t1 = t4 + t5;
-		o[0*8]  = t0 + t1;
-		o[1*8]  = t1 - t0;
-		o[2*8] = (t3 - t2) << 1;
-		o[3*8] = (t5 - t4) << 1;
-
-		++o;
-		++l;
-	}
-	/* rows */
-	o = scratch;
-	l = (u_int8_t*)out;
-	for (k = 8; --k >= 0; ) {
-		int t0 = o[0];
-		int t1 = o[1];
-		int t2 = t0 + t1;
-		l[4] = (t1 - t0 + 7) >> 4;
-
-		t0 = o[2];
-		t1 = o[3];
-		int t3 = t0 + t1;
-		l[5] = (t1 - t0 + 7) >> 4;
-
-		t0 = o[4];
-		t1 = o[5];
-		int t4 = t0 + t1;
-		l[6] = (t1 - t0 + 7) >> 4;
-
-		t0 = o[6];
-		t1 = o[7];
-		int t5 = t0 + t1;
-		l[7] = (t1 - t0 + 7) >> 4;
-
-		t0 = t2 + t3;
-		t1 = t4 + t5;
-		l[0] = (t0 + t1 + 31) >> 6;
-		l[1] = (t1 - t0 + 31) >> 6;
-		l[2] = (t3 - t2 + 15) >> 5;
-		l[3] = (t5 - t4 + 15) >> 5;
-
-		l += 8;
-		o += 8;
-	}
-}
-
+#ifdef SBC_STAT
 struct { 
 	int zt[4];
 	int sbc[4];
@@ -424,6 +237,7 @@ struct {
 	int dc;
 	int mba;
 } b;
+#endif
 
 u_char child[] = {
 	0, 2, 4, 6, 64, 66, 68, 70,
@@ -555,7 +369,7 @@ void find_children(const u_int8_t* p, u_char* z)
 	z[0] = ll;
 }
 
-void BvcEncoder::encode_coef(int v, int active)
+void BvcBand::encode_coef(int v, int active)
 {
 	int sign = v >> 7;
 	v &= 0x7f;
@@ -573,7 +387,7 @@ void BvcEncoder::encode_coef(int v, int active)
 /*
  * "active" is of form 000...011...1
  */
-int BvcEncoder::prune_layers(int active, int cm)
+int BvcBand::prune_layers(int active, int cm)
 {
 	if (active == 0)
 		abort();
@@ -615,7 +429,7 @@ void find_grandchildren(const u_char* children, u_char* grandchildren)
 	}
 }
 
-void BvcEncoder::encode_sbc(const u_int8_t* p)
+void BvcBand::encode_sbc(const u_int8_t* p)
 {
 #ifdef notyet
 	u_int bb = bb_;
@@ -626,13 +440,15 @@ void BvcEncoder::encode_sbc(const u_int8_t* p)
 	u_char children[64];
 	u_char grandchildren[64];
 	
-        smquant((u_int8_t*)p, qs_);
+	smquant((u_int8_t*)p, encoder_->qs_);
 	find_children(p, children);
 	find_grandchildren(children, grandchildren);
 
 	/*XXX dpcm & entropy */
 	PUT_BITS(p[0], 8, nbb_, bb_, bs_);
+#ifdef SBC_STAT
 	b.dc += 8;
+#endif
 
 	int active = prune_layers(0x7f, children[0]);
 	if (active == 0)
@@ -725,83 +541,130 @@ void BvcEncoder::encode_sbc(const u_int8_t* p)
 
 extern "C" void malloc_verify();
 
-void BvcEncoder::encode_block(const u_char* in)
+void BvcBand::encode_block(const u_char* in, int stride)
 {
 	int8_t out[3*8*8];
-	decompose_block(in, out);
+	bvc_decompose(in, stride, out);
 	encode_sbc((u_int8_t*)out);
 }
 
-void BvcEncoder::encode_color(const u_char* in)
+void BvcBand::encode_color(const u_char* in, int stride)
 {
 	int8_t out[3*8*8];
 
 	memset(&out[64], 0, 128);
-	haar_fwd(in, (u_int8_t*)out, width_ >> 1);
+	bvc_haar_fwd(in, (u_int8_t*)out, stride);
 	encode_sbc((u_int8_t*)out);
 }
 
-pktbuf* BvcEncoder::getpkt(u_int32_t ts, int layer)
+BvcBand::BvcBand() : encoder_(0), latch_(0), y0_(0), y1_(0), buf_(0),
+	chunk_(0), nchunk_(0), size_(0)
 {
-	//Transmitter::pktbuf* pb = tx_->alloc(ts, RTP_PT_BVC);
-	pktbuf* pb = pool_->alloc(ts, RTP_PT_BVC);
-	pb->layer = layer;
-	//rtphdr* rh = (rtphdr*)pb->iov[0].iov_base;
-	rtphdr* rh = (rtphdr*)pb->data;
-	bvchdr* bh = (bvchdr*)(rh + 1);
-	bh->version = 0;
-	bh->pad = 0;
-	bh->width = width_ >> 3;
-	bh->height = height_ >> 3;
-	bh->quant = htonl(quant_);
-	bh->blkno = htons(blkno_);
-	//bs_ = (u_char*)pb->iov[1].iov_base;
-	bs_ = (u_char*)&pb->data[HDRSIZE];
-	es_ = bs_ + tx_->mtu() - HDRSIZE;
+}
+
+BvcBand::~BvcBand()
+{
+	delete[] buf_;
+	delete[] chunk_;
+}
+
+/*
+ * Make room for coding nblk blocks.  Each new packet is started
+ * with room left for a whole block, so the blocks can't take more
+ * than MAXMBSIZE each however they're cut up.
+ */
+void BvcBand::reserve(int nblk)
+{
+	if (nblk <= size_)
+		return;
+	delete[] buf_;
+	delete[] chunk_;
+	size_ = nblk;
+	/* STORE_BITS may write a word past the end */
+	buf_ = new u_char[(nblk + 1) * MAXMBSIZE + 4];
+	chunk_ = new BvcChunk[nblk + 1];
+}
+
+void BvcBand::newchunk()
+{
+	BvcChunk* c = &chunk_[nchunk_++];
+	c->off = bs_ - buf_;
+	c->cc = 0;
+	c->blkno = blkno_;
+	es_ = bs_ + encoder_->len_;
 	bb_ = 0;
 	nbb_ = 0;
-	return (pb);
 }
 
-/*XXX*/
-int BvcEncoder::consume(const VideoFrame* vf)
+void BvcBand::endchunk()
 {
-	if (!samesize(vf))
-		size(vf->width_, vf->height_);
-	YuvFrame* p = (YuvFrame*)vf;
-	tx_->flush();
-	int layer = p->layer_;
+	/* flush bit buffer */
+	STORE_BITS(bs_, bb_);
 
-	u_char* frm = (u_char*)p->bp_;
-	const u_char* chm = frm + framesize_;
-	blkno_ = -1;
-	pktbuf* pb = getpkt(p->ts_, layer);
-	const u_int8_t* crv = p->crvec_;
-	memset(&b, 0, sizeof(b));
+	BvcChunk* c = &chunk_[nchunk_ - 1];
+	int cc = bs_ - (buf_ + c->off);
+	cc += nbb_ >> 3;
+	int nbit = nbb_ & 7;
+	if (nbit != 0)
+		cc += 1;
+	c->cc = cc;
+	bs_ = buf_ + c->off + cc;
+}
 
-#ifdef SBC_STAT
-	if (f[0] == 0) {
-		f[0] = fopen("sbc0", "w");
-		f[1] = fopen("sbc1", "w");
-		f[2] = fopen("sbc2", "w");
-		f[3] = fopen("sbc3", "w");
+/*
+ * Copy the luma block at p, with the row and column around it that
+ * the analysis filters read, into the 18x18 block at pad.  Where
+ * the block is at the edge of the image, the edge pels are repeated
+ * outwards.  For the 1-3-3-1 filter set, we use symmetric extension
+ * at both analysis and synthesis to give perfect reconstruction.
+ */
+static void extend(const u_char* p, int stride, int left, int right,
+		   int top, int bottom, u_char* pad)
+{
+	for (int k = -1; k <= 16; ++k) {
+		const u_char* s = p + k * stride;
+		if (k < 0 && top)
+			s = p;
+		else if (k > 15 && bottom)
+			s = p + 15 * stride;
+		pad[0] = left ? s[0] : s[-1];
+		memcpy(pad + 1, s, 16);
+		pad[17] = right ? s[15] : s[16];
+		pad += 18;
 	}
-#endif
-	int cc = 0;
-	int blkw = width_ >> 4;
-	int blkh = height_ >> 4;
-	int blkno = 0;
-	for (int y = 0; y < blkh; ++y) {
+}
+
+/*
+ * Code block rows [y0_, y1_) of the encoder's current frame.
+ */
+void BvcBand::code()
+{
+	const BvcEncoder* e = encoder_;
+	int width = e->width_;
+	int blkw = width >> 4;
+	int blkh = e->height_ >> 4;
+	int cs = e->framesize_ >> 2;
+	reserve((y1_ - y0_) * blkw);
+
+	const u_char* frm = e->frm_ + y0_ * (width << 4);
+	const u_char* chm = e->frm_ + e->framesize_ + y0_ * (width << 2);
+	const u_int8_t* crv = e->crvec_ + y0_ * blkw;
+	int blkno = y0_ * blkw;
+	blkno_ = blkno - 1;
+	bs_ = buf_;
+	nchunk_ = 0;
+	newchunk();
+
+	for (int y = y0_; y < y1_; ++y) {
 		for (int x = 0; x < blkw; ++blkno, frm += 16, chm += 8,
 		     ++x, ++crv) {
 			int s = crv[0];
 			if ((s & CR_SEND) == 0)
 				continue;
 
-#define MAXMBSIZE (16*16+2*8*8+4)
 			if (bs_ + MAXMBSIZE >= es_) {
-				cc += flush(pb, 0);
-				pb = getpkt(p->ts_, layer);
+				endchunk();
+				newchunk();
 			}
 
 			int dblk = blkno - blkno_;
@@ -811,83 +674,152 @@ int BvcEncoder::consume(const VideoFrame* vf)
 
 			if (dblk == 1) {
 				PUT_BITS(1, 1, nbb_, bb_, bs_);
+#ifdef SBC_STAT
 b.mba += 1;
+#endif
 			} else if (dblk <= 17) {
 				PUT_BITS(0x10 | (dblk - 2), 6, nbb_, bb_, bs_);
+#ifdef SBC_STAT
 b.mba += 6;
+#endif
 			} else {
 				PUT_BITS(dblk, 13, nbb_, bb_, bs_);
+#ifdef SBC_STAT
 b.mba += 13;
+#endif
 			}
 			/*
-			 * Deal with boundaries of image.  This is
-			 * simply ugly, but it's the price we have
-			 * to pay for using a four tap filter stage.
-			 * For the 1-3-3-1 filter set, we use symmetric
-			 * extension at both analysis and synthesis
-			 * to give perfect reconstruction.
-			 * If we're at the top of the image, we simply
-			 * copy the top row up (since the grabber's
-			 * reserve one line of extra space).  Otherwise,
-			 * we save pixels, do the symmetrization,
-			 * encode the block, then restore the pixels.
-			 */
-			u_char ysave[16];
-			u_char xsave[16];
-			if (y == 0)
-				memcpy(frm - width_, frm, 16);
-			else if (y == blkh - 1) {
-				u_char* p = frm + (width_ << 4);
-				memcpy(ysave, p, 16);
-				memcpy(p, p - width_, 16);
-			}
-			if (x == 0) {
-				u_char* s = xsave;
-				u_char* p = frm;
-				for (int k = 0; k < 16; ++k) {
-					*s++ = p[-1];
-					p[-1] = p[0];
-					p += width_;
-				}
-			} else if (x == blkw - 1) {
-				u_char* s = xsave;
-				u_char* p = frm + 16;
-				for (int k = 0; k < 16; ++k) {
-					*s++ = p[0];
-					p[0] = p[-1];
-					p += width_;
-				}
-			}
-			encode_block(frm);
-			encode_color(chm);
-			encode_color(chm + (framesize_ >> 2));
-			/*
-			 * Now restore the pixels.  We don't bother
-			 * with the "y = 0" case because the affected
-			 * memory will not be used.
+			 * The four tap filters read a pel beyond the
+			 * block all round, so at the boundaries of the
+			 * image the block is coded from a copy with
+			 * the edges extended.  The frame itself is
+			 * left alone, since other bands may be reading
+			 * it at the same time.
 			 */
-			if (y == blkh - 1) {
-				u_char* p = frm + (width_ << 4);
-				memcpy(p, ysave, 16);
-			}
-			if (x == 0) {
-				u_char* s = xsave;
-				u_char* p = frm;
-				for (int k = 0; k < 16; ++k) {
-					p[-1] = *s++;
-					p += width_;
-				}
-			} else if (x == blkw - 1) {
-				u_char* s = xsave;
-				u_char* p = frm + 16;
-				for (int k = 0; k < 16; ++k) {
-					p[0] = *s++;
-					p += width_;
-				}
+			int left = (x == 0);
+			int right = (x == blkw - 1);
+			int top = (y == 0);
+			int bottom = (y == blkh - 1);
+			if (left | right | top | bottom) {
+				u_char pad[18 * 18];
+				extend(frm, width, left, right, top, bottom,
+				       pad);
+				encode_block(pad + 18 + 1, 18);
+			} else
+				encode_block(frm, width);
+			encode_color(chm, width >> 1);
+			encode_color(chm + cs, width >> 1);
+		}
+		frm += 15 * width;
+		chm += 7 * (width >> 1);
+	}
+	endchunk();
+}
+
+void BvcBand::run()
+{
+	TRACE_SCOPE_KEY(TRACE_SLICE, encoder_->srcid(), encoder_->ts_);
+	code();
+	latch_->done();
+}
+
+pktbuf* BvcEncoder::getpkt(u_int32_t ts, int layer, int blkno)
+{
+	//Transmitter::pktbuf* pb = tx_->alloc(ts, RTP_PT_BVC);
+	pktbuf* pb = pool_->alloc(ts, RTP_PT_BVC);
+	pb->layer = layer;
+	//rtphdr* rh = (rtphdr*)pb->iov[0].iov_base;
+	rtphdr* rh = (rtphdr*)pb->data;
+	bvchdr* bh = (bvchdr*)(rh + 1);
+	bh->version = 0;
+	bh->pad = 0;
+	bh->width = width_ >> 3;
+	bh->height = height_ >> 3;
+	bh->quant = htonl(quant_);
+	bh->blkno = htons(blkno);
+	return (pb);
+}
+
+/*XXX*/
+int BvcEncoder::consume(const VideoFrame* vf)
+{
+	TRACE_SCOPE_SETKEY(TRACE_ENCODE, srcid(), vf->ts_);
+	if (!samesize(vf))
+		size(vf->width_, vf->height_);
+	YuvFrame* p = (YuvFrame*)vf;
+	tx_->flush();
+	int layer = p->layer_;
+
+	frm_ = p->bp_;
+	crvec_ = p->crvec_;
+	ts_ = p->ts_;
+	len_ = tx_->mtu() - HDRSIZE;
+#ifdef SBC_STAT
+	memset(&b, 0, sizeof(b));
+	if (f[0] == 0) {
+		f[0] = fopen("sbc0", "w");
+		f[1] = fopen("sbc1", "w");
+		f[2] = fopen("sbc2", "w");
+		f[3] = fopen("sbc3", "w");
+	}
+#endif
+	int blkh = height_ >> 4;
+	int n = 1;
+	if (parallel_) {
+		n = WorkerPool::instance().nthread();
+		if (n > BVC_MAXBAND)
+			n = BVC_MAXBAND;
+		if (n > blkh)
+			n = blkh;
+		if (n < 1)
+			n = 1;
+	}
+	for (int i = 0; i < n; ++i) {
+		band_[i].y0_ = i * blkh / n;
+		band_[i].y1_ = (i + 1) * blkh / n;
+	}
+	/*
+	 * Band 0 is coded here while the workers do the rest.
+	 */
+	if (n > 1) {
+		latch_.reset(n - 1);
+		for (int i = 1; i < n; ++i)
+			WorkerPool::instance().submit(&band_[i]);
+	}
+	band_[0].code();
+	if (n > 1)
+		latch_.wait();
+
+	/*
+	 * Send the packets in order.  There's always at least
+	 * one, to carry the marker bit even if nothing changed.
+	 */
+	int lastband = -1;
+	int lastchunk = -1;
+	for (int i = 0; i < n; ++i) {
+		for (int k = 0; k < band_[i].nchunk_; ++k) {
+			if (band_[i].chunk_[k].cc != 0) {
+				lastband = i;
+				lastchunk = k;
 			}
 		}
-		frm += 15 * width_;
-		chm += 7 * (width_ >> 1);
+	}
+	int cc = 0;
+	if (lastband < 0) {
+		pktbuf* pb = getpkt(p->ts_, layer, -1);
+		cc += flush(pb, 0, 1);
+		return (cc);
+	}
+	for (int i = 0; i <= lastband; ++i) {
+		const BvcBand* band = &band_[i];
+		for (int k = 0; k < band->nchunk_; ++k) {
+			const BvcChunk* c = &band->chunk_[k];
+			if (c->cc == 0)
+				continue;
+			pktbuf* pb = getpkt(p->ts_, layer, c->blkno);
+			memcpy(&pb->data[HDRSIZE], band->buf_ + c->off, c->cc);
+			cc += flush(pb, c->cc, i == lastband && k == lastchunk);
+		}
 	}
 #ifdef notdef
 	double t = b.dc + b.mba;
@@ -901,7 +833,6 @@ b.mba += 13;
 		printf("zt%d\t%.3f\n", i, b.zt[i] / t);
 	}
 #endif
-	cc += flush(pb, 1);
 	return (cc);
 }
 
@@ -32,6 +32,7 @@ static const char rcsid[] =
 #include "transmitter.h"
 #include "pktbuf.h"
 #include "module.h"
+#include "trace.h"
 
 #define MAXSKIP		32
 
@@ -245,6 +246,7 @@ CellbEncoder::~CellbEncoder()
  */
 int CellbEncoder::consume(const VideoFrame* vf)
 {
+	TRACE_SCOPE_SETKEY(TRACE_ENCODE, srcid(), vf->ts_);
 	if (!samesize(vf))
 		size(vf->width_, vf->height_);
 	YuvFrame* p = (YuvFrame*)vf;
@@ -39,12 +39,13 @@ static const char rcsid[] =
 #include "rtp.h"
 #include "dct.h"
 #include "p64/p64-huff.h"
-#include "bsd-endian.h"
+#include "bitio.h"
 #include "vic_tcl.h"
 #include "crdef.h"
 #include "transmitter.h"
 #include "pktbuf-rtp.h"
 #include "module.h"
+#include "trace.h"
 
 #define HDRSIZE (sizeof(rtphdr) + 4)
 #define	CIF_WIDTH	352
@@ -54,62 +55,6 @@ static const char rcsid[] =
 #define	BMB		6	/* # blocks in a MB */
 #define MBPERGOB	33	/* # of Macroblocks per GOB */
 
-#ifdef INT_64
-#define NBIT 64
-#define BB_INT INT_64
-#else
-#define NBIT 32
-#define BB_INT u_int
-#endif
-
-#if BYTE_ORDER == LITTLE_ENDIAN
-#if NBIT == 64
-#define STORE_BITS(bb, bc) \
-	bc[0] = bb >> 56; \
-	bc[1] = bb >> 48; \
-	bc[2] = bb >> 40; \
-	bc[3] = bb >> 32; \
-	bc[4] = bb >> 24; \
-	bc[5] = bb >> 16; \
-	bc[6] = bb >> 8; \
-	bc[7] = bb;
-#define LOAD_BITS(bc) \
-	((BB_INT)bc[0] << 56 | \
-	 (BB_INT)bc[1] << 48 | \
-	 (BB_INT)bc[2] << 40 | \
-	 (BB_INT)bc[3] << 32 | \
-	 (BB_INT)bc[4] << 24 | \
-	 (BB_INT)bc[5] << 16 | \
-	 (BB_INT)bc[6] << 8 | \
-	 (BB_INT)bc[7])
-#else
-#define STORE_BITS(bb, bc) \
-	bc[0] = bb >> 24; \
-	bc[1] = bb >> 16; \
-	bc[2] = bb >> 8; \
-	bc[3] = bb;
-#define LOAD_BITS(bc) (ntohl(*(BB_INT*)(bc)))
-#endif
-#else
-#define STORE_BITS(bb, bc) *(BB_INT*)bc = (bb);
-#define LOAD_BITS(bc) (*(BB_INT*)(bc))
-#endif
-
-#define PUT_BITS(bits, n, nbb, bb, bc) \
-{ \
-	nbb += (n); \
-	if (nbb > NBIT)  { \
-		u_int extra = (nbb) - NBIT; \
-		bb |= (BB_INT)(bits) >> extra; \
-		STORE_BITS(bb, bc) \
-		bc += sizeof(BB_INT); \
-		bb = (BB_INT)(bits) << (NBIT - extra); \
-		nbb = extra; \
-	} else \
-		bb |= (BB_INT)(bits) << (NBIT - (nbb)); \
-}
-
-
 class H261Encoder : public TransmitterModule {
     public:
 	void setq(int q);
@@ -128,7 +73,7 @@ class H261Encoder : public TransmitterModule {
 		       u_int loff, u_int coff, int how) = 0;
 
 	/* bit buffer */
-	BB_INT bb_;
+	bitbuf bb_;
 	u_int nbb_;
 
 	u_char* bs_;
@@ -446,7 +391,7 @@ H261Encoder::make_level_map(int q, u_int fthresh)
 void
 H261Encoder::encode_blk(const short* blk, const char* lm)
 {
-	BB_INT bb = bb_;
+	bitbuf bb = bb_;
 	u_int nbb = nbb_;
 	u_char* bc = bc_;
 
@@ -464,7 +409,7 @@ H261Encoder::encode_blk(const short* blk, const char* lm)
 		/* per Table 6/H.261 */
 		dc = 255;
 	/* Code DC */
-	PUT_BITS(dc, 8, nbb, bb, bc);
+	BITS_PUT(dc, 8, nbb, bb, bc);
 	int run = 0;
 	const u_char* colzag = &COLZAG[0];
 	for (int zag; (zag = *++colzag) != 0; ) {
@@ -483,13 +428,13 @@ H261Encoder::encode_blk(const short* blk, const char* lm)
 				val = (1 << 14) | (run << 8) | (level & 0xff);
 				nb = 20;
 			}
-			PUT_BITS(val, nb, nbb, bb, bc);
+			BITS_PUT(val, nb, nbb, bb, bc);
 			run = 0;
 		} else
 			++run;
 	}
 	/* EOB */
-	PUT_BITS(2, 2, nbb, bb, bc);
+	BITS_PUT(2, 2, nbb, bb, bc);
 
 	bb_ = bb;
 	nbb_ = nbb;
@@ -580,15 +525,15 @@ H261PixelEncoder::encode_mb(u_int mba, const u_char* frm,
 	mba_ = mba;
 	huffent* he = &hte_mba[m - 1];
 	/* MBA */
-	PUT_BITS(he->val, he->nb, nbb_, bb_, bc_);
+	BITS_PUT(he->val, he->nb, nbb_, bb_, bc_);
 	if (q != mquant_) {
 		/* MTYPE = INTRA + TC + MQUANT */
-		PUT_BITS(1, 7, nbb_, bb_, bc_);
-		PUT_BITS(q, 5, nbb_, bb_, bc_);
+		BITS_PUT(1, 7, nbb_, bb_, bc_);
+		BITS_PUT(q, 5, nbb_, bb_, bc_);
 		mquant_ = q;
 	} else {
 		/* MTYPE = INTRA + TC (no quantizer) */
-		PUT_BITS(1, 4, nbb_, bb_, bc_);
+		BITS_PUT(1, 4, nbb_, bb_, bc_);
 	}
 
 	/* luminance */
@@ -671,15 +616,15 @@ H261DCTEncoder::encode_mb(u_int mba, const u_char* frm,
 	mba_ = mba;
 	huffent* he = &hte_mba[m - 1];
 	/* MBA */
-	PUT_BITS(he->val, he->nb, nbb_, bb_, bc_);
+	BITS_PUT(he->val, he->nb, nbb_, bb_, bc_);
 	if (q != mquant_) {
 		/* MTYPE = INTRA + TC + MQUANT */
-		PUT_BITS(1, 7, nbb_, bb_, bc_);
-		PUT_BITS(q, 5, nbb_, bb_, bc_);
+		BITS_PUT(1, 7, nbb_, bb_, bc_);
+		BITS_PUT(q, 5, nbb_, bb_, bc_);
 		mquant_ = q;
 	} else {
 		/* MTYPE = INTRA + TC (no quantizer) */
-		PUT_BITS(1, 4, nbb_, bb_, bc_);
+		BITS_PUT(1, 4, nbb_, bb_, bc_);
 	}
 
 	/* luminance */
@@ -707,7 +652,7 @@ int
 H261Encoder::flush(pktbuf* pb, int nbit, pktbuf* npb)
 {
 	/* flush bit buffer */
-	STORE_BITS(bb_, bc_);
+	bits_store64(bc_, bb_);
 
 	int cc = (nbit + 7) >> 3;
 	int ebit = (cc << 3) - nbit;
@@ -734,7 +679,7 @@ H261Encoder::flush(pktbuf* pb, int nbit, pktbuf* npb)
 		bs_ = nbs;
 		sbit_ = nbit & 7;
 		tbit -= nbit &~ 7;
-		bc = tbit &~ (NBIT - 1);
+		bc = tbit &~ (BITS_NBIT - 1);
 		nbb_ = tbit - bc;
 		bc_ = bs_ + (bc >> 3);
 		/*
@@ -743,8 +688,8 @@ H261Encoder::flush(pktbuf* pb, int nbit, pktbuf* npb)
 		 * or'd into the buffer.
 		 */
 		if (nbb_ > 0) {
-			u_int n = NBIT - nbb_;
-			bb_ = (LOAD_BITS(bc_) >> n) << n;
+			u_int n = BITS_NBIT - nbb_;
+			bb_ = (bits_load64(bc_) >> n) << n;
 		} else
 			bb_ = 0;
 	}
@@ -755,6 +700,7 @@ H261Encoder::flush(pktbuf* pb, int nbit, pktbuf* npb)
 
 int H261DCTEncoder::consume(const VideoFrame *vf)
 {
+	TRACE_SCOPE_SETKEY(TRACE_ENCODE, srcid(), vf->ts_);
 	if (!samesize(vf))
 		size(vf->width_, vf->height_);
 
@@ -765,6 +711,7 @@ int H261DCTEncoder::consume(const VideoFrame *vf)
 
 int H261PixelEncoder::consume(const VideoFrame *vf)
 {
+	TRACE_SCOPE_SETKEY(TRACE_ENCODE, srcid(), vf->ts_);
 	if (!samesize(vf))
 		size(vf->width_, vf->height_);
 
@@ -788,16 +735,16 @@ H261Encoder::encode(const VideoFrame* vf, const u_int8_t *crvec)
 	*(u_int*)(rh + 1) = 1 << 25 | lq_ << 10;
 
 	/* PSC */
-	PUT_BITS(0x0001, 16, nbb_, bb_, bc_);
+	BITS_PUT(0x0001, 16, nbb_, bb_, bc_);
 	/* GOB 0 -> picture header */
-	PUT_BITS(0, 4, nbb_, bb_, bc_);
+	BITS_PUT(0, 4, nbb_, bb_, bc_);
 	/* TR (XXX should do this right) */
-	PUT_BITS(0, 5, nbb_, bb_, bc_);
+	BITS_PUT(0, 5, nbb_, bb_, bc_);
 	/* PTYPE = CIF */
 	int pt = cif_ ? 4 : 0;
-	PUT_BITS(pt, 6, nbb_, bb_, bc_);
+	BITS_PUT(pt, 6, nbb_, bb_, bc_);
 	/* PEI */
-	PUT_BITS(0, 1, nbb_, bb_, bc_);
+	BITS_PUT(0, 1, nbb_, bb_, bc_);
 
 	int step = cif_ ? 1 : 2;
 	int cc = 0;
@@ -810,10 +757,10 @@ H261Encoder::encode(const VideoFrame* vf, const u_int8_t *crvec)
 		u_int nbit = ((bc_ - bs_) << 3) + nbb_;
 
 		/* GSC/GN */
-		PUT_BITS(0x10 | (gob + 1), 20, nbb_, bb_, bc_);
+		BITS_PUT(0x10 | (gob + 1), 20, nbb_, bb_, bc_);
 		/* GQUANT/GEI */
 		mquant_ = lq_;
-		PUT_BITS(mquant_ << 1, 6, nbb_, bb_, bc_);
+		BITS_PUT(mquant_ << 1, 6, nbb_, bb_, bc_);
 
 		mba_ = 0;
 		int line = 11;
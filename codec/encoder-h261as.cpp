@@ -14,6 +14,7 @@
 #include "transmitter.h"
 #include "pktbuf-rtp.h"
 #include "module.h"
+#include "trace.h"
 
 #define HDRSIZE (sizeof(rtphdr) + 4)
 #define DEFAULT_THRESHOLD 48
@@ -553,6 +554,7 @@ H261ASEncoder::flush(pktbuf* pb, int nbit, pktbuf* npb)
 
 int H261ASEncoder::consume(const VideoFrame *vf)
 {
+	TRACE_SCOPE_SETKEY(TRACE_ENCODE, srcid(), vf->ts_);
 	if (!samesize(vf))
 		size(vf->width_, vf->height_);
 
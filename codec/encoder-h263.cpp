@@ -57,6 +57,7 @@ static const char rcsid[] =
 #include "pktbuf-rtp.h"
 #include "module.h"
 #include "crdef.h"
+#include "trace.h"
 
 #include "h263/bitOut.h"
 #include "h263/h263.h"
@@ -150,6 +151,21 @@ H263Encoder::command(int argc,const char* const *argv)
 			q_ = atoi(argv[2]);
 			return 0;
 		}
+		/* integer-pel motion search: full (reference), base, epzs */
+		if (!strcasecmp(argv[1],"me")) {
+			if (!strcasecmp(argv[2],"full"))
+				motionSearch = ME_FULL;
+			else if (!strcasecmp(argv[2],"base"))
+				motionSearch = ME_BASE;
+			else if (!strcasecmp(argv[2],"epzs"))
+				motionSearch = ME_EPZS;
+			else {
+				Tcl::instance().resultf("bad motion search %s",
+							argv[2]);
+				return TCL_ERROR;
+			}
+			return 0;
+		}
 	}
 	return TransmitterModule::command(argc,argv);
 }
@@ -165,6 +181,7 @@ H263Encoder::command(int argc,const char* const *argv)
 */
 int H263Encoder::consume(const VideoFrame* vf)
 {
+	TRACE_SCOPE_SETKEY(TRACE_ENCODE, srcid(), vf->ts_);
 	YuvFrame*	yuv = (YuvFrame*)vf;	/* real YUV Frame */
 	Picture		thispic;		/* current image */
 	u_int		xfps,kbps;		/* parameter from Tcl */
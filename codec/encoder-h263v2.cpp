@@ -50,6 +50,7 @@ static const char rcsid[] =
 #include "module.h"
 
 #include "h263coder.h"
+#include "trace.h"
 
 #define HDRSIZE (sizeof(rtphdr) + 4)
 #define	CIF_WIDTH	352
@@ -176,6 +177,7 @@ dump_paket(const unsigned char *data, int len)
 
 int H263plusEncoder::consume(const VideoFrame *vf)
 {
+    TRACE_SCOPE_SETKEY(TRACE_ENCODE, srcid(), vf->ts_);
     pktbuf* pb;
     rtphdr* rh;
     int n,ps,send_psize = tx_->mtu() - 14;      /* 12 RTP + 2 Payload */
@@ -17,16 +17,12 @@
 #include "databuffer.h"
 #include "x264encoder.h"
 #include "deinterlace.h"
+#include "trace.h"
 /*extern "C"
 {
 #include "base64.h"
 }*/
 
-static Transmitter *tx;
-static RTP_BufferPool *pool;
-static u_int32_t ts;
-static unsigned char frame_seq;
-
 class H264Encoder:public TransmitterModule
 {
   public:
@@ -48,8 +44,10 @@ class H264Encoder:public TransmitterModule
     DataBuffer *fOut;
     Deinterlace deinterlacer;
     bool use_deinterlacer;
+    bool low_latency;
 
     FILE *fptr;
+    unsigned char frame_seq;
 };
 
 static class H264EncoderMatcher:public Matcher
@@ -79,6 +77,7 @@ H264Encoder::H264Encoder():TransmitterModule(FT_YUV_420)
     gop = 20;
     fOut=NULL;
     use_deinterlacer=false; 
+    low_latency=false;
 }
 
 H264Encoder::~H264Encoder()
@@ -96,6 +95,12 @@ void H264Encoder::size(int w, int h)
 
 int H264Encoder::command(int argc, const char *const *argv)
 {
+    if (argc == 2) {
+	if (strcmp(argv[1], "keyframe") == 0) {
+	    enc->requestKeyFrame();
+	    return (TCL_OK);
+	}
+    }
     if (argc == 3) {
 	if (strcmp(argv[1], "q") == 0) {
 	    gop = atoi(argv[2]);
@@ -111,12 +116,19 @@ int H264Encoder::command(int argc, const char *const *argv)
 	    if (kbps < 64)
 		kbps = 64;
 	    //std::cout << "H264: kbps " << kbps << "\n";
+	    if (state)
+		enc->setBitRate(kbps);
 	    return (TCL_OK);
 	}
 	else if (strcmp(argv[1], "useDeinterlacer") == 0) {
 	    use_deinterlacer = atoi(argv[2]);
 	    return (TCL_OK);
 	}
+	else if (strcmp(argv[1], "lowLatency") == 0) {
+	    // takes effect when the encoder is opened, on the first frame
+	    low_latency = atoi(argv[2]);
+	    return (TCL_OK);
+	}
 	else if (strcmp(argv[1], "hq") == 0) {
 	    int enable_hq = atoi(argv[2]);
 	    return (TCL_OK);
@@ -128,11 +140,12 @@ int H264Encoder::command(int argc, const char *const *argv)
 
 int H264Encoder::consume(const VideoFrame * vf)
 {
+    TRACE_SCOPE_SETKEY(TRACE_ENCODE, srcid(), vf->ts_);
     pktbuf *pb;
     rtphdr *rh;
-    ts = vf->ts_;
-    tx = tx_;
-    pool = pool_;
+    /* no statics: simulcast runs several of us at once */
+    Transmitter *tx = tx_;
+    RTP_BufferPool *pool = pool_;
 
     int numNAL, i, sent_size = 0;
     int frame_size = 0;
@@ -151,6 +164,11 @@ int H264Encoder::consume(const VideoFrame * vf)
 	    size(vf->width_, vf->height_);
 	    debug_msg("init x264 encoder with kbps:%d, fps:%d\n", kbps, fps);
 	    enc->setGOP(gop);
+	    // slices that fit a packet whole: the NAL header and payload
+	    // after the RTP header (x264 counts the 4 byte length we don't
+	    // send as well, which leaves room for its estimate to be short)
+	    if (low_latency)
+		enc->setLowLatency(NAL_FRAG_THRESH);
 	    enc->init(vf->width_, vf->height_, kbps, fps);
 	    frame_size = vf->width_ * vf->height_;
     }
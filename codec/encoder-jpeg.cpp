@@ -37,127 +37,114 @@ static const char rcsid[] =
 #include "net.h"
 #include "rtp.h"
 #include "dct.h"
-#include "bsd-endian.h"
+#include "bitio.h"
 #include "vic_tcl.h"
 #include "crdef.h"
 #include "transmitter.h"
 #include "pktbuf-rtp.h"
 #include "module.h"
+#include "trace.h"
+#include "worker.h"
 
 #define HDRSIZE (sizeof(rtphdr) + 8)
+#define RSTSIZE (sizeof(jpegrsthdr))
 
-#ifdef INT_64
-#define NBIT 64
-#define BB_INT INT_64
-#else
-#define NBIT 32
-#define BB_INT u_int
-#endif
-
-#if NBIT == 64
-#define STORE_BITS(bb, bc)						\
-{									\
-    u_char t = bb>>56;							\
-    *bc++ = t;								\
-    if (t == 0xff) *bc++ = 0;						\
-    t = bb>>48;								\
-    *bc++ = t;								\
-    if (t == 0xff) *bc++ = 0;						\
-    t = bb>>40;								\
-    *bc++ = t;								\
-    if (t == 0xff) *bc++ = 0;						\
-    t = bb>>32;								\
-    *bc++ = t;								\
-    if (t == 0xff) *bc++ = 0;						\
-    t = bb>>24;								\
-    *bc++ = t;								\
-    if (t == 0xff) *bc++ = 0;						\
-    t = bb>>16;								\
-    *bc++ = t;								\
-    if (t == 0xff) *bc++ = 0;						\
-    t = bb>>8;								\
-    *bc++ = t;								\
-    if (t == 0xff) *bc++ = 0;						\
-    t = bb;								\
-    *bc++ = t;								\
-    if (t == 0xff) *bc++ = 0;						\
-}
+struct huffentry {
+    u_short val;
+    u_short nb;
+};
 
-#else
-
-#define STORE_BITS(bb, bc)						\
-{									\
-    u_char t = bb>>24;							\
-    *bc++ = t;								\
-    if (t == 0xff) *bc++ = 0;						\
-    t = bb>>16;								\
-    *bc++ = t;								\
-    if (t == 0xff) *bc++ = 0;						\
-    t = bb>>8;								\
-    *bc++ = t;								\
-    if (t == 0xff) *bc++ = 0;						\
-    t = bb;								\
-    *bc++ = t;								\
-    if (t == 0xff) *bc++ = 0;						\
-}
+/*
+ * The entropy coder: the bit buffer and the dc predictors.
+ */
+class JpegCoder {
+  public:
+    JpegCoder();
+    void encode_blk(const short* blk, short* dcpred,
+		    const huffentry* dcht, const huffentry* acht);
+    void encode_mcu(u_int mcu, const u_char* frm, int w, int fs,
+		    const float* lqt, const float* cqt);
+    void restart(int n);
 
-#endif
-
-#define PUT_BITS(bits, n, nbb, bb, bc)					\
-{									\
-    nbb += (n);								\
-    if (nbb > NBIT)  {							\
-		u_int extra = (nbb) - NBIT;					\
-		bb |= (BB_INT)(bits) >> extra;					\
-		STORE_BITS(bb, bc)						\
-		bb = (BB_INT)(bits) << (NBIT - extra);				\
-		nbb = extra;							\
-    } else								\
-		bb |= (BB_INT)(bits) << (NBIT - (nbb));				\
-}
+  protected:
+    static void fdct(const u_char* in, int stride, short* out,
+		     const float* qt);
+
+    /* bit buffer */
+    bitbuf bb_;
+    u_int nbb_;
+    u_char* bc_;
+
+    short lpred_;	// dc predictors
+    short crpred_;
+    short cbpred_;
+};
+
+class JpegEncoder;
+
+/*
+ * A band of MCU rows, when the frame is coded with a restart
+ * marker after each row ("parallel").  A row starts with the dc
+ * predictors at 0 and ends on a byte boundary, so the band's rows
+ * are coded into its buffer on their own, on a worker thread, and
+ * the encoder cuts the frame into packets once all are done.
+ */
+class JpegBand : public WorkerTask, public JpegCoder {
+  public:
+    JpegBand();
+    ~JpegBand();
+    virtual void run();
+    void code();
+
+    JpegEncoder* encoder_;
+    WorkerLatch* latch_;
+    int y0_;		/* first row */
+    int y1_;		/* and one past the last */
+
+    u_char* buf_;
+    int* end_;		/* where each row ends in buf_ */
+  protected:
+    void grow();
+    int size_;
+    int nrow_;
+};
 
-class JpegEncoder : public TransmitterModule {
+#define JPEG_MAXBAND 16
+
+class JpegEncoder : public TransmitterModule, public JpegCoder {
   public:
     JpegEncoder();
     void setq(int q);
     void size(int w, int h);
     int consume(const VideoFrame*);
 
-    struct huffentry {
-	u_short val;
-	u_short nb;
-    };
-
   protected:
+    friend class JpegBand;
     int command(int argc, const char*const* argv);
 
     int flush(pktbuf* pb, int nbit, pktbuf* npb);
     int encode(const VideoFrame*);
-    void encode_blk(const short* blk, short* dcpred,
-		    struct JpegEncoder::huffentry* dcht,
-		    struct JpegEncoder::huffentry* acht);
-    void encode_mcu(u_int mcu, const u_char* frm);
-    void fdct(const u_char* in, int stride, short* out, const float* qt);
-
-    /* bit buffer */
-    BB_INT bb_;
-    u_int nbb_;
+    int encode_rows(const VideoFrame*);
+    const u_char* rowdata(int row, int& len) const;
 
     u_char* bs_;
-    u_char* bc_;
     u_int offset_;
 
     u_char quant_;
     float lqt_[64];
     float cqt_[64];
 
-    short lpred_;	// dc predictors
-    short crpred_;
-    short cbpred_;
-
     u_int nmcu_;
     u_char w_;			/* divided by 8 */
     u_char h_;
+
+    /* the frame being coded, for the bands */
+    const u_char* frm_;
+    u_int32_t ts_;
+
+    int parallel_;
+    JpegBand band_[JPEG_MAXBAND];
+    WorkerLatch latch_;
 };
 
 static class JpegEncoderMatcher : public Matcher {
@@ -190,15 +177,15 @@ static const int stdcqt[] = {
     99, 99, 99, 99, 99, 99, 99, 99,
     99, 99, 99, 99, 99, 99, 99, 99 };
 
-static struct JpegEncoder::huffentry ldht[] = {
+static const huffentry ldht[] = {
     {0x0, 2}, {0x2, 3}, {0x3, 3}, {0x4, 3}, {0x5, 3}, {0x6, 3},
     {0xe, 4}, {0x1e, 5}, {0x3e, 6}, {0x7e, 7}, {0xfe, 8}, {0x1fe, 9}};
 
-static struct JpegEncoder::huffentry cdht[] = {
+static const huffentry cdht[] = {
     {0x0, 2}, {0x1, 2}, {0x2, 2}, {0x6, 3}, {0xe, 4}, {0x1e, 5}, {0x3e, 6},
     {0x7e, 7}, {0xfe, 8}, {0x1fe, 9}, {0x3fe, 10}, {0x7fe, 11}};
 
-static struct JpegEncoder::huffentry laht[] = {
+static const huffentry laht[] = {
     {0x0a, 4}, {0x00, 2}, {0x01, 2}, {0x04, 3}, 
     {0x0b, 4}, {0x1a, 5}, {0x78, 7}, {0xf8, 8}, 
     {0x3f6, 10}, {0xff82, 16}, {0xff83, 16}, {0x00, 0}, 
@@ -264,7 +251,7 @@ static struct JpegEncoder::huffentry laht[] = {
     {0xfffc, 16}, {0xfffd, 16}, {0xfffe, 16}, {0x00, 0}, 
     {0x00, 0}, {0x00, 0}, {0x00, 0}, {0x00, 0} };
 
-static struct JpegEncoder::huffentry caht[] = {
+static const huffentry caht[] = {
     {0x00, 2}, {0x01, 2}, {0x04, 3}, {0x0a, 4}, 
     {0x18, 5}, {0x19, 5}, {0x38, 6}, {0x78, 7}, 
     {0x1f4, 9}, {0x3f6, 10}, {0xff4, 12}, {0x00, 0}, 
@@ -348,11 +335,20 @@ static const char ss[] = {
     8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8,
     8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8 };
 
+JpegCoder::JpegCoder() : bb_(0), nbb_(0), bc_(0),
+    lpred_(0), crpred_(0), cbpred_(0)
+{
+}
+
 JpegEncoder::JpegEncoder() : TransmitterModule(FT_JPEG), 
-    bb_(0), nbb_(0), bs_(0), bc_(0), offset_(0), quant_(0),
-    lpred_(0), crpred_(0), cbpred_(0), nmcu_(0), w_(0), h_(0)
+    bs_(0), offset_(0), quant_(0), nmcu_(0), w_(0), h_(0),
+    frm_(0), ts_(0), parallel_(0)
 {
     setq(30);
+    for (int i = 0; i < JPEG_MAXBAND; ++i) {
+	band_[i].encoder_ = this;
+	band_[i].latch_ = &latch_;
+    }
 }
 
 void
@@ -408,16 +404,27 @@ JpegEncoder::command(int argc, const char*const* argv)
 	setq(atoi(argv[2]));
 	return (TCL_OK);
     }
+    if (argc == 3 && strcmp(argv[1], "parallel") == 0) {
+	/*
+	 * Put a restart marker after each row of MCUs and code
+	 * the rows in bands on the worker threads (in one band
+	 * if there are none; receivers can still resync at the
+	 * markers).
+	 */
+	parallel_ = atoi(argv[2]) != 0;
+	return (TCL_OK);
+    }
     return (TransmitterModule::command(argc, argv));
 }
 
 int
 JpegEncoder::consume(const VideoFrame *vf)
 {
+    TRACE_SCOPE_SETKEY(TRACE_ENCODE, srcid(), vf->ts_);
     if (!samesize(vf))
 	size(vf->width_, vf->height_);
 
-    return(encode(vf));
+    return (parallel_ ? encode_rows(vf) : encode(vf));
 }
 
 int
@@ -426,7 +433,13 @@ JpegEncoder::flush(pktbuf* pb, int nbit, pktbuf* npb)
     u_char* obc = bc_;
 
     /* flush bit buffer */
-    STORE_BITS(bb_, bc_);
+    bc_ = bits_store64_ff(bc_, bb_);
+    if (npb == 0) {
+	/* the 0 stuffed after an ff in the last bits goes too */
+	for (int k = (nbb_ + 7) >> 3; --k >= 0; )
+	    if (u_char(bb_ >> (56 - (k << 3))) == 0xff)
+		nbit += 8;
+    }
 
     int cc = (nbit + 7) >> 3;
 
@@ -456,10 +469,10 @@ JpegEncoder::flush(pktbuf* pb, int nbit, pktbuf* npb)
 #define SSSS(n) (((n)&~0xff) ? (8+ss[(n)>>8]) : ss[n])
 
 void
-JpegEncoder::encode_blk(const short* blk, short* dcpred,
-			struct huffentry* dcht, struct huffentry* acht)
+JpegCoder::encode_blk(const short* blk, short* dcpred,
+		      const huffentry* dcht, const huffentry* acht)
 {
-    BB_INT bb = bb_;
+    bitbuf bb = bb_;
     u_int nbb = nbb_;
     u_char* bc = bc_;
 
@@ -472,13 +485,13 @@ JpegEncoder::encode_blk(const short* blk, short* dcpred,
     if (diff < 0){
 	len = SSSS(-diff);
 	huffentry e = dcht[len];
-	PUT_BITS(e.val, e.nb, nbb, bb, bc);
-	PUT_BITS((diff-1)&(~(-1<<len)), len, nbb, bb, bc);
+	BITS_PUT_FF(e.val, e.nb, nbb, bb, bc);
+	BITS_PUT_FF((diff-1)&(~(-1<<len)), len, nbb, bb, bc);
     } else {
 	len = SSSS(diff);
 	huffentry e = dcht[len];
-	PUT_BITS(e.val, e.nb, nbb, bb, bc);
-	PUT_BITS(diff, len, nbb, bb, bc);
+	BITS_PUT_FF(e.val, e.nb, nbb, bb, bc);
+	BITS_PUT_FF(diff, len, nbb, bb, bc);
     }
 
     /* code ac terms */
@@ -491,22 +504,22 @@ JpegEncoder::encode_blk(const short* blk, short* dcpred,
 		len = SSSS(-level);
 		while (run & ~0xf) {
 		    huffentry e = acht[0xf0];
-		    PUT_BITS(e.val, e.nb, nbb, bb, bc);
+		    BITS_PUT_FF(e.val, e.nb, nbb, bb, bc);
 		    run -= 16;
 		}
 		huffentry e = acht[(run<<4) | len];
-		PUT_BITS(e.val, e.nb, nbb, bb, bc);
-		PUT_BITS((level-1)&(~(-1<<len)), len, nbb, bb, bc);
+		BITS_PUT_FF(e.val, e.nb, nbb, bb, bc);
+		BITS_PUT_FF((level-1)&(~(-1<<len)), len, nbb, bb, bc);
 	    } else {
 		len = SSSS(level);
 		while (run & ~0xf) {
 		    huffentry e = acht[0xf0];
-		    PUT_BITS(e.val, e.nb, nbb, bb, bc);
+		    BITS_PUT_FF(e.val, e.nb, nbb, bb, bc);
 		    run -= 16;
 		}
 		huffentry e = acht[(run<<4) | len];
-		PUT_BITS(e.val, e.nb, nbb, bb, bc);
-		PUT_BITS(level, len, nbb, bb, bc);
+		BITS_PUT_FF(e.val, e.nb, nbb, bb, bc);
+		BITS_PUT_FF(level, len, nbb, bb, bc);
 	    }
 	    run = 0;
 	} else {
@@ -517,7 +530,7 @@ JpegEncoder::encode_blk(const short* blk, short* dcpred,
     if (run > 0) {
 	/* EOB */
 	huffentry e = acht[0];
-	PUT_BITS(e.val, e.nb, nbb, bb, bc);
+	BITS_PUT_FF(e.val, e.nb, nbb, bb, bc);
     }
 
     bb_ = bb;
@@ -525,36 +538,67 @@ JpegEncoder::encode_blk(const short* blk, short* dcpred,
     bc_ = bc;
 }
 
+/*
+ * Code MCU `mcu' of the 4:2:2 frame frm, w/8 blocks wide and with
+ * fs luma pels.
+ */
 void
-JpegEncoder::encode_mcu(u_int mcu, const u_char* frm)
+JpegCoder::encode_mcu(u_int mcu, const u_char* frm, int w, int fs,
+		      const float* lqt, const float* cqt)
 {
     short blk[64];
-    register int stride = w_ << 3;
+    register int stride = w << 3;
 
-    u_char mx = mcu % (w_ >> 1);
-    u_char my = mcu / (w_ >> 1);
+    u_int mx = mcu % (w >> 1);
+    u_int my = mcu / (w >> 1);
 
     /* luminance */
     const u_char* p = &frm[8*stride*my + 16*mx];
-    fdct(p, stride, blk, lqt_);
+    fdct(p, stride, blk, lqt);
     encode_blk(blk, &lpred_, ldht, laht);
 
     p += 8;
-    fdct(p, stride, blk, lqt_);
+    fdct(p, stride, blk, lqt);
     encode_blk(blk, &lpred_, ldht, laht);
 
     /* chrominance */
     stride >>= 1;
-    int fs = framesize_;
     p = &frm[fs + 8*stride*my + 8*mx];
-    fdct(p, stride, blk, cqt_);
+    fdct(p, stride, blk, cqt);
     encode_blk(blk, &crpred_, cdht, caht);
 
     p += (fs>>1);
-    fdct(p, stride, blk, cqt_);
+    fdct(p, stride, blk, cqt);
     encode_blk(blk, &cbpred_, cdht, caht);
 }
 
+/*
+ * End a restart interval: pad it out to a byte with 1s and put
+ * marker RSTn after it, or nothing if n is negative.  The next
+ * interval starts with the dc predictors at 0.
+ */
+void
+JpegCoder::restart(int n)
+{
+    int pad = -nbb_ & 7;
+    if (pad != 0)
+	BITS_PUT_FF((1 << pad) - 1, pad, nbb_, bb_, bc_);
+    for (int s = 56; nbb_ != 0; s -= 8, nbb_ -= 8) {
+	u_char t = u_char(bb_ >> s);
+	*bc_++ = t;
+	if (t == 0xff)
+	    *bc_++ = 0;
+    }
+    bb_ = 0;
+    if (n >= 0) {
+	*bc_++ = 0xff;
+	*bc_++ = 0xd0 + (n & 7);
+    }
+    lpred_ = 0;
+    crpred_ = 0;
+    cbpred_ = 0;
+}
+
 int
 JpegEncoder::encode(const VideoFrame* vf)
 {
@@ -582,7 +626,7 @@ JpegEncoder::encode(const VideoFrame* vf)
 
     u_int8_t* frm = vf->bp_;
     for (u_int mcu = 0; mcu < nmcu_; mcu++) {
-	encode_mcu(mcu, frm);
+	encode_mcu(mcu, frm, w_, framesize_, lqt_, cqt_);
 	u_int cbits = (bc_ - bs_) << 3;
 	if (cbits > ec) {
 	    pktbuf* npb = pool_->alloc(vf->ts_, RTP_PT_JPEG);
@@ -602,6 +646,183 @@ JpegEncoder::encode(const VideoFrame* vf)
     return (cc);
 }
 
+/* where row's restart interval is, and its length */
+const u_char*
+JpegEncoder::rowdata(int row, int& len) const
+{
+    const JpegBand* b = band_;
+    while (row >= b->y1_)
+	++b;
+    int k = row - b->y0_;
+    int off = k > 0 ? b->end_[k - 1] : 0;
+    len = b->end_[k] - off;
+    return (b->buf_ + off);
+}
+
+/*
+ * Code the frame with a restart marker after each row of MCUs, in
+ * bands of rows at once, and send it in chunks of whole rows: as
+ * many as fit in a packet, or one cut across packets if it doesn't
+ * fit on its own (RFC 2435, type 64).
+ */
+int
+JpegEncoder::encode_rows(const VideoFrame* vf)
+{
+    tx_->flush();
+    frm_ = vf->bp_;
+    ts_ = vf->ts_;
+
+    int nrow = h_;
+    int n = WorkerPool::instance().nthread();
+    if (n > JPEG_MAXBAND)
+	n = JPEG_MAXBAND;
+    if (n > nrow)
+	n = nrow;
+    if (n < 1)
+	n = 1;
+    int i;
+    for (i = 0; i < n; ++i) {
+	band_[i].y0_ = i * nrow / n;
+	band_[i].y1_ = (i + 1) * nrow / n;
+    }
+    /*
+     * Band 0 is coded here while the workers do the rest.
+     */
+    if (n > 1) {
+	latch_.reset(n - 1);
+	for (i = 1; i < n; ++i)
+	    WorkerPool::instance().submit(&band_[i]);
+    }
+    band_[0].code();
+    if (n > 1)
+	latch_.wait();
+
+    int room = tx_->mtu() - HDRSIZE - RSTSIZE;
+    u_int off = 0;
+    int cc = 0;
+    for (int row = 0; row < nrow; ) {
+	int first = row;
+	int len;
+	const u_char* bp = rowdata(row, len);
+	int clen = len;
+	while (++row < nrow) {
+	    (void)rowdata(row, len);
+	    if (clen + len > room)
+		break;
+	    clen += len;
+	}
+	for (int done = 0; done < clen; ) {
+	    int pcc = clen - done;
+	    if (pcc > room)
+		pcc = room;
+	    pktbuf* pb = pool_->alloc(ts_, RTP_PT_JPEG);
+	    rtphdr* rh = (rtphdr*)pb->data;
+	    u_int* h = (u_int*)(rh + 1);
+	    h[0] = htonl(off);
+	    h[1] = htonl(JPEG_TYPE_RESTART << 24 | quant_ << 16 |
+			 w_ << 8 | h_);
+	    jpegrsthdr* rst = (jpegrsthdr*)(h + 2);
+	    rst->dri = htons(w_ >> 1);
+	    rst->count = htons((done == 0) << 15 |
+			       (done + pcc == clen) << 14 | (first & 0x3fff));
+	    u_char* dp = &pb->data[HDRSIZE + RSTSIZE];
+	    if (row - first == 1)
+		memcpy(dp, bp + done, pcc);
+	    else {
+		/* whole rows, which all fit */
+		for (int k = first; k < row; ++k) {
+		    const u_char* p = rowdata(k, len);
+		    memcpy(dp, p, len);
+		    dp += len;
+		}
+	    }
+	    done += pcc;
+	    off += pcc;
+	    pb->len = HDRSIZE + RSTSIZE + pcc;
+	    if (row == nrow && done == clen)
+		rh->rh_flags |= htons(RTP_M);
+	    cc += pb->len;
+	    tx_->send(pb);
+	}
+    }
+    return (cc);
+}
+
+JpegBand::JpegBand() : encoder_(0), latch_(0), y0_(0), y1_(0),
+    buf_(0), end_(0), size_(0), nrow_(0)
+{
+}
+
+JpegBand::~JpegBand()
+{
+    delete[] buf_;
+    delete[] end_;
+}
+
+/*
+ * The most an MCU can add to a band's buffer: four blocks of 64
+ * of the longest codes, every byte of them stuffed, and the bits
+ * left in the bit buffer, stuffed, and a marker.
+ */
+#define MAXMCU (4 * 64 * (16 + 11) / 8 * 2 + 2 * 8 + 2)
+
+void
+JpegBand::grow()
+{
+    int nsize = size_ != 0 ? 2 * size_ : 16 * MAXMCU;
+    u_char* p = new u_char[nsize];
+    int cc = 0;
+    if (buf_ != 0) {
+	cc = bc_ - buf_;
+	memcpy(p, buf_, cc);
+	delete[] buf_;
+    }
+    buf_ = p;
+    bc_ = p + cc;
+    size_ = nsize;
+}
+
+void
+JpegBand::code()
+{
+    JpegEncoder* e = encoder_;
+    int ncol = e->w_ >> 1;
+    int nrow = y1_ - y0_;
+    if (nrow > nrow_) {
+	delete[] end_;
+	end_ = new int[nrow];
+	nrow_ = nrow;
+    }
+    if (buf_ == 0)
+	grow();
+    bc_ = buf_;
+    bb_ = 0;
+    nbb_ = 0;
+    lpred_ = 0;
+    crpred_ = 0;
+    cbpred_ = 0;
+    for (int y = y0_; y < y1_; ++y) {
+	u_int mcu = y * ncol;
+	for (int x = 0; x < ncol; ++x, ++mcu) {
+	    if (bc_ + MAXMCU > buf_ + size_)
+		grow();
+	    encode_mcu(mcu, e->frm_, e->w_, e->framesize_,
+		       e->lqt_, e->cqt_);
+	}
+	/* RST0-7 in turn, and none after the last row */
+	restart(y < e->h_ - 1 ? y : -1);
+	end_[y - y0_] = bc_ - buf_;
+    }
+}
+
+void
+JpegBand::run()
+{
+    TRACE_SCOPE_KEY(TRACE_SLICE, encoder_->srcid(), encoder_->ts_);
+    code();
+    latch_->done();
+}
+
 /*
  * fdct() from dct.cc slightly modified to fold in the jpeg 128 bias.
  */
@@ -614,7 +835,7 @@ JpegEncoder::encode(const VideoFrame* vf)
 #define FWD_DandQ(v, iq) short((v) * qt[iq] + 0.5)
 
 void
-JpegEncoder::fdct(const u_char* in, int stride, short* out, const float* qt)
+JpegCoder::fdct(const u_char* in, int stride, short* out, const float* qt)
 {
     float tmp[64];
     float* tp = tmp;
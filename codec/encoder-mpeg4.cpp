@@ -14,12 +14,7 @@
 #include "module.h"
 #include "ffmpeg_codec.h"
 #include "deinterlace.h"
-
-static Transmitter *tx;
-static RTP_BufferPool *pool;
-static u_int32_t ts;
-static int vicEncodedMB;
-static int vicNumMB;
+#include "trace.h"
 
 using namespace std;
 
@@ -45,6 +40,9 @@ class MPEG4Encoder:public TransmitterModule
     UCHAR *bitstream;
     Deinterlace deinterlacer;
     bool use_deinterlacer;
+    u_int32_t ts;
+    int vicEncodedMB;
+    int vicNumMB;
 };
 
 static class MPEG4EncoderMatcher:public Matcher
@@ -68,6 +66,7 @@ MPEG4Encoder::MPEG4Encoder():TransmitterModule(FT_YUV_420)
     state = false;
     mpeg4.init(true, CODEC_ID_MPEG4, PIX_FMT_YUV420P);
     mpeg4.rtp_callback = rtp_callback;
+    mpeg4.opaque = this;
     kbps = 1000;
     fps = 20;
     gop = 20;
@@ -91,6 +90,12 @@ void MPEG4Encoder::size(int w, int h)
 
 int MPEG4Encoder::command(int argc, const char *const *argv)
 {
+    if (argc == 2) {
+	if (strcmp(argv[1], "keyframe") == 0) {
+	    mpeg4.request_key_frame();
+	    return (TCL_OK);
+	}
+    }
     if (argc == 3) {
 	if (strcmp(argv[1], "q") == 0) {
 	    // mpeg4.quality = atoi(argv[2]);
@@ -105,6 +110,7 @@ int MPEG4Encoder::command(int argc, const char *const *argv)
 	}
 	else if (strcmp(argv[1], "kbps") == 0) {
 	    kbps = atoi(argv[2]);
+	    mpeg4.set_bit_rate(kbps * 1024);
 	    return (TCL_OK);
 	}
 	else if (strcmp(argv[1], "useDeinterlacer") == 0) {
@@ -121,50 +127,57 @@ int MPEG4Encoder::command(int argc, const char *const *argv)
     return (TransmitterModule::command(argc, argv));
 }
 
+/*
+ * The codec calls this as it finishes each video packet, while it
+ * goes on with the rest of the frame, so the packet goes out now
+ * instead of after the whole frame.  Each starts at a resync marker
+ * (or the VOP header) as RFC 3016 has it.  The codec only ends a
+ * video packet once it is past rtp_payload_size, so one that has
+ * grown too big for an RTP packet is cut across several; the last
+ * one of the frame gets the marker bit.
+ */
 void MPEG4Encoder::rtp_callback(AVCodecContext * c, void *data, int size,
 				int num_mb)
 {
-    // cout << "packet size = " << size << "  MB num = "<< num_mb << endl;
-
-    pktbuf *pb;
-    rtphdr *rh;
-
-    pb = pool->alloc(ts, RTP_PT_MPEG4);
-    rh = (rtphdr *) pb->data;
-
-    vicEncodedMB += num_mb;
-    if (vicEncodedMB == vicNumMB) {
-	rh->rh_flags |= htons(RTP_M);
-	vicEncodedMB = 0;
+    /* no statics: simulcast runs several of us at once */
+    MPEG4Encoder *e = (MPEG4Encoder *) c->opaque;
+    Transmitter *tx = e->tx_;
+
+    e->vicEncodedMB += num_mb;
+    bool last = e->vicEncodedMB >= e->vicNumMB;
+    if (last)
+	e->vicEncodedMB = 0;
+
+    const UCHAR *dp = (const UCHAR *) data;
+    int max = tx->mtu() - sizeof(rtphdr);
+    while (size > 0) {
+	int cc = size < max ? size : max;
+	pktbuf *pb = e->pool_->alloc(e->ts, RTP_PT_MPEG4);
+	rtphdr *rh = (rtphdr *) pb->data;
+	size -= cc;
+	if (last && size == 0)
+	    rh->rh_flags |= htons(RTP_M);
+	memcpy(&pb->data[sizeof(rtphdr)], dp, cc);
+	dp += cc;
+	pb->len = cc + sizeof(rtphdr);
+	tx->send(pb);
     }
-
-    UCHAR *pd = (UCHAR *) data;
-
-    // sizeof(rtphdr) is 12
-    memcpy(&pb->data[12], data, size);
-
-    pb->len = size + 12;
-    tx->send(pb);
     tx->flush();
 }
 
 
 int MPEG4Encoder::consume(const VideoFrame * vf)
 {
-    pktbuf *pb;
-    rtphdr *rh;
+    TRACE_SCOPE_SETKEY(TRACE_ENCODE, srcid(), vf->ts_);
     int len;
     ts = vf->ts_;
-    tx = tx_;
-    pool = pool_;
-
-    static int pframe_no = 0;
-
-    double psnr = 0;
 
     if (!state) {
 	state = true;
 	size(vf->width_, vf->height_);
+	// end video packets a quarter short of a full RTP packet, for
+	// the macroblock that takes one past the mark
+	mpeg4.rtp_payload_size = (tx_->mtu() - sizeof(rtphdr)) * 3 / 4;
 	// std::cout << "mpeg4enc: WxH:" << vf->width_ << "x" << vf->height_;
 	// std::cout << "kbps:" << kbps << " fps:" << fps << "\n";
 	mpeg4.init_encoder(vf->width_, vf->height_, kbps * 1024, fps, gop);
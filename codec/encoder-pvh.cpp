@@ -51,6 +51,7 @@ extern "C"
 #include "module.h"
 #include "transmitter.h"
 #include "pktbuf-rtp.h"
+#include "trace.h"
 
 #ifdef HAVE_HH
 #define NC (4*64)
@@ -99,11 +100,16 @@ struct bit_counter {
 }
 
 #define BB_NBIT(lp) ((((lp)->bs - &(lp)->pb->data[HLEN]) << 3) + (lp)->nbb)
+/*
+ * Where a 32-bit bit buffer would have stored up to (it keeps 1 to
+ * 32 bits back), so packets are split where they always have been.
+ */
+#define BB_WORDS(lp) (&(lp)->pb->data[HLEN] + (((BB_NBIT(lp) - 1) >> 5) << 2))
 
 struct pvh_layer {
 	/* bit buffer */
 	int nbb;
-	u_int bb;
+	bitbuf bb;
 	u_char* bs;
 	u_char* es;
 	pktbuf* pb;
@@ -503,7 +509,7 @@ void PvhEncoder::refine_old(pvh_layer* lp, int off)
 void PvhEncoder::refine_new(pvh_layer* lp, int off)
 {
 	u_int16_t* sc = sc_;
-	u_int bb = lp->bb;
+	bitbuf bb = lp->bb;
 	int nbb = lp->nbb;
 	/*
 	 * compute a mask of the bits left to
@@ -569,7 +575,7 @@ printf("DCX %d\n", blk[0]);
 printf("DCD %d\n", blk[0] - dc_);
 dc_ = blk[0];
 #endif
-	u_int bb = lp->bb;
+	bitbuf bb = lp->bb;
 	int nbb = lp->nbb;
 	/*
 	 * Quantize DC.  Round instead of truncate.
@@ -993,7 +999,7 @@ static u_int8_t cf_code[16] = {
  */
 void PvhEncoder::encode_sbc_base(pvh_layer* lp, u_int8_t* p, u_int m)
 {
-	u_int bb = lp->bb;
+	bitbuf bb = lp->bb;
 	int nbb = lp->nbb;
 	for (int k = 0; m != 0; ++k, m >>= 1) {
 		if ((m & 1) != 0) {
@@ -1028,7 +1034,7 @@ void PvhEncoder::encode_sbc_base(pvh_layer* lp, u_int8_t* p, u_int m)
 void PvhEncoder::encode_sbc_refinement(pvh_layer* lp, u_int8_t* p,
 				       u_int m, int bit)
 {
-	u_int bb = lp->bb;
+	bitbuf bb = lp->bb;
 	int nbb = lp->nbb;
 	int mask = 0x80 - (1 << bit);
 	for (int k = 0; m != 0; ++k, m >>= 1) {
@@ -1275,7 +1281,7 @@ int PvhEncoder::check_buffers(int sblk)
 		 * should instead walk off end and copy back
 		 * (like H.261)
 		 */
-		if (lp->bs + MAXMBSIZE >= lp->es) {
+		if (BB_WORDS(lp) + MAXMBSIZE >= lp->es) {
 			flush(lp, 0);
 			getpkt(i, sblk);
 			if (i == 0)
@@ -1288,6 +1294,7 @@ int PvhEncoder::check_buffers(int sblk)
 //void PvhEncoder::recv(Buffer* bp)
 int PvhEncoder::consume(const VideoFrame *vf)
 {
+	TRACE_SCOPE_SETKEY(TRACE_ENCODE, srcid(), vf->ts_);
 	//const VideoFrame* vf = (VideoFrame*)bp;
 	if (!samesize(vf))
 		size(vf->width_, vf->height_);
@@ -35,6 +35,7 @@ static const char rcsid[] =
 #include "transmitter.h"
 #include "pktbuf-rtp.h"
 #include "module.h"
+#include "trace.h"
 
 class RawEncoder : public TransmitterModule {
  public:
@@ -69,6 +70,7 @@ RawEncoder::~RawEncoder()
 
 int RawEncoder::consume(const VideoFrame* vf)
 {
+	TRACE_SCOPE_SETKEY(TRACE_ENCODE, srcid(), vf->ts_);
 	YuvFrame* p = (YuvFrame*)vf;
 
 	/* make sure the last frame is completely transmitted */
@@ -20,6 +20,8 @@ FFMpegCodec::FFMpegCodec()
     state = false;
     quality = 31;
     //rtp_callback = NULL;
+    opaque = NULL;
+    rtp_payload_size = 1024;
     enable_hq_encoding = false;
 }
 
@@ -79,6 +81,7 @@ void FFMpegCodec::init_encoder(int width_, int height_,
 
     // assign rtp callback function
     c->rtp_callback = rtp_callback;
+    c->opaque = opaque;
     //c->rtp_callback = NULL;
     // put sample parameters */
     c->bit_rate = bit_rate;
@@ -116,7 +119,7 @@ void FFMpegCodec::init_encoder(int width_, int height_,
     }
 
     c->me_method = ME_EPZS;
-    c->rtp_payload_size = 1024;
+    c->rtp_payload_size = rtp_payload_size;
 
     /* open it */
     if (avcodec_open(c, codec) < 0) {
@@ -138,6 +141,7 @@ void FFMpegCodec::init_encoder(int width_, int height_,
     bitstream = new UCHAR[MAX_CODED_SIZE];
     state = true;
     keyFrame = false;
+    keyRequest = false;
 }
 
 
@@ -197,6 +201,8 @@ UCHAR *FFMpegCodec::encode(const UCHAR * vf, int &len)
     memcpy(picture->data[1], (vf + frame_size), frame_size / 4);
     memcpy(picture->data[2], (vf + frame_size * 5 / 4), frame_size / 4);
 
+    picture->pict_type = keyRequest ? FF_I_TYPE : 0;
+    keyRequest = false;
     len = avcodec_encode_video(c, bitstream, MAX_CODED_SIZE, picture);
     if (c->coded_frame && c->coded_frame->key_frame) {
 	keyFrame = true;
@@ -231,6 +237,14 @@ double FFMpegCodec::get_PSNR()
 // return:  videoframe size
 //         -1 indicates decoding failure
 int FFMpegCodec::decode(UCHAR * codedstream, int size, UCHAR * vf)
+{
+    int len = decode(codedstream, size);
+    if (len >= 0)
+	copy(vf);
+    return len;
+}
+
+int FFMpegCodec::decode(UCHAR * codedstream, int size)
 {
     int got_picture;
     int len;
@@ -257,9 +271,6 @@ int FFMpegCodec::decode(UCHAR * codedstream, int size, UCHAR * vf)
     }
 */
     pict_type = picture->pict_type;
-    memcpy(vf, picture->data[0], frame_size);
-    memcpy(vf + frame_size, picture->data[1], frame_size / 4);
-    memcpy(vf + frame_size * 5 / 4, picture->data[2], frame_size / 4);
 
     //fwrite(picture->data[0], frame_size, 1, (FILE*)fptr);
     //fwrite(picture->data[1], frame_size/4, 1, (FILE*)fptr);
@@ -268,6 +279,13 @@ int FFMpegCodec::decode(UCHAR * codedstream, int size, UCHAR * vf)
     return len;
 }
 
+void FFMpegCodec::copy(UCHAR * vf) const
+{
+    memcpy(vf, picture->data[0], frame_size);
+    memcpy(vf + frame_size, picture->data[1], frame_size / 4);
+    memcpy(vf + frame_size * 5 / 4, picture->data[2], frame_size / 4);
+}
+
 void FFMpegCodec::resize(int w, int h)
 {
     width = w;
@@ -303,3 +321,19 @@ void FFMpegCodec::set_max_quantizer(int q)
 //    s->qmax = c->qmax = c->mb_qmax = q;
     }
 }
+
+// the rate control reads bit_rate every frame, so this takes effect
+// on a running encoder
+void FFMpegCodec::set_bit_rate(int bps)
+{
+    bit_rate = bps;
+    if (state)
+	c->bit_rate = bps;
+}
+
+// the next frame is coded intra (with the VOL header in front) at a
+// receiver's request
+void FFMpegCodec::request_key_frame()
+{
+    keyRequest = true;
+}
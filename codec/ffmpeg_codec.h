@@ -66,15 +66,24 @@ class FFMpegCodec
     //     -1 indicates failure decoding
     //     -2  indicates resizing    
     int decode(UCHAR * codedstream, int size, UCHAR * vf);
+    // decode without the copy: the picture, width * height * 3 / 2
+    // bytes of I420, is only copied out by copy(), so the frame
+    // can be sized after the stream
+    int decode(UCHAR * codedstream, int size);
+    void copy(UCHAR * vf) const;
 
 
     void set_gop(int gop);
     void set_max_quantizer(int q);
+    void set_bit_rate(int bps);
+    void request_key_frame();
     double get_PSNR();
 
     //New interface
     void (*rtp_callback) (AVCodecContext * c, void *data, int size,
 			  int packet_number);
+    void *opaque;		// c->opaque, for rtp_callback
+    int rtp_payload_size;	// where a video packet is ended
     int width;
     int height;
     int bit_rate;
@@ -92,6 +101,7 @@ class FFMpegCodec
     PixelFormat pixelfmt;
     bool encoding;
     bool keyFrame;
+    bool keyRequest;		// code the next frame intra
 
     AVCodec *codec;
 
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include "config.h"
+#include "sys-time.h"
+#include "framepool.h"
+
+FramePool::framebuf* FramePool::free_list_[FRAMEPOOL_NBUCKET];
+u_int FramePool::inuse_;
+u_int FramePool::free_;
+double FramePool::trimmed_;
+
+/* the header, rounded up to keep the frame 32 byte aligned */
+#define FRAMEBUF_HDR ((sizeof(framebuf) + 31) & ~31)
+
+double FramePool::now()
+{
+	timeval tv;
+	::gettimeofday(&tv, 0);
+	return (tv.tv_sec + 1e-6 * tv.tv_usec);
+}
+
+FramePool::framebuf* FramePool::header(const u_char* p)
+{
+	return ((framebuf*)(p - FRAMEBUF_HDR));
+}
+
+u_char* FramePool::alloc(int size)
+{
+	int b = 0;
+	int n = FRAMEPOOL_MIN;
+	while (n < size && b < FRAMEPOOL_NBUCKET) {
+		n <<= 1;
+		++b;
+	}
+	framebuf* f;
+	if (b == FRAMEPOOL_NBUCKET) {
+		b = -1;
+		n = size;
+		f = 0;
+	} else {
+		f = free_list_[b];
+		if (f != 0) {
+			free_list_[b] = f->next;
+			free_ -= n;
+		}
+	}
+	if (f == 0) {
+		/* 32 more for the alignment, as malloc only gives 16 */
+		u_char* bp = (u_char*)malloc(FRAMEBUF_HDR + n + 32);
+		if (bp == 0)
+			abort();
+		u_char* p = (u_char*)(((unsigned long)bp + FRAMEBUF_HDR + 31) &
+				      ~31UL);
+		f = header(p);
+		f->base = bp;
+		f->bucket = b;
+		f->size = n;
+	}
+	f->next = 0;
+	f->refcnt = 1;
+	inuse_ += n;
+	trim();
+	return ((u_char*)f + FRAMEBUF_HDR);
+}
+
+void FramePool::hold(u_char* p)
+{
+	++header(p)->refcnt;
+}
+
+void FramePool::release(u_char* p)
+{
+	if (p == 0)
+		return;
+	framebuf* f = header(p);
+	if (--f->refcnt > 0)
+		return;
+	inuse_ -= f->size;
+	if (f->bucket < 0)
+		free(f->base);
+	else {
+		f->freed = now();
+		f->next = free_list_[f->bucket];
+		free_list_[f->bucket] = f;
+		free_ += f->size;
+	}
+	trim();
+}
+
+int FramePool::size(const u_char* p)
+{
+	return (header(p)->size);
+}
+
+void FramePool::trim()
+{
+	if (free_ == 0)
+		return;
+	double t = now();
+	/* no more than once a second */
+	if (t - trimmed_ < 1.)
+		return;
+	trimmed_ = t;
+	for (int b = 0; b < FRAMEPOOL_NBUCKET; ++b) {
+		framebuf** pp = &free_list_[b];
+		while (*pp != 0) {
+			framebuf* f = *pp;
+			if (t - f->freed < FRAMEPOOL_IDLE) {
+				pp = &f->next;
+				continue;
+			}
+			*pp = f->next;
+			free_ -= f->size;
+			free(f->base);
+		}
+	}
+}
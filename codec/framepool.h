@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef vic_framepool_h
+#define vic_framepool_h
+
+#include "config.h"
+
+/*
+ * The big buffers decoders keep their frames in, shared by all of
+ * them rather than each holding its own for as long as it lives.
+ * Buffers come in power-of-two sizes from FRAMEPOOL_MIN up (a
+ * bigger one is allocated as asked, and freed as soon as it is
+ * released) and are counted references: alloc() hands out the
+ * first, hold() takes another (a renderer keeping a frame past
+ * consume()), and release() drops one, the last putting the buffer
+ * on its size's free list.  A buffer left there FRAMEPOOL_IDLE
+ * seconds goes back to the system (trim(), which the pool runs
+ * itself as it is used).
+ *
+ * Only for the main thread: the worker pool decodes into frames it
+ * is handed, and doesn't allocate them.
+ */
+
+#define FRAMEPOOL_MIN	(64 << 10)
+#define FRAMEPOOL_NBUCKET 8	/* FRAMEPOOL_MIN up to 8MB */
+#define FRAMEPOOL_IDLE	30	/* seconds */
+
+class FramePool {
+    public:
+	static u_char* alloc(int size);
+	static void hold(u_char* p);
+	static void release(u_char* p);
+	/* the bytes p can hold */
+	static int size(const u_char* p);
+	static void trim();
+
+	/* bytes held, in use or free; those in use; those free */
+	static inline u_int resident() { return (inuse_ + free_); }
+	static inline u_int inuse() { return (inuse_); }
+	static inline u_int nfree() { return (free_); }
+    protected:
+	struct framebuf {
+		framebuf* next;	/* on a free list */
+		void* base;	/* what malloc gave, for free() */
+		int bucket;	/* -1 if too big for one */
+		int size;
+		int refcnt;
+		double freed;	/* seconds, when put on the free list */
+	};
+	static framebuf* header(const u_char* p);
+	static double now();
+
+	static framebuf* free_list_[FRAMEPOOL_NBUCKET];
+	static u_int inuse_;
+	static u_int free_;
+	static double trimmed_;	/* when trim() last ran */
+};
+
+#endif
@@ -11,6 +11,144 @@
 /* Subsampling factor for SAD measurement */
 int subsampleSAD = 1;    /* may be 1, 2 or 4 */
 
+/* Use the SSE2 SAD, -1: not yet decided (see SetSIMDSAD) */
+int simdSAD = -1;
+
+/*
+ * The SSE2 SAD is compiled for SSE2 even when the rest of the file
+ * isn't, and is only used if the cpu turns out to have it.
+ */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define SAD_SSE2 __attribute__((target("sse2")))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define SAD_SSE2
+#endif
+
+#ifdef SAD_SSE2
+#include <emmintrin.h>
+#ifdef RUNTIME_CPUDETECT
+#include "cpu/cpudetect.h"
+#endif
+#endif
+
+
+/***********************************************************CommentBegin******
+ *****************************************************************************
+ *
+ * -- SetSIMDSAD -- Choose between the SSE2 and the C SAD
+ *
+ * Purpose:             Enables the SSE2 SAD if 'on' is set and the cpu
+ *                      has SSE2, disables it otherwise.
+ *
+ * Side effects:        Sets the global variable 'simdSAD'.
+ *
+ *****************************************************************************/
+void SetSIMDSAD(int on)
+ /**********************************************************CommentEnd********/
+{
+  simdSAD = 0;
+#ifdef SAD_SSE2
+  if (on) {
+#ifdef RUNTIME_CPUDETECT
+    simdSAD = (cpu_check() & FF_CPU_SSE2) != 0;
+#elif defined(__SSE2__) || defined(_M_X64)
+    simdSAD = 1;
+#endif
+  }
+#else
+  (void)on;
+#endif
+}
+
+
+#ifdef SAD_SSE2
+/*
+ * One row of 16 pels per psadbw.  When subsampling, the pels that
+ * count (every 'subsampleSAD'th, starting with the first) are picked
+ * out by masking the others to 0 in both blocks.  The sum is checked against 'max'
+ * every four rows; since it never decreases, this stops no earlier
+ * than the C version would, and returns the same value whenever the
+ * C version runs to the end.
+ */
+SAD_SSE2
+static int BlockSADSSE2(Byte *p, Byte *rp, int w, int max)
+{
+  const int  step = subsampleSAD * w;
+  __m128i    mask, acc, a, b;
+  int        sad = 0;
+  int        n = 0;
+  int        y;
+
+
+  if (subsampleSAD == 1)
+    mask = _mm_set1_epi8((char)0xff);
+  else if (subsampleSAD == 2)
+    mask = _mm_set1_epi16(0x00ff);
+  else
+    mask = _mm_set1_epi32(0x000000ff);
+  acc = _mm_setzero_si128();
+
+  for (y = subsampleSAD / 2; y < 16; y += subsampleSAD) {
+    a = _mm_and_si128(_mm_loadu_si128((__m128i *)p), mask);
+    b = _mm_and_si128(_mm_loadu_si128((__m128i *)rp), mask);
+    acc = _mm_add_epi64(acc, _mm_sad_epu8(a, b));
+    p += step;
+    rp += step;
+    if ((++n & 3) == 0) {
+      sad = _mm_cvtsi128_si32(acc) +
+	_mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+      if (sad > max)
+	break;
+    }
+  }
+  sad = _mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+
+  if (subsampleSAD > 1)
+    sad *= SQR(subsampleSAD);
+
+  return(sad);
+}
+#endif
+
+
+/*
+ * SAD of the 16x16 blocks at 'p' and 'rp' in pictures 'w' pels wide,
+ * the common part of the routines below.
+ */
+static int BlockSAD(Byte *p, Byte *rp, int w, int max)
+{
+  const int  wm1 = subsampleSAD * w - 16;
+  int  sad = 0;
+  int  tmp;
+  int  x, y;
+
+
+#ifdef SAD_SSE2
+  if (simdSAD < 0)
+    SetSIMDSAD(1);
+  if (simdSAD)
+    return(BlockSADSSE2(p, rp, w, max));
+#endif
+
+  for (y = subsampleSAD / 2; y < 16; y += subsampleSAD) {
+    for (x = subsampleSAD / 2; x < 16; x += subsampleSAD) {
+      tmp = (int)(*p) - (int)(*rp);
+      p += subsampleSAD;
+      rp += subsampleSAD;
+      sad += ABS(tmp);
+    }
+    p += wm1;
+    rp += wm1;
+    if (sad > max)
+      break;
+  }
+
+  if (subsampleSAD > 1)
+    sad *= SQR(subsampleSAD);
+
+  return(sad);
+}
+
 /***********************************************************CommentBegin******
  *****************************************************************************
  *
@@ -209,33 +347,10 @@ int MacroBlockPictureSAD(int xPos, int yPos, Picture *pict1, Picture *pict2,
  /**********************************************************CommentEnd********/
 {
   const int  w = pict1->w;
-  const int  wm1 = subsampleSAD * w - 16;
-  int  sad = 0;
-  int  tmp;
-  int  x, y;
-  Byte *p1, *p2;
 
 
-  p1 = pict1->y + xPos + yPos * w;
-  p2 = pict2->y + xPos + yPos * w;
-
-  for (y = subsampleSAD / 2; y < 16; y += subsampleSAD) {
-    for (x = subsampleSAD / 2; x < 16; x += subsampleSAD) {
-      tmp = (int)(*p1) - (int)(*p2);
-      p1 += subsampleSAD;
-      p2 += subsampleSAD;
-      sad += ABS(tmp);
-    }
-    p1 += wm1;
-    p2 += wm1;
-    if (sad > max)
-      break;
-  }
-
-  if (subsampleSAD > 1)
-    sad *= SQR(subsampleSAD);
-
-  return(sad);
+  return(BlockSAD(pict1->y + xPos + yPos * w, pict2->y + xPos + yPos * w,
+		  w, max));
 }
 
 
@@ -284,33 +399,13 @@ int FPMotionMacroBlockPictureSAD(int xPos, int yPos, Picture *pict,
  /**********************************************************CommentEnd********/
 {
   const int  w = pict->w;
-  const int  wm1 = subsampleSAD * w - 16;
-  int  sad = 0;
-  int  tmp;
-  int  x, y;
   Byte *p, *rp;
 
 
   p = pict->y + xPos + yPos * w;
   rp = refPict->y + xPos + mv->x + (yPos + mv->y) * w;
 
-  for (y = subsampleSAD / 2; y < 16; y += subsampleSAD) {
-    for (x = subsampleSAD / 2; x < 16; x += subsampleSAD) {
-      tmp = (int)(*p) - (int)(*rp);
-      p += subsampleSAD;
-      rp += subsampleSAD;
-      sad += ABS(tmp);
-    }
-    p += wm1;
-    rp += wm1;
-    if (sad > max)
-      break;
-  }
-
-  if (subsampleSAD > 1)
-    sad *= SQR(subsampleSAD);
-
-  return(sad);
+  return(BlockSAD(p, rp, w, max));
 }
 
 
@@ -362,10 +457,6 @@ int HPMotionMacroBlockPictureSAD(int xPos, int yPos, Picture *pict,
  /**********************************************************CommentEnd********/
 {
   const int  w = pict->w;
-  const int  wm1 = subsampleSAD * w - 16;
-  int  sad = 0;
-  int  tmp;
-  int  x, y;
   Byte *p, *rp;
 
 
@@ -377,23 +468,7 @@ int HPMotionMacroBlockPictureSAD(int xPos, int yPos, Picture *pict,
   else
     rp = interpol[2] + xPos + mv->x + (yPos + mv->y) * w;
 
-  for (y = subsampleSAD / 2; y < 16; y += subsampleSAD) {
-    for (x = subsampleSAD / 2; x < 16; x += subsampleSAD) {
-      tmp = (int)(*p) - (int)(*rp);
-      p += subsampleSAD;
-      rp += subsampleSAD;
-      sad += ABS(tmp);
-    }
-    p += wm1;
-    rp += wm1;
-    if (sad > max)
-      break;
-  }
-
-  if (subsampleSAD > 1)
-    sad *= SQR(subsampleSAD);
-
-  return(sad);
+  return(BlockSAD(p, rp, w, max));
 }
 
 
@@ -19,6 +19,8 @@ extern void recon_comp(unsigned char *src, unsigned char *dst, int lx, int lx2,
 extern void recon_comp_obmc(unsigned char *src, unsigned char *dst, int modemap[72+1][88+2], int MV[2][5][72+1][88+2], int pb_frame, int lx, int lx2, int comp, int w, int h, int x, int y);
 /* block.c */
 extern int subsampleSAD;
+extern int simdSAD;
+extern void SetSIMDSAD(int on);
 extern int MacroBlockPictureIntraSAD(int xPos, int yPos, Picture *pict, int max);
 extern int MacroBlockPictureIntraVar(int xPos, int yPos, Picture *pict, int max);
 extern int MacroBlockPictureSAD(int xPos, int yPos, Picture *pict1, Picture *pict2, int max);
@@ -56,6 +58,7 @@ extern int H263subtractMVPrediction(MVector *mv, MVector *pv, int umv, MVector *
 extern int GetMVDRate(MVector *pv, MVector *mv);
 extern int FullSearchFullPelME(int xPos, int yPos, int *minCost_p, int lambda, int searchRange, int rMin, int rMax, Picture *pict, Picture *predPict, MVector *pv, MVector *mvOut);
 extern int FastFullPelMotionEstimationMB(int xPos, int yPos, Picture *pict, Picture *refPict, int cost0, int lambda, MVector *pv, MVector *mv);
+extern int EPZSFullPelMotionEstimationMB(int xPos, int yPos, Picture *pict, Picture *refPict, int cost0, int lambda, MVector *pv, MVField *mvf, MVector *mv);
 extern void InitHalfPelInterpolation(Picture *pict, Byte *interpol[3]);
 extern int HalfPelMotionEstimationMB(int xPos, int yPos, Picture *pict, Byte *interpol[3], int left_f, int right_f, int top_f, int bottom_f, int costMin, int lambda, MVector *pv, MVector *mv);
 extern void PlotMVField(MVField *mvf, int value, float scale, Picture *pic);
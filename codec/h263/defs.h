@@ -100,6 +100,11 @@
 #define TIME_RD_MODE_DECISION   7
 /*#define TIME_RD_ME*/
 
+/* Integer-pel motion search used below TIME_FULLSEARCH_ME ('motionSearch') */
+#define ME_FULL                 0  /* exhaustive, the reference */
+#define ME_BASE                 1  /* descent from the predictor */
+#define ME_EPZS                 2  /* predictive zonal search */
+
 
 /* Pyramid scales */
 #define SCALE_STEP            2
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * h263bench - compare the integer-pel motion searches of the H.263
+ * encoder.
+ *
+ * usage: h263bench [-n frames] [-q quant] [-t codingtime] [-s wxh]
+ *                  [-m full|base|epzs] [-c] [file]
+ *
+ * The input is a sequence of 4:2:0 planar frames of the given size
+ * (CIF by default) read from `file', or a synthetic panning picture
+ * if there's no file.  The sequence is encoded with a fixed quantizer
+ * once with each motion search (or only with -m), the first frame
+ * intra and the rest inter, and for each the encoding rate, the
+ * bits per frame and the luma PSNR of the decoded pictures are
+ * reported, with the differences to full search.
+ *
+ * -c	use the C SAD, not SSE2.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "../../bench.h"
+
+#define DEFINE_GLOBALS
+#include "defs.h"
+#include "structs.h"
+#include "Util.h"
+#include "bitOut.h"
+#include "h263encoder.h"
+#include "code.h"
+#include "h263encoder.p"
+#include "common.p"
+
+static void alloc_picture(Picture* p, int w, int h)
+{
+	p->w = w;
+	p->h = h;
+	p->y = (Byte*)calloc(w * h * 3 / 2, 1);
+	p->u = p->y + w * h;
+	p->v = p->u + w * h / 4;
+}
+
+/*
+ * A smooth texture seen through a window that pans at a speed
+ * changing with the frame number, with a block moving against it.
+ */
+static void synth(Byte* f, int w, int h, int n)
+{
+	int x, y;
+	int dx = (n * 3) / 2 + (n / 10) * 2;
+	int dy = n / 2 - (n / 15) * 3;
+	int bx = (w / 4 + 5 * n) % w;
+	int by = (h / 4 + 2 * n) % h;
+
+	for (y = 0; y < h; ++y)
+		for (x = 0; x < w; ++x) {
+			int u = x + dx;
+			int v = y + dy;
+			int s = (int)(96 + 48 * sin(u * 0.11) * cos(v * 0.07) +
+				      24 * sin((u + 2 * v) * 0.31));
+			if (x >= bx && x < bx + 48 && y >= by && y < by + 48)
+				s = 200 - ((x - bx) ^ (y - by)) * 2;
+			f[x + y * w] = s;
+		}
+	for (y = 0; y < h / 2; ++y)
+		for (x = 0; x < w / 2; ++x) {
+			f[w * h + x + y * w / 2] = 128 + ((x + dx / 2) & 31);
+			f[w * h * 5 / 4 + x + y * w / 2] = 128 - ((y + dy / 2) & 31);
+		}
+}
+
+struct result {
+	double fps;
+	double bits;	/* per frame */
+	double psnr;	/* luma, mean over the frames */
+};
+
+static void encode(int me, Byte* seq, int nframe, int w, int h, int q,
+		   int codingtime, struct result* r)
+{
+	Picture pict, prev, prevdec, dec;
+	MVField mvf;
+	Bitstr bs;
+	int fs = w * h * 3 / 2;
+	int nmb = (w / 16) * (h / 16);
+	double t = 0., bits = 0., db = 0.;
+	int i;
+
+	motionSearch = me;
+	alloc_picture(&prev, w, h);
+	alloc_picture(&prevdec, w, h);
+	alloc_picture(&dec, w, h);
+	mvf.w = w / 16;
+	mvf.h = h / 16;
+	mvf.mx = (short*)calloc(nmb, sizeof(short));
+	mvf.my = (short*)calloc(nmb, sizeof(short));
+	mvf.mode = (short*)calloc(nmb, sizeof(short));
+	bs.size = 8 * fs * 2;
+	bs.b = (Byte*)malloc(bs.size / 8);
+	bs.actualSize = 0;
+	bs.fp = NULL;
+
+	for (i = 0; i < nframe; ++i) {
+		Byte* f = seq + i * fs;
+		double t0;
+		Picture tmp;
+
+		pict.w = w;
+		pict.h = h;
+		pict.y = f;
+		pict.u = f + w * h;
+		pict.v = pict.u + w * h / 4;
+		bs.ind = 0;
+		t0 = bench_now();
+		EncodeH263Q(q, codingtime, i == 0 ? PICTURE_CODING_TYPE_INTRA :
+			    PICTURE_CODING_TYPE_INTER, i, 0, &pict, &prev,
+			    &prevdec, NULL, &dec, &bs, NULL, NULL, &mvf);
+		t += bench_now() - t0;
+		bits += bs.ind;
+		db += bench_psnr(f, dec.y, w * h);
+		memcpy(prev.y, f, fs);
+		tmp = prevdec; prevdec = dec; dec = tmp;
+	}
+	r->fps = t > 0. ? nframe / t : 0.;
+	r->bits = bits / nframe;
+	r->psnr = db / nframe;
+
+	free(prev.y);
+	free(prevdec.y);
+	free(dec.y);
+	free(mvf.mx);
+	free(mvf.my);
+	free(mvf.mode);
+	free(bs.b);
+}
+
+static const char synopsis[] =
+	"h263bench [-n frames] [-q quant] "
+	"[-t codingtime] [-s wxh] [-m full|base|epzs] [-c] [file]\n";
+
+int main(int argc, char** argv)
+{
+	static const char* name[] = { "full", "base", "epzs" };
+	struct result r[3];
+	int nframe = 50;
+	int q = 10;
+	int codingtime = 3;
+	int w = CIF_WIDTH;
+	int h = CIF_HEIGHT;
+	int only = -1;
+	int fs, n, me, op;
+	Byte* seq;
+
+	SetSIMDSAD(1);
+	while ((op = getopt(argc, argv, "n:q:t:s:m:c")) != -1) {
+		switch (op) {
+		case 'n':
+			nframe = atoi(optarg);
+			break;
+		case 'q':
+			q = atoi(optarg);
+			break;
+		case 't':
+			codingtime = atoi(optarg);
+			break;
+		case 's':
+			if (!bench_size(optarg, &w, &h))
+				bench_usage(synopsis);
+			break;
+		case 'm':
+			for (only = 2; only >= 0; --only)
+				if (strcmp(optarg, name[only]) == 0)
+					break;
+			if (only < 0)
+				bench_usage(synopsis);
+			break;
+		case 'c':
+			SetSIMDSAD(0);
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind < argc - 1 || nframe < 2 || q < 1 || q > 31 ||
+	    w <= 0 || (w & 15) != 0 || h <= 0 || (h & 15) != 0)
+		bench_usage(synopsis);
+
+	fs = w * h * 3 / 2;
+	seq = (Byte*)malloc(nframe * fs);
+	if (optind < argc) {
+		FILE* f = fopen(argv[optind], "rb");
+		if (f == NULL) {
+			perror(argv[optind]);
+			exit(1);
+		}
+		n = fread(seq, fs, nframe, f);
+		fclose(f);
+		if (n < 2) {
+			fprintf(stderr, "h263bench: %s: need two frames\n",
+				argv[optind]);
+			exit(1);
+		}
+		nframe = n;
+	} else
+		for (n = 0; n < nframe; ++n)
+			synth(seq + n * fs, w, h, n);
+
+	printf("%dx%d, %d frames, q %d, codingtime %d, %s SAD\n", w, h,
+	       nframe, q, codingtime, simdSAD ? "sse2" : "c");
+	printf("%-6s %10s %10s %8s %10s %10s\n", "search", "frames/s",
+	       "bits/frm", "psnr", "d bits", "d psnr");
+	for (me = ME_FULL; me <= ME_EPZS; ++me) {
+		if (only >= 0 && me != only)
+			continue;
+		encode(me, seq, nframe, w, h, q, codingtime, &r[me]);
+		printf("%-6s %10.1f %10.0f %8.2f", name[me], r[me].fps,
+		       r[me].bits, r[me].psnr);
+		if (only < 0 && me != ME_FULL)
+			printf(" %+9.1f%% %+10.2f",
+			       100. * (r[me].bits - r[ME_FULL].bits) /
+			       r[ME_FULL].bits, r[me].psnr - r[ME_FULL].psnr);
+		printf("\n");
+	}
+	return (0);
+}
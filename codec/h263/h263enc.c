@@ -18,6 +18,10 @@
 /* Subsampling factor for SAD measurement */
 extern int subsampleSAD;
 
+/* Integer-pel motion search below TIME_FULLSEARCH_ME: ME_FULL, ME_BASE
+   or ME_EPZS */
+int motionSearch = ME_EPZS;
+
 /***********************************************************CommentBegin******
  *****************************************************************************
  *
@@ -1147,7 +1151,12 @@ int H263MbEncodePFrame(int mx, int my, int q, int codingTime, int forceIntra,
 	cost -= 100;	/* We prefer the zero vector */
       if (codingTime < TIME_FASTFULLPEL_MC)
 	ResetMVector(mb->mv[0]);
-      else if (codingTime < TIME_FULLSEARCH_ME) {
+      else if (codingTime < TIME_FULLSEARCH_ME && motionSearch == ME_EPZS) {
+	/* 'cost' above is for pv, not for the zero vector */
+	cost = EPZSFullPelMotionEstimationMB(mx, my, pict, prevPict, -1,
+					     me_lambda, mb->pv[0], mvField,
+					     mb->mv[0]);
+      } else if (codingTime < TIME_FULLSEARCH_ME && motionSearch == ME_BASE) {
 	mb->mv[0]->sx = 0;
 	mb->mv[0]->sy = 0;
 	cost = FastFullPelMotionEstimationMB(mx, my, pict, prevPict, cost,
@@ -4,6 +4,7 @@ extern void FdctFastByte(Byte *block, int w, int *coeff);
 extern void Fdct3coef(int *block, int *coeff);
 extern void Fdct3coefByte(Byte *block, int w, int *coeff);
 /* h263enc.c */
+extern int motionSearch;
 extern int EncodeH263(int rate, int codingTime, int type, int t, int percentIMBs, Picture *pict, Picture *prevPict, Picture *prevDecPict, unsigned char *crvec, Picture *decPict, Bitstr *bs, int *mbInd, int *mbQuant, MVField *mvField);
 extern int EncodeH263Q(int q, int codingTime, int type, int t, int percentIMBs, Picture *pict, Picture *prevPict, Picture *prevDecPict, unsigned char *crvec, Picture *decPict, Bitstr *bs, int *mbInd, int *mbQuant, MVField *mvField);
 extern int H263intraPictureEncode(int rate, int codingTime, int t, int gfid, Picture *pict, Picture *decPict, Bitstr *bs, int *mbInd, int *mbQuant, MVField *mvField);
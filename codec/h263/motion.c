@@ -648,95 +648,36 @@ int FullSearchFullPelME(int xPos, int yPos, int *minCost_p, int lambda,
 /***********************************************************CommentBegin******
  *****************************************************************************
  *
- * -- FastFullPelMotionEstimationMB -- Estimate quickly full pel mot. for a MB
- *
- * Author:             K.S.
- *
- * Created:            29-Dec-97
- *
- * Purpose:            Estimates the full pel motion vector for a macroblock
- *                     by using a fast search algorithm.
- * 
- * Arguments in:       int     xPos         x position of MB
- *                     int     yPos         y position of MB
- *                     Picture *pict        original picture to be coded.
- *                     Picture *refPict     reference picture.
- *                     int     cost0        cost for the 0 vector.
- *                                          If 'cost0 < 0', it is computed
- *                                          in this routine.
- *                     int lambda           lambda for rate-distortion search
- *                                          SAD + lambda * rate.
- *                     MVector *pv          predicted motion vector.
+ * -- DiamondSearchFullPelME -- Descend from mv to the best integer-pel match
  *
- * Arguments in/out:   MVector *mv          best motion vector.
- *                                          If no half pel motion vector with
- *                                          a SAD smaller than 'sadFP' is
- *                                          found, 'mv' is set to '0'.
+ * Purpose:            Moves 'mv' one pel at a time in the direction of
+ *                     the best of its four neighbours until none of them
+ *                     is better, and returns the cost there.
  *
- * Arguments out:      -
+ * Arguments in:       int     costMin      cost of 'mv'.
+ *                     int     dxMin, ...   allowed range of 'mv'.
+ *                     (others as in FastFullPelMotionEstimationMB)
  *
- * Return values:      int     cost         cost of best motion vector.
+ * Arguments in/out:   MVector *mv          start and end of the search.
  *
- * Example:            cost = FastFullPelMotionEstimationMB(i*16, j*16, pict,
- *                                                         prevPict, cost0,
- *                                                         lambda, pv, mv);
- *
- * Side effects:       -
- *
- * Description:        The search is done starting at 'pv' following the
- *                     direction of the best match.
- *                     See DA Baese: Bi Area Subsampled Estimation (BASE)
- *                     Algorithm.
- *
- * See also:           HalfPelMotionEstimationMB
- *
- * Modified:           -
+ * Description:        The search loop of FastFullPelMotionEstimationMB,
+ *                     shared with EPZSFullPelMotionEstimationMB.
+ *                     A neighbour is not tested again right after
+ *                     the step away from it.
  *
  *****************************************************************************/
-int FastFullPelMotionEstimationMB(int xPos, int yPos,
+static int DiamondSearchFullPelME(int xPos, int yPos,
 				  Picture *pict, Picture *refPict,
-				  int cost0, int lambda,
+				  int costMin, int lambda,
+				  int dxMin, int dxMax, int dyMin, int dyMax,
 				  MVector *pv, MVector *mv)
 /***********************************************************CommentEnd********/
 {
   int rate = 0;
-  int cost = INT_MAX, costMin = cost0;
-  int dxMin, dxMax, dyMin, dyMax;
+  int cost;
   int dir, prevDir = -1;  /* -1: invalid, 0: up, 3: right, 6: down, 9: left */
 
 
-  dxMin = MAX(-xPos, -16);
-  dxMax = MIN(pict->w - 16 - xPos, 15);
-  dyMin = MAX(-yPos, -16);
-  dyMax = MIN(pict->h - 16 - yPos, 15);
-
-  /* Compute SAD0 if necessary */
-  if (cost0 < 0) {
-    if (lambda != 0)
-      rate = lambda * GetMVDRate(pv, NULL);
-    cost0 = MacroBlockPictureSAD(xPos, yPos, pict, refPict, INT_MAX) + rate;
-  }
-
-  /* Compute SAD for predictor unless it is equal 0 and only if it is inside
-     the picture */
-  if (pv->x != 0 || pv->y != 0)
-    if (pv->x >= dxMin && pv->x <= dxMax && pv->y >= dyMin && pv->y <= dyMax) {
-      mv->x = pv->x;
-      mv->y = pv->y;
-      mv->sx = 0;
-      mv->sy = 0;
-      if (lambda != 0)
-	rate = lambda * GetMVDRate(pv, mv);
-      costMin = FPMotionMacroBlockPictureSAD(xPos, yPos, pict, refPict, pv,
-					     cost0 - rate) + rate;
-    }
-
-  if (cost0 <= costMin) {
-    ResetMVector(mv);
-    costMin = cost0;
-  }
-
-  /* Do search */
   do {
     dir = -1;
     /* right */
@@ -820,6 +761,265 @@ int FastFullPelMotionEstimationMB(int xPos, int yPos,
 }
 
 
+/***********************************************************CommentBegin******
+ *****************************************************************************
+ *
+ * -- FastFullPelMotionEstimationMB -- Estimate quickly full pel mot. for a MB
+ *
+ * Author:             K.S.
+ *
+ * Created:            29-Dec-97
+ *
+ * Purpose:            Estimates the full pel motion vector for a macroblock
+ *                     by using a fast search algorithm.
+ * 
+ * Arguments in:       int     xPos         x position of MB
+ *                     int     yPos         y position of MB
+ *                     Picture *pict        original picture to be coded.
+ *                     Picture *refPict     reference picture.
+ *                     int     cost0        cost for the 0 vector.
+ *                                          If 'cost0 < 0', it is computed
+ *                                          in this routine.
+ *                     int lambda           lambda for rate-distortion search
+ *                                          SAD + lambda * rate.
+ *                     MVector *pv          predicted motion vector.
+ *
+ * Arguments in/out:   MVector *mv          best motion vector.
+ *                                          If no half pel motion vector with
+ *                                          a SAD smaller than 'sadFP' is
+ *                                          found, 'mv' is set to '0'.
+ *
+ * Arguments out:      -
+ *
+ * Return values:      int     cost         cost of best motion vector.
+ *
+ * Example:            cost = FastFullPelMotionEstimationMB(i*16, j*16, pict,
+ *                                                         prevPict, cost0,
+ *                                                         lambda, pv, mv);
+ *
+ * Side effects:       -
+ *
+ * Description:        The search is done starting at 'pv' following the
+ *                     direction of the best match.
+ *                     See DA Baese: Bi Area Subsampled Estimation (BASE)
+ *                     Algorithm.
+ *
+ * See also:           HalfPelMotionEstimationMB
+ *
+ * Modified:           -
+ *
+ *****************************************************************************/
+int FastFullPelMotionEstimationMB(int xPos, int yPos,
+				  Picture *pict, Picture *refPict,
+				  int cost0, int lambda,
+				  MVector *pv, MVector *mv)
+/***********************************************************CommentEnd********/
+{
+  int rate = 0;
+  int costMin = cost0;
+  int dxMin, dxMax, dyMin, dyMax;
+
+
+  dxMin = MAX(-xPos, -16);
+  dxMax = MIN(pict->w - 16 - xPos, 15);
+  dyMin = MAX(-yPos, -16);
+  dyMax = MIN(pict->h - 16 - yPos, 15);
+
+  /* Compute SAD0 if necessary */
+  if (cost0 < 0) {
+    if (lambda != 0)
+      rate = lambda * GetMVDRate(pv, NULL);
+    cost0 = MacroBlockPictureSAD(xPos, yPos, pict, refPict, INT_MAX) + rate;
+  }
+
+  /* Compute SAD for predictor unless it is equal 0 and only if it is inside
+     the picture */
+  if (pv->x != 0 || pv->y != 0)
+    if (pv->x >= dxMin && pv->x <= dxMax && pv->y >= dyMin && pv->y <= dyMax) {
+      mv->x = pv->x;
+      mv->y = pv->y;
+      mv->sx = 0;
+      mv->sy = 0;
+      if (lambda != 0)
+	rate = lambda * GetMVDRate(pv, mv);
+      costMin = FPMotionMacroBlockPictureSAD(xPos, yPos, pict, refPict, pv,
+					     cost0 - rate) + rate;
+    }
+
+  if (cost0 <= costMin) {
+    ResetMVector(mv);
+    costMin = cost0;
+  }
+
+  /* Do search */
+  costMin = DiamondSearchFullPelME(xPos, yPos, pict, refPict, costMin,
+				   lambda, dxMin, dxMax, dyMin, dyMax, pv, mv);
+
+  return(costMin);
+}
+
+
+/*
+ * Early termination thresholds for EPZSFullPelMotionEstimationMB,
+ * in units of the cost (SAD + lambda * rate) of a macroblock: stop
+ * if the zero vector, or later the best predictor, costs less.
+ */
+#define EPZS_STOP_ZERO        256
+#define EPZS_STOP_PRED        512
+
+/* Most candidate vectors tested before the diamond search */
+#define EPZS_MAX_CAND         7
+
+
+/***********************************************************CommentBegin******
+ *****************************************************************************
+ *
+ * -- EPZSFullPelMotionEstimationMB -- Predictive zonal full pel search
+ *
+ * Purpose:            Estimates the full pel motion vector for a macroblock
+ *                     from the vectors of its neighbours in this and the
+ *                     previous picture.
+ * 
+ * Arguments in:       int     xPos         x position of MB
+ *                     int     yPos         y position of MB
+ *                     Picture *pict        original picture to be coded.
+ *                     Picture *refPict     reference picture.
+ *                     int     cost0        cost for the 0 vector.
+ *                                          If 'cost0 < 0', it is computed
+ *                                          in this routine.
+ *                     int lambda           lambda for rate-distortion search
+ *                                          SAD + lambda * rate.
+ *                     MVector *pv          predicted motion vector.
+ *                     MVField *mvf         motion vectors (half pel) of the
+ *                                          MBs coded so far in this picture
+ *                                          and of the rest in the previous
+ *                                          one, or NULL.
+ *
+ * Arguments in/out:   -
+ *
+ * Arguments out:      MVector *mv          best motion vector.
+ *
+ * Return values:      int     cost         cost of best motion vector.
+ *
+ * Example:            cost = EPZSFullPelMotionEstimationMB(i*16, j*16, pict,
+ *                                                          prevPict, -1,
+ *                                                          lambda, pv, mvf,
+ *                                                          mv);
+ *
+ * Side effects:       -
+ *
+ * Description:        Tests the zero vector, then 'pv', the vectors above
+ *                     and above right in this picture, and the vectors
+ *                     here, to the right and below in the previous
+ *                     picture, then descends from the best of them as
+ *                     in FastFullPelMotionEstimationMB.  Stops early
+ *                     when the zero vector or the best candidate is
+ *                     already cheap enough (EPZS_STOP_ZERO, _PRED).
+ *                     See A.M. Tourapis: Enhanced Predictive Zonal
+ *                     Search for Single and Multiple Frame Motion
+ *                     Estimation.
+ *
+ * See also:           FastFullPelMotionEstimationMB, FullSearchFullPelME
+ *
+ * Modified:           -
+ *
+ *****************************************************************************/
+int EPZSFullPelMotionEstimationMB(int xPos, int yPos,
+				  Picture *pict, Picture *refPict,
+				  int cost0, int lambda,
+				  MVector *pv, MVField *mvf, MVector *mv)
+/***********************************************************CommentEnd********/
+{
+  int rate = 0;
+  int cost, costMin;
+  int dxMin, dxMax, dyMin, dyMax;
+  int cand[EPZS_MAX_CAND][2];
+  int nCand = 0;
+  int bestX = 0, bestY = 0;
+  int mbw = pict->w / MACROBLOCK_SIZE;
+  int mn, i, j;
+
+
+  dxMin = MAX(-xPos, -16);
+  dxMax = MIN(pict->w - 16 - xPos, 15);
+  dyMin = MAX(-yPos, -16);
+  dyMax = MIN(pict->h - 16 - yPos, 15);
+
+  /* Zero vector */
+  ResetMVector(mv);
+  if (cost0 < 0) {
+    if (lambda != 0)
+      rate = lambda * GetMVDRate(pv, NULL);
+    cost0 = MacroBlockPictureSAD(xPos, yPos, pict, refPict, INT_MAX) + rate;
+  }
+  costMin = cost0;
+  if (costMin < EPZS_STOP_ZERO)
+    return(costMin);
+
+  /* Collect the candidates */
+  cand[nCand][0] = pv->x;
+  cand[nCand++][1] = pv->y;
+  if (mvf != NULL) {
+    /* same indexing as H263MbEncodePFrame */
+    mn = xPos / MACROBLOCK_SIZE + (yPos / MACROBLOCK_SIZE) * mbw;
+    if (yPos > 0) {
+      /* above and above right, this picture */
+      cand[nCand][0] = mvf->mx[mn - mbw] / 2;
+      cand[nCand++][1] = mvf->my[mn - mbw] / 2;
+      if (xPos + MACROBLOCK_SIZE < pict->w) {
+	cand[nCand][0] = mvf->mx[mn - mbw + 1] / 2;
+	cand[nCand++][1] = mvf->my[mn - mbw + 1] / 2;
+      }
+    }
+    /* here, right and below, previous picture */
+    cand[nCand][0] = mvf->mx[mn] / 2;
+    cand[nCand++][1] = mvf->my[mn] / 2;
+    if (xPos + MACROBLOCK_SIZE < pict->w) {
+      cand[nCand][0] = mvf->mx[mn + 1] / 2;
+      cand[nCand++][1] = mvf->my[mn + 1] / 2;
+    }
+    if (yPos + MACROBLOCK_SIZE < pict->h) {
+      cand[nCand][0] = mvf->mx[mn + mbw] / 2;
+      cand[nCand++][1] = mvf->my[mn + mbw] / 2;
+    }
+  }
+
+  /* Test each candidate that is inside and new */
+  for (i = 0; i < nCand; ++i) {
+    mv->x = cand[i][0];
+    mv->y = cand[i][1];
+    if (mv->x < dxMin || mv->x > dxMax || mv->y < dyMin || mv->y > dyMax)
+      continue;
+    if (mv->x == 0 && mv->y == 0)
+      continue;
+    for (j = 0; j < i; ++j)
+      if (cand[j][0] == mv->x && cand[j][1] == mv->y)
+	break;
+    if (j < i)
+      continue;
+    if (lambda != 0)
+      rate = lambda * GetMVDRate(pv, mv);
+    cost = FPMotionMacroBlockPictureSAD(xPos, yPos, pict, refPict, mv,
+					costMin - rate) + rate;
+    if (cost < costMin) {
+      costMin = cost;
+      bestX = mv->x;
+      bestY = mv->y;
+    }
+  }
+  mv->x = bestX;
+  mv->y = bestY;
+  if (costMin < EPZS_STOP_PRED)
+    return(costMin);
+
+  /* Refine */
+  costMin = DiamondSearchFullPelME(xPos, yPos, pict, refPict, costMin,
+				   lambda, dxMin, dxMax, dyMin, dyMax, pv, mv);
+
+  return(costMin);
+}
+
+
 
 /***********************************************************CommentBegin******
  *****************************************************************************
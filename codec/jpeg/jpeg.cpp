@@ -87,7 +87,7 @@ class JpegDCTDecoder_422 : public JpegDCTDecoder {
 };
 
 JpegPixelDecoder::JpegPixelDecoder(const config &c, int dec, int ow, int oh)
-		 :JpegDecoder(c, dec, ow, oh)
+		 :JpegDecoder(c, dec, ow, oh), scale_(0)
 {
 	int ns = NCC * owidth_ * oheight_ / 64;	// # blocks
 	cache_ = new short[ns];
@@ -105,6 +105,17 @@ JpegPixelDecoder::~JpegPixelDecoder()
 	delete[] frm_; //SV-XXX: Debian
 }
 
+void JpegPixelDecoder::scale(int s)
+{
+	if (s == scale_)
+		return;
+	scale_ = s;
+	/* gray, and every block over the threshold */
+	int n = decimation_ == 420 ? osize_ + osize_ / 2 : 2 * osize_;
+	memset(frm_, 0x80, n);
+	memset(cache_, 0x7f, NCC * owidth_ * oheight_ / 64 * sizeof(*cache_));
+}
+
 JpegDCTDecoder::JpegDCTDecoder(const config& c, int dec, int ow, int oh)
 	       :JpegDecoder(c, dec, ow, oh)
 {
@@ -910,6 +921,8 @@ int JpegDecoder_422::decode(const u_char* in, int len, u_char *marks, int mark)
 		inb_ = parseJFIF(inb_);
 
 	huffreset();
+	if (scale_ != 0)
+		return (decode_reduced(marks, mark));
 
 	int q0 = comp_[0].qno;
 	int q1 = comp_[1].qno;
@@ -935,6 +948,14 @@ int JpegDecoder_422::decode(const u_char* in, int len, u_char *marks, int mark)
 			cache += m.marklskip * NCC;
 		}
 		for (int x = 0; x < ncol_; ++x) {
+			/*
+			 * If we're handling restart markers,
+			 * check if we need to resync.
+			 */
+			if (rlen_ != 0 && --rcnt_ <= 0) {
+				rcnt_ = rlen_;
+				restart();
+			}
 			if (ycrop || x < lcrop_ || x >= rcrop_) {
 				(void)huffskip(comp_[0]);
 				(void)huffskip(comp_[0]);	
@@ -944,14 +965,6 @@ int JpegDecoder_422::decode(const u_char* in, int len, u_char *marks, int mark)
 			}
 
 			MASK_DECL;
-			/*
-			 * If we're handling restart markers,
-			 * check if we need to resync.
-			 */
-			if (rlen_ != 0 && --rcnt_ <= 0) {
-				rcnt_ = rlen_;
-				restart();
-			}
 
 			int nc = huffparse(comp_[0], blk, cache, MASK_REF);
 			int dontskip = nc;
@@ -1062,6 +1075,14 @@ int JpegDCTDecoder_422::decode(const u_char* in, int len, u_char *marks,
 			lastoff = fp;
 			for (int x = 0; x < ncol_; ++x) {
 				/* processing for one 4.2.2 mcu */
+				/*
+				 * If we're handling restart markers,
+				 * check if we need to resync.
+				 */
+				if (rlen_ != 0 && --rcnt_ <= 0) {
+					rcnt_ = rlen_;
+					restart();
+				}
 				if (ycrop || x < lcrop_ || x >= rcrop_) {
 					/* Y Y U V */
 					(void)huffskip(comp_[0]);
@@ -1072,14 +1093,6 @@ int JpegDCTDecoder_422::decode(const u_char* in, int len, u_char *marks,
 				}
 
 				MASK_DECL;
-				/*
-				 * If we're handling restart markers,
-				 * check if we need to resync.
-				 */
-				if (rlen_ != 0 && --rcnt_ <= 0) {
-					rcnt_ = rlen_;
-					restart();
-				}
 
 				/* Y's for even lines */
 				int nc = huffparse(comp_[0], fp,
@@ -1117,6 +1130,14 @@ int JpegDCTDecoder_422::decode(const u_char* in, int len, u_char *marks,
 		} else {
 			for (int x = 0; x < ncol_; ++x) {
 				/* processing for one column */
+				/*
+				 * If we're handling restart markers,
+				 * check if we need to resync.
+				 */
+				if (rlen_ != 0 && --rcnt_ <= 0) {
+					rcnt_ = rlen_;
+					restart();
+				}
 				if (ycrop || x < lcrop_ || x >= rcrop_) {
 					/* Y Y U V */
 					(void)huffskip(comp_[0]);
@@ -1127,14 +1148,6 @@ int JpegDCTDecoder_422::decode(const u_char* in, int len, u_char *marks,
 				}
 
 				MASK_DECL;
-				/*
-				 * If we're handling restart markers,
-				 * check if we need to resync.
-				 */
-				if (rlen_ != 0 && --rcnt_ <= 0) {
-					rcnt_ = rlen_;
-					restart();
-				}
 
 				/* Y's for odd lines */
 				int nc = huffparse(comp_[0], lastoff + 128,
@@ -1193,6 +1206,8 @@ int JpegDecoder_420::decode(const u_char* in, int len, u_char *marks, int mark)
 		inb_ = parseJFIF(inb_);
 
 	huffreset();
+	if (scale_ != 0)
+		return (decode_reduced(marks, mark));
 	int q0 = comp_[0].qno;
 	int q1 = comp_[1].qno;
 	u_char* yp = frm_;
@@ -1219,6 +1234,14 @@ int JpegDecoder_420::decode(const u_char* in, int len, u_char *marks, int mark)
 			cache += m.marklskip * 2 * NCC;
 		}
 		for (int x = 0; x < ncol_; ++x) {
+			/*
+			 * If we're handling restart markers,
+			 * check if we need to resync.
+			 */
+			if (rlen_ != 0 && --rcnt_ <= 0) {
+				rcnt_ = rlen_;
+				restart();
+			}
 			if (ycrop || x < lcrop_ || x >= rcrop_) {	
 				(void)huffskip(comp_[0]);
 				(void)huffskip(comp_[0]);	
@@ -1229,14 +1252,6 @@ int JpegDecoder_420::decode(const u_char* in, int len, u_char *marks, int mark)
 				continue;
 			}
 			MASK_DECL;
-			/*
-			 * If we're handling restart markers,
-			 * check if we need to resync.
-			 */
-			if (rlen_ != 0 && --rcnt_ <= 0) {
-				rcnt_ = rlen_;
-				restart();
-			}
 			int nc = huffparse(comp_[0], blk, cache, MASK_REF);
 			cache += NCC;
 			int dontskip = nc;
@@ -1311,6 +1326,117 @@ int JpegDecoder_420::decode(const u_char* in, int len, u_char *marks, int mark)
 }
 
 
+#ifdef INT_64
+#define MASK_LOW	u_int(m0)
+#else
+#define MASK_LOW	mask[0]
+#endif
+
+/*
+ * The rest of decode() when decoding smaller (see scale()): the same
+ * walk over the MCUs for either decimation, with each block put out
+ * 8 >> scale_ pixels on a side by rdct_down().  The image is
+ * owidth_ >> scale_ wide, and the marks are of its 8x8 blocks.
+ */
+int JpegPixelDecoder::decode_reduced(u_char* marks, int mark)
+{
+	int s = scale_;
+	int b = 8 >> s;
+	int ow = owidth_ >> s;
+	int cw = ow >> 1;
+	/* Y blocks down an MCU */
+	int vb = decimation_ == 420 ? 2 : 1;
+	const int* q0 = qt_[comp_[0].qno];
+	const int* q1 = qt_[comp_[1].qno];
+	u_char* yp = frm_;
+	u_char* up = yp + (osize_ >> (2 * s));
+	u_char* vp = up + (osize_ >> (2 * s)) / (2 * vb);
+	short* cache = cache_;
+	short blk[64];
+	margin& m = margin_;
+	int ylskip = m.left >> s;
+	int uvlskip = m.left >> (s + 1);
+	int yrskip = m.right >> s;
+	int uvrskip = m.right >> (s + 1);
+
+	/* Skip top */
+	yp += (m.top >> s) * ow;
+	up += (m.top >> s) * ow / (2 * vb);
+	vp += (m.top >> s) * ow / (2 * vb);
+	cache += m.marktopskip * NCC;
+
+	for (int y = 0; y < nrow_; ++y) {
+		int ycrop = (y < topcrop_ || y >= botcrop_);
+		if (!ycrop) {
+			yp += ylskip;
+			up += uvlskip;
+			vp += uvlskip;
+			cache += m.marklskip * vb * NCC;
+		}
+		for (int x = 0; x < ncol_; ++x) {
+			if (rlen_ != 0 && --rcnt_ <= 0) {
+				rcnt_ = rlen_;
+				restart();
+			}
+			if (ycrop || x < lcrop_ || x >= rcrop_) {
+				for (int k = 2 * vb; --k >= 0; )
+					(void)huffskip(comp_[0]);
+				(void)huffskip(comp_[1]);
+				(void)huffskip(comp_[2]);
+				continue;
+			}
+			MASK_DECL;
+			int dontskip = 0;
+			for (int k = 0; k < 2 * vb; ++k) {
+				int nc = huffparse(comp_[0], blk, cache,
+						   MASK_REF, dontskip);
+				cache += NCC;
+				dontskip |= nc;
+				if (nc != 0)
+					rdct_down(s, blk, MASK_LOW, q0, 128,
+						  yp + (k >> 1) * b * ow +
+						  (k & 1) * b, ow, 0);
+			}
+			if (color_ && dontskip) {
+				short dummy[6];
+				int nc = huffparse(comp_[1], blk, dummy,
+						   MASK_REF, 1);
+				if (nc != 0)
+					rdct_down(s, blk, MASK_LOW, q1, 128,
+						  up, cw, 0);
+				nc = huffparse(comp_[2], blk, dummy,
+					       MASK_REF, 1);
+				if (nc != 0)
+					rdct_down(s, blk, MASK_LOW, q1, 128,
+						  vp, cw, 0);
+			} else {
+				(void)huffskip(comp_[1]);
+				(void)huffskip(comp_[2]);
+			}
+			if (dontskip) {
+				int off = yp - frm_;
+				marks[(off / ow >> 3) * (ow >> 3) +
+				      (off % ow >> 3)] = mark;
+				ndblk_ += 2 * vb;
+			}
+			yp += 2 * b;
+			up += b;
+			vp += b;
+		}
+		if (!ycrop) {
+			yp += yrskip;
+			up += uvrskip;
+			vp += uvrskip;
+			cache += m.markrskip * vb * NCC;
+
+			yp += (vb * b - 1) * ow;
+			up += (b - 1) * cw;
+			vp += (b - 1) * cw;
+		}
+	}
+	return (0);
+}
+
 //
 // decode only to DCT not pixels (i.e. don't to rdct step)
 // output is stored interleaved 4 Y's followed by 1 U and 1 V block
@@ -1347,6 +1473,14 @@ int JpegDCTDecoder_420::decode(const u_char* in, int len, u_char *marks, int mar
 			fp += m.flskip;
 		}
 		for (int x = 0; x < ncol_; ++x) {
+			/*
+			 * If we're handling restart markers,
+			 * check if we need to resync.
+			 */
+			if (rlen_ != 0 && --rcnt_ <= 0) {
+				rcnt_ = rlen_;
+				restart();
+			}
 			if (ycrop || x < lcrop_ || x >= rcrop_) {	
 				(void)huffskip(comp_[0]);
 				(void)huffskip(comp_[0]);	
@@ -1357,14 +1491,6 @@ int JpegDCTDecoder_420::decode(const u_char* in, int len, u_char *marks, int mar
 				continue;
 			}
 			MASK_DECL;
-			/*
-			 * If we're handling restart markers,
-			 * check if we need to resync.
-			 */
-			if (rlen_ != 0 && --rcnt_ <= 0) {
-				rcnt_ = rlen_;
-				restart();
-			}
 
 			/*
 			 * decode the 4 Y blocks
@@ -1436,59 +1562,27 @@ huff_EXTEND(int x, int s)
 #endif
 
 /*
- * Read the next 16 bits off the bit string into the bit buffer.
- * Skip over zero-stuffed ff's but make no attempt to verify
- * that they aren't some other marker (which shouldn't be in the
- * middle of a block anyway).
+ * The bit buffer is filled 32 bits at a time (bitio.h), skipping
+ * zero-stuffed ff's and stopping at a marker.
  */
-#define HUFFRQ(bb) \
- { \
-	register int v; \
-	register const u_char *cp = inb_; \
- \
-	bb <<= 16; \
-	v = *cp++; \
-	if (v == 0xff) ++cp; \
-	bb |= v << 8; \
-	v = *cp++; \
-	if (v == 0xff) ++cp; \
-	bb |= v; \
-	inb_ = cp; \
- \
-}
-
-#define MASK(s) ((1 << (s)) - 1)
-
 #define HUFF_DECODE(ht, nbb, bb, result) { \
-	register int s_, v_; \
+	int s_, v_; \
  \
-	if (nbb < 16) { \
-		HUFFRQ(bb); \
-		nbb += 16; \
-	} \
-	v_ = (bb >> (nbb - 16)) & 0xffff; \
+	if (nbb < 16) \
+		BITS_FILL_FF(inb_, nbb, bb); \
+	v_ = (int)(bb >> (nbb - 16)) & 0xffff; \
 	s_ = (ht)[v_]; \
 	nbb -= (s_ >> 8); \
 	result = s_ & 0xff; \
  }
 
-#define GET_BITS(n, nbb, bb, result) \
-{ \
-	nbb -= n; \
-	if (nbb < 0)  { \
-		HUFFRQ(bb); \
-		nbb += 16; \
-	} \
-	(result) = ((bb >> nbb) & MASK(n)); \
-}
+#define GET_BITS(n, nbb, bb, result) BITS_GET_FF(inb_, n, nbb, bb, result)
 
 #define SKIP_BITS(n, nbb, bb) \
 { \
 	nbb -= n; \
-	if (nbb < 0)  { \
-		HUFFRQ(bb); \
-		nbb += 16; \
-	} \
+	if (nbb < 0) \
+		BITS_FILL_FF(inb_, nbb, bb); \
 }
 
 int JpegDecoder::huffdc(component& p)
@@ -1496,7 +1590,7 @@ int JpegDecoder::huffdc(component& p)
 	/* Decode a single block's worth of coefficients */
 		
 	/* Section F.2.2.1: decode the DC coefficient difference */
-	register int bb = bb_;
+	bitbuf bb = bb_;
 	register int nbb = nbb_;
 	u_short* ht = dcht_[p.dc_tbl_no];
 	register int s, r;
@@ -1555,7 +1649,7 @@ int JpegDCTDecoder::huffparse(component& p, short* out,
 			   u_int* mask, const int *quant_table, int dontskip)
 #endif
 {
-	register int bb = bb_;
+	bitbuf bb = bb_;
 	register int nbb = nbb_;
 	u_short* ht = dcht_[p.dc_tbl_no];
 	register int s, r;
@@ -1719,7 +1813,7 @@ int JpegPixelDecoder::huffparse(component& p, short* out, short* ref,
 			   u_int* mask, int dontskip)
 #endif
 {
-	register int bb = bb_;
+	bitbuf bb = bb_;
 	register int nbb = nbb_;
 	u_short* ht = dcht_[p.dc_tbl_no];
 	register int s, r;
@@ -1872,7 +1966,7 @@ int JpegPixelDecoder::huffparse(component& p, short* out, short* ref,
  */
 int JpegDecoder::huffskip(component& p)
 {
-	register int bb = bb_;
+	bitbuf bb = bb_;
 	register int nbb = nbb_;
 	u_short* ht = dcht_[p.dc_tbl_no];
 	register int s;
@@ -1913,6 +2007,8 @@ int JpegDecoder::huffskip(component& p)
 void JpegDecoder::huffreset()
 {
 	nbb_ = 0;
+	/* the first restart marker follows the first interval */
+	rcnt_ = rlen_ + 1;
 	comp_[0].dc = 0;
 	comp_[1].dc = 0;
 	comp_[2].dc = 0;
@@ -38,6 +38,7 @@
 #include <sys/param.h>
 #endif
 #include <sys/types.h>
+#include "bitio.h"
 
 /*XXX*/
 #define NUM_HUFF_TBLS       4	/* Huffman tables are numbered 0..3 */
@@ -108,6 +109,8 @@ public:
 	inline int decimation() const { return (decimation_); }
 	inline void thresh(int v) { thresh_ = v; }
 	inline void cthresh(int v) { cthresh_ = v; }
+	/* MCUs between restart markers, when it's not in a DRI */
+	inline void restart_interval(int n) { rlen_ = n; }
 	inline void resetndblk() { ndblk_ = 0; }
 	inline int ndblk() const { return (ndblk_); }
 protected:
@@ -131,9 +134,9 @@ protected:
 #endif
 	int compute_margins(int, int);
 	void idlefill(void);
-	const u_char *inb_;		/* input buffer XXX make u_long */
+	const u_char *inb_;		/* input buffer */
 	const u_char *end_;
-	u_int bb_;		/* bit buffer */
+	bitbuf bb_;		/* bit buffer (bitio.h) */
 	int nbb_;		/* # bits in bit buffer */
 	int ndblk_;	/* # blks decoded for this frame */
 	const u_char* parseJFIF(const u_char*);
@@ -199,7 +202,15 @@ public:
 	~JpegPixelDecoder();
 	static JpegPixelDecoder* create(const config&, int, int);
 	inline u_char* frame(void) const { return (frm_); }
+	/*
+	 * Decode at 1 / (1 << s) of the output size (s is 0, 1 or 2),
+	 * from the low order coefficients of each block; frame() is
+	 * then that size.  The next frame is decoded whole.
+	 */
+	void scale(int s);
 protected:
+	int decode_reduced(u_char* marks, int mark);
+	int scale_;
 #ifdef INT_64
 	int huffparse(component&, short* out, short* ref, INT_64* mask,
 		      int dontskip = 0);
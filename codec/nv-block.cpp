@@ -0,0 +1,1686 @@
+/*
+ * This module was originally derived from:
+ *
+ * Netvideo version 3.2
+ * Written by Ron Frederick <frederick@parc.xerox.com>
+ *
+ * Block transforms and run-length coding for the nv format
+ *
+ * Copyright (c) Xerox Corporation 1992. All rights reserved.
+ *  
+ * License is granted to copy, to use, and to make and to use derivative
+ * works for research and evaluation purposes, provided that Xerox is
+ * acknowledged in all documentation pertaining to any such copy or derivative
+ * work. Xerox grants no other licenses expressed or implied. The Xerox trade
+ * name should not be used in any advertising without its written permission.
+ *  
+ * XEROX CORPORATION MAKES NO REPRESENTATIONS CONCERNING EITHER THE
+ * MERCHANTABILITY OF THIS SOFTWARE OR THE SUITABILITY OF THIS SOFTWARE
+ * FOR ANY PARTICULAR PURPOSE.  The software is provided "as is" without
+ * express or implied warranty of any kind.
+ *  
+ * These notices must be retained in any copies of any part of this software.
+ */
+
+static const char rcsid[] =
+    "@(#) $Header$ (LBL)";
+
+#include <string.h>
+#include "inet.h"
+#include "nv-block.h"
+
+/*
+ * SSE2 versions of the transforms.  On gcc these are compiled for
+ * SSE2 even when the rest of the file isn't, and are only called
+ * if the cpu turns out to have it (see nv_simd()).
+ */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define NV_SSE2 __attribute__((target("sse2")))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define NV_SSE2
+#endif
+
+#ifdef NV_SSE2
+#include <emmintrin.h>
+#ifdef RUNTIME_CPUDETECT
+extern "C" {
+#include "cpu/cpudetect.h"
+}
+#endif
+#endif
+
+static int simd_ = -1;
+
+void nv_simd(int on)
+{
+	simd_ = 0;
+#ifdef NV_SSE2
+	if (on) {
+#ifdef RUNTIME_CPUDETECT
+		simd_ = (cpu_check() & FF_CPU_SSE2) != 0;
+#elif defined(__SSE2__) || defined(_M_X64)
+		simd_ = 1;
+#endif
+	}
+#else
+	UNUSED(on);
+#endif
+}
+
+int nv_simd()
+{
+	if (simd_ < 0)
+		nv_simd(1);
+	return (simd_);
+}
+
+/* Sick little macro which will limit x to [0..255] with logical ops */
+#define UCLIMIT(x) ((t = (x)), (t &= ~(t>>31)), (t | ~((t-256) >> 31)))
+/* A variant of above which will limit x to [-128..127] */
+#define SCLIMIT(x) (UCLIMIT((x)+128)-128)
+
+/*
+ * Haar transform the block, the way nv expects it
+ * (i.e., interleaved u,v)
+ */
+static void fwd_haar_c(const u_char *yp, const u_char *up, const u_char* vp,
+		       int stride, u_int32_t *out)
+{
+    register int i, t0, t1, t2, t3, t4, t5, *dataptr;
+    register int stride2=2*stride, stride6=6*stride;
+    register char *outcptr = (char *)out;
+    static int block[64];
+
+    dataptr = block;
+    for (i=0; i<8; i++) {
+	t0 = yp[0];
+	t1 = yp[stride];
+	t2 = t0 + t1;
+	dataptr[32] = (t1 - t0) << 2;
+	yp += stride2;
+
+	t0 = yp[0];
+	t1 = yp[stride];
+	t3 = t0 + t1;
+	dataptr[40] = (t1 - t0) << 2;
+	yp += stride2;
+
+	t0 = yp[0];
+	t1 = yp[stride];
+	t4 = t0 + t1;
+	dataptr[48] = (t1 - t0) << 2;
+	yp += stride2;
+
+	t0 = yp[0];
+	t1 = yp[stride];
+	t5 = t0 + t1;
+	dataptr[56] = (t1 - t0) << 2;
+	yp -= stride6;
+
+	t0 = t2 + t3;
+	t1 = t4 + t5;
+	dataptr[0]  = t0 + t1 - 1024; /* Correct for DC offset */
+	dataptr[8]  = t1 - t0;
+	dataptr[16] = (t3 - t2) << 1;
+	dataptr[24] = (t5 - t4) << 1;
+
+	yp++;
+	dataptr++;
+    }
+
+    dataptr = block;
+    for (i=0; i<8; i++) {
+	t0 = dataptr[0];
+	t1 = dataptr[1];
+	t2 = t0 + t1;
+	outcptr[4] = (t1 - t0 + 7) >> 4;
+
+	t0 = dataptr[2];
+	t1 = dataptr[3];
+	t3 = t0 + t1;
+	outcptr[5] = (t1 - t0 + 7) >> 4;
+
+	t0 = dataptr[4];
+	t1 = dataptr[5];
+	t4 = t0 + t1;
+	outcptr[6] = (t1 - t0 + 7) >> 4;
+
+	t0 = dataptr[6];
+	t1 = dataptr[7];
+	t5 = t0 + t1;
+	outcptr[7] = (t1 - t0 + 7) >> 4;
+
+	t0 = t2 + t3;
+	t1 = t4 + t5;
+	outcptr[0] = (t0 + t1 + 31) >> 6;
+	outcptr[1] = (t1 - t0 + 31) >> 6;
+	outcptr[2] = (t3 - t2 + 15) >> 5;
+	outcptr[3] = (t5 - t4 + 15) >> 5;
+
+	dataptr += 8;
+	outcptr += 8;
+    }
+
+    if (up != 0) {
+	stride >>= 1;
+	stride2 >>= 1;
+	stride6 >>= 1;
+
+        int uswitch = 1;
+	const u_char* p = up++;
+	dataptr = block;
+	for (i=0; i<8; i++) {
+	    t0 = p[0] - 0x80;
+	    t1 = p[stride] - 0x80;
+	    t2 = t0 + t1;
+	    dataptr[32] = (t1 - t0) << 2;
+	    p += stride2;
+
+	    t0 = p[0] - 0x80;
+	    t1 = p[stride] - 0x80;
+	    t3 = t0 + t1;
+	    dataptr[40] = (t1 - t0) << 2;
+	    p += stride2;
+
+	    t0 = p[0] - 0x80;
+	    t1 = p[stride] - 0x80;
+	    t4 = t0 + t1;
+	    dataptr[48] = (t1 - t0) << 2;
+	    p += stride2;
+
+	    t0 = p[0] - 0x80;
+	    t1 = p[stride] - 0x80;
+	    t5 = t0 + t1;
+	    dataptr[56] = (t1 - t0) << 2;
+	    p -= stride6;
+
+	    t0 = t2 + t3;
+	    t1 = t4 + t5;
+	    dataptr[0]  = t0 + t1;
+	    dataptr[8]  = t1 - t0;
+	    dataptr[16] = (t3 - t2) << 1;
+	    dataptr[24] = (t5 - t4) << 1;
+
+	    if (uswitch) {
+		    uswitch = 0;
+		    p = vp++;
+	    } else {
+		    uswitch = 1;
+		    p = up++;
+	    }
+	    dataptr++;
+        }
+
+	dataptr = block;
+	for (i=0; i<8; i++) {
+	    t0 = dataptr[0];
+	    t1 = dataptr[2];
+	    t2 = t0 + t1;
+	    outcptr[4] = (t1 - t0 + 7) >> 4;
+
+	    t0 = dataptr[4];
+	    t1 = dataptr[6];
+	    t3 = t0 + t1;
+	    outcptr[5] = (t1 - t0 + 7) >> 4;
+
+	    t0 = dataptr[1];
+	    t1 = dataptr[3];
+	    t4 = t0 + t1;
+	    outcptr[6] = (t1 - t0 + 7) >> 4;
+
+	    t0 = dataptr[5];
+	    t1 = dataptr[7];
+	    t5 = t0 + t1;
+	    outcptr[7] = (t1 - t0 + 7) >> 4;
+
+	    outcptr[0] = (t2 + t3 + 15) >> 5;
+	    outcptr[1] = (t4 + t5 + 15) >> 5;
+	    outcptr[2] = (t3 - t2 + 15) >> 5;
+	    outcptr[3] = (t5 - t4 + 15) >> 5;
+
+	    dataptr += 8;
+	    outcptr += 8;
+	}
+    }
+}
+
+static void fwd_dct_c(const u_int8_t *yp, const u_int8_t *up,
+		      const u_int8_t* vp, int width, u_int32_t *out)
+{
+    int i, t0, t1, *dataptr;
+    int a0, a1, a2, a3, b0, b1, b2, b3, c0, c1, c2, c3;
+    int8_t *outcptr=(int8_t *)out;
+    static int block[64];
+
+    dataptr = block;
+    for (i=0; i<8; i++) {
+	t0 = yp[0];
+	t1 = yp[7*width];
+	a0 = t0+t1;
+	c3 = t0-t1;
+	yp += width;
+
+	t0 = yp[0];
+	t1 = yp[5*width];
+	a1 = t0+t1;
+	c2 = t0-t1;
+	yp += width;
+
+	t0 = yp[0];
+	t1 = yp[3*width];
+	a2 = t0+t1;
+	c1 = t0-t1;
+	yp += width;
+
+	t0 = yp[0];
+	t1 = yp[width];
+	a3 = t0+t1;
+	c0 = t0-t1;
+	yp -= 3*width;
+
+	b0 = a0+a3;
+	b1 = a1+a2;
+	b2 = a1-a2;
+	b3 = a0-a3;
+
+	dataptr[0]  = (362 * (b0+b1-1024))   >> 7; /* Correct for DC offset */
+	dataptr[32] = (362 * (b0-b1))        >> 7;
+	dataptr[16] = (196*b2 + 473*b3)      >> 7;
+	dataptr[48] = (196*b3 - 473*b2)      >> 7;
+
+	b0 = (362 * (c2-c1)) >> 7;
+	b1 = (362 * (c2+c1)) >> 7;
+	c0 = c0 << 2;
+	c3 = c3 << 2;
+
+	a0 = c0+b0;
+	a1 = c0-b0;
+	a2 = c3-b1;
+	a3 = c3+b1;
+
+	dataptr[8]  = (100*a0 + 502*a3) >> 9;
+	dataptr[24] = (426*a2 - 284*a1) >> 9;
+	dataptr[40] = (426*a1 + 284*a2) >> 9;
+	dataptr[56] = (100*a3 - 502*a0) >> 9;
+
+	yp++;
+	dataptr++;
+    }
+
+    dataptr = block;
+    for (i=0; i<8; i++) {
+	t0 = dataptr[0];
+	t1 = dataptr[7];
+	a0 = t0+t1;
+	c3 = t0-t1;
+
+	t0 = dataptr[1];
+	t1 = dataptr[6];
+	a1 = t0+t1;
+	c2 = t0-t1;
+
+	t0 = dataptr[2];
+	t1 = dataptr[5];
+	a2 = t0+t1;
+	c1 = t0-t1;
+
+	t0 = dataptr[3];
+	t1 = dataptr[4];
+	a3 = t0+t1;
+	c0 = t0-t1;
+
+	b0 = a0+a3;
+	b1 = a1+a2;
+	b2 = a1-a2;
+	b3 = a0-a3;
+
+	outcptr[0] = (362 * (b0+b1)   + 32768) >> 16;
+	outcptr[4] = (362 * (b0-b1)   + 32768) >> 16;
+	outcptr[2] = (196*b2 + 473*b3 + 32768) >> 16;
+	outcptr[6] = (196*b3 - 473*b2 + 32768) >> 16;
+
+	b0 = (362 * (c2-c1)) >> 9;
+	b1 = (362 * (c2+c1)) >> 9;
+
+	a0 = c0+b0;
+	a1 = c0-b0;
+	a2 = c3-b1;
+	a3 = c3+b1;
+
+	outcptr[1] = (100*a0 + 502*a3 + 32768) >> 16;
+	outcptr[3] = (426*a2 - 284*a1 + 32768) >> 16;
+	outcptr[5] = (426*a1 + 284*a2 + 32768) >> 16;
+	outcptr[7] = (100*a3 - 502*a0 + 32768) >> 16;
+
+	dataptr += 8;
+	outcptr += 8;
+    }
+
+    if (up) {
+	int8_t uvblk[64];
+
+	/* XXX interleave how nv wants it */
+	int8_t* uvp = uvblk;
+	for (i = 0; i < 8; ++i) {
+		uvp[0] = up[0] + 0x80;
+		uvp[1] = vp[0] + 0x80;
+		uvp[2] = up[1] + 0x80;
+		uvp[3] = vp[1] + 0x80;
+		uvp[4] = up[2] + 0x80;
+		uvp[5] = vp[2] + 0x80;
+		uvp[6] = up[3] + 0x80;
+		uvp[7] = vp[3] + 0x80;
+		uvp += 8;
+		up += width >> 1;
+		vp += width >> 1;
+	}
+	uvp = uvblk;
+#define width 8
+
+	dataptr = block;
+	for (i=0; i<8; i++) {
+	    t0 = uvp[0];
+	    t1 = uvp[7*width];
+	    a0 = t0+t1;
+	    c3 = t0-t1;
+	    uvp += width;
+
+	    t0 = uvp[0];
+	    t1 = uvp[5*width];
+	    a1 = t0+t1;
+	    c2 = t0-t1;
+	    uvp += width;
+
+	    t0 = uvp[0];
+	    t1 = uvp[3*width];
+	    a2 = t0+t1;
+	    c1 = t0-t1;
+	    uvp += width;
+
+	    t0 = uvp[0];
+	    t1 = uvp[width];
+	    a3 = t0+t1;
+	    c0 = t0-t1;
+	    uvp -= 3*width;
+
+	    b0 = a0+a3;
+	    b1 = a1+a2;
+	    b2 = a1-a2;
+	    b3 = a0-a3;
+
+	    dataptr[0]  = (362 * (b0+b1))   >> 7;
+	    dataptr[32] = (362 * (b0-b1))   >> 7;
+	    dataptr[16] = (196*b2 + 473*b3) >> 7;
+	    dataptr[48] = (196*b3 - 473*b2) >> 7;
+
+	    b0 = (362 * (c2-c1)) >> 7;
+	    b1 = (362 * (c2+c1)) >> 7;
+	    c0 = c0 << 2;
+	    c3 = c3 << 2;
+
+	    a0 = c0+b0;
+	    a1 = c0-b0;
+	    a2 = c3-b1;
+	    a3 = c3+b1;
+
+	    dataptr[8]  = (100*a0 + 502*a3) >> 9;
+	    dataptr[24] = (426*a2 - 284*a1) >> 9;
+	    dataptr[40] = (426*a1 + 284*a2) >> 9;
+	    dataptr[56] = (100*a3 - 502*a0) >> 9;
+
+
+	    uvp++;
+	    dataptr++;
+	}
+
+	dataptr = block;
+	for (i=0; i<8; i++) {
+	    a0 = dataptr[0];
+	    a3 = dataptr[6];
+
+	    a1 = dataptr[2];
+	    a2 = dataptr[4];
+
+	    b0 = a0+a3;
+	    b1 = a1+a2;
+	    b2 = a1-a2;
+	    b3 = a0-a3;
+
+	    outcptr[0] = (362 * (b0+b1)   + 16384) >> 15;
+	    outcptr[4] = (362 * (b0-b1)   + 16384) >> 15;
+	    outcptr[2] = (196*b2 + 473*b3 + 16384) >> 15;
+	    outcptr[6] = (196*b3 - 473*b2 + 16384) >> 15;
+
+	    a0 = dataptr[1];
+	    a3 = dataptr[7];
+
+	    a1 = dataptr[3];
+	    a2 = dataptr[5];
+
+	    b0 = a0+a3;
+	    b1 = a1+a2;
+	    b2 = a1-a2;
+	    b3 = a0-a3;
+
+	    outcptr[1] = (362 * (b0+b1)   + 16384) >> 15;
+	    outcptr[5] = (362 * (b0-b1)   + 16384) >> 15;
+	    outcptr[3] = (196*b2 + 473*b3 + 16384) >> 15;
+	    outcptr[7] = (196*b3 - 473*b2 + 16384) >> 15;
+
+	    dataptr += 8;
+	    outcptr += 8;
+	}
+#undef width
+    }
+}
+
+static void rev_haar_c(const u_int32_t* inp, u_char *yp,
+		       u_char* up, u_char* vp, int width)
+{
+    register int i, t, t0, t1, t2, t3, t4, t5, *dataptr;
+    register int width2=2*width, width6=6*width;
+    register const signed char *inpcptr=(const signed char *)inp;
+    static int block[64];
+#define SIGN_EXTEND(c) c
+
+    dataptr = block;
+    for (i=0; i<8; i++) {
+	if ((inpcptr[1] | inpcptr[2] | inpcptr[3]) == 0) {
+	    t2 = t3 = t4 = t5 = SIGN_EXTEND(inpcptr[0]);
+	} else {
+	    t4 = SIGN_EXTEND(inpcptr[0]);
+	    t5 = SIGN_EXTEND(inpcptr[1]);
+	    t0 = t4 - t5;
+	    t1 = t4 + t5;
+
+	    t4 = SIGN_EXTEND(inpcptr[2]);
+	    t5 = SIGN_EXTEND(inpcptr[3]);
+	    t2 = t0 - t4;
+	    t3 = t0 + t4;
+	    t4 = t1 - t5;
+	    t5 = t1 + t5;
+	}
+
+	if (inp[1] == 0) {
+	    dataptr[0] = dataptr[1] = t2;
+	    dataptr[2] = dataptr[3] = t3;
+	    dataptr[4] = dataptr[5] = t4;
+	    dataptr[6] = dataptr[7] = t5;
+	} else {
+	    t0 = SIGN_EXTEND(inpcptr[4]);
+	    t1 = SIGN_EXTEND(inpcptr[5]);
+	    dataptr[0] = t2 - t0;
+	    dataptr[1] = t2 + t0;
+	    dataptr[2] = t3 - t1;
+	    dataptr[3] = t3 + t1;
+
+	    t0 = SIGN_EXTEND(inpcptr[6]);
+	    t1 = SIGN_EXTEND(inpcptr[7]);
+	    dataptr[4] = t4 - t0;
+	    dataptr[5] = t4 + t0;
+	    dataptr[6] = t5 - t1;
+	    dataptr[7] = t5 + t1;
+	}
+
+	inp += 2;
+	inpcptr += 8;
+	dataptr += 8;
+    }
+
+    dataptr = block;
+    for (i=0; i<8; i++) {
+	t4 = dataptr[0] + 128; /* Add back DC offset */
+	t5 = dataptr[8];
+	t0 = t4 - t5;
+	t1 = t4 + t5;
+
+	t4 = dataptr[16];
+	t5 = dataptr[24];
+	t2 = t0 - t4;
+	t3 = t0 + t4;
+	t4 = t1 - t5;
+	t5 = t1 + t5;
+
+	t0 = dataptr[32];
+	t1 = dataptr[40];
+	yp[0] = UCLIMIT(t2 - t0);
+	yp[width] = UCLIMIT(t2 + t0);
+	yp += width2;
+	yp[0] = UCLIMIT(t3 - t1);
+	yp[width] = UCLIMIT(t3 + t1);
+	yp += width2;
+
+	t0 = dataptr[48];
+	t1 = dataptr[56];
+	yp[0] = UCLIMIT(t4 - t0);
+	yp[width] = UCLIMIT(t4 + t0);
+	yp += width2;
+	yp[0] = UCLIMIT(t5 - t1);
+	yp[width] = UCLIMIT(t5 + t1);
+	yp -= width6;
+
+	yp++;
+	dataptr++;
+    }
+
+    if (up) {
+	int uswitch = 1;
+	signed char* p = (signed char*)up++;
+	dataptr = block;
+	for (i=0; i<8; i++) {
+	    if ((inpcptr[2] | inpcptr[3]) == 0) {
+		t2 = t3 = SIGN_EXTEND(inpcptr[0]);
+		t4 = t5 = SIGN_EXTEND(inpcptr[1]);
+	    } else {
+		t0 = SIGN_EXTEND(inpcptr[0]);
+		t1 = SIGN_EXTEND(inpcptr[1]);
+
+		t4 = SIGN_EXTEND(inpcptr[2]);
+		t5 = SIGN_EXTEND(inpcptr[3]);
+		t2 = t0 - t4;
+		t3 = t0 + t4;
+		t4 = t1 - t5;
+		t5 = t1 + t5;
+	    }
+
+	    if (inp[1] == 0) {
+		dataptr[0] = dataptr[2] = t2;
+		dataptr[4] = dataptr[6] = t3;
+		dataptr[1] = dataptr[3] = t4;
+		dataptr[5] = dataptr[7] = t5;
+	    } else {
+		t0 = SIGN_EXTEND(inpcptr[4]);
+		t1 = SIGN_EXTEND(inpcptr[5]);
+		dataptr[0] = t2 - t0;
+		dataptr[2] = t2 + t0;
+		dataptr[4] = t3 - t1;
+		dataptr[6] = t3 + t1;
+
+		t0 = SIGN_EXTEND(inpcptr[6]);
+		t1 = SIGN_EXTEND(inpcptr[7]);
+		dataptr[1] = t4 - t0;
+		dataptr[3] = t4 + t0;
+		dataptr[5] = t5 - t1;
+		dataptr[7] = t5 + t1;
+	    }
+
+	    inp += 2;
+	    inpcptr += 8;
+	    dataptr += 8;
+	}
+
+	dataptr = block;
+	for (i=0; i<8; i++) {
+	    t4 = dataptr[0];
+	    t5 = dataptr[8];
+	    t0 = t4 - t5;
+	    t1 = t4 + t5;
+
+	    t4 = dataptr[16];
+	    t5 = dataptr[24];
+	    t2 = t0 - t4;
+	    t3 = t0 + t4;
+	    t4 = t1 - t5;
+	    t5 = t1 + t5;
+
+	    t0 = dataptr[32];
+	    t1 = dataptr[40];
+
+	    *p = SCLIMIT(t2 - t0) + 0x80;
+	    p += width / 2;
+	    *p = SCLIMIT(t2 + t0) + 0x80;
+	    p += width / 2;
+	    *p = SCLIMIT(t3 - t1) + 0x80;
+	    p += width / 2;
+	    *p = SCLIMIT(t3 + t1) + 0x80;
+	    p += width / 2;
+	    
+	    t0 = dataptr[48];
+	    t1 = dataptr[56];
+	    *p = SCLIMIT(t4 - t0) + 0x80;
+	    p += width / 2;
+	    *p = SCLIMIT(t4 + t0) + 0x80;
+	    p += width / 2;
+	    *p = SCLIMIT(t5 - t1) + 0x80;
+	    p += width / 2;
+	    *p = SCLIMIT(t5 + t1) + 0x80;
+	    p += width / 2;
+
+	    if (uswitch) {
+		    uswitch = 0;
+		    p = (signed char*)vp++;
+	    } else {
+		    uswitch = 1;
+		    p = (signed char*)up++;
+	    }
+	    dataptr++;
+	}
+    }
+}
+
+static void rev_dct_c(const u_int32_t* inp, u_char *yp,
+		      u_char* up, u_char* vp, int width)
+{
+    int i, t, *dataptr;
+    int a0, a1, a2, a3, b0, b1, b2, b3, c0, c1, c2, c3;
+    const int8_t *inpcptr=(const int8_t *)inp;
+    static int block[64];
+
+    dataptr = block;
+    for (i=0; i<8; i++) {
+	if ((inp[0]|inp[1]) == 0) {
+	    dataptr[0] = dataptr[1] = dataptr[2] = dataptr[3] =
+		dataptr[4] = dataptr[5] = dataptr[6] = dataptr[7] = 0;
+	} else {
+	    b0 = inpcptr[0] << 4;
+	    b1 = inpcptr[4] << 4;
+	    b2 = inpcptr[2] << 4;
+	    b3 = inpcptr[6] << 4;
+
+	    a0 = (362 * (b0+b1)) >> 9;
+	    a1 = (362 * (b0-b1)) >> 9;
+	    a2 = (196*b2 - 473*b3) >> 9;
+	    a3 = (473*b2 + 196*b3) >> 9;
+
+	    b0 = a0+a3;
+	    b1 = a1+a2;
+	    b2 = a1-a2;
+	    b3 = a0-a3;
+
+	    a0 = inpcptr[1] << 4;
+	    a1 = inpcptr[3] << 4;
+	    a2 = inpcptr[5] << 4;
+	    a3 = inpcptr[7] << 4;
+
+	    c0 = (100*a0 - 502*a3) >> 9;
+	    c1 = (426*a2 - 284*a1) >> 9;
+	    c2 = (426*a1 + 284*a2) >> 9;
+	    c3 = (502*a0 + 100*a3) >> 9;
+
+	    a0 = c0+c1;
+	    a1 = c0-c1;
+	    a2 = c3-c2;
+	    a3 = c3+c2;
+
+	    c0 = a0;
+	    c1 = (362 * (a2-a1)) >> 9;
+	    c2 = (362 * (a1+a2)) >> 9;
+	    c3 = a3;
+
+	    dataptr[0] = b0+c3;
+	    dataptr[1] = b1+c2;
+	    dataptr[2] = b2+c1;
+	    dataptr[3] = b3+c0;
+	    dataptr[4] = b3-c0;
+	    dataptr[5] = b2-c1;
+	    dataptr[6] = b1-c2;
+	    dataptr[7] = b0-c3;
+	}
+
+	inp += 2;
+	inpcptr += 8;
+	dataptr += 8;
+    }
+
+    dataptr = block;
+    for (i=0; i<8; i++) {
+	b0 = dataptr[0]+1448; /* Add back DC offset */
+	b1 = dataptr[32];
+	b2 = dataptr[16];
+	b3 = dataptr[48];
+
+	a0 = (362 * (b0+b1)) >> 9;
+	a1 = (362 * (b0-b1)) >> 9;
+	a2 = (196*b2 - 473*b3) >> 9;
+	a3 = (473*b2 + 196*b3) >> 9;
+
+	b0 = a0+a3;
+	b1 = a1+a2;
+	b2 = a1-a2;
+	b3 = a0-a3;
+
+	a0 = dataptr[8];
+	a1 = dataptr[24];
+	a2 = dataptr[40];
+	a3 = dataptr[56];
+
+	c0 = (100*a0 - 502*a3) >> 9;
+	c1 = (426*a2 - 284*a1) >> 9;
+	c2 = (426*a1 + 284*a2) >> 9;
+	c3 = (502*a0 + 100*a3) >> 9;
+
+	a0 = c0+c1;
+	a1 = c0-c1;
+	a2 = c3-c2;
+	a3 = c3+c2;
+
+	c0 = a0;
+	c1 = (362 * (a2-a1)) >> 9;
+	c2 = (362 * (a2+a1)) >> 9;
+	c3 = a3;
+
+	yp[0]     = UCLIMIT((b0+c3+4) >> 3);
+	yp[width] = UCLIMIT((b1+c2+4) >> 3);
+	yp += 2*width;
+
+	yp[0]     = UCLIMIT((b2+c1+4) >> 3);
+	yp[width] = UCLIMIT((b3+c0+4) >> 3);
+	yp += 2*width;
+
+	yp[0]     = UCLIMIT((b3-c0+4) >> 3);
+	yp[width] = UCLIMIT((b2-c1+4) >> 3);
+	yp += 2*width;
+
+	yp[0]     = UCLIMIT((b1-c2+4) >> 3);
+	yp[width] = UCLIMIT((b0-c3+4) >> 3);
+	yp -= 6*width;
+
+	yp++;
+	dataptr++;
+    }
+
+    if (up) {
+	u_int8_t uvblk[64];
+	u_int8_t* uvp = uvblk;
+#define width 8
+	dataptr = block;
+	for (i=0; i<8; i++) {
+	    if ((inp[0]|inp[1]) == 0) {
+		dataptr[0] = dataptr[1] = dataptr[2] = dataptr[3] =
+		    dataptr[4] = dataptr[5] = dataptr[6] = dataptr[7] = 0;
+	    } else {
+		b0 = inpcptr[0] << 4;
+		b2 = inpcptr[2] << 4;
+		b1 = inpcptr[4] << 4;
+		b3 = inpcptr[6] << 4;
+
+		a0 = (362 * (b0+b1)) >> 9;
+		a1 = (362 * (b0-b1)) >> 9;
+		a2 = (196*b2 - 473*b3) >> 9;
+		a3 = (473*b2 + 196*b3) >> 9;
+
+		dataptr[0] = a0+a3;
+		dataptr[2] = a1+a2;
+		dataptr[4] = a1-a2;
+		dataptr[6] = a0-a3;
+
+		b0 = inpcptr[1] << 4;
+		b2 = inpcptr[3] << 4;
+		b1 = inpcptr[5] << 4;
+		b3 = inpcptr[7] << 4;
+
+		a0 = (362 * (b0+b1)) >> 9;
+		a1 = (362 * (b0-b1)) >> 9;
+		a2 = (196*b2 - 473*b3) >> 9;
+		a3 = (473*b2 + 196*b3) >> 9;
+
+		dataptr[1] = a0+a3;
+		dataptr[3] = a1+a2;
+		dataptr[5] = a1-a2;
+		dataptr[7] = a0-a3;
+	    }
+
+	    inp += 2;
+	    inpcptr += 8;
+	    dataptr += 8;
+	}
+
+	dataptr = block;
+	for (i=0; i<8; i++) {
+	    b0 = dataptr[0];
+	    b1 = dataptr[32];
+	    b2 = dataptr[16];
+	    b3 = dataptr[48];
+
+	    a0 = (362 * (b0+b1)) >> 9;
+	    a1 = (362 * (b0-b1)) >> 9;
+	    a2 = (196*b2 - 473*b3) >> 9;
+	    a3 = (473*b2 + 196*b3) >> 9;
+
+	    b0 = a0+a3;
+	    b1 = a1+a2;
+	    b2 = a1-a2;
+	    b3 = a0-a3;
+
+	    a0 = dataptr[8];
+	    a1 = dataptr[24];
+	    a2 = dataptr[40];
+	    a3 = dataptr[56];
+
+	    c0 = (100*a0 - 502*a3) >> 9;
+	    c1 = (426*a2 - 284*a1) >> 9;
+	    c2 = (426*a1 + 284*a2) >> 9;
+	    c3 = (502*a0 + 100*a3) >> 9;
+
+	    a0 = c0+c1;
+	    a1 = c0-c1;
+	    a2 = c3-c2;
+	    a3 = c3+c2;
+
+	    c0 = a0;
+	    c1 = (362 * (a2-a1)) >> 9;
+	    c2 = (362 * (a2+a1)) >> 9;
+	    c3 = a3;
+
+	    uvp[0]     = SCLIMIT((b0+c3+4) >> 3);
+	    uvp[width] = SCLIMIT((b1+c2+4) >> 3);
+	    uvp += 2*width;
+
+	    uvp[0]     = SCLIMIT((b2+c1+4) >> 3);
+	    uvp[width] = SCLIMIT((b3+c0+4) >> 3);
+	    uvp += 2*width;
+
+	    uvp[0]     = SCLIMIT((b3-c0+4) >> 3);
+	    uvp[width] = SCLIMIT((b2-c1+4) >> 3);
+	    uvp += 2*width;
+
+	    uvp[0]     = SCLIMIT((b1-c2+4) >> 3);
+	    uvp[width] = SCLIMIT((b0-c3+4) >> 3);
+	    uvp -= 6*width;
+
+	    uvp++;
+	    dataptr++;
+	}
+#undef width
+	uvp = uvblk;
+	for (i = 0; i < 8; ++i) {
+		up[0] = uvp[0] + 0x80;
+		vp[0] = uvp[1] + 0x80;
+		up[1] = uvp[2] + 0x80;
+		vp[1] = uvp[3] + 0x80;
+		up[2] = uvp[4] + 0x80;
+		vp[2] = uvp[5] + 0x80;
+		up[3] = uvp[6] + 0x80;
+		vp[3] = uvp[7] + 0x80;
+		up += width >> 1;
+		vp += width >> 1;
+		uvp += 8;
+	}
+    }
+}
+
+
+#ifdef NV_SSE2
+/*
+ * The SSE2 transforms keep an 8x8 block in eight registers of
+ * 16-bit lanes, one row per register, and do each pass of the C
+ * code on all the rows or columns at once, transposing in between.
+ * Everything the C code does in 32 bits fits in 16 except the
+ * products, which are done with _mm_madd_epi16 on pairs of
+ * operands, and the second pass of the inverse DCT, which is done
+ * in 32-bit lanes, half a block at a time.
+ */
+NV_SSE2
+static inline void transpose8(__m128i* r)
+{
+	__m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+	__m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+	__m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+	__m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+	__m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+	__m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+	__m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+	__m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+	__m128i b0 = _mm_unpacklo_epi32(a0, a2);
+	__m128i b1 = _mm_unpackhi_epi32(a0, a2);
+	__m128i b2 = _mm_unpacklo_epi32(a1, a3);
+	__m128i b3 = _mm_unpackhi_epi32(a1, a3);
+	__m128i b4 = _mm_unpacklo_epi32(a4, a6);
+	__m128i b5 = _mm_unpackhi_epi32(a4, a6);
+	__m128i b6 = _mm_unpacklo_epi32(a5, a7);
+	__m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+	r[0] = _mm_unpacklo_epi64(b0, b4);
+	r[1] = _mm_unpackhi_epi64(b0, b4);
+	r[2] = _mm_unpacklo_epi64(b1, b5);
+	r[3] = _mm_unpackhi_epi64(b1, b5);
+	r[4] = _mm_unpacklo_epi64(b2, b6);
+	r[5] = _mm_unpackhi_epi64(b2, b6);
+	r[6] = _mm_unpacklo_epi64(b3, b7);
+	r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+/* the multiplier pair (cx, cy) for madd() */
+NV_SSE2
+static inline __m128i coef(int cx, int cy)
+{
+	return (_mm_set1_epi32((cy << 16) | (cx & 0xffff)));
+}
+
+/* (cx * x + cy * y + bias) >> shift, in 16-bit lanes */
+NV_SSE2
+static inline __m128i madd(__m128i x, __m128i y, __m128i c, __m128i bias,
+			   __m128i shift)
+{
+	__m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(x, y), c);
+	__m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(x, y), c);
+	lo = _mm_sra_epi32(_mm_add_epi32(lo, bias), shift);
+	hi = _mm_sra_epi32(_mm_add_epi32(hi, bias), shift);
+	return (_mm_packs_epi32(lo, hi));
+}
+
+/* cx * x + cy * y in 32-bit lanes, for lanes 0-3 or 4-7 */
+NV_SSE2
+static inline __m128i madd32(__m128i x, __m128i y, __m128i c, int hi)
+{
+	return (_mm_madd_epi16(hi ? _mm_unpackhi_epi16(x, y) :
+			       _mm_unpacklo_epi16(x, y), c));
+}
+
+/* x * c in 32-bit lanes */
+NV_SSE2
+static inline __m128i mul32(__m128i x, int c)
+{
+	__m128i k = _mm_set1_epi32(c);
+	__m128i p0 = _mm_mul_epu32(x, k);
+	__m128i p1 = _mm_mul_epu32(_mm_srli_epi64(x, 32), k);
+	return (_mm_unpacklo_epi32(_mm_shuffle_epi32(p0, _MM_SHUFFLE(0, 0, 2, 0)),
+				   _mm_shuffle_epi32(p1, _MM_SHUFFLE(0, 0, 2, 0))));
+}
+
+/* 8 rows of 8 coefficients, sign extended */
+NV_SSE2
+static inline void load_coef(const u_int32_t* in, __m128i* r)
+{
+	const __m128i* p = (const __m128i*)in;
+	for (int k = 0; k < 8; k += 2) {
+		__m128i x = _mm_loadu_si128(p++);
+		r[k] = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+		r[k + 1] = _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8);
+	}
+}
+
+/* the low bytes of 8 rows, as the C code's stores to char */
+NV_SSE2
+static inline void store_coef(const __m128i* r, u_int32_t* out)
+{
+	const __m128i mask = _mm_set1_epi16(0xff);
+	__m128i* p = (__m128i*)out;
+	for (int k = 0; k < 8; k += 2)
+		_mm_storeu_si128(p++,
+			_mm_packus_epi16(_mm_and_si128(r[k], mask),
+					 _mm_and_si128(r[k + 1], mask)));
+}
+
+NV_SSE2
+static inline __m128i load32(const u_char* p)
+{
+	int v;
+	memcpy(&v, p, 4);
+	return (_mm_cvtsi32_si128(v));
+}
+
+/* 8 rows of 4 u and 4 v pels, interleaved as u0 v0 u1 v1 ..., less 128 */
+NV_SSE2
+static inline void load_uv(const u_char* up, const u_char* vp, int stride,
+			   __m128i* r)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i dc = _mm_set1_epi16(128);
+	for (int k = 0; k < 8; ++k) {
+		__m128i uv = _mm_unpacklo_epi8(load32(up), load32(vp));
+		r[k] = _mm_sub_epi16(_mm_unpacklo_epi8(uv, zero), dc);
+		up += stride;
+		vp += stride;
+	}
+}
+
+/* the reverse of load_uv, saturating; r is already offset by 128 */
+NV_SSE2
+static inline void store_uv(__m128i r, u_char* up, u_char* vp)
+{
+	r = _mm_shufflelo_epi16(r, _MM_SHUFFLE(3, 1, 2, 0));
+	r = _mm_shufflehi_epi16(r, _MM_SHUFFLE(3, 1, 2, 0));
+	r = _mm_shuffle_epi32(r, _MM_SHUFFLE(3, 1, 2, 0));
+	r = _mm_packus_epi16(r, r);
+	int v = _mm_cvtsi128_si32(r);
+	memcpy(up, &v, 4);
+	v = _mm_cvtsi128_si32(_mm_srli_si128(r, 4));
+	memcpy(vp, &v, 4);
+}
+
+/* the first (vertical) pass of the forward Haar transform */
+NV_SSE2
+static inline void fwd_haar_cols(const __m128i* r, __m128i* d)
+{
+	__m128i t0, t1, t2, t3, t4, t5;
+
+	t2 = _mm_add_epi16(r[0], r[1]);
+	d[4] = _mm_slli_epi16(_mm_sub_epi16(r[1], r[0]), 2);
+	t3 = _mm_add_epi16(r[2], r[3]);
+	d[5] = _mm_slli_epi16(_mm_sub_epi16(r[3], r[2]), 2);
+	t4 = _mm_add_epi16(r[4], r[5]);
+	d[6] = _mm_slli_epi16(_mm_sub_epi16(r[5], r[4]), 2);
+	t5 = _mm_add_epi16(r[6], r[7]);
+	d[7] = _mm_slli_epi16(_mm_sub_epi16(r[7], r[6]), 2);
+
+	t0 = _mm_add_epi16(t2, t3);
+	t1 = _mm_add_epi16(t4, t5);
+	d[0] = _mm_add_epi16(t0, t1);
+	d[1] = _mm_sub_epi16(t1, t0);
+	d[2] = _mm_slli_epi16(_mm_sub_epi16(t3, t2), 1);
+	d[3] = _mm_slli_epi16(_mm_sub_epi16(t5, t4), 1);
+}
+
+/* (x + r) >> s */
+#define NV_RSHIFT(x, r, s) \
+	_mm_srai_epi16(_mm_add_epi16((x), _mm_set1_epi16(r)), s)
+
+NV_SSE2
+static void fwd_haar_sse2(const u_char* yp, const u_char* up,
+			  const u_char* vp, int stride, u_int32_t* out)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i r[8], d[8], t0, t1, t2, t3, t4, t5;
+	int k;
+
+	for (k = 0; k < 8; ++k) {
+		r[k] = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)yp),
+					 zero);
+		yp += stride;
+	}
+	fwd_haar_cols(r, d);
+	/* Correct for DC offset */
+	d[0] = _mm_sub_epi16(d[0], _mm_set1_epi16(1024));
+	transpose8(d);
+
+	t2 = _mm_add_epi16(d[0], d[1]);
+	r[4] = NV_RSHIFT(_mm_sub_epi16(d[1], d[0]), 7, 4);
+	t3 = _mm_add_epi16(d[2], d[3]);
+	r[5] = NV_RSHIFT(_mm_sub_epi16(d[3], d[2]), 7, 4);
+	t4 = _mm_add_epi16(d[4], d[5]);
+	r[6] = NV_RSHIFT(_mm_sub_epi16(d[5], d[4]), 7, 4);
+	t5 = _mm_add_epi16(d[6], d[7]);
+	r[7] = NV_RSHIFT(_mm_sub_epi16(d[7], d[6]), 7, 4);
+
+	t0 = _mm_add_epi16(t2, t3);
+	t1 = _mm_add_epi16(t4, t5);
+	r[0] = NV_RSHIFT(_mm_add_epi16(t0, t1), 31, 6);
+	r[1] = NV_RSHIFT(_mm_sub_epi16(t1, t0), 31, 6);
+	r[2] = NV_RSHIFT(_mm_sub_epi16(t3, t2), 15, 5);
+	r[3] = NV_RSHIFT(_mm_sub_epi16(t5, t4), 15, 5);
+	transpose8(r);
+	store_coef(r, out);
+
+	if (up == 0)
+		return;
+
+	load_uv(up, vp, stride >> 1, r);
+	fwd_haar_cols(r, d);
+	transpose8(d);
+
+	t2 = _mm_add_epi16(d[0], d[2]);
+	r[4] = NV_RSHIFT(_mm_sub_epi16(d[2], d[0]), 7, 4);
+	t3 = _mm_add_epi16(d[4], d[6]);
+	r[5] = NV_RSHIFT(_mm_sub_epi16(d[6], d[4]), 7, 4);
+	t4 = _mm_add_epi16(d[1], d[3]);
+	r[6] = NV_RSHIFT(_mm_sub_epi16(d[3], d[1]), 7, 4);
+	t5 = _mm_add_epi16(d[5], d[7]);
+	r[7] = NV_RSHIFT(_mm_sub_epi16(d[7], d[5]), 7, 4);
+
+	r[0] = NV_RSHIFT(_mm_add_epi16(t2, t3), 15, 5);
+	r[1] = NV_RSHIFT(_mm_add_epi16(t4, t5), 15, 5);
+	r[2] = NV_RSHIFT(_mm_sub_epi16(t3, t2), 15, 5);
+	r[3] = NV_RSHIFT(_mm_sub_epi16(t5, t4), 15, 5);
+	transpose8(r);
+	store_coef(r, out + 16);
+}
+
+/*
+ * One pass of the inverse Haar transform on the luma block, which
+ * is the same across the rows as down the columns.
+ */
+NV_SSE2
+static inline void rev_haar_pass(const __m128i* x, __m128i* d)
+{
+	__m128i t0, t1, t2, t3, t4, t5;
+
+	t0 = _mm_sub_epi16(x[0], x[1]);
+	t1 = _mm_add_epi16(x[0], x[1]);
+	t2 = _mm_sub_epi16(t0, x[2]);
+	t3 = _mm_add_epi16(t0, x[2]);
+	t4 = _mm_sub_epi16(t1, x[3]);
+	t5 = _mm_add_epi16(t1, x[3]);
+
+	d[0] = _mm_sub_epi16(t2, x[4]);
+	d[1] = _mm_add_epi16(t2, x[4]);
+	d[2] = _mm_sub_epi16(t3, x[5]);
+	d[3] = _mm_add_epi16(t3, x[5]);
+	d[4] = _mm_sub_epi16(t4, x[6]);
+	d[5] = _mm_add_epi16(t4, x[6]);
+	d[6] = _mm_sub_epi16(t5, x[7]);
+	d[7] = _mm_add_epi16(t5, x[7]);
+}
+
+NV_SSE2
+static void rev_haar_sse2(const u_int32_t* in, u_char* yp, u_char* up,
+			  u_char* vp, int width)
+{
+	const __m128i dc = _mm_set1_epi16(128);
+	__m128i x[8], d[8], t2, t3, t4, t5;
+	int k;
+
+	load_coef(in, x);
+	transpose8(x);
+	rev_haar_pass(x, d);
+	transpose8(d);
+	/* Add back DC offset */
+	d[0] = _mm_add_epi16(d[0], dc);
+	rev_haar_pass(d, x);
+	for (k = 0; k < 8; ++k) {
+		_mm_storel_epi64((__m128i*)yp, _mm_packus_epi16(x[k], x[k]));
+		yp += width;
+	}
+
+	if (up == 0)
+		return;
+
+	load_coef(in + 16, x);
+	transpose8(x);
+	t2 = _mm_sub_epi16(x[0], x[2]);
+	t3 = _mm_add_epi16(x[0], x[2]);
+	t4 = _mm_sub_epi16(x[1], x[3]);
+	t5 = _mm_add_epi16(x[1], x[3]);
+	d[0] = _mm_sub_epi16(t2, x[4]);
+	d[2] = _mm_add_epi16(t2, x[4]);
+	d[4] = _mm_sub_epi16(t3, x[5]);
+	d[6] = _mm_add_epi16(t3, x[5]);
+	d[1] = _mm_sub_epi16(t4, x[6]);
+	d[3] = _mm_add_epi16(t4, x[6]);
+	d[5] = _mm_sub_epi16(t5, x[7]);
+	d[7] = _mm_add_epi16(t5, x[7]);
+	transpose8(d);
+	rev_haar_pass(d, x);
+	width >>= 1;
+	for (k = 0; k < 8; ++k) {
+		store_uv(_mm_adds_epi16(x[k], dc), up, vp);
+		up += width;
+		vp += width;
+	}
+}
+
+/*
+ * The first (vertical) pass of the forward DCT; dc is subtracted
+ * from the sum of the column before scaling.
+ */
+NV_SSE2
+static inline void fwd_dct_cols(const __m128i* r, __m128i* d, int dc)
+{
+	const __m128i s7 = _mm_cvtsi32_si128(7);
+	const __m128i s9 = _mm_cvtsi32_si128(9);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i a0, a1, a2, a3, b0, b1, b2, b3, c0, c1, c2, c3;
+
+	a0 = _mm_add_epi16(r[0], r[7]);
+	c3 = _mm_sub_epi16(r[0], r[7]);
+	a1 = _mm_add_epi16(r[1], r[6]);
+	c2 = _mm_sub_epi16(r[1], r[6]);
+	a2 = _mm_add_epi16(r[2], r[5]);
+	c1 = _mm_sub_epi16(r[2], r[5]);
+	a3 = _mm_add_epi16(r[3], r[4]);
+	c0 = _mm_sub_epi16(r[3], r[4]);
+
+	b0 = _mm_add_epi16(a0, a3);
+	b1 = _mm_add_epi16(a1, a2);
+	b2 = _mm_sub_epi16(a1, a2);
+	b3 = _mm_sub_epi16(a0, a3);
+
+	d[0] = madd(b0, b1, coef(362, 362), _mm_set1_epi32(-362 * dc), s7);
+	d[4] = madd(b0, b1, coef(362, -362), zero, s7);
+	d[2] = madd(b2, b3, coef(196, 473), zero, s7);
+	d[6] = madd(b3, b2, coef(196, -473), zero, s7);
+
+	b0 = madd(c2, c1, coef(362, -362), zero, s7);
+	b1 = madd(c2, c1, coef(362, 362), zero, s7);
+	c0 = _mm_slli_epi16(c0, 2);
+	c3 = _mm_slli_epi16(c3, 2);
+
+	a0 = _mm_add_epi16(c0, b0);
+	a1 = _mm_sub_epi16(c0, b0);
+	a2 = _mm_sub_epi16(c3, b1);
+	a3 = _mm_add_epi16(c3, b1);
+
+	d[1] = madd(a0, a3, coef(100, 502), zero, s9);
+	d[3] = madd(a2, a1, coef(426, -284), zero, s9);
+	d[5] = madd(a1, a2, coef(426, 284), zero, s9);
+	d[7] = madd(a3, a0, coef(100, -502), zero, s9);
+}
+
+/* the 4-point forward DCT of the second pass for chroma */
+NV_SSE2
+static inline void fwd_dct4(__m128i a0, __m128i a1, __m128i a2, __m128i a3,
+			    __m128i* o0, __m128i* o2, __m128i* o4,
+			    __m128i* o6)
+{
+	const __m128i rnd = _mm_set1_epi32(16384);
+	const __m128i s15 = _mm_cvtsi32_si128(15);
+	__m128i b0 = _mm_add_epi16(a0, a3);
+	__m128i b1 = _mm_add_epi16(a1, a2);
+	__m128i b2 = _mm_sub_epi16(a1, a2);
+	__m128i b3 = _mm_sub_epi16(a0, a3);
+
+	*o0 = madd(b0, b1, coef(362, 362), rnd, s15);
+	*o4 = madd(b0, b1, coef(362, -362), rnd, s15);
+	*o2 = madd(b2, b3, coef(196, 473), rnd, s15);
+	*o6 = madd(b3, b2, coef(196, -473), rnd, s15);
+}
+
+NV_SSE2
+static void fwd_dct_sse2(const u_char* yp, const u_char* up,
+			 const u_char* vp, int width, u_int32_t* out)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rnd = _mm_set1_epi32(32768);
+	const __m128i s9 = _mm_cvtsi32_si128(9);
+	const __m128i s16 = _mm_cvtsi32_si128(16);
+	__m128i r[8], d[8], a0, a1, a2, a3, b0, b1, b2, b3, c0, c1, c2, c3;
+	int k;
+
+	for (k = 0; k < 8; ++k) {
+		r[k] = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)yp),
+					 zero);
+		yp += width;
+	}
+	/* Correct for DC offset */
+	fwd_dct_cols(r, d, 1024);
+	transpose8(d);
+
+	a0 = _mm_add_epi16(d[0], d[7]);
+	c3 = _mm_sub_epi16(d[0], d[7]);
+	a1 = _mm_add_epi16(d[1], d[6]);
+	c2 = _mm_sub_epi16(d[1], d[6]);
+	a2 = _mm_add_epi16(d[2], d[5]);
+	c1 = _mm_sub_epi16(d[2], d[5]);
+	a3 = _mm_add_epi16(d[3], d[4]);
+	c0 = _mm_sub_epi16(d[3], d[4]);
+
+	b0 = _mm_add_epi16(a0, a3);
+	b1 = _mm_add_epi16(a1, a2);
+	b2 = _mm_sub_epi16(a1, a2);
+	b3 = _mm_sub_epi16(a0, a3);
+
+	r[0] = madd(b0, b1, coef(362, 362), rnd, s16);
+	r[4] = madd(b0, b1, coef(362, -362), rnd, s16);
+	r[2] = madd(b2, b3, coef(196, 473), rnd, s16);
+	r[6] = madd(b3, b2, coef(196, -473), rnd, s16);
+
+	b0 = madd(c2, c1, coef(362, -362), zero, s9);
+	b1 = madd(c2, c1, coef(362, 362), zero, s9);
+
+	a0 = _mm_add_epi16(c0, b0);
+	a1 = _mm_sub_epi16(c0, b0);
+	a2 = _mm_sub_epi16(c3, b1);
+	a3 = _mm_add_epi16(c3, b1);
+
+	r[1] = madd(a0, a3, coef(100, 502), rnd, s16);
+	r[3] = madd(a2, a1, coef(426, -284), rnd, s16);
+	r[5] = madd(a1, a2, coef(426, 284), rnd, s16);
+	r[7] = madd(a3, a0, coef(100, -502), rnd, s16);
+	transpose8(r);
+	store_coef(r, out);
+
+	if (up == 0)
+		return;
+
+	load_uv(up, vp, width >> 1, r);
+	fwd_dct_cols(r, d, 0);
+	transpose8(d);
+	fwd_dct4(d[0], d[2], d[4], d[6], &r[0], &r[2], &r[4], &r[6]);
+	fwd_dct4(d[1], d[3], d[5], d[7], &r[1], &r[3], &r[5], &r[7]);
+	transpose8(r);
+	store_coef(r, out + 16);
+}
+
+/*
+ * The even half of the first pass of the inverse DCT, on the
+ * coefficients in x0, x2, x4 and x6 (in that order).
+ */
+NV_SSE2
+static inline void rev_dct_even(__m128i x0, __m128i x2, __m128i x4,
+				__m128i x6, __m128i* e)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i s9 = _mm_cvtsi32_si128(9);
+	__m128i b0 = _mm_slli_epi16(x0, 4);
+	__m128i b1 = _mm_slli_epi16(x4, 4);
+	__m128i b2 = _mm_slli_epi16(x2, 4);
+	__m128i b3 = _mm_slli_epi16(x6, 4);
+
+	__m128i a0 = madd(b0, b1, coef(362, 362), zero, s9);
+	__m128i a1 = madd(b0, b1, coef(362, -362), zero, s9);
+	__m128i a2 = madd(b2, b3, coef(196, -473), zero, s9);
+	__m128i a3 = madd(b2, b3, coef(473, 196), zero, s9);
+
+	e[0] = _mm_add_epi16(a0, a3);
+	e[1] = _mm_add_epi16(a1, a2);
+	e[2] = _mm_sub_epi16(a1, a2);
+	e[3] = _mm_sub_epi16(a0, a3);
+}
+
+/*
+ * The second (vertical) pass of the inverse DCT, in 32-bit lanes
+ * for columns 0-3 or 4-7 of e; dc is added to the first row.
+ * Returns the 8 rows of pels, before they are clamped.
+ */
+NV_SSE2
+static inline void rev_dct_cols(const __m128i* e, int hi, int dc, __m128i* y)
+{
+	const __m128i rnd = _mm_set1_epi32(4);
+	__m128i a0, a1, a2, a3, b0, b1, b2, b3, c0, c1, c2, c3;
+
+	b0 = _mm_add_epi16(e[0], _mm_set1_epi16(dc));
+	a0 = _mm_srai_epi32(madd32(b0, e[4], coef(362, 362), hi), 9);
+	a1 = _mm_srai_epi32(madd32(b0, e[4], coef(362, -362), hi), 9);
+	a2 = _mm_srai_epi32(madd32(e[2], e[6], coef(196, -473), hi), 9);
+	a3 = _mm_srai_epi32(madd32(e[2], e[6], coef(473, 196), hi), 9);
+
+	b0 = _mm_add_epi32(a0, a3);
+	b1 = _mm_add_epi32(a1, a2);
+	b2 = _mm_sub_epi32(a1, a2);
+	b3 = _mm_sub_epi32(a0, a3);
+
+	c0 = _mm_srai_epi32(madd32(e[1], e[7], coef(100, -502), hi), 9);
+	c1 = _mm_srai_epi32(madd32(e[5], e[3], coef(426, -284), hi), 9);
+	c2 = _mm_srai_epi32(madd32(e[3], e[5], coef(426, 284), hi), 9);
+	c3 = _mm_srai_epi32(madd32(e[1], e[7], coef(502, 100), hi), 9);
+
+	a0 = _mm_add_epi32(c0, c1);
+	a1 = _mm_sub_epi32(c0, c1);
+	a2 = _mm_sub_epi32(c3, c2);
+	a3 = _mm_add_epi32(c3, c2);
+
+	c0 = a0;
+	c1 = _mm_srai_epi32(mul32(_mm_sub_epi32(a2, a1), 362), 9);
+	c2 = _mm_srai_epi32(mul32(_mm_add_epi32(a2, a1), 362), 9);
+	c3 = a3;
+
+	b0 = _mm_add_epi32(b0, rnd);
+	b1 = _mm_add_epi32(b1, rnd);
+	b2 = _mm_add_epi32(b2, rnd);
+	b3 = _mm_add_epi32(b3, rnd);
+	y[0] = _mm_srai_epi32(_mm_add_epi32(b0, c3), 3);
+	y[1] = _mm_srai_epi32(_mm_add_epi32(b1, c2), 3);
+	y[2] = _mm_srai_epi32(_mm_add_epi32(b2, c1), 3);
+	y[3] = _mm_srai_epi32(_mm_add_epi32(b3, c0), 3);
+	y[4] = _mm_srai_epi32(_mm_sub_epi32(b3, c0), 3);
+	y[5] = _mm_srai_epi32(_mm_sub_epi32(b2, c1), 3);
+	y[6] = _mm_srai_epi32(_mm_sub_epi32(b1, c2), 3);
+	y[7] = _mm_srai_epi32(_mm_sub_epi32(b0, c3), 3);
+}
+
+NV_SSE2
+static void rev_dct_sse2(const u_int32_t* in, u_char* yp, u_char* up,
+			 u_char* vp, int width)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i s9 = _mm_cvtsi32_si128(9);
+	__m128i x[8], d[8], lo[8], hi[8], e[4];
+	__m128i a0, a1, a2, a3, c0, c1, c2, c3;
+	int k;
+
+	load_coef(in, x);
+	transpose8(x);
+	rev_dct_even(x[0], x[2], x[4], x[6], e);
+
+	a0 = _mm_slli_epi16(x[1], 4);
+	a1 = _mm_slli_epi16(x[3], 4);
+	a2 = _mm_slli_epi16(x[5], 4);
+	a3 = _mm_slli_epi16(x[7], 4);
+
+	c0 = madd(a0, a3, coef(100, -502), zero, s9);
+	c1 = madd(a2, a1, coef(426, -284), zero, s9);
+	c2 = madd(a1, a2, coef(426, 284), zero, s9);
+	c3 = madd(a0, a3, coef(502, 100), zero, s9);
+
+	a0 = _mm_add_epi16(c0, c1);
+	a1 = _mm_sub_epi16(c0, c1);
+	a2 = _mm_sub_epi16(c3, c2);
+	a3 = _mm_add_epi16(c3, c2);
+
+	c0 = a0;
+	c1 = madd(a2, a1, coef(362, -362), zero, s9);
+	c2 = madd(a1, a2, coef(362, 362), zero, s9);
+	c3 = a3;
+
+	d[0] = _mm_add_epi16(e[0], c3);
+	d[1] = _mm_add_epi16(e[1], c2);
+	d[2] = _mm_add_epi16(e[2], c1);
+	d[3] = _mm_add_epi16(e[3], c0);
+	d[4] = _mm_sub_epi16(e[3], c0);
+	d[5] = _mm_sub_epi16(e[2], c1);
+	d[6] = _mm_sub_epi16(e[1], c2);
+	d[7] = _mm_sub_epi16(e[0], c3);
+	transpose8(d);
+
+	/* Add back DC offset */
+	rev_dct_cols(d, 0, 1448, lo);
+	rev_dct_cols(d, 1, 1448, hi);
+	for (k = 0; k < 8; ++k) {
+		__m128i y = _mm_packs_epi32(lo[k], hi[k]);
+		_mm_storel_epi64((__m128i*)yp, _mm_packus_epi16(y, y));
+		yp += width;
+	}
+
+	if (up == 0)
+		return;
+
+	load_coef(in + 16, x);
+	transpose8(x);
+	rev_dct_even(x[0], x[2], x[4], x[6], e);
+	d[0] = e[0];
+	d[2] = e[1];
+	d[4] = e[2];
+	d[6] = e[3];
+	rev_dct_even(x[1], x[3], x[5], x[7], e);
+	d[1] = e[0];
+	d[3] = e[1];
+	d[5] = e[2];
+	d[7] = e[3];
+	transpose8(d);
+
+	rev_dct_cols(d, 0, 0, lo);
+	rev_dct_cols(d, 1, 0, hi);
+	width >>= 1;
+	for (k = 0; k < 8; ++k) {
+		__m128i uv = _mm_adds_epi16(_mm_packs_epi32(lo[k], hi[k]),
+					    _mm_set1_epi16(128));
+		store_uv(uv, up, vp);
+		up += width;
+		vp += width;
+	}
+}
+#endif
+
+void nv_fwd_haar(const u_char* yp, const u_char* up, const u_char* vp,
+		 int width, u_int32_t* out)
+{
+#ifdef NV_SSE2
+	if (nv_simd()) {
+		fwd_haar_sse2(yp, up, vp, width, out);
+		return;
+	}
+#endif
+	fwd_haar_c(yp, up, vp, width, out);
+}
+
+void nv_fwd_dct(const u_char* yp, const u_char* up, const u_char* vp,
+		int width, u_int32_t* out)
+{
+#ifdef NV_SSE2
+	if (nv_simd()) {
+		fwd_dct_sse2(yp, up, vp, width, out);
+		return;
+	}
+#endif
+	fwd_dct_c(yp, up, vp, width, out);
+}
+
+void nv_rev_haar(const u_int32_t* in, u_char* yp, u_char* up, u_char* vp,
+		 int width)
+{
+#ifdef NV_SSE2
+	if (nv_simd()) {
+		rev_haar_sse2(in, yp, up, vp, width);
+		return;
+	}
+#endif
+	rev_haar_c(in, yp, up, vp, width);
+}
+
+void nv_rev_dct(const u_int32_t* in, u_char* yp, u_char* up, u_char* vp,
+		int width)
+{
+#ifdef NV_SSE2
+	if (nv_simd()) {
+		rev_dct_sse2(in, yp, up, vp, width);
+		return;
+	}
+#endif
+	rev_dct_c(in, yp, up, vp, width);
+}
+
+void nv_drop(u_int32_t* blk, int color, int loss)
+{
+	signed char *blkp = (signed char*)blk;
+	if ((blkp[2]>=-loss) && (blkp[2]<=loss)) blkp[2] = 0;
+	if ((blkp[3]>=-loss) && (blkp[3]<=loss)) blkp[3] = 0;
+	if ((blkp[4]>=-loss) && (blkp[5]<=loss)) blkp[4] = 0;
+	if ((blkp[5]>=-loss) && (blkp[5]<=loss)) blkp[5] = 0;
+	if ((blkp[6]>=-loss) && (blkp[6]<=loss)) blkp[6] = 0;
+	if ((blkp[7]>=-loss) && (blkp[7]<=loss)) blkp[7] = 0;
+	blkp = ((signed char *)blk)+10;
+	int i;
+	for (i=10; i<64; i+=6, blkp+=6) {
+		if ((blkp[0]>=-loss) && (blkp[0]<=loss)) blkp[0] = 0;
+		if ((blkp[1]>=-loss) && (blkp[1]<=loss)) blkp[1] = 0;
+		if ((blkp[2]>=-loss) && (blkp[2]<=loss)) blkp[2] = 0;
+		if ((blkp[3]>=-loss) && (blkp[3]<=loss)) blkp[3] = 0;
+		if ((blkp[4]>=-loss) && (blkp[4]<=loss)) blkp[4] = 0;
+		if ((blkp[5]>=-loss) && (blkp[5]<=loss)) blkp[5] = 0;
+	}
+
+	if (color) {
+		blkp = ((signed char *)blk)+64;
+		if ((blkp[2]>=-2*loss) && (blkp[2]<=2*loss))
+			blkp[2] = 0;
+		if ((blkp[3]>=-2*loss) && (blkp[3]<=2*loss))
+			blkp[3] = 0;
+		if ((blkp[4]>=-2*loss) && (blkp[5]<=2*loss))
+			blkp[4] = 0;
+		if ((blkp[5]>=-2*loss) && (blkp[5]<=2*loss))
+			blkp[5] = 0;
+		if ((blkp[6]>=-2*loss) && (blkp[6]<=2*loss))
+			blkp[6] = 0;
+		if ((blkp[7]>=-2*loss) && (blkp[7]<=2*loss))
+			blkp[7] = 0;
+		blkp = ((signed char *)blk)+74;
+		for (i=10; i<64; i+=6, blkp+=6) {
+			if ((blkp[0]>=-2*loss) && (blkp[0]<=2*loss))
+				blkp[0] = 0;
+			if ((blkp[1]>=-2*loss) && (blkp[1]<=2*loss))
+				blkp[1] = 0;
+			if ((blkp[2]>=-2*loss) && (blkp[2]<=2*loss))
+				blkp[2] = 0;
+			if ((blkp[3]>=-2*loss) && (blkp[3]<=2*loss))
+				blkp[3] = 0;
+			if ((blkp[4]>=-2*loss) && (blkp[4]<=2*loss))
+				blkp[4] = 0;
+			if ((blkp[5]>=-2*loss) && (blkp[5]<=2*loss))
+				blkp[5] = 0;
+		}
+	}
+}
+
+u_char* nv_pack(const u_int32_t* blk, int color, u_char* pt)
+{
+	/* XXX: The ntohl() calls here need to be redone as something more
+		efficient for little-endian machines! */
+	const u_int32_t* blkwp = blk;
+	const u_int32_t* blkwLim = color ? blk+32 : blk+16;
+	int i = 2;
+	int zcount = 0;
+	u_int32_t blkw = ntohl(*blkwp++);
+	pt[1] = blkw >> 24;
+	blkw <<= 8;
+	int rem = 3;
+	do {
+		int b;
+		while ((b = blkw >> 24) != 0) {
+			pt[i++] = b;
+			blkw <<= 8;
+			rem--;
+			if (i == 4) break;
+			if (rem == 0) {
+				if (blkwp == blkwLim) break;
+				blkw = ntohl(*blkwp++);
+				rem = 4;
+			}
+		}
+
+		while (1) {
+			if (zcount+rem >= 63) {
+				break;
+			} else if (blkw == 0) {
+				zcount += rem;
+				rem = 0;
+				if (blkwp == blkwLim) break;
+				blkw = ntohl(*blkwp++);
+				rem = 4;
+			} else if ((blkw >> 24) == 0) {
+				zcount++;
+				blkw <<= 8;
+				rem--;
+			} else break;
+		}
+
+		*pt = ((i-1) << 6) + zcount;
+		pt += i;
+		i = 1;
+		zcount = 0;
+	} while ((rem != 0) || (blkwp != blkwLim));
+	return (pt);
+}
+
+/*
+ * Each run is copied with one unaligned 4-byte load and store,
+ * with the bytes past the literals masked to zero; a later run
+ * overwrites whatever of this lands on its own coefficients.
+ */
+const u_char* nv_unpack(const u_char* bp, const u_char* end, int color,
+			u_int32_t* blk)
+{
+	static const union {
+		u_char b[4][4];
+		u_int32_t w[4];
+	} mask = {{
+		{ 0, 0, 0, 0 },
+		{ 0xff, 0, 0, 0 },
+		{ 0xff, 0xff, 0, 0 },
+		{ 0xff, 0xff, 0xff, 0 },
+	}};
+	u_char* cp = (u_char*)blk;
+	memset(blk, 0, 128);
+	int lim = color ? 128 : 64;
+	for (int i = 0; i < lim; ) {
+		if (bp >= end)
+			return (0);
+		int run = *bp++;
+		int j = run >> 6;
+		int k = run & 0x3f;
+		if (i + j + k > lim || end - bp < j)
+			return (0);
+		if (end - bp >= 4) {
+			u_int32_t w;
+			memcpy(&w, bp, 4);
+			w &= mask.w[j];
+			memcpy(cp + i, &w, 4);
+		} else {
+			for (int n = 0; n < j; ++n)
+				cp[i + n] = bp[n];
+		}
+		bp += j;
+		i += j + k;
+	}
+	return (bp);
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef vic_nv_block_h
+#define vic_nv_block_h
+
+#include "config.h"
+
+/*
+ * Block coding for the nv format, shared by the nv encoder and
+ * decoder.  A block is 8x8 luma pels and, for color, the 4x8 u and
+ * v pels beside them (4:2:2), coded as 64 or 128 signed bytes of
+ * Haar or DCT coefficients (chroma interleaved u,v).  On the wire
+ * each block is a sequence of runs, each a byte holding the number
+ * of literal coefficients that follow it (0-3) in the top two bits
+ * and the number of zeros after those in the rest.
+ *
+ * The transforms have SSE2 versions, used when the cpu has SSE2
+ * (see nv_simd()); they give the same results as the C versions.
+ */
+
+/* transform 8 rows starting at yp (and up, vp, if not 0) into out */
+void nv_fwd_haar(const u_char* yp, const u_char* up, const u_char* vp,
+		 int width, u_int32_t* out);
+void nv_fwd_dct(const u_char* yp, const u_char* up, const u_char* vp,
+		int width, u_int32_t* out);
+/* and back; up and vp may be 0 */
+void nv_rev_haar(const u_int32_t* in, u_char* yp, u_char* up, u_char* vp,
+		 int width);
+void nv_rev_dct(const u_int32_t* in, u_char* yp, u_char* up, u_char* vp,
+		int width);
+
+/* zero the small coefficients of a block before coding it */
+void nv_drop(u_int32_t* blk, int color, int loss);
+/* run-length code blk at pt; returns the end of the coded block */
+u_char* nv_pack(const u_int32_t* blk, int color, u_char* pt);
+/*
+ * Decode the block at bp into blk, which needs room for 131 bytes
+ * (the chroma of a gray block is left zero).  Returns the end of
+ * the coded block, or 0 if it is bad or runs past end.
+ */
+const u_char* nv_unpack(const u_char* bp, const u_char* end, int color,
+			u_int32_t* blk);
+
+/* use the SSE2 transforms if on and the cpu has them */
+void nv_simd(int on);
+int nv_simd();
+
+#endif
@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * nvbench - time the nv block coder, C and SSE2.
+ *
+ * usage: nvbench [-n passes] [-s wxh] [-q loss] [-c] [file]
+ *
+ * The input is one 4:2:2 planar frame of the given size (CIF by
+ * default) read from `file', or a synthetic frame if there's no
+ * file.  Every 8x8 block of the frame, with its chroma, is coded
+ * as NvEncoder does it (transform, drop the coefficients under
+ * `loss', run-length code) and decoded again as NvDecoder does it,
+ * `passes' times for each transform, and the rates are reported
+ * in blocks per second.
+ *
+ * -c	instead, check that the SSE2 transforms give the same coded
+ *	frame and the same decoded frame as the C ones, and the same
+ *	results on random blocks.  Exits with 1 if anything differs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "../config.h"
+#include "../bench.h"
+#include "nv-block.h"
+
+static int width = 352;
+static int height = 288;
+static int loss = 2;
+
+/*
+ * Code every block of the 4:2:2 frame f into bp and return the
+ * end of the coded data.
+ */
+static u_char* encode(int dct, const u_char* f, u_char* bp)
+{
+	int fs = width * height;
+	for (int y = 0; y < height; y += 8) {
+		for (int x = 0; x < width; x += 8) {
+			const u_char* yp = f + y * width + x;
+			const u_char* up = f + fs + (y * width >> 1) + (x >> 1);
+			const u_char* vp = up + (fs >> 1);
+			static u_int32_t block[32];
+			if (dct)
+				nv_fwd_dct(yp, up, vp, width, block);
+			else
+				nv_fwd_haar(yp, up, vp, width, block);
+			if (loss > 0)
+				nv_drop(block, 1, loss);
+			bp = nv_pack(block, 1, bp);
+		}
+	}
+	return (bp);
+}
+
+/*
+ * Decode what encode() left in [bp, ep) into the frame f.
+ * Returns -1 if the coded data is bad.
+ */
+static int decode(int dct, const u_char* bp, const u_char* ep, u_char* f)
+{
+	int fs = width * height;
+	for (int y = 0; y < height; y += 8) {
+		for (int x = 0; x < width; x += 8) {
+			u_char* yp = f + y * width + x;
+			u_char* up = f + fs + (y * width >> 1) + (x >> 1);
+			u_char* vp = up + (fs >> 1);
+			static u_int32_t block[33];
+			bp = nv_unpack(bp, ep, 1, block);
+			if (bp == 0)
+				return (-1);
+			if (dct)
+				nv_rev_dct(block, yp, up, vp, width);
+			else
+				nv_rev_haar(block, yp, up, vp, width);
+		}
+	}
+	return (0);
+}
+
+static const char* name[] = { "haar", "dct" };
+
+/*
+ * Code and decode the frame with both transforms, C and SSE2,
+ * and compare.
+ */
+static int check_frame(const u_char* f)
+{
+	int fs = 2 * width * height;
+	int nblk = fs / 128;
+	int bad = 0;
+	u_char* cb[2];
+	u_char* ce[2];
+	u_char* df[2];
+	for (int dct = 0; dct < 2; ++dct) {
+		for (int s = 0; s < 2; ++s) {
+			nv_simd(s);
+			cb[s] = new u_char[nblk * 160];
+			ce[s] = encode(dct, f, cb[s]);
+			df[s] = new u_char[fs];
+			memset(df[s], 0, fs);
+			if (decode(dct, cb[s], ce[s], df[s]) < 0) {
+				printf("%s: %s stream does not decode\n",
+				       name[dct], s ? "sse2" : "c");
+				bad = 1;
+			}
+		}
+		if (ce[0] - cb[0] != ce[1] - cb[1] ||
+		    memcmp(cb[0], cb[1], ce[0] - cb[0]) != 0) {
+			printf("%s: coded frames differ\n", name[dct]);
+			bad = 1;
+		}
+		if (memcmp(df[0], df[1], fs) != 0) {
+			printf("%s: decoded frames differ\n", name[dct]);
+			bad = 1;
+		}
+		printf("%s: %d bytes, luma psnr %.2f\n", name[dct],
+		       int(ce[0] - cb[0]), bench_psnr(f, df[0], width * height));
+		for (int s = 0; s < 2; ++s) {
+			delete[] cb[s];
+			delete[] df[s];
+		}
+	}
+	return (bad);
+}
+
+/*
+ * Run random blocks through the transforms and the run-length
+ * coder: pels through the forward transforms, coefficients (any
+ * byte at all) through the inverse ones, and sparse coefficient
+ * blocks through nv_pack and nv_unpack.
+ */
+static int check_random(int n)
+{
+	const int stride = 16;
+	u_char in[3][8 * stride];
+	u_char out[2][3][8 * stride];
+	u_int32_t cf[2][33];
+	int bad[5];
+	memset(bad, 0, sizeof(bad));
+	srandom(1);
+	for (int k = 0; k < n; ++k) {
+		for (int p = 0; p < 3; ++p)
+			for (int i = 0; i < 8 * stride; ++i)
+				in[p][i] = random();
+		for (int dct = 0; dct < 2; ++dct) {
+			for (int s = 0; s < 2; ++s) {
+				nv_simd(s);
+				if (dct)
+					nv_fwd_dct(in[0], in[1], in[2], stride,
+						   cf[s]);
+				else
+					nv_fwd_haar(in[0], in[1], in[2], stride,
+						    cf[s]);
+			}
+			if (memcmp(cf[0], cf[1], 128) != 0)
+				++bad[dct];
+			memcpy(cf[0], in[0], 128);
+			for (int s = 0; s < 2; ++s) {
+				nv_simd(s);
+				memset(out[s], 0, sizeof(out[s]));
+				if (dct)
+					nv_rev_dct(cf[0], out[s][0], out[s][1],
+						   out[s][2], stride);
+				else
+					nv_rev_haar(cf[0], out[s][0], out[s][1],
+						    out[s][2], stride);
+			}
+			if (memcmp(out[0], out[1], sizeof(out[0])) != 0)
+				++bad[2 + dct];
+		}
+		u_char* cp = (u_char*)cf[0];
+		for (int i = 0; i < 128; ++i)
+			cp[i] = (random() & 3) == 0 ? random() : 0;
+		int color = k & 1;
+		u_char buf[256];
+		u_char* ep = nv_pack(cf[0], color, buf);
+		if (nv_unpack(buf, ep, color, cf[1]) != ep ||
+		    memcmp(cf[0], cf[1], color ? 128 : 64) != 0)
+			++bad[4];
+	}
+	static const char* what[] = {
+		"forward haar", "forward dct", "inverse haar", "inverse dct",
+		"run-length"
+	};
+	int r = 0;
+	for (int i = 0; i < 5; ++i) {
+		printf("%s: %d of %d random blocks differ\n", what[i], bad[i],
+		       n);
+		r |= bad[i] != 0;
+	}
+	return (r);
+}
+
+static const char synopsis[] =
+	"nvbench [-n passes] [-s wxh] [-q loss] [-c] [file]\n";
+
+int main(int argc, char** argv)
+{
+	int npass = 50;
+	int check = 0;
+	int op;
+	while ((op = getopt(argc, argv, "n:s:q:c")) != -1) {
+		switch (op) {
+		case 'n':
+			npass = atoi(optarg);
+			break;
+		case 's':
+			if (!bench_size(optarg, &width, &height))
+				bench_usage(synopsis);
+			break;
+		case 'q':
+			loss = atoi(optarg);
+			break;
+		case 'c':
+			check = 1;
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind < argc - 1 || npass <= 0 || loss < 0 ||
+	    width <= 0 || (width & 15) != 0 || height <= 0 || (height & 7) != 0)
+		bench_usage(synopsis);
+
+	int fs = 2 * width * height;
+	u_char* f = new u_char[fs];
+	if (optind < argc) {
+		FILE* fp = fopen(argv[optind], "rb");
+		if (fp == 0) {
+			perror(argv[optind]);
+			exit(1);
+		}
+		if (fread(f, 1, fs, fp) != (size_t)fs) {
+			fprintf(stderr, "nvbench: %s: short frame\n",
+				argv[optind]);
+			exit(1);
+		}
+		fclose(fp);
+	} else {
+		/* smooth luma with some texture, slow chroma */
+		int cw = width >> 1;
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x)
+				f[y * width + x] = int(128 +
+					64 * sin(x * 0.05) * cos(y * 0.07) +
+					32 * sin((x + 3 * y) * 0.6));
+			for (int x = 0; x < cw; ++x) {
+				f[width * height + y * cw + x] =
+					128 + ((x + y) & 63) - 32;
+				f[width * height * 3 / 2 + y * cw + x] =
+					128 + ((x - y) & 31) - 16;
+			}
+		}
+	}
+
+	if (check) {
+		int bad = check_frame(f);
+		bad |= check_random(200000);
+		return (bad);
+	}
+
+	int nblk = fs / 128;
+	u_char* cb = new u_char[nblk * 160];
+	u_char* df = new u_char[fs];
+	int simd = nv_simd();
+	printf("%dx%d, loss %d, %d passes; blocks/sec\n", width, height, loss,
+	       npass);
+	printf("%-6s %10s %10s %10s %10s\n", "", "enc c", "enc sse2",
+	       "dec c", "dec sse2");
+	for (int dct = 0; dct < 2; ++dct) {
+		double rate[2][2];
+		for (int s = 0; s < 2; ++s) {
+			nv_simd(s);
+			double t0 = bench_now();
+			u_char* ce = 0;
+			for (int i = 0; i < npass; ++i)
+				ce = encode(dct, f, cb);
+			double t1 = bench_now();
+			for (int i = 0; i < npass; ++i)
+				(void)decode(dct, cb, ce, df);
+			double t2 = bench_now();
+			rate[s][0] = npass * nblk / (t1 - t0);
+			rate[s][1] = npass * nblk / (t2 - t1);
+		}
+		printf("%-6s %10.0f %10.0f %10.0f %10.0f\n", name[dct],
+		       rate[0][0], rate[1][0], rate[0][1], rate[1][1]);
+	}
+	if (!simd)
+		printf("(no sse2: both columns are C)\n");
+	return (0);
+}
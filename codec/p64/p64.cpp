@@ -44,8 +44,48 @@ typedef __int64 intptr_t;
 #include "p64.h"
 #include "p64-huff.h"
 #include "dct.h"
+#include "framepool.h"
 #include "bsd-endian.h"
 
+/*
+ * SSE2 versions of the loop filter and motion-compensated
+ * block copies.  On gcc these are compiled for SSE2 even when
+ * the rest of the file isn't, and are only called if the cpu
+ * turns out to have it (see P64Decoder::simd()).
+ */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define P64_SSE2 __attribute__((target("sse2")))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define P64_SSE2
+#endif
+
+#ifdef P64_SSE2
+#include <emmintrin.h>
+#ifdef RUNTIME_CPUDETECT
+extern "C" {
+#include "cpu/cpudetect.h"
+}
+#endif
+#endif
+
+int P64Decoder::simd_ = -1;
+
+void P64Decoder::simd(int on)
+{
+	simd_ = 0;
+#ifdef P64_SSE2
+	if (on) {
+#ifdef RUNTIME_CPUDETECT
+		simd_ = (cpu_check() & FF_CPU_SSE2) != 0;
+#elif defined(__SSE2__) || defined(_M_X64)
+		simd_ = 1;
+#endif
+	}
+#else
+	UNUSED(on);
+#endif
+}
+
 void P64Decoder::err(const char* msg ...) const
 {
 #ifndef DEVELOPMENT_VERSION
@@ -56,26 +96,34 @@ void P64Decoder::err(const char* msg ...) const
 	vfprintf(stderr, msg, ap);
 	fprintf(stderr, " @g%d m%d %d/%d of %d/%d: %04x %04x %04x %04x|%04x\n",
 		gob_, mba_,
-		(int)((u_char*)bs_ - (u_char*)ps_), nbb_,
-		(int)((u_char*)es_ - (u_char*)ps_), pebit_,
-	       bs_[-4], bs_[-3], bs_[-2], bs_[-1], bs_[0]);
+		(int)(bs_ - ps_), nbb_, (int)(es_ - ps_), pebit_,
+		bs_[-8] << 8 | bs_[-7], bs_[-6] << 8 | bs_[-5],
+		bs_[-4] << 8 | bs_[-3], bs_[-2] << 8 | bs_[-1],
+		bs_[0] << 8 | bs_[1]);
 #endif
 }
 
 //SV-XXX: rearranged intialistaion order to shut upp gcc4
 P64Decoder::P64Decoder()
-	: fs_(0), front_(0), back_(0),
+	: scale_(0), fs_(0), front_(0), back_(0), mbstab_(mb_state_), shared_(0),
 	  ngob_(0), maxgob_(0), ndblk_(0), gobquant_(0), mt_(0), gob_(0), mba_(0), mvdh_(0), mvdv_(0),
 	  marks_(0), mark_(0), bad_psc_(0), bad_bits_(0), bad_GOBno_(0), bad_fmt_(0)
 {
 	fmt_ = IT_CIF;/*XXX*/
 	inithuff();
 	initquant();
+	if (simd_ < 0)
+		simd(1);
 }
 
 P64Decoder::~P64Decoder()
 {
-	delete[] fs_;
+	FramePool::release(fs_);
+}
+
+int P64Decoder::framemem() const
+{
+	return (fs_ != 0 ? FramePool::size(fs_) : 0);
 }
 
 void P64Decoder::init()
@@ -119,55 +167,18 @@ void P64Decoder::init()
 	marks_ = 0;
 }
 
-#if BYTE_ORDER == LITTLE_ENDIAN
-#define HUFFRQ(bs, bb) \
- { \
-	register int t = *bs++; \
-	bb <<= 16; \
-	bb |= (t & 0xff) << 8; \
-	bb |= t >> 8; \
-}
-#else
-#define HUFFRQ(bs, bb) \
- { \
-	bb <<= 16; \
-	bb |= *bs++; \
-}
-#endif
-
 #define MASK(s) ((1 << (s)) - 1)
 
-#define HUFF_DECODE(bs, ht, nbb, bb, result) { \
-	register int s__, v__; \
- \
-	if (nbb < 16) { \
-		HUFFRQ(bs, bb); \
-		nbb += 16; \
-	} \
-	s__ = ht.maxlen; \
-	v__ = (bb >> (nbb - s__)) & MASK(s__); \
-	s__ = (ht.prefix)[v__]; \
-	nbb -= (s__ & 0x1f); \
-	result = s__ >> 5; \
- }
-
-#define GET_BITS(bs, n, nbb, bb, result) \
-{ \
-	nbb -= n; \
-	if (nbb < 0)  { \
-		HUFFRQ(bs, bb); \
-		nbb += 16; \
-	} \
-	(result) = ((bb >> nbb) & MASK(n)); \
-}
+#define HUFF_DECODE(bs, ht, nbb, bb, result) \
+	BITS_HUFF(bs, ht.prefix, ht.maxlen, nbb, bb, result)
+
+#define GET_BITS(bs, n, nbb, bb, result) BITS_GET(bs, n, nbb, bb, result)
 
 #define SKIP_BITS(bs, n, nbb, bb) \
 { \
 	nbb -= n; \
-	if (nbb < 0)  { \
-		HUFFRQ(bs, bb); \
-		nbb += 16; \
-	} \
+	if (nbb < 0) \
+		BITS_FILL(bs, nbb, bb); \
 }
 
 /*
@@ -230,7 +241,7 @@ int P64Decoder::parse_block(short* blk, u_int* mask)
 	 * Cache bit buffer in registers.
 	 */
 	register int nbb = nbb_;
-	register int bb = bb_;
+	bitbuf bb = bb_;
 	register short* qt = qt_;
 
 	int k;
@@ -347,8 +358,69 @@ int P64Decoder::parse_block(short* blk, u_int* mask)
  * two 16-bit adds in a 32-bit register, or four 16-bit adds
  * in a 64-bit register.
  */
+#ifdef P64_SSE2
+/*
+ * The SSE2 filter does a whole row of the block at once, in
+ * 16-bit lanes.  Both passes compute four times the filtered
+ * value, with the edge taps as (0 4 0) instead of (0 1 0), so
+ * that every output pixel is (sum + 8) >> 4.  This is exact,
+ * since (4s + 8) >> 4 == (s + 2) >> 2 along the edges and
+ * 16s >> 4 == s at the corners.
+ */
+P64_SSE2
+static void filter_sse2(const u_char* in, u_char* out, u_int stride)
+{
+	const __m128i zero = _mm_setzero_si128();
+	/* lanes 0 and 7 */
+	const __m128i edge = _mm_set_epi16(-1, 0, 0, 0, 0, 0, 0, -1);
+	const __m128i rnd = _mm_set1_epi16(8);
+
+	__m128i r[8];
+	for (int k = 0; k < 8; ++k) {
+		r[k] = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)in),
+					 zero);
+		in += stride;
+	}
+	for (int k = 0; k < 8; ++k) {
+		/* vertical pass */
+		__m128i v;
+		if (k == 0 || k == 7)
+			v = _mm_slli_epi16(r[k], 2);
+		else
+			v = _mm_add_epi16(_mm_add_epi16(r[k - 1], r[k + 1]),
+					  _mm_slli_epi16(r[k], 1));
+		/* horizontal pass */
+		__m128i h = _mm_add_epi16(_mm_slli_si128(v, 2),
+					  _mm_srli_si128(v, 2));
+		h = _mm_add_epi16(h, _mm_slli_epi16(v, 1));
+		h = _mm_or_si128(_mm_and_si128(edge, _mm_slli_epi16(v, 2)),
+				 _mm_andnot_si128(edge, h));
+		h = _mm_srli_epi16(_mm_add_epi16(h, rnd), 4);
+		_mm_storel_epi64((__m128i*)out, _mm_packus_epi16(h, h));
+		out += stride;
+	}
+}
+
+P64_SSE2
+static void mvblk_sse2(const u_char* in, u_char* out, u_int stride)
+{
+	for (int k = 8; --k >= 0; ) {
+		_mm_storel_epi64((__m128i*)out,
+				 _mm_loadl_epi64((const __m128i*)in));
+		in += stride;
+		out += stride;
+	}
+}
+#endif
+
 void P64Decoder::filter(u_char* in, u_char* out, u_int stride)
 {
+#ifdef P64_SSE2
+	if (simd_) {
+		filter_sse2(in, out, stride);
+		return;
+	}
+#endif
 	/* Corner pixel has filter coef 1 */
 	u_int s = in[0];
 	u_int o = 0;
@@ -589,6 +661,12 @@ void P64Decoder::filter(u_char* in, u_char* out, u_int stride)
 
 void P64Decoder::mvblka(u_char* in, u_char* out, u_int stride)
 {
+#ifdef P64_SSE2
+	if (simd_) {
+		mvblk_sse2(in, out, stride);
+		return;
+	}
+#endif
 #ifdef INT_64
 	*(INT_64*)out = *(INT_64*)in;
 	out += stride; in += stride;
@@ -617,6 +695,13 @@ void P64Decoder::mvblka(u_char* in, u_char* out, u_int stride)
 
 void P64Decoder::mvblk(u_char* in, u_char* out, u_int stride)
 {
+#ifdef P64_SSE2
+	/* unaligned loads are no slower than aligned ones */
+	if (simd_) {
+		mvblk_sse2(in, out, stride);
+		return;
+	}
+#endif
 #ifdef INT_64
 	if (((u_long)in & 7) == 0) {
 		mvblka(in, out, stride);
@@ -654,6 +739,13 @@ int P64Decoder::parse_picture_hdr()
 	GET_BITS(bs_, 6, nbb_, bb_, pt);
 	int fmt = (pt >> 2) & 1;
 	if (fmt_ != fmt) {
+		/*
+		 * Can't reallocate someone else's frame out from
+		 * under them.  The owner should have seen this
+		 * header first (see prepare()).
+		 */
+		if (shared_)
+			return (-1);
 		/* change formats */
 		fmt_ = fmt;
 		init();
@@ -727,7 +819,7 @@ int P64Decoder::parse_gob_hdr(int ebit)
 		 * are a start code and throw them away.
 		 * But first check that we have the bits.
 		 */
-		int nbit = ((es_ - bs_) << 4) + nbb_ - ebit;
+		int nbit = ((es_ - bs_) << 3) + nbb_ - ebit;
 		if (nbit < 20)
 			return (0);
 
@@ -868,6 +960,17 @@ void P64Decoder::decode_block(u_int tc, u_int x, u_int y, u_int stride,
 	if (tc != 0)
 		nc = parse_block(blk, MASK_REF);
 
+	if (scale_ != 0) {
+#ifdef INT_64
+		decode_reduced(tc, blk, tc != 0 ? u_int(mask) : 0, x, y,
+			       stride, front, back, sf);
+#else
+		decode_reduced(tc, blk, tc != 0 ? mask[0] : 0, x, y,
+			       stride, front, back, sf);
+#endif
+		return;
+	}
+
 	int off = y * stride + x;
 	u_char* out = front + off;
 
@@ -943,6 +1046,40 @@ void P64Decoder::decode_block(u_int tc, u_int x, u_int y, u_int stride,
 	}
 }
 
+/*
+ * decode_block() at a reduced size: the block at x, y is 8 >> scale_
+ * pixels on a side, and only its low order coefficients are
+ * transformed (rdct_down(), which with just the DC gives its mean).
+ * Motion vectors shrink with the picture, and the loop filter is
+ * left out, since at this size it smooths next to nothing.
+ */
+void P64Decoder::decode_reduced(u_int tc, const short* blk, u_int m0,
+				u_int x, u_int y, u_int stride,
+				u_char* front, u_char* back, int sf)
+{
+	int n = 8 >> scale_;
+	int off = y * stride + x;
+	u_char* out = front + off;
+	const u_char* in = back + off;
+	if ((mt_ & (MT_INTRA|MT_MVD)) == MT_MVD) {
+		int sx = x + mvdh_ / (sf << scale_);
+		int sy = y + mvdv_ / (sf << scale_);
+		in = back + sy * (int)stride + sx;
+	}
+	if (tc != 0) {
+		if (mt_ & MT_INTRA)
+			in = 0;
+		rdct_down(scale_, blk, m0, 0, 0, out, stride, in);
+	} else if (in != out) {
+		/* the block as it was, or where the vector points */
+		for (int k = n; --k >= 0; ) {
+			memcpy(out, in, n);
+			in += stride;
+			out += stride;
+		}
+	}
+}
+
 /*
  * Decompress the next macroblock.  Return 0 if the macroblock
  * was present (with no errors).  Return SYM_STARTCODE (-1),
@@ -983,17 +1120,20 @@ int P64Decoder::decode_mb()
 	 * (This code assumes MT_TCOEFF is 1.)
 	 */
 	register u_int tc = mt_ & MT_TCOEFF;
-	register u_int s = width_;
-	decode_block(tc & (cbp >> 5), x, y, s, front_, back_, 1);
-	decode_block(tc & (cbp >> 4), x + 8, y, s, front_, back_, 1);
-	decode_block(tc & (cbp >> 3), x, y + 8, s, front_, back_, 1);
-	decode_block(tc & (cbp >> 2), x + 8, y + 8, s, front_, back_, 1);
+	register u_int s = width_ >> scale_;
+	u_int bx = x >> scale_;
+	u_int by = y >> scale_;
+	u_int b = 8 >> scale_;
+	decode_block(tc & (cbp >> 5), bx, by, s, front_, back_, 1);
+	decode_block(tc & (cbp >> 4), bx + b, by, s, front_, back_, 1);
+	decode_block(tc & (cbp >> 3), bx, by + b, s, front_, back_, 1);
+	decode_block(tc & (cbp >> 2), bx + b, by + b, s, front_, back_, 1);
 	s >>= 1;
-	int off = size_;
-	decode_block(tc & (cbp >> 1), x >> 1, y >> 1, s,
+	int off = lsize();
+	decode_block(tc & (cbp >> 1), bx >> 1, by >> 1, s,
 		     front_ + off, back_ + off, 2);
-	off += size_ >> 2;
-	decode_block(tc & (cbp >> 0), x >> 1, y >> 1, s,
+	off += lsize() >> 2;
+	decode_block(tc & (cbp >> 0), bx >> 1, by >> 1, s,
 		     front_ + off, back_ + off, 2);
 
 	mbst_[mba_] = MBST_NEW;
@@ -1004,14 +1144,17 @@ int P64Decoder::decode_mb()
 	 * rather than the entire image on each frame.
 	 */
 	if (marks_) {
-		/* convert to 8x8 block offset */
-		off = (x >> 3) + (y >> 3) * (width_ >> 3);
+		/* convert to 8x8 block offset (of the image as decoded) */
+		int sh = 3 + scale_;
+		off = (x >> sh) + (y >> sh) * (width_ >> sh);
 		int m = mark_;
 		marks_[off] = m;
-		marks_[off + 1] = m;
-		off += width_ >> 3;
-		marks_[off] = m;
-		marks_[off + 1] = m;
+		if (scale_ == 0) {
+			marks_[off + 1] = m;
+			off += width_ >> 3;
+			marks_[off] = m;
+			marks_[off + 1] = m;
+		}
 	}
 	return (0);
 }
@@ -1037,29 +1180,13 @@ int P64Decoder::decode_mb()
 int P64Decoder::decode(const u_char* bp, int cc, int sbit, int ebit,
 		       int mba, int gob, int mq, int mvdh, int mvdv)
 {
-	ps_ = (u_short*)bp;
-	/*
-	 * If cc is odd, ignore 8 extra bits in last short.
-	 */
-	int odd = cc & 1;
-	ebit += odd << 3;
+	ps_ = bp;
 	pebit_ = ebit;
-	es_ = (u_short*)(bp + ((cc - 1) &~ 1));
-
-	/*
-	 * If input buffer not aligned, prime bit-buffer
-	 * with 8 bits; otherwise, prime it with a 16.
-	 */
-	//if ((int)bp & 1) {
-	if ((intptr_t)bp & 1) { //SV-XXX: Debian bug 297949
-		bs_ = (u_short*)(bp + 1);
-		bb_ = *bp;
-		nbb_ = 8 - sbit;
-	} else {
-		bs_ = (u_short*)bp;
-		HUFFRQ(bs_, bb_);
-		nbb_ = 16 - sbit;
-	}
+	es_ = bp + cc;
+	bs_ = bp;
+	bb_ = 0;
+	nbb_ = -sbit;
+	BITS_FILL(bs_, nbb_, bb_);
 
 	mba_ = mba;
 	qt_ = &quant_[mq << 8];
@@ -1072,8 +1199,8 @@ int P64Decoder::decode(const u_char* bp, int cc, int sbit, int ebit,
 			gob >>= 1;
 	}
 
-	while (bs_ < es_ || (bs_ == es_ && nbb_ > ebit)) {
-		mbst_ = &mb_state_[gob << 6];
+	while (((es_ - bs_) << 3) + nbb_ > ebit) {
+		mbst_ = &mbstab_[gob << 6];
 		coord_ = &base_[gob << 6];
 
 		ndblk_++;
@@ -1096,6 +1223,148 @@ int P64Decoder::decode(const u_char* bp, int cc, int sbit, int ebit,
 	return (1);
 }
 
+/*
+ * Check for a picture header at the start of a packet and,
+ * if it announces a different format, switch to it now.  This
+ * lets a caller that hands packets to SliceP64Decoders make sure
+ * the frame is the right size before any of them start.
+ * Returns true if the format changed.
+ */
+int P64Decoder::prepare(const u_char* bp, int cc, int sbit)
+{
+	/* PSC (16 bits), GN (4), TR (5), PTYPE (6) */
+	if (cc < 5)
+		return (0);
+	u_int v = bp[0] << 24 | bp[1] << 16 | bp[2] << 8 | bp[3];
+	v = v << sbit | bp[4] >> (8 - sbit);
+	if ((v >> 12) != 0x00010)
+		return (0);
+	int fmt = (v >> 3) & 1;
+	if (fmt == (int)fmt_)
+		return (0);
+	fmt_ = fmt;
+	init();
+	return (1);
+}
+
+/*
+ * Set up to decode into the current frame of `master'.
+ * Error and block counts start again from zero and are
+ * folded back into the master with merge().
+ */
+void P64Decoder::share(const P64Decoder& m)
+{
+	shared_ = 1;
+	fmt_ = m.fmt_;
+	ngob_ = m.ngob_;
+	width_ = m.width_;
+	height_ = m.height_;
+	size_ = m.size_;
+	scale_ = m.scale_;
+	front_ = m.front_;
+	back_ = m.back_;
+	mbstab_ = m.mbstab_;
+	marks_ = m.marks_;
+	mark_ = m.mark_;
+	memcpy(base_, m.base_, sizeof(base_));
+
+	minx_ = width_;
+	miny_ = height_;
+	maxx_ = 0;
+	maxy_ = 0;
+	maxgob_ = 0;
+	ndblk_ = 0;
+	bad_psc_ = 0;
+	bad_bits_ = 0;
+	bad_GOBno_ = 0;
+	bad_fmt_ = 0;
+}
+
+void P64Decoder::merge(const P64Decoder& s)
+{
+	bad_psc_ += s.bad_psc_;
+	bad_bits_ += s.bad_bits_;
+	bad_GOBno_ += s.bad_GOBno_;
+	bad_fmt_ += s.bad_fmt_;
+	if (s.ndblk_ == 0)
+		return;
+	ndblk_ += s.ndblk_;
+	gobquant_ = s.gobquant_;
+	if (s.maxgob_ > maxgob_)
+		maxgob_ = s.maxgob_;
+	if (s.minx_ < minx_)
+		minx_ = s.minx_;
+	if (s.miny_ < miny_)
+		miny_ = s.miny_;
+	if (s.maxx_ > maxx_)
+		maxx_ = s.maxx_;
+	if (s.maxy_ > maxy_)
+		maxy_ = s.maxy_;
+}
+
+/*
+ * Scale the planes of a frame decoded at 1 / (1 << scale) of the
+ * size to scale_: averaging when it shrinks, and repeating pixels
+ * when it grows.
+ */
+void P64Decoder::resample(const u_char* in, int scale, u_char* out) const
+{
+	for (int c = 0; c < 3; ++c) {
+		int sub = c != 0;
+		int iw = width_ >> (scale + sub);
+		int ih = height_ >> (scale + sub);
+		int ow = width_ >> (scale_ + sub);
+		int oh = height_ >> (scale_ + sub);
+		int x, y;
+		if (scale_ > scale) {
+			int f = iw / ow;
+			int sh = 2 * (scale_ - scale);
+			for (y = 0; y < oh; ++y) {
+				const u_char* row = in + y * f * iw;
+				for (x = 0; x < ow; ++x) {
+					const u_char* p = row + x * f;
+					int sum = 0;
+					for (int i = 0; i < f; ++i, p += iw)
+						for (int j = 0; j < f; ++j)
+							sum += p[j];
+					*out++ = (sum + (f * f >> 1)) >> sh;
+				}
+			}
+		} else {
+			int sh = scale - scale_;
+			for (y = 0; y < oh; ++y)
+				for (x = 0; x < ow; ++x)
+					*out++ = in[(y >> sh) * iw + (x >> sh)];
+		}
+		in += iw * ih;
+	}
+}
+
+/*
+ * Conditional replenishment only sends the blocks that change, so
+ * the frames so far are scaled over to the new size rather than
+ * started again from gray.
+ */
+void P64Decoder::scale(int s)
+{
+	if (s == scale_)
+		return;
+	u_char* fs = fs_;
+	u_char* front = front_;
+	u_char* back = back_;
+	int os = scale_;
+	/* allocate() would give the old frames back */
+	fs_ = 0;
+	scale_ = s;
+	allocate();
+	if (fs != 0) {
+		resample(back, os, back_);
+		if (front_ != back_)
+			resample(front, os, front_);
+		FramePool::release(fs);
+	}
+}
+
 FullP64Decoder::FullP64Decoder()
 {
 	init();
@@ -1103,9 +1372,9 @@ FullP64Decoder::FullP64Decoder()
 
 void FullP64Decoder::allocate()
 {
-	delete[] fs_; //SV-XXX: Debian
-	int n = size_ + (size_ >> 1);
-	fs_ = new u_char[2 * n];
+	FramePool::release(fs_);
+	int n = lsize() + (lsize() >> 1);
+	fs_ = FramePool::alloc(2 * n);
 	/* initialize to gray */
 	memset(fs_, 0x80, 2 * n);
 	front_ = fs_;
@@ -1145,6 +1414,10 @@ void FullP64Decoder::mbcopy(u_int mba)
 	x >>= 8;
 	x <<= 3;
 
+	if (scale_ != 0) {
+		mbcopy_reduced(x, y);
+		return;
+	}
 	u_int stride = width_;
 	u_int off = y * stride + x;
 	u_char* in = back_ + off;
@@ -1170,6 +1443,31 @@ void FullP64Decoder::mbcopy(u_int mba)
 	mvblka(in, out, stride);
 }
 
+/* mbcopy() of a macroblock 16 >> scale_ pixels on a side */
+void FullP64Decoder::mbcopy_reduced(u_int x, u_int y)
+{
+	int n = 16 >> scale_;
+	u_int stride = width_ >> scale_;
+	x >>= scale_;
+	y >>= scale_;
+	u_int off = y * stride + x;
+	for (int c = 0; c < 3; ++c) {
+		const u_char* in = back_ + off;
+		u_char* out = front_ + off;
+		for (int k = n; --k >= 0; ) {
+			memcpy(out, in, n);
+			in += stride;
+			out += stride;
+		}
+		if (c == 0) {
+			n >>= 1;
+			stride >>= 1;
+			off = lsize() + (y >> 1) * stride + (x >> 1);
+		} else
+			off += lsize() >> 2;
+	}
+}
+
 void P64Decoder::sync()
 {
 	bbx_ = minx_;
@@ -1189,7 +1487,7 @@ void FullP64Decoder::sync()
 {
 	for (int k = 0; k < ngob_; ++k) {
 		coord_ = &base_[k << 6];
-		u_char* mbst = &mb_state_[k << 6];
+		u_char* mbst = &mbstab_[k << 6];
 		for (int mba = 0; mba < MBPERGOB; ++mba) {
 			int s = mbst[mba];
 			if (s == MBST_FRESH) {
@@ -1210,9 +1508,9 @@ IntraP64Decoder::IntraP64Decoder()
 
 void IntraP64Decoder::allocate()
 {
-	delete[] fs_; //SV-XXX: Debian
-	int n = size_ + (size_ >> 1);
-	fs_ = new u_char[n];
+	FramePool::release(fs_);
+	int n = lsize() + (lsize() >> 1);
+	fs_ = FramePool::alloc(n);
 	/* initialize to gray */
 	memset(fs_, 0x80, n);
 	front_ = back_ = fs_;
@@ -31,6 +31,7 @@
 #define lib_p64_h
 
 #include <sys/types.h>
+#include "bitio.h"
 
 struct huffcode;
 
@@ -44,6 +45,8 @@ class P64Decoder {
 	inline void resetndblk() { ndblk_ = 0; }
 	inline int width() const { return (width_); }
 	inline int height() const { return (height_); }
+	/* the frame buffers (from the FramePool), bytes */
+	int framemem() const;
 	virtual int decode(const u_char* bp, int cc,
 			   int sbit, int ebit, int mba, int gob,
 			   int quant, int mvdh, int mvdv);
@@ -60,6 +63,25 @@ class P64Decoder {
 
 	inline void marks(u_char* p) { marks_ = p; }
 	inline void mark(int v) { mark_ = v; }
+
+	int prepare(const u_char* bp, int cc, int sbit);
+	void share(const P64Decoder& master);
+	void merge(const P64Decoder& slice);
+
+	/*
+	 * Decode at 1 / (1 << s) of the size (s is 0, 1 or 2), from
+	 * the low order coefficients of each block.  frame() is then
+	 * width() >> s by height() >> s.  Only between frames.
+	 */
+	void scale(int s);
+	inline int scale() const { return (scale_); }
+
+	/*
+	 * Use the SSE2 loop filter and block copies if the
+	 * cpu has them (the default), or the portable code.
+	 */
+	static void simd(int on);
+	static inline int simd() { return (simd_); }
     protected:
 	P64Decoder();
 	void init();
@@ -75,9 +97,14 @@ class P64Decoder {
 #endif
 	void decode_block(u_int tc, u_int x, u_int y, u_int stride,
 			  u_char* front, u_char* back, int sf);
+	void decode_reduced(u_int tc, const short* blk, u_int m0,
+			    u_int x, u_int y, u_int stride,
+			    u_char* front, u_char* back, int sf);
+	void resample(const u_char* in, int scale, u_char* out) const;
 	void filter(u_char* in, u_char* out, u_int stride);
 	void mvblk(u_char* in, u_char* out, u_int stride);
 	void mvblka(u_char*, u_char*, u_int stride);
+	static int simd_;
 
 	int parse_picture_hdr();
 	int parse_sc();
@@ -87,6 +114,9 @@ class P64Decoder {
 	int decode_mb();
 
 	u_int size_;
+	int scale_;		/* decoding at 1 / (1 << scale_) size */
+	/* size of the Y component as decoded */
+	inline u_int lsize() const { return (size_ >> (scale_ << 1)); }
 	u_char* fs_;
 	u_char* front_;
 	u_char* back_;
@@ -101,17 +131,19 @@ class P64Decoder {
 	hufftab ht_tcoeff_;
 	hufftab ht_mtype_;
 
-	u_int bb_;		/* 32-bit bit buffer */
+	bitbuf bb_;		/* bit buffer (bitio.h) */
 	int nbb_;		/* number bits in bit buffer */
-	const u_short* bs_;	/* input bit stream (less bits in bb_) */
-	const u_short* es_;	/* pointer to end if input stream */
-	const u_short* ps_;	/* packet start (for error reporting) */
+	const u_char* bs_;	/* input bit stream (less bits in bb_) */
+	const u_char* es_;	/* end of input stream */
+	const u_char* ps_;	/* packet start (for error reporting) */
 	int pebit_;		/* packet end bit (for error reporting) */
 
 #define MBST_FRESH	0
 #define MBST_OLD	1
 #define MBST_NEW	2
 	u_char* mbst_;
+	u_char* mbstab_;	/* mb_state_, or the master's (see share()) */
+	int shared_;		/* true if decoding into another's frame */
 	short* qt_;
 	u_short* coord_;
 
@@ -167,6 +199,7 @@ class FullP64Decoder : public P64Decoder {
     protected:
 	virtual void allocate();
 	void mbcopy(u_int mba);
+	void mbcopy_reduced(u_int x, u_int y);
 	void swap();
 	virtual void sync();
 };
@@ -178,4 +211,17 @@ class IntraP64Decoder : public P64Decoder {
 	virtual void allocate();
 };
 
+/*
+ * A decoder with no frame of its own.  After share(), it decodes
+ * into the frame of a Full or Intra decoder, so that several
+ * packets of the same frame can be decoded at once (each packet
+ * covers its own set of macroblocks).
+ */
+class SliceP64Decoder : public P64Decoder {
+    public:
+	SliceP64Decoder() {}
+    protected:
+	virtual void allocate() {}
+};
+
 #endif
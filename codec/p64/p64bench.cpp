@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * p64bench - time the H.261 decoder on a recorded stream.
+ *
+ * usage: p64bench [-n passes] [-s] [-c] [-r scale] file
+ *
+ * The input is a raw H.261 bit stream (e.g., what ffmpeg writes with
+ * "-f h261").  It is split into pictures at each picture start code,
+ * and each picture is handed to the decoder as if it had arrived in
+ * a single packet.  The whole stream is decoded `passes' times and
+ * the decode rate is reported in macroblocks per second.
+ *
+ * -s	use the portable C loop filter and block copies, not SSE2.
+ * -c	decode each picture with both and check that the results
+ *	are identical.
+ * -r	time decoding at 1 / (1 << scale) of the size as well (scale
+ *	1 or 2, as for a thumbnail; P64Decoder::scale()), and print
+ *	the cpu each picture took both ways.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../config.h"
+#include "../bench.h"
+#include "p64.h"
+
+/*
+ * Return the bit offset of the next picture start code
+ * (0000 0000 0000 0001 0000) at or after bit `pos', or
+ * `nbit' if there isn't one.  The buffer must be padded
+ * with BITS_PAD zero bytes, for the decoder's reads past the
+ * end of the last picture (see bitio.h).
+ */
+static int next_psc(const u_char* bp, int nbit, int pos)
+{
+	for (; pos + 20 <= nbit; ++pos) {
+		const u_char* p = bp + (pos >> 3);
+		u_int v = p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+		v <<= pos & 7;
+		if ((v >> 12) == 0x00010)
+			return (pos);
+	}
+	return (nbit);
+}
+
+/*
+ * Decode the picture in bits [s, e) of bp.
+ */
+static void decode(P64Decoder* d, const u_char* bp, int s, int e)
+{
+	const u_char* p = bp + (s >> 3);
+	int cc = ((e + 7) >> 3) - (s >> 3);
+	int sbit = s & 7;
+	int ebit = (8 - (e & 7)) & 7;
+	(void)d->decode(p, cc, sbit, ebit, 0, 0, 0, 0, 0);
+	d->sync();
+}
+
+static const char synopsis[] =
+	"p64bench [-n passes] [-s] [-c] [-r scale] "
+	"file\n";
+
+int main(int argc, char** argv)
+{
+	int passes = 10;
+	int check = 0;
+	int reduce = 0;
+	int op;
+	while ((op = getopt(argc, argv, "n:scr:")) != -1) {
+		switch (op) {
+		case 'n':
+			passes = atoi(optarg);
+			break;
+		case 's':
+			P64Decoder::simd(0);
+			break;
+		case 'c':
+			check = 1;
+			break;
+		case 'r':
+			reduce = atoi(optarg);
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind != argc - 1 || passes <= 0 || reduce < 0 || reduce > 2)
+		bench_usage(synopsis);
+
+	FILE* f = fopen(argv[optind], "rb");
+	if (f == 0) {
+		perror(argv[optind]);
+		exit(1);
+	}
+	fseek(f, 0, SEEK_END);
+	long len = ftell(f);
+	rewind(f);
+	u_char* bp = new u_char[len + BITS_PAD];
+	if (fread(bp, 1, len, f) != (size_t)len) {
+		perror(argv[optind]);
+		exit(1);
+	}
+	fclose(f);
+	memset(bp + len, 0, BITS_PAD);
+
+	/* find the pictures */
+	int nbit = len << 3;
+	int npic = 0;
+	int maxpic = 1024;
+	int* psc = new int[maxpic + 1];
+	for (int pos = next_psc(bp, nbit, 0); pos < nbit;
+	     pos = next_psc(bp, nbit, pos + 20)) {
+		if (npic >= maxpic) {
+			int* p = new int[2 * maxpic + 1];
+			memcpy(p, psc, npic * sizeof(*p));
+			delete[] psc;
+			psc = p;
+			maxpic *= 2;
+		}
+		psc[npic++] = pos;
+	}
+	psc[npic] = nbit;
+	if (npic == 0) {
+		fprintf(stderr, "p64bench: no pictures in %s\n", argv[optind]);
+		exit(1);
+	}
+
+	if (check) {
+		/*
+		 * The SIMD setting is global, so flip it back and forth
+		 * and keep a decoder for each.
+		 */
+		P64Decoder* a = new FullP64Decoder;
+		P64Decoder* b = new FullP64Decoder;
+		for (int i = 0; i < npic; ++i) {
+			P64Decoder::simd(0);
+			decode(a, bp, psc[i], psc[i + 1]);
+			P64Decoder::simd(1);
+			decode(b, bp, psc[i], psc[i + 1]);
+			int n = a->width() * a->height() * 3 / 2;
+			if (a->width() != b->width() ||
+			    memcmp(a->frame(), b->frame(), n) != 0) {
+				printf("picture %d: SIMD and C output differ\n",
+				       i);
+				exit(1);
+			}
+		}
+		printf("%d pictures: SIMD and C output identical%s\n", npic,
+		       P64Decoder::simd() ? "" : " (no SIMD on this cpu)");
+		delete a;
+		delete b;
+		return (0);
+	}
+
+	double full = 0.;
+	for (int r = 0; r <= reduce; r += reduce > 0 ? reduce : 1) {
+		P64Decoder* d = new FullP64Decoder;
+		d->scale(r);
+		double nmb = 0.;
+		double t0 = bench_now();
+		for (int k = 0; k < passes; ++k) {
+			for (int i = 0; i < npic; ++i) {
+				decode(d, bp, psc[i], psc[i + 1]);
+				nmb += d->ndblk();
+				d->resetndblk();
+			}
+		}
+		double t = bench_now() - t0;
+		printf("%s 1/%d: %d pictures x %d passes, %.0f macroblocks "
+		       "in %.3f sec\n", P64Decoder::simd() ? "sse2" : "c",
+		       1 << r, npic, passes, nmb, t);
+		printf("%.0f macroblocks/sec, %.1f pictures/sec, "
+		       "%.3f ms/picture\n", t > 0. ? nmb / t : 0.,
+		       t > 0. ? npic * passes / t : 0.,
+		       1e3 * t / (npic * passes));
+		printf("bad: psc %u bits %u gob %u fmt %u\n", d->bad_psc(),
+		       d->bad_bits(), d->bad_GOBno(), d->bad_fmt());
+		if (r == 0)
+			full = t;
+		else if (t > 0.)
+			printf("1/%d takes %.0f%% of the cpu of full size\n",
+			       1 << r, 100. * t / full);
+		delete d;
+	}
+	return (0);
+}
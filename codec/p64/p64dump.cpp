@@ -51,62 +51,25 @@ P64Dumper::P64Dumper()
 	dump_quantized_ = 0;
 }
 
-#if BYTE_ORDER == LITTLE_ENDIAN
-#define HUFFRQ(bs, bb) \
- { \
-	register int t = *bs++; \
-	bb <<= 16; \
-	bb |= (t & 0xff) << 8; \
-	bb |= t >> 8; \
-}
-#else
-#define HUFFRQ(bs, bb) \
- { \
-	bb <<= 16; \
-	bb |= *bs++; \
-}
-#endif
-
 #define MASK(s) ((1 << (s)) - 1)
 
-#define HUFF_DECODE(bs, ht, nbb, bb, result) { \
-	register int s__, v__; \
- \
-	if (nbb < 16) { \
-		HUFFRQ(bs, bb); \
-		nbb += 16; \
-	} \
-	s__ = ht.maxlen; \
-	v__ = (bb >> (nbb - s__)) & MASK(s__); \
-	s__ = (ht.prefix)[v__]; \
-	nbb -= (s__ & 0x1f); \
-	result = s__ >> 5; \
- }
-
-#define GET_BITS(bs, n, nbb, bb, result) \
-{ \
-	nbb -= n; \
-	if (nbb < 0)  { \
-		HUFFRQ(bs, bb); \
-		nbb += 16; \
-	} \
-	(result) = ((bb >> nbb) & MASK(n)); \
-}
+#define HUFF_DECODE(bs, ht, nbb, bb, result) \
+	BITS_HUFF(bs, ht.prefix, ht.maxlen, nbb, bb, result)
+
+#define GET_BITS(bs, n, nbb, bb, result) BITS_GET(bs, n, nbb, bb, result)
 
 #define SKIP_BITS(bs, n, nbb, bb) \
 { \
 	nbb -= n; \
-	if (nbb < 0)  { \
-		HUFFRQ(bs, bb); \
-		nbb += 16; \
-	} \
+	if (nbb < 0) \
+		BITS_FILL(bs, nbb, bb); \
 }
 
 #define DUMPBITS(c) dump_bits(c)
 
 void P64Dumper::dump_bits(char c)
 {
-	int nbits = (bs_ - dbs_) * 16 + dnbb_ - nbb_;
+	int nbits = (bs_ - dbs_) * 8 + dnbb_ - nbb_;
 	int v;
 	printf("%d/", nbits);
 	while (nbits > 16) {
@@ -135,9 +98,10 @@ void P64Dumper::err(const char* msg ...) const
 	vfprintf(stdout, msg, ap);
 	printf(" @g%d m%d %d/%d of %d/%d: %04x %04x %04x %04x|%04x\n",
 		gob_, mba_,
-	       (u_char*)bs_ - (u_char*)ps_, nbb_,
-	       (u_char*)es_ - (u_char*)ps_, pebit_,
-	       bs_[-4], bs_[-3], bs_[-2], bs_[-1], bs_[0]);
+	       (int)(bs_ - ps_), nbb_, (int)(es_ - ps_), pebit_,
+	       bs_[-8] << 8 | bs_[-7], bs_[-6] << 8 | bs_[-5],
+	       bs_[-4] << 8 | bs_[-3], bs_[-2] << 8 | bs_[-1],
+	       bs_[0] << 8 | bs_[1]);
 }
 
 
@@ -160,7 +124,7 @@ int P64Dumper::parse_block(short* blk, u_int* mask)
 	 * Cache bit buffer in registers.
 	 */
 	register int nbb = nbb_;
-	register int bb = bb_;
+	bitbuf bb = bb_;
 	register short* qt = qt_;
 	register int val = 0, k;
 
@@ -358,7 +322,7 @@ int P64Dumper::parse_gob_hdr(int ebit)
 		 * are a start code and throw them away.
 		 * But first check that we have the bits.
 		 */
-		int nbit = ((es_ - bs_) << 4) + nbb_ - ebit;
+		int nbit = ((es_ - bs_) << 3) + nbb_ - ebit;
 		if (nbit < 20)
 			return (0);
 
@@ -637,29 +601,13 @@ int P64Dumper::decode_mb()
 int P64Dumper::decode(const u_char* bp, int cc, int sbit, int ebit,
 		      int mba, int gob, int mq, int mvdh, int mvdv)
 {
-	ps_ = (u_short*)bp;
-	/*
-	 * If cc is even, ignore 8 extra bits in last short.
-	 */
-	int odd = cc & 1;
-	ebit += (odd ^ 1) << 3;
+	ps_ = bp;
 	pebit_ = ebit;
-	cc -= odd;
-	es_ = (u_short*)(bp + cc);
-
-	/*
-	 * If input buffer not aligned, prime bit-buffer
-	 * with 8 bits; otherwise, prime it with a 16.
-	 */
-	if ((int)bp & 1) {
-		bs_ = (u_short*)(bp + 1);
-		bb_ = *bp;
-		nbb_ = 8 - sbit;
-	} else {
-		bs_ = (u_short*)bp;
-		HUFFRQ(bs_, bb_);
-		nbb_ = 16 - sbit;
-	}
+	es_ = bp + cc;
+	bs_ = bp;
+	bb_ = 0;
+	nbb_ = -sbit;
+	BITS_FILL(bs_, nbb_, bb_);
 	dbs_ = bs_;
 	dnbb_ = nbb_;
 	dbb_ = bb_;
@@ -675,7 +623,7 @@ int P64Dumper::decode(const u_char* bp, int cc, int sbit, int ebit,
 			gob >>= 1;
 	}
 
-	while (bs_ < es_ || (bs_ == es_ && nbb_ > ebit)) {
+	while (((es_ - bs_) << 3) + nbb_ > ebit) {
 		mbst_ = &mb_state_[gob << 6];
 		coord_ = &base_[gob << 6];
 
@@ -23,8 +23,8 @@ class P64Dumper: public FullP64Decoder {
 	int decode_gob(u_int gob);
 	int decode_mb();
 
-	u_int dbb_;		/* 32-bit bit buffer */
+	bitbuf dbb_;		/* bit buffer (bitio.h) */
 	int dnbb_;		/* number bits in bit buffer */
-	const u_short* dbs_;	/* input bit stream (less bits in bb_) */
+	const u_char* dbs_;	/* input bit stream (less bits in bb_) */
 	int dump_quantized_;	/* dump quantized coef. values if = 1 */
 };
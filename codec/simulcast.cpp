@@ -0,0 +1,602 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * simulcast:
+ *	one grabber feeding several encoders, so receivers on slow
+ *	links can take a smaller stream without a second vic on the
+ *	camera.  The first encoder sends from our ssrc and each of the
+ *	others from one of its own, as a second vic would, since a
+ *	receiver decodes an ssrc with one codec; each also has a
+ *	layer, which puts it in a multicast group of its own.
+ *
+ *	The grabber's frame is deinterlaced and downscaled here once
+ *	for every size asked for, and the encoders are run on the
+ *	worker threads, each handing its packets to a transmitter of
+ *	its own that just keeps them.  Once they are all done, the
+ *	packets go out on the session's transmitter from the main
+ *	thread, as if one encoder had sent them.  consume() waits for
+ *	the encoders, so the shared frames need no reference counts.
+ *
+ *	Encoders have to be reentrant to be run this way.  The H.263
+ *	encoders (tmn globals, and Tcl calls from consume) are not, so
+ *	they must be added with thread 0 to run on the main thread.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "config.h"
+#include "vic_tcl.h"
+#include "module.h"
+#include "transmitter.h"
+#include "source.h"
+#include "crdef.h"
+#include "worker.h"
+#ifdef HAVE_SWSCALE
+#include "deinterlace.h"
+#endif
+
+#define SIM_MAXCHAIN	8
+
+#define CIF_WIDTH	352
+#define CIF_HEIGHT	288
+#define QCIF_WIDTH	176
+#define QCIF_HEIGHT	144
+
+/*
+ * Stands in for the session's transmitter under one chain's
+ * encoder and keeps what the encoder sends, in order.
+ */
+class ChainTransmitter : public Transmitter {
+    public:
+	ChainTransmitter() : first_(0), last_(0) {}
+	inline void mtu(int mtu) { mtu_ = mtu; }
+	virtual void send(pktbuf* pb) {
+		pb->next = 0;
+		if (first_ == 0)
+			first_ = pb;
+		else
+			last_->next = pb;
+		last_ = pb;
+	}
+	virtual void flush() {}
+	/* what was sent since the last take() */
+	inline pktbuf* take() {
+		pktbuf* pb = first_;
+		first_ = last_ = 0;
+		return (pb);
+	}
+    protected:
+	virtual void transmit(pktbuf*) {}
+	pktbuf* first_;
+	pktbuf* last_;
+};
+
+/*
+ * One encoder, and the frames it has been given.
+ */
+class SimChain : public WorkerTask {
+    public:
+	SimChain(Module* encoder, int w, int h, int layer, int thread);
+	virtual void run();
+
+	Module* encoder_;
+	ChainTransmitter tx_;
+	int width_;		/* frame size it takes, 0 for the input's */
+	int height_;
+	int layer_;		/* added to the layer of what it sends */
+	int thread_;		/* 0 if it has to run on the main thread */
+	Source* src_;		/* the one it sends from, 0 for localsrc */
+
+	const YuvFrame* frame_;	/* the one to encode */
+	WorkerLatch* latch_;	/* to tell when done, if on a worker */
+	int nbytes_;		/* consume()'s result */
+
+	double busy_;		/* seconds spent in consume() */
+	u_int32_t nframe_;
+};
+
+/*
+ * A frame size, and the frame of that size made this time around.
+ */
+struct SimSize {
+	int w;
+	int h;
+	u_char* bp;		/* 0 until the input size is known */
+	u_char* crvec;
+	YuvFrame* frame;
+};
+
+class Simulcast : public TransmitterModule {
+    public:
+	Simulcast();
+	~Simulcast();
+	int command(int argc, const char*const* argv);
+	int consume(const VideoFrame*);
+    protected:
+	int add(Module* encoder, int w, int h, int layer, int thread);
+	void resize(int w, int h);
+	void scale(const YuvFrame* yf);
+	void stats(char* bp);
+
+	SimChain* chain_[SIM_MAXCHAIN];
+	int nchain_;
+	SimSize size_[SIM_MAXCHAIN];
+	int nsize_;
+	u_char* tmp_;		/* for halving */
+	WorkerLatch latch_;
+#ifdef HAVE_SWSCALE
+	Deinterlace deinterlacer_;
+	int deinterlace_;
+#endif
+	double scaletime_;	/* seconds deinterlacing and scaling */
+	double time_;		/* and in all of consume() */
+	u_int32_t nframe_;
+};
+
+static class SimulcastMatcher : public Matcher {
+    public:
+	SimulcastMatcher() : Matcher("module") {}
+	TclObject* match(const char* fmt) {
+		if (strcasecmp(fmt, "simulcast") == 0)
+			return (new Simulcast);
+		return (0);
+	}
+} simulcast_matcher;
+
+static double now()
+{
+	timeval tv;
+	::gettimeofday(&tv, 0);
+	return (tv.tv_sec + 1e-6 * tv.tv_usec);
+}
+
+SimChain::SimChain(Module* encoder, int w, int h, int layer, int thread)
+	: encoder_(encoder), width_(w), height_(h), layer_(layer),
+	  thread_(thread), src_(0), frame_(0), latch_(0), nbytes_(0),
+	  busy_(0.), nframe_(0)
+{
+}
+
+void SimChain::run()
+{
+	double t = now();
+	nbytes_ = encoder_->consume(frame_);
+	busy_ += now() - t;
+	++nframe_;
+	if (latch_ != 0)
+		latch_->done();
+}
+
+Simulcast::Simulcast() : TransmitterModule(FT_YUV_420),
+	nchain_(0), nsize_(0), tmp_(0), scaletime_(0.), time_(0.), nframe_(0)
+{
+#ifdef HAVE_SWSCALE
+	deinterlace_ = 0;
+#endif
+	tx_ = 0;
+	width_ = height_ = framesize_ = 0;
+}
+
+Simulcast::~Simulcast()
+{
+	for (int i = 0; i < nchain_; ++i) {
+		if (chain_[i]->src_ != 0)
+			SourceManager::instance().removelocal(chain_[i]->src_);
+		delete chain_[i];
+	}
+	resize(0, 0);
+}
+
+int Simulcast::command(int argc, const char*const* argv)
+{
+	Tcl& tcl = Tcl::instance();
+	if (argc == 2) {
+		if (strcmp(argv[1], "stats") == 0) {
+			char* bp = tcl.buffer();
+			tcl.result(bp);
+			stats(bp);
+			return (TCL_OK);
+		}
+	}
+	if (argc == 3) {
+#ifdef HAVE_SWSCALE
+		if (strcmp(argv[1], "deinterlace") == 0) {
+			deinterlace_ = atoi(argv[2]);
+			return (TCL_OK);
+		}
+#endif
+	}
+	/*
+	 * add encoder wxh ?layer? ?thread?
+	 * where a size of - means the grabber's, whose frames are
+	 * then of the kind this encoder wants.
+	 */
+	if (argc >= 4 && argc <= 6 && strcmp(argv[1], "add") == 0) {
+		Module* m = (Module*)TclObject::lookup(argv[2]);
+		int w = 0, h = 0;
+		if (m == 0) {
+			tcl.resultf("simulcast: no encoder %s", argv[2]);
+			return (TCL_ERROR);
+		}
+		if (strcmp(argv[3], "-") != 0 &&
+		    (sscanf(argv[3], "%dx%d", &w, &h) != 2 || w <= 0 ||
+		     h <= 0 || (w & 15) != 0 || (h & 15) != 0)) {
+			tcl.resultf("simulcast: bad size %s", argv[3]);
+			return (TCL_ERROR);
+		}
+		int layer = argc > 4 ? atoi(argv[4]) : nchain_;
+		int thread = argc > 5 ? atoi(argv[5]) : 1;
+		if (add(m, w, h, layer, thread) < 0)
+			return (TCL_ERROR);
+		SimChain* c = chain_[nchain_ - 1];
+		tcl.evalf("%s transmitter %s", m->name(), c->tx_.name());
+		if (c->src_ != 0)
+			tcl.evalf("%s srcid %u", m->name(),
+				  (u_int)ntohl(c->src_->srcid()));
+		return (TCL_OK);
+	}
+	return (TransmitterModule::command(argc, argv));
+}
+
+int Simulcast::add(Module* m, int w, int h, int layer, int thread)
+{
+	Tcl& tcl = Tcl::instance();
+	if (nchain_ == SIM_MAXCHAIN) {
+		tcl.result("simulcast: too many encoders");
+		return (-1);
+	}
+	if (layer < 0 || layer >= NLAYER) {
+		tcl.resultf("simulcast: bad layer %d", layer);
+		return (-1);
+	}
+	if (w == 0) {
+		if (m->ft() != FT_YUV_420 && m->ft() != FT_YUV_CIF) {
+			tcl.resultf("simulcast: %s takes %s frames", m->name(),
+				    fttoa(m->ft()));
+			return (-1);
+		}
+	} else if (m->ft() == FT_YUV_CIF) {
+		/* frames are planar 4:2:0, which cif is at two sizes only */
+		if (!(w == CIF_WIDTH && h == CIF_HEIGHT) &&
+		    !(w == QCIF_WIDTH && h == QCIF_HEIGHT)) {
+			tcl.resultf("simulcast: %s takes cif or qcif only",
+				    m->name());
+			return (-1);
+		}
+	} else if (m->ft() != FT_YUV_420) {
+		tcl.resultf("simulcast: %s takes %s frames", m->name(),
+			    fttoa(m->ft()));
+		return (-1);
+	}
+	Source* src = 0;
+	if (nchain_ > 0) {
+		SourceManager& sm = SourceManager::instance();
+		for (int n = 0; src == 0 && n < 4; ++n)
+			src = sm.addlocal(u_int32_t(random()));
+		if (src == 0) {
+			tcl.result("simulcast: no ssrc for encoder");
+			return (-1);
+		}
+	}
+	SimChain* c = new SimChain(m, w, h, layer, thread);
+	c->src_ = src;
+	chain_[nchain_++] = c;
+	if (w == 0) {
+		ft_ = m->ft();
+		return (0);
+	}
+
+	int i;
+	for (i = 0; i < nsize_; ++i)
+		if (size_[i].w == w && size_[i].h == h)
+			return (0);
+	SimSize& s = size_[nsize_++];
+	s.w = w;
+	s.h = h;
+	s.bp = 0;
+	s.crvec = 0;
+	s.frame = 0;
+	if (width_ > 0)
+		/* frames are coming in already */
+		resize(width_, height_);
+	return (0);
+}
+
+/*
+ * Drop the frames made for the last input size; they are made
+ * again for the next.
+ */
+void Simulcast::resize(int w, int h)
+{
+	for (int i = 0; i < nsize_; ++i) {
+		SimSize& s = size_[i];
+		delete[] s.bp;
+		delete[] s.crvec;
+		delete s.frame;
+		s.bp = 0;
+		s.crvec = 0;
+		s.frame = 0;
+	}
+	delete[] tmp_;
+	tmp_ = 0;
+	Module::size(w, h);
+	if (w == 0)
+		return;
+	/* room for a half and a quarter size luma plane */
+	tmp_ = new u_char[(framesize_ >> 2) + (framesize_ >> 4)];
+	for (int i = 0; i < nsize_; ++i) {
+		SimSize& s = size_[i];
+		if (s.w == w && s.h == h)
+			/* the grabber's frame is used as is */
+			continue;
+		int fs = s.w * s.h;
+		s.bp = new u_char[fs + (fs >> 1)];
+		s.crvec = new u_char[(s.w >> 4) * (s.h >> 4)];
+		s.frame = new YuvFrame(0, s.bp, s.crvec, s.w, s.h);
+	}
+}
+
+/* sw x sh to sw/2 x sh/2, averaging each 2x2 */
+static void halve(const u_char* sp, int sw, int sh, u_char* dp)
+{
+	int dw = sw >> 1;
+	int dh = sh >> 1;
+	for (int y = 0; y < dh; ++y) {
+		const u_char* a = sp + 2 * y * sw;
+		const u_char* b = a + sw;
+		for (int x = 0; x < dw; ++x, a += 2, b += 2)
+			*dp++ = (a[0] + a[1] + b[0] + b[1] + 2) >> 2;
+	}
+}
+
+/* bilinear, in 16.16 fixed point, pixel centers lined up */
+static void resample(const u_char* sp, int sw, int sh,
+		     u_char* dp, int dw, int dh)
+{
+	int xstep = (sw << 16) / dw;
+	int ystep = (sh << 16) / dh;
+	int sy = (ystep >> 1) - 0x8000;
+	for (int y = 0; y < dh; ++y, sy += ystep) {
+		int y0 = sy < 0 ? 0 : sy >> 16;
+		int fy = sy < 0 ? 0 : (sy >> 8) & 0xff;
+		int y1 = y0 + 1 < sh ? y0 + 1 : sh - 1;
+		const u_char* r0 = sp + y0 * sw;
+		const u_char* r1 = sp + y1 * sw;
+		int sx = (xstep >> 1) - 0x8000;
+		for (int x = 0; x < dw; ++x, sx += xstep) {
+			int x0 = sx < 0 ? 0 : sx >> 16;
+			int fx = sx < 0 ? 0 : (sx >> 8) & 0xff;
+			int x1 = x0 + 1 < sw ? x0 + 1 : sw - 1;
+			int top = r0[x0] * (256 - fx) + r0[x1] * fx;
+			int bot = r1[x0] * (256 - fx) + r1[x1] * fx;
+			*dp++ = (top * (256 - fy) + bot * fy + 0x8000) >> 16;
+		}
+	}
+}
+
+/*
+ * Scale a plane, halving while that doesn't go below the size
+ * asked for (which averages every pixel in, where bilinear alone
+ * would skip some), then resampling the rest of the way.
+ */
+static void scale_plane(const u_char* sp, int sw, int sh,
+			u_char* dp, int dw, int dh, u_char* tmp)
+{
+	u_char* half = tmp;
+	u_char* quarter = tmp + ((sw >> 1) * (sh >> 1));
+	while (2 * dw <= sw && 2 * dh <= sh) {
+		if (2 * dw == sw && 2 * dh == sh) {
+			halve(sp, sw, sh, dp);
+			return;
+		}
+		u_char* t = sp == half ? quarter : half;
+		halve(sp, sw, sh, t);
+		sp = t;
+		sw >>= 1;
+		sh >>= 1;
+	}
+	if (sw == dw && sh == dh)
+		memcpy(dp, sp, dw * dh);
+	else
+		resample(sp, sw, sh, dp, dw, dh);
+}
+
+/*
+ * A block is sent at the smaller size if any of the blocks it
+ * covers is sent at the larger one.
+ */
+static void scale_crvec(const u_char* sp, int sbw, int sbh,
+			u_char* dp, int dbw, int dbh)
+{
+	for (int by = 0; by < dbh; ++by) {
+		int y0 = by * sbh / dbh;
+		int y1 = ((by + 1) * sbh + dbh - 1) / dbh;
+		for (int bx = 0; bx < dbw; ++bx) {
+			int x0 = bx * sbw / dbw;
+			int x1 = ((bx + 1) * sbw + dbw - 1) / dbw;
+			u_char s = sp[y0 * sbw + x0];
+			for (int y = y0; y < y1 && (s & CR_SEND) == 0; ++y)
+				for (int x = x0; x < x1; ++x)
+					if (sp[y * sbw + x] & CR_SEND) {
+						s = sp[y * sbw + x];
+						break;
+					}
+			*dp++ = s;
+		}
+	}
+}
+
+/*
+ * Make a frame of each size from the input, largest first, each
+ * from the smallest one already made that is big enough.
+ */
+void Simulcast::scale(const YuvFrame* yf)
+{
+	int done[SIM_MAXCHAIN];
+	int ndone = 0;
+	for (int n = 0; n < nsize_; ++n) {
+		SimSize* s = 0;
+		for (int i = 0; i < nsize_; ++i) {
+			SimSize& t = size_[i];
+			if (t.frame == 0)
+				continue;
+			int j;
+			for (j = 0; j < ndone; ++j)
+				if (done[j] == i)
+					break;
+			if (j == ndone && (s == 0 || t.w * t.h > s->w * s->h))
+				s = &t;
+		}
+		if (s == 0)
+			break;
+		const u_char* sp = yf->bp_;
+		const u_char* scrv = yf->crvec_;
+		int sw = width_;
+		int sh = height_;
+		for (int j = 0; j < ndone; ++j) {
+			const SimSize& t = size_[done[j]];
+			if (t.w >= s->w && t.h >= s->h && t.w * t.h < sw * sh) {
+				sp = t.bp;
+				scrv = t.crvec;
+				sw = t.w;
+				sh = t.h;
+			}
+		}
+		int fs = sw * sh;
+		int dfs = s->w * s->h;
+		scale_plane(sp, sw, sh, s->bp, s->w, s->h, tmp_);
+		scale_plane(sp + fs, sw >> 1, sh >> 1, s->bp + dfs,
+			    s->w >> 1, s->h >> 1, tmp_);
+		scale_plane(sp + fs + (fs >> 2), sw >> 1, sh >> 1,
+			    s->bp + dfs + (dfs >> 2), s->w >> 1, s->h >> 1,
+			    tmp_);
+		if (scrv != 0)
+			scale_crvec(scrv, sw >> 4, sh >> 4, s->crvec,
+				    s->w >> 4, s->h >> 4);
+		else
+			memset(s->crvec, CR_SEND|CR_MOTION,
+			       (s->w >> 4) * (s->h >> 4));
+		s->frame->ts_ = yf->ts_;
+		done[ndone++] = s - size_;
+	}
+}
+
+int Simulcast::consume(const VideoFrame* vf)
+{
+	const YuvFrame* yf = (const YuvFrame*)vf;
+	if (nchain_ == 0 || tx_ == 0)
+		return (0);
+	double t0 = now();
+	if (!samesize(vf))
+		resize(vf->width_, vf->height_);
+#ifdef HAVE_SWSCALE
+	if (deinterlace_)
+		deinterlacer_.render(vf->bp_, vf->width_, vf->height_);
+#endif
+	scale(yf);
+	scaletime_ += now() - t0;
+
+	/*
+	 * The main thread takes one of the chains itself, plus those
+	 * that can't go on a worker.  One worker is kept free, for
+	 * encoders that split their frames over the pool and wait.
+	 */
+	int nworker = WorkerPool::instance().nthread() - 1;
+	SimChain* local[SIM_MAXCHAIN];
+	SimChain* submit[SIM_MAXCHAIN];
+	int nlocal = 0;
+	int nsubmit = 0;
+	int kept = 0;
+	int i;
+	for (i = 0; i < nchain_; ++i) {
+		SimChain* c = chain_[i];
+		c->tx_.mtu(tx_->mtu());
+		c->frame_ = yf;
+		for (int j = 0; j < nsize_; ++j)
+			if (size_[j].frame != 0 &&
+			    size_[j].w == c->width_ && size_[j].h == c->height_)
+				c->frame_ = size_[j].frame;
+		c->latch_ = 0;
+		if (c->thread_ && kept && nsubmit < nworker) {
+			c->latch_ = &latch_;
+			submit[nsubmit++] = c;
+		} else {
+			kept |= c->thread_;
+			local[nlocal++] = c;
+		}
+	}
+	latch_.reset(nsubmit);
+	for (i = 0; i < nsubmit; ++i)
+		WorkerPool::instance().submit(submit[i]);
+	for (i = 0; i < nlocal; ++i)
+		local[i]->run();
+	latch_.wait();
+
+	/* send it all, as one encoder would */
+	tx_->flush();
+	int nbytes = 0;
+	for (i = 0; i < nchain_; ++i) {
+		SimChain* c = chain_[i];
+		nbytes += c->nbytes_;
+		pktbuf* pb = c->tx_.take();
+		while (pb != 0) {
+			pktbuf* next = pb->next;
+			pb->layer += c->layer_;
+			if (pb->layer >= NLAYER)
+				pb->layer = NLAYER - 1;
+			tx_->send(pb);
+			pb = next;
+		}
+	}
+	time_ += now() - t0;
+	++nframe_;
+	return (nbytes);
+}
+
+/*
+ * Mean ms per frame: in all, scaling, and in each encoder, which
+ * is named by its format and size.
+ */
+void Simulcast::stats(char* bp)
+{
+	double n = nframe_ > 0 ? nframe_ : 1;
+	sprintf(bp, "Simulcast-ms %.2f Scale-ms %.2f", 1e3 * time_ / n,
+		1e3 * scaletime_ / n);
+	bp += strlen(bp);
+	for (int i = 0; i < nchain_; ++i) {
+		const SimChain* c = chain_[i];
+		double m = c->nframe_ > 0 ? c->nframe_ : 1;
+		sprintf(bp, " %s/%dx%d-ms %.2f", c->encoder_->name(),
+			c->width_, c->height_, 1e3 * c->busy_ / m);
+		bp += strlen(bp);
+	}
+}
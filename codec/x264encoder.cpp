@@ -30,6 +30,8 @@ x264Encoder::x264Encoder()
     enc->h = NULL;
     encoder = (void *) enc;
     isFrameEncoded = false;
+    keyFrameRequested = false;
+    sliceMaxSize = 0;
 }
 
 x264Encoder::~x264Encoder()
@@ -80,9 +82,16 @@ bool x264Encoder::init(int w, int h, int bps, int fps)
     // should help with packet loss resiliency at low bitrates
     param->b_intra_refresh = 1;
 
-    // may want to try slice_max_size=packet size (mtu=1450? need to check rtp
-    // header length), but might be higher than the normal max amount of slices
-    // supported by decoder (most builds of FFmpeg) (16) depending on bitrate
+    // the low latency profile: the slices are coded at once, a thread
+    // each (with sliced threads X264_THREADS_AUTO is one per core), and
+    // none is bigger than a packet, so the packetizer never has to cut
+    // one up with FU-A.  At high rates this can be more slices than
+    // some decoders (most builds of FFmpeg) take (16), so it's an option
+    if (sliceMaxSize > 0) {
+	param->b_sliced_threads = 1;
+	param->i_threads = X264_THREADS_AUTO;
+	param->i_slice_max_size = sliceMaxSize;
+    }
 
     // just to be safe, make sure there are no b-frames (just in case it may be
     // set by a slower speed preset)
@@ -116,6 +125,11 @@ bool x264Encoder::encodeFrame(uint8 *buf)
     enc->pic.img.plane[1] = buf + frame_size;
     enc->pic.img.plane[2] = buf + frame_size*5/4;
 
+    // an IDR (with the SPS and PPS in front) at a receiver's request,
+    // rather than waiting for the intra refresh to come around
+    enc->pic.i_type = keyFrameRequested ? X264_TYPE_IDR : X264_TYPE_AUTO;
+    keyFrameRequested = false;
+
     int result = x264_encoder_encode(enc->h, &(enc->nal), &(enc->i_nal), &(enc->pic), &(enc->pic_out));
 
     if (result < 0) {
@@ -177,6 +191,14 @@ void x264Encoder::setBitRate(int br)
     x264 *enc = (x264 *) encoder;
     x264_param_t *param = &(enc->param);
     param->rc.i_bitrate = br;
+
+    // keep the single-frame vbv of init() and apply it all to a
+    // running encoder
+    if (enc->h != NULL) {
+	param->rc.i_vbv_max_bitrate = br;
+	param->rc.i_vbv_buffer_size = br * param->i_fps_den / param->i_fps_num;
+	x264_encoder_reconfig(enc->h, param);
+    }
 }
 
 void x264Encoder::setFPS(int fps)
@@ -185,6 +207,24 @@ void x264Encoder::setFPS(int fps)
     x264_param_t *param = &(enc->param);
     param->i_fps_num = fps * 1000;
     param->i_fps_den = 1000;
+
+    // the single-frame vbv follows the frame rate too
+    if (enc->h != NULL && fps > 0) {
+	param->rc.i_vbv_buffer_size = param->rc.i_vbv_max_bitrate / fps;
+	x264_encoder_reconfig(enc->h, param);
+    }
+}
+
+// before init(): the low latency profile, with slices of at most
+// size bytes (0 turns it off)
+void x264Encoder::setLowLatency(int size)
+{
+    sliceMaxSize = size;
+}
+
+void x264Encoder::requestKeyFrame()
+{
+    keyFrameRequested = true;
 }
 
 bool x264Encoder::isInitialized()
@@ -16,11 +16,15 @@ class x264Encoder
     void setGOP(int);
     void setBitRate(int);
     void setFPS(int);
+    void setLowLatency(int);
+    void requestKeyFrame();
     bool isInitialized();
 
   private:
     void *encoder;
     bool isFrameEncoded;
+    bool keyFrameRequested;
+    int sliceMaxSize;
 };
 
 #endif
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * evbench - time the dispatch of sockets through the Tk notifier
+ * and through the epoll event core, level and edge triggered.
+ *
+ * usage: evbench [-n socks[,socks...]] [-p packets]
+ *
+ * For each count in `socks' (16, 64, 256 and 512) as many UDP
+ * sockets on 127.0.0.1 are linked to handlers that read until they
+ * would block.  Then `packets' (20000) times a packet is sent to
+ * the next socket round and the loop is run until it has been read,
+ * so each wakeup finds one descriptor ready among all of them.
+ * Printed are the microseconds per packet taken by the loop (the
+ * send left out), and for the event core the histograms of its last
+ * run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "config.h"
+#include "bench.h"
+#include "iohandler.h"
+#include "eventloop.h"
+
+static int nread;
+
+class Sock : public IOHandler {
+    public:
+	Sock(int fd, int mask) : fd_(fd) { link(fd, mask); }
+	virtual ~Sock() { unlink(); close(fd_); }
+    protected:
+	virtual void dispatch(int) {
+		char buf[2048];
+		while (recv(fd_, buf, sizeof(buf), MSG_DONTWAIT) > 0)
+			++nread;
+	}
+	int fd_;
+};
+
+/* a socket on 127.0.0.1; fills in its address */
+static int listener(sockaddr_in& sin)
+{
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (fd < 0 || bind(fd, (sockaddr*)&sin, sizeof(sin)) < 0) {
+		perror("evbench: socket");
+		exit(1);
+	}
+	socklen_t len = sizeof(sin);
+	getsockname(fd, (sockaddr*)&sin, &len);
+	return (fd);
+}
+
+/* core 0 is Tk's, 1 epoll level triggered, 2 edge triggered */
+static double run(int core, int nsock, int npkt)
+{
+	EventLoop* loop = EventLoop::instance();
+	int mask = TK_READABLE;
+	if (core == 2)
+		mask |= IO_EDGE;
+	Sock** s = new Sock*[nsock];
+	sockaddr_in* sin = new sockaddr_in[nsock];
+	int i;
+	for (i = 0; i < nsock; ++i)
+		s[i] = new Sock(listener(sin[i]), mask);
+	int sfd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (loop != 0)
+		loop->reset();
+
+	char pkt[200];
+	memset(pkt, 0, sizeof(pkt));
+	double t = 0.;
+	nread = 0;
+	for (i = 0; i < npkt; ++i) {
+		const sockaddr_in& to = sin[i % nsock];
+		(void)sendto(sfd, pkt, sizeof(pkt), 0, (sockaddr*)&to, sizeof(to));
+		double t0 = bench_now();
+		while (nread <= i) {
+			if (loop != 0)
+				loop->once(-1);
+			else
+				Tcl_DoOneEvent(TCL_FILE_EVENTS);
+		}
+		t += bench_now() - t0;
+	}
+	for (i = 0; i < nsock; ++i)
+		delete s[i];
+	delete[] s;
+	delete[] sin;
+	close(sfd);
+	return (1e6 * t / npkt);
+}
+
+static void hist(const char* name, const u_int32_t* h, int dispatch)
+{
+	printf("%s:", name);
+	for (int i = 0; i < EVLOOP_NHIST; ++i) {
+		if (h[i] == 0)
+			continue;
+		if (dispatch)
+			printf(" %u:%u", i > 0 ? 1 << (i - 1) : 0, h[i]);
+		else
+			printf(" %uus:%u", i > 0 ? 1 << i : 0, h[i]);
+	}
+	printf("\n");
+}
+
+static const char synopsis[] =
+	"evbench [-n socks[,socks...]] [-p packets]\n";
+
+int main(int argc, char** argv)
+{
+	int socks[16];
+	int nsocks = 4;
+	socks[0] = 16;
+	socks[1] = 64;
+	socks[2] = 256;
+	socks[3] = 512;
+	int npkt = 20000;
+	int op;
+	while ((op = getopt(argc, argv, "n:p:")) != -1) {
+		switch (op) {
+		case 'n':
+			nsocks = 0;
+			for (char* p = strtok(optarg, ","); p != 0 && nsocks < 16;
+			     p = strtok(0, ","))
+				socks[nsocks++] = atoi(p);
+			break;
+		case 'p':
+			npkt = atoi(optarg);
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind != argc || nsocks == 0 || npkt < 1)
+		bench_usage(synopsis);
+	for (int i = 0; i < nsocks; ++i)
+		/* select() goes no further than FD_SETSIZE */
+		if (socks[i] < 1 || socks[i] > FD_SETSIZE - 64)
+			bench_usage(synopsis);
+	Tcl_FindExecutable(argv[0]);
+
+	printf("%d packets, us per packet\n", npkt);
+	printf("%6s %8s %8s %8s\n", "socks", "tk", "epoll", "edge");
+	double r[16][3];
+	for (int i = 0; i < nsocks; ++i)
+		r[i][0] = run(0, socks[i], npkt);
+	EventLoop* loop = EventLoop::enable();
+	for (int i = 0; i < nsocks; ++i) {
+		r[i][1] = loop != 0 ? run(1, socks[i], npkt) : 0.;
+		r[i][2] = loop != 0 ? run(2, socks[i], npkt) : 0.;
+		printf("%6d %8.2f %8.2f %8.2f\n", socks[i], r[i][0], r[i][1],
+		       r[i][2]);
+	}
+	if (loop == 0) {
+		printf("(no epoll)\n");
+		return (0);
+	}
+	printf("last run, %u iterations\n", loop->niter());
+	hist("dispatched", loop->ndispatch(), 1);
+	hist("latency", loop->latency(), 0);
+	return (0);
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "config.h"
+#include "iohandler.h"
+#include "eventloop.h"
+#ifdef HAVE_EPOLL
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#endif
+
+EventLoop* EventLoop::instance_;
+
+#ifdef HAVE_EPOLL
+static double usecs()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (1e6 * double(ts.tv_sec) + 1e-3 * double(ts.tv_nsec));
+}
+#endif
+
+EventLoop::EventLoop(int fd) : fd_(fd), nfd_(0), stop_(0), tcl_(0.),
+	nready_(0)
+{
+	reset();
+}
+
+EventLoop* EventLoop::enable()
+{
+#ifdef HAVE_EPOLL
+	if (instance_ == 0) {
+		int fd = epoll_create1(EPOLL_CLOEXEC);
+		if (fd >= 0)
+			instance_ = new EventLoop(fd);
+	}
+#endif
+	return (instance_);
+}
+
+void EventLoop::reset()
+{
+	niter_ = 0;
+	memset(ndispatch_, 0, sizeof(ndispatch_));
+	memset(latency_, 0, sizeof(latency_));
+}
+
+/* the bits in v, no more than the last bucket */
+int EventLoop::bucket(u_int32_t v)
+{
+	int n = 0;
+	for (; v != 0 && n < EVLOOP_NHIST - 1; v >>= 1)
+		++n;
+	return (n);
+}
+
+void EventLoop::link(IOHandler* p, int fd, int mask)
+{
+#ifdef HAVE_EPOLL
+	epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	if (mask & TK_READABLE)
+		ev.events |= EPOLLIN;
+	if (mask & TK_WRITABLE)
+		ev.events |= EPOLLOUT;
+	if (mask & TK_EXCEPTION)
+		ev.events |= EPOLLPRI;
+	if (mask & IO_EDGE)
+		ev.events |= EPOLLET;
+	ev.data.ptr = p;
+	if (epoll_ctl(fd_, EPOLL_CTL_ADD, fd, &ev) == 0)
+		++nfd_;
+	else if (errno == EEXIST)
+		/* linked again, as with Tk, replaces what was there */
+		(void)epoll_ctl(fd_, EPOLL_CTL_MOD, fd, &ev);
+#endif
+}
+
+void EventLoop::unlink(IOHandler* p, int fd)
+{
+#ifdef HAVE_EPOLL
+	if (epoll_ctl(fd_, EPOLL_CTL_DEL, fd, 0) == 0)
+		--nfd_;
+	/* it may be going away; don't dispatch it later this iteration */
+	for (int i = 0; i < nready_; ++i)
+		if (ready_[i] == p)
+			ready_[i] = 0;
+#endif
+}
+
+int EventLoop::once(int ms)
+{
+#ifdef HAVE_EPOLL
+	epoll_event ev[EVLOOP_MAXEVENTS];
+	int n = epoll_wait(fd_, ev, EVLOOP_MAXEVENTS, ms);
+	if (n < 0)
+		/* EINTR */
+		n = 0;
+	double start = usecs();
+	int i;
+	for (i = 0; i < n; ++i) {
+		int mask = 0;
+		/* an error or hangup is for the handler's read to find */
+		if (ev[i].events & (EPOLLIN|EPOLLERR|EPOLLHUP))
+			mask |= TK_READABLE;
+		if (ev[i].events & EPOLLOUT)
+			mask |= TK_WRITABLE;
+		if (ev[i].events & EPOLLPRI)
+			mask |= TK_EXCEPTION;
+		ready_[i] = (IOHandler*)ev[i].data.ptr;
+		mask_[i] = mask;
+	}
+	nready_ = n;
+	for (i = 0; i < n; ++i) {
+		IOHandler* p = ready_[i];
+		if (p != 0)
+			p->dispatch(mask_[i]);
+	}
+	nready_ = 0;
+
+	u_int32_t t = u_int32_t(usecs() - start);
+	int b = bucket(t);
+	++niter_;
+	++ndispatch_[bucket(n)];
+	++latency_[b > 0 ? b - 1 : 0];
+	return (n);
+#else
+	return (0);
+#endif
+}
+
+void EventLoop::run()
+{
+#ifdef HAVE_EPOLL
+	stop_ = 0;
+	while (!stop_) {
+		double now = usecs();
+		/* (rounded up, not to spin through the last of it) */
+		int ms = int((tcl_ + 1e3 * EVLOOP_TCL_MS - now + 999.) / 1e3);
+		once(ms > 0 ? ms : 0);
+		now = usecs();
+		if (now - tcl_ >= 1e3 * EVLOOP_TCL_MS) {
+			tcl_ = now;
+			while (Tcl_DoOneEvent(TCL_ALL_EVENTS | TCL_DONT_WAIT))
+				;
+		}
+	}
+#endif
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef vic_eventloop_h
+#define vic_eventloop_h
+
+#include "config.h"
+
+#if defined(__linux__)
+#define HAVE_EPOLL
+#endif
+
+class IOHandler;
+
+/*
+ * An event core for running without Tk (a receiver or recorder
+ * with no window and many sockets).  Once enabled, IOHandler::link
+ * puts descriptors on an epoll set rather than handing them to the
+ * Tk notifier, whose select() costs as much for each descriptor
+ * idle as for one ready; and the timers all go on the timer wheel,
+ * whose timerfd is just another descriptor on the set.  Tcl's own
+ * events (`after' scripts and the like) are looked at every
+ * EVLOOP_TCL_MS.
+ *
+ * A handler linked with IO_EDGE (see iohandler.h) is told only
+ * when its descriptor becomes ready, not while it stays so, and has
+ * to read until it would block.
+ *
+ * Each iteration counts the handlers it dispatched and the time it
+ * took them, in power-of-two histograms.  Only Linux has one.
+ */
+
+#define EVLOOP_MAXEVENTS 256	/* handlers dispatched per iteration */
+#define EVLOOP_NHIST	20	/* histogram buckets */
+#define EVLOOP_TCL_MS	10
+
+class EventLoop {
+public:
+	/*
+	 * Turn it on, before anything is linked.  Returns 0 where there
+	 * is no epoll.
+	 */
+	static EventLoop* enable();
+	static inline EventLoop* instance() { return (instance_); }
+
+	/* until stop() */
+	void run();
+	inline void stop() { stop_ = 1; }
+	/*
+	 * Wait up to `ms' milliseconds (-1 for ever) and dispatch what
+	 * is ready; returns the handlers dispatched.
+	 */
+	int once(int ms);
+
+	void link(IOHandler* p, int fd, int mask);
+	void unlink(IOHandler* p, int fd);
+	inline int nfd() const { return (nfd_); }
+
+	/*
+	 * Bucket 0 of ndispatch counts iterations that dispatched
+	 * nothing; bucket n > 0 those that dispatched 2^(n-1) up to
+	 * 2^n - 1 handlers.  Bucket n of latency counts iterations
+	 * that took from 2^n up to 2^(n+1) microseconds to dispatch
+	 * (bucket 0 includes those under a microsecond); the last
+	 * bucket of each takes everything bigger.
+	 */
+	inline u_int32_t niter() const { return (niter_); }
+	inline const u_int32_t* ndispatch() const { return (ndispatch_); }
+	inline const u_int32_t* latency() const { return (latency_); }
+	void reset();
+private:
+	EventLoop(int fd);
+	static int bucket(u_int32_t v);
+	static EventLoop* instance_;
+
+	int fd_;
+	int nfd_;
+	int stop_;
+	double tcl_;		/* when Tcl's events were last run */
+	/* the iteration being dispatched; unlink() clears its handler */
+	IOHandler* ready_[EVLOOP_MAXEVENTS];
+	int mask_[EVLOOP_MAXEVENTS];
+	int nready_;
+
+	u_int32_t niter_;
+	u_int32_t ndispatch_[EVLOOP_NHIST];
+	u_int32_t latency_[EVLOOP_NHIST];
+};
+
+#endif
@@ -30,96 +30,27 @@
 #ifndef lib_huffman_h
 #define lib_huffman_h
 
+#include "bitio.h"
+
 struct huffent {
 	int val;
 	int nb;
 };
 
 #define HUFF_SYM_ILLEGAL (0x8000 >> 5)
-#define HUFF_MASK(s) ((1 << (s)) - 1)
+#define HUFF_MASK(s) BITS_MASK(s)
 
 /*
- * Read the next 16 bits off the bit string into the bit buffer.
- * Skip over zero-stuffed ff's but make no attempt to verify
- * that they aren't some other marker (which should not be in the
- * middle of a block anyway).
+ * The bit buffer is a bitbuf, filled and emptied as bitio.h says;
+ * these keep the argument order the pvh coder has always used.
  */
-#define HUFF_READ(bb, bs) \
-{ \
-	register int v; \
-	register const u_char *cp = (bs); \
- \
-	bb <<= 16; \
-	v = *cp++; \
-	bb |= v << 8; \
-	v = *cp++; \
-	bb |= v; \
-	(bs) = cp; \
- \
-}
-
-#define GET_BITS(n, nbb, bb, bs, result) \
-{ \
-	nbb -= n; \
-	if (nbb < 0) { \
-		HUFF_READ(bb, bs); \
-		nbb += 16; \
-	} \
-	(result) = (((bb) >> (nbb)) & HUFF_MASK(n)); \
-/*printf("gb %d(%x)\n", n, (result));*/\
-}
-
-#define SKIP_BITS(n, nbb, bb) \
-{ \
-	nbb -= n; \
-	if (nbb < 0)  { \
-		HUFFRQ(bb); \
-		nbb += 16; \
-	} \
-}
+#define GET_BITS(n, nbb, bb, bs, result) BITS_GET(bs, n, nbb, bb, result)
 
-#define HUFF_DECODE(ht, maxlen, nbb, bb, bs, result) { \
-	register int s__, v__; \
- \
-	 /*XXX*/ \
-	while (nbb < maxlen) { \
-		bb <<= 8; \
-		bb |= *(bs)++; \
-		nbb += 8; \
-	} \
-	s__ = maxlen; \
-	v__ = (bb >> (nbb - s__)) & HUFF_MASK(s__); \
-	s__ = (ht)[v__]; \
-	nbb -= (s__ & 0x1f); \
-	result = s__ >> 5; \
-}
+#define HUFF_DECODE(ht, maxlen, nbb, bb, bs, result) \
+	BITS_HUFF(bs, ht, maxlen, nbb, bb, result)
 
-/*XXX use 64-bits if available */
-#define HUFF_NBIT 32
-
-#if BYTE_ORDER == LITTLE_ENDIAN
-#define HUFF_STORE_BITS(bs, bb) \
-	((u_char*)bs)[0] = bb >> 24; \
-	((u_char*)bs)[1] = bb >> 16; \
-	((u_char*)bs)[2] = bb >> 8; \
-	((u_char*)bs)[3] = bb;
-#else
-#define HUFF_STORE_BITS(bs, bb) *(u_int*)(bs) = (bb);
-#endif
+#define HUFF_STORE_BITS(bs, bb) bits_store64((u_char*)(bs), bb);
 
-#define PUT_BITS(bits, n, nbb, bb, bs) \
-{ \
-if (0) printf("pb %d(%x %d%d%d)\n", n, bits, (bits >> 2) & 1, (bits >> 1) & 1, bits & 1); \
-	nbb += (n); \
-	if (nbb > HUFF_NBIT)  { \
-		int extra = (nbb) - HUFF_NBIT; \
-		bb |= (bits) >> extra; \
-		HUFF_STORE_BITS(bs, bb) \
-		bs += (HUFF_NBIT / 8); \
-		bb = (bits) << (HUFF_NBIT - extra); \
-		nbb = extra; \
-	} else \
-		bb |= (bits) << (HUFF_NBIT - (nbb)); \
-}
+#define PUT_BITS(bits, n, nbb, bb, bs) BITS_PUT(bits, n, nbb, bb, bs)
 
 #endif
@@ -32,6 +32,7 @@ static const char rcsid[] =
 
 #include "config.h"
 #include "iohandler.h"
+#include "eventloop.h"
 #ifdef WIN32
 #include "vic_tcl.h"
 #include <stdlib.h>
@@ -71,7 +72,7 @@ IOHandler::WSocketHandler(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
 }
 #endif
 
-IOHandler::IOHandler() : fd_(-1)
+IOHandler::IOHandler() : fd_(-1), loop_(0)
 #ifdef WIN32
     , hwnd_(0)
 #endif
@@ -129,7 +130,13 @@ void IOHandler::link(int fd, int mask)
 	    
         }
 #else
-	Tk_CreateFileHandler(fd, mask, callback, (ClientData)this);
+	EventLoop* loop = EventLoop::instance();
+	if (loop != 0) {
+		loop->link(this, fd, mask);
+		loop_ = 1;
+		return;
+	}
+	Tk_CreateFileHandler(fd, mask & ~IO_EDGE, callback, (ClientData)this);
 #endif
 }
 
@@ -148,7 +155,11 @@ void IOHandler::unlink()
 	}
 #else
 	if (fd_ >= 0) {
-		Tk_DeleteFileHandler(fd_);
+		if (loop_) {
+			EventLoop::instance()->unlink(this, fd_);
+			loop_ = 0;
+		} else
+			Tk_DeleteFileHandler(fd_);
 		fd_ = -1;
 	}
 #endif
@@ -40,6 +40,14 @@ extern "C" {
 #include <tk.h>
 }
 
+/*
+ * With the mask to link(): tell only when the descriptor becomes
+ * ready, so dispatch() has to read until it would block.  Only the
+ * epoll event core (eventloop.h) does it; the Tk notifier keeps on
+ * telling, which a handler that drains doesn't mind.
+ */
+#define IO_EDGE 0x100
+
 class IOHandler {
 protected:
 	IOHandler();
@@ -50,6 +58,7 @@ public:
 protected:
 	virtual void dispatch(int mask) = 0;
 private:
+	friend class EventLoop;
 #ifdef WIN32
 	static LRESULT CALLBACK WSocketHandler(HWND, UINT, WPARAM, LPARAM);
 	HWND hwnd_;
@@ -57,6 +66,7 @@ private:
 	static void callback(ClientData, int mask);
 #endif
 	int fd_;
+	int loop_;	/* true if on the EventLoop */
 };
 
 #endif
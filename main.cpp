@@ -61,6 +61,7 @@ static const char rcsid[] =
 #include "inet.h"
 #include "vic_tcl.h"
 #include "transmitter.h"
+#include "eventloop.h"
 
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
@@ -181,6 +182,61 @@ static class UsageCommand : public TclObject {
 #endif
 #endif
 
+/*
+ * eventloop enabled|nfd|niter|ndispatch|latency|reset: whether vic
+ * is on the epoll event core (-XeventLoop=epoll), the descriptors
+ * on it, and its dispatch and latency histograms (see eventloop.h),
+ * one count per bucket.
+ */
+static class EventLoopCommand : public TclObject {
+	public:
+		EventLoopCommand() : TclObject("eventloop") {}
+		int command(int argc, const char*const* argv);
+} cmd_eventloop;
+
+int EventLoopCommand::command(int argc, const char*const* argv)
+{
+	Tcl& tcl = Tcl::instance();
+	EventLoop* loop = EventLoop::instance();
+	if (argc == 2) {
+		if (strcmp(argv[1], "enabled") == 0) {
+			tcl.result(loop != 0 ? "1" : "0");
+			return (TCL_OK);
+		}
+		if (loop == 0) {
+			tcl.result("eventloop: not enabled");
+			return (TCL_ERROR);
+		}
+		if (strcmp(argv[1], "nfd") == 0) {
+			tcl.resultf("%d", loop->nfd());
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "niter") == 0) {
+			tcl.resultf("%u", loop->niter());
+			return (TCL_OK);
+		}
+		const u_int32_t* h = 0;
+		if (strcmp(argv[1], "ndispatch") == 0)
+			h = loop->ndispatch();
+		else if (strcmp(argv[1], "latency") == 0)
+			h = loop->latency();
+		if (h != 0) {
+			char* bp = tcl.buffer();
+			tcl.result(bp);
+			for (int i = 0; i < EVLOOP_NHIST; ++i) {
+				sprintf(bp, i == 0 ? "%u" : " %u", h[i]);
+				bp += strlen(bp);
+			}
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "reset") == 0) {
+			loop->reset();
+			return (TCL_OK);
+		}
+	}
+	return (TclObject::command(argc, argv));
+}
+
 extern void adios();
 
 	static SIGRET
@@ -796,6 +852,10 @@ int main(int argc, const char** argv)
 		usage("vic: destination address required\n");
 	}
 	tcl.add_option("defaultHostSpec", dst);
+	/* before vic_main opens the sockets, which link to it */
+	const char* loop = tcl.attr("eventLoop");
+	if (loop != 0 && strcmp(loop, "epoll") == 0 && EventLoop::enable() == 0)
+		fprintf(stderr, "vic: no epoll; using the Tk event loop\n");
 #ifdef notdef
 	const char* outfile = tcl.attr("outfile");
 	if (outfile != 0) {
@@ -879,7 +939,10 @@ int main(int argc, const char** argv)
 		}
 	}
 #else
-	Tk_MainLoop();
+	if (EventLoop::instance() != 0)
+		EventLoop::instance()->run();
+	else
+		Tk_MainLoop();
 #endif
 #endif
 	adios();
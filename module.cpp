@@ -32,6 +32,7 @@ static const char rcsid[] =
     "@(#) $Header$ (LBL)";
 #endif
 #include "module.h"
+#include "source.h"
 
 const char* Module::fttoa(int ft)
 {
@@ -115,6 +116,11 @@ TransmitterModule::~TransmitterModule()
 	delete pool_;
 }
 
+u_int32_t TransmitterModule::srcid() const
+{
+	return (pool_->srcid());
+}
+
 int TransmitterModule::command(int argc, const char*const* argv)
 {
 	//SV-XXX: unused: Tcl& tcl = Tcl::instance();
@@ -127,6 +133,11 @@ int TransmitterModule::command(int argc, const char*const* argv)
 			tx_->loop_layer(atoi(argv[2]));
 			return (TCL_OK);
 		}
+		if (strcmp(argv[1], "srcid") == 0) {
+			/* send from an ssrc other than localsrc's */
+			pool_->srcid(htonl(strtoul(argv[2], 0, 10)));
+			return (TCL_OK);
+		}
 	}
 	return (Module::command(argc, argv));
 }
@@ -40,6 +40,7 @@ class Transmitter;
 class RTP_BufferPool;
 class BufferPool;
 class pktbuf;
+class RenderPlan;
 
 class VideoFrame {
     public:
@@ -64,9 +65,11 @@ class YuvFrame : public VideoFrame {
     public:
 	    inline YuvFrame(u_int32_t ts, u_int8_t* bp, u_int8_t* crvec,
 			int w, int h, int layer=0) :
-			VideoFrame(ts, bp, w, h, layer), crvec_(crvec) {}
+			VideoFrame(ts, bp, w, h, layer), crvec_(crvec),
+			plan_(0) {}
 
 	    const u_int8_t* crvec_;
+	    const RenderPlan* plan_;	/* changed blocks, if known */
 };
 
 class JpegFrame : public VideoFrame {
@@ -147,6 +150,7 @@ class TransmitterModule : public Module {
     public:
 	~TransmitterModule();
 	virtual int command(int argc, const char*const* argv);
+	u_int32_t srcid() const;	/* SSRC we send as, net order */
     protected:
 	TransmitterModule(int ft);
 	Transmitter* tx_;
@@ -31,10 +31,26 @@ static const char rcsid[] =
     "@(#) $Header$ (LBL)";
 
 #include "pktbuf.h"
+#ifndef WIN32
+#include <pthread.h>
+#endif
 
 pktbuf* BufferPool::freebufs_=0;
 int BufferPool::nbufs_=0;
 
+/*
+ * The free list is shared by every pool, and encoders running on
+ * worker threads (see Simulcast) allocate from it at the same time.
+ */
+#ifndef WIN32
+static pthread_mutex_t freelock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK() pthread_mutex_lock(&freelock)
+#define UNLOCK() pthread_mutex_unlock(&freelock)
+#else
+#define LOCK()
+#define UNLOCK()
+#endif
+
 /*static class BufferPoolClass : public TclClass {
 public:
 	BufferPoolClass() : TclClass("BufferPool") {}
@@ -50,14 +66,17 @@ BufferPool::BufferPool()
 
 pktbuf* BufferPool::alloc(int layer)
 {
+	LOCK();
 	pktbuf* pb = freebufs_;
 	if (pb != 0)
 		freebufs_ = pb->next;
-	else {
+	else
+		++nbufs_;
+	UNLOCK();
+	if (pb == 0) {
 		/*XXX grow exponentially*/
 		pb = new pktbuf;
 		pb->manager = this;
-		++nbufs_;
 	}
 	pb->len = 0;
 	pb->ref = 1;
@@ -68,8 +87,10 @@ pktbuf* BufferPool::alloc(int layer)
 
 void BufferPool::release(pktbuf* pb)
 {
+	LOCK();
 	pb->next = freebufs_;
 	freebufs_ = pb;
+	UNLOCK();
 }
 
 Buffer* pktbuf::copy()
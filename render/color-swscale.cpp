@@ -121,6 +121,8 @@ public:
 	    }
 
 	    i_width = width_; i_height = height_; o_width = outw_; o_height = outh_;
+	    /* (a different image of the ring each time) */
+	    sws_tar[0] = pixbuf_;
 	    sws_src[0] = (uint8_t*)frm;
 	    sws_src[1] = sws_src[0] + framesize_;
 	    if (decimation_ == 422) {
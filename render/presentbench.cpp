@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * presentbench - time putting frames into many video windows with
+ * an XSync after each, as vic did, and with a ring of shared images
+ * and completion events (ImageRing, vw.h).
+ *
+ * usage: presentbench [-n windows] [-s widthxheight] [-f frames]
+ *		       [-i images]
+ *
+ * `windows' (16) windows of the given size (320x240) are opened on
+ * $DISPLAY, which has to have the MIT-SHM extension (Xvfb does, so
+ * `xvfb-run presentbench' will do).  Each of `frames' (300) times,
+ * a frame is written into every window's image and put, as fast as
+ * they go.  With XSync, the frames a second and the time the XSyncs
+ * took are printed; with the ring of `images' (2) images, the frames
+ * a second put and dropped (the server not done with the images)
+ * and the mean and worst present latency, the time from the put to
+ * the completion event.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "bench.h"
+#include "vic_tcl.h"
+#include "vw.h"
+
+/* vw.cpp and the X11 grabber look at these; they live in main.cpp */
+int use_shm = 1;
+int use_ddraw = 0;
+
+/* this frame's picture: a band that moves down a line a frame */
+static void fill(u_char* p, int bpl, int height, int frame)
+{
+	for (int y = 0; y < height; ++y)
+		memset(p + y * bpl, ((y + frame) & 63) << 2, bpl);
+}
+
+static VideoWindow** windows(int n, int width, int height)
+{
+	Tcl& tcl = Tcl::instance();
+	VideoWindow** vw = new VideoWindow*[n];
+	for (int i = 0; i < n; ++i) {
+		tcl.evalf("video .v%d %d %d", i, width, height);
+		vw[i] = VideoWindow::lookup(tcl.result());
+		tcl.evalf("grid .v%d -row %d -column %d", i, i / 8, i % 8);
+	}
+	tcl.evalc("update");
+	return (vw);
+}
+
+static void synced(VideoWindow** vw, int n, int width, int height,
+		   int nframe)
+{
+	StandardVideoImage** vi = new StandardVideoImage*[n];
+	int i;
+	for (i = 0; i < n; ++i)
+		vi[i] = StandardVideoImage::allocate(vw[i]->tkwin(), width,
+						     height);
+	XImage* xi = vi[0]->ximage();
+	double tsync = 0.;
+	double start = bench_now();
+	for (int f = 0; f < nframe; ++f) {
+		for (i = 0; i < n; ++i) {
+			fill(vi[i]->pixbuf(), xi->bytes_per_line, height, f);
+			vw[i]->render(vi[i]);
+			double t = bench_now();
+			vw[i]->complete();
+			tsync += bench_now() - t;
+		}
+		while (Tcl_DoOneEvent(TCL_ALL_EVENTS | TCL_DONT_WAIT))
+			;
+	}
+	double t = bench_now() - start;
+	printf("%-8s %8.1f %8s %10.3f\n", "xsync", nframe * n / t, "-",
+	       1e3 * tsync / (nframe * n));
+	for (i = 0; i < n; ++i) {
+		vw[i]->setimage(0);
+		delete vi[i];
+	}
+	delete[] vi;
+}
+
+static void ringed(VideoWindow** vw, int n, int width, int height,
+		   int nframe, int nimage)
+{
+	ImageRing** ring = new ImageRing*[n];
+	int bpl = 0;
+	int i;
+	for (i = 0; i < n; ++i) {
+		ring[i] = new ImageRing(vw[i]);
+		for (int k = 0; k < nimage; ++k) {
+			StandardVideoImage* p = StandardVideoImage::allocate(
+				vw[i]->tkwin(), width, height);
+			bpl = p->ximage()->bytes_per_line;
+			ring[i]->add(p, p->pixbuf());
+		}
+	}
+	double start = bench_now();
+	for (int f = 0; f < nframe; ++f) {
+		for (i = 0; i < n; ++i) {
+			u_int base;
+			if (ring[i]->next(f & 0xff, base) < 0)
+				continue;
+			fill(ring[i]->pixbuf(), bpl, height, f);
+			ring[i]->present(0, 0, 0, 0);
+			ring[i]->done(f & 0xff);
+		}
+		ring[0]->flush();
+		/* the completion events */
+		while (Tcl_DoOneEvent(TCL_ALL_EVENTS | TCL_DONT_WAIT))
+			;
+	}
+	double t = bench_now() - start;
+	u_int32_t nput = 0, ndrop = 0;
+	double latency = 0., worst = 0.;
+	for (i = 0; i < n; ++i) {
+		nput += ring[i]->npresent();
+		ndrop += ring[i]->ndrop();
+		latency += ring[i]->latency();
+		if (ring[i]->maxlatency() > worst)
+			worst = ring[i]->maxlatency();
+	}
+	char name[16];
+	sprintf(name, "ring/%d", nimage);
+	printf("%-8s %8.1f %8.1f %10.3f %10.3f\n", name, nput / t, ndrop / t,
+	       latency / n, worst);
+	for (i = 0; i < n; ++i) {
+		vw[i]->setimage(0);
+		delete ring[i];
+	}
+	delete[] ring;
+}
+
+static const char synopsis[] =
+	"presentbench [-n windows] [-s widthxheight] "
+	"[-f frames]\n\t\t    [-i images]\n";
+
+int main(int argc, char** argv)
+{
+	int n = 16;
+	int width = 320;
+	int height = 240;
+	int nframe = 300;
+	int nimage = 2;
+	int op;
+	while ((op = getopt(argc, argv, "n:s:f:i:")) != -1) {
+		switch (op) {
+		case 'n':
+			n = atoi(optarg);
+			break;
+		case 's':
+			if (!bench_size(optarg, &width, &height))
+				bench_usage(synopsis);
+			break;
+		case 'f':
+			nframe = atoi(optarg);
+			break;
+		case 'i':
+			nimage = atoi(optarg);
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind != argc || n < 1 || n > 64 || width < 16 || height < 16 ||
+	    nframe < 1 || nimage < 2 || nimage > IMAGE_RING)
+		bench_usage(synopsis);
+
+	Tcl_FindExecutable(argv[0]);
+	Tcl::init("presentbench");
+	Tcl& tcl = Tcl::instance();
+	if (Tcl_Init(tcl.interp()) != TCL_OK ||
+	    Tk_Init(tcl.interp()) != TCL_OK) {
+		fprintf(stderr, "presentbench: %s\n", tcl.result());
+		exit(1);
+	}
+	tcl.tkmain(Tk_MainWindow(tcl.interp()));
+
+	VideoWindow** vw = windows(n, width, height);
+	StandardVideoImage* p = StandardVideoImage::allocate(vw[0]->tkwin(),
+							     width, height);
+	int shared = p->shmseg() != 0;
+	delete p;
+	if (!shared) {
+		fprintf(stderr, "presentbench: no shared memory images\n");
+		exit(1);
+	}
+
+	printf("%d windows %dx%d, %d frames\n", n, width, height, nframe);
+	printf("%-8s %8s %8s %10s %10s\n", "", "put/s", "drop/s",
+	       "ms wait", "ms worst");
+	synced(vw, n, width, height, nframe);
+	ringed(vw, n, width, height, nframe, nimage);
+	return (0);
+}
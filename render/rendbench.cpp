@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * rendbench - check and time the direct color renderers (16, 24 and
+ * 32 bits per pixel) on every chroma layout and scale they support.
+ *
+ * usage: rendbench [-n frames] [-r rounds] [-s widthxheight] [file]
+ *
+ * The input is one 4:2:0 planar frame of the given size (CIF by
+ * default) read from `file', or a synthetic frame if there's
+ * no file.  For 4:2:2 each chroma row is used twice.  For each
+ * combination, the whole frame and a run of random rectangles of
+ * it are converted by YuvMap and by the kernels it replaced (see
+ * rendref.cpp), and the output compared; then the whole frame is
+ * converted `frames' times by each, taking turns, `rounds' (5)
+ * times over, and the best rate of each is reported in frames per
+ * second, so that other load on the machine counts for little.
+ * The exit status is 1 if any output differed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../config.h"
+#include "../bench.h"
+#include "yuv-map.h"
+#include "rendref.h"
+
+static int clamp(int v)
+{
+	return (v < -128 ? -128 : v > 127 ? 127 : v);
+}
+
+/*
+ * Same as TrueColorModel::alloc_colors on an 8:8:8 visual.
+ */
+static void true_tab(u_int* uvtab)
+{
+	for (int u = 0; u < 256; ++u) {
+		double uf = double(u - 128);
+		for (int v = 0; v < 256; ++v) {
+			double vf = double(v - 128);
+			int r = clamp(int(vf * 1.402));
+			int b = clamp(int(uf * 1.772));
+			int g = clamp(int(uf * -0.34414 - vf * 0.71414));
+			uvtab[(u << 8) | v] = (r & 0xff) << 16 |
+				(g & 0xff) << 8 | (b & 0xff);
+		}
+	}
+}
+
+/*
+ * Roughly what HiColorModel::alloc_colors builds for 5:6:5.
+ */
+static void hi_tab(u_short* uvtab)
+{
+	for (int u = 0; u < 256; u += 8) {
+		for (int v = 0; v < 256; v += 8) {
+			for (int y = 3; y < 256; y += 4) {
+				int r = y + int((v - 128) * 1.402);
+				int g = y - int((u - 128) * 0.34414 +
+						(v - 128) * 0.71414);
+				int b = y + int((u - 128) * 1.772);
+				r = clamp(r - 128) + 128;
+				g = clamp(g - 128) + 128;
+				b = clamp(b - 128) + 128;
+				uvtab[UVINDX(u, v) | (y >> 2)] =
+					(r >> 3) << 11 | (g >> 2) << 5 | b >> 3;
+			}
+		}
+	}
+}
+
+static int nframe = 100;
+static int nround = 5;
+
+/*
+ * Convert the width x height rectangle at (x, y) with kernel
+ * `index' (see WindowRenderer::index()) `n' times, with YuvMap
+ * or, if ref, with the old kernel.  Returns the time it took.
+ */
+template <class P>
+static double run(const P& p, const RefRenderer* ref, int index,
+		  YuvTarget& t, const u_char* frm, int x, int y, int width,
+		  int height, int n)
+{
+	typename YuvMap<P>::Method m = YuvMap<P>::method(index);
+	int off = y * t.width + x;
+	double t0 = bench_now();
+	for (int i = 0; i < n; ++i) {
+		if (ref != 0)
+			ref->render(index, frm, off, x, width, height);
+		else
+			(*m)(p, t, frm, off, x, width, height);
+	}
+	return (bench_now() - t0);
+}
+
+/*
+ * Convert the same rectangles both ways into buffers that start
+ * out the same, and return true if the results match.  Only whole
+ * 8x8 blocks are drawn, 16x16 when decimating by 16 or more.
+ */
+template <class P>
+static int same(const P& p, const RefRenderer* ref, int index,
+		YuvTarget& t, YuvTarget& rt, const u_char* frm, int height,
+		int bufsize)
+{
+	int a = (t.scale >= 4) ? 16 : 8;
+	int bw = t.width / a;
+	int bh = height / a;
+	for (int k = 0; k < 20; ++k) {
+		int x = 0, y = 0, w = t.width, h = height;
+		if (k > 0) {
+			x = random() % bw;
+			y = random() % bh;
+			w = a * (1 + random() % (bw - x));
+			h = a * (1 + random() % (bh - y));
+			x *= a;
+			y *= a;
+		}
+		memset(t.pixbuf, 0x5a, bufsize);
+		memset(rt.pixbuf, 0x5a, bufsize);
+		run(p, 0, index, t, frm, x, y, w, h, 1);
+		run(p, ref, index, rt, frm, x, y, w, h, 1);
+		if (memcmp(t.pixbuf, rt.pixbuf, bufsize) != 0)
+			return (0);
+	}
+	return (1);
+}
+
+static double rate(double t)
+{
+	return (t > 0. ? nframe / t : 0.);
+}
+
+/*
+ * Check and time one combination at `bpp' bits per pixel, with
+ * the old kernel drawing into rt, and print the old and new rates,
+ * or that the output differed.  Returns false if it did.
+ */
+template <class P>
+static int bench(const P& p, int bpp, const void* uvtab, int index,
+		 YuvTarget& t, YuvTarget& rt, const u_char* frm, int height,
+		 int bufsize)
+{
+	RefRenderer* ref = RefRenderer::alloc(bpp, rt, uvtab, 0x808080,
+					      0xffffff);
+	int ok = same(p, ref, index, t, rt, frm, height, bufsize);
+	if (ok) {
+		double told = 0., tnew = 0.;
+		for (int k = 0; k < nround; ++k) {
+			double o = run(p, ref, index, rt, frm, 0, 0, t.width,
+				       height, nframe);
+			double n = run(p, 0, index, t, frm, 0, 0, t.width,
+				       height, nframe);
+			if (k == 0 || o < told)
+				told = o;
+			if (k == 0 || n < tnew)
+				tnew = n;
+		}
+		printf(" %8.0f %8.0f", rate(told), rate(tnew));
+	} else
+		printf(" %17s", "differs");
+	delete ref;
+	return (ok);
+}
+
+static const char synopsis[] =
+	"rendbench [-n frames] [-r rounds] [-s widthxheight] [file]\n";
+
+int main(int argc, char** argv)
+{
+	int width = 352;
+	int height = 288;
+	int op;
+	while ((op = getopt(argc, argv, "n:r:s:")) != -1) {
+		switch (op) {
+		case 'n':
+			nframe = atoi(optarg);
+			break;
+		case 'r':
+			nround = atoi(optarg);
+			break;
+		case 's':
+			if (!bench_size(optarg, &width, &height))
+				bench_usage(synopsis);
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind < argc - 1 || nframe <= 0 || nround <= 0 ||
+	    width <= 0 || (width & 15) != 0 ||
+	    height <= 0 || (height & 15) != 0)
+		bench_usage(synopsis);
+
+	int fs = width * height;
+	u_char* f420 = new u_char[fs + fs / 2];
+	if (optind < argc) {
+		FILE* f = fopen(argv[optind], "rb");
+		if (f == 0) {
+			perror(argv[optind]);
+			exit(1);
+		}
+		size_t n = fs + fs / 2;
+		if (fread(f420, 1, n, f) != n) {
+			fprintf(stderr, "rendbench: %s: short frame\n",
+				argv[optind]);
+			exit(1);
+		}
+		fclose(f);
+	} else {
+		/* noisy luma, smooth chroma */
+		srandom(1);
+		for (int i = 0; i < fs; ++i)
+			f420[i] = random();
+		for (int i = 0; i < fs / 2; ++i) {
+			int x = i % (width / 2);
+			int y = (i % (fs / 4)) / (width / 2);
+			f420[fs + i] = 64 + (x + y) % 128;
+		}
+	}
+	/* the same picture, 4:2:2 */
+	u_char* f422 = new u_char[2 * fs];
+	memcpy(f422, f420, fs);
+	int cw = width / 2;
+	for (int plane = 0; plane < 2; ++plane) {
+		const u_char* sp = f420 + fs + plane * (fs / 4);
+		u_char* dp = f422 + fs + plane * (fs / 2);
+		for (int y = 0; y < height; ++y)
+			memcpy(dp + y * cw, sp + (y >> 1) * cw, cw);
+	}
+
+	u_int* truetab = new u_int[65536];
+	true_tab(truetab);
+	u_short* hitab = new u_short[65536];
+	memset(hitab, 0, 65536 * sizeof(*hitab));
+	hi_tab(hitab);
+	TruePixel32 p32(truetab, 0x808080, 0xffffff);
+	TruePixel24 p24(truetab, 0x808080, 0xffffff);
+	HiPixel p16(hitab);
+
+	/* room for a doubled frame at 4 bytes per pixel */
+	int bufsize = 16 * fs;
+	u_char* pixbuf = new u_char[bufsize];
+	u_char* refbuf = new u_char[bufsize];
+	memset(pixbuf, 0, bufsize);
+	memset(refbuf, 0, bufsize);
+
+	static const char* layout[] = { "420", "422", "gray" };
+	printf("%dx%d, best of %d x %d frames; frames/sec, old and new\n",
+	       width, height, nround, nframe);
+	printf("%-6s %-6s %17s %17s %17s\n", "scale", "input", "16bpp",
+	       "24bpp", "32bpp");
+	int bad = 0;
+	for (int scale = -1; scale <= 4; ++scale) {
+		for (int c = 0; c < 3; ++c) {
+			YuvTarget t;
+			t.pixbuf = pixbuf;
+			t.width = width;
+			t.framesize = fs;
+			t.scale = scale;
+			YuvTarget rt = t;
+			rt.pixbuf = refbuf;
+			int index = ((scale < 3 ? scale + 1 : 4) << 2) | c;
+			const u_char* frm = (c == 1) ? f422 : f420;
+			char s[16];
+			if (scale < 0)
+				strcpy(s, "2:1");
+			else
+				sprintf(s, "1:%d", 1 << scale);
+			printf("%-6s %-6s", s, layout[c]);
+			bad += !bench(p16, 16, hitab, index, t, rt, frm,
+				      height, bufsize);
+			bad += !bench(p24, 24, truetab, index, t, rt, frm,
+				      height, bufsize);
+			bad += !bench(p32, 32, truetab, index, t, rt, frm,
+				      height, bufsize);
+			printf("\n");
+		}
+	}
+	if (bad) {
+		printf("%d combinations differ from the old kernels\n", bad);
+		return (1);
+	}
+	return (0);
+}
@@ -31,6 +31,7 @@ static const char rcsid[] =
     "@(#) $Header$ (LBL)";
 
 #include <stdlib.h>
+#include <string.h>
 #include "vw.h"
 #include "renderer-window.h"
 #include "color.h"
@@ -39,6 +40,7 @@ WindowRenderer::WindowRenderer(VideoWindow* w, int decimation) :
 	BlockRenderer(decimation == 422 ? FT_YUV_422 : FT_YUV_420),
 	window_(w),
 	image_(0),
+	ring_(0),
 	ww_(w->width()),
 	wh_(w->height()),
 	scale_(0),
@@ -57,7 +59,55 @@ WindowRenderer::~WindowRenderer()
 	 * and replaces the image.
 	 */
 	window_->setimage(0);
-	delete image_;
+	free_image();
+}
+
+void WindowRenderer::free_image()
+{
+	if (ring_ != 0) {
+		/* image_ is one of its images */
+		delete ring_;
+		ring_ = 0;
+	} else
+		delete image_;
+	image_ = 0;
+}
+
+int WindowRenderer::command(int argc, const char*const* argv)
+{
+	if (argc == 2 && strcmp(argv[1], "present") == 0) {
+		Tcl& tcl = Tcl::instance();
+		if (ring_ == 0)
+			tcl.result("images 1");
+		else
+			tcl.resultf("images %d presented %u dropped %u "
+				    "latency %.2f max %.2f", ring_->nimage(),
+				    ring_->npresent(), ring_->ndrop(),
+				    ring_->latency(), ring_->maxlatency());
+		return (TCL_OK);
+	}
+	return (BlockRenderer::command(argc, argv));
+}
+
+int WindowRenderer::begin(u_int ts, u_int& base)
+{
+	if (ring_ == 0)
+		return (BlockRenderer::begin(ts, base));
+	int r = ring_->next(ts, base);
+	image_ = ring_->image();
+	return (r);
+}
+
+void WindowRenderer::end(u_int ts)
+{
+	if (ring_ != 0)
+		ring_->done(ts);
+}
+
+void WindowRenderer::invalidate()
+{
+	if (ring_ != 0)
+		ring_->invalidate();
 }
 
 static inline int
@@ -112,22 +162,99 @@ void WindowRenderer::compute_scale(int w, int h)
 #endif
 }
 
+/*
+ * A window smaller than the frame needs no more than its own size
+ * decoded: halve the frame, up to twice, while it still covers it.
+ */
+int WindowRenderer::reduction(int w, int h) const
+{
+	int s = 0;
+	while (s < 2 && (w >> (s + 1)) >= ww_ && (h >> (s + 1)) >= wh_)
+		++s;
+	return (s);
+}
+
+/*
+ * Return the part of the frame, in source pixels rounded out to
+ * whole blocks, that shows through the window.  When the scaled
+ * image is larger than the window, or has been panned with voff/hoff,
+ * the rest is never seen and there's no point color converting it.
+ */
+int WindowRenderer::visible(int& x0, int& y0, int& x1, int& y1) const
+{
+	if (!window_->mapped())
+		return (0);
+	x0 = 0;
+	y0 = 0;
+	x1 = width_;
+	y1 = height_;
+	if (enable_xv)
+		/* the server scales the whole frame */
+		return (1);
+
+	/* the image is centered in the window (see VideoWindow::draw) */
+	int ww = window_->width();
+	int wh = window_->height();
+	int hoff = ((ww - outw_) >> 1) + window_->hoff();
+	int voff = ((wh - outh_) >> 1) + window_->voff();
+	int ox0 = (hoff < 0) ? -hoff : 0;
+	int oy0 = (voff < 0) ? -voff : 0;
+	int ox1 = (ww - hoff < outw_) ? ww - hoff : outw_;
+	int oy1 = (wh - voff < outh_) ? wh - voff : outh_;
+	if (ox0 >= ox1 || oy0 >= oy1)
+		return (0);
+
+	if (scale_ >= 0) {
+		x0 = ox0 << scale_;
+		y0 = oy0 << scale_;
+		x1 = ox1 << scale_;
+		y1 = oy1 << scale_;
+	} else {
+		int s = -scale_;
+		x0 = ox0 >> s;
+		y0 = oy0 >> s;
+		x1 = (ox1 + (1 << s) - 1) >> s;
+		y1 = (oy1 + (1 << s) - 1) >> s;
+	}
+	x0 &= ~7;
+	y0 &= ~7;
+	x1 = (x1 + 7) & ~7;
+	y1 = (y1 + 7) & ~7;
+	if (x1 > width_)
+		x1 = width_;
+	if (y1 > height_)
+		y1 = height_;
+	return (1);
+}
+
 void WindowRenderer::sync() const
 {
-	window_->complete();
+	if (ring_ != 0)
+		/* the completion events tell when the server is done */
+		ring_->flush();
+	else
+		window_->complete();
+}
+
+void WindowRenderer::put(int miny, int maxy, int minx, int maxx) const
+{
+	if (ring_ != 0)
+		ring_->present(miny, maxy, minx, maxx);
+	else
+		window_->render(image_, miny, maxy, minx, maxx);
 }
 
 void WindowRenderer::push(const u_char*, int miny, int maxy, int minx, int maxx) const
 {
         if(enable_xv){
-            window_->render(image_, 0, outh_, 0, outw_ );
+            put(0, outh_, 0, outw_ );
 			return;
         }            
 	
 #ifdef HAVE_SWSCALE
 		// swscaler render called - alothough args are zero it uses the global variables
 		// Should probably alter this so that global variables are passed in the args for clarity
-	window_->render(image_, 0, 0 , 0, 0);
+	put(0, 0 , 0, 0);
 #else
 	if (scale_ >= 0) {
 		miny >>= scale_;
@@ -140,7 +267,7 @@ void WindowRenderer::push(const u_char*, int miny, int maxy, int minx, int maxx)
 		minx <<= -scale_;
 		maxx <<= -scale_;
 	}
-	window_->render(image_, miny, maxy, minx, maxx);
+	put(miny, maxy, minx, maxx);
 #endif	
 
 }
@@ -175,7 +302,7 @@ void WindowRenderer::resize(int w, int h)
 	 * dependent on the size of the window).
 	 */
 //	if (outw != outw_ || outh != outh_) {
-		delete image_;
+		free_image();
 		window_->setimage(0);
 		alloc_image();
 		/*XXX*/
@@ -188,6 +315,8 @@ void WindowRenderer::resize(int w, int h)
 void WindowRenderer::setcolor(int c)
 {
 	color_ = c;
+	/* the images hold pixels in the old colors */
+	invalidate();
 	doupdate();
 }
 
@@ -201,7 +330,8 @@ WindowDitherer::WindowDitherer(VideoWindow* vw, int decimation)
 {
 }
 
-void WindowDitherer::alloc_image()
+/* an image the size the window shows, and where its pixels go */
+VideoImage* WindowDitherer::new_image(u_char*& pixbuf)
 {
 	StandardVideoImage* p;
 
@@ -211,9 +341,8 @@ void WindowDitherer::alloc_image()
 	  XVideoImage *p;		
 	  p = XVideoImage::allocate(window_->tkwin(), width_, height_);	
 	  if(p){
-	    pixbuf_ = p->pixbuf();
-	    image_ = p;
-	    return;
+	    pixbuf = p->pixbuf();
+	    return (p);
 	  }	  
 	  enable_xv = false;
 	  debug_msg("disable xvideo\n");
@@ -221,6 +350,52 @@ void WindowDitherer::alloc_image()
 #endif
 
 	p = StandardVideoImage::allocate(window_->tkwin(), outw_, outh_);
-	pixbuf_ = p->pixbuf();
-	image_ = p;
+	pixbuf = p->pixbuf();
+	return (p);
+}
+
+void WindowDitherer::alloc_image()
+{
+	image_ = new_image(pixbuf_);
+
+	/*
+	 * With shared images, draw into a few by turns (see
+	 * ImageRing in vw.h) rather than wait on the server after
+	 * each frame.
+	 */
+	int n = 2;
+	const char* cp = Tcl::instance().attr("presentImages");
+	if (cp != 0)
+		n = atoi(cp);
+	if (n > IMAGE_RING)
+		n = IMAGE_RING;
+	if (n < 2 || image_->shmseg() == 0)
+		return;
+	VideoImage* vi[IMAGE_RING];
+	u_char* pixbuf[IMAGE_RING];
+	bool xv = enable_xv;
+	int m;
+	for (m = 1; m < n; ++m) {
+		vi[m] = new_image(pixbuf[m]);
+		if (vi[m]->shmseg() == 0 || enable_xv != xv) {
+			/* not the same kind; make do with what we have */
+			delete vi[m];
+			enable_xv = xv;
+			break;
+		}
+	}
+	if (m < 2)
+		return;
+	ring_ = new ImageRing(window_);
+	ring_->add(image_, pixbuf_);
+	for (int i = 1; i < m; ++i)
+		ring_->add(vi[i], pixbuf[i]);
+}
+
+int WindowDitherer::begin(u_int ts, u_int& base)
+{
+	int r = WindowRenderer::begin(ts, base);
+	if (ring_ != 0)
+		pixbuf_ = ring_->pixbuf();
+	return (r);
 }
@@ -34,6 +34,7 @@
 
 class VideoWindow;
 class VideoImage;
+class ImageRing;
 
 /*
  * A subclass of Renderer where video is sent to a display window.
@@ -47,13 +48,21 @@ class WindowRenderer : public BlockRenderer {
 		  int minx, int maxx) const;
 	void sync() const;
 	void resize(int w, int h);
+	virtual int reduction(int w, int h) const;
+	virtual int command(int argc, const char*const* argv);
 	void dither_null(const u_char* frm, u_int off, u_int x,
 			 u_int width, u_int height) const;
     protected:
 	/*XXX*/
 	virtual void setcolor(int c);
 	void compute_scale(int w, int h);
+	virtual int visible(int& x0, int& y0, int& x1, int& y1) const;
 	virtual void alloc_image() = 0;
+	virtual int begin(u_int ts, u_int& base);
+	virtual void end(u_int ts);
+	virtual void invalidate();
+	void free_image();
+	void put(int miny, int maxy, int minx, int maxx) const;
 	void doupdate();
 	virtual void update() = 0;
 	virtual void disable() = 0;
@@ -61,6 +70,7 @@ class WindowRenderer : public BlockRenderer {
 
 	VideoWindow* window_;
 	VideoImage* image_;
+	ImageRing* ring_;	/* images drawn into by turns, or 0 */
 	int ww_;		/* width of target window */
 	int wh_;		/* height of target window */
 	int scale_;		/* log base two of inverse of scale factor */
@@ -94,6 +104,8 @@ class WindowDitherer : public WindowRenderer {
     protected:
 	WindowDitherer(VideoWindow*, int decimation);
 	void alloc_image();
+	VideoImage* new_image(u_char*& pixbuf);
+	virtual int begin(u_int ts, u_int& base);
 
 	u_char* pixbuf_;
 };
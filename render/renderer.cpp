@@ -97,9 +97,94 @@ void Renderer::timeout()
 	msched(update_interval_);
 }
 
+RenderPlan::RenderPlan() :
+	width_(0),
+	height_(0),
+	base_(0),
+	nblk_(0),
+	nrect_(0),
+	rects_(0),
+	open_(0)
+{
+}
+
+RenderPlan::~RenderPlan()
+{
+	delete[] rects_;
+	delete[] open_;
+}
+
+void RenderPlan::resize(int w, int h)
+{
+	width_ = w;
+	height_ = h;
+	nblk_ = 0;
+	nrect_ = 0;
+	delete[] rects_;
+	delete[] open_;
+	/*
+	 * Worst case is a checkerboard, which gives one rectangle
+	 * for every other block in each row.
+	 */
+	int bw = w >> 3;
+	rects_ = new rect[(h >> 3) * ((bw + 1) >> 1) + 1];
+	open_ = new int[bw + 1];
+}
+
+void RenderPlan::build(const u_int8_t* ts, u_int base)
+{
+	base_ = base;
+	nblk_ = 0;
+	nrect_ = 0;
+	int bw = width_ >> 3;
+	int x;
+	for (x = 0; x < bw; ++x)
+		open_[x] = -1;
+
+	for (int y = 0; y < height_; y += 8) {
+		for (x = 0; x < bw; ) {
+			if (RV_PAST(base, ts[x])) {
+				++x;
+				continue;
+			}
+			int sx = x;
+			do {
+				++x;
+			} while (x < bw && !RV_PAST(base, ts[x]));
+			nblk_ += x - sx;
+			/*
+			 * If the run lines up exactly with a rectangle
+			 * that ended on the row above, grow that one.
+			 */
+			int k = open_[sx];
+			if (k >= 0) {
+				rect& r = rects_[k];
+				if (r.y + r.h == y && r.w == (x - sx) << 3) {
+					r.h += 8;
+					continue;
+				}
+			}
+			rect& r = rects_[nrect_];
+			r.x = sx << 3;
+			r.y = y;
+			r.w = (x - sx) << 3;
+			r.h = 8;
+			open_[sx] = nrect_++;
+		}
+		ts += bw;
+	}
+}
+
 int BlockRenderer::command(int argc, const char*const* argv)
 {
-	if (argc == 3) {
+	if (argc == 2) {
+		if (strcmp(argv[1], "stats") == 0) {
+			Tcl::instance().resultf(
+				"converted %.0f displayed %.0f skipped %.0f",
+				converted_, displayed_, skipped_);
+			return (TCL_OK);
+		}
+	} else if (argc == 3) {
 		if (strcmp(argv[1], "irthresh") == 0) {
 			irthresh_ = atoi(argv[2]);
 			return (TCL_OK);
@@ -108,34 +193,100 @@ int BlockRenderer::command(int argc, const char*const* argv)
 	return (Renderer::command(argc, argv));
 }
 
-int BlockRenderer::consume(const VideoFrame* vf)
+/*
+ * Return the part of the frame, in source pixels, that ends up on
+ * the display.  By default that is all of it.
+ */
+int BlockRenderer::visible(int& x0, int& y0, int& x1, int& y1) const
 {
-	if (!samesize(vf))
-		resize(vf->width_, vf->height_);
-	YuvFrame* p = (YuvFrame*)vf;
+	x0 = 0;
+	y0 = 0;
+	x1 = width_;
+	y1 = height_;
+	return (1);
+}
 
-	if (update_interval_ != 0) {
-		if (need_update_ == 0)
-			return (0);
-		need_update_ = 0;
+/*
+ * Color convert the rectangle [x0,x1) x [y0,y1) of the frame
+ * and, if immed is set, send it to the display straight away.
+ * Returns the number of pixels converted.
+ */
+int BlockRenderer::render_rect(const u_char* frm, int x0, int y0,
+			       int x1, int y1, int immed)
+{
+	int w = x1 - x0;
+	int h = y1 - y0;
+	render(frm, y0 * width_ + x0, x0, w, h);
+	if (immed) {
+		push(frm, y0, y1, x0, x1);
+		displayed_ += w * h;
 	}
+	converted_ += w * h;
+	return (w * h);
+}
 
-#ifdef HAVE_SWSCALE
-	render(vf->bp_, 0, 0, 0, 0);
-	
-	// put the image to display
-	// in WindowRenderer::push
-	push(NULL, 0, 0, 0, 0);
-	sync();
-#else
-	
-	
+void BlockRenderer::push_rows(const u_char* frm, int ymin, int ymax,
+			      int immed)
+{
+	if (ymin < ymax) {
+		if (!immed) {
+			push(frm, ymin, ymax, 0, 0);
+			displayed_ += double(ymax - ymin) * (vx1_ - vx0_);
+		}
+		sync();
+	}
+}
+
+/*
+ * Render the blocks listed in the decoder's render plan, clipped
+ * to the visible part of the frame.
+ */
+void BlockRenderer::render_plan(const YuvFrame* p)
+{
+	const RenderPlan& rp = *p->plan_;
+	int immed = rp.nblk() < irthresh_;
+
+#ifdef WIN32
+	immed = 0;
+#endif
+
+	int ymin = height_;
+	int ymax = 0;
+	int changed = 0;
+	int conv = 0;
+	for (int n = 0; n < rp.nrect(); ++n) {
+		const RenderPlan::rect& r = rp.rects(n);
+		changed += r.w * r.h;
+		int x0 = r.x > vx0_ ? r.x : vx0_;
+		int x1 = r.x + r.w < vx1_ ? r.x + r.w : vx1_;
+		int y0 = r.y > vy0_ ? r.y : vy0_;
+		int y1 = r.y + r.h < vy1_ ? r.y + r.h : vy1_;
+		if (x0 >= x1 || y0 >= y1)
+			continue;
+		if (y0 < ymin)
+			ymin = y0;
+		if (y1 > ymax)
+			ymax = y1;
+		conv += render_rect(p->bp_, x0, y0, x1, y1, immed);
+	}
+	skipped_ += changed - conv;
+	push_rows(p->bp_, ymin, ymax, immed);
+}
+
+/*
+ * Scan the rendering vector for blocks that changed since frame
+ * `base', the one the image shows.  Used when there is no plan for
+ * the frame, or the plan was built relative to a frame the image
+ * didn't show.
+ */
+void BlockRenderer::render_scan(const YuvFrame* p, u_int base)
+{
 	/*
 	 * check how many blocks we need to update.  If more than
 	 * 12%, do a single image push call for them.  Otherwise,
 	 * only push the ones that change.
 	 */	
-	u_int now = now_;
+	u_int now = base;
 	const u_int8_t* ts = p->crvec_;
 	u_int bcnt = 0;
 	int w = width_ >> 3;
@@ -154,9 +305,10 @@ int BlockRenderer::consume(const VideoFrame* vf)
 
 	int ymin = height_;
 	int ymax = 0;
-	ts = p->crvec_;
-	for (y = 0; y < height_; y += 8) {
-		for (int x = 0; x < width_; ) {
+	int conv = 0;
+	ts = p->crvec_ + (vy0_ >> 3) * w;
+	for (y = vy0_; y < vy1_; y += 8) {
+		for (int x = vx0_; x < vx1_; ) {
 			if (RV_PAST(now, ts[x >> 3])) {
 				x += 8;
 				continue;
@@ -164,27 +316,78 @@ int BlockRenderer::consume(const VideoFrame* vf)
 			int sx = x;
 			do {
 				x += 8;
-			} while (x < width_ && !RV_PAST(now, ts[x >> 3]));
+			} while (x < vx1_ && !RV_PAST(now, ts[x >> 3]));
 
 			if (y < ymin)
 				ymin = y;
-			if (y > ymax)
-				ymax = y;
-			// XXX
-			int off = y * width_ + sx;
-			render(p->bp_, off, sx, x - sx, 8);
-			if (immed)
-				push(p->bp_, y, y + 8, sx, x);
+			if (y + 8 > ymax)
+				ymax = y + 8;
+			conv += render_rect(p->bp_, sx, y, x, y + 8, immed);
 		}
-		ts += width_ >> 3;
+		ts += w;
 	}
+	skipped_ += (bcnt << 6) - conv;
+	push_rows(p->bp_, ymin, ymax, immed);
+}
+
+int BlockRenderer::consume(const VideoFrame* vf)
+{
+	if (!samesize(vf))
+		resize(vf->width_, vf->height_);
+	YuvFrame* p = (YuvFrame*)vf;
+
+	if (update_interval_ != 0) {
+		if (need_update_ == 0)
+			return (0);
+		need_update_ = 0;
+	}
+
+	u_int base;
+#ifdef HAVE_SWSCALE
+	if (begin(p->ts_, base) < 0)
+		return (0);
+	render(vf->bp_, 0, 0, 0, 0);
+	
+	// put the image to display
+	// in WindowRenderer::push
+	push(NULL, 0, 0, 0, 0);
+	sync();
+	end(p->ts_);
+#else
+	int x0, y0, x1, y1;
+	if (!visible(x0, y0, x1, y1))
+		x0 = y0 = x1 = y1 = 0;
+
+	int redo = 0;
+	if (x0 != vx0_ || y0 != vy0_ || x1 != vx1_ || y1 != vy1_) {
+		/*
+		 * A different part of the frame shows through the
+		 * window than last time (it was mapped, resized or
+		 * panned), so blocks we skipped as hidden may now be
+		 * exposed.  Redo everything that is visible.
+		 */
+		vx0_ = x0;
+		vy0_ = y0;
+		vx1_ = x1;
+		vy1_ = y1;
+		invalidate();
+		redo = 1;
+	}
+	int r = begin(p->ts_, base);
+	if (r < 0)
+		return (0);
+	if (redo || r == 0) {
+		if (vx0_ < vx1_ && vy0_ < vy1_) {
+			render_rect(p->bp_, vx0_, vy0_, vx1_, vy1_, 0);
+			push_rows(p->bp_, vy0_, vy1_, 0);
+		}
+	} else if (p->plan_ != 0 && p->plan_->base() == base)
+		render_plan(p);
+	else
+		render_scan(p, base);
 	// XXX
 	now_ = p->ts_;
-	if (ymin <= ymax) {
-		if (!immed)
-			push(p->bp_, ymin, ymax + 8, 0, 0);
-		sync();
-	}
+	end(now_);
 #endif
 
 	return (0);
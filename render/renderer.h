@@ -35,6 +35,41 @@
 #include "timer.h"
 #include "module.h"
 
+/*
+ * A render plan is the set of 8x8 blocks that a decoder updated
+ * since the frame stamped `base'.  It is computed once per frame by
+ * the decoder and handed to every attached renderer, so that N windows
+ * showing the same source don't each rescan the rendering vector.
+ * Horizontal runs of changed blocks are coalesced into rectangles,
+ * and runs in consecutive block rows that line up are merged
+ * vertically.  All coordinates are in pixels of the decoded image.
+ */
+class RenderPlan {
+    public:
+	RenderPlan();
+	~RenderPlan();
+	struct rect {
+		int x;
+		int y;
+		int w;
+		int h;
+	};
+	void resize(int w, int h);
+	void build(const u_int8_t* crvec, u_int base);
+	inline u_int base() const { return (base_); }
+	inline int nrect() const { return (nrect_); }
+	inline const rect& rects(int n) const { return (rects_[n]); }
+	inline u_int nblk() const { return (nblk_); }
+    protected:
+	int width_;
+	int height_;
+	u_int base_;		/* renderer timestamp this plan is valid for */
+	u_int nblk_;		/* number of changed blocks */
+	int nrect_;
+	rect* rects_;
+	int* open_;		/* per block column: last rect begun there */
+};
+
 /*
  * Base class for objects that render video onto an output device.
  * Output devices may be X windows, external video ports, etc.
@@ -46,10 +81,23 @@ class Renderer : public Module, public Timer {
 	Renderer(int ft);
 	virtual int command(int argc, const char*const* argv);
 	virtual void setcolor(int) {}
+	/*
+	 * Draw the next frame over whole, in every image it may go
+	 * into (a different part of the frame is on show, the
+	 * decoder is redrawing, or the colors changed).
+	 */
+	virtual void invalidate() {}
 	inline void now(u_int v) { now_ = v; }
+	inline u_int now() const { return (now_); }
 
 	inline int update_interval() const { return (update_interval_); }
 	inline int need_update() const { return (need_update_); }
+	/*
+	 * How many times (log2) a w by h frame can be halved without
+	 * going below what this renderer shows of it; the decoder
+	 * decodes that much smaller (Decoder::reduction()).
+	 */
+	virtual int reduction(int, int) const { return (0); }
 
 	Renderer* next_;	/* linked list for decoders */
     protected:
@@ -66,13 +114,37 @@ class BlockRenderer : public Renderer {
 	virtual void sync() const = 0;
 	virtual int command(int argc, const char*const* argv);
     protected:
-	inline BlockRenderer(int ft) : Renderer(ft), irthresh_(150) {}
+	inline BlockRenderer(int ft) : Renderer(ft),
+		vx0_(0), vy0_(0), vx1_(0), vy1_(0),
+		converted_(0.), displayed_(0.), skipped_(0.),
+		irthresh_(150) {}
 	virtual int consume(const VideoFrame*);
 	virtual void resize(int w, int h) = 0;
 	virtual void render(const u_char* frm, int off, int x,
 			    int w, int h) = 0;
 	virtual void push(const u_char* frm, int miny, int maxy,
 			  int minx, int maxx) const = 0;
+	virtual int visible(int& x0, int& y0, int& x1, int& y1) const;
+	/*
+	 * Pick the image frame ts goes into.  Returns -1 to drop the
+	 * frame, 0 if the image has to be drawn over whole, or 1 with
+	 * `base' set to the frame it shows.  By default there is the
+	 * one image, showing the last frame.
+	 */
+	virtual int begin(u_int, u_int& base) { base = now_; return (1); }
+	/* the image now shows frame ts */
+	virtual void end(u_int) {}
+	int render_rect(const u_char* frm, int x0, int y0, int x1, int y1,
+			int immed);
+	void render_plan(const YuvFrame* p);
+	void render_scan(const YuvFrame* p, u_int base);
+	void push_rows(const u_char* frm, int ymin, int ymax, int immed);
+
+	/* part of the frame that showed in the window at last render */
+	int vx0_, vy0_, vx1_, vy1_;
+	double converted_;	/* source pixels color converted */
+	double displayed_;	/* source pixels pushed to the display */
+	double skipped_;	/* changed pixels not converted (hidden) */
 	u_int irthresh_;	/* 'immediate render' threshhold --
 				 * if less than this number of blocks
 				 * are marked to be rendered, only the
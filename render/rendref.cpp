@@ -0,0 +1,2440 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * The 16, 24 and 32 bit direct color kernels from color-hi.cpp and
+ * color-true.cpp as they were before yuv-map.h replaced them, for
+ * rendbench to compare against.  They are copied as they were, with
+ * the color model and WindowRenderer state they used turned into
+ * members, and with the bugs YuvMap fixed also fixed here (the 4:2:0
+ * path at 1:8 and below, and the 32 bit 2:1 paths not masking the
+ * doubled row), so any difference in output is a bug.
+ */
+
+#include <string.h>
+#include "config.h"
+#include "bsd-endian.h"
+#include "rendref.h"
+
+class RefTrue24 : public RefRenderer {
+    public:
+	RefTrue24(const YuvTarget& t, const u_int* uvtab, u_int omask,
+		  u_int pmask)
+		: RefRenderer(t), uvtab_(uvtab), omask_(omask),
+		  pmask_(pmask) {}
+	virtual void render(int index, const u_char* frm, u_int off,
+			    u_int x, u_int width, u_int height) const;
+    protected:
+	typedef void (RefTrue24::*Method)(const u_char*, u_int, u_int, u_int,
+				       u_int) const;
+	static const Method methods_[];
+	const u_int* uvtab_;
+	u_int omask_;
+	u_int pmask_;
+	void map_422(const u_char* frm, u_int off, u_int x,
+		     u_int width, u_int height) const;
+	void map_down2_422(const u_char* frm, u_int off, u_int x,
+			   u_int width, u_int height) const;
+	void map_down4_422(const u_char* frm, u_int off, u_int x,
+			   u_int width, u_int height) const;
+	void map_down_422(const u_char* frm, u_int off, u_int x,
+			  u_int width, u_int height) const;
+	void map_up2_422(const u_char* frm, u_int off, u_int x,
+			 u_int width, u_int height) const;
+	void map_420(const u_char* frm, u_int off, u_int x,
+		     u_int width, u_int height) const;
+	void map_down2_420(const u_char* frm, u_int off, u_int x,
+			   u_int width, u_int height) const;
+	void map_down4_420(const u_char* frm, u_int off, u_int x,
+			   u_int width, u_int height) const;
+	void map_down_420(const u_char* frm, u_int off, u_int x,
+			  u_int width, u_int height) const;
+	void map_up2_420(const u_char* frm, u_int off, u_int x,
+			 u_int width, u_int height) const;
+	void map_gray(const u_char* frm, u_int off, u_int x,
+		      u_int width, u_int height) const;
+	void map_gray_down2(const u_char* frm, u_int off, u_int x,
+			    u_int width, u_int height) const;
+	void map_gray_down4(const u_char* frm, u_int off, u_int x,
+			    u_int width, u_int height) const;
+	void map_gray_down(const u_char* frm, u_int off, u_int x,
+			   u_int width, u_int height) const;
+	void map_gray_up2(const u_char* frm, u_int off, u_int x,
+			  u_int width, u_int height) const;
+};
+
+class RefTrue32 : public RefRenderer {
+    public:
+	RefTrue32(const YuvTarget& t, const u_int* uvtab, u_int omask,
+		  u_int pmask)
+		: RefRenderer(t), uvtab_(uvtab), omask_(omask),
+		  pmask_(pmask) {}
+	virtual void render(int index, const u_char* frm, u_int off,
+			    u_int x, u_int width, u_int height) const;
+    protected:
+	typedef void (RefTrue32::*Method)(const u_char*, u_int, u_int, u_int,
+				       u_int) const;
+	static const Method methods_[];
+	const u_int* uvtab_;
+	u_int omask_;
+	u_int pmask_;
+	void map_422(const u_char* frm, u_int off, u_int x,
+		     u_int width, u_int height) const;
+	void map_down2_422(const u_char* frm, u_int off, u_int x,
+			   u_int width, u_int height) const;
+	void map_down4_422(const u_char* frm, u_int off, u_int x,
+			   u_int width, u_int height) const;
+	void map_down_422(const u_char* frm, u_int off, u_int x,
+			  u_int width, u_int height) const;
+	void map_up2_422(const u_char* frm, u_int off, u_int x,
+			 u_int width, u_int height) const;
+	void map_420(const u_char* frm, u_int off, u_int x,
+		     u_int width, u_int height) const;
+	void map_down2_420(const u_char* frm, u_int off, u_int x,
+			   u_int width, u_int height) const;
+	void map_down4_420(const u_char* frm, u_int off, u_int x,
+			   u_int width, u_int height) const;
+	void map_down_420(const u_char* frm, u_int off, u_int x,
+			  u_int width, u_int height) const;
+	void map_up2_420(const u_char* frm, u_int off, u_int x,
+			 u_int width, u_int height) const;
+	void map_gray(const u_char* frm, u_int off, u_int x,
+		      u_int width, u_int height) const;
+	void map_gray_down2(const u_char* frm, u_int off, u_int x,
+			    u_int width, u_int height) const;
+	void map_gray_down4(const u_char* frm, u_int off, u_int x,
+			    u_int width, u_int height) const;
+	void map_gray_down(const u_char* frm, u_int off, u_int x,
+			   u_int width, u_int height) const;
+	void map_gray_up2(const u_char* frm, u_int off, u_int x,
+			  u_int width, u_int height) const;
+};
+
+class RefHi : public RefRenderer {
+    public:
+	RefHi(const YuvTarget& t, const u_short* uvtab)
+		: RefRenderer(t), uvtab_(uvtab) {}
+	virtual void render(int index, const u_char* frm, u_int off,
+			    u_int x, u_int width, u_int height) const;
+    protected:
+	typedef void (RefHi::*Method)(const u_char*, u_int, u_int, u_int,
+				       u_int) const;
+	static const Method methods_[];
+	const u_short* uvtab_;
+	void map_422(const u_char* frm, u_int off, u_int x,
+		     u_int width, u_int height) const;
+	void map_down2_422(const u_char* frm, u_int off, u_int x,
+			   u_int width, u_int height) const;
+	void map_down4_422(const u_char* frm, u_int off, u_int x,
+			   u_int width, u_int height) const;
+	void map_down_422(const u_char* frm, u_int off, u_int x,
+			  u_int width, u_int height) const;
+	void map_up2_422(const u_char* frm, u_int off, u_int x,
+			 u_int width, u_int height) const;
+	void map_420(const u_char* frm, u_int off, u_int x,
+		     u_int width, u_int height) const;
+	void map_down2_420(const u_char* frm, u_int off, u_int x,
+			   u_int width, u_int height) const;
+	void map_down4_420(const u_char* frm, u_int off, u_int x,
+			   u_int width, u_int height) const;
+	void map_down_420(const u_char* frm, u_int off, u_int x,
+			  u_int width, u_int height) const;
+	void map_up2_420(const u_char* frm, u_int off, u_int x,
+			 u_int width, u_int height) const;
+	void map_gray(const u_char* frm, u_int off, u_int x,
+		      u_int width, u_int height) const;
+	void map_gray_down2(const u_char* frm, u_int off, u_int x,
+			    u_int width, u_int height) const;
+	void map_gray_down4(const u_char* frm, u_int off, u_int x,
+			    u_int width, u_int height) const;
+	void map_gray_down(const u_char* frm, u_int off, u_int x,
+			   u_int width, u_int height) const;
+	void map_gray_up2(const u_char* frm, u_int off, u_int x,
+			  u_int width, u_int height) const;
+};
+
+const RefTrue24::Method RefTrue24::methods_[] = {
+	&RefTrue24::map_up2_420,
+	&RefTrue24::map_up2_422,
+	&RefTrue24::map_gray_up2,
+	&RefTrue24::map_gray_up2,
+	&RefTrue24::map_420,
+	&RefTrue24::map_422,
+	&RefTrue24::map_gray,
+	&RefTrue24::map_gray,
+	&RefTrue24::map_down2_420,
+	&RefTrue24::map_down2_422,
+	&RefTrue24::map_gray_down2,
+	&RefTrue24::map_gray_down2,
+	&RefTrue24::map_down4_420,
+	&RefTrue24::map_down4_422,
+	&RefTrue24::map_gray_down4,
+	&RefTrue24::map_gray_down4,
+	&RefTrue24::map_down_420,
+	&RefTrue24::map_down_422,
+	&RefTrue24::map_gray_down,
+	&RefTrue24::map_gray_down,
+};
+
+void RefTrue24::render(int index, const u_char* frm, u_int off, u_int x,
+		   u_int width, u_int height) const
+{
+	(this->*methods_[index])(frm, off, x, width, height);
+}
+
+const RefTrue32::Method RefTrue32::methods_[] = {
+	&RefTrue32::map_up2_420,
+	&RefTrue32::map_up2_422,
+	&RefTrue32::map_gray_up2,
+	&RefTrue32::map_gray_up2,
+	&RefTrue32::map_420,
+	&RefTrue32::map_422,
+	&RefTrue32::map_gray,
+	&RefTrue32::map_gray,
+	&RefTrue32::map_down2_420,
+	&RefTrue32::map_down2_422,
+	&RefTrue32::map_gray_down2,
+	&RefTrue32::map_gray_down2,
+	&RefTrue32::map_down4_420,
+	&RefTrue32::map_down4_422,
+	&RefTrue32::map_gray_down4,
+	&RefTrue32::map_gray_down4,
+	&RefTrue32::map_down_420,
+	&RefTrue32::map_down_422,
+	&RefTrue32::map_gray_down,
+	&RefTrue32::map_gray_down,
+};
+
+void RefTrue32::render(int index, const u_char* frm, u_int off, u_int x,
+		   u_int width, u_int height) const
+{
+	(this->*methods_[index])(frm, off, x, width, height);
+}
+
+const RefHi::Method RefHi::methods_[] = {
+	&RefHi::map_up2_420,
+	&RefHi::map_up2_422,
+	&RefHi::map_gray_up2,
+	&RefHi::map_gray_up2,
+	&RefHi::map_420,
+	&RefHi::map_422,
+	&RefHi::map_gray,
+	&RefHi::map_gray,
+	&RefHi::map_down2_420,
+	&RefHi::map_down2_422,
+	&RefHi::map_gray_down2,
+	&RefHi::map_gray_down2,
+	&RefHi::map_down4_420,
+	&RefHi::map_down4_422,
+	&RefHi::map_gray_down4,
+	&RefHi::map_gray_down4,
+	&RefHi::map_down_420,
+	&RefHi::map_down_422,
+	&RefHi::map_gray_down,
+	&RefHi::map_gray_down,
+};
+
+void RefHi::render(int index, const u_char* frm, u_int off, u_int x,
+		u_int width, u_int height) const
+{
+	(this->*methods_[index])(frm, off, x, width, height);
+}
+
+RefRenderer* RefRenderer::alloc(int bpp, const YuvTarget& t,
+				 const void* uvtab, u_int omask, u_int pmask)
+{
+	switch (bpp) {
+	case 16:
+		return (new RefHi(t, (const u_short*)uvtab));
+	case 24:
+		return (new RefTrue24(t, (const u_int*)uvtab, omask, pmask));
+	case 32:
+		return (new RefTrue32(t, (const u_int*)uvtab, omask, pmask));
+	}
+	return (0);
+}
+
+#if BYTE_ORDER == LITTLE_ENDIAN
+#define SHIFT_0		24
+#define SHIFT_8		16
+#define SHIFT_16	8
+#define SHIFT_24	0
+#define UV0 ((v << 5) & 0x3ff00)
+#define UV1 ((u << 2) & 0x3ff00)
+#define UV2 ((v >> 11) & 0x3ff00)
+#define UV3 ((u >> 14) & 0x3ff00)
+#else
+#define SHIFT_0		0
+#define SHIFT_8		8
+#define SHIFT_16	16
+#define SHIFT_24	24
+#define UV0 ((u >> 12) & 0xfff00)
+#define UV1 ((v >> 10) & 0xfff00)
+#define UV2 ((u << 4) & 0xfff00)
+#define UV3 ((v << 6) & 0xfff00)
+#endif
+
+/*
+ * This routine sums the luma & chroma components of one pixel &
+ * constructs an rgb output.  It does all three r g b components
+ * in parallel.  The one complication is that it has to
+ * deal with overflow (sum > 255) and underflow (sum < 0).  Underflow
+ * & overflow are only possible if both terms have the same sign and
+ * are indicated by the result having a different sign than the terms.
+ * Note that we ignore the carry into the next byte's lsb that happens
+ * on an overflow/underflow on the grounds that it's probably invisible.
+ * The luma term and sum are biased by 128 so a negative number has the
+ * 2^7 bit = 0.  The chroma term is not biased so a negative number has
+ * the 2^7 bit = 1.  So underflow is indicated by (L & C & sum) != 0;
+ */
+
+#define ONERGB(dst, rgb) \
+	dst = rgb;
+
+#define ONEGRAY(dst, pix) \
+	(dst) =  (pix << 16) | (pix << 8) | pix;
+
+#define ONEPIX(src, dst) { \
+	l = src; \
+	l |= l << 8; l |= l << 16; \
+	sum = l + uv; \
+	uflo = (l ^ uv) & (l ^ sum) & omask; \
+	if (uflo) { \
+		if ((l = uflo & l) != 0) { \
+			/* saturate overflow(s) */ \
+			l |= l >> 1; \
+			l |= l >> 2; \
+			l |= l >> 4; \
+			sum |= l; \
+			uflo &=~ l; \
+		} \
+		if (uflo != 0) { \
+			/* zero underflow(s) */ \
+			uflo |= uflo >> 1; \
+			uflo |= uflo >> 2; \
+			uflo |= uflo >> 4; \
+			sum &=~ uflo; \
+		} \
+	} \
+	ONERGB(dst, sum & pmask); \
+}
+
+void RefTrue32::map_422(const u_char* frm, u_int off,
+				 u_int /* x */, u_int width, u_int height) const
+{
+
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + (off >> 1);
+	const u_char* vp = up + (framesize_ >> 1);
+	u_int* xip = (u_int*)pixbuf_ + off;
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height; len > 0; len -= 8) {
+		u_int l, uv;
+		u_int uflo, sum;
+
+#define TWO422(n) \
+		uv = yuv2rgb[(up[(n)/2] << 8) | vp[(n)/2]]; \
+		ONEPIX(yp[(n)], xip[(n)]) \
+		ONEPIX(yp[(n)+1], xip[(n)+1])
+
+		TWO422(0)
+		TWO422(2)
+		TWO422(4)
+		TWO422(6)
+
+		xip += 8;
+		yp += 8;
+		up += 4;
+		vp += 4;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = iw - w;
+			int cstride = pstride >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += pstride;
+		}
+	}
+}
+
+void RefTrue32::map_down2_422(const u_char* frm,
+				       u_int off, u_int x,
+				       u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + (off >> 1);
+	const u_char* vp = up + (framesize_ >> 1);
+	u_int* xip = (u_int*)pixbuf_ + ((off - x) >> 2) + (x >> 1);
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height >> 1; len > 0; len -= 8) {
+		u_int l, uv;
+		u_int uflo, sum;
+
+#define ONE422(n) \
+		uv = yuv2rgb[(up[(n)/2] << 8) | vp[(n)/2]]; \
+		ONEPIX(yp[(n)], xip[(n)/2])
+
+		ONE422(0)
+		ONE422(2)
+		ONE422(4)
+		ONE422(6)
+
+		xip += 4;
+		yp += 8;
+		up += 4;
+		vp += 4;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 2 * iw - w;
+			int cstride = pstride >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += (iw - w) >> 1;
+		}
+	}
+}
+
+void RefTrue32::map_down4_422(const u_char* frm,
+				       u_int off, u_int x,
+				       u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + (off >> 1);
+	const u_char* vp = up + (framesize_ >> 1);
+	u_int* xip = (u_int*)pixbuf_ + ((off - x) >> 4) + (x >> 2);
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height >> 2; len > 0; len -= 8) {
+		u_int l, uv;
+		u_int uflo, sum;
+
+		uv = yuv2rgb[(up[0] << 8) | vp[0]];
+		ONEPIX(yp[0], xip[0])
+		uv = yuv2rgb[(up[2] << 8) | vp[2]];
+		ONEPIX(yp[4], xip[1])
+
+		xip += 2;
+		yp += 8;
+		up += 4;
+		vp += 4;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 4 * iw - w;
+			int cstride = pstride >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += (iw - w) >> 2;
+		}
+	}
+}
+
+/*
+ * decimate by some power of 2 >= 2^3.
+ */
+void RefTrue32::map_down_422(const u_char* frm,
+				      u_int off, u_int x,
+				      u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + (off >> 1);
+	const u_char* vp = up + (framesize_ >> 1);
+	int s = scale_;
+	int istride = 1 << s;
+	u_int* xip = (u_int*)pixbuf_ +
+		((off - x) >> (s + s)) + (x >> s);
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height >> s; len > 0; len -= istride) {
+		u_int l, uv;
+		u_int uflo, sum;
+
+		uv = yuv2rgb[(up[0] << 8) | vp[0]];
+		ONEPIX(yp[0], xip[0])
+
+		xip += 1;
+		yp += istride;
+		up += istride >> 1;
+		vp += istride >> 1;
+
+		w -= istride;
+		if (w <= 0) {
+			w = width;
+			int pstride = (iw << s) - w;
+			int cstride = pstride >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += (iw - w) >> s;
+		}
+	}
+}
+
+void RefTrue32::map_up2_422(const u_char* frm,
+				     u_int off, u_int x,
+				     u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + (off >> 1);
+	const u_char* vp = up + (framesize_ >> 1);
+	u_int* xip = (u_int*)pixbuf_ + ((off - x) << 2) + (x << 1);
+	int w = width;
+	u_int e1 = yp[0];
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height; len > 0; len -= 2) {
+		u_int l, uv;
+		u_int uflo, sum;
+		u_int e2;
+		u_int* xip2 = xip + (iw << 1);
+
+		uv = yuv2rgb[(up[0] << 8) | vp[0]];
+		e2 = yp[0];
+		ONEPIX((e1 + e2) >> 1, xip[0])
+		ONERGB(xip2[0], sum & pmask);
+		ONEPIX(e2, xip[1])
+		ONERGB(xip2[1], sum & pmask);
+		e1 = yp[1];
+		ONEPIX((e1 + e2) >> 1, xip[2])
+		ONERGB(xip2[2], sum & pmask);
+		ONEPIX(e1, xip[3])
+		ONERGB(xip2[3], sum & pmask);
+
+		xip += 4;
+		yp += 2;
+		up += 1;
+		vp += 1;
+
+		w -= 2;
+		if (w <= 0) {
+			w = width;
+			u_int pstride = iw - w;
+			u_int cstride = pstride >> 1;
+			yp += pstride;
+			e1 = yp[0];
+			up += cstride;
+			vp += cstride;
+			xip += (iw + pstride) << 1;
+		}
+	}
+}
+
+void RefTrue32::map_420(const u_char* frm, u_int off,
+				 u_int x, u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + ((off - x) >> 2) + (x >> 1);
+	const u_char* vp = up + (framesize_ >> 2);
+	u_int* xip = (u_int*)pixbuf_ + off;
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height; len > 0; len -= 8) {
+		u_int l, uv;
+		u_int uflo, sum;
+		u_int* xip2 = xip + iw;
+		const u_char* yp2 = yp + iw;
+
+#define FOUR420(n) \
+		uv = yuv2rgb[(up[(n)/2] << 8) | vp[(n)/2]]; \
+		ONEPIX(yp[(n)], xip[(n)]) \
+		ONEPIX(yp[(n)+1], xip[(n)+1]) \
+		ONEPIX(yp2[(n)], xip2[(n)]) \
+		ONEPIX(yp2[(n)+1], xip2[(n)+1])
+
+		FOUR420(0)
+		FOUR420(2)
+
+		xip += 4;
+		yp += 4;
+		up += 2;
+		vp += 2;
+
+		w -= 4;
+		if (w <= 0) {
+			w = width;
+			int pstride = 2 * iw - w;
+			int cstride = (iw - w) >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += pstride;
+		}
+	}
+}
+
+void RefTrue32::map_down2_420(const u_char* frm,
+				       u_int off, u_int x,
+				       u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	off = ((off - x) >> 2) + (x >> 1);
+	const u_char* up = frm + framesize_ + off;
+	const u_char* vp = up + (framesize_ >> 2);
+	u_int* xip = (u_int*)pixbuf_ + off;
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height >> 1; len > 0; len -= 8) {
+		u_int l, uv;
+		u_int uflo, sum;
+
+#define ONE420(n) \
+		uv = yuv2rgb[(up[(n)/2] << 8) | vp[(n)/2]]; \
+		ONEPIX(yp[(n)], xip[(n)/2])
+
+		ONE420(0)
+		ONE420(2)
+		ONE420(4)
+		ONE420(6)
+
+		xip += 4;
+		yp += 8;
+		up += 4;
+		vp += 4;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 2 * iw - w;
+			int cstride = (iw - w) >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += cstride;
+		}
+	}
+}
+
+void RefTrue32::map_down4_420(const u_char* frm,
+				       u_int off, u_int x,
+				       u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + ((off - x) >> 2) + (x >> 1);
+	const u_char* vp = up + (framesize_ >> 2);
+	u_int* xip = (u_int*)pixbuf_ + ((off - x) >> 4) + (x >> 2);
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height >> 2; len > 0; len -= 8) {
+		u_int l, uv;
+		u_int uflo, sum;
+
+		uv = yuv2rgb[(up[0] << 8) | vp[0]];
+		ONEPIX(yp[0], xip[0])
+		uv = yuv2rgb[(up[2] << 8) | vp[2]];
+		ONEPIX(yp[4], xip[1])
+
+		xip += 2;
+		yp += 8;
+		up += 4;
+		vp += 4;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 4 * iw - w;
+			int cstride = iw - (w >> 1);
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += (iw - w) >> 2;
+		}
+	}
+}
+
+/*
+ * decimate by some power of 2 >= 2^3.
+ */
+void RefTrue32::map_down_420(const u_char* frm,
+				      u_int off, u_int x,
+				      u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + ((off - x) >> 2) + (x >> 1);
+	const u_char* vp = up + (framesize_ >> 2);
+	int s = scale_;
+	int istride = 1 << s;
+	u_int* xip = (u_int*)pixbuf_
+		+ ((off - x) >> (s + s)) + (x >> s);
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height >> s; len > 0; len -= istride) {
+		u_int l, uv;
+		u_int uflo, sum;
+
+		uv = yuv2rgb[(up[0] << 8) | vp[0]];
+		ONEPIX(yp[0], xip[0])
+
+		xip += 1;
+		yp += istride;
+		up += istride >> 1;
+		vp += istride >> 1;
+
+		w -= istride;
+		if (w <= 0) {
+			w = width;
+			int pstride = (iw << s) - w;
+			int cstride = (iw << (s - 2)) - (w >> 1);
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += (iw - w) >> s;
+		}
+	}
+}
+
+void RefTrue32::map_up2_420(const u_char* frm,
+				     u_int off, u_int x,
+				     u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + ((off - x) >> 2) + (x >> 1);
+	const u_char* vp = up + (framesize_ >> 2);
+	u_int* xip = (u_int*)pixbuf_ + ((off - x) << 2) + (x << 1);
+	int w = width;
+	u_int e1 = yp[0], o1 = yp[iw];
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height; len > 0; len -= 4) {
+		u_int l, uv;
+		u_int uflo, sum;
+		u_int e2, o2;
+		const u_char* yp2 = yp + iw;
+		u_int* xip2 = xip + (iw << 1);
+		u_int* xip3 = xip2 + (iw << 1);
+		u_int* xip4 = xip3 + (iw << 1);
+
+		uv = yuv2rgb[(up[0] << 8) | vp[0]];
+		e2 = yp[0];
+		ONEPIX((e1 + e2) >> 1, xip[0])
+		ONERGB(xip2[0], sum & pmask);
+		ONEPIX(e2, xip[1])
+		ONERGB(xip2[1], sum & pmask);
+		e1 = yp[1];
+		ONEPIX((e1 + e2) >> 1, xip[2])
+		ONERGB(xip2[2], sum & pmask);
+		ONEPIX(e1, xip[3])
+		ONERGB(xip2[3], sum & pmask);
+
+		o2 = yp2[0];
+		ONEPIX((o1 + o2) >> 1, xip3[0])
+		ONERGB(xip4[0], sum & pmask);
+		ONEPIX(o2, xip3[1])
+		ONERGB(xip4[1], sum & pmask);
+		o1 = yp2[1];
+		ONEPIX((o1 + o2) >> 1, xip3[2])
+		ONERGB(xip4[2], sum & pmask);
+		ONEPIX(o1, xip3[3])
+		ONERGB(xip4[3], sum & pmask);
+
+		xip += 4;
+		yp += 2;
+		up += 1;
+		vp += 1;
+
+		w -= 2;
+		if (w <= 0) {
+			w = width;
+			u_int pstride = 2 * iw - w;
+			u_int cstride = (iw - w) >> 1;
+			yp += pstride;
+			e1 = yp[0];
+			o1 = yp[iw];
+			up += cstride;
+			vp += cstride;
+			xip += 8 * iw - 2 * w;
+		}
+	}
+}
+
+void RefTrue32::map_gray(const u_char *yp,
+				  u_int off, u_int /* x */,
+				  u_int width, u_int height) const
+{
+
+	u_int iw = width_;
+	yp += off;
+	u_int* xip = (u_int*)pixbuf_ + off;
+	int w = width;
+	for (int len = w * height; len > 0; len -= 8) {
+		u_int y1;
+		u_int pix;
+
+		y1 = *(const u_int*)yp;
+		pix = (y1 >> SHIFT_24) & 0xff;
+		ONEGRAY(xip[0], pix);
+		pix = (y1 >> SHIFT_16) & 0xff;
+		ONEGRAY(xip[1], pix);
+		pix = (y1 >> SHIFT_8) & 0xff;
+		ONEGRAY(xip[2], pix);
+		pix = (y1 >> SHIFT_0) & 0xff;
+		ONEGRAY(xip[3], pix);
+
+		y1 = *(const u_int*)(yp + 4);
+		pix = (y1 >> SHIFT_24) & 0xff;
+		ONEGRAY(xip[4], pix);
+		pix = (y1 >> SHIFT_16) & 0xff;
+		ONEGRAY(xip[5], pix);
+		pix = (y1 >> SHIFT_8) & 0xff;
+		ONEGRAY(xip[6], pix);
+		pix = (y1 >> SHIFT_0) & 0xff;
+		ONEGRAY(xip[7], pix);
+
+		xip += 8;
+		yp += 8;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			u_int pstride = iw - w;
+			yp += pstride;
+			xip += pstride;
+		}
+	}
+}
+
+void RefTrue32::map_gray_down2(const u_char *yp,
+					u_int off, u_int x,
+					u_int width, u_int height) const
+{
+	u_int iw = width_;
+	yp += off;
+	off = ((off - x) >> 2) + (x >> 1);
+	u_int* xip = (u_int*)pixbuf_ + off;
+	int w = width;
+	for (int len = w * height >> 1; len > 0; len -= 8) {
+		u_int y1;
+		u_int pix;
+
+		y1 = *(const u_int*)yp;
+		pix = (y1 >> SHIFT_24) & 0xff;
+		ONEGRAY(xip[0], pix);
+		pix = (y1 >> SHIFT_8) & 0xff;
+		ONEGRAY(xip[1], pix);
+
+		y1 = *(const u_int*)(yp + 4);
+		pix = (y1 >> SHIFT_24) & 0xff;
+		ONEGRAY(xip[2], pix);
+		pix = (y1 >> SHIFT_8) & 0xff;
+		ONEGRAY(xip[3], pix);
+
+		xip += 4;
+		yp += 8;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 2 * iw - w;
+			yp += pstride;
+			xip += (iw - w) >> 1;
+		}
+	}
+}
+
+void RefTrue32::map_gray_down4(const u_char *yp,
+					u_int off, u_int x,
+					u_int width, u_int height) const
+{
+	u_int iw = width_;
+	yp += off;
+	u_int* xip = (u_int*)pixbuf_ + ((off - x) >> 4) + (x >> 2);
+	int w = width;
+	for (int len = w * height >> 2; len > 0; len -= 8) {
+		u_int pix;
+
+		pix = yp[0];
+		ONEGRAY(xip[0], pix);
+		pix = yp[4];
+		ONEGRAY(xip[1], pix);
+
+		xip += 2;
+		yp += 8;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 4 * iw - w;
+			yp += pstride;
+			xip += (iw - w) >> 2;
+		}
+	}
+}
+
+void RefTrue32::map_gray_down(const u_char *yp,
+				       u_int off, u_int x,
+				       u_int width, u_int height) const
+{
+	u_int iw = width_;
+	yp += off;
+	int s = scale_;
+	int istride = 1 << s;
+	u_int* xip = (u_int*)pixbuf_ +
+		((off - x) >> (s + s)) + (x >> s);
+	int w = width;
+	for (int len = w * height >> s; len > 0; len -= istride) {
+		u_int pix = *yp;
+		ONEGRAY(xip[0], pix);
+		xip++;
+		yp += istride;
+		w -= istride;
+		if (w <= 0) {
+			w = width;
+			int pstride = (iw << s) - w;
+			yp += pstride;
+			xip += (iw - w) >> s;
+		}
+	}
+}
+
+void RefTrue32::map_gray_up2(const u_char *yp,
+				      u_int off, u_int x,
+				      u_int width, u_int height) const
+{
+	u_int iw = width_;
+	yp += off;
+	u_int* xip = (u_int*)pixbuf_ + ((off - x) << 2) + (x << 1);
+	int w = width;
+	u_int e1 = yp[0];
+
+	for (int len = width * height; len > 0; len -= 8) {
+		u_int y1, e2, pix;
+		u_int* xip2 = xip + iw * 2;
+
+		y1 = *(const u_int*)yp;
+		e2 = (y1 >> SHIFT_24) & 0xff;
+		pix = (e1 + e2) >> 1;
+		ONEGRAY(xip[0], pix);
+		ONEGRAY(xip2[0], pix);
+		ONEGRAY(xip[1], e2);
+		ONEGRAY(xip2[1], e2);
+		e1 = (y1 >> SHIFT_16) & 0xff;
+		pix = (e1 + e2) >> 1;
+		ONEGRAY(xip[2], pix);
+		ONEGRAY(xip2[2], pix);
+		ONEGRAY(xip[3], e1);
+		ONEGRAY(xip2[3], e1);
+
+		e2 = (y1 >> SHIFT_8) & 0xff;
+		pix = (e1 + e2) >> 1;
+		ONEGRAY(xip[4], pix);
+		ONEGRAY(xip2[4], pix);
+		ONEGRAY(xip[5], e2);
+		ONEGRAY(xip2[5], e2);
+		e1 = (y1 >> SHIFT_0) & 0xff;
+		pix = (e1 + e2) >> 1;
+		ONEGRAY(xip[6], pix);
+		ONEGRAY(xip2[6], pix);
+		ONEGRAY(xip[7], e1);
+		ONEGRAY(xip2[7], e1);
+
+		y1 = *(const u_int*)(yp + 4);
+		e2 = (y1 >> SHIFT_24) & 0xff;
+		pix = (e1 + e2) >> 1;
+		ONEGRAY(xip[8], pix);
+		ONEGRAY(xip2[8], pix);
+		ONEGRAY(xip[9], e2);
+		ONEGRAY(xip2[9], e2);
+		e1 = (y1 >> SHIFT_16) & 0xff;
+		pix = (e1 + e2) >> 1;
+		ONEGRAY(xip[10], pix);
+		ONEGRAY(xip2[10], pix);
+		ONEGRAY(xip[11], e1);
+		ONEGRAY(xip2[11], e1);
+
+		e2 = (y1 >> SHIFT_8) & 0xff;
+		pix = (e1 + e2) >> 1;
+		ONEGRAY(xip[12], pix);
+		ONEGRAY(xip2[12], pix);
+		ONEGRAY(xip[13], e2);
+		ONEGRAY(xip2[13], e2);
+		e1 = (y1 >> SHIFT_0) & 0xff;
+		pix = (e1 + e2) >> 1;
+		ONEGRAY(xip[14], pix);
+		ONEGRAY(xip2[14], pix);
+		ONEGRAY(xip[15], e1);
+		ONEGRAY(xip2[15], e1);
+
+		xip += 16;
+		yp += 8;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			u_int pstride = iw - w;
+			yp += pstride;
+			e1 = yp[0];
+			xip += (iw + pstride) << 1;
+		}
+	}
+}
+
+// Dithers for 24 bpp displays
+// XXX might be possible to replace char* by u_int* somehow
+//     or to do other optimizations
+
+#if  (BYTE_ORDER == LITTLE_ENDIAN)
+#define PONERGB(dst, rgb)						\
+    (&(dst))[0] = (rgb);						\
+    (&(dst))[1] = (rgb)>>8;						\
+    (&(dst))[2] = (rgb)>>16;
+
+#else
+#define PONERGB(dst, rgb)						\
+    (&(dst))[0] = (rgb)>>16;						\
+    (&(dst))[1] = (rgb)>>8;						\
+    (&(dst))[2] = (rgb);
+#endif
+
+#define PONEGRAY(dst, pix)						\
+    (&(dst))[0] = pix;							\
+    (&(dst))[1] = pix;							\
+    (&(dst))[2] = pix;
+
+#define PONEPIX(src,dst) {						\
+    l = src;								\
+    l |= l << 8; l |= l << 16;						\
+    sum = l + uv;							\
+    uflo = (l ^ uv) & (l ^ sum) & omask;				\
+    if (uflo) {								\
+	if ((l = uflo & l) != 0) {					\
+	    /* saturate overflow(s) */					\
+	    l |= l >> 1;						\
+	    l |= l >> 2;						\
+	    l |= l >> 4;						\
+	    sum |= l;							\
+	    uflo &=~ l;							\
+	}								\
+	if (uflo != 0) {						\
+	    /* zero underflow(s) */					\
+	    uflo |= uflo >> 1;						\
+	    uflo |= uflo >> 2;						\
+	    uflo |= uflo >> 4;						\
+	    sum &=~ uflo;						\
+	}								\
+    }									\
+    PONERGB(dst, sum & pmask);						\
+}
+
+void RefTrue24::map_422(const u_char* frm, u_int off,
+				 u_int /* x */, u_int width, u_int height) const
+{
+
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + (off >> 1);
+	const u_char* vp = up + (framesize_ >> 1);
+	char* xip = (char*)pixbuf_ + 3*off;
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height; len > 0; len -= 8) {
+		u_int l, uv;
+		u_int uflo, sum;
+
+#define PTWO422(n) \
+		uv = yuv2rgb[(up[(n)/2] << 8) | vp[(n)/2]]; \
+		PONEPIX(yp[(n)], xip[3*(n)]) \
+		PONEPIX(yp[(n)+1], xip[3*(n)+3])
+
+		PTWO422(0)
+		PTWO422(2)
+		PTWO422(4)
+		PTWO422(6)
+
+		xip += 24;
+		yp += 8;
+		up += 4;
+		vp += 4;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = iw - w;
+			int cstride = pstride >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += 3*pstride;
+		}
+	}
+}
+
+void RefTrue24::map_down2_422(const u_char* frm,
+				       u_int off, u_int x,
+				       u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + (off >> 1);
+	const u_char* vp = up + (framesize_ >> 1);
+	char* xip = (char*)pixbuf_ + 3*(((off - x) >> 2) + (x >> 1));
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height >> 1; len > 0; len -= 8) {
+		u_int l, uv;
+		u_int uflo, sum;
+
+#define PONE422(n) \
+		uv = yuv2rgb[(up[(n)/2] << 8) | vp[(n)/2]]; \
+		PONEPIX(yp[(n)], xip[3*(n)/2])
+
+		PONE422(0)
+		PONE422(2)
+		PONE422(4)
+		PONE422(6)
+
+		xip += 12;
+		yp += 8;
+		up += 4;
+		vp += 4;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 2 * iw - w;
+			int cstride = pstride >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += 3*((iw - w) >> 1);
+		}
+	}
+}
+
+void RefTrue24::map_down4_422(const u_char* frm,
+				       u_int off, u_int x,
+				       u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + (off >> 1);
+	const u_char* vp = up + (framesize_ >> 1);
+	char* xip = (char*)pixbuf_ + 3*(((off - x) >> 4) + (x >> 2));
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height >> 2; len > 0; len -= 8) {
+		u_int l, uv;
+		u_int uflo, sum;
+
+		uv = yuv2rgb[(up[0] << 8) | vp[0]];
+		PONEPIX(yp[0], xip[0])
+		uv = yuv2rgb[(up[2] << 8) | vp[2]];
+		PONEPIX(yp[4], xip[3])
+
+		xip += 6;
+		yp += 8;
+		up += 4;
+		vp += 4;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 4 * iw - w;
+			int cstride = pstride >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += 3*((iw - w) >> 2);
+		}
+	}
+}
+
+/*
+ * decimate by some power of 2 >= 2^3.
+ */
+void RefTrue24::map_down_422(const u_char* frm,
+				      u_int off, u_int x,
+				      u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + (off >> 1);
+	const u_char* vp = up + (framesize_ >> 1);
+	int s = scale_;
+	int istride = 1 << s;
+	char* xip = (char*)pixbuf_ +
+	    3*(((off - x) >> (s + s)) + (x >> s));
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height >> s; len > 0; len -= istride) {
+		u_int l, uv;
+		u_int uflo, sum;
+
+		uv = yuv2rgb[(up[0] << 8) | vp[0]];
+		PONEPIX(yp[0], xip[0])
+
+		xip += 3;
+		yp += istride;
+		up += istride >> 1;
+		vp += istride >> 1;
+
+		w -= istride;
+		if (w <= 0) {
+			w = width;
+			int pstride = (iw << s) - w;
+			int cstride = pstride >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += 3*((iw - w) >> s);
+		}
+	}
+}
+
+void RefTrue24::map_up2_422(const u_char* frm,
+				     u_int off, u_int x,
+				     u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + (off >> 1);
+	const u_char* vp = up + (framesize_ >> 1);
+	char* xip = (char*)pixbuf_ + 3*(((off - x) << 2) + (x << 1));
+	int w = width;
+	u_int e1 = yp[0];
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height; len > 0; len -= 2) {
+		u_int l, uv;
+		u_int uflo, sum;
+		u_int e2;
+		char* xip2 = xip + 3*((iw << 1));
+
+		uv = yuv2rgb[(up[0] << 8) | vp[0]];
+		e2 = yp[0];
+		PONEPIX((e1 + e2) >> 1, xip[0])
+		PONERGB(xip2[0], sum);
+		PONEPIX(e2, xip[3])
+		PONERGB(xip2[3], sum);
+		e1 = yp[1];
+		PONEPIX((e1 + e2) >> 1, xip[6])
+		PONERGB(xip2[6], sum);
+		PONEPIX(e1, xip[9])
+		PONERGB(xip2[9], sum);
+
+		xip += 12;
+		yp += 2;
+		up += 1;
+		vp += 1;
+
+		w -= 2;
+		if (w <= 0) {
+			w = width;
+			u_int pstride = iw - w;
+			u_int cstride = pstride >> 1;
+			yp += pstride;
+			e1 = yp[0];
+			up += cstride;
+			vp += cstride;
+			xip += 3*((iw + pstride) << 1);
+		}
+	}
+}
+
+void RefTrue24::map_420(const u_char* frm, u_int off,
+				 u_int x, u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + ((off - x) >> 2) + (x >> 1);
+	const u_char* vp = up + (framesize_ >> 2);
+	char* xip = (char*)pixbuf_ + 3*off;
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height; len > 0; len -= 8) {
+		u_int l, uv;
+		u_int uflo, sum;
+		char* xip2 = xip + 3*iw;
+		const u_char* yp2 = yp + iw;
+
+#define PFOUR420(n) \
+		uv = yuv2rgb[(up[(n)/2] << 8) | vp[(n)/2]]; \
+		PONEPIX(yp[(n)], xip[3*(n)]) \
+		PONEPIX(yp[(n)+1], xip[3*(n)+3]) \
+		PONEPIX(yp2[(n)], xip2[3*(n)]) \
+		PONEPIX(yp2[(n)+1], xip2[3*(n)+3])
+
+		PFOUR420(0)
+		PFOUR420(2)
+
+		xip += 12;
+		yp += 4;
+		up += 2;
+		vp += 2;
+
+		w -= 4;
+		if (w <= 0) {
+			w = width;
+			int pstride = 2 * iw - w;
+			int cstride = (iw - w) >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += 3*pstride;
+		}
+	}
+}
+
+void RefTrue24::map_down2_420(const u_char* frm,
+				       u_int off, u_int x,
+				       u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	off = ((off - x) >> 2) + (x >> 1);
+	const u_char* up = frm + framesize_ + off;
+	const u_char* vp = up + (framesize_ >> 2);
+	char* xip = (char*)pixbuf_ + 3*off;
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height >> 1; len > 0; len -= 8) {
+		u_int l, uv;
+		u_int uflo, sum;
+
+#define PONE420(n) \
+		uv = yuv2rgb[(up[(n)/2] << 8) | vp[(n)/2]]; \
+		PONEPIX(yp[(n)], xip[3*(n)/2])
+
+		PONE420(0)
+		PONE420(2)
+		PONE420(4)
+		PONE420(6)
+
+		xip += 12;
+		yp += 8;
+		up += 4;
+		vp += 4;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 2 * iw - w;
+			int cstride = (iw - w) >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += 3*cstride;
+		}
+	}
+}
+
+void RefTrue24::map_down4_420(const u_char* frm,
+				       u_int off, u_int x,
+				       u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + ((off - x) >> 2) + (x >> 1);
+	const u_char* vp = up + (framesize_ >> 2);
+	char* xip = (char*)pixbuf_ + 3*(((off - x) >> 4) + (x >> 2));
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height >> 2; len > 0; len -= 8) {
+		u_int l, uv;
+		u_int uflo, sum;
+
+		uv = yuv2rgb[(up[0] << 8) | vp[0]];
+		PONEPIX(yp[0], xip[0])
+		uv = yuv2rgb[(up[2] << 8) | vp[2]];
+		PONEPIX(yp[4], xip[3])
+
+		xip += 6;
+		yp += 8;
+		up += 4;
+		vp += 4;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 4 * iw - w;
+			int cstride = iw - (w >> 1);
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += 3*((iw - w) >> 2);
+		}
+	}
+}
+
+/*
+ * decimate by some power of 2 >= 2^3.
+ */
+void RefTrue24::map_down_420(const u_char* frm,
+				      u_int off, u_int x,
+				      u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + ((off - x) >> 2) + (x >> 1);
+	const u_char* vp = up + (framesize_ >> 2);
+	int s = scale_;
+	int istride = 1 << s;
+	char* xip = (char*)pixbuf_
+		+ 3*(((off - x) >> (s + s)) + (x >> s));
+	int w = width;
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height >> s; len > 0; len -= istride) {
+		u_int l, uv;
+		u_int uflo, sum;
+
+		uv = yuv2rgb[(up[0] << 8) | vp[0]];
+		PONEPIX(yp[0], xip[0])
+
+		xip += 3;
+		yp += istride;
+		up += istride >> 1;
+		vp += istride >> 1;
+
+		w -= istride;
+		if (w <= 0) {
+			w = width;
+			int pstride = (iw << s) - w;
+			int cstride = (iw << (s - 2)) - (w >> 1);
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += 3*((iw - w) >> s);
+		}
+	}
+}
+
+void RefTrue24::map_up2_420(const u_char* frm,
+				     u_int off, u_int x,
+				     u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + ((off - x) >> 2) + (x >> 1);
+	const u_char* vp = up + (framesize_ >> 2);
+	char* xip = (char*)pixbuf_ + 3*(((off - x) << 2) + (x << 1));
+	int w = width;
+	u_int e1 = yp[0], o1 = yp[iw];
+	const u_int* yuv2rgb = uvtab_;
+	u_int omask = omask_;
+	u_int pmask = pmask_;
+
+	for (int len = w * height; len > 0; len -= 4) {
+		u_int l, uv;
+		u_int uflo, sum;
+		u_int e2, o2;
+		const u_char* yp2 = yp + iw;
+		char* xip2 = xip + 3*((iw << 1));
+		char* xip3 = xip2 + 3*((iw << 1));
+		char* xip4 = xip3 + 3*((iw << 1));
+
+		uv = yuv2rgb[(up[0] << 8) | vp[0]];
+		e2 = yp[0];
+		PONEPIX((e1 + e2) >> 1, xip[0])
+		PONERGB(xip2[0], sum);
+		PONEPIX(e2, xip[3])
+		PONERGB(xip2[3], sum);
+		e1 = yp[1];
+		PONEPIX((e1 + e2) >> 1, xip[6])
+		PONERGB(xip2[6], sum);
+		PONEPIX(e1, xip[9])
+		PONERGB(xip2[9], sum);
+
+		o2 = yp2[0];
+		PONEPIX((o1 + o2) >> 1, xip3[0])
+		PONERGB(xip4[0], sum);
+		PONEPIX(o2, xip3[3])
+		PONERGB(xip4[3], sum);
+		o1 = yp2[1];
+		PONEPIX((o1 + o2) >> 1, xip3[6])
+		PONERGB(xip4[6], sum);
+		PONEPIX(o1, xip3[9])
+		PONERGB(xip4[9], sum);
+
+		xip += 12;
+		yp += 2;
+		up += 1;
+		vp += 1;
+
+		w -= 2;
+		if (w <= 0) {
+			w = width;
+			u_int pstride = 2 * iw - w;
+			u_int cstride = (iw - w) >> 1;
+			yp += pstride;
+			e1 = yp[0];
+			o1 = yp[iw];
+			up += cstride;
+			vp += cstride;
+			xip += 3 * (8 * iw - 2 * w);
+		}
+	}
+}
+
+void RefTrue24::map_gray(const u_char *yp,
+				  u_int off, u_int /* x */,
+				  u_int width, u_int height) const
+{
+
+	u_int iw = width_;
+	yp += off;
+	char* xip = (char*)pixbuf_ + 3*off;
+	int w = width;
+	for (int len = w * height; len > 0; len -= 8) {
+		u_int y1;
+		u_int pix;
+
+		y1 = *(const u_int*)yp;
+		pix = (y1 >> SHIFT_24) & 0xff;
+		PONEGRAY(xip[0], pix);
+		pix = (y1 >> SHIFT_16) & 0xff;
+		PONEGRAY(xip[3], pix);
+		pix = (y1 >> SHIFT_8) & 0xff;
+		PONEGRAY(xip[6], pix);
+		pix = (y1 >> SHIFT_0) & 0xff;
+		PONEGRAY(xip[9], pix);
+
+		y1 = *(const u_int*)(yp + 4);
+		pix = (y1 >> SHIFT_24) & 0xff;
+		PONEGRAY(xip[12], pix);
+		pix = (y1 >> SHIFT_16) & 0xff;
+		PONEGRAY(xip[15], pix);
+	        pix = (y1 >> SHIFT_8) & 0xff;
+		PONEGRAY(xip[18], pix);
+		pix = (y1 >> SHIFT_0) & 0xff;
+		PONEGRAY(xip[21], pix);
+
+		xip += 24;
+		yp += 8;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			u_int pstride = iw - w;
+			yp += pstride;
+			xip += 3*pstride;
+		}
+	}
+}
+
+void RefTrue24::map_gray_down2(const u_char *yp,
+					u_int off, u_int x,
+					u_int width, u_int height) const
+{
+	u_int iw = width_;
+	yp += off;
+	off = ((off - x) >> 2) + (x >> 1);
+	char* xip = (char*)pixbuf_ + 3*off;
+	int w = width;
+	for (int len = w * height >> 1; len > 0; len -= 8) {
+		u_int y1;
+		u_int pix;
+
+		y1 = *(const u_int*)yp;
+		pix = (y1 >> SHIFT_24) & 0xff;
+		PONEGRAY(xip[0], pix);
+		pix = (y1 >> SHIFT_8) & 0xff;
+		PONEGRAY(xip[3], pix);
+
+		y1 = *(const u_int*)(yp + 4);
+		pix = (y1 >> SHIFT_24) & 0xff;
+		PONEGRAY(xip[6], pix);
+		pix = (y1 >> SHIFT_8) & 0xff;
+		PONEGRAY(xip[9], pix);
+
+		xip += 12;
+		yp += 8;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 2 * iw - w;
+			yp += pstride;
+			xip += 3*((iw - w) >> 1);
+		}
+	}
+}
+
+void RefTrue24::map_gray_down4(const u_char *yp,
+					u_int off, u_int x,
+					u_int width, u_int height) const
+{
+	u_int iw = width_;
+	yp += off;
+	char* xip = (char*)pixbuf_ + 3*(((off - x) >> 4) + (x >> 2));
+	int w = width;
+	for (int len = w * height >> 2; len > 0; len -= 8) {
+		u_int pix;
+
+		pix = yp[0];
+		PONEGRAY(xip[0], pix);
+		pix = yp[4];
+		PONEGRAY(xip[3], pix);
+
+		xip += 6;
+		yp += 8;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 4 * iw - w;
+			yp += pstride;
+			xip += 3*((iw - w) >> 2);
+		}
+	}
+}
+
+void RefTrue24::map_gray_down(const u_char *yp,
+				       u_int off, u_int x,
+				       u_int width, u_int height) const
+{
+	u_int iw = width_;
+	yp += off;
+	int s = scale_;
+	int istride = 1 << s;
+	char* xip = (char*)pixbuf_ +
+		3*(((off - x) >> (s + s)) + (x >> s));
+	int w = width;
+	for (int len = w * height >> s; len > 0; len -= istride) {
+		u_int pix = *yp;
+		PONEGRAY(xip[0], pix);
+		xip += 3;
+		yp += istride;
+		w -= istride;
+		if (w <= 0) {
+			w = width;
+			int pstride = (iw << s) - w;
+			yp += pstride;
+			xip += 3*((iw - w) >> s);
+		}
+	}
+}
+
+void RefTrue24::map_gray_up2(const u_char *yp,
+				      u_int off, u_int x,
+				      u_int width, u_int height) const
+{
+	u_int iw = width_;
+	yp += off;
+	char* xip = (char*)pixbuf_ + 3*(((off - x) << 2) + (x << 1));
+	int w = width;
+	u_int e1 = yp[0];
+
+	for (int len = width * height; len > 0; len -= 8) {
+		u_int y1, e2, pix;
+		char* xip2 = xip + 3*iw * 2;
+
+		y1 = *(const u_int*)yp;
+		e2 = (y1 >> SHIFT_24) & 0xff;
+		pix = (e1 + e2) >> 1;
+		PONEGRAY(xip[0], pix);
+		PONEGRAY(xip2[0], pix);
+		PONEGRAY(xip[3], e2);
+		PONEGRAY(xip2[3], e2);
+		e1 = (y1 >> SHIFT_16) & 0xff;
+		pix = (e1 + e2) >> 1;
+		PONEGRAY(xip[6], pix);
+		PONEGRAY(xip2[6], pix);
+		PONEGRAY(xip[9], e1);
+		PONEGRAY(xip2[9], e1);
+
+		e2 = (y1 >> SHIFT_8) & 0xff;
+		pix = (e1 + e2) >> 1;
+		PONEGRAY(xip[12], pix);
+		PONEGRAY(xip2[12], pix);
+		PONEGRAY(xip[15], e2);
+		PONEGRAY(xip2[15], e2);
+		e1 = (y1 >> SHIFT_0) & 0xff;
+		pix = (e1 + e2) >> 1;
+		PONEGRAY(xip[18], pix);
+		PONEGRAY(xip2[18], pix);
+		PONEGRAY(xip[21], e1);
+		PONEGRAY(xip2[21], e1);
+
+		y1 = *(const u_int*)(yp + 4);
+		e2 = (y1 >> SHIFT_24) & 0xff;
+		pix = (e1 + e2) >> 1;
+		PONEGRAY(xip[24], pix);
+		PONEGRAY(xip2[24], pix);
+		PONEGRAY(xip[27], e2);
+		PONEGRAY(xip2[27], e2);
+		e1 = (y1 >> SHIFT_16) & 0xff;
+		pix = (e1 + e2) >> 1;
+		PONEGRAY(xip[30], pix);
+		PONEGRAY(xip2[30], pix);
+		PONEGRAY(xip[33], e1);
+		PONEGRAY(xip2[33], e1);
+
+		e2 = (y1 >> SHIFT_8) & 0xff;
+		pix = (e1 + e2) >> 1;
+		PONEGRAY(xip[36], pix);
+		PONEGRAY(xip2[36], pix);
+		PONEGRAY(xip[39], e2);
+		PONEGRAY(xip2[39], e2);
+		e1 = (y1 >> SHIFT_0) & 0xff;
+		pix = (e1 + e2) >> 1;
+		PONEGRAY(xip[42], pix);
+		PONEGRAY(xip2[42], pix);
+		PONEGRAY(xip[45], e1);
+		PONEGRAY(xip2[45], e1);
+
+		xip += 48;
+		yp += 8;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			u_int pstride = iw - w;
+			yp += pstride;
+			e1 = yp[0];
+			xip += 3*((iw + pstride) << 1);
+		}
+	}
+}
+
+#undef FOUR420
+#undef ONE420
+#undef ONE422
+#undef ONEGRAY
+#undef ONEPIX
+#undef ONERGB
+#undef PFOUR420
+#undef PONE420
+#undef PONE422
+#undef PONEGRAY
+#undef PONEPIX
+#undef PONERGB
+#undef PTWO422
+#undef SHIFT_0
+#undef SHIFT_16
+#undef SHIFT_24
+#undef SHIFT_8
+#undef TWO422
+#undef UV0
+#undef UV1
+#undef UV2
+#undef UV3
+
+/*
+ * This routine sums the luma & chroma components of one pixel &
+ * constructs an rgb output.  It does all three r g b components
+ * in parallel.  The one complication is that it has to
+ * deal with overflow (sum > 255) and underflow (sum < 0).  Underflow
+ * & overflow are only possible if both terms have the same sign and
+ * are indicated by the result having a different sign than the terms.
+ * Note that we ignore the carry into the next byte's lsb that happens
+ * on an overflow/underflow on the grounds that it's probably invisible.
+ * The luma term and sum are biased by 128 so a negative number has the
+ * 2^7 bit = 0.  The chroma term is not biased so a negative number has
+ * the 2^7 bit = 1.  So underflow is indicated by (L & C & sum) != 0;
+ */
+
+#define PIXSETUP \
+	const u_short* uv;
+
+#define ONEPIX(src, dst) { \
+	dst = uv[src >> 2]; \
+}
+
+void RefHi::map_422(const u_char* frm, u_int off,
+				 u_int /* x */, u_int width, u_int height) const
+{
+
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + (off >> 1);
+	const u_char* vp = up + (framesize_ >> 1);
+	u_short* xip = (u_short*)pixbuf_ + off;
+	int w = width;
+	const u_short* yuv2rgb = uvtab_;
+
+	for (int len = w * height; len > 0; len -= 8) {
+		PIXSETUP
+
+#define TWO422(n) \
+		uv = yuv2rgb + UVINDX(up[(n)/2], vp[(n)/2]); \
+		ONEPIX(yp[(n)], xip[(n)]) \
+		ONEPIX(yp[(n)+1], xip[(n)+1])
+
+		TWO422(0)
+		TWO422(2)
+		TWO422(4)
+		TWO422(6)
+
+		xip += 8;
+		yp += 8;
+		up += 4;
+		vp += 4;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = iw - w;
+			int cstride = pstride >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += pstride;
+		}
+	}
+}
+
+void RefHi::map_down2_422(const u_char* frm,
+				       u_int off, u_int x,
+				       u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + (off >> 1);
+	const u_char* vp = up + (framesize_ >> 1);
+	u_short* xip = (u_short*)pixbuf_ + ((off - x) >> 2) + (x >> 1);
+	int w = width;
+	const u_short* yuv2rgb = uvtab_;
+
+	for (int len = w * height >> 1; len > 0; len -= 8) {
+		PIXSETUP
+
+#define ONE422(n) \
+		uv = yuv2rgb + UVINDX(up[(n)/2], vp[(n)/2]); \
+		ONEPIX(yp[(n)], xip[(n)/2])
+
+		ONE422(0)
+		ONE422(2)
+		ONE422(4)
+		ONE422(6)
+
+		xip += 4;
+		yp += 8;
+		up += 4;
+		vp += 4;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 2 * iw - w;
+			int cstride = pstride >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += (iw - w) >> 1;
+		}
+	}
+}
+
+void RefHi::map_down4_422(const u_char* frm,
+				       u_int off, u_int x,
+				       u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + (off >> 1);
+	const u_char* vp = up + (framesize_ >> 1);
+	u_short* xip = (u_short*)pixbuf_ + ((off - x) >> 4) + (x >> 2);
+	int w = width;
+	const u_short* yuv2rgb = uvtab_;
+
+	for (int len = w * height >> 2; len > 0; len -= 8) {
+		PIXSETUP
+
+		uv = yuv2rgb + UVINDX(up[0], vp[0]);
+		ONEPIX(yp[0], xip[0])
+		uv = yuv2rgb + UVINDX(up[2], vp[2]);
+		ONEPIX(yp[4], xip[1])
+
+		xip += 2;
+		yp += 8;
+		up += 4;
+		vp += 4;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 4 * iw - w;
+			int cstride = pstride >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += (iw - w) >> 2;
+		}
+	}
+}
+
+/*
+ * decimate by some power of 2 >= 2^3.
+ */
+void RefHi::map_down_422(const u_char* frm,
+				      u_int off, u_int x,
+				      u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + (off >> 1);
+	const u_char* vp = up + (framesize_ >> 1);
+	int s = scale_;
+	int istride = 1 << s;
+	u_short* xip = (u_short*)pixbuf_ +
+		((off - x) >> (s + s)) + (x >> s);
+	int w = width;
+	const u_short* yuv2rgb = uvtab_;
+
+	for (int len = w * height >> s; len > 0; len -= istride) {
+		PIXSETUP
+
+		uv = yuv2rgb + UVINDX(up[0], vp[0]);
+		ONEPIX(yp[0], xip[0])
+
+		xip += 1;
+		yp += istride;
+		up += istride >> 1;
+		vp += istride >> 1;
+
+		w -= istride;
+		if (w <= 0) {
+			w = width;
+			int pstride = (iw << s) - w;
+			int cstride = pstride >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += (iw - w) >> s;
+		}
+	}
+}
+
+void RefHi::map_up2_422(const u_char* frm,
+				     u_int off, u_int x,
+				     u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + (off >> 1);
+	const u_char* vp = up + (framesize_ >> 1);
+	u_short* xip = (u_short*)pixbuf_ + ((off - x) << 2) + (x << 1);
+	int w = width;
+	u_short e1 = yp[0];
+	const u_short* yuv2rgb = uvtab_;
+
+	for (int len = w * height; len > 0; len -= 2) {
+		PIXSETUP
+		u_short e2, t;
+		u_short* xip2 = xip + (iw << 1);
+
+		uv = yuv2rgb + UVINDX(up[0], vp[0]);
+		e2 = yp[0];
+		ONEPIX((e1 + e2) >> 1, t)
+		xip[0] = t;
+		xip2[0] = t;
+		ONEPIX(e2, t)
+		xip[1] = t;
+		xip2[1] = t;
+		e1 = yp[1];
+		ONEPIX((e1 + e2) >> 1, t)
+		xip[2] = t;
+		xip2[2] = t;
+		ONEPIX(e1, t)
+		xip[3] = t;
+		xip2[3] = t;
+
+		xip += 4;
+		yp += 2;
+		up += 1;
+		vp += 1;
+
+		w -= 2;
+		if (w <= 0) {
+			w = width;
+			u_int pstride = iw - w;
+			u_int cstride = pstride >> 1;
+			yp += pstride;
+			e1 = yp[0];
+			up += cstride;
+			vp += cstride;
+			xip += (iw + pstride) << 1;
+		}
+	}
+}
+
+void RefHi::map_420(const u_char* frm, u_int off,
+				 u_int x, u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + ((off - x) >> 2) + (x >> 1);
+	const u_char* vp = up + (framesize_ >> 2);
+	u_short* xip = (u_short*)pixbuf_ + off;
+	int w = width;
+	const u_short* yuv2rgb = uvtab_;
+
+	for (int len = w * height; len > 0; len -= 8) {
+		PIXSETUP
+		u_short* xip2 = xip + iw;
+		const u_char* yp2 = yp + iw;
+
+#define FOUR420(n) \
+		uv = yuv2rgb + UVINDX(up[(n)/2], vp[(n)/2]); \
+		ONEPIX(yp[(n)], xip[(n)]) \
+		ONEPIX(yp[(n)+1], xip[(n)+1]) \
+		ONEPIX(yp2[(n)], xip2[(n)]) \
+		ONEPIX(yp2[(n)+1], xip2[(n)+1])
+
+		FOUR420(0)
+		FOUR420(2)
+
+		xip += 4;
+		yp += 4;
+		up += 2;
+		vp += 2;
+
+		w -= 4;
+		if (w <= 0) {
+			w = width;
+			int pstride = 2 * iw - w;
+			int cstride = (iw - w) >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += pstride;
+		}
+	}
+}
+
+void RefHi::map_down2_420(const u_char* frm,
+				       u_int off, u_int x,
+				       u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	off = ((off - x) >> 2) + (x >> 1);
+	const u_char* up = frm + framesize_ + off;
+	const u_char* vp = up + (framesize_ >> 2);
+	u_short* xip = (u_short*)pixbuf_ + off;
+	int w = width;
+	const u_short* yuv2rgb = uvtab_;
+
+	for (int len = w * height >> 1; len > 0; len -= 8) {
+		PIXSETUP
+
+#define ONE420(n) \
+		uv = yuv2rgb + UVINDX(up[(n)/2], vp[(n)/2]); \
+		ONEPIX(yp[(n)], xip[(n)/2])
+
+		ONE420(0)
+		ONE420(2)
+		ONE420(4)
+		ONE420(6)
+
+		xip += 4;
+		yp += 8;
+		up += 4;
+		vp += 4;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 2 * iw - w;
+			int cstride = (iw - w) >> 1;
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += cstride;
+		}
+	}
+}
+
+void RefHi::map_down4_420(const u_char* frm,
+				       u_int off, u_int x, 
+				       u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + ((off - x) >> 2) + (x >> 1);
+	const u_char* vp = up + (framesize_ >> 2);
+	u_short* xip = (u_short*)pixbuf_ + ((off - x) >> 4) + (x >> 2);
+	int w = width;
+	const u_short* yuv2rgb = uvtab_;
+
+	for (int len = w * height >> 2; len > 0; len -= 8) {
+		PIXSETUP
+
+		uv = yuv2rgb + UVINDX(up[0], vp[0]);
+		ONEPIX(yp[0], xip[0])
+		uv = yuv2rgb + UVINDX(up[2], vp[2]);
+		ONEPIX(yp[4], xip[1])
+
+		xip += 2;
+		yp += 8;
+		up += 4;
+		vp += 4;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 4 * iw - w;
+			int cstride = iw - (w >> 1);
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += (iw - w) >> 2;
+		}
+	}
+}
+
+/*
+ * decimate by some power of 2 >= 2^3.
+ */
+void RefHi::map_down_420(const u_char* frm,
+				      u_int off, u_int x,
+				      u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + ((off - x) >> 2) + (x >> 1);
+	const u_char* vp = up + (framesize_ >> 2);
+	int s = scale_;
+	int istride = 1 << s;
+	u_short* xip = (u_short*)pixbuf_
+		+ ((off - x) >> (s + s)) + (x >> s);
+	int w = width;
+	const u_short* yuv2rgb = uvtab_;
+
+	for (int len = w * height >> s; len > 0; len -= istride) {
+		PIXSETUP
+
+		uv = yuv2rgb + UVINDX(up[0], vp[0]);
+		ONEPIX(yp[0], xip[0])
+
+		xip += 1;
+		yp += istride;
+		up += istride >> 1;
+		vp += istride >> 1;
+
+		w -= istride;
+		if (w <= 0) {
+			w = width;
+			int pstride = (iw << s) - w;
+			int cstride = (iw << (s - 2)) - (w >> 1);
+			yp += pstride;
+			up += cstride;
+			vp += cstride;
+			xip += (iw - w) >> s;
+		}
+	}
+}
+
+void RefHi::map_up2_420(const u_char* frm,
+				     u_int off, u_int x,
+				     u_int width, u_int height) const
+{
+	u_int iw = width_;
+	const u_char* yp = frm + off;
+	const u_char* up = frm + framesize_ + ((off - x) >> 2) + (x >> 1);
+	const u_char* vp = up + (framesize_ >> 2);
+	u_short* xip = (u_short*)pixbuf_ + ((off - x) << 2) + (x << 1);
+	int w = width;
+	u_short e1 = yp[0], o1 = yp[iw];
+	const u_short* yuv2rgb = uvtab_;
+
+	for (int len = w * height; len > 0; len -= 4) {
+		PIXSETUP
+		u_short e2, o2, t;
+		const u_char* yp2 = yp + iw;
+		u_short* xip2 = xip + (iw << 1);
+		u_short* xip3 = xip2 + (iw << 1);
+		u_short* xip4 = xip3 + (iw << 1);
+
+		uv = yuv2rgb + UVINDX(up[0], vp[0]);
+		e2 = yp[0];
+#define ONEx2e(v, n) \
+	ONEPIX(v, t) \
+	xip[n] = t; \
+	xip2[n] = t;
+#define ONEx2o(v, n) \
+	ONEPIX(v, t) \
+	xip3[n] = t; \
+	xip4[n] = t;
+		ONEx2e((e1 + e2) >> 1, 0)
+		ONEx2e(e2, 1)
+		e1 = yp[1];
+		ONEx2e((e1 + e2) >> 1, 2)
+		ONEx2e(e1, 3)
+
+		o2 = yp2[0];
+		ONEx2o((o1 + o2) >> 1, 0)
+		ONEx2o(o2, 1)
+		o1 = yp2[1];
+		ONEx2o((o1 + o2) >> 1, 2)
+		ONEx2o(o1, 3)
+
+		xip += 4;
+		yp += 2;
+		up += 1;
+		vp += 1;
+
+		w -= 2;
+		if (w <= 0) {
+			w = width;
+			u_int pstride = 2 * iw - w;
+			u_int cstride = (iw - w) >> 1;
+			yp += pstride;
+			e1 = yp[0];
+			o1 = yp[iw];
+			up += cstride;
+			vp += cstride;
+			xip += 8 * iw - 2 * w;
+		}
+	}
+}
+
+void RefHi::map_gray(const u_char *yp,
+				  u_int off, u_int /* x */,
+				  u_int width, u_int height) const
+{
+
+	u_int iw = width_;
+	yp += off;
+	u_short* xip = (u_short*)pixbuf_ + off;
+	const u_short* uv = uvtab_ + UVINDX(0x80, 0x80);
+	int w = width;
+	for (int len = w * height; len > 0; len -= 8) {
+		ONEPIX(yp[0], xip[0])
+		ONEPIX(yp[1], xip[1])
+		ONEPIX(yp[2], xip[2])
+		ONEPIX(yp[3], xip[3])
+		ONEPIX(yp[4], xip[4])
+		ONEPIX(yp[5], xip[5])
+		ONEPIX(yp[6], xip[6])
+		ONEPIX(yp[7], xip[7])
+
+		xip += 8;
+		yp += 8;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			u_int pstride = iw - w;
+			yp += pstride;
+			xip += pstride;
+		}
+	}
+}
+
+void RefHi::map_gray_down2(const u_char *yp,
+					u_int off, u_int x,
+					u_int width, u_int height) const
+{
+	u_int iw = width_;
+	yp += off;
+	off = ((off - x) >> 2) + (x >> 1);
+	u_short* xip = (u_short*)pixbuf_ + off;
+	const u_short* uv = uvtab_ + UVINDX(0x80, 0x80);
+	int w = width;
+	for (int len = w * height >> 1; len > 0; len -= 8) {
+		ONEPIX(yp[0], xip[0])
+		ONEPIX(yp[2], xip[1])
+		ONEPIX(yp[4], xip[2])
+		ONEPIX(yp[6], xip[3])
+
+		xip += 4;
+		yp += 8;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 2 * iw - w;
+			yp += pstride;
+			xip += (iw - w) >> 1;
+		}
+	}
+}
+
+void RefHi::map_gray_down4(const u_char *yp,
+					u_int off, u_int x,
+					u_int width, u_int height) const
+{
+	u_int iw = width_;
+	yp += off;
+	u_short* xip = (u_short*)pixbuf_ + ((off - x) >> 4) + (x >> 2);
+	const u_short* uv = uvtab_ + UVINDX(0x80, 0x80);
+	int w = width;
+	for (int len = w * height >> 2; len > 0; len -= 8) {
+		ONEPIX(yp[0], xip[0])
+		ONEPIX(yp[4], xip[1])
+
+		xip += 2;
+		yp += 8;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			int pstride = 4 * iw - w;
+			yp += pstride;
+			xip += (iw - w) >> 2;
+		}
+	}
+}
+
+void RefHi::map_gray_down(const u_char *yp,
+				       u_int off, u_int x,
+				       u_int width, u_int height) const
+{
+	u_int iw = width_;
+	yp += off;
+	int s = scale_;
+	int istride = 1 << s;
+	u_short* xip = (u_short*)pixbuf_ +
+		((off - x) >> (s + s)) + (x >> s);
+	const u_short* uv = uvtab_ + UVINDX(0x80, 0x80);
+	int w = width;
+	for (int len = w * height >> s; len > 0; len -= istride) {
+		ONEPIX(yp[0], xip[0])
+
+		++xip;
+		yp += istride;
+		w -= istride;
+		if (w <= 0) {
+			w = width;
+			int pstride = (iw << s) - w;
+			yp += pstride;
+			xip += (iw - w) >> s;
+		}
+	}
+}
+
+void RefHi::map_gray_up2(const u_char *yp,
+				      u_int off, u_int x,
+				      u_int width, u_int height) const
+{
+	u_int iw = width_;
+	yp += off;
+	u_short* xip = (u_short*)pixbuf_ + ((off - x) << 2) + (x << 1);
+	const u_short* uv = uvtab_ + UVINDX(0x80, 0x80);
+	int w = width;
+	u_short e1 = yp[0];
+
+	for (int len = width * height; len > 0; len -= 8) {
+		u_short t, e2;
+		u_short* xip2 = xip + iw * 2;
+
+#define ONEx2(v, n) \
+	ONEPIX(v, t) \
+	xip[n] = t; \
+	xip2[n] = t;
+
+#define TWOx2(n) \
+	e2 = yp[n]; \
+	ONEx2((e1 + e2) >> 1, (n)*2) \
+	ONEx2(e2, (n)*2 + 1) \
+	e1 = yp[(n) + 1]; \
+	ONEx2((e1 + e2) >> 1, (n)*2 + 2) \
+	ONEx2(e1, (n)*2 + 3)
+
+		TWOx2(0)
+		TWOx2(2)
+		TWOx2(4)
+		TWOx2(6)
+
+		xip += 16;
+		yp += 8;
+
+		w -= 8;
+		if (w <= 0) {
+			w = width;
+			u_int pstride = iw - w;
+			yp += pstride;
+			e1 = yp[0];
+			xip += (iw + pstride) << 1;
+		}
+	}
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef vic_rendref_h
+#define vic_rendref_h
+
+#include "yuv-map.h"
+
+/*
+ * The direct color kernels as they were before yuv-map.h, kept
+ * so rendbench can check YuvMap's output against them and time
+ * the two side by side.  A RefRenderer draws into the target t
+ * as the old 16 (HiWindowRenderer), 24 or 32 bit
+ * (TrueWindowRenderer24/32) renderers did; uvtab is the color
+ * model's table, an array of u_short for 16 bits and of u_int
+ * otherwise, and omask & pmask are only used by the latter.
+ */
+class RefRenderer {
+    public:
+	virtual ~RefRenderer() {}
+	static RefRenderer* alloc(int bpp, const YuvTarget& t,
+				  const void* uvtab, u_int omask,
+				  u_int pmask);
+	/* index is as in WindowRenderer::index() */
+	virtual void render(int index, const u_char* frm, u_int off,
+			    u_int x, u_int width, u_int height) const = 0;
+    protected:
+	RefRenderer(const YuvTarget& t) : width_(t.width),
+		framesize_(t.framesize), scale_(t.scale),
+		pixbuf_(t.pixbuf) {}
+	int width_;
+	int framesize_;
+	int scale_;
+	u_char* pixbuf_;
+};
+
+#endif
@@ -50,6 +50,7 @@ extern "C" {
 #endif
 
 #include "vw.h"
+#include "sys-time.h"
 #include "color.h"
 #include "rgb-converter.h"
 #ifdef HAVE_XVIDEO
@@ -258,6 +259,17 @@ void XVideoImage::putimage(Display* dpy, Window window, GC gc,
 		      int sx, int sy, int x, int y,int w, int h) const{
 	render.displayImage(window, gc, w, h);
 }
+
+void XVideoImage::present(Display* dpy, Window window, GC gc,
+			  int sx, int sy, int x, int y, int w, int h) const
+{
+	render.presentImage(window, gc, w, h);
+}
+
+u_long XVideoImage::shmseg() const
+{
+	return (render.shmseg());
+}
 #endif /*HAVE_XVIDEO*/
 
 SlowVideoImage::SlowVideoImage(Tk_Window tk, int w, int h)
@@ -367,6 +379,13 @@ void SharedVideoImage::putimage(Display* dpy, Window window, GC gc,
 {
 	XShmPutImage(dpy, window, gc, image_, sx, sy, x, y, w, h, 0);
 }
+
+void SharedVideoImage::present(Display* dpy, Window window, GC gc,
+			       int sx, int sy, int x, int y,
+			       int w, int h) const
+{
+	XShmPutImage(dpy, window, gc, image_, sx, sy, x, y, w, h, True);
+}
 #endif
 
 #ifdef USE_DDRAW
@@ -1408,6 +1427,7 @@ GC VideoWindow::gc_;
 VideoWindow::VideoWindow(const char* name, XVisualInfo* vinfo)
 	: BareWindow(name, vinfo),
 	  vi_(0),
+	  present_(0),
 	  callback_pending_(0),
 	  damage_(0),
 	  voff_(0),
@@ -1473,20 +1493,20 @@ void VideoWindow::display(ClientData cd)
 	vw->draw(0, h, 0, 0);
 }
 
-void VideoWindow::draw(int y0, int y1, int x0, int x1)
+int VideoWindow::draw(int y0, int y1, int x0, int x1)
 {
 	if (callback_pending_) {
 		callback_pending_ = 0;
 		Tk_CancelIdleCall(display, (ClientData)this);
 	}
 	if (!Tk_IsMapped(tk_))
-		return;
+		return (0);
 
 	Window window = Tk_WindowId(tk_);
 
 	if (vi_ == 0) {
 		XFillRectangle(dpy_, window, gc_, 0, 0, width_, height_);
-		return;
+		return (0);
 	}
 	int hoff = (width_ - vi_->width()) >> 1;
 	int voff = (height_ - vi_->height()) >> 1;
@@ -1515,16 +1535,22 @@ void VideoWindow::draw(int y0, int y1, int x0, int x1)
 //	else if (h > vi_->height())
 //		h = vi_->height();
 	else if (h < 0)
-		return;
+		return (0);
 	int w = x1 - x0;
 	if (w == 0)
 		w = vi_->width();
 //	else if (w > vi_->width())
 //		w = vi_->width();
 	else if (w < 0)
-		return;
+		return (0);
 
-	vi_->putimage(dpy_, window, gc_, x0, y0, x0 + hoff, y0 + voff, w, h);
+	if (present_)
+		vi_->present(dpy_, window, gc_, x0, y0, x0 + hoff, y0 + voff,
+			     w, h);
+	else
+		vi_->putimage(dpy_, window, gc_, x0, y0, x0 + hoff, y0 + voff,
+			      w, h);
+	return (1);
 }
 
 /*XXX*/
@@ -1616,6 +1642,153 @@ void VideoWindow::render(const VideoImage* v, int miny, int maxy,
 	draw(miny, maxy, minx, maxx);
 }
 
+int VideoWindow::present(const VideoImage* v, int miny, int maxy,
+			 int minx, int maxx)
+{
+	vi_ = v;
+	present_ = 1;
+	int put = draw(miny, maxy, minx, maxx);
+	present_ = 0;
+	return (put);
+}
+
+ImageRing* ImageRing::rings_;
+
+static double msnow()
+{
+	timeval tv;
+	::gettimeofday(&tv, 0);
+	return (1e3 * tv.tv_sec + 1e-3 * tv.tv_usec);
+}
+
+ImageRing::ImageRing(VideoWindow* vw)
+	: nimage_(0), cur_(0), vw_(vw), dpy_(Tk_Display(vw->tkwin())),
+	  event_(-1), npresent_(0), ndrop_(0), ncomplete_(0),
+	  latency_(0.), maxlatency_(0.)
+{
+	memset(slot_, 0, sizeof(slot_));
+#ifdef USE_SHM
+	event_ = XShmGetEventBase(dpy_) + ShmCompletion;
+#endif
+	if (rings_ == 0)
+		Tk_CreateGenericHandler(handle, 0);
+	next_ = rings_;
+	rings_ = this;
+}
+
+ImageRing::~ImageRing()
+{
+	ImageRing** p;
+	for (p = &rings_; *p != this; p = &(*p)->next_)
+		;
+	*p = next_;
+	if (rings_ == 0)
+		Tk_DeleteGenericHandler(handle, 0);
+	/* the server has to be done with the segments before they go */
+	XSync(dpy_, 0);
+	for (int i = 0; i < nimage_; ++i)
+		delete slot_[i].vi;
+}
+
+void ImageRing::add(VideoImage* vi, u_char* pixbuf)
+{
+	slot& s = slot_[nimage_];
+	s.vi = vi;
+	s.pixbuf = pixbuf;
+	s.shmseg = vi->shmseg();
+	s.pending = 0;
+	s.valid = 0;
+	/* the first is the current one */
+	if (nimage_++ == 0)
+		cur_ = 0;
+}
+
+int ImageRing::next(u_int ts, u_int& base)
+{
+	int n = cur_;
+	for (int i = 1; i < nimage_; ++i) {
+		int k = (cur_ + i) % nimage_;
+		if (slot_[k].pending == 0) {
+			n = k;
+			break;
+		}
+	}
+	if (n == cur_ && nimage_ > 1) {
+		++ndrop_;
+		return (-1);
+	}
+	cur_ = n;
+	slot& s = slot_[n];
+	/*
+	 * The rendering vector stamps wrap at 256 (see decoder.cpp),
+	 * so an image left alone for a good part of that can't be
+	 * brought up to date from them.
+	 */
+	if (!s.valid || ((ts - s.ts) & 0xff) > 64)
+		return (0);
+	base = s.ts;
+	return (1);
+}
+
+void ImageRing::done(u_int ts)
+{
+	slot& s = slot_[cur_];
+	s.ts = ts;
+	s.valid = 1;
+}
+
+void ImageRing::invalidate()
+{
+	for (int i = 0; i < nimage_; ++i)
+		slot_[i].valid = 0;
+}
+
+void ImageRing::present(int miny, int maxy, int minx, int maxx)
+{
+	slot& s = slot_[cur_];
+	if (vw_->present(s.vi, miny, maxy, minx, maxx)) {
+		if (s.pending++ == 0)
+			++npresent_;
+		s.sent = msnow();
+	}
+}
+
+void ImageRing::flush()
+{
+	XFlush(dpy_);
+}
+
+void ImageRing::complete(u_long shmseg)
+{
+	for (int i = 0; i < nimage_; ++i) {
+		slot& s = slot_[i];
+		if (s.shmseg != shmseg || s.pending == 0)
+			continue;
+		if (--s.pending == 0) {
+			double t = msnow() - s.sent;
+			latency_ += t;
+			if (t > maxlatency_)
+				maxlatency_ = t;
+			++ncomplete_;
+		}
+		return;
+	}
+}
+
+int ImageRing::handle(ClientData, XEvent* e)
+{
+#ifdef USE_SHM
+	for (ImageRing* p = rings_; p != 0; p = p->next_) {
+		if (e->type == p->event_ && e->xany.display == p->dpy_) {
+			p->complete(((XShmCompletionEvent*)e)->shmseg);
+			break;
+		}
+	}
+#endif
+	/* let Tk see it too */
+	return (0);
+}
+
 CaptureWindow::CaptureWindow(const char* name, XVisualInfo* vinfo)
 	: BareWindow(name, vinfo),
 	  base_width_(0),
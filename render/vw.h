@@ -59,6 +59,18 @@ class VideoImage {
 	virtual void putimage(Display* dpy, Window window, GC gc,
 			      int sx, int sy, int x, int y,
 			      int w, int h) const = 0;
+	/*
+	 * Put the image without waiting for the server to be done
+	 * with it; a shared image has a ShmCompletion event sent
+	 * for segment shmseg() when it is.  An image that isn't
+	 * shared (shmseg() is 0) is copied out by putimage().
+	 */
+	virtual void present(Display* dpy, Window window, GC gc,
+			     int sx, int sy, int x, int y,
+			     int w, int h) const {
+		putimage(dpy, window, gc, sx, sy, x, y, w, h);
+	}
+	virtual u_long shmseg() const { return (0); }
     protected:
 	int bpp_;		/* bits per pixel (XXX must be 1,8,16,32) */
 	int width_;
@@ -92,6 +104,9 @@ class XVideoImage : public VideoImage {
 	inline IMAGE_TYPE* ximage() { return (image_); }
 	void putimage(Display* dpy, Window window, GC gc,
 		      int sx, int sy, int x, int y,int w, int h) const;
+	void present(Display* dpy, Window window, GC gc,
+		     int sx, int sy, int x, int y, int w, int h) const;
+	u_long shmseg() const;
         static inline bool is_supported() { return enable_xv; }        		      
         
     protected:
@@ -121,6 +136,10 @@ class SharedVideoImage : public StandardVideoImage {
 	void putimage(Display* dpy, Window window, GC gc,
 		      int sx, int sy, int x, int y,
 		      int w, int h) const;
+	void present(Display* dpy, Window window, GC gc,
+		     int sx, int sy, int x, int y,
+		     int w, int h) const;
+	inline u_long shmseg() const { return (shminfo_.shmseg); }
 	inline int valid() const { return (shminfo_.shmid >= 0); }
     protected:
 	void init(Tk_Window tk);
@@ -402,6 +421,7 @@ class BareWindow : public TclObject {
 	inline int height() { return (height_); }
 	virtual void setsize(int w, int h);
 
+	inline int mapped() { return (Tk_IsMapped(tk_)); }
 	inline void map() { Tk_MapWindow(tk_); }
 	inline void unmap() { Tk_UnmapWindow(tk_); }
 	void sync();
@@ -435,6 +455,12 @@ class VideoWindow : public BareWindow {
 	void setimage(VideoImage* v) { vi_ = v; }
 	void render(const VideoImage* vi, int miny = 0, int maxy = 0,
 		    int minx = 0, int maxx = 0);
+	/*
+	 * render() through VideoImage::present(); returns true if
+	 * the image was put (the window is mapped).
+	 */
+	int present(const VideoImage* vi, int miny = 0, int maxy = 0,
+		    int minx = 0, int maxx = 0);
 	inline void complete() { sync(); }	/* complete last render call */
 	void redraw();
 	inline void damage(int v) { damage_ = v; }
@@ -442,6 +468,8 @@ class VideoWindow : public BareWindow {
 
 	inline void voff(int v) { voff_ = v; }
 	inline void hoff(int v) { hoff_ = v; }
+	inline int voff() const { return (voff_); }
+	inline int hoff() const { return (hoff_); }
 	int bpp();
 	/*
 	 * Return the VideoWindow object associated with
@@ -452,12 +480,13 @@ class VideoWindow : public BareWindow {
 		return ((VideoWindow*)TclObject::lookup(name));
 	}
     protected:
-	void draw(int miny, int maxy, int minx, int maxx);
+	int draw(int miny, int maxy, int minx, int maxx);
 	void dim();
 	void clear();
 
 	static GC gc_;
 	const VideoImage* vi_;
+	int present_;		/* true to draw with vi_->present() */
 	int callback_pending_;
 	int damage_;
 	int voff_;
@@ -468,6 +497,76 @@ class VideoWindow : public BareWindow {
 	static void dodim(ClientData);
 };
 
+/*
+ * Shared images a renderer draws into by turns, so that it can go
+ * on to the next frame while the X server is still reading the last
+ * rather than waiting out a round trip (XSync) for each.  Every put
+ * asks for a ShmCompletion event, and an image is handed out again
+ * only once all its puts have completed; the one on show never is.
+ * A frame that finds every other image still being read is dropped.
+ * The time from a frame's last put to the server being done with it
+ * is kept as the present latency.
+ */
+#define IMAGE_RING	3	/* images at most */
+
+class ImageRing {
+    public:
+	ImageRing(VideoWindow* vw);
+	~ImageRing();
+	/* take over vi, whose pixels are at pixbuf */
+	void add(VideoImage* vi, u_char* pixbuf);
+	inline int nimage() const { return (nimage_); }
+	/*
+	 * Move on to the next image, for frame ts.  Returns -1 if the
+	 * frame is to be dropped, 0 if the image has to be drawn over
+	 * whole, or 1 with `base' set to the frame it last showed.
+	 */
+	int next(u_int ts, u_int& base);
+	inline VideoImage* image() const { return (slot_[cur_].vi); }
+	inline u_char* pixbuf() const { return (slot_[cur_].pixbuf); }
+	/* the current image now shows frame ts */
+	void done(u_int ts);
+	/* all the images have to be drawn over */
+	void invalidate();
+	/* put part of the current image, as VideoWindow::render() */
+	void present(int miny, int maxy, int minx, int maxx);
+	void flush();
+
+	inline u_int32_t npresent() const { return (npresent_); }
+	inline u_int32_t ndrop() const { return (ndrop_); }
+	/* milliseconds */
+	inline double latency() const {
+		return (ncomplete_ ? latency_ / ncomplete_ : 0.);
+	}
+	inline double maxlatency() const { return (maxlatency_); }
+    protected:
+	static int handle(ClientData, XEvent*);
+	void complete(u_long shmseg);
+
+	struct slot {
+		VideoImage* vi;
+		u_char* pixbuf;
+		u_long shmseg;
+		int pending;	/* puts not yet completed */
+		int valid;	/* false to draw over whole */
+		u_int ts;	/* frame it shows */
+		double sent;	/* time of the last put (ms) */
+	} slot_[IMAGE_RING];
+	int nimage_;
+	int cur_;
+	VideoWindow* vw_;
+	Display* dpy_;
+	int event_;		/* ShmCompletion event type */
+	ImageRing* next_;
+	static ImageRing* rings_;
+
+	u_int32_t npresent_;	/* frames put */
+	u_int32_t ndrop_;	/* frames dropped, the server behind */
+	u_int32_t ncomplete_;
+	double latency_;	/* total */
+	double maxlatency_;
+};
+
 class CaptureWindow : public BareWindow {
     public:
 	CaptureWindow(const char* name, XVisualInfo*);
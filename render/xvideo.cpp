@@ -46,7 +46,7 @@ int vout_ChromaCmp( vlc_fourcc_t i_chroma, vlc_fourcc_t i_amorhc );
 
 void DisplayVideo( Display *p_display, int i_xvport, Window video_window,
 	GC gc, IMAGE_TYPE *p_image, int width, int height, int o_width, int o_height,
-	bool shared_memory );
+	bool shared_memory, bool completion = false );
 
 static int xv_port = -1;
 // how many clients that use xv_port
@@ -481,7 +481,7 @@ IMAGE_TYPE * CreateImage( Display *p_display, EXTRA_ARGS,
 
 void DisplayVideo( Display *p_display, int i_xvport, Window video_window,
 	GC gc, IMAGE_TYPE *p_image, int width, int height, int o_width, int o_height,
-	bool shared_memory )
+	bool shared_memory, bool completion )
 {
 
 
@@ -496,15 +496,21 @@ void DisplayVideo( Display *p_display, int i_xvport, Window video_window,
                        0 /*src_x*/, 0 /*src_y*/,
                        width, height,
                        0 /*dest_x*/, 0 /*dest_y*/, o_width, o_height,
-                       False /* Don't put True here or you'll waste your CPU */ );
+                       completion /* an event when done, in place of the XSync */ );
 #   else
         XShmPutImage( p_display,
                       video_window,
                       gc, p_image,
                       0 /*src_x*/, 0 /*src_y*/, 0 /*dest_x*/, 0 /*dest_y*/,
                       width, height,
-                      False /* Don't put True here ! */ );
+                      completion );
 #   endif
+        if( completion )
+        {
+            /* the ShmCompletion event says when it has been read */
+            XFlush( p_display );
+            return;
+        }
     }
     else
 #endif /* USE_SHM */
@@ -618,6 +624,19 @@ void XRender::displayImage(Window video_window, GC gc, int o_width, int o_height
 	
 }
 
+void XRender::presentImage(Window video_window, GC gc, int o_width, int o_height) const{
+  DisplayVideo( display, xv_port, video_window, gc, yuv_image, i_width, i_height, 
+    o_width, o_height, enable_shm, true );
+}
+
+unsigned long XRender::shmseg() const{
+#ifdef USE_SHM
+  if(enable_shm && yuv_image)
+    return yuv_shminfo.shmseg;
+#endif
+  return 0;
+}
+
 void XRender::release(){
   if(yuv_image) IMAGE_FREE(yuv_image);
   
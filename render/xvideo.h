@@ -62,6 +62,10 @@ class XRender{
     int init(Display *_dpy, vlc_fourcc_t _chroma, Visual *_p_visual=NULL, int _depth=0, int _bytes_per_rgb=3);
     IMAGE_TYPE* createImage(int _width, int _height);
     void displayImage(Window video_window, GC gc, int _o_width, int _o_height) const;    
+    // put without XSync; the server sends a ShmCompletion event for
+    // shmseg() when done with a shared image
+    void presentImage(Window video_window, GC gc, int _o_width, int _o_height) const;
+    unsigned long shmseg() const;
     void release();
     bool enable_shm;
 
@@ -0,0 +1,579 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef vic_yuv_map_h
+#define vic_yuv_map_h
+
+#include "config.h"
+#include <string.h>
+#include "bsd-endian.h"
+
+/*
+ * The colorspace conversion kernel shared by the direct color
+ * renderers (16, 24 and 32 bits per pixel).  There is one kernel,
+ * yuv_map(), parameterized on
+ *
+ *	the pixel format	a class like TruePixel32 below, which knows
+ *				how to make and store one output pixel;
+ *	the chroma layout	420, 422, or 0 to render grayscale;
+ *	the scale		-1 to double the image, 0 for 1:1, and n to
+ *				decimate by 2^n.  YUV_DOWN stands for any
+ *				decimation of 2^3 or more, taken from the
+ *				target at run time.
+ *
+ * Every combination a WindowRenderer can ask for (see index()) is
+ * instantiated by YuvMap<P>::method(), so the inner loops are
+ * compiled with the pixel format and the strides known.
+ *
+ * Each call converts the width x height rectangle of the frame
+ * at `off' (whose column is x) into the matching spot in the target.
+ * The rectangle is made of whole 8x8 blocks.
+ */
+
+#define YUV_DOWN 3
+
+/*
+ * Where the output goes and the geometry of the input frame.
+ */
+struct YuvTarget {
+	u_char* pixbuf;
+	u_int width;		/* of the frame, in pixels */
+	u_int framesize;	/* width * height */
+	int scale;		/* as in WindowRenderer */
+};
+
+/*
+ * Byte i, in memory order, of a word of luma.
+ */
+inline u_int yuv_byte(u_int l, int i)
+{
+#if BYTE_ORDER == LITTLE_ENDIAN
+	return ((l >> (8 * i)) & 0xff);
+#else
+	return ((l >> (24 - 8 * i)) & 0xff);
+#endif
+}
+
+/*
+ * True color: add the luma to a precomputed rgb chroma term
+ * for all three components at once.
+ */
+class TruePixel {
+    public:
+	inline TruePixel(const u_int* uvtab, u_int omask, u_int pmask)
+		: uvtab_(uvtab), omask_(omask), pmask_(pmask) {}
+	inline u_int chroma(u_int u, u_int v) const {
+		return (uvtab_[(u << 8) | v]);
+	}
+	/*
+	 * Underflow & overflow are only possible if both terms have
+	 * the same sign and are indicated by the result having a
+	 * different sign than the terms.  The luma term and sum are
+	 * biased by 128 so a negative number has the 2^7 bit = 0.
+	 * The chroma term is not biased so a negative number has the
+	 * 2^7 bit = 1.  We ignore the carry into the next byte's lsb
+	 * that happens on an overflow/underflow on the grounds that
+	 * it's probably invisible.
+	 */
+	inline u_int color(u_int uv, u_int y) const {
+		u_int l = y;
+		l |= l << 8;
+		l |= l << 16;
+		u_int sum = l + uv;
+		u_int uflo = (l ^ uv) & (l ^ sum) & omask_;
+		if (uflo) {
+			if ((l = uflo & l) != 0) {
+				/* saturate overflow(s) */
+				l |= l >> 1;
+				l |= l >> 2;
+				l |= l >> 4;
+				sum |= l;
+				uflo &=~ l;
+			}
+			if (uflo != 0) {
+				/* zero underflow(s) */
+				uflo |= uflo >> 1;
+				uflo |= uflo >> 2;
+				uflo |= uflo >> 4;
+				sum &=~ uflo;
+			}
+		}
+		return (sum & pmask_);
+	}
+	inline u_int gray(u_int y) const {
+		return ((y << 16) | (y << 8) | y);
+	}
+    protected:
+	const u_int* uvtab_;
+	u_int omask_;
+	u_int pmask_;
+};
+
+class TruePixel32 : public TruePixel {
+    public:
+	inline TruePixel32(const u_int* uvtab, u_int omask, u_int pmask)
+		: TruePixel(uvtab, omask, pmask) {}
+	enum { size = 4 };
+	static inline void put(u_char* p, u_int rgb) {
+		*(u_int*)p = rgb;
+	}
+	inline void put_gray(u_char* p, u_int y) const {
+		put(p, gray(y));
+	}
+	/* four gray pixels from the luma bytes of word l */
+	inline void put4_gray(u_char* p, u_int l) const {
+		put_gray(p, yuv_byte(l, 0));
+		put_gray(p + size, yuv_byte(l, 1));
+		put_gray(p + 2 * size, yuv_byte(l, 2));
+		put_gray(p + 3 * size, yuv_byte(l, 3));
+	}
+	static inline void put4(u_char* p, u_int a, u_int b, u_int c,
+				u_int d) {
+		u_int* w = (u_int*)p;
+		w[0] = a;
+		w[1] = b;
+		w[2] = c;
+		w[3] = d;
+	}
+};
+
+class TruePixel24 : public TruePixel {
+    public:
+	inline TruePixel24(const u_int* uvtab, u_int omask, u_int pmask)
+		: TruePixel(uvtab, omask, pmask) {}
+	enum { size = 3 };
+	static inline void put(u_char* p, u_int rgb) {
+#if BYTE_ORDER == LITTLE_ENDIAN
+		p[0] = rgb;
+		p[1] = rgb >> 8;
+		p[2] = rgb >> 16;
+#else
+		p[0] = rgb >> 16;
+		p[1] = rgb >> 8;
+		p[2] = rgb;
+#endif
+	}
+	/* all three bytes are y, so store them as they are */
+	static inline void put_gray(u_char* p, u_int y) {
+		p[0] = y;
+		p[1] = y;
+		p[2] = y;
+	}
+	/* four gray pixels from the luma bytes of word l, as three words */
+	static inline void put4_gray(u_char* p, u_int l) {
+		u_int* w = (u_int*)p;
+#if BYTE_ORDER == LITTLE_ENDIAN
+		u_int b0 = l & 0xff;
+		u_int b1 = (l >> 8) & 0xff;
+		u_int b2 = (l >> 16) & 0xff;
+		u_int b3 = l >> 24;
+		w[0] = b0 * 0x010101 | b1 << 24;
+		w[1] = b1 * 0x0101 | b2 * 0x01010000;
+		w[2] = b2 | b3 * 0x01010100;
+#else
+		u_int b0 = l >> 24;
+		u_int b1 = (l >> 16) & 0xff;
+		u_int b2 = (l >> 8) & 0xff;
+		u_int b3 = l & 0xff;
+		w[0] = b0 * 0x01010100 | b1;
+		w[1] = b1 * 0x01010000 | b2 * 0x0101;
+		w[2] = b2 << 24 | b3 * 0x010101;
+#endif
+	}
+	/*
+	 * Four pixels fill three words exactly, and p is word
+	 * aligned when it's at a multiple of four pixels.
+	 */
+	static inline void put4(u_char* p, u_int a, u_int b, u_int c,
+				u_int d) {
+		u_int* w = (u_int*)p;
+		a &= 0xffffff;
+		b &= 0xffffff;
+		c &= 0xffffff;
+		d &= 0xffffff;
+#if BYTE_ORDER == LITTLE_ENDIAN
+		w[0] = a | b << 24;
+		w[1] = b >> 8 | c << 16;
+		w[2] = c >> 16 | d << 8;
+#else
+		w[0] = a << 8 | b >> 16;
+		w[1] = b << 16 | c >> 8;
+		w[2] = c << 24 | d;
+#endif
+	}
+};
+
+/*
+ * 16 bit color: one table lookup on 5 bits each of u & v
+ * and 6 bits of y.
+ */
+#define UVINDX(u, v) ((((u) >> 3) << 11) | (((v) >> 3) << 6))
+
+class HiPixel {
+    public:
+	inline HiPixel(const u_short* uvtab)
+		: uvtab_(uvtab), graytab_(uvtab + UVINDX(0x80, 0x80)) {}
+	enum { size = 2 };
+	inline u_int chroma(u_int u, u_int v) const {
+		return (UVINDX(u, v));
+	}
+	inline u_int color(u_int uv, u_int y) const {
+		return (uvtab_[uv | (y >> 2)]);
+	}
+	inline u_int gray(u_int y) const {
+		return (graytab_[y >> 2]);
+	}
+	static inline void put(u_char* p, u_int rgb) {
+		*(u_short*)p = rgb;
+	}
+	inline void put_gray(u_char* p, u_int y) const {
+		put(p, gray(y));
+	}
+	/* four gray pixels from the luma bytes of word l */
+	inline void put4_gray(u_char* p, u_int l) const {
+		put_gray(p, yuv_byte(l, 0));
+		put_gray(p + size, yuv_byte(l, 1));
+		put_gray(p + 2 * size, yuv_byte(l, 2));
+		put_gray(p + 3 * size, yuv_byte(l, 3));
+	}
+	static inline void put4(u_char* p, u_int a, u_int b, u_int c,
+				u_int d) {
+		u_short* w = (u_short*)p;
+		w[0] = a;
+		w[1] = b;
+		w[2] = c;
+		w[3] = d;
+	}
+    protected:
+	const u_short* uvtab_;
+	const u_short* graytab_;	/* the row of uvtab_ for u = v = 128 */
+};
+
+/*
+ * One pixel, in color from luma y and chroma term uv,
+ * or gray from y alone.
+ */
+template <class P, int C>
+inline u_int yuv_pixel(const P& p, u_int uv, u_int y)
+{
+	return (C == 0 ? p.gray(y) : p.color(uv, y));
+}
+
+/*
+ * Store the pixels for luma samples y0 & y1 and the two
+ * interpolated between them and y0's left neighbor e.
+ */
+template <class P, int C>
+inline void yuv_up2(const P& p, u_char* q, u_int uv,
+		    u_int e, u_int y0, u_int y1)
+{
+	P::put4(q, yuv_pixel<P, C>(p, uv, (e + y0) >> 1),
+		yuv_pixel<P, C>(p, uv, y0),
+		yuv_pixel<P, C>(p, uv, (y0 + y1) >> 1),
+		yuv_pixel<P, C>(p, uv, y1));
+}
+
+/*
+ * Convert four pixels at 1:1 from the luma in l, the first
+ * two with chroma term uv0 and the others with uv1.
+ */
+template <class P, int C>
+inline void yuv_four(const P& p, u_char* q, u_int l, u_int uv0, u_int uv1)
+{
+	P::put4(q, yuv_pixel<P, C>(p, uv0, yuv_byte(l, 0)),
+		yuv_pixel<P, C>(p, uv0, yuv_byte(l, 1)),
+		yuv_pixel<P, C>(p, uv1, yuv_byte(l, 2)),
+		yuv_pixel<P, C>(p, uv1, yuv_byte(l, 3)));
+}
+
+/*
+ * Convert one row at 1:1, eight pixels at a time.  The luma
+ * is read a word at a time (y is aligned), and before any of
+ * the stores, since the compiler has to assume they might
+ * overlap.
+ */
+template <class P, int C>
+inline void yuv_row(const P& p, u_char* q, const u_char* y,
+		    const u_char* u, const u_char* v, u_int width)
+{
+	for (u_int n = width >> 3; n > 0; --n) {
+		u_int l0 = ((const u_int*)y)[0];
+		u_int l1 = ((const u_int*)y)[1];
+		yuv_four<P, C>(p, q, l0, p.chroma(u[0], v[0]),
+			       p.chroma(u[1], v[1]));
+		yuv_four<P, C>(p, q + 4 * P::size, l1, p.chroma(u[2], v[2]),
+			       p.chroma(u[3], v[3]));
+		y += 8;
+		u += 4;
+		v += 4;
+		q += 8 * P::size;
+	}
+}
+
+/*
+ * Convert the two rows at y and y + iw that share a row of
+ * 4:2:0 chroma at 1:1, so each chroma term is looked up once
+ * for four pixels.  ow is the distance between the output rows.
+ */
+template <class P>
+inline void yuv_row420(const P& p, u_char* q, u_int ow, const u_char* y,
+		       u_int iw, const u_char* u, const u_char* v,
+		       u_int width)
+{
+	for (u_int n = width >> 3; n > 0; --n) {
+		u_int l0 = *(const u_int*)y;
+		u_int l1 = *(const u_int*)(y + iw);
+		u_int uv0 = p.chroma(u[0], v[0]);
+		u_int uv1 = p.chroma(u[1], v[1]);
+		yuv_four<P, 420>(p, q, l0, uv0, uv1);
+		yuv_four<P, 420>(p, q + ow, l1, uv0, uv1);
+		l0 = *(const u_int*)(y + 4);
+		l1 = *(const u_int*)(y + iw + 4);
+		uv0 = p.chroma(u[2], v[2]);
+		uv1 = p.chroma(u[3], v[3]);
+		yuv_four<P, 420>(p, q + 4 * P::size, l0, uv0, uv1);
+		yuv_four<P, 420>(p, q + ow + 4 * P::size, l1, uv0, uv1);
+		y += 8;
+		u += 4;
+		v += 4;
+		q += 8 * P::size;
+	}
+}
+
+/*
+ * Convert one row of gray at 1:1 or decimated by 2 or 4.  As
+ * in the old per-depth kernels, the second word of luma is
+ * read after the first word's pixels are stored, and only
+ * 24 bit pixels are packed into words: with no chroma to look
+ * up, packing (or letting the compiler vectorize the row)
+ * costs more than it saves.
+ */
+template <class P, int S>
+inline void yuv_gray_row(const P& p, u_char* q, const u_char* y,
+			 u_int width)
+{
+	for (u_int n = width >> 3; n > 0; --n) {
+		u_int l;
+		if (S == 0) {
+			p.put4_gray(q, ((const u_int*)y)[0]);
+			p.put4_gray(q + 4 * P::size, ((const u_int*)y)[1]);
+		} else if (S == 1) {
+			l = ((const u_int*)y)[0];
+			p.put_gray(q, yuv_byte(l, 0));
+			p.put_gray(q + P::size, yuv_byte(l, 2));
+			l = ((const u_int*)y)[1];
+			p.put_gray(q + 2 * P::size, yuv_byte(l, 0));
+			p.put_gray(q + 3 * P::size, yuv_byte(l, 2));
+		} else {
+			p.put_gray(q, y[0]);
+			p.put_gray(q + P::size, y[4]);
+		}
+		y += 8;
+		q += (S == 0 ? 8 : S == 1 ? 4 : 2) * P::size;
+	}
+}
+
+template <class P, int C, int S>
+void yuv_map(const P& p, const YuvTarget& t, const u_char* frm,
+	     u_int off, u_int x, u_int width, u_int height)
+{
+	const int s = (S < YUV_DOWN) ? S : t.scale;
+	const u_int iw = t.width;
+	const u_int cw = iw >> 1;
+	const u_char* yp = frm + off;
+	const u_char* up;
+	const u_char* vp;
+	if (C == 420) {
+		up = frm + t.framesize + ((off - x) >> 2) + (x >> 1);
+		vp = up + (t.framesize >> 2);
+	} else {
+		up = frm + t.framesize + (off >> 1);
+		vp = up + (t.framesize >> 1);
+	}
+	u_int uv = 0;
+
+	if (s < 0) {
+		/* each row is done once and then copied to the next */
+		const u_int ow = (iw << 1) * P::size;
+		u_char* o = t.pixbuf + P::size * (((off - x) << 2) + (x << 1));
+		for (u_int row = 0; row < height; ++row) {
+			const u_char* y = yp;
+			const u_char* u = up;
+			const u_char* v = vp;
+			u_char* q = o;
+			u_int e = y[0];
+			for (u_int n = width >> 1; n > 0; --n) {
+				u_int y0 = y[0];
+				u_int y1 = y[1];
+				if (C != 0)
+					uv = p.chroma(*u++, *v++);
+				yuv_up2<P, C>(p, q, uv, e, y0, y1);
+				e = y1;
+				y += 2;
+				q += 4 * P::size;
+			}
+			memcpy(o + ow, o, 2 * width * P::size);
+			yp += iw;
+			o += 2 * ow;
+			if (C == 422 || (row & 1) != 0) {
+				up += cw;
+				vp += cw;
+			}
+		}
+	} else if (s == 0) {
+		const u_int ow = iw * P::size;
+		u_char* o = t.pixbuf + P::size * off;
+		for (u_int row = 0; row < height; ++row) {
+			if (C == 0)
+				yuv_gray_row<P, 0>(p, o, yp, width);
+			else if (C == 420) {
+				yuv_row420<P>(p, o, ow, yp, iw, up, vp, width);
+				yp += iw;
+				o += ow;
+				++row;
+			} else
+				yuv_row<P, C>(p, o, yp, up, vp, width);
+			yp += iw;
+			o += ow;
+			if (C == 422 || (row & 1) != 0) {
+				up += cw;
+				vp += cw;
+			}
+		}
+	} else {
+		/* decimate: take the top left pixel of each 2^s square */
+		const u_int step = 1 << s;
+		const u_int ow = (iw >> s) * P::size;
+		const u_int cstride = (C == 420) ? cw << (s - 1) : cw << s;
+		u_char* o = t.pixbuf + P::size *
+			(((off - x) >> (s + s)) + (x >> s));
+		for (u_int row = 0; row < height; row += step) {
+			const u_char* y = yp;
+			const u_char* u = up;
+			const u_char* v = vp;
+			u_char* q = o;
+			if (C == 0 && S <= 2) {
+				yuv_gray_row<P, S>(p, q, y, width);
+			} else if (S == 1) {
+				/* every other pixel of two words of luma */
+				for (u_int n = width >> 3; n > 0; --n) {
+					u_int l0 = ((const u_int*)y)[0];
+					u_int l1 = ((const u_int*)y)[1];
+					u_int uv0 = 0, uv1 = 0, uv2 = 0, uv3 = 0;
+					if (C != 0) {
+						uv0 = p.chroma(u[0], v[0]);
+						uv1 = p.chroma(u[1], v[1]);
+						uv2 = p.chroma(u[2], v[2]);
+						uv3 = p.chroma(u[3], v[3]);
+					}
+					P::put4(q, yuv_pixel<P, C>(p, uv0,
+							yuv_byte(l0, 0)),
+						yuv_pixel<P, C>(p, uv1,
+							yuv_byte(l0, 2)),
+						yuv_pixel<P, C>(p, uv2,
+							yuv_byte(l1, 0)),
+						yuv_pixel<P, C>(p, uv3,
+							yuv_byte(l1, 2)));
+					y += 8;
+					u += 4;
+					v += 4;
+					q += 4 * P::size;
+				}
+			} else if (S == 2) {
+				/* two pixels per 8 luma, one at a time */
+				for (u_int n = width >> 3; n > 0; --n) {
+					P::put(q, p.color(p.chroma(u[0], v[0]),
+							  y[0]));
+					P::put(q + P::size,
+					       p.color(p.chroma(u[2], v[2]),
+						       y[4]));
+					y += 8;
+					u += 4;
+					v += 4;
+					q += 2 * P::size;
+				}
+			} else {
+				for (u_int n = width >> s; n > 0; --n) {
+					if (C != 0)
+						uv = p.chroma(*u, *v);
+					P::put(q, yuv_pixel<P, C>(p, uv, *y));
+					y += step;
+					u += step >> 1;
+					v += step >> 1;
+					q += P::size;
+				}
+			}
+			yp += iw << s;
+			up += cstride;
+			vp += cstride;
+			o += ow;
+		}
+	}
+}
+
+/*
+ * The kernels in the order of WindowRenderer::index().
+ */
+template <class P>
+class YuvMap {
+    public:
+	typedef void (*Method)(const P&, const YuvTarget&, const u_char*,
+			       u_int, u_int, u_int, u_int);
+	static Method method(int index);
+};
+
+template <class P>
+typename YuvMap<P>::Method YuvMap<P>::method(int index)
+{
+	static const Method methods[] = {
+		&yuv_map<P, 420, -1>,
+		&yuv_map<P, 422, -1>,
+		&yuv_map<P, 0, -1>,
+		&yuv_map<P, 0, -1>,
+		&yuv_map<P, 420, 0>,
+		&yuv_map<P, 422, 0>,
+		&yuv_map<P, 0, 0>,
+		&yuv_map<P, 0, 0>,
+		&yuv_map<P, 420, 1>,
+		&yuv_map<P, 422, 1>,
+		&yuv_map<P, 0, 1>,
+		&yuv_map<P, 0, 1>,
+		&yuv_map<P, 420, 2>,
+		&yuv_map<P, 422, 2>,
+		&yuv_map<P, 0, 2>,
+		&yuv_map<P, 0, 2>,
+		&yuv_map<P, 420, YUV_DOWN>,
+		&yuv_map<P, 422, YUV_DOWN>,
+		&yuv_map<P, 0, YUV_DOWN>,
+		&yuv_map<P, 0, YUV_DOWN>,
+	};
+	return (methods[index]);
+}
+
+#endif
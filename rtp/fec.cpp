@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "rtp.h"
+#include "fec.h"
+
+/*
+ * An SSE2 version of the XOR, which runs for every byte sent and
+ * received.  On gcc it is compiled for SSE2 even when the rest of
+ * the file isn't, and is only called if the cpu turns out to have
+ * it (see fec_simd()).
+ */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define FEC_SSE2 __attribute__((target("sse2")))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define FEC_SSE2
+#endif
+
+#ifdef FEC_SSE2
+#include <emmintrin.h>
+#ifdef RUNTIME_CPUDETECT
+extern "C" {
+#include "cpu/cpudetect.h"
+}
+#endif
+#endif
+
+static int simd_ = -1;
+
+void fec_simd(int on)
+{
+	simd_ = 0;
+#ifdef FEC_SSE2
+	if (on) {
+#ifdef RUNTIME_CPUDETECT
+		simd_ = (cpu_check() & FF_CPU_SSE2) != 0;
+#elif defined(__SSE2__) || defined(_M_X64)
+		simd_ = 1;
+#endif
+	}
+#else
+	UNUSED(on);
+#endif
+}
+
+int fec_simd()
+{
+	if (simd_ < 0)
+		fec_simd(1);
+	return (simd_);
+}
+
+static void xor_c(u_char* dst, const u_char* src, int len)
+{
+	const u_long mask = sizeof(u_long) - 1;
+	if ((((u_long)dst ^ (u_long)src) & mask) == 0) {
+		/* (payloads start 12 bytes in, so both are off alike) */
+		for (; len > 0 && ((u_long)dst & mask) != 0; --len)
+			*dst++ ^= *src++;
+		for (; len >= int(sizeof(u_long)); len -= sizeof(u_long)) {
+			*(u_long*)dst ^= *(const u_long*)src;
+			dst += sizeof(u_long);
+			src += sizeof(u_long);
+		}
+	}
+	while (--len >= 0)
+		*dst++ ^= *src++;
+}
+
+#ifdef FEC_SSE2
+FEC_SSE2
+static void xor_sse2(u_char* dst, const u_char* src, int len)
+{
+	for (; len >= 64; len -= 64, dst += 64, src += 64) {
+		__m128i a0 = _mm_loadu_si128((const __m128i*)dst);
+		__m128i a1 = _mm_loadu_si128((const __m128i*)(dst + 16));
+		__m128i a2 = _mm_loadu_si128((const __m128i*)(dst + 32));
+		__m128i a3 = _mm_loadu_si128((const __m128i*)(dst + 48));
+		a0 = _mm_xor_si128(a0, _mm_loadu_si128((const __m128i*)src));
+		a1 = _mm_xor_si128(a1,
+			_mm_loadu_si128((const __m128i*)(src + 16)));
+		a2 = _mm_xor_si128(a2,
+			_mm_loadu_si128((const __m128i*)(src + 32)));
+		a3 = _mm_xor_si128(a3,
+			_mm_loadu_si128((const __m128i*)(src + 48)));
+		_mm_storeu_si128((__m128i*)dst, a0);
+		_mm_storeu_si128((__m128i*)(dst + 16), a1);
+		_mm_storeu_si128((__m128i*)(dst + 32), a2);
+		_mm_storeu_si128((__m128i*)(dst + 48), a3);
+	}
+	for (; len >= 16; len -= 16, dst += 16, src += 16)
+		_mm_storeu_si128((__m128i*)dst,
+			_mm_xor_si128(_mm_loadu_si128((const __m128i*)dst),
+				      _mm_loadu_si128((const __m128i*)src)));
+	while (--len >= 0)
+		*dst++ ^= *src++;
+}
+#endif
+
+void fec_xor(u_char* dst, const u_char* src, int len)
+{
+#ifdef FEC_SSE2
+	if (fec_simd()) {
+		xor_sse2(dst, src, len);
+		return;
+	}
+#endif
+	xor_c(dst, src, len);
+}
+
+FecEncoder::FecEncoder(int k, int pt, u_int32_t ssrc)
+	: k_(k), pt_(pt), ssrc_(ssrc), seqno_(1), n_(0), base_(0), flags_(0), ts_(0),
+	  len_(0), maxlen_(0)
+{
+	if (k_ > FEC_MAXBLOCK)
+		k_ = FEC_MAXBLOCK;
+}
+
+pktbuf* FecEncoder::protect(const pktbuf* pb)
+{
+	const rtphdr* rh = (const rtphdr*)pb->dp;
+	int flags = ntohs(rh->rh_flags);
+	int len = pb->len - sizeof(*rh);
+	if (n_ == 0) {
+		base_ = ntohs(rh->rh_seqno);
+		flags_ = 0;
+		ts_ = 0;
+		len_ = 0;
+		maxlen_ = 0;
+	}
+	if (len > maxlen_) {
+		/* shorter payloads are padded with zeros */
+		memset(par_ + maxlen_, 0, len - maxlen_);
+		maxlen_ = len;
+	}
+	flags_ ^= flags;
+	ts_ ^= rh->rh_ts;
+	len_ ^= len;
+	fec_xor(par_, pb->dp + sizeof(*rh), len);
+	if (++n_ < k_ && (flags & RTP_M) == 0)
+		return (0);
+
+	pktbuf* fp = pb->manager->alloc(pb->layer);
+	rtphdr* fh = (rtphdr*)fp->dp;
+	fh->rh_flags = htons(RTP_VERSION << 14 | pt_);
+	fh->rh_seqno = htons(seqno_++);
+	fh->rh_ts = rh->rh_ts;
+	fh->rh_ssrc = ssrc_;
+	u_char* p = (u_char*)(fh + 1);
+	/* E and L clear: no extension, 16 bit mask */
+	p[0] = flags_ >> 8 & 0x3f;
+	p[1] = flags_;
+	*(u_int16_t*)(p + 2) = htons(base_);
+	memcpy(p + 4, &ts_, 4);
+	*(u_int16_t*)(p + 8) = htons(len_);
+	*(u_int16_t*)(p + 10) = htons(maxlen_);
+	*(u_int16_t*)(p + 12) = htons(u_int16_t(0xffff << (16 - n_)));
+	memcpy(p + FEC_HDRLEN, par_, maxlen_);
+	fp->len = sizeof(*fh) + FEC_HDRLEN + maxlen_;
+	n_ = 0;
+	return (fp);
+}
+
+FecDecoder::FecDecoder(u_int32_t ssrc)
+	: ssrc_(ssrc), newest_(-1), npending_(0), nrecovered_(0)
+{
+	memset(win_, 0, sizeof(win_));
+}
+
+FecDecoder::~FecDecoder()
+{
+	for (int i = 0; i < FEC_WINDOW; ++i)
+		if (win_[i].pb != 0)
+			win_[i].pb->release();
+	while (npending_ > 0)
+		drop(0);
+}
+
+void FecDecoder::keep(pktbuf* pb)
+{
+	u_int16_t seqno = ntohs(((rtphdr*)pb->dp)->rh_seqno);
+	slot* s = &win_[seqno & (FEC_WINDOW - 1)];
+	pb->attach();
+	if (s->pb != 0)
+		s->pb->release();
+	s->pb = pb;
+	s->seqno = seqno;
+	if (newest_ < 0 || short(seqno - newest_) > 0)
+		newest_ = seqno;
+}
+
+pktbuf* FecDecoder::lookup(u_int16_t seqno) const
+{
+	const slot* s = &win_[seqno & (FEC_WINDOW - 1)];
+	return (s->pb != 0 && s->seqno == seqno ? s->pb : 0);
+}
+
+void FecDecoder::drop(int i)
+{
+	pending_[i]->release();
+	--npending_;
+	memmove(&pending_[i], &pending_[i + 1],
+		(npending_ - i) * sizeof(pending_[0]));
+}
+
+void FecDecoder::parity(pktbuf* pb)
+{
+	if (npending_ == FEC_MAXPENDING)
+		drop(0);
+	pending_[npending_++] = pb;
+}
+
+pktbuf* FecDecoder::recover(BufferPool* pool)
+{
+	for (int i = 0; i < npending_; ) {
+		pktbuf* fp = pending_[i];
+		const rtphdr* fh = (const rtphdr*)fp->dp;
+		const u_char* p = (const u_char*)(fh + 1);
+		int plen = p[10] << 8 | p[11];
+		u_int16_t base = p[2] << 8 | p[3];
+		int mask = p[12] << 8 | p[13];
+		if (fp->len < int(sizeof(*fh)) + FEC_HDRLEN ||
+		    fp->len < int(sizeof(*fh)) + FEC_HDRLEN + plen ||
+		    (p[0] & 0xc0) != 0 ||
+		    (newest_ >= 0 && short(newest_ - base) >= FEC_WINDOW)) {
+			/* bad, a kind we don't do, or too old */
+			drop(i);
+			continue;
+		}
+		int nmissing = 0;
+		u_int16_t missing = 0;
+		int k;
+		for (k = 0; k < 16; ++k) {
+			if ((mask & 0x8000 >> k) != 0 &&
+			    lookup(base + k) == 0) {
+				++nmissing;
+				missing = base + k;
+			}
+		}
+		if (nmissing != 1) {
+			/* nothing to do, or not yet */
+			if (nmissing == 0)
+				drop(i);
+			else
+				++i;
+			continue;
+		}
+
+		pktbuf* rb = pool->alloc(fp->layer);
+		int flags = p[0] << 8 | p[1];
+		u_int32_t ts;
+		memcpy(&ts, p + 4, 4);
+		int len = p[8] << 8 | p[9];
+		memcpy(rb->dp + sizeof(rtphdr), p + FEC_HDRLEN, plen);
+		for (k = 0; k < 16; ++k) {
+			if ((mask & 0x8000 >> k) == 0 ||
+			    u_int16_t(base + k) == missing)
+				continue;
+			const pktbuf* q = lookup(base + k);
+			const rtphdr* qh = (const rtphdr*)q->dp;
+			int qlen = q->len - sizeof(rtphdr);
+			flags ^= ntohs(qh->rh_flags);
+			ts ^= qh->rh_ts;
+			len ^= qlen;
+			fec_xor(rb->dp + sizeof(rtphdr),
+				q->dp + sizeof(rtphdr), qlen < plen ? qlen : plen);
+		}
+		rtphdr* rh = (rtphdr*)rb->dp;
+		rh->rh_flags = htons(RTP_VERSION << 14 | (flags & 0x3fff));
+		rh->rh_seqno = htons(missing);
+		rh->rh_ts = ts;
+		rh->rh_ssrc = ssrc_;
+		rb->len = sizeof(rtphdr) + len;
+		drop(i);
+		if (len > plen) {
+			rb->release();
+			continue;
+		}
+		++nrecovered_;
+		return (rb);
+	}
+	return (0);
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef vic_fec_h
+#define vic_fec_h
+
+#include "config.h"
+#include "pktbuf.h"
+
+/*
+ * Forward error correction by XOR parity (RFC 5109, ULP level 0
+ * only).  The sender follows each block of up to k media packets,
+ * and each end of frame, with a parity packet: the XOR of the
+ * packets' payloads and of the header fields that a lost packet
+ * would need back (P, X, CC, M, PT, timestamp and length), with the
+ * first sequence number and a mask of the packets covered.  The
+ * receiver keeps the media packets last in, and when all but one of
+ * the packets under a parity packet are there, XORs it back.
+ *
+ * The parity packets are a stream of their own, with an ssrc,
+ * payload type and sequence numbers apart from the media, as
+ * retransmissions are (see rtx.h).  The receiver ties the stream to
+ * its media source by the sequence numbers it covers.
+ */
+
+#define FEC_HDRLEN	14	/* fec header and level 0 header */
+#define FEC_MAXBLOCK	16	/* packets one parity packet covers */
+#define FEC_WINDOW	64	/* media packets kept for recovery (power of 2) */
+#define FEC_MAXPENDING	8	/* parity packets waiting for more to come in */
+
+/* dst ^= src */
+void fec_xor(u_char* dst, const u_char* src, int len);
+/* use the SSE2 XOR if on and the cpu has it */
+void fec_simd(int on);
+int fec_simd();
+
+class FecEncoder {
+    public:
+	FecEncoder(int k, int pt, u_int32_t ssrc);
+	inline int block() const { return (k_); }
+	/*
+	 * Add media packet pb to the block.  Returns the parity
+	 * packet when that makes the block complete, else 0.
+	 */
+	pktbuf* protect(const pktbuf* pb);
+    protected:
+	int k_;
+	int pt_;
+	u_int32_t ssrc_;	/* of the parity packets (net order) */
+	u_int16_t seqno_;
+	int n_;			/* packets in the block so far */
+	u_int16_t base_;	/* seqno of the first */
+	u_int16_t flags_;	/* the XORs of their fields */
+	u_int32_t ts_;
+	u_int16_t len_;
+	int maxlen_;		/* longest payload */
+	u_char par_[PKTBUF_SIZE];
+};
+
+class FecDecoder {
+    public:
+	/* for the media of ssrc (net order) */
+	FecDecoder(u_int32_t ssrc);
+	~FecDecoder();
+	/* media packet pb came in; holds a reference to it */
+	void keep(pktbuf* pb);
+	/* parity packet pb came in; takes over the caller's reference */
+	void parity(pktbuf* pb);
+	/*
+	 * A media packet rebuilt into a fresh buffer from pool, or 0
+	 * if none can be.  Call again until it returns 0.
+	 */
+	pktbuf* recover(BufferPool* pool);
+	inline u_int32_t nrecovered() const { return (nrecovered_); }
+    protected:
+	pktbuf* lookup(u_int16_t seqno) const;
+	void drop(int i);
+
+	struct slot {
+		pktbuf* pb;
+		u_int16_t seqno;
+	};
+	u_int32_t ssrc_;
+	slot win_[FEC_WINDOW];
+	int newest_;		/* highest seqno in, or -1 */
+	pktbuf* pending_[FEC_MAXPENDING];
+	int npending_;
+	u_int32_t nrecovered_;
+};
+
+#endif
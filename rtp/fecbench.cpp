@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * fecbench - time the fec parity coder and recovery, C and SSE2,
+ * at video rates.
+ *
+ * usage: fecbench [-r mbps[,mbps...]] [-k block] [-l loss] [-b burst]
+ *		   [-s size] [-f fps] [-t time] [-S seed]
+ *
+ * For each rate in `mbps' (10, 50 and 100) `time' seconds (10) of
+ * packets of `size' bytes (1000) are protected as the Transmitter
+ * does it, with a parity packet after each `block' packets (10) and
+ * each of the `fps' (30) frames a second.  The packets, parity
+ * included, are then lost at `loss' percent (1) in bursts of
+ * `burst' (1) on average, and the rest go through recovery as
+ * SessionManager does it.  Every recovered packet is checked against
+ * the one sent.
+ *
+ * Printed are the time spent coding and recovering, as a share of
+ * real time, the packets lost and recovered, and the overhead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../config.h"
+#include "../bench.h"
+#include "rtp.h"
+#include "fec.h"
+
+#define CHUNK 1024
+
+static bench_loss gilbert;
+
+struct result {
+	double tenc;
+	double tdec;
+	int nmedia;
+	int nparity;
+	double bmedia;
+	double bparity;
+	int lost;
+	int recovered;
+	int bad;
+};
+
+static void run(double mbps, int k, int size, int fps, double duration,
+		long seed, result& r)
+{
+	memset(&r, 0, sizeof(r));
+	srand48(seed);
+	BufferPool pool;
+	FecEncoder fe(k, RTP_PT_ULPFEC, 0x9abcdef0);
+	FecDecoder fd(0x12345678);
+	int state = 0;
+	int npkt = int(mbps * 1e6 * duration / (8. * size));
+	int perframe = int(mbps * 1e6 / (8. * size * fps));
+	if (perframe < 1)
+		perframe = 1;
+	u_int32_t seed32 = seed;
+
+	pktbuf* sent[2 * CHUNK];
+	pktbuf* media[65536];
+	memset(media, 0, sizeof(media));
+	for (int n = 0; n < npkt; ) {
+		int m = npkt - n < CHUNK ? npkt - n : CHUNK;
+		/* what the encoder hands over */
+		int i;
+		for (i = 0; i < m; ++i) {
+			pktbuf* pb = pool.alloc();
+			rtphdr* rh = (rtphdr*)pb->dp;
+			int s = n + i;
+			int flags = RTP_VERSION << 14 | RTP_PT_H261;
+			if (s % perframe == perframe - 1)
+				flags |= RTP_M;
+			rh->rh_flags = htons(flags);
+			rh->rh_seqno = htons(s);
+			rh->rh_ts = htonl(s / perframe * 3000);
+			rh->rh_ssrc = 0x12345678;
+			/* the last packet of a frame is shorter */
+			pb->len = (flags & RTP_M) ? size / 2 + (s & 63) : size;
+			for (int j = sizeof(*rh); j < pb->len; ++j) {
+				seed32 = seed32 * 1103515245 + 12345;
+				pb->dp[j] = seed32 >> 24;
+			}
+			sent[i] = pb;
+		}
+		/* protect them */
+		pktbuf* out[2 * CHUNK];
+		int nout = 0;
+		double t = bench_now();
+		for (i = 0; i < m; ++i) {
+			out[nout++] = sent[i];
+			pktbuf* fp = fe.protect(sent[i]);
+			if (fp != 0)
+				out[nout++] = fp;
+		}
+		r.tenc += bench_now() - t;
+
+		/* the network */
+		int nin = 0;
+		for (i = 0; i < nout; ++i) {
+			pktbuf* pb = out[i];
+			int parity = (pb->dp[1] & 0x7f) == RTP_PT_ULPFEC;
+			if (parity) {
+				++r.nparity;
+				r.bparity += pb->len;
+			} else {
+				++r.nmedia;
+				r.bmedia += pb->len;
+				int s = ntohs(((rtphdr*)pb->dp)->rh_seqno);
+				if (media[s & 0xffff] != 0)
+					media[s & 0xffff]->release();
+				pb->attach();
+				media[s & 0xffff] = pb;
+			}
+			if (bench_lose(&gilbert, &state)) {
+				if (!parity)
+					++r.lost;
+				pb->release();
+			} else
+				out[nin++] = pb;
+		}
+
+		/* and the receiver */
+		pktbuf* rec[2 * CHUNK];
+		int nrec = 0;
+		t = bench_now();
+		for (i = 0; i < nin; ++i) {
+			pktbuf* pb = out[i];
+			if ((pb->dp[1] & 0x7f) == RTP_PT_ULPFEC)
+				fd.parity(pb);
+			else {
+				fd.keep(pb);
+				pb->release();
+			}
+			pktbuf* rb;
+			while ((rb = fd.recover(&pool)) != 0) {
+				fd.keep(rb);
+				rec[nrec++] = rb;
+			}
+		}
+		r.tdec += bench_now() - t;
+
+		for (i = 0; i < nrec; ++i) {
+			pktbuf* rb = rec[i];
+			int s = ntohs(((rtphdr*)rb->dp)->rh_seqno);
+			pktbuf* pb = media[s];
+			if (pb == 0 || pb->len != rb->len ||
+			    memcmp(pb->dp, rb->dp, pb->len) != 0)
+				++r.bad;
+			++r.recovered;
+			rb->release();
+		}
+		n += m;
+	}
+	for (int s = 0; s < 65536; ++s)
+		if (media[s] != 0)
+			media[s]->release();
+}
+
+static const char synopsis[] =
+	"fecbench [-r mbps[,mbps...]] [-k block] "
+	"[-l loss] [-b burst]\n\t\t[-s size] [-f fps] [-t time] "
+	"[-S seed]\n";
+
+int main(int argc, char** argv)
+{
+	double rate[16];
+	int nrate = 3;
+	rate[0] = 10.;
+	rate[1] = 50.;
+	rate[2] = 100.;
+	int k = 10;
+	double loss = 1.;
+	double burst = 1.;
+	int size = 1000;
+	int fps = 30;
+	double duration = 10.;
+	long seed = 1;
+	int op;
+	while ((op = getopt(argc, argv, "r:k:l:b:s:f:t:S:")) != -1) {
+		switch (op) {
+		case 'r':
+			nrate = 0;
+			for (char* p = strtok(optarg, ","); p != 0 && nrate < 16;
+			     p = strtok(0, ","))
+				rate[nrate++] = atof(p);
+			break;
+		case 'k':
+			k = atoi(optarg);
+			break;
+		case 'l':
+			loss = atof(optarg);
+			break;
+		case 'b':
+			burst = atof(optarg);
+			break;
+		case 's':
+			size = atoi(optarg);
+			break;
+		case 'f':
+			fps = atoi(optarg);
+			break;
+		case 't':
+			duration = atof(optarg);
+			break;
+		case 'S':
+			seed = atol(optarg);
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind != argc || nrate == 0 || k < 1 || k > FEC_MAXBLOCK ||
+	    loss < 0. || loss >= 100. || burst < 1. || fps < 1 ||
+	    size < int(sizeof(rtphdr)) + 64 || size > RTP_MTU ||
+	    duration <= 0.)
+		bench_usage(synopsis);
+	for (int i = 0; i < nrate; ++i)
+		if (rate[i] <= 0.)
+			bench_usage(synopsis);
+	bench_loss_init(&gilbert, loss, burst);
+
+	printf("block %d, %d byte packets, loss %.1f%% (burst %.1f), "
+	       "%.0f s each\n", k, size, loss, burst, duration);
+	printf("%6s %5s %9s %9s %7s %8s %9s %9s %8s\n", "Mb/s", "xor",
+	       "enc %cpu", "dec %cpu", "lost", "recov", "residual",
+	       "overhead", "MB/s");
+	const char* name[2] = { "c", "sse2" };
+	int bad = 0;
+	for (int i = 0; i < nrate; ++i) {
+		for (int simd = 0; simd < 2; ++simd) {
+			fec_simd(simd);
+			if (simd && !fec_simd())
+				break;
+			result r;
+			run(rate[i], k, size, fps, duration, seed, r);
+			double bytes = r.bmedia + r.bparity;
+			printf("%6.0f %5s %8.3f%% %8.3f%% %7d %8d %8.3f%% "
+			       "%8.1f%% %9.0f\n", rate[i], name[simd],
+			       100. * r.tenc / duration,
+			       100. * r.tdec / duration, r.lost, r.recovered,
+			       100. * (r.lost - r.recovered) / r.nmedia,
+			       100. * r.bparity / r.bmedia,
+			       bytes / 1e6 / (r.tenc + r.tdec));
+			bad += r.bad;
+		}
+	}
+	if (!fec_simd())
+		printf("(no sse2)\n");
+	if (bad != 0) {
+		printf("%d recovered packets differ from the ones sent\n", bad);
+		return (1);
+	}
+	return (0);
+}
@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * keybench - time the recovery from loss of a predictive codec,
+ * with and without key frame requests, over emulated lossy paths.
+ *
+ * usage: keybench [-n receivers] [-l loss] [-b burst] [-d delay]
+ *		   [-f fps] [-p packets] [-k factor] [-g keyint]
+ *		   [-r kbps] [-t time] [-S seed]
+ *
+ * A sender sends `fps' (20) frames a second for `time' seconds (60)
+ * to `receivers' (10) receivers, each over a path of its own with a
+ * one-way delay of `delay' ms (40) that loses `loss' percent (1) of
+ * the packets both ways, in bursts of `burst' packets on average (1;
+ * a Gilbert model).  A frame is `packets' packets (4), a key frame
+ * `factor' (5) times that, and every `keyint'th frame (50) is a key
+ * frame.  A receiver that loses part of a frame holds frames with a
+ * KeyWait until a key frame comes in, as the H.264 and MPEG-4
+ * decoders do; with requests on it sends PLIs as they do, and the
+ * sender forces key frames through a KeyLimiter as SessionManager
+ * does.  A PLI goes as SessionManager sends it: in an early packet
+ * after a random wait of up to half the report interval, or with the
+ * next regular report if this interval's early packet is used, and
+ * not at all if another receiver's PLI is heard first (RFC 4585 3.5).
+ * The report interval is that of RFC 3550 for a session of `kbps'
+ * (1000) with the receivers' share, but no less than the reduced
+ * minimum of 360 / `kbps' seconds.
+ *
+ * Printed for each mode are the times from damage to decoding again,
+ * the share of time the receivers showed a frozen picture, the
+ * requests sent and key frames forced, and the packets sent.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../config.h"
+#include "../bench.h"
+#include "keyframe.h"
+
+/* events, in time order */
+enum { FRAME, RECV, PLI, TIMER, EARLY, REPORT, HEARD };
+struct event {
+	double t;
+	int type;
+	int rcvr;
+	int key;
+	int lost;
+};
+
+static event* heap;
+static int nheap;
+static int maxheap;
+
+static void push(const event& e)
+{
+	if (nheap == maxheap) {
+		maxheap = maxheap ? 2 * maxheap : 1024;
+		heap = (event*)realloc(heap, maxheap * sizeof(event));
+	}
+	int i = nheap++;
+	while (i > 0 && heap[(i - 1) / 2].t > e.t) {
+		heap[i] = heap[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	heap[i] = e;
+}
+
+static event pop()
+{
+	event e = heap[0];
+	event last = heap[--nheap];
+	int i = 0;
+	for (;;) {
+		int c = 2 * i + 1;
+		if (c >= nheap)
+			break;
+		if (c + 1 < nheap && heap[c + 1].t < heap[c].t)
+			++c;
+		if (heap[c].t >= last.t)
+			break;
+		heap[i] = heap[c];
+		i = c;
+	}
+	heap[i] = last;
+	return (e);
+}
+
+static bench_loss gilbert;
+
+#define RTCP_SIZE	100.	/* bytes in a receiver's report */
+
+/* a receiver's early feedback, as SessionManager keeps it */
+struct feedback {
+	int early;		/* true if an early packet may go */
+	double fbt;		/* when it goes, or < 0 */
+	int pli;		/* true if a PLI is to go */
+};
+
+struct result {
+	double* recovery;	/* seconds, each time */
+	int nrecovery;
+	double frozen;		/* receiver seconds */
+	u_int32_t npli;
+	u_int32_t nforced;
+	double npkt;
+	double nkeypkt;
+};
+
+static int cmp(const void* a, const void* b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x < y ? -1 : x > y);
+}
+
+/*
+ * Receiver i sends its PLI: to the sender, and to the other receivers,
+ * whose own it stands for.
+ */
+static void send_pli(int i, int nrcvr, double now, double delay, int* rev,
+		     feedback* fb, result& r)
+{
+	fb[i].pli = 0;
+	++r.npli;
+	if (bench_lose(&gilbert, &rev[i]))
+		return;
+	event e;
+	memset(&e, 0, sizeof(e));
+	e.t = now + delay;
+	e.type = PLI;
+	e.rcvr = i;
+	push(e);
+	e.t = now + 2. * delay;
+	e.type = HEARD;
+	for (int k = 0; k < nrcvr; ++k) {
+		if (k != i && fb[k].pli) {
+			e.rcvr = k;
+			push(e);
+		}
+	}
+}
+
+static void run(int request, int nrcvr, double delay, int fps, int ppf,
+		int factor, int keyint, int kbps, double duration, long seed,
+		result& r)
+{
+	srand48(seed);
+	int nframe = int(duration * fps);
+	KeyWait* kw = new KeyWait[nrcvr];
+	int* fwd = new int[nrcvr];
+	int* rev = new int[nrcvr];
+	memset(fwd, 0, nrcvr * sizeof(int));
+	memset(rev, 0, nrcvr * sizeof(int));
+	feedback* fb = new feedback[nrcvr];
+	double rint = RTCP_SIZE * nrcvr /
+		(kbps * 125. * .05 * .75);
+	if (rint < 360. / kbps)
+		rint = 360. / kbps;
+	KeyLimiter kl;
+	int force = 0;
+	double timer = -1.;
+	r.recovery = new double[nframe * nrcvr];
+	r.nrecovery = 0;
+	r.frozen = 0.;
+	r.npli = 0;
+	r.npkt = 0.;
+	r.nkeypkt = 0.;
+
+	event e;
+	memset(&e, 0, sizeof(e));
+	for (int n = 0; n < nframe; ++n) {
+		e.t = double(n) / fps;
+		e.type = FRAME;
+		e.key = n % keyint == 0;
+		push(e);
+	}
+	e.type = REPORT;
+	for (int i = 0; i < nrcvr; ++i) {
+		fb[i].early = 1;
+		fb[i].fbt = -1.;
+		fb[i].pli = 0;
+		e.t = rint * drand48();
+		e.rcvr = i;
+		push(e);
+	}
+	while (nheap > 0) {
+		e = pop();
+		double now = e.t;
+		switch (e.type) {
+
+		case FRAME: {
+			int key = e.key || force;
+			force = 0;
+			int npkt = key ? ppf * factor : ppf;
+			r.npkt += npkt;
+			if (key)
+				r.nkeypkt += npkt;
+			event d;
+			d.t = now + delay;
+			d.type = RECV;
+			d.key = key;
+			for (int i = 0; i < nrcvr; ++i) {
+				d.rcvr = i;
+				d.lost = 0;
+				for (int k = 0; k < npkt; ++k)
+					d.lost += bench_lose(&gilbert, &fwd[i]);
+				push(d);
+			}
+			break;
+		}
+
+		case RECV: {
+			KeyWait& w = kw[e.rcvr];
+			if (e.lost)
+				w.damaged(now);
+			else if (w.waiting() && w.frame(e.key, now)) {
+				double t = w.recovery() / 1e3;
+				r.recovery[r.nrecovery++] = t;
+				r.frozen += t;
+			} else
+				w.frame(e.key, now);
+			feedback& f = fb[e.rcvr];
+			if (request && w.request(now)) {
+				f.pli = 1;
+				if (f.early && f.fbt < 0.) {
+					f.fbt = now + .5 * rint * drand48();
+					e.t = f.fbt;
+					e.type = EARLY;
+					push(e);
+				}
+			}
+			break;
+		}
+
+		case EARLY: {
+			feedback& f = fb[e.rcvr];
+			if (now != f.fbt)
+				break;
+			f.fbt = -1.;
+			if (f.pli) {
+				send_pli(e.rcvr, nrcvr, now, delay, rev, fb, r);
+				f.early = 0;
+			}
+			break;
+		}
+
+		case REPORT:
+			if (fb[e.rcvr].pli)
+				send_pli(e.rcvr, nrcvr, now, delay, rev, fb, r);
+			fb[e.rcvr].early = 1;
+			if (now < duration) {
+				e.t = now + rint * (.5 + drand48());
+				push(e);
+			}
+			break;
+
+		case HEARD:
+			fb[e.rcvr].pli = 0;
+			break;
+
+		case PLI:
+			if (kl.request(now)) {
+				force = 1;
+				break;
+			}
+			if (timer < 0. || kl.due() < timer) {
+				timer = kl.due();
+				e.t = timer;
+				e.type = TIMER;
+				push(e);
+			}
+			break;
+
+		case TIMER:
+			if (now != timer)
+				/* superseded */
+				break;
+			timer = -1.;
+			if (kl.expire(now))
+				force = 1;
+			break;
+		}
+	}
+	r.nforced = kl.nforced();
+	delete[] kw;
+	delete[] fb;
+	delete[] fwd;
+	delete[] rev;
+}
+
+static const char synopsis[] =
+	"keybench [-n receivers] [-l loss] [-b burst] "
+	"[-d delay]\n\t\t[-f fps] [-p packets] [-k factor] "
+	"[-g keyint]\n\t\t[-r kbps] [-t time] [-S seed]\n";
+
+int main(int argc, char** argv)
+{
+	int nrcvr = 10;
+	double loss = 1.;
+	double burst = 1.;
+	double delay = .04;
+	int fps = 20;
+	int ppf = 4;
+	int factor = 5;
+	int keyint = 50;
+	int kbps = 1000;
+	double duration = 60.;
+	long seed = 1;
+	int op;
+	while ((op = getopt(argc, argv, "n:l:b:d:f:p:k:g:r:t:S:")) != -1) {
+		switch (op) {
+		case 'n':
+			nrcvr = atoi(optarg);
+			break;
+		case 'l':
+			loss = atof(optarg);
+			break;
+		case 'b':
+			burst = atof(optarg);
+			break;
+		case 'd':
+			delay = atof(optarg) / 1e3;
+			break;
+		case 'f':
+			fps = atoi(optarg);
+			break;
+		case 'p':
+			ppf = atoi(optarg);
+			break;
+		case 'k':
+			factor = atoi(optarg);
+			break;
+		case 'g':
+			keyint = atoi(optarg);
+			break;
+		case 'r':
+			kbps = atoi(optarg);
+			break;
+		case 't':
+			duration = atof(optarg);
+			break;
+		case 'S':
+			seed = atol(optarg);
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind != argc || nrcvr < 1 || loss < 0. || loss >= 100. ||
+	    burst < 1. || delay < 0. || fps < 1 || ppf < 1 || factor < 1 ||
+	    keyint < 1 || kbps < 1 || duration <= 0.)
+		bench_usage(synopsis);
+	bench_loss_init(&gilbert, loss, burst);
+
+	printf("%d receivers, loss %.1f%% (burst %.1f), rtt %.0f ms, "
+	       "%d fps, key frame every %d\n", nrcvr, loss, burst,
+	       2e3 * delay, fps, keyint);
+	printf("%-5s %7s %7s %7s %7s %7s %7s %7s %7s %6s\n", "pli",
+	       "recov", "mean", "p50", "p95", "max", "frozen", "plis",
+	       "forced", "keys");
+	for (int request = 0; request < 2; ++request) {
+		result r;
+		run(request, nrcvr, delay, fps, ppf, factor, keyint, kbps,
+		    duration, seed, r);
+		int n = r.nrecovery;
+		double sum = 0.;
+		for (int i = 0; i < n; ++i)
+			sum += r.recovery[i];
+		qsort(r.recovery, n, sizeof(double), cmp);
+		printf("%-5s %7d", request ? "on" : "off", n);
+		if (n > 0)
+			printf(" %7.0f %7.0f %7.0f %7.0f", 1e3 * sum / n,
+			       1e3 * r.recovery[n / 2],
+			       1e3 * r.recovery[n * 95 / 100],
+			       1e3 * r.recovery[n - 1]);
+		else
+			printf(" %7s %7s %7s %7s", "-", "-", "-", "-");
+		printf(" %6.2f%% %7u %7u %5.1f%%\n",
+		       100. * r.frozen / (nrcvr * duration), r.npli, r.nforced,
+		       100. * r.nkeypkt / r.npkt);
+		delete[] r.recovery;
+	}
+	printf("(times in ms; keys is the share of packets sent in key "
+	       "frames)\n");
+	return (0);
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "keyframe.h"
+
+KeyWait::KeyWait()
+	: since_(-1.), asked_(-1.), nheld_(0), nrequest_(0), recovery_(0)
+{
+}
+
+void KeyWait::damaged(double now)
+{
+	if (since_ < 0.)
+		since_ = now;
+}
+
+int KeyWait::frame(int key, double now)
+{
+	if (since_ < 0.)
+		return (1);
+	if (!key && now - since_ < KEY_WAIT) {
+		++nheld_;
+		return (0);
+	}
+	recovery_ = u_int32_t(1e3 * (now - since_) + .5);
+	since_ = -1.;
+	asked_ = -1.;
+	return (1);
+}
+
+int KeyWait::request(double now)
+{
+	if (since_ < 0. || (asked_ >= 0. && now - asked_ < KEY_REPEAT))
+		return (0);
+	asked_ = now;
+	++nrequest_;
+	return (1);
+}
+
+KeyLimiter::KeyLimiter()
+	: last_(-1.), pending_(0), nrequest_(0), nforced_(0)
+{
+}
+
+int KeyLimiter::request(double now)
+{
+	++nrequest_;
+	if (last_ >= 0. && now - last_ < KEY_HOLDOFF) {
+		pending_ = 1;
+		return (0);
+	}
+	pending_ = 0;
+	last_ = now;
+	++nforced_;
+	return (1);
+}
+
+double KeyLimiter::due() const
+{
+	return (pending_ ? last_ + KEY_HOLDOFF : -1.);
+}
+
+int KeyLimiter::expire(double now)
+{
+	if (!pending_ || now - last_ < KEY_HOLDOFF)
+		return (0);
+	pending_ = 0;
+	last_ = now;
+	++nforced_;
+	return (1);
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef vic_keyframe_h
+#define vic_keyframe_h
+
+#include "config.h"
+
+/*
+ * Recovery from loss for codecs that predict from earlier frames
+ * (H.264, MPEG-4).  A receiver that loses part of a frame stops
+ * decoding, holds the last good frame up and asks the sender for a
+ * key frame with an RTCP picture loss indication (RFC 4585); the
+ * sender answers a PLI or a full intra request (RFC 5104) by having
+ * the encoder code the next frame intra.  Without this a receiver
+ * decodes garbage until the next periodic refresh.
+ */
+
+#define KEY_REPEAT	0.25	/* seconds between a receiver's requests */
+#define KEY_WAIT	5.	/* seconds held before decoding regardless */
+#define KEY_HOLDOFF	0.5	/* least seconds between forced key frames */
+
+/*
+ * The receiver side, for one decoder.  The decoder reports damage
+ * (a frame that came in incomplete or failed to decode) and asks at
+ * each whole frame whether to decode it: not until a key frame
+ * comes in, or KEY_WAIT seconds go by for a sender that doesn't
+ * answer.
+ */
+class KeyWait {
+    public:
+	KeyWait();
+	void damaged(double now);
+	/* a whole frame came in; true to decode it */
+	int frame(int key, double now);
+	/* true if a request should go out now */
+	int request(double now);
+	inline int waiting() const { return (since_ >= 0.); }
+
+	inline u_int32_t nheld() const { return (nheld_); }
+	inline u_int32_t nrequest() const { return (nrequest_); }
+	/* ms from damage to decoding again, the last time */
+	inline u_int32_t recovery() const { return (recovery_); }
+    protected:
+	double since_;		/* damaged, or < 0 */
+	double asked_;		/* last request, or < 0 */
+	u_int32_t nheld_;	/* frames not decoded */
+	u_int32_t nrequest_;
+	u_int32_t recovery_;
+};
+
+/*
+ * The sender side.  All the receivers that lost a packet ask for a
+ * key frame at about the same time; the first request is answered
+ * at once and the rest within KEY_HOLDOFF are folded into at most
+ * one more at the end of it (for a receiver that lost a packet
+ * after the first key frame went out).
+ */
+class KeyLimiter {
+    public:
+	KeyLimiter();
+	/* a receiver asked; true to force a key frame now */
+	int request(double now);
+	/* when a deferred request is due, or < 0 */
+	double due() const;
+	/* the timer for due() went off; true to force one now */
+	int expire(double now);
+
+	inline u_int32_t nrequest() const { return (nrequest_); }
+	inline u_int32_t nforced() const { return (nforced_); }
+    protected:
+	double last_;		/* last forced, or < 0 */
+	int pending_;
+	u_int32_t nrequest_;
+	u_int32_t nforced_;
+};
+
+#endif
@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * pacebench - capture on loopback the packets a Transmitter paces
+ * out, with the microsecond timers and with the Tk ones, and time
+ * their spacing.
+ *
+ * usage: pacebench [-r mbps[,mbps...]] [-s size] [-f fps] [-t time]
+ *
+ * For each rate in `mbps' (2, 10 and 50) an encoder hands the
+ * Transmitter `fps' (30) frames a second for `time' seconds (3),
+ * each a burst of `size' byte packets (1000) coming to 90% of the
+ * rate.  The Transmitter sends them over UDP to a socket on
+ * 127.0.0.1, which the kernel stamps as they come in
+ * (SO_TIMESTAMPNS).
+ *
+ * The gap before each packet but the first of a frame is compared
+ * with the spacing the Transmitter was asked for.  Printed are the
+ * mean and standard deviation of the difference, its 99th
+ * percentile, the share of packets that went out in bursts (less
+ * than a quarter of their spacing after the one before), and the
+ * rate sent.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "config.h"
+#include "bench.h"
+#include "vic_tcl.h"
+#include "transmitter.h"
+#include "iohandler.h"
+
+/* vw.cpp and the X11 grabber look at these; they live in main.cpp */
+int use_shm = 0;
+int use_ddraw = 0;
+
+struct stamp {
+	double t;	/* arrival, seconds */
+	int frame;
+	int pkt;	/* in the frame */
+	int len;
+};
+
+static stamp* stamps;
+static int nstamp;
+static int maxstamp;
+
+/* sends what the Transmitter paces out to the capture socket */
+class LoopTransmitter : public Transmitter {
+    public:
+	LoopTransmitter(int fd, const sockaddr_in& to) : fd_(fd), to_(to) {
+		/* nothing to a local source */
+		loop_layer(0);
+	}
+    protected:
+	virtual void transmit(pktbuf* pb) {
+		(void)sendto(fd_, pb->dp, pb->len, 0, (sockaddr*)&to_,
+			     sizeof(to_));
+	}
+	int fd_;
+	sockaddr_in to_;
+};
+
+class Capture : public IOHandler {
+    public:
+	Capture(int fd) : fd_(fd) { link(fd, TK_READABLE); }
+    protected:
+	virtual void dispatch(int mask);
+	int fd_;
+};
+
+void Capture::dispatch(int)
+{
+	for (;;) {
+		u_char buf[PKTBUF_SIZE];
+		char ctl[256];
+		iovec iov;
+		iov.iov_base = buf;
+		iov.iov_len = sizeof(buf);
+		msghdr mh;
+		memset(&mh, 0, sizeof(mh));
+		mh.msg_iov = &iov;
+		mh.msg_iovlen = 1;
+		mh.msg_control = ctl;
+		mh.msg_controllen = sizeof(ctl);
+		int cc = recvmsg(fd_, &mh, MSG_DONTWAIT);
+		if (cc < int(sizeof(rtphdr)) + 8)
+			return;
+		double t = 0.;
+		for (cmsghdr* c = CMSG_FIRSTHDR(&mh); c != 0;
+		     c = CMSG_NXTHDR(&mh, c)) {
+			if (c->cmsg_level == SOL_SOCKET &&
+			    c->cmsg_type == SCM_TIMESTAMPNS) {
+				timespec ts;
+				memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+				t = ts.tv_sec + 1e-9 * ts.tv_nsec;
+			}
+		}
+		if (nstamp == maxstamp) {
+			maxstamp = maxstamp ? 2 * maxstamp : 4096;
+			stamps = (stamp*)realloc(stamps, maxstamp * sizeof(stamp));
+		}
+		stamp& s = stamps[nstamp++];
+		s.t = t;
+		memcpy(&s.frame, buf + sizeof(rtphdr), 4);
+		memcpy(&s.pkt, buf + sizeof(rtphdr) + 4, 4);
+		s.len = cc;
+	}
+}
+
+/* the encoder: a frame's packets all at once, fps times a second */
+class FrameSource : public Timer {
+    public:
+	FrameSource(Transmitter& tx, int fps, int npkt, int size, double duration)
+		: tx_(tx), fps_(fps), npkt_(npkt), size_(size), frame_(0),
+		  nframe_(int(duration * fps)), start_(0.) {}
+	void start() {
+		start_ = gettimeofday_usecs();
+		timeout();
+	}
+	inline int done() const { return (frame_ >= nframe_); }
+    protected:
+	virtual void timeout();
+	Transmitter& tx_;
+	int fps_;
+	int npkt_;
+	int size_;
+	int frame_;
+	int nframe_;
+	double start_;
+	BufferPool pool_;
+};
+
+void FrameSource::timeout()
+{
+	if (done())
+		return;
+	for (int i = 0; i < npkt_; ++i) {
+		pktbuf* pb = pool_.alloc();
+		rtphdr* rh = (rtphdr*)pb->dp;
+		int flags = RTP_VERSION << 14 | RTP_PT_H261;
+		if (i == npkt_ - 1)
+			flags |= RTP_M;
+		rh->rh_flags = htons(flags);
+		rh->rh_seqno = htons(frame_ * npkt_ + i);
+		rh->rh_ts = htonl(frame_ * 90000 / fps_);
+		rh->rh_ssrc = 0;
+		memset(pb->dp + sizeof(*rh), 0, size_ - sizeof(*rh));
+		memcpy(pb->dp + sizeof(*rh), &frame_, 4);
+		memcpy(pb->dp + sizeof(*rh) + 4, &i, 4);
+		pb->len = size_;
+		tx_.send(pb);
+	}
+	++frame_;
+	/* on the frame clock, not from now */
+	double next = start_ + 1e6 * frame_ / fps_;
+	usched(next - gettimeofday_usecs());
+}
+
+static int cmp(const void* a, const void* b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x < y ? -1 : x > y);
+}
+
+static void run(double mbps, int size, int fps, double duration, int highres)
+{
+	Timer::highres(highres);
+	int rfd = socket(AF_INET, SOCK_DGRAM, 0);
+	sockaddr_in sin;
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	int on = 1;
+	setsockopt(rfd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+	int bufsize = 8 << 20;
+	setsockopt(rfd, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+	if (bind(rfd, (sockaddr*)&sin, sizeof(sin)) < 0) {
+		perror("bind");
+		exit(1);
+	}
+	socklen_t len = sizeof(sin);
+	getsockname(rfd, (sockaddr*)&sin, &len);
+	int sfd = socket(AF_INET, SOCK_DGRAM, 0);
+
+	int kbps = int(mbps * 1e3);
+	int npkt = int(0.9 * mbps * 1e6 / (8. * size * fps));
+	if (npkt < 1)
+		npkt = 1;
+	LoopTransmitter tx(sfd, sin);
+	tx.bps(kbps);
+	Capture cap(rfd);
+	FrameSource src(tx, fps, npkt, size, duration);
+	nstamp = 0;
+	src.start();
+	while (!src.done())
+		Tcl_DoOneEvent(TCL_ALL_EVENTS);
+	/* the last frame's packets */
+	double end = tx.gettimeofday_usecs() + 1e6 / fps;
+	while (tx.gettimeofday_usecs() < end)
+		Tcl_DoOneEvent(TCL_ALL_EVENTS | TCL_DONT_WAIT);
+
+	double* err = new double[nstamp];
+	int n = 0;
+	int nburst = 0;
+	double sum = 0., sum2 = 0., bytes = 0.;
+	for (int i = 0; i < nstamp; ++i) {
+		bytes += stamps[i].len;
+		if (i == 0 || stamps[i].pkt == 0 ||
+		    stamps[i].frame != stamps[i - 1].frame ||
+		    stamps[i].pkt != stamps[i - 1].pkt + 1)
+			continue;
+		double gap = stamps[i].t - stamps[i - 1].t;
+		double want = 8. * stamps[i - 1].len / (1e3 * kbps);
+		if (gap < want / 4.)
+			++nburst;
+		double e = 1e6 * (gap - want);
+		sum += e;
+		sum2 += e * e;
+		err[n++] = fabs(e);
+	}
+	double mean = n ? sum / n : 0.;
+	double sd = n ? sqrt(sum2 / n - mean * mean) : 0.;
+	qsort(err, n, sizeof(double), cmp);
+	double span = nstamp > 1 ? stamps[nstamp - 1].t - stamps[0].t : 0.;
+	printf("%6.1f %6s %8.0f %9.1f %8.1f %8.1f %7.1f%% %8.2f\n", mbps,
+	       highres ? "us" : "ms", 1e6 * 8. * size / (1e3 * kbps), mean,
+	       sd, n ? err[n * 99 / 100] : 0., n ? 100. * nburst / n : 0.,
+	       span > 0. ? bytes * 8. / span / 1e6 : 0.);
+	delete[] err;
+	close(sfd);
+	close(rfd);
+}
+
+static const char synopsis[] =
+	"pacebench [-r mbps[,mbps...]] [-s size] "
+	"[-f fps] [-t time]\n";
+
+int main(int argc, char** argv)
+{
+	double rate[16];
+	int nrate = 3;
+	rate[0] = 2.;
+	rate[1] = 10.;
+	rate[2] = 50.;
+	int size = 1000;
+	int fps = 30;
+	double duration = 3.;
+	int op;
+	while ((op = getopt(argc, argv, "r:s:f:t:")) != -1) {
+		switch (op) {
+		case 'r':
+			nrate = 0;
+			for (char* p = strtok(optarg, ","); p != 0 && nrate < 16;
+			     p = strtok(0, ","))
+				rate[nrate++] = atof(p);
+			break;
+		case 's':
+			size = atoi(optarg);
+			break;
+		case 'f':
+			fps = atoi(optarg);
+			break;
+		case 't':
+			duration = atof(optarg);
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind != argc || nrate == 0 || fps < 1 ||
+	    size < int(sizeof(rtphdr)) + 8 || size > RTP_MTU ||
+	    duration <= 0.)
+		bench_usage(synopsis);
+	for (int i = 0; i < nrate; ++i)
+		if (rate[i] <= 0.)
+			bench_usage(synopsis);
+
+	Tcl::init("pacebench");
+	TclObject::define();
+	Timer::highres(1);
+	int us = Timer::highres();
+
+	printf("%d byte packets, %d fps, %.0f s each\n", size, fps, duration);
+	printf("%6s %6s %8s %9s %8s %8s %8s %8s\n", "Mb/s", "timers",
+	       "spacing", "err mean", "err sd", "err p99", "burst", "Mb/s");
+	for (int i = 0; i < nrate; ++i) {
+		run(rate[i], size, fps, duration, 0);
+		if (us)
+			run(rate[i], size, fps, duration, 1);
+	}
+	if (!us)
+		printf("(no microsecond timers)\n");
+	printf("(times in us)\n");
+	return (0);
+}
@@ -84,6 +84,13 @@ void RTP_BufferPool::seqno(u_int16_t s)
 		seqno_[i] = s;
 }
 
+u_int32_t RTP_BufferPool::srcid() const
+{
+	if (srcid_ != (u_int32_t)-1)
+		return (srcid_);
+	return (SourceManager::instance().localsrc()->srcid());
+}
+
 void RTP_BufferPool::initpkt(pktbuf *pb, u_int32_t ts, int fmt, int layer)
 {
 	pb->layer = layer;
@@ -93,6 +100,5 @@ void RTP_BufferPool::initpkt(pktbuf *pb, u_int32_t ts, int fmt, int layer)
 	rh->rh_seqno = htons(seqno_[layer]);
 	++seqno_[layer];
 	rh->rh_ts = htonl(ts);
-	//rh->rh_ssrc = srcid_;
-	rh->rh_ssrc = SourceManager::instance().localsrc()->srcid();
+	rh->rh_ssrc = srcid();
 }
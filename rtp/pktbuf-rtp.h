@@ -39,6 +39,9 @@ public:
 	RTP_BufferPool();
 	virtual int command(int argc, const char*const* argv);
 	void seqno(u_int16_t s);
+	/* the ssrc packets go out from (net order), localsrc's if unset */
+	u_int32_t srcid() const;
+	inline void srcid(u_int32_t s) { srcid_ = s; }
 	pktbuf* alloc(u_int32_t ts, int fmt, int layer = 0) {
 		pktbuf* pb = BufferPool::alloc();
 		initpkt(pb, ts, fmt, layer);
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include "rate-control.h"
+
+RateControl::RateControl()
+	: nrcvr_(0), rate_(128000.), max_(128000.)
+{
+}
+
+void RateControl::limit(int kbps)
+{
+	max_ = 1000. * kbps;
+	for (int i = 0; i < nrcvr_; ++i)
+		if (rcvr_[i].rate > max_)
+			rcvr_[i].rate = max_;
+	if (nrcvr_ == 0 || rate_ > max_)
+		rate_ = max_;
+}
+
+/*
+ * Find the entry for ssrc, making one if there's none.  When the
+ * table is full the receiver heard from least recently is dropped.
+ */
+RateControl::receiver* RateControl::lookup(u_int32_t ssrc, double now)
+{
+	receiver* r;
+	for (int i = 0; i < nrcvr_; ++i)
+		if (rcvr_[i].ssrc == ssrc)
+			return (&rcvr_[i]);
+	if (nrcvr_ < RC_MAXRCVR)
+		r = &rcvr_[nrcvr_++];
+	else {
+		r = &rcvr_[0];
+		for (int i = 1; i < nrcvr_; ++i)
+			if (rcvr_[i].last < r->last)
+				r = &rcvr_[i];
+	}
+	r->ssrc = ssrc;
+	r->rate = rate_;
+	r->rtt = -1.;
+	r->minrtt = -1.;
+	r->cut = 0.;
+	r->hold = 0;
+	r->last = now;
+	return (r);
+}
+
+int RateControl::report(u_int32_t ssrc, int fraction, double jitter,
+			double rtt, double now)
+{
+	receiver* r = lookup(ssrc, now);
+	double dt = now - r->last;
+	r->last = now;
+
+	double loss = fraction / 256.;
+	if (rtt >= 0.) {
+		r->rtt = (r->rtt < 0.) ? rtt : r->rtt + (rtt - r->rtt) * .25;
+		if (r->minrtt < 0. || rtt < r->minrtt)
+			r->minrtt = rtt;
+	}
+
+	/*
+	 * Loss and delay are about what we sent, which may be less
+	 * than this receiver would allow.
+	 */
+	double rate = r->rate < rate_ ? r->rate : rate_;
+	if (dt > 5.)
+		dt = 5.;
+	if (loss > RC_LOSS_HIGH ||
+	    (rtt >= 0. && rtt - r->minrtt > RC_QDELAY) || jitter > RC_JITTER) {
+		/* what got through is about what the path takes */
+		r->cut = rate * (1. - loss);
+		rate = r->cut * RC_DECREASE;
+		r->hold = 1;
+	} else if (r->hold || loss >= RC_LOSS_LOW) {
+		/* let the queue drain before probing again */
+		rate = r->rate;
+		r->hold = 0;
+	} else {
+		double c = r->cut;
+		if (c > 0. && rate > c / RC_NEAR)
+			/* well past it; the path has opened up */
+			c = r->cut = 0.;
+		if (c > 0. && rate >= RC_NEAR * c)
+			/* near where we last saw congestion: probe gently */
+			rate = r->rate + dt * RC_STEP * c;
+		else {
+			rate = r->rate * pow(RC_INCREASE, dt) + 1000.;
+			if (c > 0. && rate > RC_NEAR * c)
+				rate = RC_NEAR * c;
+		}
+	}
+	if (rate > max_)
+		rate = max_;
+	r->rate = rate;
+
+	int old = kbps();
+	update(now);
+	return (kbps() != old);
+}
+
+/* send at the least rate of the receivers still reporting */
+void RateControl::update(double now)
+{
+	double rate = max_;
+	for (int i = 0; i < nrcvr_; ) {
+		receiver* r = &rcvr_[i];
+		if (now - r->last > RC_TIMEOUT) {
+			*r = rcvr_[--nrcvr_];
+			continue;
+		}
+		if (r->rate < rate)
+			rate = r->rate;
+		++i;
+	}
+	double floor = 1000. * RC_MINKBPS;
+	if (floor > max_)
+		floor = max_;
+	if (rate < floor)
+		rate = floor;
+	rate_ = rate;
+}
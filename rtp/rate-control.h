@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef vic_rate_control_h
+#define vic_rate_control_h
+
+#include "config.h"
+
+/*
+ * Sender rate control driven by RTCP receiver reports.  Each
+ * receiver that reports on our stream gets its own allowed rate,
+ * moved by the loss, queueing delay and jitter it reports:
+ *
+ *  - loss over RC_LOSS_HIGH, a round trip time RC_QDELAY over the
+ *    least one seen from that receiver (i.e., a queue building at
+ *    the bottleneck) or jitter over RC_JITTER cuts the rate to
+ *    RC_DECREASE of the part of it that got through, which is
+ *    taken as what the path carries;
+ *  - otherwise, with loss under RC_LOSS_LOW, it grows by
+ *    RC_INCREASE a second up to RC_NEAR of what the path carries,
+ *    then by RC_STEP of that a second, until it is well past it
+ *    (the path has opened up) and grows by RC_INCREASE again.
+ *
+ * The rate holds for the report after a cut, to let the queue
+ * drain, and with loss between the two thresholds.
+ *
+ * We send at the least allowed rate of the receivers heard from
+ * lately, between the floor and the user's rate.  With nobody
+ * reporting we send at the user's rate.
+ */
+
+#define RC_MAXRCVR	32	/* receivers tracked */
+#define RC_MINKBPS	16	/* floor */
+#define RC_LOSS_HIGH	0.10
+#define RC_LOSS_LOW	0.02
+#define RC_QDELAY	0.1	/* seconds */
+#define RC_JITTER	0.05	/* seconds */
+#define RC_DECREASE	0.85
+#define RC_INCREASE	1.05
+#define RC_NEAR		0.9
+#define RC_STEP		0.01
+#define RC_TIMEOUT	30.	/* seconds before a silent receiver is dropped */
+
+class RateControl {
+    public:
+	RateControl();
+	/* the user's rate, the most we will send */
+	void limit(int kbps);
+	inline int limit() const { return (int(max_ / 1000.)); }
+	/* the rate to send at */
+	inline int kbps() const { return (int(rate_ / 1000. + .5)); }
+	/*
+	 * Take a report on our stream from receiver ssrc, made at time
+	 * now (seconds): the fraction lost (of 256), the interarrival
+	 * jitter and the round trip time in seconds, rtt < 0 if it is
+	 * unknown.  Returns true if kbps() changed.
+	 */
+	int report(u_int32_t ssrc, int fraction, double jitter, double rtt,
+		   double now);
+    protected:
+	struct receiver {
+		u_int32_t ssrc;
+		double rate;	/* what this receiver allows (bits/s) */
+		double rtt;	/* smoothed round trip time */
+		double minrtt;	/* least round trip time seen */
+		double cut;	/* what the path carried at the last cut */
+		int hold;	/* true just after a cut */
+		double last;	/* time of the last report */
+	};
+	receiver* lookup(u_int32_t ssrc, double now);
+	void update(double now);
+
+	receiver rcvr_[RC_MAXRCVR];
+	int nrcvr_;
+	double rate_;		/* current rate (bits/s) */
+	double max_;		/* user's rate */
+};
+
+#endif
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * ratebench - run the sender rate control against an emulated
+ * bottleneck.
+ *
+ * usage: ratebench [-c kbps[,kbps...]] [-d delay] [-q queue] [-i interval]
+ *		    [-t time] [-r kbps] [-s size] [-v]
+ *
+ * A sender paced at RateControl's rate sends packets of `size'
+ * bytes (1000) through a link of the given capacity with a
+ * drop-tail queue of `queue' ms (200) and a one-way delay of
+ * `delay' ms (20), for `time' seconds (300).  With a list of
+ * capacities, each one holds for an equal share of the time.  The
+ * receiver sends a report every `interval' seconds (5, the RTCP
+ * minimum) with the fraction lost, the jitter and the round trip
+ * time (the reports themselves aren't queued), which goes to the
+ * controller; `kbps' (1000) is the user's rate.
+ *
+ * The goodput, loss and queueing delay are printed for each report
+ * interval with -v, and summed up for each capacity and for the
+ * whole run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "../config.h"
+#include "../bench.h"
+#include "rate-control.h"
+
+#define MAXSTEP 16
+
+struct Stats {
+	double bits;		/* delivered */
+	int sent;
+	int lost;
+	double qsum;		/* queueing delay of the delivered packets */
+	double qmax;
+	int n;
+	void clear() { memset(this, 0, sizeof(*this)); }
+	void add(const Stats& s) {
+		bits += s.bits;
+		sent += s.sent;
+		lost += s.lost;
+		qsum += s.qsum;
+		if (s.qmax > qmax)
+			qmax = s.qmax;
+		n += s.n;
+	}
+};
+
+static void summary(const char* what, const Stats& s, double t, double cap)
+{
+	double gp = s.bits / t / 1000.;
+	printf("%-12s goodput %7.1f kb/s", what, gp);
+	if (cap > 0.)
+		printf(" (%3.0f%%)", 100. * gp / cap);
+	printf("  loss %5.2f%%  queue delay mean %5.1f max %5.1f ms\n",
+	       s.sent ? 100. * s.lost / s.sent : 0.,
+	       s.n ? 1e3 * s.qsum / s.n : 0., 1e3 * s.qmax);
+}
+
+static const char synopsis[] =
+	"ratebench [-c kbps[,kbps...]] [-d delay] "
+	"[-q queue] [-i interval]\n\t\t [-t time] [-r kbps] "
+	"[-s size] [-v]\n";
+
+int main(int argc, char** argv)
+{
+	double cap[MAXSTEP];
+	int ncap = 1;
+	cap[0] = 500.;
+	double delay = .02;
+	double qlen = .2;
+	double interval = 5.;
+	double duration = 300.;
+	int limit = 1000;
+	int size = 1000;
+	int verbose = 0;
+	int op;
+	while ((op = getopt(argc, argv, "c:d:q:i:t:r:s:v")) != -1) {
+		switch (op) {
+		case 'c':
+			ncap = 0;
+			for (char* p = strtok(optarg, ","); p != 0 && ncap < MAXSTEP;
+			     p = strtok(0, ","))
+				cap[ncap++] = atof(p);
+			break;
+		case 'd':
+			delay = atof(optarg) / 1e3;
+			break;
+		case 'q':
+			qlen = atof(optarg) / 1e3;
+			break;
+		case 'i':
+			interval = atof(optarg);
+			break;
+		case 't':
+			duration = atof(optarg);
+			break;
+		case 'r':
+			limit = atoi(optarg);
+			break;
+		case 's':
+			size = atoi(optarg);
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind != argc || ncap == 0 || interval <= 0. || duration <= 0. ||
+	    limit <= 0 || size <= 0)
+		bench_usage(synopsis);
+	for (int i = 0; i < ncap; ++i)
+		if (cap[i] <= 0.)
+			bench_usage(synopsis);
+
+	RateControl rc;
+	rc.limit(limit);
+
+	double step = duration / ncap;
+	double t = 0.;			/* next packet */
+	double report = interval;	/* next report */
+	double busy = 0.;		/* link is busy until */
+	double last_transit = -1.;
+	double jitter = 0.;
+	Stats iv, seg, all;
+	iv.clear();
+	seg.clear();
+	all.clear();
+	int k = 0;
+
+	if (verbose)
+		printf("%6s %6s %7s %8s %6s %7s\n", "time", "link", "rate",
+		       "goodput", "loss", "qdelay");
+	while (report <= duration) {
+		if (t < report) {
+			/* send a packet into the bottleneck */
+			double c = 1e3 * cap[k];
+			++iv.sent;
+			double q = busy > t ? busy - t : 0.;
+			if (q > qlen)
+				++iv.lost;
+			else {
+				busy = (busy > t ? busy : t) + 8. * size / c;
+				double transit = busy + delay - t;
+				if (last_transit >= 0.)
+					jitter += (fabs(transit - last_transit) -
+						   jitter) / 16.;
+				last_transit = transit;
+				iv.bits += 8. * size;
+				iv.qsum += q;
+				if (q > iv.qmax)
+					iv.qmax = q;
+				++iv.n;
+			}
+			t += 8. * size / (1e3 * rc.kbps());
+			continue;
+		}
+		/* the receiver reports; the rtt sees the queue now */
+		int fraction = iv.sent ? (iv.lost << 8) / iv.sent : 0;
+		if (fraction > 255)
+			fraction = 255;
+		double q = busy > report ? busy - report : 0.;
+		rc.report(1, fraction, jitter, 2. * delay + q, report);
+		if (verbose)
+			printf("%6.0f %6.0f %7d %8.1f %5.1f%% %6.1f\n", report,
+			       cap[k], rc.kbps(), iv.bits / interval / 1e3,
+			       iv.sent ? 100. * iv.lost / iv.sent : 0.,
+			       iv.n ? 1e3 * iv.qsum / iv.n : 0.);
+		seg.add(iv);
+		iv.clear();
+		report += interval;
+		if (report > (k + 1) * step + 1e-9 || report > duration) {
+			char what[32];
+			sprintf(what, "%.0f kb/s", cap[k]);
+			summary(what, seg, step, cap[k]);
+			all.add(seg);
+			seg.clear();
+			if (k < ncap - 1)
+				++k;
+		}
+	}
+	all.add(seg);
+	summary("total", all, duration, 0.);
+	return (0);
+}
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * reflectbench - time the reflector's fan-out over loopback, with
+ * sendmmsg and with a sendto for each destination, and check that
+ * its rate limit holds.
+ *
+ * usage: reflectbench [-n dests[,dests...]] [-s size] [-p packets]
+ *		       [-k kbps] [-t time]
+ *
+ * For each count in `dests' (1, 4, 16 and 32) as many sockets are
+ * opened on 127.0.0.1 and `packets' (20000) packets of `size' bytes
+ * (1000) are relayed to all of them, as SessionManager does, the
+ * sockets being read after each 32.  Printed are the packets relayed
+ * and sent a second, counting the time in the reflector only, and
+ * the share of them that came in.
+ *
+ * Then for `time' seconds (2) packets are relayed at twice `kbps'
+ * (1000) to a destination held to `kbps', and the rate it got and
+ * the packets held back and dropped are printed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "../config.h"
+#include "../bench.h"
+#include "rtp.h"
+#include "reflector.h"
+
+#define CHUNK 32
+
+/* a socket on 127.0.0.1; returns its port */
+static int listener(int& fd)
+{
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	sockaddr_in sin;
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	int bufsize = 4 << 20;
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+	if (bind(fd, (sockaddr*)&sin, sizeof(sin)) < 0) {
+		perror("bind");
+		exit(1);
+	}
+	socklen_t len = sizeof(sin);
+	getsockname(fd, (sockaddr*)&sin, &len);
+	return (ntohs(sin.sin_port));
+}
+
+/* read what is waiting on the n sockets; returns the bytes */
+static double drain(const int* fd, int n, double& npkt)
+{
+	u_char buf[PKTBUF_SIZE];
+	double nbyte = 0.;
+	for (int i = 0; i < n; ++i) {
+		int cc;
+		while ((cc = recv(fd[i], buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+			npkt += 1.;
+			nbyte += cc;
+		}
+	}
+	return (nbyte);
+}
+
+static pktbuf* packet(BufferPool& pool, int size, u_int16_t seqno)
+{
+	pktbuf* pb = pool.alloc();
+	rtphdr* rh = (rtphdr*)pb->dp;
+	rh->rh_flags = htons(RTP_VERSION << 14 | RTP_PT_H261);
+	rh->rh_seqno = htons(seqno);
+	rh->rh_ts = htonl(seqno * 3000);
+	rh->rh_ssrc = htonl(0x12345678);
+	memset(pb->dp + sizeof(*rh), seqno, size - sizeof(*rh));
+	pb->len = size;
+	return (pb);
+}
+
+static void fanout(int ndest, int batch, int size, int npkt)
+{
+	BufferPool pool;
+	Reflector r;
+	r.batch(batch);
+	int* fd = new int[ndest];
+	for (int i = 0; i < ndest; ++i)
+		r.add(htonl(INADDR_LOOPBACK), listener(fd[i]));
+
+	double t = 0.;
+	double nin = 0.;
+	for (int n = 0; n < npkt; ) {
+		int m = npkt - n < CHUNK ? npkt - n : CHUNK;
+		pktbuf* pb[CHUNK];
+		int i;
+		for (i = 0; i < m; ++i)
+			pb[i] = packet(pool, size, n + i);
+		double t0 = bench_now();
+		for (i = 0; i < m; ++i)
+			r.forward(pb[i], 0);
+		t += bench_now() - t0;
+		for (i = 0; i < m; ++i)
+			pb[i]->release();
+		drain(fd, ndest, nin);
+		n += m;
+	}
+	usleep(10000);
+	drain(fd, ndest, nin);
+
+	double nout = 0.;
+	u_int32_t nerror = 0;
+	for (int i = 0; i < ndest; ++i) {
+		nout += r.dest(i)->npkt;
+		nerror += r.dest(i)->nerror;
+		close(fd[i]);
+	}
+	printf("%5d %8s %10.0f %10.0f %9.0f %7.2f%% %6u\n", ndest,
+	       batch ? "sendmmsg" : "sendto", npkt / t, nout / t,
+	       nout * size * 8. / t / 1e6, 100. * nin / (double(npkt) * ndest),
+	       nerror);
+	delete[] fd;
+}
+
+static void shaped(int kbps, int size, double duration)
+{
+	BufferPool pool;
+	Reflector r;
+	int fd;
+	int d = r.add(htonl(INADDR_LOOPBACK), listener(fd));
+	r.rate(d, kbps);
+
+	/* twice the rate */
+	double gap = size * 8. / (2e3 * kbps);
+	double start = bench_now();
+	double next = start;
+	double nin = 0.;
+	double nbyte = 0.;
+	u_int16_t seqno = 0;
+	for (;;) {
+		double t = bench_now();
+		if (t - start >= duration)
+			break;
+		while (next <= t) {
+			pktbuf* pb = packet(pool, size, seqno++);
+			r.forward(pb, 0);
+			pb->release();
+			next += gap;
+		}
+		Tcl_DoOneEvent(TCL_ALL_EVENTS | TCL_DONT_WAIT);
+		nbyte += drain(&fd, 1, nin);
+		usleep(500);
+	}
+	const ReflectDest* rd = r.dest(d);
+	printf("limit %d kb/s, offered %d kb/s: got %.0f kb/s, "
+	       "%u delayed, %u dropped\n", kbps, 2 * kbps,
+	       nbyte * 8. / duration / 1e3, rd->ndelay, rd->ndrop);
+	close(fd);
+}
+
+static const char synopsis[] =
+	"reflectbench [-n dests[,dests...]] [-s size] "
+	"[-p packets]\n\t\t   [-k kbps] [-t time]\n";
+
+int main(int argc, char** argv)
+{
+	int dests[16];
+	int ndests = 4;
+	dests[0] = 1;
+	dests[1] = 4;
+	dests[2] = 16;
+	dests[3] = 32;
+	int size = 1000;
+	int npkt = 20000;
+	int kbps = 1000;
+	double duration = 2.;
+	int op;
+	while ((op = getopt(argc, argv, "n:s:p:k:t:")) != -1) {
+		switch (op) {
+		case 'n':
+			ndests = 0;
+			for (char* p = strtok(optarg, ","); p != 0 && ndests < 16;
+			     p = strtok(0, ","))
+				dests[ndests++] = atoi(p);
+			break;
+		case 's':
+			size = atoi(optarg);
+			break;
+		case 'p':
+			npkt = atoi(optarg);
+			break;
+		case 'k':
+			kbps = atoi(optarg);
+			break;
+		case 't':
+			duration = atof(optarg);
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind != argc || ndests == 0 || size < int(sizeof(rtphdr)) ||
+	    size > PKTBUF_SIZE || npkt < 1 || kbps < 1 || duration <= 0.)
+		bench_usage(synopsis);
+	for (int i = 0; i < ndests; ++i)
+		if (dests[i] < 1 || dests[i] > REFLECT_MAXDEST)
+			bench_usage(synopsis);
+	Tcl_FindExecutable(argv[0]);
+
+	printf("%d packets of %d bytes\n", npkt, size);
+	printf("%5s %8s %10s %10s %9s %8s %6s\n", "dests", "send",
+	       "in pkt/s", "out pkt/s", "out Mb/s", "recv", "errors");
+	for (int i = 0; i < ndests; ++i)
+		for (int batch = 0; batch < 2; ++batch)
+			fanout(dests[i], batch, size, npkt);
+	shaped(kbps, size, duration);
+	return (0);
+}
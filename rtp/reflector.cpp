@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <errno.h>
+#ifndef WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#endif
+#include "rtp.h"
+#include "reflector.h"
+
+#if defined(__linux__)
+#define HAVE_SENDMMSG
+#endif
+
+Reflector::Reflector() : ndest_(0), batch_(1), nmsg_(0)
+{
+	memset(dest_, 0, sizeof(dest_));
+	fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+#ifdef WIN32
+	u_long flag = 1;
+	ioctlsocket(fd_, FIONBIO, &flag);
+#else
+	if (fd_ >= 0)
+		fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+Reflector::~Reflector()
+{
+	for (int i = 0; i < REFLECT_MAXDEST; ++i)
+		remove(i);
+#ifdef WIN32
+	closesocket(fd_);
+#else
+	if (fd_ >= 0)
+		close(fd_);
+#endif
+}
+
+int Reflector::add(u_int32_t addr, int port)
+{
+	for (int i = 0; i < REFLECT_MAXDEST; ++i) {
+		if (dest_[i] != 0)
+			continue;
+		ReflectDest* d = new ReflectDest;
+		memset(d, 0, sizeof(*d));
+		d->addr.sin_family = AF_INET;
+		d->addr.sin_addr.s_addr = addr;
+		d->addr.sin_port = htons(port);
+		dest_[i] = d;
+		++ndest_;
+		return (i);
+	}
+	return (-1);
+}
+
+void Reflector::remove(int n)
+{
+	ReflectDest* d = (ReflectDest*)dest(n);
+	if (d == 0)
+		return;
+	for (; d->qlen > 0; --d->qlen) {
+		d->q[d->qhead]->release();
+		d->qhead = (d->qhead + 1) % REFLECT_QLEN;
+	}
+	delete d;
+	dest_[n] = 0;
+	--ndest_;
+}
+
+void Reflector::ssrc(int n, const u_int32_t* ssrc, int cnt)
+{
+	ReflectDest* d = (ReflectDest*)dest(n);
+	if (d == 0)
+		return;
+	if (cnt > REFLECT_MAXSSRC)
+		cnt = REFLECT_MAXSSRC;
+	memcpy(d->ssrc, ssrc, cnt * sizeof(*ssrc));
+	d->nssrc = cnt;
+}
+
+void Reflector::rate(int n, int kbps)
+{
+	ReflectDest* d = (ReflectDest*)dest(n);
+	if (d == 0)
+		return;
+	d->rate = kbps * 1000. / 8.;
+	/* at least a couple of packets, so any one can get through */
+	d->depth = d->rate * REFLECT_BURST;
+	if (d->depth < 2 * PKTBUF_SIZE)
+		d->depth = 2 * PKTBUF_SIZE;
+	d->tokens = d->depth;
+	d->last = gettimeofday_usecs() / 1e6;
+	/* what was waiting on the old rate */
+	drain(d->last);
+	schedule();
+}
+
+void Reflector::echo(int n, int on)
+{
+	ReflectDest* d = (ReflectDest*)dest(n);
+	if (d != 0)
+		d->echo = on;
+}
+
+void Reflector::batch(int on)
+{
+	batch_ = on;
+}
+
+/*
+ * Whether d takes packets from ssrc.  Unless asked to, a destination
+ * doesn't get back what its own host sent, so a site both sending to
+ * the reflector and listening to it doesn't see itself twice.
+ */
+int Reflector::accept(ReflectDest* d, u_int32_t ssrc, u_int32_t from)
+{
+	if (!d->echo && d->addr.sin_addr.s_addr == from)
+		return (0);
+	if (d->nssrc == 0)
+		return (1);
+	for (int i = 0; i < d->nssrc; ++i)
+		if (d->ssrc[i] == ssrc)
+			return (1);
+	return (0);
+}
+
+void Reflector::fill(ReflectDest* d, double now)
+{
+	d->tokens += (now - d->last) * d->rate;
+	if (d->tokens > d->depth)
+		d->tokens = d->depth;
+	d->last = now;
+}
+
+void Reflector::queue(ReflectDest* d, pktbuf*& copy, pktbuf* pb)
+{
+	if (d->qlen == REFLECT_QLEN) {
+		++d->ndrop;
+		return;
+	}
+	if (copy == 0)
+		copy = (pktbuf*)pb->copy();
+	copy->attach();
+	d->q[(d->qhead + d->qlen) % REFLECT_QLEN] = copy;
+	++d->qlen;
+	++d->ndelay;
+}
+
+void Reflector::add(ReflectDest* d, const u_char* bp, int len, int port,
+		    int ctrl)
+{
+	if (nmsg_ == REFLECT_BATCH)
+		flush();
+	msg* m = &msg_[nmsg_++];
+	m->addr = d->addr;
+	m->addr.sin_port = htons(port);
+	m->bp = bp;
+	m->len = len;
+	m->d = d;
+	m->ctrl = ctrl;
+}
+
+/* send what add() has lined up, in one call where we can */
+void Reflector::flush()
+{
+	int ok[REFLECT_BATCH];
+	int i;
+	for (i = 0; i < nmsg_; ++i)
+		ok[i] = 1;
+#ifdef HAVE_SENDMMSG
+	if (batch_) {
+		mmsghdr mh[REFLECT_BATCH];
+		iovec iov[REFLECT_BATCH];
+		memset(mh, 0, nmsg_ * sizeof(mh[0]));
+		for (i = 0; i < nmsg_; ++i) {
+			iov[i].iov_base = (void*)msg_[i].bp;
+			iov[i].iov_len = msg_[i].len;
+			mh[i].msg_hdr.msg_name = &msg_[i].addr;
+			mh[i].msg_hdr.msg_namelen = sizeof(msg_[i].addr);
+			mh[i].msg_hdr.msg_iov = &iov[i];
+			mh[i].msg_hdr.msg_iovlen = 1;
+		}
+		for (i = 0; i < nmsg_; ) {
+			int n = sendmmsg(fd_, mh + i, nmsg_ - i, 0);
+			if (n < 0) {
+				if (errno == EINTR)
+					continue;
+				/* message i failed; go on from the next */
+				ok[i++] = 0;
+			} else
+				i += n;
+		}
+	} else
+#endif
+	for (i = 0; i < nmsg_; ++i)
+		if (sendto(fd_, (const char*)msg_[i].bp, msg_[i].len, 0,
+			   (sockaddr*)&msg_[i].addr,
+			   sizeof(msg_[i].addr)) < 0)
+			ok[i] = 0;
+
+	for (i = 0; i < nmsg_; ++i) {
+		ReflectDest* d = msg_[i].d;
+		if (!ok[i])
+			++d->nerror;
+		else if (msg_[i].ctrl)
+			++d->nctrl;
+		else {
+			++d->npkt;
+			d->nbyte += msg_[i].len;
+		}
+	}
+	nmsg_ = 0;
+}
+
+void Reflector::forward(pktbuf* pb, u_int32_t from)
+{
+	u_int32_t ssrc = ((rtphdr*)pb->dp)->rh_ssrc;
+	double now = 0.;
+	pktbuf* copy = 0;
+	for (int i = 0; i < REFLECT_MAXDEST; ++i) {
+		ReflectDest* d = dest_[i];
+		if (d == 0)
+			continue;
+		if (!accept(d, ssrc, from)) {
+			if (d->nssrc != 0)
+				++d->nfilter;
+			continue;
+		}
+		if (d->rate > 0.) {
+			if (now == 0.)
+				now = gettimeofday_usecs() / 1e6;
+			fill(d, now);
+			if (d->qlen > 0 || d->tokens < pb->len) {
+				queue(d, copy, pb);
+				continue;
+			}
+			d->tokens -= pb->len;
+		}
+		add(d, pb->dp, pb->len,
+		    ntohs(d->addr.sin_port) + 2 * pb->layer, 0);
+	}
+	flush();
+	if (copy != 0) {
+		/* the queues have their own references */
+		copy->release();
+		schedule();
+	}
+}
+
+void Reflector::forward(const u_char* bp, int len, int layer,
+			u_int32_t ssrc, u_int32_t from)
+{
+	for (int i = 0; i < REFLECT_MAXDEST; ++i) {
+		ReflectDest* d = dest_[i];
+		if (d != 0 && accept(d, ssrc, from))
+			add(d, bp, len, ntohs(d->addr.sin_port) + 2 * layer + 1, 1);
+	}
+	flush();
+}
+
+/* send what the buckets now have room for */
+void Reflector::drain(double now)
+{
+	pktbuf* sent[REFLECT_MAXDEST * REFLECT_QLEN];
+	int nsent = 0;
+	for (int i = 0; i < REFLECT_MAXDEST; ++i) {
+		ReflectDest* d = dest_[i];
+		if (d == 0 || d->qlen == 0)
+			continue;
+		fill(d, now);
+		while (d->qlen > 0) {
+			pktbuf* pb = d->q[d->qhead];
+			if (d->rate > 0. && d->tokens < pb->len)
+				break;
+			d->tokens -= pb->len;
+			add(d, pb->dp, pb->len,
+			    ntohs(d->addr.sin_port) + 2 * pb->layer, 0);
+			sent[nsent++] = pb;
+			d->qhead = (d->qhead + 1) % REFLECT_QLEN;
+			--d->qlen;
+		}
+	}
+	flush();
+	while (--nsent >= 0)
+		sent[nsent]->release();
+}
+
+/* run the timer for when the first waiting packet fits */
+void Reflector::schedule()
+{
+	double wait = -1.;
+	for (int i = 0; i < REFLECT_MAXDEST; ++i) {
+		ReflectDest* d = dest_[i];
+		if (d == 0 || d->qlen == 0)
+			continue;
+		double t = 0.;
+		if (d->rate > 0. && d->tokens < d->q[d->qhead]->len)
+			t = (d->q[d->qhead]->len - d->tokens) / d->rate;
+		if (wait < 0. || t < wait)
+			wait = t;
+	}
+	cancel();
+	if (wait >= 0.)
+		usched(1e6 * wait);
+}
+
+void Reflector::timeout()
+{
+	double now = gettimeofday_usecs() / 1e6;
+	drain(now);
+	schedule();
+}
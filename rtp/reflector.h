@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef vic_reflector_h
+#define vic_reflector_h
+
+#include "config.h"
+#include "pktbuf.h"
+#include "timer.h"
+#ifndef WIN32
+#include <netinet/in.h>
+#endif
+
+/*
+ * Unicast fan-out of a session, for sites without multicast.  The
+ * data packets SessionManager has validated (and the RTCP packets
+ * with them) are relayed, undecoded, to each destination on the
+ * list, layer n going to the destination's port plus 2n as vic
+ * lays out its own ports.
+ *
+ * The received pktbuf goes out to all the destinations at once,
+ * one sendmmsg (where there is one) with an address per message
+ * and every iovec on the same bytes.  A destination can be held to
+ * a list of ssrcs and to a rate; a packet over its rate waits in a
+ * queue of its own, drained by the timer, and one that finds the
+ * queue full is dropped.  Waiting packets are copies, made once
+ * for all the destinations they wait for, since the session goes
+ * on to squeeze the csrcs out of the original and the decoders may
+ * write to it.
+ */
+
+#define REFLECT_MAXDEST	32	/* destinations */
+#define REFLECT_MAXSSRC	8	/* ssrcs a destination can be held to */
+#define REFLECT_QLEN	64	/* packets waiting on a destination */
+#define REFLECT_BURST	0.1	/* seconds of its rate a destination may burst */
+#define REFLECT_BATCH	64	/* messages per sendmmsg */
+
+struct ReflectDest {
+	sockaddr_in addr;	/* data port of layer 0 */
+	u_int32_t ssrc[REFLECT_MAXSSRC];	/* network order */
+	int nssrc;		/* 0 for any */
+	int echo;		/* true to send it its own host's packets */
+	double rate;		/* bytes a second, 0 for no limit */
+	double depth;		/* bucket size (bytes) */
+	double tokens;
+	double last;		/* when the bucket was last filled */
+	pktbuf* q[REFLECT_QLEN];
+	int qhead;
+	int qlen;
+
+	u_int32_t npkt;		/* packets and bytes sent */
+	u_int32_t nbyte;
+	u_int32_t nctrl;	/* rtcp packets sent */
+	u_int32_t nfilter;	/* left out by the ssrc list */
+	u_int32_t ndelay;	/* held back by the rate */
+	u_int32_t ndrop;	/* queue full */
+	u_int32_t nerror;	/* send failed */
+};
+
+class Reflector : public Timer {
+    public:
+	Reflector();
+	virtual ~Reflector();
+	/*
+	 * Add a destination (addr in network order) and return its
+	 * number, or -1 if there are too many.
+	 */
+	int add(u_int32_t addr, int port);
+	void remove(int n);
+	inline const ReflectDest* dest(int n) const {
+		return (n >= 0 && n < REFLECT_MAXDEST ? dest_[n] : 0);
+	}
+	inline int ndest() const { return (ndest_); }
+	/* ssrcs (network order) for destination n, none for any */
+	void ssrc(int n, const u_int32_t* ssrc, int cnt);
+	/* kbps for destination n, 0 for no limit */
+	void rate(int n, int kbps);
+	void echo(int n, int on);
+	/* use sendmmsg where there is one (the default) */
+	void batch(int on);
+
+	/*
+	 * Relay the data packet pb, come in from host `from' (network
+	 * order).  The caller keeps its reference.
+	 */
+	void forward(pktbuf* pb, u_int32_t from);
+	/* relay a compound rtcp packet from ssrc, unshaped */
+	void forward(const u_char* bp, int len, int layer, u_int32_t ssrc,
+		     u_int32_t from);
+    protected:
+	virtual void timeout();
+	int accept(ReflectDest* d, u_int32_t ssrc, u_int32_t from);
+	void fill(ReflectDest* d, double now);
+	void queue(ReflectDest* d, pktbuf*& copy, pktbuf* pb);
+	void drain(double now);
+	void schedule();
+	void add(ReflectDest* d, const u_char* bp, int len, int port,
+		 int ctrl);
+	void flush();
+
+	ReflectDest* dest_[REFLECT_MAXDEST];
+	int ndest_;
+	int fd_;
+	int batch_;
+
+	/* the messages going out next */
+	int nmsg_;
+	struct msg {
+		sockaddr_in addr;
+		const u_char* bp;
+		int len;
+		ReflectDest* d;
+		int ctrl;
+	} msg_[REFLECT_BATCH];
+};
+
+#endif
@@ -58,6 +58,8 @@
 #define RTP_PT_MPEG4		45
 #define RTP_PT_H264		96	/* RFC3984 compliant H.264 */
 #define RTP_PT_H264_IOCOM	107	/* IOCOM.com's IG2 proprietary H.264*/
+#define RTP_PT_RTX		98	/* RFC4588 retransmission (dynamic) */
+#define RTP_PT_ULPFEC		99	/* RFC5109 parity (dynamic) */
 
 /* backward compat hack for decoding RTPv1 ivs streams */
 #define RTP_PT_H261_COMPAT 127
@@ -137,6 +139,11 @@ struct rtcp_rr {
 #define 	RTCP_SDES_PRIV	8	/* private SDES extensions */
 #define RTCP_PT_BYE	203	/* end of participation */
 #define RTCP_PT_APP	204	/* application specific functions */
+#define RTCP_PT_RTPFB	205	/* transport layer feedback (RFC4585) */
+#define 	RTCP_FB_NACK	1	/* generic nack */
+#define RTCP_PT_PSFB	206	/* payload specific feedback (RFC4585) */
+#define 	RTCP_FB_PLI	1	/* picture loss indication */
+#define 	RTCP_FB_FIR	4	/* full intra request (RFC5104) */
 
 #define		RTCP_SDES_MIN	1
 #define		RTCP_SDES_MAX	7
@@ -185,6 +192,26 @@ struct jpeghdr {
 	u_int8_t height;	/* 1/8 frame height */
 };
 
+/*
+ * With 64 added to the type, the scan has restart markers and
+ * this header follows (RFC 2435):
+ *
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |       Restart Interval        |F|L|       Restart Count       |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *
+ * Restart Interval = MCUs from one restart marker to the next
+ * F, L = the packet starts, ends a chunk of whole intervals
+ * Restart Count = the chunk's first interval (0x3fff if the
+ * packets aren't cut on interval boundaries)
+ */
+#define JPEG_TYPE_RESTART 64
+
+struct jpegrsthdr {
+	u_int16_t dri;		/* restart interval */
+	u_int16_t count;	/* F, L and restart count */
+};
+
 /*
  * NV encapsulation.
  */
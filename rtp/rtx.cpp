@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "rtp.h"
+#include "rtx.h"
+
+RtxHistory::RtxHistory()
+{
+	memset(slot_, 0, sizeof(slot_));
+}
+
+RtxHistory::~RtxHistory()
+{
+	clear();
+}
+
+void RtxHistory::clear()
+{
+	for (int i = 0; i < RTX_HISTORY; ++i) {
+		if (slot_[i].pb != 0) {
+			slot_[i].pb->release();
+			slot_[i].pb = 0;
+		}
+	}
+}
+
+void RtxHistory::keep(pktbuf* pb, double now)
+{
+	u_int16_t seqno = ntohs(((rtphdr*)pb->dp)->rh_seqno);
+	slot* s = &slot_[seqno & (RTX_HISTORY - 1)];
+	if (s->pb != 0)
+		s->pb->release();
+	pb->attach();
+	s->pb = pb;
+	s->seqno = seqno;
+	s->sent = now;
+	s->rtx = -1.;
+}
+
+pktbuf* RtxHistory::lookup(u_int16_t seqno, double now)
+{
+	slot* s = &slot_[seqno & (RTX_HISTORY - 1)];
+	if (s->pb == 0 || s->seqno != seqno || now - s->sent > RTX_MAXAGE)
+		return (0);
+	if (s->rtx >= 0. && now - s->rtx < RTX_HOLDOFF)
+		return (0);
+	s->rtx = now;
+	return (s->pb);
+}
+
+NackList::NackList()
+	: nlost_(0), nnack_(0), nrepaired_(0), ngaveup_(0),
+	  delay_(0.), maxdelay_(0.)
+{
+}
+
+void NackList::remove(int i)
+{
+	--nlost_;
+	memmove(&lost_[i], &lost_[i + 1], (nlost_ - i) * sizeof(lost_[0]));
+}
+
+void NackList::gap(u_int16_t from, u_int16_t to, double now, int fmt)
+{
+	if (u_int16_t(to - from) > NACK_MAXGAP)
+		return;
+	for (u_int16_t s = from; s != to; ++s) {
+		if (nlost_ == NACK_MAXLOST) {
+			/* make room by giving up on the oldest */
+			remove(0);
+			++ngaveup_;
+		}
+		lost* l = &lost_[nlost_++];
+		l->seqno = s;
+		l->fmt = fmt;
+		l->tries = 0;
+		l->when = now;
+		l->next = now;
+	}
+}
+
+int NackList::arrived(u_int16_t seqno, double now)
+{
+	for (int i = 0; i < nlost_; ++i) {
+		if (lost_[i].seqno == seqno) {
+			double d = now - lost_[i].when;
+			delay_ += d;
+			if (d > maxdelay_)
+				maxdelay_ = d;
+			++nrepaired_;
+			remove(i);
+			return (1);
+		}
+	}
+	return (0);
+}
+
+int NackList::format(u_int16_t seqno) const
+{
+	for (int i = 0; i < nlost_; ++i)
+		if (lost_[i].seqno == seqno)
+			return (lost_[i].fmt);
+	return (-1);
+}
+
+void NackList::forget(u_int16_t seqno)
+{
+	for (int i = 0; i < nlost_; ++i) {
+		if (lost_[i].seqno == seqno) {
+			remove(i);
+			return;
+		}
+	}
+}
+
+void NackList::heard(u_int16_t pid, u_int16_t blp, double now)
+{
+	for (int i = 0; i < nlost_; ++i) {
+		lost* l = &lost_[i];
+		u_int16_t d = l->seqno - pid;
+		if (d > 16 || (d > 0 && !(blp & 1 << (d - 1))))
+			continue;
+		if (l->next < now + NACK_RETRY) {
+			++l->tries;
+			l->next = now + NACK_RETRY;
+		}
+	}
+}
+
+double NackList::due() const
+{
+	double t = -1.;
+	for (int i = 0; i < nlost_; ++i)
+		if (t < 0. || lost_[i].next < t)
+			t = lost_[i].next;
+	return (t);
+}
+
+int NackList::build(u_int32_t* fci, int n, double now)
+{
+	int i;
+	for (i = 0; i < nlost_; ) {
+		lost* l = &lost_[i];
+		if ((l->tries >= NACK_TRIES && now >= l->next) ||
+		    now - l->when > RTX_MAXAGE) {
+			remove(i);
+			++ngaveup_;
+		} else
+			++i;
+	}
+	/*
+	 * Each entry names one packet and carries a bit for each of
+	 * the 16 after it, so a burst goes in one entry.
+	 */
+	int k = 0;
+	int sent[NACK_MAXLOST];
+	for (i = 0; i < nlost_; ++i)
+		sent[i] = lost_[i].next > now;
+	for (i = 0; i < nlost_ && k < n; ++i) {
+		if (sent[i])
+			continue;
+		u_int16_t pid = lost_[i].seqno;
+		u_int32_t blp = 0;
+		for (int j = i; j < nlost_; ++j) {
+			u_int16_t d = lost_[j].seqno - pid;
+			if (sent[j] || d > 16)
+				continue;
+			if (d > 0)
+				blp |= 1 << (d - 1);
+			sent[j] = 1;
+			++lost_[j].tries;
+			lost_[j].next = now + NACK_RETRY;
+			++nnack_;
+		}
+		fci[k++] = pid << 16 | blp;
+	}
+	return (k);
+}
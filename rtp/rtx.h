@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef vic_rtx_h
+#define vic_rtx_h
+
+#include "config.h"
+#include "pktbuf.h"
+
+/*
+ * Repair of lost packets by retransmission.  Receivers ask for the
+ * packets missing from the sequence space with RTCP generic NACKs
+ * (RFC 4585); the sender keeps what it sent lately and answers with
+ * the RFC 4588 retransmission payload, the original packet with its
+ * sequence number prepended, in a stream of its own (its own ssrc,
+ * payload type and sequence numbers).  The receiver undoes that and
+ * hands the packet to the decoder as if it had come in late.
+ */
+
+#define RTX_HISTORY	256	/* packets kept per layer (power of 2) */
+#define RTX_MAXAGE	1.	/* seconds a packet is worth repairing */
+#define RTX_HOLDOFF	0.05	/* seconds between repairs of one packet */
+
+#define NACK_MAXLOST	64	/* missing packets tracked per layer */
+#define NACK_MAXGAP	32	/* larger gaps are left to the decoder */
+#define NACK_TRIES	3	/* times a packet is asked for */
+#define NACK_RETRY	0.1	/* seconds between asking */
+
+/*
+ * The sender side: a ring of the packets last sent on one layer,
+ * indexed by sequence number.  Each holds a reference (attach) to
+ * the pktbuf that went out, so nothing is copied until a packet is
+ * asked for; the reference is dropped when the slot is reused.
+ */
+class RtxHistory {
+    public:
+	RtxHistory();
+	~RtxHistory();
+	void keep(pktbuf* pb, double now);
+	/*
+	 * The packet with sequence number seqno if it is still held,
+	 * isn't too old to be of use and wasn't repaired just now
+	 * (for another receiver asking for the same one), else 0.
+	 */
+	pktbuf* lookup(u_int16_t seqno, double now);
+	void clear();
+    protected:
+	struct slot {
+		pktbuf* pb;
+		u_int16_t seqno;
+		double sent;	/* when it went out */
+		double rtx;	/* when it was last repaired */
+	};
+	slot slot_[RTX_HISTORY];
+};
+
+/*
+ * The receiver side: the packets found missing on one layer of a
+ * source, with when they went missing and how often they were asked
+ * for.  The sequence gaps come from the receive path; a packet
+ * arriving (late or repaired) takes its entry out.
+ */
+class NackList {
+    public:
+	NackList();
+	/*
+	 * seqnos from up to (but not including) to are missing; fmt is
+	 * the payload type they were most likely sent with (that of the
+	 * packet after them), which a retransmission doesn't carry.
+	 */
+	void gap(u_int16_t from, u_int16_t to, double now, int fmt);
+	/* seqno arrived; true if it was missing */
+	int arrived(u_int16_t seqno, double now);
+	/* the fmt given for seqno if it is missing, else -1 */
+	int format(u_int16_t seqno) const;
+	inline int missing(u_int16_t seqno) const {
+		return (format(seqno) >= 0);
+	}
+	/* stop asking for seqno, without counting it either way */
+	void forget(u_int16_t seqno);
+	/*
+	 * Another receiver asked for pid and those flagged in blp: count
+	 * it as our asking, since the repair comes to us too.
+	 */
+	void heard(u_int16_t pid, u_int16_t blp, double now);
+	/*
+	 * Fill fci with the generic NACK entries (packet id and bitmask
+	 * of the 16 that follow, host order) for the packets due to be
+	 * asked for at time now, at most n of them, and return how many.
+	 * Packets asked for NACK_TRIES times or older than RTX_MAXAGE
+	 * are given up on.
+	 */
+	int build(u_int32_t* fci, int n, double now);
+	/* time the next packet is due to be asked for, or < 0 */
+	double due() const;
+	inline int pending() const { return (nlost_); }
+
+	inline u_int32_t nnack() const { return (nnack_); }
+	inline u_int32_t nrepaired() const { return (nrepaired_); }
+	inline u_int32_t ngaveup() const { return (ngaveup_); }
+	/* mean and max time from going missing to arriving (seconds) */
+	inline double delay() const {
+		return (nrepaired_ ? delay_ / nrepaired_ : 0.);
+	}
+	inline double maxdelay() const { return (maxdelay_); }
+    protected:
+	struct lost {
+		u_int16_t seqno;
+		int fmt;
+		int tries;
+		double when;	/* went missing */
+		double next;	/* due to be asked for */
+	};
+	void remove(int i);
+
+	lost lost_[NACK_MAXLOST];
+	int nlost_;
+	u_int32_t nnack_;	/* packets asked for */
+	u_int32_t nrepaired_;
+	u_int32_t ngaveup_;
+	double delay_;
+	double maxdelay_;
+};
+
+#endif
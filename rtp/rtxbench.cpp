@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * rtxbench - run packet repair by retransmission over an emulated
+ * lossy path.
+ *
+ * usage: rtxbench [-l loss] [-b burst] [-d delay] [-r kbps] [-s size]
+ *		   [-t time] [-S seed]
+ *
+ * A sender sends packets of `size' bytes (1000) at `kbps' (1000)
+ * for `time' seconds (60), keeping each in an RtxHistory, over a
+ * path with a one-way delay of `delay' ms (40) that loses `loss'
+ * percent (2) of the packets both ways, in bursts of `burst' packets
+ * on average (1, i.e. independent losses; a Gilbert model).  The
+ * receiver tracks the gaps in a NackList and sends nacks as
+ * SessionManager does with a single peer: in an early packet at once
+ * (RFC 4585 3.5, no dither), but only one of those per report
+ * interval, the rest with the next regular report, which comes every
+ * 360 / `kbps' seconds give or take half that (the reduced minimum).
+ * The sender answers with RFC 4588 packets, which can be lost too.
+ *
+ * Printed are the packets lost and repaired, the loss left after
+ * repair, the repair latency (from when the packet would have come
+ * in to when its repair did) and the bytes spent on retransmissions
+ * and nacks against the media bytes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../config.h"
+#include "../bench.h"
+#include "rtp.h"
+#include "rtx.h"
+
+#define RTCP_EARLYHDR	44	/* empty rr, cname, fb header, media ssrc */
+#define RTCP_NACKHDR	12	/* fb header and media ssrc */
+
+/* events on the path, in time order */
+enum { SEND, ARRIVE, REPAIR, NACK, TIMER, REPORT };
+struct event {
+	double t;
+	int type;
+	u_int16_t seqno;
+	int nfci;
+	u_int32_t fci[NACK_MAXLOST];
+};
+
+static event* heap;
+static int nheap;
+static int maxheap;
+
+static void push(const event& e)
+{
+	if (nheap == maxheap) {
+		maxheap = maxheap ? 2 * maxheap : 1024;
+		heap = (event*)realloc(heap, maxheap * sizeof(event));
+	}
+	int i = nheap++;
+	while (i > 0 && heap[(i - 1) / 2].t > e.t) {
+		heap[i] = heap[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	heap[i] = e;
+}
+
+static event pop()
+{
+	event e = heap[0];
+	event last = heap[--nheap];
+	int i = 0;
+	for (;;) {
+		int c = 2 * i + 1;
+		if (c >= nheap)
+			break;
+		if (c + 1 < nheap && heap[c + 1].t < heap[c].t)
+			++c;
+		if (heap[c].t >= last.t)
+			break;
+		heap[i] = heap[c];
+		i = c;
+	}
+	heap[i] = last;
+	return (e);
+}
+
+static bench_loss gilbert;
+
+static NackList nl;
+static double timer = -1.;	/* the receiver's nack timer */
+static int early = 1;		/* true if an early packet may go */
+static int rev;			/* loss state of the way back */
+static int nnack;
+static int nearly;
+static double bnack;
+static double delay;
+
+static void schedule(double t)
+{
+	if (timer < 0. || t < timer) {
+		timer = t;
+		event e;
+		e.t = t;
+		e.type = TIMER;
+		e.nfci = 0;
+		push(e);
+	}
+}
+
+/*
+ * As SessionManager::feedback_timeout, or send_report for a regular
+ * report, which lets the next early packet go.
+ */
+static void send_nacks(double now, int regular)
+{
+	event e;
+	e.type = NACK;
+	e.nfci = 0;
+	if (regular || early)
+		e.nfci = nl.build(e.fci, NACK_MAXLOST, now);
+	if (e.nfci > 0) {
+		++nnack;
+		bnack += RTCP_NACKHDR + 4 * e.nfci;
+		if (!regular) {
+			bnack += RTCP_EARLYHDR - RTCP_NACKHDR;
+			++nearly;
+			early = 0;
+		}
+		if (!bench_lose(&gilbert, &rev)) {
+			e.t = now + delay;
+			push(e);
+		}
+	}
+	if (regular)
+		early = 1;
+	double due = nl.due();
+	if (due >= 0. && early)
+		schedule(due > now ? due : now + 1e-3);
+}
+
+static int cmp(const void* a, const void* b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x < y ? -1 : x > y);
+}
+
+static const char synopsis[] =
+	"rtxbench [-l loss] [-b burst] [-d delay] "
+	"[-r kbps] [-s size]\n\t\t[-t time] [-S seed]\n";
+
+int main(int argc, char** argv)
+{
+	double loss = 2.;
+	double burst = 1.;
+	delay = .04;
+	int kbps = 1000;
+	int size = 1000;
+	double duration = 60.;
+	long seed = 1;
+	int op;
+	while ((op = getopt(argc, argv, "l:b:d:r:s:t:S:")) != -1) {
+		switch (op) {
+		case 'l':
+			loss = atof(optarg);
+			break;
+		case 'b':
+			burst = atof(optarg);
+			break;
+		case 'd':
+			delay = atof(optarg) / 1e3;
+			break;
+		case 'r':
+			kbps = atoi(optarg);
+			break;
+		case 's':
+			size = atoi(optarg);
+			break;
+		case 't':
+			duration = atof(optarg);
+			break;
+		case 'S':
+			seed = atol(optarg);
+			break;
+		default:
+			bench_usage(synopsis);
+		}
+	}
+	if (optind != argc || loss < 0. || loss >= 100. || burst < 1. ||
+	    kbps <= 0 || size < int(sizeof(rtphdr)) || size > RTP_MTU ||
+	    duration <= 0.)
+		bench_usage(synopsis);
+	srand48(seed);
+	bench_loss_init(&gilbert, loss, burst);
+
+	BufferPool pool;
+	RtxHistory hist;
+	int fwd = 0;			/* loss state of the way there */
+
+	double interval = 8. * size / (1e3 * kbps);
+	double rint = 360. / kbps;
+	int npkt = int(duration / interval);
+	if (npkt > 65536)
+		/* once around the sequence space */
+		npkt = 65536;
+	double* due = new double[npkt];	/* when each would have come in */
+	double* latency = new double[npkt];
+	int nlatency = 0;
+	int nsent = 0, nlost = 0, nrtx = 0;
+	double brtx = 0.;
+	int high = -1;			/* highest seqno in */
+
+	event e;
+	memset(&e, 0, sizeof(e));
+	for (int i = 0; i < npkt; ++i) {
+		e.t = i * interval;
+		e.type = SEND;
+		e.seqno = i;
+		push(e);
+	}
+	e.t = rint * drand48();
+	e.type = REPORT;
+	push(e);
+	while (nheap > 0) {
+		e = pop();
+		double now = e.t;
+		switch (e.type) {
+
+		case SEND: {
+			/* the transmitter keeps it and lets go of its own ref */
+			pktbuf* pb = pool.alloc();
+			rtphdr* rh = (rtphdr*)pb->dp;
+			memset(rh, 0, sizeof(*rh));
+			rh->rh_flags = htons(RTP_VERSION << 14);
+			rh->rh_seqno = htons(e.seqno);
+			pb->len = size;
+			hist.keep(pb, now);
+			pb->release();
+			++nsent;
+			due[e.seqno] = now + delay;
+			if (bench_lose(&gilbert, &fwd)) {
+				++nlost;
+				break;
+			}
+			e.t = now + delay;
+			e.type = ARRIVE;
+			push(e);
+			break;
+		}
+
+		case ARRIVE:
+			/* sequence numbers don't wrap within a run */
+			if (e.seqno > high + 1 && high >= 0) {
+				nl.gap(high + 1, e.seqno, now, RTP_PT_H261);
+				send_nacks(now, 0);
+			} else
+				nl.arrived(e.seqno, now);
+			if (e.seqno > high)
+				high = e.seqno;
+			break;
+
+		case REPAIR:
+			if (nl.arrived(e.seqno, now))
+				latency[nlatency++] = now - due[e.seqno];
+			break;
+
+		case NACK:
+			/* the sender answers */
+			for (int i = 0; i < e.nfci; ++i) {
+				u_int16_t pid = e.fci[i] >> 16;
+				for (int k = 0; k <= 16; ++k) {
+					if (k > 0 && !(e.fci[i] & 1 << (k - 1)))
+						continue;
+					u_int16_t s = pid + k;
+					pktbuf* pb = hist.lookup(s, now);
+					if (pb == 0)
+						continue;
+					++nrtx;
+					brtx += pb->len + 2;
+					if (bench_lose(&gilbert, &fwd))
+						continue;
+					event r;
+					r.t = now + delay;
+					r.type = REPAIR;
+					r.seqno = s;
+					r.nfci = 0;
+					push(r);
+				}
+			}
+			break;
+
+		case TIMER:
+			if (now != timer)
+				/* superseded by an earlier one */
+				break;
+			timer = -1.;
+			send_nacks(now, 0);
+			break;
+
+		case REPORT:
+			send_nacks(now, 1);
+			if (now < npkt * interval + RTX_MAXAGE) {
+				e.t = now + rint * (.5 + drand48());
+				push(e);
+			}
+			break;
+		}
+	}
+	int nrepaired = nlatency;
+	double sum = 0.;
+	for (int i = 0; i < nlatency; ++i)
+		sum += latency[i];
+	qsort(latency, nlatency, sizeof(double), cmp);
+	double media = double(nsent) * size;
+
+	printf("sent %d, lost %d (%.2f%%), repaired %d, unrepaired %d\n",
+	       nsent, nlost, 100. * nlost / nsent, nrepaired,
+	       nlost - nrepaired);
+	printf("loss after repair %.3f%%\n",
+	       100. * (nlost - nrepaired) / nsent);
+	if (nlatency > 0)
+		printf("repair latency mean %.1f  p50 %.1f  p95 %.1f  "
+		       "max %.1f ms (rtt %.0f ms)\n", 1e3 * sum / nlatency,
+		       1e3 * latency[nlatency / 2],
+		       1e3 * latency[nlatency * 95 / 100],
+		       1e3 * latency[nlatency - 1], 2e3 * delay);
+	printf("overhead: %d retransmissions %.0f bytes (%.2f%%), "
+	       "%d nacks %.0f bytes (%.2f%%)\n", nrtx, brtx,
+	       100. * brtx / media, nnack, bnack, 100. * bnack / media);
+	printf("nack list: %u asked, %u given up; %d of %d nack packets "
+	       "early\n", nl.nnack(), nl.ngaveup(), nearly, nnack);
+	delete[] due;
+	delete[] latency;
+	return (0);
+}
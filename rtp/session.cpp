@@ -44,6 +44,8 @@ static const char rcsid[] =
 #include "timer.h"
 #include "ntp-time.h"
 #include "session.h"
+#include "reflector.h"
+#include "trace.h"
 
 /* added to support the mbus 
 #include "mbus_handler.h"*/
@@ -61,6 +63,16 @@ static class SessionMatcher : public Matcher {
 		}
 } session_matcher;
 
+/*
+ * Video receivers ask for key frames, and may for lost packets, so
+ * they report at the pace of RFC 4585 rather than RFC 3550.
+ */
+VideoSessionManager::VideoSessionManager()
+{
+	for (int i = 0; i < NLAYER; ++i)
+		ch_[i].avpf(1);
+}
+
 int VideoSessionManager::check_format(int fmt) const
 {
 	switch(fmt) {
@@ -116,6 +128,16 @@ adios()
 sm_.send_report();
 }*/
 
+void NackTimer::timeout()
+{
+	sm_.feedback_timeout();
+}
+
+void KeyTimer::timeout()
+{
+	sm_.key_timeout();
+}
+
 void DataHandler::dispatch(int)
 {
 	sm_->recv(this);
@@ -129,7 +151,12 @@ void CtrlHandler::dispatch(int)
 CtrlHandler::CtrlHandler()
 : ctrl_inv_bw_(0.),
 ctrl_avg_size_(128.),
-rint_(0.0) //SV-XXX: Debian
+rint_(0.0), //SV-XXX: Debian
+kbps_(0.),
+avpf_(0),
+min_(CTRL_MIN_RPT_TIME * 1000.),
+early_(1),
+fbt_(-1.)
 {
 }
 
@@ -153,13 +180,40 @@ void CtrlHandler::net(Network* n)
 	* SRs instead of RRs).
 		*/
 		double rint = ctrl_avg_size_ * ctrl_inv_bw_;
-		if (rint < CTRL_MIN_RPT_TIME / 2. * 1000.)
-			rint = CTRL_MIN_RPT_TIME / 2. * 1000.;
+		if (rint < min_ / 2.)
+			rint = min_ / 2.;
 		rint_ = rint;
 		schedule_timer();
 	}
 }
 
+/*
+ * The session bandwidth in kb/s, which is bytes/ms over 8.
+ */
+void CtrlHandler::bandwidth(double kbps)
+{
+	if (kbps <= 0.)
+		return;
+	kbps_ = kbps;
+	ctrl_inv_bw_ = 1. / (kbps / 8. * CTRL_SESSION_BW_FRACTION);
+	avpf(avpf_);
+}
+
+/*
+ * A receiver giving feedback reports more often: the 5 second
+ * minimum would leave it one early packet per 5 seconds (RFC 4585
+ * 3.5), so the interval falls to the reduced minimum instead, once
+ * the session bandwidth is known.
+ */
+void CtrlHandler::avpf(int on)
+{
+	avpf_ = on;
+	if (on && kbps_ > 0.)
+		min_ = CTRL_REDUCED_MIN / kbps_ * 1000.;
+	else
+		min_ = CTRL_MIN_RPT_TIME * 1000.;
+}
+
 void CtrlHandler::sample_size(int cc)
 {
 	ctrl_avg_size_ += CTRL_SIZE_GAIN * (double(cc + 28) - ctrl_avg_size_);
@@ -187,8 +241,8 @@ void CtrlHandler::adapt(int nsrc, int nrr, int we_sent)
 		}
 	}
 	double rint = ctrl_avg_size_ * double(nsrc) * ibw;
-	if (rint < CTRL_MIN_RPT_TIME * 1000.)
-		rint = CTRL_MIN_RPT_TIME * 1000.;
+	if (rint < min_)
+		rint = min_;
 	rint_ = rint;
 }
 
@@ -212,7 +266,14 @@ last_np_(0),
 sdes_seq_(0),
 rtcp_inv_bw_(0.),
 rtcp_avg_size_(128.),
-confid_(-1)
+confid_(-1),
+ratecontrol_(0),
+nack_(0),
+nt_(*this),
+kt_(*this),
+npli_(0),
+reflector_(0),
+reflectonly_(0)
 {
 	/*XXX For adios() to send bye*/
 	manager = this;
@@ -247,6 +308,7 @@ SessionManager::~SessionManager()
 	if (pktbuf_) 
 		delete[] pktbuf_;
 	
+	delete reflector_;
 	delete pool_;
 }
 
@@ -273,6 +335,18 @@ char* SessionManager::stats(char* cp) const
 	cp = onestat(cp, "Bad-Payload-Format", badfmt_);
 	cp = onestat(cp, "Bad-RTP-Extension", badext_);
 	cp = onestat(cp, "Runts", nrunt_);
+	if (hist_ != 0) {
+		cp = onestat(cp, "Retransmitted", nrtx_);
+		cp = onestat(cp, "Retransmitted-Kbits", brtx_ >> (10-3));
+	}
+	if (fecblock_ > 0)
+		cp = onestat(cp, "Fec-Packets", nfec_);
+	if (kl_.nrequest() != 0) {
+		cp = onestat(cp, "Key-Requests", kl_.nrequest());
+		cp = onestat(cp, "Key-Frames-Forced", kl_.nforced());
+	}
+	if (npli_ != 0)
+		cp = onestat(cp, "Key-Requests-Sent", npli_);
 	Crypt* p = dh_[0].net()->crypt();
 	if (p != 0) {
 		cp = onestat(cp, "Crypt-Bad-Length", p->badpktlen());
@@ -294,6 +368,8 @@ int SessionManager::command(int argc, const char*const* argv)
 {
 	Tcl& tcl = Tcl::instance();
 	char* cp = tcl.buffer();
+	if (argc >= 3 && strcmp(argv[1], "reflect") == 0)
+		return (reflect(argc, argv));
 	if (argc == 2) {
 		if (strcmp(argv[1], "active") == 0) {
 			SourceManager::instance().sortactive(cp);
@@ -331,6 +407,11 @@ int SessionManager::command(int argc, const char*const* argv)
 			tcl.result(cp);
 			return (TCL_OK);
 		}
+		if (strcmp(argv[1], "congestion-rate") == 0) {
+			sprintf(cp, "%d", rc_.kbps());
+			tcl.result(cp);
+			return (TCL_OK);
+		}
 
 	} else if (argc == 3) {
 		if (strcmp(argv[1], "sm") == 0) {
@@ -367,6 +448,8 @@ int SessionManager::command(int argc, const char*const* argv)
 		if (strcmp(argv[1], "max-bandwidth") == 0) {
 			double bw = atof(argv[2]) / 8.;
 			rtcp_inv_bw_ = 1. / (bw * RTCP_SESSION_BW_FRACTION);
+			for (int i = 0; i < NLAYER; ++i)
+				ch_[i].bandwidth(atof(argv[2]));
 			return (TCL_OK);
 		}
 		if (strcmp(argv[1], "confid") == 0) {
@@ -375,7 +458,41 @@ int SessionManager::command(int argc, const char*const* argv)
 		}
 		if (strcmp(argv[1], "data-bandwidth") == 0) {
 			/*XXX assume value in range */
-			bps(atoi(argv[2]));
+			int kbps = atoi(argv[2]);
+			rc_.limit(kbps);
+			if (ratecontrol_ && rc_.kbps() < kbps)
+				adapt_rate();
+			else
+				bps(kbps);
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "congestion-control") == 0) {
+			ratecontrol_ = atoi(argv[2]);
+			if (rc_.kbps() < rc_.limit())
+				adapt_rate();
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "retransmit") == 0) {
+			/* answer nacks and send them */
+			nack_ = atoi(argv[2]);
+			rtx(nack_ ? rtxpt_ : -1, u_int32_t(random()));
+			if (!nack_)
+				nt_.cancel();
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "fec") == 0) {
+			/* packets per parity packet, 0 for none */
+			int k = atoi(argv[2]);
+			fec(k, k > 0 && fecpt_ < 0 ? RTP_PT_ULPFEC : fecpt_);
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "fec-format") == 0) {
+			/* parity to send and recover from, < 0 for none */
+			fec(fecblock_, atoi(argv[2]));
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "rtx-format") == 0) {
+			rtxpt_ = atoi(argv[2]);
 			return (TCL_OK);
 		}
 		if (strcmp(argv[1], "mtu") == 0) {
@@ -438,6 +555,98 @@ int SessionManager::command(int argc, const char*const* argv)
 	return (TCL_ERROR);
 }
 
+/*
+ * The unicast reflector:
+ *	reflect add host port	relay to host/port, returns its number
+ *	reflect delete n
+ *	reflect ssrc n ?ssrc ...?	only these sources (none for all)
+ *	reflect rate n kbps	no more than kbps (0 for no limit)
+ *	reflect echo n 0|1	send its host's own packets back too
+ *	reflect stats n
+ *	reflect only 0|1	relay without decoding
+ */
+int SessionManager::reflect(int argc, const char*const* argv)
+{
+	Tcl& tcl = Tcl::instance();
+	char* cp = tcl.buffer();
+	if (strcmp(argv[2], "only") == 0 && argc == 4) {
+		reflectonly_ = atoi(argv[3]);
+		return (TCL_OK);
+	}
+	if (strcmp(argv[2], "add") == 0 && argc == 5) {
+		u_int32_t addr = LookupHostAddr(argv[3]);
+		if (addr == 0) {
+			tcl.resultf("unknown host %s", argv[3]);
+			return (TCL_ERROR);
+		}
+		if (reflector_ == 0)
+			reflector_ = new Reflector;
+		int n = reflector_->add(addr, atoi(argv[4]));
+		if (n < 0) {
+			tcl.result("too many reflector destinations");
+			return (TCL_ERROR);
+		}
+		sprintf(cp, "%d", n);
+		tcl.result(cp);
+		return (TCL_OK);
+	}
+	if (argc < 4 || reflector_ == 0 ||
+	    reflector_->dest(atoi(argv[3])) == 0) {
+		tcl.resultf("%s: bad reflect command", argv[0]);
+		return (TCL_ERROR);
+	}
+	int n = atoi(argv[3]);
+	if (strcmp(argv[2], "delete") == 0) {
+		reflector_->remove(n);
+		if (reflector_->ndest() == 0) {
+			delete reflector_;
+			reflector_ = 0;
+		}
+		return (TCL_OK);
+	}
+	if (strcmp(argv[2], "ssrc") == 0) {
+		u_int32_t ssrc[REFLECT_MAXSSRC];
+		int cnt = 0;
+		for (int i = 4; i < argc && cnt < REFLECT_MAXSSRC; ++i)
+			ssrc[cnt++] = htonl(strtoul(argv[i], 0, 10));
+		reflector_->ssrc(n, ssrc, cnt);
+		return (TCL_OK);
+	}
+	if (strcmp(argv[2], "rate") == 0 && argc == 5) {
+		reflector_->rate(n, atoi(argv[4]));
+		return (TCL_OK);
+	}
+	if (strcmp(argv[2], "echo") == 0 && argc == 5) {
+		reflector_->echo(n, atoi(argv[4]));
+		return (TCL_OK);
+	}
+	if (strcmp(argv[2], "stats") == 0) {
+		const ReflectDest* d = reflector_->dest(n);
+		char* bp = cp;
+		bp = onestat(bp, "Packets", d->npkt);
+		bp = onestat(bp, "Kilobits", d->nbyte >> (10-3));
+		bp = onestat(bp, "Control", d->nctrl);
+		bp = onestat(bp, "Filtered", d->nfilter);
+		bp = onestat(bp, "Delayed", d->ndelay);
+		bp = onestat(bp, "Dropped", d->ndrop);
+		bp = onestat(bp, "Send-Errors", d->nerror);
+		*--bp = 0;
+		tcl.result(cp);
+		return (TCL_OK);
+	}
+	tcl.resultf("%s: bad reflect command", argv[0]);
+	return (TCL_ERROR);
+}
+
+/* the IPv4 host of addr in network order, 0 for any other kind */
+static u_int32_t inaddr(const Address & addr)
+{
+	u_int32_t a = 0;
+	if (addr.length() == sizeof(a))
+		memcpy(&a, (const void*)addr, sizeof(a));
+	return (a);
+}
+
 void SessionManager::transmit(pktbuf* pb)
 {
 	//mh_.msg_iov = pb->iov;
@@ -465,10 +674,8 @@ u_char* SessionManager::build_sdes_item(u_char* p, int code, Source& s)
 	return (p);
 }
 
-int SessionManager::build_sdes(rtcphdr* rh, Source& ls)
+int SessionManager::build_sdes(rtcphdr* rh, Source& ls, int layer)
 {
-	int flags = RTP_VERSION << 14 | 1 << 8 | RTCP_PT_SDES;
-	rh->rh_flags = htons(flags);
 	rh->rh_ssrc = ls.srcid();
 	u_char* p = (u_char*)(rh + 1);
 	p = build_sdes_item(p, RTCP_SDES_CNAME, ls);
@@ -526,10 +733,54 @@ int SessionManager::build_sdes(rtcphdr* rh, Source& ls)
 	int len = p - (u_char*)rh;
 	int pad = 4 - (len & 3);
 	len += pad;
-	rh->rh_len = htons((len >> 2) - 1);
 	while (--pad >= 0)
 		*p++ = 0;
 
+	/*
+	 * Then a chunk for each of our other sources that sends on
+	 * this layer, with our cname, which tells receivers that the
+	 * streams come from one participant.
+	 */
+	int nchunk = 1;
+	SourceManager& sm = SourceManager::instance();
+	for (int i = 0; i < sm.nextra() && nchunk < 31; ++i) {
+		Source* s = sm.extra(i);
+		if (layer >= s->nlayer_ || s->layer(layer).np() == 0)
+			continue;
+		s->layer(layer).lts_ctrl(unixtime());
+		u_char* q = p;
+		*(u_int32_t*)p = s->srcid();
+		p = build_sdes_item(p + 4, RTCP_SDES_CNAME, ls);
+		int n = p - q;
+		pad = 4 - (n & 3);
+		len += n + pad;
+		while (--pad >= 0)
+			*p++ = 0;
+		++nchunk;
+	}
+	int flags = RTP_VERSION << 14 | nchunk << 8 | RTCP_PT_SDES;
+	rh->rh_flags = htons(flags);
+	rh->rh_len = htons((len >> 2) - 1);
+
+	return (len);
+}
+
+/*
+ * An sdes with just our cname, as a compound packet sent for
+ * feedback must carry (RFC 3550 6.1, RFC 4585 3.1).
+ */
+int SessionManager::build_cname(rtcphdr* rh, Source& ls)
+{
+	int flags = RTP_VERSION << 14 | 1 << 8 | RTCP_PT_SDES;
+	rh->rh_flags = htons(flags);
+	rh->rh_ssrc = ls.srcid();
+	u_char* p = build_sdes_item((u_char*)(rh + 1), RTCP_SDES_CNAME, ls);
+	int len = p - (u_char*)rh;
+	int pad = 4 - (len & 3);
+	len += pad;
+	rh->rh_len = htons((len >> 2) - 1);
+	while (--pad >= 0)
+		*p++ = 0;
 	return (len);
 }
 
@@ -681,7 +932,7 @@ void SessionManager::send_report(CtrlHandler* ch, int bye, int app)
 		rr->rr_loss = htonl(v);
 		//		rr->rr_ehsr = htonl(sp->ehs());
 		rr->rr_ehsr = htonl(sl.ehs());
-		rr->rr_dv = (sp->handler() != 0) ? sp->handler()->delvar() : 0;
+		rr->rr_dv = htonl(sl.jitter());
 		//		rr->rr_lsr = htonl(sp->sts_ctrl());
 		rr->rr_lsr = htonl(sl.sts_ctrl());
 		//		if (sp->lts_ctrl().tv_sec == 0)
@@ -705,7 +956,7 @@ void SessionManager::send_report(CtrlHandler* ch, int bye, int app)
 	if (bye)
 		len += build_bye((rtcphdr*)rr, s);
 	else
-		len += build_sdes((rtcphdr*)rr, s);
+		len += build_sdes((rtcphdr*)rr, s, layer);
 	
 	// build "site" app data if specified
 	const char *data = tcl.attr("site");
@@ -714,8 +965,13 @@ void SessionManager::send_report(CtrlHandler* ch, int bye, int app)
 	    rr = (rtcp_rr*)(((u_char*)rh) + len);
 	    len += build_app((rtcphdr*)rr, s, "site", (void *)data, strlen(data));
 	}
+	/* feedback held for want of an early packet rides along */
+	if (!bye)
+		len = build_fb(pktbuf_ + len, pktbuf_ + RTP_MTU, layer,
+			       gettimeofday_secs()) - pktbuf_;
 	//LLL	ch_.send(pktbuf_, len);
 	ch->send(pktbuf_, len);
+	ch->early(1);
 	
 	/*
       rtcp_avg_size_ += RTCP_SIZE_GAIN * (double(len + 28) - rtcp_avg_size_);
@@ -757,11 +1013,17 @@ void SessionManager::send_report(CtrlHandler* ch, int bye, int app)
 
 int SessionManager::build_bye(rtcphdr* rh, Source& ls)
 {
-	int flags = RTP_VERSION << 14 | 1 << 8 | RTCP_PT_BYE;
+	/* our other sources leave with us */
+	SourceManager& sm = SourceManager::instance();
+	int n = 1 + sm.nextra();
+	int flags = RTP_VERSION << 14 | n << 8 | RTCP_PT_BYE;
 	rh->rh_flags = ntohs(flags);
-	rh->rh_len = htons(1);
+	rh->rh_len = htons(n);
 	rh->rh_ssrc = ls.srcid();
-	return (8);
+	u_int32_t* p = (u_int32_t*)(rh + 1);
+	for (int i = 0; i < sm.nextra(); ++i)
+		*p++ = sm.extra(i)->srcid();
+	return (4 + 4 * n);
 }
 
 void SessionManager::recv(DataHandler* dh)
@@ -785,7 +1047,7 @@ void SessionManager::recv(DataHandler* dh)
 	if (!loopback_) {
 		rtphdr* rh = (rtphdr*)pb->data;
 		SourceManager& sm = SourceManager::instance();
-		if (rh->rh_ssrc == (*sm.localsrc()).srcid()) {
+		if (sm.local(rh->rh_ssrc) != 0) {
 			pb->release();
 			return;
 		}
@@ -805,17 +1067,211 @@ void SessionManager::recv(DataHandler* dh)
 		return;
 	}
 	pb->len = cc;
+	if (nack_ && (pb->data[1] & 0x7f) == rtxpt_) {
+		repair(pb, *addrp);
+		return;
+	}
 	
 	//bp += sizeof(*rh);
 	//cc -= sizeof(*rh);
 	demux(pb, *addrp);
 }
 
-void SessionManager::demux(pktbuf* pb, Address & addr)
+/*
+ * Undo the RFC 4588 wrapping of a retransmitted packet and pass it
+ * on as the original, come in late.  The retransmission ssrc is tied
+ * to its source the first time one comes in (RFC 4588 section 5.3):
+ * then it is the one source at the packet's address that is missing
+ * the original seqno, which track() keeps unique.  The payload type
+ * is the one the original was taken to have when it went missing.
+ */
+void SessionManager::repair(pktbuf* pb, Address & addr)
+{
+	rtphdr* rh = (rtphdr*)pb->data;
+	int flags = ntohs(rh->rh_flags);
+	int hlen = sizeof(*rh) + ((flags >> 8 & 0xf) << 2);
+	if (pb->len < hlen + 2) {
+		++nrunt_;
+		pb->release();
+		return;
+	}
+	u_int16_t osn;
+	memcpy(&osn, pb->data + hlen, 2);
+	u_int16_t seqno = ntohs(osn);
+	SourceManager& sm = SourceManager::instance();
+	Source* s;
+	for (s = sm.sources(); s != 0; s = s->next_)
+		if (s->rtxsrcid() == rh->rh_ssrc)
+			break;
+	if (s == 0) {
+		int n = 0;
+		for (Source* p = sm.sources(); p != 0; p = p->next_) {
+			if (pb->layer >= p->nlayer_ || !(p->addr() == addr))
+				continue;
+			NackList* nl = p->layer(pb->layer).nacklist();
+			if (nl != 0 && nl->missing(seqno)) {
+				s = p;
+				++n;
+			}
+		}
+		if (n != 1) {
+			/* no one (or, after a restart, not one) to give it to */
+			pb->release();
+			return;
+		}
+		s->rtxsrcid(rh->rh_ssrc);
+	}
+	int fmt = -1;
+	if (s->handler() != 0 && pb->layer < s->nlayer_) {
+		NackList* nl = s->layer(pb->layer).nacklist();
+		if (nl != 0)
+			fmt = nl->format(seqno);
+	}
+	if (fmt < 0) {
+		/* not (or no longer) missing */
+		pb->release();
+		return;
+	}
+	rh->rh_flags = htons((flags & ~0x7f) | fmt);
+	rh->rh_seqno = osn;
+	rh->rh_ssrc = s->srcid();
+	pb->len -= 2;
+	memmove(pb->data + hlen, pb->data + hlen + 2, pb->len - hlen);
+	demux(pb, addr, 1);
+}
+
+/*
+ * A parity packet.  Its ssrc is tied to its source the first time
+ * one comes in, as for retransmissions: then it is the one source at
+ * the packet's address whose sequence numbers on the layer have just
+ * passed the first one it covers.  The source's layer keeps its
+ * media packets from then on, and gets back what it can.
+ */
+void SessionManager::parity(pktbuf* pb, Address & addr)
+{
+	rtphdr* rh = (rtphdr*)pb->data;
+	if (pb->len < int(sizeof(*rh)) + FEC_HDRLEN) {
+		++nrunt_;
+		pb->release();
+		return;
+	}
+	const u_char* p = (const u_char*)(rh + 1);
+	u_int16_t base = p[2] << 8 | p[3];
+	SourceManager& sm = SourceManager::instance();
+	Source* s;
+	for (s = sm.sources(); s != 0; s = s->next_)
+		if (s->fecsrcid() == rh->rh_ssrc)
+			break;
+	if (s == 0) {
+		int n = 0;
+		for (Source* q = sm.sources(); q != 0; q = q->next_) {
+			if (q == sm.localsrc() || pb->layer >= q->nlayer_ ||
+			    !(q->addr() == addr))
+				continue;
+			u_int16_t d = q->layer(pb->layer).cs() - base;
+			if (d < FEC_WINDOW) {
+				s = q;
+				++n;
+			}
+		}
+		if (n != 1) {
+			pb->release();
+			return;
+		}
+		s->fecsrcid(rh->rh_ssrc);
+	}
+	if (reflector_ != 0)
+		reflector_->forward(pb, inaddr(addr));
+	if (s->handler() == 0 || pb->layer >= s->nlayer_) {
+		pb->release();
+		return;
+	}
+	Source::Layer& sl = s->layer(pb->layer);
+	FecDecoder* fd = sl.fecdecoder();
+	if (fd == 0) {
+		fd = new FecDecoder(s->srcid());
+		sl.fecdecoder(fd);
+	}
+	fd->parity(pb);
+	recover(fd, addr);
+}
+
+/* hand on the packets fd rebuilds like retransmitted ones */
+void SessionManager::recover(FecDecoder* fd, Address & addr)
+{
+	pktbuf* pb;
+	while ((pb = fd->recover(pool_)) != 0)
+		demux(pb, addr, 1);
+}
+
+/*
+ * Account for a data packet's seqno and return true if it is a
+ * duplicate.  A gap in the sequence is noted on the layer's nack
+ * list, with the packet's payload type, and asked for right away.
+ * Retransmissions only fill holes: they aren't counted as received,
+ * so the reception reports still tell the sender what the network
+ * lost.
+ */
+int SessionManager::track(Source* s, int layer, u_int16_t seqno, int fmt,
+			  int repair)
+{
+	Source::Layer& sl = s->layer(layer);
+	NackList* nl = sl.nacklist();
+	if (repair) {
+		if (sl.checkseq(seqno))
+			return (1);
+		if (nl != 0)
+			nl->arrived(seqno, gettimeofday_secs());
+		return (0);
+	}
+	u_int16_t c = sl.cs();
+	int dup = sl.cs(seqno, s);
+	if (!nack_)
+		return (dup);
+	if (nl == 0) {
+		nl = new NackList;
+		sl.nacklist(nl);
+	}
+	u_int16_t d = seqno - c;
+	if (d > 1 && d <= NACK_MAXGAP) {
+		nl->gap(c + 1, seqno, gettimeofday_secs(), fmt);
+		if (s->rtxsrcid() == 0)
+			unshare(s, layer, c + 1, seqno);
+		feedback_timeout();
+	} else if (!dup && nl->pending())
+		nl->arrived(seqno, gettimeofday_secs());
+	return (dup);
+}
+
+/*
+ * Until we know the ssrc of s's retransmissions, one is matched to
+ * s by the seqno it repairs, so no other source may be missing that
+ * seqno on the layer at the same time.  Stop asking s for those in
+ * [from, to) that another source is missing; the decoder copes.
+ */
+void SessionManager::unshare(Source* s, int layer, u_int16_t from,
+			     u_int16_t to)
+{
+	NackList* nl = s->layer(layer).nacklist();
+	for (Source* p = SourceManager::instance().sources(); p != 0;
+	     p = p->next_) {
+		if (p == s || layer >= p->nlayer_)
+			continue;
+		NackList* pl = p->layer(layer).nacklist();
+		if (pl == 0 || !pl->pending())
+			continue;
+		for (u_int16_t q = from; q != to; ++q)
+			if (pl->missing(q))
+				nl->forget(q);
+	}
+}
+
+void SessionManager::demux(pktbuf* pb, Address & addr, int repair)
 {
 	rtphdr* rh = (rtphdr*)pb->data;
 	u_int32_t srcid = rh->rh_ssrc;
 	int flags = ntohs(rh->rh_flags);
+	TRACE_SCOPE_SETKEY(TRACE_DEMUX, srcid, ntohl(rh->rh_ts));
 	// for LIP SYNC
 	//SV-XXX: unused: u_char *pkt = pb->data - sizeof(*rh);
 
@@ -834,6 +1290,10 @@ void SessionManager::demux(pktbuf* pb, Address & addr)
 	 * a session packet arriving on the data port.
 	 */
 	int fmt = flags & 0x7f;
+	if (fecpt_ >= 0 && fmt == fecpt_) {
+		parity(pb, addr);
+		return;
+	}
 	if (!check_format(fmt)) {
 		++badfmt_;
 		pb->release();
@@ -855,13 +1315,24 @@ void SessionManager::demux(pktbuf* pb, Address & addr)
 	}
 	/* inform this source of the mbus */
 	s->mbus(&mb_);
+	/* (before any csrcs are squeezed out below) */
+	if (reflector_ != 0)
+		reflector_->forward(pb, inaddr(addr));
 	
 	Source::Layer& sl = s->layer(pb->layer);
+	FecDecoder* fd = sl.fecdecoder();
+	if (fd != 0 && (flags & 0x0f00) == 0) {
+		/* (before any csrcs are squeezed out below) */
+		fd->keep(pb);
+		recover(fd, addr);
+	}
 	timeval now = unixtime();
 	//	s->lts_data(now);
 	sl.lts_data(now);
 	//	s->sts_data(rh->rh_ts);
 	sl.sts_data(rh->rh_ts);
+	if (!repair)
+		sl.arrival(ntohl(rh->rh_ts), now);
 	
 	// extract CSRC count (CC field); increment pb->dp data pointer & adjust length accordingly
 	int cnt = (flags >> 8) & 0xf;
@@ -887,6 +1358,19 @@ void SessionManager::demux(pktbuf* pb, Address & addr)
 	} else
 		s->action();
 
+	if (reflectonly_) {
+		/* relayed but not decoded; only counted for the reports */
+		int dup = track(s, pb->layer, seqno, fmt, repair);
+		if (!repair) {
+			sl.np(1);
+			sl.nb(pb->len);
+		}
+		if ((flags & RTP_M) && !dup)
+			sl.nf(1);
+		pb->release();
+		return;
+	}
+
 	if (s->sync() && lipSyncEnabled()) {  
 		/*
 		 * Synchronisation is enabled on this source; 
@@ -902,9 +1386,11 @@ void SessionManager::demux(pktbuf* pb, Address & addr)
 		//		int dup = s->cs(seqno);
 		//		s->np(1);
 		//		s->nb(cc + sizeof(*rh));
-		int dup = sl.cs(seqno, s);
-		sl.np(1);
-		sl.nb(pb->len);
+		int dup = track(s, pb->layer, seqno, fmt, repair);
+		if (!repair) {
+			sl.np(1);
+			sl.nb(pb->len);
+		}
 		if (dup) {
 			pb->release();
 			return;
@@ -941,9 +1427,11 @@ void SessionManager::demux(pktbuf* pb, Address & addr)
 		//	        int dup = s->cs(seqno);
 		//	        s->np(1);
 		//	        s->nb(cc + sizeof(*rh));
-		int dup = sl.cs(seqno, s);
-		sl.np(1);
-		sl.nb(pb->len);
+		int dup = track(s, pb->layer, seqno, fmt, repair);
+		if (!repair) {
+			sl.np(1);
+			sl.nb(pb->len);
+		}
 		if (dup){
 			pb->release();
 			return;
@@ -969,17 +1457,311 @@ void SessionManager::demux(pktbuf* pb, Address & addr)
 			return;
 		}
 		//h->recv(rh, bp + hlen, cc);
+		TRACE_SCOPE(TRACE_DECODE);
 		h->recv(pb);
+		if (h->keyreq()) {
+			h->keyreq(0);
+			send_pli(s);
+		}
 	} /* not sync-ed */
 
 }
 
-void SessionManager::parse_rr_records(u_int32_t, rtcp_rr*, int,
-				      const u_char*, Address &)
+/*
+ * Feed the report blocks about our own stream to the rate
+ * controller.  The round trip time comes from the echoed
+ * timestamp of our last SR and the receiver's delay since it
+ * (both in 1/65536 sec); the jitter is in media clock ticks.
+ */
+void SessionManager::parse_rr_records(u_int32_t ssrc, rtcp_rr* r, int cnt,
+				      const u_char* ep, Address &)
 {
+	Source* ls = SourceManager::instance().localsrc();
+	if (ls == 0)
+		return;
+	timeval tv = unixtime();
+	double now = tv.tv_sec + 1e-6 * tv.tv_usec;
+	for (; --cnt >= 0 && (u_char*)(r + 1) <= ep; ++r) {
+		if (r->rr_srcid != ls->srcid())
+			continue;
+		int fraction = ntohl(r->rr_loss) >> 24;
+		double jitter = ntohl(r->rr_dv) / 90000.;
+		double rtt = -1.;
+		u_int32_t lsr = ntohl(r->rr_lsr);
+		if (lsr != 0) {
+			int d = int(ntptime(tv) - lsr - ntohl(r->rr_dlsr));
+			if (d >= 0)
+				rtt = d / 65536.;
+		}
+		if (rc_.report(ssrc, fraction, jitter, rtt, now) &&
+		    ratecontrol_)
+			adapt_rate();
+	}
+}
+
+/*
+ * Pace the transmitter at the controlled rate and have the ui
+ * carry it to the grabber and encoder.
+ */
+void SessionManager::adapt_rate()
+{
+	int kbps = ratecontrol_ ? rc_.kbps() : rc_.limit();
+	bps(kbps);
+	Tcl::instance().evalf("adapt_rate %d", kbps);
 }
 				      
 
+/*
+ * A generic nack (RFC 4585) for our stream: retransmit each packet
+ * it names, the one in each entry and those flagged in its bitmask
+ * of the 16 after it.  One from another receiver for a stream we
+ * are missing packets of too stands for ours, as the repair goes
+ * to the group (RFC 4585 3.5.2).
+ */
+void SessionManager::parse_fb(rtcphdr* rh, int flags, u_char* ep, int layer)
+{
+	if ((flags >> 8 & 0x1f) != RTCP_FB_NACK)
+		return;
+	u_int32_t* p = (u_int32_t*)(rh + 1);
+	Source* ls = SourceManager::instance().localsrc();
+	if ((u_char*)(p + 1) > ep || ls == 0)
+		return;
+	if (*p != ls->srcid()) {
+		Source* s = SourceManager::instance().consult(*p);
+		NackList* nl = s != 0 ? s->layer(layer).nacklist() : 0;
+		if (nl == 0 || !nl->pending())
+			return;
+		double now = gettimeofday_secs();
+		while ((u_char*)(++p + 1) <= ep) {
+			u_int32_t v = ntohl(*p);
+			nl->heard(v >> 16, v & 0xffff, now);
+		}
+		return;
+	}
+	if (hist_ == 0)
+		return;
+	while ((u_char*)(++p + 1) <= ep) {
+		u_int32_t v = ntohl(*p);
+		u_int16_t pid = v >> 16;
+		retransmit(layer, pid);
+		for (int i = 0; i < 16; ++i)
+			if (v & 1 << i)
+				retransmit(layer, pid + i + 1);
+	}
+}
+
+/*
+ * Early feedback (RFC 4585 3.5).  Once in each report interval a
+ * receiver may send its feedback ahead of the next regular report,
+ * after a random wait of up to T_dither_max: none with a single peer,
+ * half the interval in a group, so that one receiver's request can
+ * be heard by the others and stand for theirs.  Feedback that finds
+ * the early packet used goes with the next regular report.
+ */
+void SessionManager::feedback(int layer, double now)
+{
+	CtrlHandler& ch = ch_[layer];
+	if (!ch.early() || ch.fbt() >= 0. || ch.net() == 0)
+		return;
+	double ms = 0.;
+	if (SourceManager::instance().nsources() > 2)
+		ms = fmod(double(random()), ch.rint() * .5);
+	ch.fbt(now + 1e-3 * ms);
+}
+
+/*
+ * Ask for an early packet on each layer with nacks due, send those
+ * whose wait is over and set the timer for the next.
+ */
+void SessionManager::feedback_timeout()
+{
+	double now = gettimeofday_secs();
+	double next = -1.;
+	SourceManager& sm = SourceManager::instance();
+	for (Source* s = sm.sources(); s != 0; s = s->next_) {
+		for (int layer = 0; layer < s->nlayer_; ++layer) {
+			NackList* nl = s->layer(layer).nacklist();
+			if (nl == 0 || !nl->pending())
+				continue;
+			double due = nl->due();
+			if (due <= now)
+				feedback(layer, now);
+			else if (next < 0. || due < next)
+				next = due;
+		}
+	}
+	for (int layer = 0; layer < NLAYER; ++layer) {
+		CtrlHandler& ch = ch_[layer];
+		double t = ch.fbt();
+		if (t < 0.)
+			continue;
+		if (t <= now) {
+			ch.fbt(-1.);
+			if (send_feedback(&ch, now))
+				ch.early(0);
+		} else if (next < 0. || t < next)
+			next = t;
+	}
+	nt_.cancel();
+	if (next >= 0.) {
+		int ms = int(1e3 * (next - now) + .5);
+		nt_.msched(ms > 0 ? ms : 1);
+	}
+}
+
+/*
+ * An early packet: an empty receiver report, our cname and the
+ * feedback due on the layer.  Returns its length, 0 if there was
+ * nothing to send.
+ */
+int SessionManager::send_feedback(CtrlHandler* ch, double now)
+{
+	Source* ls = SourceManager::instance().localsrc();
+	if (ls == 0)
+		return (0);
+	rtcphdr* rh = (rtcphdr*)pktbuf_;
+	rh->rh_flags = htons(RTP_VERSION << 14 | RTCP_PT_RR);
+	rh->rh_len = htons(1);
+	rh->rh_ssrc = ls->srcid();
+	u_char* fb = (u_char*)(rh + 1);
+	fb += build_cname((rtcphdr*)fb, *ls);
+	u_char* p = build_fb(fb, pktbuf_ + RTP_MTU, ch - ch_, now);
+	if (p == fb)
+		return (0);
+	int len = p - pktbuf_;
+	ch->send(pktbuf_, len);
+	ch->sample_size(len);
+	return (len);
+}
+
+/*
+ * The feedback messages due on a layer, built at p and not past ep.
+ */
+u_char* SessionManager::build_fb(u_char* p, u_char* ep, int layer,
+				 double now)
+{
+	SourceManager& sm = SourceManager::instance();
+	for (Source* s = sm.sources(); s != 0; s = s->next_) {
+		NackList* nl = s->layer(layer).nacklist();
+		if (nl != 0 && nl->pending() && nl->due() <= now)
+			p = build_nack(p, ep, s, nl, now);
+		if (layer == 0 && s->pli())
+			p = build_pli(p, ep, s);
+	}
+	return (p);
+}
+
+u_char* SessionManager::build_nack(u_char* p, u_char* ep, Source* s,
+				   NackList* nl, double now)
+{
+	int room = (ep - p - int(sizeof(rtcphdr)) - 4) >> 2;
+	if (room <= 0)
+		return (p);
+	if (room > NACK_MAXLOST)
+		room = NACK_MAXLOST;
+	rtcphdr* fb = (rtcphdr*)p;
+	u_int32_t* fci = (u_int32_t*)(fb + 1) + 1;
+	int n = nl->build(fci, room, now);
+	if (n == 0)
+		return (p);
+	for (int i = 0; i < n; ++i)
+		fci[i] = htonl(fci[i]);
+	fb->rh_flags = htons(RTP_VERSION << 14 | RTCP_FB_NACK << 8 |
+			     RTCP_PT_RTPFB);
+	fb->rh_len = htons(2 + n);
+	fb->rh_ssrc = SourceManager::instance().localsrc()->srcid();
+	*(u_int32_t*)(fb + 1) = s->srcid();
+	return ((u_char*)(fci + n));
+}
+
+/*
+ * A picture loss indication (RFC 4585) or full intra request
+ * (RFC 5104) for our stream: have the encoder send a key frame.
+ * The requests of many receivers are folded together by kl_, and
+ * the FIR sequence number, which tells a repeat from a new request,
+ * is left to that too.  A PLI from another receiver for a stream we
+ * want a key frame of too stands for ours (RFC 4585 3.5.2).
+ */
+void SessionManager::parse_psfb(rtcphdr* rh, int flags, u_char* ep)
+{
+	u_int32_t* p = (u_int32_t*)(rh + 1);
+	Source* ls = SourceManager::instance().localsrc();
+	if ((u_char*)(p + 1) > ep || ls == 0)
+		return;
+	switch (flags >> 8 & 0x1f) {
+
+	case RTCP_FB_PLI:
+		if (*p != ls->srcid()) {
+			Source* s = SourceManager::instance().consult(*p);
+			if (s != 0)
+				s->pli(0);
+			return;
+		}
+		break;
+
+	case RTCP_FB_FIR:
+		/* entries of the ssrc asked of and a sequence number */
+		for (++p; (u_char*)(p + 2) <= ep; p += 2)
+			if (*p == ls->srcid())
+				break;
+		if ((u_char*)(p + 2) > ep)
+			return;
+		break;
+
+	default:
+		return;
+	}
+	if (kl_.request(gettimeofday_secs()))
+		key_frame();
+	else
+		/* held off: answer at the end of it */
+		key_timeout();
+}
+
+void SessionManager::key_timeout()
+{
+	double now = gettimeofday_secs();
+	if (kl_.expire(now))
+		key_frame();
+	kt_.cancel();
+	double due = kl_.due();
+	if (due >= 0.)
+		kt_.msched(int(1e3 * (due - now)) + 1);
+}
+
+void SessionManager::key_frame()
+{
+	Tcl::instance().eval("key_frame");
+}
+
+/*
+ * Ask source s for a key frame with a PLI, in an early packet or,
+ * if that is used, the next regular report on the base layer.  The
+ * decoder has already seen to it that a request doesn't go out more
+ * often than KEY_REPEAT.
+ */
+void SessionManager::send_pli(Source* s)
+{
+	s->pli(1);
+	feedback(0, gettimeofday_secs());
+	feedback_timeout();
+}
+
+u_char* SessionManager::build_pli(u_char* p, u_char* ep, Source* s)
+{
+	if (p + sizeof(rtcphdr) + 4 > ep)
+		return (p);
+	rtcphdr* fb = (rtcphdr*)p;
+	fb->rh_flags = htons(RTP_VERSION << 14 | RTCP_FB_PLI << 8 |
+			     RTCP_PT_PSFB);
+	fb->rh_len = htons(2);
+	fb->rh_ssrc = SourceManager::instance().localsrc()->srcid();
+	*(u_int32_t*)(fb + 1) = s->srcid();
+	s->pli(0);
+	++npli_;
+	return ((u_char*)(fb + 1) + 4);
+}
+
 void SessionManager::parse_sr(rtcphdr* rh, int flags, u_char*ep,
 							  Source* ps, Address & addr, int layer)
 {
@@ -1172,6 +1954,8 @@ void SessionManager::recv(CtrlHandler* ch)
 		return;
 	
 	int layer = ch - ch_;
+	if (reflector_ != 0)
+		reflector_->forward(pktbuf_, cc, layer, ssrc, inaddr(addr));
 		/*
 		* Outer loop parses multiple RTCP records of a "compound packet".
 		* There is no framing between records.  Boundaries are implicit
@@ -1208,6 +1992,14 @@ void SessionManager::recv(CtrlHandler* ch)
 			parse_bye(rh, flags, ep, ps);
 			break;
 
+		case RTCP_PT_RTPFB:
+			parse_fb(rh, flags, ep, layer);
+			break;
+
+		case RTCP_PT_PSFB:
+			parse_psfb(rh, flags, ep);
+			break;
+
 		default:
 			ps->badsessopt(1);
 			break;
@@ -36,9 +36,12 @@
 #include "iohandler.h"
 #include "source.h"
 #include "mbus_handler.h"
+#include "rate-control.h"
+#include "keyframe.h"
 
 class Source;
 class SessionManager;
+class Reflector;
 
 class DataHandler : public IOHandler {
     public:
@@ -74,6 +77,7 @@ class DataHandler : public IOHandler {
 #define CTRL_SENDER_BW_FRACTION (0.25)
 #define CTRL_RECEIVER_BW_FRACTION (1. - CTRL_SENDER_BW_FRACTION)
 #define CTRL_SIZE_GAIN (1./8.)
+#define CTRL_REDUCED_MIN (360.)	/* over the session kb/s (RFC 3550 6.2) */
 
 class CtrlHandler : public DataHandler, public Timer {
     public:
@@ -87,11 +91,23 @@ class CtrlHandler : public DataHandler, public Timer {
 	void adapt(int nsrc, int nrr, int we_sent);
 	void sample_size(int cc);
 	inline double rint() const { return (rint_); }
+	void bandwidth(double kbps);
+	void avpf(int on);
+	/* early feedback (RFC 4585 3.5) */
+	inline int early() const { return (early_); }
+	inline void early(int v) { early_ = v; }
+	inline double fbt() const { return (fbt_); }
+	inline void fbt(double t) { fbt_ = t; }
  protected:
 	void schedule_timer();
 	double ctrl_inv_bw_;
 	double ctrl_avg_size_;	/* (estimated) average size of ctrl packets */
 	double rint_;		/* current session report rate (in ms) */
+	double kbps_;		/* session bandwidth, 0 if not known */
+	int avpf_;		/* true to send feedback (RFC 4585) */
+	double min_;		/* least report interval (ms) */
+	int early_;		/* true if an early packet may go */
+	double fbt_;		/* when it goes, or < 0 */
 };
 
 class ReportTimer : public Timer {
@@ -102,6 +118,22 @@ class ReportTimer : public Timer {
 	SessionManager& sm_;
 };
 
+class NackTimer : public Timer {
+    public:
+	inline NackTimer(SessionManager& sm) : sm_(sm) {}
+	void timeout();
+    protected:
+	SessionManager& sm_;
+};
+
+class KeyTimer : public Timer {
+    public:
+	inline KeyTimer(SessionManager& sm) : sm_(sm) {}
+	void timeout();
+    protected:
+	SessionManager& sm_;
+};
+
 class SessionManager : public Transmitter, public MtuAlloc {
 public:
 	SessionManager();
@@ -114,16 +146,24 @@ public:
 	virtual inline void send_bye() { send_report(&ch_[0], 1); }
 //	virtual void send_report();
 	virtual void send_report(CtrlHandler*, int bye, int app = 0);
+	void feedback_timeout();
+	void key_timeout();
 
 protected:
 //	void demux(rtphdr* rh, u_char* bp, int cc, Address & addr, int layer);
-	void demux(pktbuf* pb, Address & addr);
+	void demux(pktbuf* pb, Address & addr, int repair = 0);
+	void repair(pktbuf* pb, Address & addr);
+	void parity(pktbuf* pb, Address & addr);
+	void recover(FecDecoder* fd, Address & addr);
+	int track(Source* s, int layer, u_int16_t seqno, int fmt, int repair);
+	void unshare(Source* s, int layer, u_int16_t from, u_int16_t to);
 	virtual int check_format(int fmt) const = 0;
 	virtual void transmit(pktbuf* pb);
 	void send_report(int bye);
 	int build_bye(rtcphdr* rh, Source& local);
 	u_char* build_sdes_item(u_char* p, int code, Source&);
-	int build_sdes(rtcphdr* rh, Source& s);
+	int build_sdes(rtcphdr* rh, Source& s, int layer);
+	int build_cname(rtcphdr* rh, Source& s);
 	int build_app(rtcphdr* rh, Source& ls, const char *name, 
 			void *data, int datalen);
 
@@ -138,6 +178,16 @@ protected:
 	void parse_sdes(rtcphdr* rh, int flags, u_char* ep, Source* ps,
 			Address & addr, u_int32_t ssrc, int layer);
 	void parse_bye(rtcphdr* rh, int flags, u_char* ep, Source* ps);
+	void parse_fb(rtcphdr* rh, int flags, u_char* ep, int layer);
+	void feedback(int layer, double now);
+	int send_feedback(CtrlHandler* ch, double now);
+	u_char* build_fb(u_char* p, u_char* ep, int layer, double now);
+	u_char* build_nack(u_char* p, u_char* ep, Source* s, NackList* nl,
+			   double now);
+	void parse_psfb(rtcphdr* rh, int flags, u_char* ep);
+	void send_pli(Source* s);
+	u_char* build_pli(u_char* p, u_char* ep, Source* s);
+	void key_frame();
 
 	int parseopts(const u_char* bp, int cc, Address & addr) const;
 	int ckid(const char*, int len);
@@ -148,6 +198,8 @@ protected:
 	void lipSyncEnabled(int v) { lipSyncEnabled_=v;}
 
 	char* stats(char* cp) const;
+	void adapt_rate();
+	int reflect(int argc, const char*const* argv);
 
 	DataHandler dh_[NLAYER];
 	CtrlHandler ch_[NLAYER];
@@ -173,6 +225,19 @@ protected:
 
 	int confid_;
 
+	RateControl rc_;	/* send rate from receiver reports */
+	int ratecontrol_;	/* true to adapt to rc_ */
+
+	int nack_;		/* true to ask for lost packets */
+	NackTimer nt_;		/* early feedback and asking again */
+
+	KeyLimiter kl_;		/* key frames asked of us */
+	KeyTimer kt_;		/* for the ones held off */
+	u_int32_t npli_;	/* key frames we asked for */
+
+	Reflector* reflector_;	/* unicast fan-out, or 0 */
+	int reflectonly_;	/* true to relay without decoding */
+
 	BufferPool* pool_;
 	u_char* pktbuf_;
 
@@ -185,6 +250,8 @@ class AudioSessionManager : public SessionManager {
 };
 
 class VideoSessionManager : public SessionManager {
+    public:
+	VideoSessionManager();
     protected:
 	int check_format(int fmt) const;
 };
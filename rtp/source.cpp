@@ -40,6 +40,8 @@ static const char rcsid[] =
 
 #include "sys-time.h"
 #include "source.h"
+#include "rtx.h"
+#include "fec.h"
 #include "ntp-time.h"
 #include "mbus_handler.h"
 
@@ -116,7 +118,11 @@ sns_(0),
 ndup_(0),
 nrunt_(0),
 sts_data_(0),
-sts_ctrl_(0)
+sts_ctrl_(0),
+transit_(0),
+jitter_(0),
+nack_(0),
+fec_(0)
 {
 	
 /*
@@ -136,6 +142,12 @@ sts_ctrl_(0)
 	lts_ctrl_.tv_usec = 0;
 }
 
+Source::Layer::~Layer()
+{
+	delete nack_;
+	delete fec_;
+}
+
 void Source::Layer::clear_counters()
 {
 	np_ = 0;
@@ -146,6 +158,7 @@ void Source::Layer::clear_counters()
 	sns_ = 0;
 	ndup_ = 0;
 	nrunt_ = 0;
+	jitter_ = 0;
 	
 	lts_data_.tv_sec = 0;
 	lts_data_.tv_usec = 0;
@@ -153,6 +166,25 @@ void Source::Layer::clear_counters()
 	lts_ctrl_.tv_usec = 0;
 }
 
+/*
+ * Fold the arrival of a data packet with rtp timestamp ts (host
+ * order) into the interarrival jitter, as in RFC 3550 A.8.  Video
+ * payloads all use a 90kHz clock.  Called before the packet is
+ * counted, so the first one only sets the transit time.
+ */
+void Source::Layer::arrival(u_int32_t ts, const timeval& now)
+{
+	u_int32_t a = u_int32_t(now.tv_sec) * 90000 +
+		u_int32_t(now.tv_usec) * 9 / 100;
+	int d = int(a - ts - transit_);
+	transit_ = a - ts;
+	if (np_ == 0)
+		return;
+	if (d < 0)
+		d = -d;
+	jitter_ += d - ((jitter_ + 8) >> 4);
+}
+
 //SV-XXX: rearranged initialisation order to shut up gcc4
 Source::Source(u_int32_t srcid, u_int32_t ssrc, Address &addr)
 : TclObject(0),
@@ -161,6 +193,9 @@ hlink_(0),
 handler_(0),
 srcid_(srcid),
 ssrc_(ssrc),
+rtxsrcid_(0),
+fecsrcid_(0),
+pli_(0),
 addr_(*(addr.copy())),
 rtp2ntp_(0),
 //	  sts_data_(0),
@@ -334,6 +369,16 @@ char* Source::stats(char* cp) const
 	cp = onestat(cp, "Misordered", layer(i).nm());
 	cp = onestat(cp, "Runts", layer(i).runt());
 	cp = onestat(cp, "Dups", layer(i).dups());
+	NackList* nl = layer(i).nacklist();
+	if (nl != 0) {
+		cp = onestat(cp, "Nacked", nl->nnack());
+		cp = onestat(cp, "Repaired", nl->nrepaired());
+		cp = onestat(cp, "Unrepaired", nl->ngaveup());
+		cp = onestat(cp, "Repair-ms", u_long(1e3 * nl->delay()));
+	}
+	FecDecoder* fd = layer(i).fecdecoder();
+	if (fd != 0)
+		cp = onestat(cp, "Fec-Recovered", fd->nrecovered());
 	cp = onestat(cp, "Bad-S-Len", badsesslen());
 	cp = onestat(cp, "Bad-S-Ver", badsessver());
 	cp = onestat(cp, "Bad-S-Opt", badsessopt());
@@ -719,7 +764,7 @@ Source::schedule()
 	if (playout <= now_ || elastic_ == 0) {
 		timeout();
 	} else {
-		msched(int((playout - now_) / 65.536));
+		usched((playout - now_) / 0.065536);
 	}
 }
 
@@ -843,6 +888,7 @@ clock_(0),
 keep_sites_(0),
 site_drop_time_(0),
 localsrc_(0),
+nextra_(0),
 generator_(0)
 {
 	memset((char*)hashtab_, 0, sizeof(hashtab_));
@@ -987,6 +1033,47 @@ void SourceManager::init(u_int32_t localid, Address & localaddr)
 	localsrc_->layer(0).lts_ctrl(unixtime());/*XXX layer-0*/
 }
 
+Source* SourceManager::addlocal(u_int32_t srcid)
+{
+	if (nextra_ == SOURCE_MAXEXTRA || local(srcid) != 0)
+		return (0);
+	Source* s = new Source(srcid, srcid, *localsrc_->addr().copy());
+	enter(s);
+	remove_from_hashtable(s);
+	s->layer(0).lts_ctrl(unixtime());
+	extra_[nextra_++] = s;
+	return (s);
+}
+
+void SourceManager::removelocal(Source* s)
+{
+	int i;
+	for (i = 0; i < nextra_; ++i)
+		if (extra_[i] == s)
+			break;
+	if (i == nextra_)
+		return;
+	extra_[i] = extra_[--nextra_];
+	--nsources_;
+	Source** p = &sources_;
+	while (*p != s)
+		p = &(*p)->next_;
+	*p = (*p)->next_;
+	if (s == generator_)
+		generator_ = 0;
+	delete s;
+}
+
+Source* SourceManager::local(u_int32_t srcid) const
+{
+	if (localsrc_ != 0 && localsrc_->srcid() == srcid)
+		return (localsrc_);
+	for (int i = 0; i < nextra_; ++i)
+		if (extra_[i]->srcid() == srcid)
+			return (extra_[i]);
+	return (0);
+}
+
 Source* SourceManager::enter(Source* s)
 {
 	s->next_ = sources_;
@@ -1188,6 +1275,8 @@ void SourceManager::remove(Source* s)
 	 * suspended for a while.
 	 */
 	if (s==localsrc_) return;
+	if (local(s->srcid()) == s)
+		return;
 
 	--nsources_;
 	
@@ -43,6 +43,8 @@
 
 class SourceManager;
 class pktbuf;
+class NackList;
+class FecDecoder;
 
 
 /* Added as a variation of Isidor's approach 
@@ -55,6 +57,7 @@ class MBusHandler;
 class SourceManager;
 
 #define SOURCE_HASH 1024
+#define SOURCE_MAXEXTRA 8	/* local sources besides localsrc */
 
 #define SHASH(a) ((int)((((a) >> 20) ^ ((a) >> 10) ^ (a)) & (SOURCE_HASH-1)))
 
@@ -127,16 +130,21 @@ PacketData::construct(u_char *pkt, struct rtphdr* rh, u_char *vh,
 class PacketHandler : public TclObject {
     public:
 	virtual ~PacketHandler();
-	inline PacketHandler(int hdrlen) : hdrlen_(hdrlen), delvar_(0) { }
+	inline PacketHandler(int hdrlen) :
+		hdrlen_(hdrlen), delvar_(0), keyreq_(0) { }
 	inline int hdrlen() const { return (hdrlen_); }
 //	virtual void recv(const struct rtphdr*,
 //			  const u_char* data, int len) = 0;
 	virtual void recv(pktbuf*) = 0;
 	inline u_int32_t delvar() const { return (delvar_); }
 	inline void delvar(u_int32_t v) { delvar_ = v; }
+	/* set by a decoder that wants the sender to send a key frame */
+	inline int keyreq() const { return (keyreq_); }
+	inline void keyreq(int v) { keyreq_ = v; }
     protected:
 	int hdrlen_;
 	int delvar_;
+	int keyreq_;
 };
 
 class Source : public TclObject, public Timer {
@@ -185,6 +193,12 @@ class Source : public TclObject, public Timer {
 	inline void srcid(u_int32_t s) { srcid_ = s; }
 	inline u_int32_t ssrc() const { return (ssrc_); }
 	inline void ssrc(u_int32_t s) { ssrc_ = s; }
+	inline u_int32_t rtxsrcid() const { return (rtxsrcid_); }
+	inline void rtxsrcid(u_int32_t s) { rtxsrcid_ = s; }
+	inline u_int32_t fecsrcid() const { return (fecsrcid_); }
+	inline void fecsrcid(u_int32_t s) { fecsrcid_ = s; }
+	inline int pli() const { return (pli_); }
+	inline void pli(int v) { pli_ = v; }
 	inline void format(int v) { format_ = v; }
 	inline int  format() const { return (format_); }
 	inline void mute(int v) { mute_ = v; }
@@ -198,6 +212,7 @@ class Source : public TclObject, public Timer {
 	class Layer : public TclObject {
 	public:
 		Layer();
+		~Layer();
 		void clear_counters();
 
 		/*XXX should start at random values*/
@@ -231,6 +246,14 @@ class Source : public TclObject, public Timer {
 		void lts_ctrl(const timeval& now) { lts_ctrl_ = now; }
 		void sts_data(u_int32_t now) { sts_data_ = now; }
 		void sts_ctrl(u_int32_t now) { sts_ctrl_ = now; }
+		void arrival(u_int32_t ts, const timeval& now);
+		/* interarrival jitter, in 90kHz ticks */
+		inline u_int32_t jitter() const { return (jitter_ >> 4); }
+
+		inline NackList* nacklist() const { return (nack_); }
+		inline void nacklist(NackList* nl) { nack_ = nl; }
+		inline FecDecoder* fecdecoder() const { return (fec_); }
+		inline void fecdecoder(FecDecoder* fd) { fec_ = fd; }
 	private:
 		u_int32_t fs_;	/* first seq. no received */
 		u_int32_t cs_;	/* current (most recent) seq. no received */
@@ -247,6 +270,10 @@ class Source : public TclObject, public Timer {
 		u_int32_t sts_ctrl_; /* sndr ts from last control packet */
 		timeval lts_data_; /* local unix time for last data packet */
 		timeval lts_ctrl_; /* local unix time for last ctrl packet */
+		u_int32_t transit_; /* arrival - rtp ts of last data packet */
+		u_int32_t jitter_; /* interarrival jitter, 1/16 ticks */
+		NackList* nack_; /* missing packets to ask for, if repairing */
+		FecDecoder* fec_; /* once parity packets come in */
 #define SOURCE_NSEQ 64
 		u_int16_t seqno_[SOURCE_NSEQ];
 	} *layer_[NLAYER];
@@ -321,6 +348,9 @@ protected:
 
 	u_int32_t srcid_;	/* rtp global src id (CSRC), net order */
 	u_int32_t ssrc_;	/* rtp global sync src id (SSRC), net order) */
+	u_int32_t rtxsrcid_;	/* ssrc of its retransmissions, 0 if unknown */
+	u_int32_t fecsrcid_;	/* ssrc of its parity, 0 if unknown */
+	int pli_;		/* true if a key frame is to be asked for */
 	Address & addr_;	/* address of sender (net order) */
 
 	int rtp2ntp_;		/* true if we've received a SR report */
@@ -396,6 +426,17 @@ class SourceManager : public TclObject {
 
 	u_int32_t clock() const { return (clock_); }
 	inline Source* localsrc() const { return (localsrc_); }
+	/*
+	 * Sources of our own besides localsrc, one for each stream of
+	 * a simulcast past the first.  Like localsrc they aren't in
+	 * the hash table, and the session reports them with it.
+	 */
+	Source* addlocal(u_int32_t srcid);
+	void removelocal(Source* s);
+	inline int nextra() const { return (nextra_); }
+	inline Source* extra(int i) const { return (extra_[i]); }
+	/* localsrc or one of the others if srcid is ours, else 0 */
+	Source* local(u_int32_t srcid) const;
 
 	void sortactive(char*) const;
 	void remove(Source*);
@@ -412,6 +453,8 @@ class SourceManager : public TclObject {
 	int keep_sites_;
 	u_int site_drop_time_;
 	Source* localsrc_;
+	Source* extra_[SOURCE_MAXEXTRA];
+	int nextra_;
 	Source* generator_;
 	Source* hashtab_[SOURCE_HASH];
 
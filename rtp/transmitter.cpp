@@ -55,6 +55,7 @@ static const char rcsid[] =
 #include "source.h"
 #include "decoder.h"
 #include "vic_tcl.h"
+#include "trace.h"
 
 #if defined(sun) && !defined(__svr4__) || (defined(_AIX) && !defined(_AIX41))
 extern "C" writev(int, iovec*, int);
@@ -85,14 +86,33 @@ Transmitter::Transmitter() :
 	head_(0),
 	tail_(0),
 	loop_layer_(1000),
+	hist_(0),
+	rtxpt_(RTP_PT_RTX),
+	rtxssrc_(0),
+	rtxseqno_(1),
+	nrtx_(0),
+	brtx_(0),
+	fecblock_(0),
+	fecpt_(-1),
+	fecssrc_(0),
+	nfec_(0),
 	loopback_(0)
 {
 	memset((char*)&mh_, 0, sizeof(mh_));
 	mh_.msg_iovlen = 2;
+	for (int i = 0; i < NLAYER; ++i)
+		fec_[i] = 0;
+}
+
+Transmitter::~Transmitter()
+{
+	delete[] hist_;
+	for (int i = 0; i < NLAYER; ++i)
+		delete fec_[i];
 }
 
 /* Return time of day in seconds */
-inline double Transmitter::gettimeofday_secs() const
+double Transmitter::gettimeofday_secs() const
 {
 	timeval tv;
 	::gettimeofday(&tv, 0);
@@ -116,7 +136,9 @@ void Transmitter::loopback(pktbuf* pb)
 	++np_;
 
 	SourceManager& sm = SourceManager::instance();
-	Source* s = sm.localsrc();
+	Source* s = sm.local(rh->rh_ssrc);
+	if (s == 0)
+		s = sm.localsrc();
 	timeval now = unixtime();
 	Source::Layer& sl = s->layer(pb->layer);
 
@@ -204,7 +226,29 @@ double Transmitter::txtime(pktbuf* pb)
 	return (8 * cc / (1000. * kbps_));
 }
 
+/*
+ * Send a packet from an encoder, and the parity packet it
+ * completes if we do fec.  Each layer has its own sequence
+ * numbers and so its own blocks.
+ */
 void Transmitter::send(pktbuf* pb)
+{
+	if (fecblock_ > 0 && fecpt_ >= 0) {
+		FecEncoder*& fe = fec_[pb->layer];
+		if (fe == 0)
+			fe = new FecEncoder(fecblock_, fecpt_, fecssrc_);
+		pktbuf* fp = fe->protect(pb);
+		queue(pb);
+		if (fp != 0) {
+			++nfec_;
+			queue(fp);
+		}
+		return;
+	}
+	queue(pb);
+}
+
+void Transmitter::queue(pktbuf* pb)
 {
 	if (!busy_) {
 		double delay = txtime(pb);
@@ -214,7 +258,7 @@ void Transmitter::send(pktbuf* pb)
 		 * emulate a transmit interrupt --
 		 * assume we will have more to send.
 		 */
-		msched(int(delay * 1e-3));
+		usched(1e6 * delay);
 		busy_ = 1;
 	} else {
 		if (head_ != 0) {
@@ -226,25 +270,27 @@ void Transmitter::send(pktbuf* pb)
 	}
 }
 
+/*
+ * Send what is due and sleep until the next packet is.  With the
+ * microsecond timers each packet goes out on its own time; with
+ * millisecond ones, those due within the millisecond go together.
+ */
 void Transmitter::timeout()
 {
-	double now = gettimeofday_secs();
 	for (;;) {
 		pktbuf* p = head_;
-		if (p != 0) {
-			head_ = p->next;
-			nextpkttime_ += txtime(p);
-			output(p);
-			int ms = int(1e-3 * (nextpkttime_ - now));
-			/* make sure we will wait more than 10ms */
-			if (ms > 1000) {
-				msched(ms);
-				return;
-			}
-		} else {
+		if (p == 0) {
 			busy_ = 0;
 			break;
 		}
+		double wait = nextpkttime_ - gettimeofday_secs();
+		if (wait > (highres() ? 0. : 1e-3)) {
+			usched(1e6 * wait);
+			return;
+		}
+		head_ = p->next;
+		nextpkttime_ += txtime(p);
+		output(p);
 	}
 }
 
@@ -269,11 +315,87 @@ void Transmitter::output(pktbuf* pb)
 	//if (dumpfd_ >= 0)
 	//	dump(dumpfd_, pb->iov, mh_.msg_iovlen);
 //dprintf("layer: %d \n",pb->layer);
-	transmit(pb);
+	int pt = pb->dp[1] & 0x7f;
+	if (pt == fecpt_ || pt == rtxpt_) {
+		/* repair isn't traced, so it can't pass for a frame's send */
+		transmit(pb);
+	} else {
+		rtphdr* rh = (rtphdr*)pb->data;
+		TRACE_SCOPE_KEY(TRACE_SEND, rh->rh_ssrc, ntohl(rh->rh_ts));
+		transmit(pb);
+	}
+	if (pt == fecpt_) {
+		/* parity isn't for us, and has seqnos of its own */
+		pb->release();
+		return;
+	}
+	if (hist_ != 0)
+		hist_[pb->layer].keep(pb, gettimeofday_secs());
 	loopback(pb);
 //	pb->release() is called by decoder in loopback;
 }
 
+void Transmitter::rtx(int pt, u_int32_t ssrc)
+{
+	if (pt < 0) {
+		delete[] hist_;
+		hist_ = 0;
+		return;
+	}
+	rtxpt_ = pt;
+	rtxssrc_ = ssrc;
+	if (hist_ == 0)
+		hist_ = new RtxHistory[NLAYER];
+}
+
+void Transmitter::fec(int k, int pt)
+{
+	fecpt_ = pt;
+	if (fecssrc_ == 0)
+		fecssrc_ = u_int32_t(random());
+	if (k != fecblock_) {
+		/* start the blocks over */
+		for (int i = 0; i < NLAYER; ++i) {
+			delete fec_[i];
+			fec_[i] = 0;
+		}
+	}
+	fecblock_ = k;
+}
+
+/*
+ * Answer a nack for seqno on layer with the RFC 4588 packet: the
+ * original header under our retransmission payload type, ssrc and
+ * seqno, then the original seqno, then the original payload.  It
+ * goes out now rather than through the send queue, as it is late
+ * already.
+ */
+int Transmitter::retransmit(int layer, u_int16_t seqno)
+{
+	if (hist_ == 0 || layer < 0 || layer >= NLAYER)
+		return (0);
+	pktbuf* pb = hist_[layer].lookup(seqno, gettimeofday_secs());
+	if (pb == 0)
+		return (0);
+	rtphdr* rh = (rtphdr*)pb->dp;
+	int flags = ntohs(rh->rh_flags);
+	int hlen = sizeof(*rh) + ((flags >> 8 & 0xf) << 2);
+	pktbuf* rb = pb->manager->alloc(layer);
+	memcpy(rb->dp, pb->dp, hlen);
+	rtphdr* rr = (rtphdr*)rb->dp;
+	rr->rh_flags = htons((flags & ~0x7f) | rtxpt_);
+	rr->rh_seqno = htons(rtxseqno_++);
+	rr->rh_ssrc = rtxssrc_;
+	memcpy(rb->dp + hlen, &rh->rh_seqno, 2);
+	memcpy(rb->dp + hlen + 2, pb->dp + hlen, pb->len - hlen);
+	rb->len = pb->len + 2;
+	transmit(rb);
+	++nrtx_;
+	brtx_ += rb->len;
+	rb->release();
+	return (1);
+}
+
 /*void Transmitter::release(pktbuf* pb)
 {
 	pb->next = freehdrs_;
@@ -42,6 +42,8 @@
 #include "rtp.h"
 #include "inet.h"
 #include "pktbuf-rtp.h"
+#include "rtx.h"
+#include "fec.h"
 
 /*
  * The base object for performing the outbound path of
@@ -50,6 +52,7 @@
 class Transmitter : public TclObject, public Timer {
     public:
 	Transmitter();
+	virtual ~Transmitter();
 	virtual void timeout();
 
 	struct buffer {
@@ -69,12 +72,24 @@ class Transmitter : public TclObject, public Timer {
 	};*/
 	static void dump(int fd);
 	static inline void seqno(u_int16_t s) { seqno_ = s; }
-	inline void bps(int kbps) { kbps = kbps_; }
+	inline void bps(int kbps) { kbps_ = kbps; }
 	inline void loop_layer(int loop_layer) { loop_layer_ = loop_layer; }
 	inline int loop_layer() { return loop_layer_; }
 	inline int mtu() { return (mtu_); }
-	void flush();
-	void send(pktbuf*);
+	virtual void flush();
+	virtual void send(pktbuf*);
+	/*
+	 * Keep what we send for repair, retransmitting with payload
+	 * type pt from ssrc; pt < 0 turns it off.
+	 */
+	void rtx(int pt, u_int32_t ssrc);
+	int retransmit(int layer, u_int16_t seqno);
+	/*
+	 * Follow each k packets (and each frame) with a parity packet
+	 * of payload type pt; k = 0 or pt < 0 turns it off.  The parity
+	 * goes out from an ssrc of its own.
+	 */
+	void fec(int k, int pt);
 	/*
 	 * Buffer allocation hooks.
 	 */
@@ -85,6 +100,7 @@ protected:
 	void update(int nbytes);
 	void dump(int fd, iovec*, int iovel) const;
 	void loopback(pktbuf*);
+	void queue(pktbuf*);
 	void output(pktbuf* pb);
 	virtual void transmit(pktbuf* pb) = 0;
 	double gettimeofday_secs() const;
@@ -107,6 +123,19 @@ protected:
 
 	int loop_layer_;	/* # of layers to loop back (for testing) */
 
+	RtxHistory* hist_;	/* per layer, while answering nacks */
+	int rtxpt_;
+	u_int32_t rtxssrc_;
+	u_int16_t rtxseqno_;
+	u_int32_t nrtx_;	/* number of packets retransmitted */
+	u_int32_t brtx_;	/* number of bytes retransmitted */
+
+	int fecblock_;		/* packets per parity packet, 0 for none */
+	int fecpt_;		/* < 0 for none */
+	u_int32_t fecssrc_;
+	FecEncoder* fec_[NLAYER];
+	u_int32_t nfec_;	/* number of parity packets sent */
+
 	int loopback_;		/* true to loopback data packets */
 	static int dumpfd_;	/* fd to dump packet stream to */
 	static u_int16_t seqno_;
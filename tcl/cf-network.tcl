@@ -252,6 +252,25 @@ proc net_open_rtip { sessionType session dst } {
 	set V(data-net) $dn
 }
 
+#
+# If the reflect resource is set (a list of host/port or
+# host/port/kbps), relay what comes in on the session to each
+# of them, for receivers without multicast.
+#
+proc init_reflector {} {
+	global V
+	foreach d [resource reflect] {
+		set d [split $d /]
+		if [catch {$V(session) reflect add [lindex $d 0] [lindex $d 1]} n] {
+			warn "reflect: $n"
+			continue
+		}
+		if { [llength $d] > 2 } {
+			$V(session) reflect rate $n [lindex $d 2]
+		}
+	}
+}
+
 proc init_network {} {
 	global numLayers numEncoderLayers IPaddrFamily
 	
@@ -289,6 +308,12 @@ proc init_network {} {
 
 	$V(session) max-bandwidth [resource maxbw]
 	$V(session) lip-sync [yesno lipSync]
+	$V(session) congestion-control [yesno congestionControl]
+	$V(session) retransmit [yesno retransmit]
+	$V(session) fec-format [resource fecFormat]
+	$V(session) fec [resource fecBlock]
+	$V(session) reflect only [yesno reflectOnly]
+	init_reflector
 
 	set key [resource sessionKey]
 	if { $key != "" } {
@@ -334,10 +334,64 @@ proc create_encoder fmt {
 		$encoder use-dct 1
 	} else {
 		set encoder [new module $fmt]
+		if { ($fmt == "bvc" || $fmt == "jpeg") && [yesno parallelEncode] } {
+			$encoder parallel 1
+		}
+		if { $fmt == "h264" && [yesno lowLatencyEncode] } {
+			$encoder lowLatency 1
+		}
 	}
 	return $encoder
 }
 
+#
+# If the simulcast resource is set (a list of format/WxH or
+# format/WxH/kbps), put a simulcast module between the grabber
+# and encoder.  It gives encoder the grabber's frames, sent on
+# layer 0, and an encoder for each item in the list frames of
+# that size, each sent from an ssrc of its own on layers 1 and
+# up, as far as numLayers goes, and on the last one after that.
+# These are all below the encoder's loop_layer (numEncoderLayers
+# + 1), so none is held back unless the layers sent are turned
+# down.  Returns what the grabber should feed.
+#
+proc create_simulcast encoder {
+	global V numLayers
+	set chains [resource simulcast]
+	set ff [$encoder frame-format]
+	if { $chains == "" || ($ff != "420" && $ff != "cif") } {
+		return $encoder
+	}
+	set sim [new module simulcast]
+	$sim transmitter $V(session)
+	$sim add $encoder - 0 [simulcast_thread $V(encoder_fmt)]
+	set V(simulcast) $sim
+	set V(simulcast_encoders) ""
+	set layer 0
+	foreach c $chains {
+		set c [split $c /]
+		set fmt [lindex $c 0]
+		set e [create_encoder $fmt]
+		if { [llength $c] > 2 } {
+			catch { $e kbps [lindex $c 2] }
+		}
+		if { $layer < $numLayers } {
+			incr layer
+		}
+		$sim add $e [lindex $c 1] $layer [simulcast_thread $fmt]
+		lappend V(simulcast_encoders) $e
+	}
+	return $sim
+}
+
+# the h.263 encoders call into tcl and have globals
+proc simulcast_thread fmt {
+	if { $fmt == "h263" || $fmt == "h263+" } {
+		return 0
+	}
+	return 1
+}
+
 set transmitButtonState 0
 set logoButtonState 0
 
@@ -385,6 +439,10 @@ proc transmit { } {
 		$encoder loop_layer [expr {$numEncoderLayers + 1}]
 
 		set V(encoder) $encoder
+		set V(encoder_fmt) $videoFormat
+		if { $grabtarget == $encoder } {
+			set grabtarget [create_simulcast $encoder]
+		}
 		set ff [$grabtarget frame-format]
 		set V(grabber) [$videoDevice open $ff]
 		# special cases
@@ -443,6 +501,14 @@ proc transmit { } {
 
 proc close_device {} {
 	global V
+	if [info exists V(simulcast)] {
+		delete $V(simulcast)
+		foreach e $V(simulcast_encoders) {
+			delete $e
+		}
+		unset V(simulcast)
+		unset V(simulcast_encoders)
+	}
 	delete $V(encoder)
 	delete $V(grabber)
 	unset V(grabber)
@@ -523,12 +589,17 @@ proc doNothing { args } {
 }
 
 proc update_encoder_param {  } {
-	global videoFormat fps_slider bps_slider useDeinterlacerComp
+	global videoFormat fps_slider bps_slider useDeinterlacerComp V
 	if {$videoFormat == "mpeg4" || $videoFormat == "h264"} {
 		encoder kbps [expr round([$bps_slider get])]
 		encoder fps [expr round([$fps_slider get])]
 		encoder useDeinterlacer $useDeinterlacerComp
 	}
+	if [info exists V(simulcast)] {
+		# done once, for all the encoders
+		catch { encoder useDeinterlacer 0 }
+		catch { $V(simulcast) deinterlace $useDeinterlacerComp }
+	}
 }
 
 proc set_bps { w value } {
@@ -560,6 +631,61 @@ proc set_fps { w value } {
 	$w configure -text "$value fps"
 }
 
+#
+# Called by the session when receiver reports move the send rate
+# (with congestionControl on).  The grabber and the rate controlled
+# encoders get the new rate; below the bandwidth slider's setting,
+# the frame rate and, for the other formats, the quality are cut
+# too, each by the square root of the ratio.
+#
+proc adapt_rate kbps {
+	global videoFormat fps_slider bps_slider qscale
+	if ![have grabber] {
+		return
+	}
+	set bps [expr round([$bps_slider get])]
+	set fps [expr round([$fps_slider get])]
+	if { $kbps > $bps } {
+		set kbps $bps
+	}
+	set r [expr sqrt(double($kbps) / $bps)]
+	set f [expr round($fps * $r)]
+	if { $f < 1 } {
+		set f 1
+	}
+	grabber bps $kbps
+	grabber fps $f
+	if {$videoFormat == "mpeg4" || $videoFormat == "h264"} {
+		encoder kbps $kbps
+		encoder fps $f
+	} else {
+		set cmd $videoFormat\_setq
+		if [inList $cmd [info commands *_setq]] {
+			$cmd [expr round([$qscale get] * $r)]
+		}
+	}
+}
+
+#
+# Called by the session when a receiver asks for a key frame (an
+# RTCP PLI or FIR).  Only the formats that predict from earlier
+# frames need one; the others refresh on their own.
+#
+proc key_frame {} {
+	global videoFormat V
+	if ![have grabber] {
+		return
+	}
+	if {$videoFormat == "mpeg4" || $videoFormat == "h264"} {
+		encoder keyframe
+	}
+	if [info exists V(simulcast)] {
+		foreach e $V(simulcast_encoders) {
+			catch { $e keyframe }
+		}
+	}
+}
+
 proc build.sliders w {
 	set f [smallfont]
 
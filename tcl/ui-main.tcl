@@ -764,6 +764,9 @@ proc create_decoder src {
 	if { $format == "pvh" } {
 		$decoder maxChannel $numLayers
 	}
+	if { $format == "h261" && [yesno parallelDecode] } {
+		$decoder parallel 1
+	}
 	$src handler $decoder
 	return $decoder
 }
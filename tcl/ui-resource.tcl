@@ -161,9 +161,17 @@ proc init_resources {} {
 	option add Vic.defaultTTL 16 startupFile
 	option add Vic.maxbw -1 startupFile
 	option add Vic.bandwidth 128 startupFile
+	option add Vic.congestionControl false startupFile
+	option add Vic.retransmit false startupFile
+	option add Vic.fecBlock 0 startupFile
+	option add Vic.fecFormat -1 startupFile
+	option add Vic.reflect "" startupFile
+	option add Vic.reflectOnly false startupFile
 	option add Vic.iconPrefix vic: startupFile
 	option add Vic.netBufferSize [expr 1024*1024] startupFile
 	option add Vic.priority 10 startupFile
+	# tk, or epoll to dispatch the sockets and timers without Tk
+	option add Vic.eventLoop tk startupFile
 	option add Vic.confBusChannel 0 startupFile
 
 	option add Vic.defaultFormat h.261 startupFile
@@ -173,13 +181,18 @@ proc init_resources {} {
 	option add Vic.switchInterval 5 startupFile
 	option add Vic.dither od startupFile
 	option add Vic.tile 1 startupFile
+	option add Vic.presentImages 2 startupFile
 	option add Vic.filterGain 0.25 startupFile
 	option add Vic.statsFilter 0.0625 startupFile
 	option add Vic.useHardwareDecode false startupFile
+	option add Vic.parallelDecode false startupFile
+	option add Vic.parallelEncode false startupFile
+	option add Vic.lowLatencyEncode false startupFile
 	option add Vic.infoHighlightColor LightYellow2 startupFile
 	option add Vic.useJPEGforH261 false startupFile
 	option add Vic.useHardwareComp false startupFile
 	option add Vic.useDeinterlacerComp true startupFile
+	option add Vic.simulcast "" startupFile
 	option add Vic.stillGrabber false startupFile 
 	option add Vic.fileGrabber false startupFile 
 	option add Vic.siteDropTime "300" startupFile
@@ -33,19 +33,269 @@ static const char rcsid[] =
 #include "config.h"
 #include "sys-time.h"
 #include "timer.h"
+#ifdef __linux__
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/timerfd.h>
+#include "iohandler.h"
+#include "eventloop.h"
+#define HAVE_TIMERFD
+#endif
 
-Timer::Timer() : token_(0)
+static int highres_ = 1;
+
+#ifdef HAVE_TIMERFD
+/*
+ * The microsecond timers: a hierarchical timing wheel, as in the
+ * BSD and Linux kernels, ticking in microseconds, with its next
+ * expiry on a timerfd that the Tk event loop watches like any other
+ * descriptor.
+ *
+ * Level 0 has a slot for each of the next 256 microseconds, level 1
+ * one for each of the 256 stretches of 256 after that, and so on.
+ * A timer goes on the lowest level that reaches its deadline and
+ * moves down (cascades) when the level below comes round to its
+ * slot, so setting and cancelling one costs the same however many
+ * there are.  Timers further out than the top level reaches go in
+ * its farthest slot and are put back when they come round.
+ */
+#define WHEEL_BITS	8
+#define WHEEL_SIZE	(1 << WHEEL_BITS)
+#define WHEEL_MASK	(WHEEL_SIZE - 1)
+#define WHEEL_LEVELS	4
+
+class TimerWheel : public IOHandler {
+public:
+	TimerWheel(int fd);
+	static TimerWheel* instance();
+	static u_int64_t now();
+	void add(Timer* t);
+	void remove(Timer* t);
+protected:
+	virtual void dispatch(int mask);
+	void insert(Timer* t);
+	int cascade(int level);
+	u_int64_t next() const;
+	void arm(u_int64_t when);
+
+	int fd_;
+	u_int64_t cur_;		/* the next tick to run */
+	int running_;		/* true while running tick cur_ */
+	u_int64_t armed_;	/* when the timerfd goes off, 0 if not set */
+	Timer* slot_[WHEEL_LEVELS][WHEEL_SIZE];
+	int count_[WHEEL_LEVELS];
+};
+
+TimerWheel::TimerWheel(int fd) : fd_(fd), cur_(now()), running_(0),
+	armed_(0)
+{
+	memset(slot_, 0, sizeof(slot_));
+	memset(count_, 0, sizeof(count_));
+	link(fd, TK_READABLE);
+}
+
+TimerWheel* TimerWheel::instance()
+{
+	static TimerWheel* wheel;
+	static int tried;
+	if (!tried) {
+		tried = 1;
+		int fd = timerfd_create(CLOCK_MONOTONIC,
+					TFD_NONBLOCK | TFD_CLOEXEC);
+		if (fd >= 0)
+			wheel = new TimerWheel(fd);
+	}
+	return (wheel);
+}
+
+u_int64_t TimerWheel::now()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u_int64_t(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000);
+}
+
+void TimerWheel::insert(Timer* t)
+{
+	/* (rounded up, so it never goes off early) */
+	u_int64_t when = u_int64_t(t->deadline_ + .999);
+	/* (the slot of a tick being run has been taken off already) */
+	if (when < cur_ + running_)
+		when = cur_ + running_;
+	u_int64_t delta = when - cur_;
+	int l = 0;
+	while (l < WHEEL_LEVELS - 1 &&
+	       delta >= u_int64_t(1) << (WHEEL_BITS * (l + 1)))
+		++l;
+	if (delta >> (WHEEL_BITS * WHEEL_LEVELS) != 0)
+		when = cur_ + (u_int64_t(1) << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+	Timer** p = &slot_[l][(when >> (WHEEL_BITS * l)) & WHEEL_MASK];
+	t->wnext_ = *p;
+	if (*p != 0)
+		(*p)->wprev_ = &t->wnext_;
+	t->wprev_ = p;
+	*p = t;
+	t->wlevel_ = l;
+	++count_[l];
+}
+
+void TimerWheel::remove(Timer* t)
+{
+	*t->wprev_ = t->wnext_;
+	if (t->wnext_ != 0)
+		t->wnext_->wprev_ = t->wprev_;
+	--count_[t->wlevel_];
+	t->wlevel_ = -1;
+}
+
+void TimerWheel::add(Timer* t)
+{
+	int n = 0;
+	for (int l = 0; l < WHEEL_LEVELS; ++l)
+		n += count_[l];
+	if (n == 0 && !running_)
+		/* idle; catch up without walking the ticks */
+		cur_ = now();
+	insert(t);
+	u_int64_t when = u_int64_t(t->deadline_ + .999);
+	if (!running_ && (armed_ == 0 || when < armed_))
+		arm(when > cur_ ? when : cur_);
+}
+
+/* move the timers in this level's current slot down */
+int TimerWheel::cascade(int level)
+{
+	int i = (cur_ >> (WHEEL_BITS * level)) & WHEEL_MASK;
+	Timer* t = slot_[level][i];
+	slot_[level][i] = 0;
+	while (t != 0) {
+		Timer* n = t->wnext_;
+		--count_[level];
+		insert(t);
+		t = n;
+	}
+	return (i);
+}
+
+/*
+ * When the wheel next has something to do: the first deadline on
+ * level 0, or the first time a higher level cascades a timer down.
+ * 0 if it has nothing.
+ */
+u_int64_t TimerWheel::next() const
+{
+	u_int64_t best = 0;
+	u_int64_t base = cur_ + running_;
+	for (int l = 0; l < WHEEL_LEVELS; ++l) {
+		if (count_[l] == 0)
+			continue;
+		int shift = WHEEL_BITS * l;
+		/* the first boundary of this level from base on */
+		u_int64_t c = (base + (u_int64_t(1) << shift) - 1) >> shift;
+		for (int d = 0; d < WHEEL_SIZE; ++d) {
+			if (slot_[l][(c + d) & WHEEL_MASK] == 0)
+				continue;
+			u_int64_t t = (c + d) << shift;
+			if (best == 0 || t < best)
+				best = t;
+			break;
+		}
+	}
+	return (best);
+}
+
+void TimerWheel::arm(u_int64_t when)
+{
+	itimerspec its;
+	memset(&its, 0, sizeof(its));
+	its.it_value.tv_sec = when / 1000000;
+	its.it_value.tv_nsec = (when % 1000000) * 1000;
+	/* (all zeros disarms it) */
+	timerfd_settime(fd_, TFD_TIMER_ABSTIME, &its, 0);
+	armed_ = when;
+}
+
+void TimerWheel::dispatch(int)
+{
+	u_int64_t n;
+	(void)read(fd_, &n, sizeof(n));
+	if (running_)
+		/* from the event loop run by one of our timeouts */
+		return;
+	armed_ = 0;
+	u_int64_t now = TimerWheel::now();
+	while (cur_ <= now) {
+		int i = cur_ & WHEEL_MASK;
+		for (int l = 1; i == 0 && l < WHEEL_LEVELS; ++l)
+			i = cascade(l);
+		Timer* list = slot_[0][cur_ & WHEEL_MASK];
+		slot_[0][cur_ & WHEEL_MASK] = 0;
+		if (list != 0) {
+			list->wprev_ = &list;
+			running_ = 1;
+			Timer* t;
+			while ((t = list) != 0) {
+				remove(t);
+				t->timeout();
+			}
+			running_ = 0;
+		}
+		/* skip the stretches with nothing to do */
+		u_int64_t next = cur_ + 1;
+		for (int l = 0; l < WHEEL_LEVELS && count_[l] == 0; ++l) {
+			int shift = WHEEL_BITS * (l + 1);
+			next = ((cur_ >> shift) + 1) << shift;
+		}
+		cur_ = next <= now + 1 ? next : now + 1;
+	}
+	arm(next());
+}
+#endif
+
+Timer::Timer() : token_(0), wnext_(0), wprev_(0), wlevel_(-1), deadline_(0.)
 {
 }
 
 Timer::~Timer()
 {
-	if (token_ != 0) 
-		cancel();
+	cancel();
+}
+
+void Timer::highres(int on)
+{
+	highres_ = on;
+}
+
+int Timer::highres()
+{
+#ifdef HAVE_TIMERFD
+	return ((highres_ || EventLoop::instance() != 0) &&
+		TimerWheel::instance() != 0);
+#else
+	return (0);
+#endif
 }
 
 void Timer::msched(int ms)
 {
+	usched(1e3 * ms);
+}
+
+void Timer::usched(double usec)
+{
+	cancel();
+#ifdef HAVE_TIMERFD
+	/* (without Tk running, the wheel is all there is) */
+	TimerWheel* w = highres_ || EventLoop::instance() != 0 ?
+		TimerWheel::instance() : 0;
+	if (w != 0) {
+		deadline_ = double(TimerWheel::now()) + usec;
+		w->add(this);
+		return;
+	}
+#endif
+	int ms = usec > 0. ? int((usec + 999.) / 1e3) : 0;
 	token_ = Tk_CreateTimerHandler(ms, dispatch, (ClientData)this);
 }
 
@@ -62,6 +312,10 @@ void Timer::cancel()
 		Tk_DeleteTimerHandler(token_);
 		token_ = 0;
 	}
+#ifdef HAVE_TIMERFD
+	if (wlevel_ >= 0)
+		TimerWheel::instance()->remove(this);
+#endif
 }
 
 double Timer::gettimeofday_usecs() const
@@ -70,4 +324,3 @@ double Timer::gettimeofday_usecs() const
 	::gettimeofday(&tv, 0);
 	return (1e6 * double(tv.tv_sec) + double(tv.tv_usec));
 }
-
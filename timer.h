@@ -39,16 +39,32 @@ protected:
 	Timer();
 public:
 	virtual ~Timer();
+	/*
+	 * Run timeout() after the given time.  A timeout still
+	 * pending is moved, not doubled.  Where there is a timerfd
+	 * the time is kept to the microsecond (see TimerWheel in
+	 * timer.cpp); elsewhere it goes to the Tk timers, rounded up
+	 * to the millisecond.
+	 */
 	void msched(int milliseconds);
-	inline void usched(double usec) { msched((int)(usec / 1000.)); }
+	void usched(double usec);
 	inline void ssched(int seconds) { msched(1000 * seconds); }
 	void cancel();
 	double gettimeofday_usecs() const;
+	/* use the microsecond timers where there are any (the default) */
+	static void highres(int on);
+	static int highres();
 protected:
 	virtual void timeout() = 0;
 private:
 	static void dispatch(ClientData);
 	Tk_TimerToken token_;
+
+	friend class TimerWheel;
+	Timer* wnext_;		/* on the wheel */
+	Timer** wprev_;
+	int wlevel_;		/* -1 if not on it */
+	double deadline_;	/* microseconds, monotonic clock */
 };
 
 #ifdef notyet
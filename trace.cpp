@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sys-time.h"
+#include "vic_tcl.h"
+#include "trace.h"
+
+#if defined(__GNUC__)
+#define TRACE_TLS __thread
+#elif defined(_MSC_VER)
+#define TRACE_TLS __declspec(thread)
+#endif
+
+/*
+ * Events are kept in a ring per thread.  Only the owning thread
+ * writes a ring, and it publishes each event by bumping head_
+ * after the event is in place.  A reader copies out what it
+ * wants and then checks head_ again to find out which of the
+ * entries it copied might have been overwritten meanwhile.
+ */
+#define TRACE_RINGSIZE 8192
+
+struct TraceRing {
+	TraceEvent ev[TRACE_RINGSIZE];
+	volatile u_int head;	/* # events ever recorded */
+	u_int tail;		/* reader: ignore events before this */
+	int tid;
+	u_int32_t ssrc;		/* see Tracer::key */
+	u_int32_t ts;
+	TraceRing* next;
+};
+
+static const char* stage_name[TRACE_NSTAGE] = {
+	"grab", "encode", "send", "demux", "decode", "render", "slice",
+};
+
+int Tracer::on_;
+
+static TraceRing* volatile rings;
+static volatile int nring;
+#ifdef TRACE_TLS
+static TRACE_TLS TraceRing* myring;
+#else
+static TraceRing* myring;
+#endif
+
+static TraceRing* ring()
+{
+	TraceRing* r = myring;
+	if (r != 0)
+		return (r);
+	r = new TraceRing;
+	memset(r, 0, sizeof(*r));
+	/* push onto the list of all rings without a lock */
+#ifdef __GNUC__
+	r->tid = __sync_add_and_fetch(&nring, 1);
+	do {
+		r->next = rings;
+	} while (!__sync_bool_compare_and_swap(&rings, r->next, r));
+#else
+	r->tid = ++nring;
+	r->next = rings;
+	rings = r;
+#endif
+	myring = r;
+	return (r);
+}
+
+double Tracer::now()
+{
+	timeval tv;
+	::gettimeofday(&tv, 0);
+	return (1e6 * tv.tv_sec + tv.tv_usec);
+}
+
+void Tracer::record(int stage, u_int32_t ssrc, u_int32_t ts, double begin)
+{
+	TraceRing* r = ring();
+	u_int h = r->head;
+	TraceEvent* e = &r->ev[h % TRACE_RINGSIZE];
+	e->begin = begin;
+	e->end = now();
+	e->ssrc = ssrc;
+	e->ts = ts;
+	e->stage = stage;
+#ifdef __GNUC__
+	__sync_synchronize();
+#endif
+	r->head = h + 1;
+}
+
+void Tracer::key(u_int32_t ssrc, u_int32_t ts)
+{
+	if (!on_)
+		return;
+	TraceRing* r = ring();
+	r->ssrc = ssrc;
+	r->ts = ts;
+}
+
+u_int32_t Tracer::ssrc()
+{
+	return (on_ ? ring()->ssrc : 0);
+}
+
+u_int32_t Tracer::ts()
+{
+	return (on_ ? ring()->ts : 0);
+}
+
+/*
+ * Copy out the events of ring r that are still intact.
+ * Returns the number copied into ev.
+ */
+static int snapshot(TraceRing* r, TraceEvent* ev)
+{
+	u_int head = r->head;
+	u_int first = r->tail;
+	if (head - first > TRACE_RINGSIZE)
+		first = head - TRACE_RINGSIZE;
+	u_int n = 0;
+	for (u_int i = first; i != head; ++i)
+		ev[n++] = r->ev[i % TRACE_RINGSIZE];
+#ifdef __GNUC__
+	__sync_synchronize();
+#endif
+	/* anything the writer lapped while we copied is garbage */
+	u_int now = r->head;
+	u_int lost = 0;
+	if (now - first > TRACE_RINGSIZE)
+		lost = now - first - TRACE_RINGSIZE;
+	if (lost >= n)
+		return (0);
+	memmove(ev, ev + lost, (n - lost) * sizeof(*ev));
+	return (n - lost);
+}
+
+static int cmpdouble(const void* a, const void* b)
+{
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x < y ? -1 : x > y ? 1 : 0);
+}
+
+/* a frame's grab or one of its packets' sends, by SSRC and timestamp */
+struct TraceMark {
+	u_int32_t ssrc;
+	u_int32_t ts;
+	double t;
+};
+
+static int cmpkey(const TraceMark* x, const TraceMark* y)
+{
+	if (x->ssrc != y->ssrc)
+		return (x->ssrc < y->ssrc ? -1 : 1);
+	if (x->ts != y->ts)
+		return (x->ts < y->ts ? -1 : 1);
+	return (0);
+}
+
+static int cmpmark(const void* a, const void* b)
+{
+	const TraceMark* x = (const TraceMark*)a;
+	const TraceMark* y = (const TraceMark*)b;
+	int c = cmpkey(x, y);
+	if (c != 0)
+		return (c);
+	return (cmpdouble(&x->t, &y->t));
+}
+
+class TraceCommand : public TclObject {
+    public:
+	TraceCommand() : TclObject("tracer") {}
+	int command(int argc, const char*const* argv);
+    protected:
+	int dump(const char* file);
+	void stats();
+	char* wire(char* bp, int nr);
+};
+
+static TraceCommand cmd_tracer;
+
+/*
+ * Write all the events in Chrome's trace event format.
+ */
+int TraceCommand::dump(const char* file)
+{
+	FILE* f = fopen(file, "w");
+	if (f == 0)
+		return (-1);
+	TraceEvent* ev = new TraceEvent[TRACE_RINGSIZE];
+	fprintf(f, "{\"traceEvents\":[\n");
+	const char* sep = "";
+	for (TraceRing* r = rings; r != 0; r = r->next) {
+		int n = snapshot(r, ev);
+		for (int i = 0; i < n; ++i) {
+			TraceEvent* e = &ev[i];
+			fprintf(f, "%s{\"name\":\"%s\",\"cat\":\"vic\","
+				"\"ph\":\"X\",\"ts\":%.0f,\"dur\":%.0f,"
+				"\"pid\":1,\"tid\":%d,\"args\":{\"ssrc\":"
+				"\"%08x\",\"ts\":%u}}", sep,
+				stage_name[e->stage], e->begin,
+				e->end - e->begin, r->tid,
+				(u_int)ntohl(e->ssrc), (u_int)e->ts);
+			sep = ",\n";
+		}
+	}
+	fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	delete[] ev;
+	return (fclose(f));
+}
+
+/*
+ * Glass to wire: the time from the start of each frame's grab to
+ * the end of sending its first packet ("wire") and its last
+ * ("wire-last").  The encoder keys the grab with our SSRC and the
+ * frame's RTP timestamp, which its packets carry, so they are
+ * matched on both; retransmissions and parity aren't traced.
+ * Appends "wire count p50 p99 wire-last count p50 p99" to bp.
+ */
+char* TraceCommand::wire(char* bp, int nr)
+{
+	TraceEvent* ev = new TraceEvent[TRACE_RINGSIZE];
+	TraceMark* grab = new TraceMark[nr * TRACE_RINGSIZE];
+	TraceMark* send = new TraceMark[nr * TRACE_RINGSIZE];
+	int ngrab = 0, nsend = 0;
+	for (TraceRing* r = rings; r != 0; r = r->next) {
+		int n = snapshot(r, ev);
+		for (int i = 0; i < n; ++i) {
+			if (ev[i].stage == TRACE_GRAB) {
+				grab[ngrab].ssrc = ev[i].ssrc;
+				grab[ngrab].ts = ev[i].ts;
+				grab[ngrab++].t = ev[i].begin;
+			} else if (ev[i].stage == TRACE_SEND) {
+				send[nsend].ssrc = ev[i].ssrc;
+				send[nsend].ts = ev[i].ts;
+				send[nsend++].t = ev[i].end;
+			}
+		}
+	}
+	qsort(send, nsend, sizeof(*send), cmpmark);
+	double* first = new double[ngrab + 1];
+	double* last = new double[ngrab + 1];
+	int n = 0;
+	for (int i = 0; i < ngrab; ++i) {
+		/* the frame's first packet, by binary search */
+		int lo = 0, hi = nsend;
+		while (lo < hi) {
+			int mid = (lo + hi) >> 1;
+			if (cmpkey(&send[mid], &grab[i]) < 0)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if (lo == nsend || cmpkey(&send[lo], &grab[i]) != 0)
+			continue;
+		hi = lo;
+		while (hi + 1 < nsend && cmpkey(&send[hi + 1], &grab[i]) == 0)
+			++hi;
+		first[n] = send[lo].t - grab[i].t;
+		last[n++] = send[hi].t - grab[i].t;
+	}
+	if (n > 0) {
+		qsort(first, n, sizeof(double), cmpdouble);
+		qsort(last, n, sizeof(double), cmpdouble);
+		bp += strlen(bp);
+		sprintf(bp, "wire %d %.0f %.0f wire-last %d %.0f %.0f ", n,
+			first[n / 2], first[(n * 99) / 100], n, last[n / 2],
+			last[(n * 99) / 100]);
+	}
+	delete[] first;
+	delete[] last;
+	delete[] grab;
+	delete[] send;
+	delete[] ev;
+	return (bp);
+}
+
+/*
+ * Set the Tcl result to a list of "stage count p50 p99" (usec)
+ * for each stage that has events, and the glass to wire times.
+ */
+void TraceCommand::stats()
+{
+	int nr = 0;
+	TraceRing* r;
+	for (r = rings; r != 0; r = r->next)
+		++nr;
+	TraceEvent* ev = new TraceEvent[TRACE_RINGSIZE];
+	double* dur[TRACE_NSTAGE];
+	int ndur[TRACE_NSTAGE];
+	int s;
+	for (s = 0; s < TRACE_NSTAGE; ++s) {
+		dur[s] = new double[nr * TRACE_RINGSIZE + 1];
+		ndur[s] = 0;
+	}
+	for (r = rings; r != 0; r = r->next) {
+		int n = snapshot(r, ev);
+		for (int i = 0; i < n; ++i) {
+			s = ev[i].stage;
+			dur[s][ndur[s]++] = ev[i].end - ev[i].begin;
+		}
+	}
+	char* bp = Tcl::instance().buffer();
+	*bp = 0;
+	for (s = 0; s < TRACE_NSTAGE; ++s) {
+		int n = ndur[s];
+		if (n > 0) {
+			qsort(dur[s], n, sizeof(double), cmpdouble);
+			bp += strlen(bp);
+			sprintf(bp, "%s %d %.0f %.0f ", stage_name[s], n,
+				dur[s][n / 2], dur[s][(n * 99) / 100]);
+		}
+		delete[] dur[s];
+	}
+	delete[] ev;
+	wire(bp, nr);
+	Tcl::instance().result(Tcl::instance().buffer());
+}
+
+int TraceCommand::command(int argc, const char*const* argv)
+{
+	Tcl& tcl = Tcl::instance();
+	if (argc == 2) {
+		if (strcmp(argv[1], "enabled") == 0) {
+			tcl.result(Tracer::on_ ? "1" : "0");
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "clear") == 0) {
+			for (TraceRing* r = rings; r != 0; r = r->next)
+				r->tail = r->head;
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "stats") == 0) {
+			stats();
+			return (TCL_OK);
+		}
+	} else if (argc == 3) {
+		if (strcmp(argv[1], "enable") == 0) {
+			Tracer::on_ = atoi(argv[2]);
+			return (TCL_OK);
+		}
+		if (strcmp(argv[1], "dump") == 0) {
+			if (dump(argv[2]) < 0) {
+				tcl.resultf("%s: cannot write", argv[2]);
+				return (TCL_ERROR);
+			}
+			return (TCL_OK);
+		}
+	}
+	return (TclObject::command(argc, argv));
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef vic_trace_h
+#define vic_trace_h
+
+#include "config.h"
+
+/*
+ * Latency tracing for the send (grab -> encode -> send) and
+ * receive (demux -> decode -> render) pipelines.  Each stage
+ * records a begin/end pair, keyed by SSRC and RTP timestamp,
+ * into a ring owned by the thread that ran it, so recording
+ * takes no locks.  The "tracer" Tcl command turns tracing on
+ * and off, writes the rings out in Chrome's trace event format
+ * (load it at chrome://tracing), and summarizes each stage.
+ * When tracing is off, a TraceScope costs one test.
+ */
+
+#define TRACE_GRAB	0	/* Grabber::timeout, one frame */
+#define TRACE_ENCODE	1	/* an encoder's consume() */
+#define TRACE_SEND	2	/* Transmitter::output, one packet */
+#define TRACE_DEMUX	3	/* SessionManager::demux, one packet */
+#define TRACE_DECODE	4	/* a decoder's recv() */
+#define TRACE_RENDER	5	/* Decoder::render_frame */
+#define TRACE_SLICE	6	/* a slice of a frame, on a worker thread */
+#define TRACE_NSTAGE	7
+
+struct TraceEvent {
+	double begin;		/* usec */
+	double end;
+	u_int32_t ssrc;		/* as in the RTP header; 0 if local */
+	u_int32_t ts;		/* RTP (media) timestamp */
+	int stage;
+};
+
+class Tracer {
+    public:
+	static inline int on() { return (on_); }
+	static double now();
+	static void record(int stage, u_int32_t ssrc, u_int32_t ts,
+			   double begin);
+	/*
+	 * The key of the packet or frame the calling thread is
+	 * working on, for stages that can't see it themselves.
+	 */
+	static void key(u_int32_t ssrc, u_int32_t ts);
+	static u_int32_t ssrc();
+	static u_int32_t ts();
+    protected:
+	friend class TraceCommand;
+	static int on_;
+};
+
+/*
+ * Records the lifetime of the enclosing block as one event.
+ * The key can be filled in once it is known; if it's never
+ * set, the thread's current key (see Tracer::key) is used.
+ */
+class TraceScope {
+    public:
+	inline TraceScope(int stage) : stage_(stage), keyed_(0), ssrc_(0),
+		ts_(0) {
+		begin_ = Tracer::on() ? Tracer::now() : 0.;
+	}
+	inline TraceScope(int stage, u_int32_t ssrc, u_int32_t ts)
+		: stage_(stage), keyed_(1), ssrc_(ssrc), ts_(ts) {
+		begin_ = Tracer::on() ? Tracer::now() : 0.;
+	}
+	inline ~TraceScope() {
+		if (begin_ != 0.) {
+			if (!keyed_) {
+				ssrc_ = Tracer::ssrc();
+				ts_ = Tracer::ts();
+			}
+			Tracer::record(stage_, ssrc_, ts_, begin_);
+		}
+	}
+	inline void key(u_int32_t ssrc, u_int32_t ts) {
+		keyed_ = 1;
+		ssrc_ = ssrc;
+		ts_ = ts;
+	}
+    protected:
+	int stage_;
+	int keyed_;
+	u_int32_t ssrc_;
+	u_int32_t ts_;
+	double begin_;
+};
+
+#define TRACE_SCOPE(stage) TraceScope trace_scope_(stage)
+#define TRACE_SCOPE_KEY(stage, ssrc, ts) \
+	TraceScope trace_scope_(stage, ssrc, ts)
+/* as above, and make (ssrc, ts) the thread's current key */
+#define TRACE_SCOPE_SETKEY(stage, ssrc, ts) \
+	Tracer::key(ssrc, ts); \
+	TraceScope trace_scope_(stage, ssrc, ts)
+
+#endif
@@ -52,6 +52,7 @@ extern "C" {
 #include "grabber.h"
 #include "vic_tcl.h"
 #include "crdef.h"
+#include "trace.h"
 
 #if defined(sun) && !defined(__svr4__)
 extern "C" int gettimeofday(struct timeval*, struct timezone*);
@@ -241,7 +242,13 @@ void Grabber::stop()
 void Grabber::timeout()
 {
 	for (;;) {
-		double delta = tick(grab());
+		int n;
+		{
+			/* keyed by the encoder, if there is one */
+			TRACE_SCOPE(TRACE_GRAB);
+			n = grab();
+		}
+		double delta = tick(n);
 		if (delta != 0.) {
 			usched(delta);
 			return;
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#ifndef WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+#include "worker.h"
+
+WorkerPool* WorkerPool::instance_;
+
+WorkerPool& WorkerPool::instance()
+{
+	if (instance_ == 0)
+		instance_ = new WorkerPool;
+	return (*instance_);
+}
+
+WorkerPool::WorkerPool() : started_(0), nthread_(0), head_(0), tail_(0)
+{
+#ifndef WIN32
+	pthread_mutex_init(&mutex_, 0);
+	pthread_cond_init(&cond_, 0);
+#endif
+}
+
+int WorkerPool::nthread()
+{
+	if (!started_)
+		start();
+	return (nthread_);
+}
+
+void WorkerPool::start()
+{
+	started_ = 1;
+#ifndef WIN32
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n < 1)
+		n = 1;
+	for (int i = 0; i < n; ++i) {
+		pthread_t tid;
+		if (pthread_create(&tid, 0, loop, this) != 0) {
+			perror("vic: pthread_create");
+			break;
+		}
+		pthread_detach(tid);
+		++nthread_;
+	}
+#endif
+}
+
+void WorkerPool::submit(WorkerTask* t)
+{
+	if (nthread() == 0) {
+		t->run();
+		return;
+	}
+#ifndef WIN32
+	t->next_ = 0;
+	pthread_mutex_lock(&mutex_);
+	if (head_ == 0)
+		head_ = t;
+	else
+		tail_->next_ = t;
+	tail_ = t;
+	pthread_cond_signal(&cond_);
+	pthread_mutex_unlock(&mutex_);
+#endif
+}
+
+#ifndef WIN32
+WorkerTask* WorkerPool::next()
+{
+	pthread_mutex_lock(&mutex_);
+	while (head_ == 0)
+		pthread_cond_wait(&cond_, &mutex_);
+	WorkerTask* t = head_;
+	head_ = t->next_;
+	pthread_mutex_unlock(&mutex_);
+	return (t);
+}
+
+void* WorkerPool::loop(void* p)
+{
+	WorkerPool* wp = (WorkerPool*)p;
+	for (;;)
+		wp->next()->run();
+	return (0);
+}
+#endif
+
+WorkerLatch::WorkerLatch() : count_(0)
+{
+#ifndef WIN32
+	pthread_mutex_init(&mutex_, 0);
+	pthread_cond_init(&cond_, 0);
+#endif
+}
+
+WorkerLatch::~WorkerLatch()
+{
+#ifndef WIN32
+	pthread_cond_destroy(&cond_);
+	pthread_mutex_destroy(&mutex_);
+#endif
+}
+
+void WorkerLatch::reset(int n)
+{
+	count_ = n;
+}
+
+void WorkerLatch::done()
+{
+#ifndef WIN32
+	pthread_mutex_lock(&mutex_);
+	if (--count_ == 0)
+		pthread_cond_broadcast(&cond_);
+	pthread_mutex_unlock(&mutex_);
+#else
+	--count_;
+#endif
+}
+
+void WorkerLatch::wait()
+{
+#ifndef WIN32
+	pthread_mutex_lock(&mutex_);
+	while (count_ > 0)
+		pthread_cond_wait(&cond_, &mutex_);
+	pthread_mutex_unlock(&mutex_);
+#endif
+}
+
+WorkerReply::WorkerReply()
+{
+	fd_[0] = fd_[1] = -1;
+#ifndef WIN32
+	if (pipe(fd_) < 0) {
+		perror("vic: pipe");
+		return;
+	}
+	fcntl(fd_[0], F_SETFL, O_NONBLOCK);
+	fcntl(fd_[1], F_SETFL, O_NONBLOCK);
+	link(fd_[0], TK_READABLE);
+#endif
+}
+
+WorkerReply::~WorkerReply()
+{
+#ifndef WIN32
+	unlink();
+	if (fd_[0] >= 0) {
+		close(fd_[0]);
+		close(fd_[1]);
+	}
+#endif
+}
+
+void WorkerReply::post()
+{
+#ifndef WIN32
+	/*
+	 * If the pipe is full there's already a wakeup pending,
+	 * so there's nothing to do on EAGAIN.
+	 */
+	char c = 0;
+	(void)write(fd_[1], &c, 1);
+#else
+	ready();
+#endif
+}
+
+void WorkerReply::dispatch(int)
+{
+#ifndef WIN32
+	char buf[64];
+	while (read(fd_[0], buf, sizeof(buf)) > 0)
+		;
+#endif
+	ready();
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2026 The vic contributors.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the names of the copyright holders nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS
+ * IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef vic_worker_h
+#define vic_worker_h
+
+#include "config.h"
+#include "iohandler.h"
+
+#ifndef WIN32
+#include <pthread.h>
+#endif
+
+/*
+ * Support for pushing CPU-heavy work (e.g., decoding) off the
+ * event loop.  Nothing run on a worker thread may call into Tcl/Tk
+ * or Xlib; results are handed back to the main thread through
+ * a WorkerReply, which shows up as an ordinary IOHandler event.
+ */
+
+/*
+ * A unit of work to be run on one of the pool threads.
+ */
+class WorkerTask {
+    public:
+	WorkerTask() : next_(0) {}
+	virtual ~WorkerTask() {}
+	virtual void run() = 0;
+	WorkerTask* next_;
+};
+
+/*
+ * A fixed set of threads that run WorkerTasks in FIFO order.
+ * The threads are started on first use, one per processor.
+ * On systems without threads, nthread() is 0 and callers
+ * should do the work themselves.
+ */
+class WorkerPool {
+    public:
+	static WorkerPool& instance();
+	void submit(WorkerTask*);
+	int nthread();
+    protected:
+	WorkerPool();
+	void start();
+	WorkerTask* next();
+	int started_;
+	int nthread_;
+	WorkerTask* head_;
+	WorkerTask* tail_;
+#ifndef WIN32
+	static void* loop(void*);
+	pthread_mutex_t mutex_;
+	pthread_cond_t cond_;
+#endif
+	static WorkerPool* instance_;
+};
+
+/*
+ * Wakes up the event loop on behalf of a worker thread.  Any
+ * thread may call post(); the main thread then gets a call to
+ * ready().  Several posts before the main thread gets around to
+ * it may be folded into one call.
+ */
+class WorkerReply : public IOHandler {
+    public:
+	void post();
+    protected:
+	WorkerReply();
+	virtual ~WorkerReply();
+	virtual void ready() = 0;
+	virtual void dispatch(int mask);
+	int fd_[2];
+};
+
+/*
+ * Lets a thread wait for a set of WorkerTasks to finish: reset()
+ * it to the number of tasks before submitting them, have each
+ * call done() at the end of run(), and wait() returns once they
+ * all have.  Without threads the tasks have run by the time
+ * submit() returns, so wait() has nothing to do.
+ */
+class WorkerLatch {
+    public:
+	WorkerLatch();
+	~WorkerLatch();
+	void reset(int n);
+	void done();
+	void wait();
+    protected:
+	int count_;
+#ifndef WIN32
+	pthread_mutex_t mutex_;
+	pthread_cond_t cond_;
+#endif
+};
+
+/*
+ * Atomically add v to *p and return the new value.
+ */
+inline int worker_add(volatile int* p, int v)
+{
+#ifdef __GNUC__
+	return (__sync_add_and_fetch(p, v));
+#else
+	return (*p += v);
+#endif
+}
+
+#endif